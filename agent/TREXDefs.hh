@@ -76,6 +76,17 @@ namespace TREX {
 
 #define CPU_STAT_LOG "cpuStat.log"
 
+#ifdef NO_DEBUG_MESSAGE_SUPPORT
+
+/*
+ * Optimized builds compile logging messages out entirely, exactly as EUROPA does for debugMsg.
+ * Their arguments are not evaluated.
+ */
+#define TREX_INFO(marker, data)
+#define TREX_INFO_COND(cond, marker, data)
+
+#else
+
 /**
   @brief Create a logging message, which will
   only be created or used when the given condition is true at run time.
@@ -87,6 +98,8 @@ namespace TREX {
 /**
   @brief Create a conditional logging message, which will
   only be created or used when the given condition is true at run time.
+  The marker is checked first : neither cond nor data are evaluated unless
+  the marker is enabled.
   @param cond An additional condition to be checked before printing the message,
          which can be any C/C++ expression that could be used in an if statement.
   @param marker A string that "marks" the message to enable it by.
@@ -105,3 +118,5 @@ namespace TREX {
     } \
   } \
 }
+
+#endif // NO_DEBUG_MESSAGE_SUPPORT
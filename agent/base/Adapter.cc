@@ -38,27 +38,43 @@
 #include "Agent.hh"
 #include "Adapter.hh"
 #include "StringExtract.hh"
+#include "ObservationInbox.hh"
+#include "Utilities.hh"
 
 namespace TREX {
 
   Adapter::Adapter(const LabelStr& agentName, const TiXmlElement& configData, bool logDefault)
     : TeleoReactor(agentName, configData, 
 		   string_cast<bool>(logDefault, 
-				     checked_string(externalConfig(configData).Attribute("log")))) {
+				     checked_string(externalConfig(configData).Attribute("log")))),
+      m_inbox(createInbox(configData)) {
     getTimelines(m_internals, externalConfig(configData));
+    if(configData.Attribute("driverScheduling") != NULL)
+      m_driverScheduling = Thread::Scheduling(configData.Attribute("driverScheduling"));
   }
 
   Adapter::Adapter(const LabelStr& agentName, const LabelStr& name, TICK lookAhead, TICK latency, const LabelStr& configFile, bool logDefault)
-    : TeleoReactor(agentName, name, lookAhead, latency, logDefault) {
+    : TeleoReactor(agentName, name, lookAhead, latency, logDefault), m_inbox(NULL) {
     getTimelines(m_internals, getConfig(configFile));
   }
 
   Adapter::Adapter(const LabelStr& agentName, const TiXmlElement& configData, TICK lookAhead, TICK latency, bool logDefault)
-    : TeleoReactor(agentName, configData, lookAhead, latency, logDefault) {
+    : TeleoReactor(agentName, configData, lookAhead, latency, logDefault), m_inbox(createInbox(configData)) {
     getTimelines(m_internals, configData);
+    if(configData.Attribute("driverScheduling") != NULL)
+      m_driverScheduling = Thread::Scheduling(configData.Attribute("driverScheduling"));
   }
 
-  Adapter::~Adapter(){}
+  Adapter::~Adapter(){
+    delete m_inbox;
+  }
+
+  ObservationInbox* Adapter::createInbox(const TiXmlElement& configData){
+    if(configData.Attribute("inboxSize") == NULL)
+      return NULL;
+    bool coalesce = (configData.Attribute("coalesce") != NULL && strcmp(configData.Attribute("coalesce"), "true") == 0);
+    return new ObservationInbox(atoi(configData.Attribute("inboxSize")), coalesce);
+  }
 
   void Adapter::getTimelines(std::set<LabelStr>& results, const TiXmlElement& configSource){
     // Iterate over internal and external configuration specifications
@@ -105,6 +121,45 @@ namespace TREX {
     return false;
   }
 
+  unsigned int Adapter::sendNotify(std::vector<const Observation*> const &observations) {
+    std::vector<const Observation*> owned;
+    owned.reserve(observations.size());
+    for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it)
+      if( m_internals.find((*it)->getObjectName())!=m_internals.end() )
+	owned.push_back(*it);
+    if( !owned.empty() ) {
+      checkError( m_observer.isValid(), "Adapter error : unable to notify (Adapter::handleInit was not called)");
+      m_observer->notifyBatch(owned);
+    }
+    return owned.size();
+  }
+
+  bool Adapter::post(Observation* obs) {
+    ConfigurationException::configurationCheckError(m_inbox != NULL, "Adapter error : " + getName().toString() + " has no inbox (inboxSize is not set)");
+    return m_inbox->push(obs);
+  }
+
+  void Adapter::drainInputs() {
+    if(m_inbox == NULL)
+      return;
+    std::vector<Observation*> posted;
+    m_inbox->drain(posted);
+    if(posted.empty())
+      return;
+    std::vector<const Observation*> batch(posted.begin(), posted.end());
+    sendNotify(batch);
+    for(std::vector<Observation*>::const_iterator it = posted.begin(); it != posted.end(); ++it)
+      delete *it;
+  }
+
+  void Adapter::writeTelemetry(TelemetrySample& out) const {
+    TeleoReactor::writeTelemetry(out);
+    if(m_inbox != NULL){
+      out.add(getName(), "inbox.dropped", m_inbox->dropped());
+      out.add(getName(), "inbox.coalesced", m_inbox->coalesced());
+    }
+  }
+
   const TiXmlElement& Adapter::externalConfig( const TiXmlElement& configSrc){
     if(configSrc.Attribute("config") != NULL){
       const std::string newFile =  extractData(configSrc, "config").c_str();
@@ -115,23 +170,13 @@ namespace TREX {
   }
 
   const TiXmlElement& Adapter::getConfig(const LabelStr& configFile){
-    static TiXmlElement* sl_xml = 0;
-    static LabelStr sl_fileName;
-
-    // If no element, allocate
-    if(sl_xml == NULL){
-      sl_xml = LogManager::initXml(configFile.toString());
-      sl_fileName = configFile;
-    }
-
-    // If wrong element, delete and allocate
-    if(!(sl_fileName == configFile)){
-      delete sl_xml;
-      sl_xml = LogManager::initXml(configFile.toString());
-      sl_fileName = configFile;
-    }
+    // Keep one reference to each file, as the element is given out beyond this call
+    static std::set<LabelStr> sl_files;
 
-    return *sl_xml;
+    const TiXmlElement& config = LogManager::acquireXml(configFile.toString());
+    if(!sl_files.insert(configFile).second)
+      LogManager::releaseXml(configFile.toString());
+    return config;
   }
 
 }
@@ -41,9 +41,12 @@
 #include <set>
 
 #include "TeleoReactor.hh"
+#include "Thread.hh"
 
 namespace TREX {
 
+  class ObservationInbox;
+
   class Adapter: public TeleoReactor {
   public:
     /**
@@ -97,15 +100,46 @@ namespace TREX {
     static const TiXmlElement& externalConfig(const TiXmlElement& sourceConfig);
 
     static const TiXmlElement& getConfig(const LabelStr& configFile);
+
+    void writeTelemetry(TelemetrySample& out) const;
   protected:
     /* STUBS since adapter should handle immediately */
     bool hasWork() {return false;}
     void resume(){}
     bool sendNotify(Observation const &obs);
+    /**
+     * @brief Send all the observations of a tick in a single batch. Observations on timelines not owned by this adapter are skipped.
+     * @return the number of observations sent
+     */
+    unsigned int sendNotify(std::vector<const Observation*> const &observations);
+
+    /**
+     * @brief Queue an observation from a driver thread. It is sent when the adapter next synchronizes. This is the only
+     * method which may be called from a thread other than the agent thread, and only from one such thread.
+     * @param obs The observation. The adapter takes its ownership.
+     * @return false if the observation was dropped because the inbox is full
+     * @throw ConfigurationException The inbox is not enabled with the inboxSize attribute
+     */
+    bool post(Observation* obs);
+
+    /**
+     * @brief Send the observations posted since the last synchronization
+     */
+    void drainInputs();
+
+    /**
+     * @brief Scheduling requested for the driver thread with the driverScheduling attribute. Derived classes apply it with
+     * Thread::setScheduling before starting their driver.
+     */
+    const Thread::Scheduling& getDriverScheduling() const {return m_driverScheduling;}
 
   private:
+    static ObservationInbox* createInbox(const TiXmlElement& configData);
+
     ObserverId m_observer;
     std::set<LabelStr> m_internals; /*!< The timelines it will accept goals on and issue observations */
+    ObservationInbox* m_inbox; /*!< Observations posted by a driver thread. NULL unless inboxSize is set */
+    Thread::Scheduling m_driverScheduling;
   };
 }
 #endif
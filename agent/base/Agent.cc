@@ -49,11 +49,34 @@
 #include "LogManager.hh"
 #include "AgentListener.hh"
 #include "DbCore.hh"
+#include "Thread.hh"
+#include "DeliberationScheduler.hh"
+#include "Guardian.hh"
+#include "TickArena.hh"
+#include "TickTrace.hh"
+#include "ErrnoExcept.hh"
 #include <algorithm>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace TREX {
 
+  /**
+   * @brief Thread executing deliberation steps for the Agent
+   */
+  class Agent::Deliberator: public Thread {
+  public:
+    Deliberator(Agent& agent): m_agent(agent) {}
+
+  private:
+    void* run(){
+      m_agent.deliberate();
+      return NULL;
+    }
+
+    Agent& m_agent;
+  };
+
   AgentId Agent::s_id;
 
   bool Agent::s_terminated(false);
@@ -73,6 +96,40 @@ namespace TREX {
     return atoi(valueStr);
   }
 
+  /**
+   * @brief Scheduling of a thread given by the named attribute. The default scheduling if absent.
+   */
+  static Thread::Scheduling getScheduling(const TiXmlElement& configData, const char* name){
+    const char* spec = configData.Attribute(name);
+    return spec == NULL ? Thread::Scheduling() : Thread::Scheduling(spec);
+  }
+
+  /**
+   * @brief TCP port given by an attribute. 0 lets the system choose one.
+   */
+  static unsigned short getPort(const TiXmlElement& configData, const char* name){
+    const char* spec = configData.Attribute(name);
+    char* end = NULL;
+    long port = strtol(spec, &end, 10);
+    ConfigurationException::configurationCheckError(*spec != '\0' && *end == '\0' && port >= 0 && port <= 65535,
+						    std::string("Invalid ") + name + " " + spec);
+    return (unsigned short) port;
+  }
+
+  /**
+   * @brief Overrun policy given by the overrunPolicy attribute. CatchUp if absent.
+   */
+  static Agent::OverrunPolicy getOverrunPolicy(const TiXmlElement& configData){
+    const char* policy = configData.Attribute("overrunPolicy");
+    if(policy == NULL || strcmp(policy, "catchUp") == 0)
+      return Agent::CatchUp;
+    if(strcmp(policy, "skipToNow") == 0)
+      return Agent::SkipToNow;
+    ConfigurationException::configurationCheckError(strcmp(policy, "degradeDeliberation") == 0,
+						    std::string("Unknown overrunPolicy ") + policy);
+    return Agent::DegradeDeliberation;
+  }
+
   /**
    * @brief Connector to allow the agent to route observations. Will attach to internal reactors
    */
@@ -84,6 +141,10 @@ namespace TREX {
       m_agent->notify(observation);
     }
 
+    void notifyBatch(const std::vector<const Observation*>& observations){
+      m_agent->notifyBatch(observations);
+    }
+
   private:
     AgentId m_agent;
   };
@@ -114,17 +175,32 @@ namespace TREX {
     m_currentTick(0),
     m_finalTick(timeLimit == 0 ?getFinalTick(extractData(configData, "finalTick").c_str()) : timeLimit),
     m_attempts(0),
+    m_scheduler(NULL),
+    m_deliberator(NULL),
+    m_deliberating(false),
+    m_interrupted(false),
+    m_shutdown(false),
     m_clock(clock),
+    m_overrunPolicy(getOverrunPolicy(configData)),
+    m_skippedTicks(0),
+    m_degradedTicks(0),
     m_synchUsage(RStat::zeroed), 
-    m_deliberationUsage(RStat::zeroed),
+    m_deliberationUsage(ClockStat::thread),
+    m_latencyDumpPeriod(configData.Attribute("latencyDumpPeriod") == NULL ? 0 : atoi(configData.Attribute("latencyDumpPeriod"))),
+    m_checkpointPeriod(configData.Attribute("checkpointPeriod") == NULL ? 0 : atoi(configData.Attribute("checkpointPeriod"))),
+    m_telemetry(NULL),
     m_enableEventLogger(enableLogging),
+    m_eventLog(configData.Attribute("eventLogSize") == NULL ? 0 : atoi(configData.Attribute("eventLogSize")),
+	       configData.Attribute("eventLogFile") == NULL ? "" : configData.Attribute("eventLogFile")),
     m_obsLog(buildLogName(extractData(configData, "name"))),
+    m_history(NULL),
     m_standardDebugStream(DebugMessage::getStream()){
 
     bool useExternalFile = (configData.Attribute("config") != NULL);
 
     // Obtain the configuration file if present, otherwise expect that the configuration is provided in-line
-    const TiXmlElement* configSrcRoot = (useExternalFile ? initXml(findFile(extractData(configData, "config").toString()).c_str()) : &configData);
+    const std::string configFile = (useExternalFile ? findFile(extractData(configData, "config").toString()) : "");
+    const TiXmlElement* configSrcRoot = (useExternalFile ? &LogManager::acquireXml(configFile) : &configData);
 
     // Should always be true
     Entity::gcRequired() = true;
@@ -135,20 +211,34 @@ namespace TREX {
     // Post static id.
     s_id = m_id;
 
+    // Scheduling of the agent thread, which runs the control loop
+    if(configData.Attribute("scheduling") != NULL)
+      Thread::setCurrentScheduling(getScheduling(configData, "scheduling"));
+
+    // Trace the tick phases if requested. It must be enabled before any thread records
+    if(configData.Attribute("tickTrace") != NULL)
+      TickTrace::enable(atoi(configData.Attribute("tickTrace")));
+
     // This map will be populated as we read in the timeline modes for each reactor
     std::map<double, ServerId> serversByTimeline;
 
-    std::vector<TiXmlElement*> elements;
-    std::vector<TiXmlElement*> includedFiles; //Garbage to be deleted at the end.
+    // External timelines of each reactor. Used to build the dependency graph once all owners are known.
+    std::vector< std::pair<TeleoReactorId, LabelStr> > subscriptions;
+
+    // Deliberation weights by reactor name, for the weighted scheduler
+    std::map<double, double> weights;
+
+    std::vector<const TiXmlElement*> elements;
+    std::vector<std::string> includedFiles; //Shared files to be released at the end.
 
     // Iterate over all TeleoReactors and allocate them
-    for (TiXmlElement * child = configSrcRoot->FirstChildElement();
+    for (const TiXmlElement * child = configSrcRoot->FirstChildElement();
 	 child != NULL;
 	 child = child->NextSiblingElement()){
       elements.push_back(child);
     }
     while (elements.size()) {
-      TiXmlElement * child = elements.at(0);
+      const TiXmlElement * child = elements.at(0);
       elements.erase(elements.begin());
       static const char* DEFAULT = "TeleoReactor";
 
@@ -156,9 +246,9 @@ namespace TREX {
       if(strcmp(child->Value(), "Include") == 0){
 	std::string file = findFile(child->Attribute("name"));
 	//printf("Hi, i'm including: %s\n", file.c_str());
-	TiXmlElement* iroot = EUROPA::initXml(file.c_str());
-	includedFiles.push_back(iroot);
-	for (TiXmlElement * ichild = iroot->FirstChildElement();
+	const TiXmlElement* iroot = &LogManager::acquireXml(file);
+	includedFiles.push_back(file);
+	for (const TiXmlElement * ichild = iroot->FirstChildElement();
 	     ichild != NULL;
 	     ichild = ichild->NextSiblingElement()){
 	  elements.push_back(ichild);
@@ -175,15 +265,21 @@ namespace TREX {
 
 	m_reactorsByName.insert(std::pair<double, TeleoReactorId>(reactor->getName(), reactor));
 	m_reactors.push_back(reactor);
+
+	if(child->Attribute("weight") != NULL)
+	  weights[reactor->getName()] = atof(child->Attribute("weight"));
 	
 	// Fill Data structures for observables etc so we can hookup correctly.
 	std::list<LabelStr> externals, internals;
 	reactor->queryTimelineModes(externals, internals);
 	
 	// Populate observers by timeline - external timelines are observers
+	if(!externals.empty())
+	  m_observers.push_back(reactor->toObserver());
 	for(std::list<LabelStr>::const_iterator it = externals.begin(); it != externals.end(); ++it){
 	  const LabelStr& timelineName = *it;
-	  m_observersByTimeline.insert(std::pair<LabelStr, ObserverId>(timelineName, reactor->toObserver()));
+	  routeFor(timelineName).observers.push_back(m_observers.size()-1);
+	  subscriptions.push_back(std::pair<TeleoReactorId, LabelStr>(reactor, timelineName));
 	  debugMsg("trex:info:configuration", "Adding reactor " << reactor->getName().toString() << " as observer for " << timelineName.toString());
 	}
 	
@@ -193,10 +289,13 @@ namespace TREX {
 	  ConfigurationException::configurationCheckError(serversByTimeline.find(timelineName) == serversByTimeline.end(),
 							  "Already have a server for: " + std::string(timelineName.c_str()) + ", it is duplicated in " + reactor->getName().toString());
 
-	  if( reactor->shouldLog() )
+	  if( reactor->shouldLog() ) {
 	    m_obsLog.declTimeline(timelineName, reactor->getName().toString());
+	    routeFor(timelineName).logged = true;
+	  }
 	  
 	  serversByTimeline.insert(std::pair<double, ServerId>(timelineName, reactor->toServer()));
+	  m_ownersByTimeline.insert(std::pair<double, TeleoReactorId>(timelineName, reactor));
 	  debugMsg("trex:info:configuration", "Adding reactor " << reactor->getName().toString() << " as server for " << timelineName.toString());
 	}
       }else{
@@ -204,45 +303,99 @@ namespace TREX {
       }
     }
 
-    while(!includedFiles.empty()){
-      delete includedFiles[0];
-      includedFiles.erase(includedFiles.begin());
-    }
+    for(std::vector<std::string>::const_iterator it = includedFiles.begin(); it != includedFiles.end(); ++it)
+      LogManager::releaseXml(*it);
     
 
     // Reactors loaded : I can close the log header 
+    m_obsLog.setBinary(configData.Attribute("binaryLog") != NULL && strcmp(configData.Attribute("binaryLog"), "true") == 0);
     m_obsLog.endHeader(getCurrentTick());
 
+    // Record the mission history if requested. It can be queried with trex-history
+    if(configData.Attribute("missionHistory") != NULL && strcmp(configData.Attribute("missionHistory"), "true") == 0)
+      m_history = new MissionHistoryWriter(LogManager::instance().file_name("mission.hist"),
+					   configData.Attribute("missionHistorySegment") == NULL ? 65536 : atoi(configData.Attribute("missionHistorySegment")));
+
     // Now we should have built up the map for servers and so we can initialize the reactors with final communication binding
     for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
       TeleoReactorId reactor = *it;
       reactor->doHandleInit(0, serversByTimeline, m_thisObserver);
     }
 
-    m_sortedReactors = m_reactors;
-
-    // Sort for suitable dependency graph, uses a priority comparator
-    TeleoReactor::sort(m_sortedReactors);
+    // Resume from a checkpoint rather than from the initial state
+    if(configData.Attribute("restore") != NULL)
+      restore(configData.Attribute("restore"));
+
+    // Build the dependency graph once and for all. This gives the synchronization order and the levels of independent reactors.
+    buildDependencyGraph(subscriptions);
+
+    // Allocate the deliberation scheduler and initialize its agenda
+    m_scheduler = DeliberationScheduler::create(configData.Attribute("scheduler") == NULL ? "priority" : configData.Attribute("scheduler"));
+    if(configData.Attribute("maxSteps") != NULL)
+      m_scheduler->setMaxSteps(atoi(configData.Attribute("maxSteps")));
+    for(std::map<double, double>::const_iterator it = weights.begin(); it != weights.end(); ++it)
+      m_scheduler->setWeight(getReactor(LabelStr(it->first)), it->second);
+    m_scheduler->handleTickStart(m_sortedReactors, m_currentTick);
+
+    // Start the deliberation thread if background deliberation is requested. The default is to deliberate inline.
+    if(configData.Attribute("backgroundDeliberation") != NULL && strcmp(configData.Attribute("backgroundDeliberation"), "true") == 0){
+      debugMsg("trex:info:configuration", "Deliberating on a background thread");
+      m_deliberator = new Deliberator(*this);
+      Thread::Scheduling sched = getScheduling(configData, "deliberationScheduling");
+      if(!sched.isDefault())
+	m_deliberator->setScheduling(sched);
+      m_deliberator->start();
+    }
 
-    // Initialize deliberation agenda
-    m_deliberators = m_sortedReactors;
+    // Start the telemetry server if a port is given. It is only reachable from this host unless an address is given
+    if(configData.Attribute("telemetryPort") != NULL){
+      const char* address = configData.Attribute("telemetryAddress");
+      m_telemetry = new TelemetryServer(address == NULL ? "127.0.0.1" : address, getPort(configData, "telemetryPort"));
+      debugMsg("trex:info:configuration", "Serving telemetry on port " << m_telemetry->port());
+    }
 
-    // Deallocate configuration root
+    // Release configuration root
     if(useExternalFile)
-      delete configSrcRoot;
+      LogManager::releaseXml(configFile);
   }
 
   Agent::~Agent() {
     // Reset the Debug Message Stream before deallocating any reactors
     DebugMessage::setStream(m_standardDebugStream);
 
-    s_terminated = true;       
+    s_terminated = true;
+
+    // Stop the deliberation thread
+    if(m_deliberator != NULL){
+      {
+	Guardian<Mutex> guard(m_deliberationLock);
+	m_shutdown = true;
+	m_deliberationCond.broadcast();
+      }
+      m_deliberator->join();
+      delete m_deliberator;
+    }
+
+    delete m_telemetry;
+
+    delete m_scheduler;
 
-    // Close the observation log
+    // Write the tick trace once all the other threads are stopped
+    if(TickTrace::enabled()){
+      std::ofstream trace(LogManager::instance().file_name("tick_trace.json").c_str());
+      TickTrace::writeJson(trace);
+      condDebugMsg(TickTrace::dropped() > 0, "trex:warning", TickTrace::dropped() << " tick trace events dropped. Increase tickTrace.");
+      TickTrace::disable();
+    }
+
+    // Close the observation log and the mission history
     m_obsLog.endFile();
+    delete m_history;
 
     // Delete all the reactors
-    cleanup(m_reactorsByName);
+    for(FlatMap<double, TeleoReactorId>::iterator it = m_reactorsByName.begin(); it != m_reactorsByName.end(); ++it)
+      delete (TeleoReactor*) it->second;
+    m_reactorsByName.clear();
 
     // Garbage collect any remaining entities
     Entity::garbageCollect();
@@ -279,6 +432,9 @@ namespace TREX {
   void Agent::terminate(){
     debugMsg("Agent:terminate", "Terminating the Agent.");
     s_terminated = true;
+
+    // Make sure the pending log entries are written
+    LogManager::instance().syslog().flush();
   }
 
   bool Agent::terminated(){
@@ -301,59 +457,203 @@ namespace TREX {
 
     synchronize();
 
-    // Deliberate as necessary while we have cpu available.
-    while(executeReactor() && m_clock.getNextTick() == m_currentTick){}
+    if(m_overrunPolicy == DegradeDeliberation && m_clock.getLateness(m_currentTick + 1) > 0){
+      // The next tick is already due : no deliberation until the agent is back on time
+      debugMsg("Agent:doNext", "Tick " << m_currentTick << " is late. Skipping deliberation");
+      m_degradedTicks++;
+    }
+    else if(m_deliberator != NULL){
+      // Deliberate on the background thread until the next tick
+      startDeliberation();
+      while(m_clock.waitForNextTick(m_currentTick) == m_currentTick){}
+      stopDeliberation();
+    }
+    else {
+      // Deliberate as necessary while we have cpu available.
+      while(executeReactor() && !tickEnded()){}
 
-    // Wait for next tick
-    while(m_clock.getNextTick() == m_currentTick){m_clock.sleep();}
+      // Wait for next tick
+      while(m_clock.waitForNextTick(m_currentTick) == m_currentTick){}
+    }
 
     // Output results
     m_monitor.addTickData(m_synchUsage.user_time(), m_deliberationUsage.user_time());
+
+    // Only the values are copied here. The server thread formats them
+    if(m_telemetry != NULL){
+      m_telemetrySample.clear();
+      writeTelemetry(m_telemetrySample);
+      m_telemetry->publish(m_telemetrySample);
+    }
+
     m_synchUsage.reset();
     m_deliberationUsage.reset();
 
+    if(m_latencyDumpPeriod > 0 && (m_currentTick + 1) % m_latencyDumpPeriod == 0){
+      if(!m_latencyLog.is_open())
+	m_latencyLog.open(LogManager::instance().file_name("latency.log").c_str());
+      dumpLatencies(m_latencyLog);
+      m_latencyLog.flush();
+    }
+
+    if(m_checkpointPeriod > 0 && (m_currentTick + 1) % m_checkpointPeriod == 0)
+      checkpoint(LogManager::instance().file_name("agent.checkpoint"));
+
     // Advance the tick
     m_currentTick++;
+
+    // Drop the missed ticks if the agent lags and the policy allows it
+    if(m_overrunPolicy == SkipToNow && m_clock.getLateness(m_currentTick + 1) > 0){
+      TICK now = m_clock.getNextTick();
+      debugMsg("Agent:doNext", "Skipping from tick " << m_currentTick << " to " << now);
+      m_skippedTicks += now - m_currentTick;
+      m_currentTick = now;
+    }
+
+    // Jump over the ticks where all the reactors are quiet, if the clock allows it
+    TICK next = nextActiveTick();
+    if(next > m_currentTick && m_clock.jumpTo(next)){
+      debugMsg("Agent:doNext", "Jumping from tick " << m_currentTick << " to " << next);
+      m_currentTick = next;
+    }
+
     return true;
   }
 
+  TICK Agent::nextActiveTick(){
+    TICK next = m_finalTick;
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end() && next > m_currentTick; ++it){
+      if(!(*it)->isQuiet(m_currentTick))
+	return m_currentTick;
+      next = std::min(next, (*it)->nextActiveTick());
+    }
+    return next;
+  }
+
+  void Agent::checkpoint(const std::string& fileName){
+    Checkpoint state;
+    state.tick = m_currentTick;
+
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
+      if(DbCoreId::convertable(*it)){
+	state.reactors.push_back(Checkpoint::Reactor());
+	((DbCoreId) *it)->checkpoint(state.reactors.back());
+      }
+    }
+
+    // A failed checkpoint leaves the previous one in place: report it and carry on with the mission
+    try {
+      state.write(fileName);
+    }
+    catch(ErrnoExcept const &e) {
+      TREXLog() << "Failed to save the checkpoint of tick " << m_currentTick << ": " << e.what() << std::endl;
+      return;
+    }
+    debugMsg("Agent:checkpoint", "Saved tick " << m_currentTick << " to " << fileName);
+  }
+
+  void Agent::restore(const std::string& fileName){
+    Checkpoint state;
+    state.read(fileName);
+
+    m_currentTick = state.tick + 1;
+    m_clock.setInitialTick(m_currentTick);
+
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
+      const Checkpoint::Reactor* reactorState = state.find((*it)->getName().toString());
+      if(reactorState != NULL && DbCoreId::convertable(*it))
+	((DbCoreId) *it)->restore(*reactorState);
+    }
+
+    TREXLog() << "Restored " << state.reactors.size() << " reactors from " << fileName << " at tick " << m_currentTick << std::endl;
+  }
+
   bool Agent::executeReactor(){
-    TeleoReactorId reactor = nextReactor();
+    TeleoReactorId reactor = m_scheduler->next();
+
+    while(reactor.isId()){
+      {
+	ClockStatLap chrono(m_deliberationUsage);
+	reactor->doResume();
+      }
 
-    if(reactor.isId()){
-      RStatLap chrono(m_deliberationUsage, RStat::self);
-      reactor->doResume();
-      // If a zero latency reactor, then do not cede control. Recursive execution  instead. This allows for more robustness
-      // to timing errors for really reactive controllers
-      if(reactor->getLatency() == 0)
-	return executeReactor();
+      // If a zero latency reactor, then do not cede control. Keep stepping instead. This allows for more robustness
+      // to timing errors for really reactive controllers. The clock is not asked in between, as each query may use up
+      // a step of a pseudo clock, but an interruption of the background deliberation still applies.
+      if(reactor->getLatency() != 0 || deliberationInterrupted())
+	return true;
 
-      return true;
+      reactor = m_scheduler->next();
     }
 
     return false;
   }
 
-  /**
-   * @brief Selection of first available reactor
-   */
-  TeleoReactorId Agent::nextReactor(){
-    static unsigned int sl_counter(0);
+  bool Agent::tickEnded(){
+    if(m_deliberator == NULL)
+      return m_clock.getNextTick() != m_currentTick;
 
-    debugMsg("Agent:nextReactor", "[" << sl_counter << "] Size=" << m_deliberators.size());
-    sl_counter++;
+    return deliberationInterrupted();
+  }
 
-    if(m_deliberators.empty())
-      return TeleoReactorId::noId();
+  bool Agent::deliberationInterrupted(){
+    if(m_deliberator == NULL)
+      return false;
+
+    Guardian<Mutex> guard(m_deliberationLock);
+    return m_interrupted;
+  }
+
+  void Agent::startDeliberation(){
+    Guardian<Mutex> guard(m_deliberationLock);
+    m_interrupted = false;
+    m_deliberating = true;
+    m_deliberationCond.broadcast();
+  }
+
+  void Agent::stopDeliberation(){
+    Guardian<Mutex> guard(m_deliberationLock);
+    m_interrupted = true;
+    while(m_deliberating)
+      m_deliberationCond.wait(m_deliberationLock);
+
+    if(!m_deliberationError.empty()){
+      std::string error = m_deliberationError;
+      m_deliberationError.clear();
+      throw std::runtime_error(error);
+    }
+  }
 
-    if(m_deliberators[0]->getLookAhead() > 0 && m_deliberators[0]->hasWork())
-      return m_deliberators[0];
+  void Agent::deliberate(){
+    Guardian<Mutex> guard(m_deliberationLock);
 
-    // Remove the reactor that is done
-    m_deliberators.erase(m_deliberators.begin());
+    while(!m_shutdown){
+      if(!m_deliberating){
+	m_deliberationCond.wait(m_deliberationLock);
+	continue;
+      }
+
+      m_deliberationLock.unlock();
+      std::string error;
+      try {
+	while(!tickEnded() && executeReactor()){}
+      }
+      catch(std::exception const& e){
+	error = e.what();
+      }
+      catch(...){
+	error = "Unknown exception during background deliberation";
+      }
+      m_deliberationLock.lock();
+
+      m_deliberationError = error;
 
-    // Tail-recursion
-    return nextReactor();
+      // Done for this tick, either interrupted or out of work
+      while(!m_interrupted && !m_shutdown)
+	m_deliberationCond.wait(m_deliberationLock);
+      m_deliberating = false;
+      m_deliberationCond.broadcast();
+    }
   }
 
   const AgentId& Agent::getId() const { return m_id; }
@@ -368,12 +668,20 @@ namespace TREX {
     return m_finalTick;
   }
 
+  unsigned long Agent::getSkippedTicks() const {
+    return m_skippedTicks;
+  }
+
+  unsigned long Agent::getDegradedTicks() const {
+    return m_degradedTicks;
+  }
+
   const Clock& Agent::getClock() const {
     return m_clock;
   }
 
   const TeleoReactorId& Agent::getReactor(const LabelStr& name){
-    std::map<double, TeleoReactorId>::const_iterator it = m_reactorsByName.find(name);
+    FlatMap<double, TeleoReactorId>::const_iterator it = m_reactorsByName.find(name);
     if(it == m_reactorsByName.end())
       return TeleoReactorId::noId();
     else
@@ -381,37 +689,94 @@ namespace TREX {
   }
 
   const TeleoReactorId& Agent::getOwner(const LabelStr& timeline){
-    if(m_ownersByTimeline.empty()){
-      for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
-	TeleoReactorId reactor = *it;
-	std::list<LabelStr> externals, internals;
-	reactor->queryTimelineModes(externals, internals);
-	for(std::list<LabelStr>::const_iterator l_it = internals.begin(); l_it != internals.end(); ++l_it){
-	  const LabelStr& t = *l_it;
-	  m_ownersByTimeline.insert(std::pair<double, TeleoReactorId>(t, reactor));
-	}
-      }
-    }
-
-    std::map<double, TeleoReactorId>::const_iterator it = m_ownersByTimeline.find(timeline);
+    FlatMap<double, TeleoReactorId>::const_iterator it = m_ownersByTimeline.find(timeline);
     checkError(it != m_ownersByTimeline.end(), "No owner for " << timeline.toString());
     return it->second;
   }
 
+  int Agent::getLevel(const LabelStr& reactorName) const {
+    std::map<double, int>::const_iterator it = m_levelByReactor.find(reactorName);
+    checkError(it != m_levelByReactor.end(), "No dependency level for " << reactorName.toString());
+    return it->second;
+  }
+
+  const std::vector<TeleoReactorId>& Agent::getSortedReactors() const {
+    return m_sortedReactors;
+  }
+
+  const std::vector< std::vector<TeleoReactorId> >& Agent::getLevels() const {
+    return m_syncLevels;
+  }
+
+  /**
+   * The graph has an edge from each reactor to the owner of each of its external timelines. The level of a reactor is 0 if it has
+   * no external timelines, and 1 + the highest level of the reactors it depends on otherwise. Reactors are then bucketed by level,
+   * preserving allocation order within a level, which gives a topological order.
+   */
+  void Agent::buildDependencyGraph(const std::vector< std::pair<TeleoReactorId, LabelStr> >& subscriptions){
+    std::map<double, std::vector<TeleoReactorId> > dependencies;
+
+    for(std::vector< std::pair<TeleoReactorId, LabelStr> >::const_iterator it = subscriptions.begin(); it != subscriptions.end(); ++it){
+      FlatMap<double, TeleoReactorId>::const_iterator owner = m_ownersByTimeline.find(it->second);
+      ConfigurationException::configurationCheckError(owner != m_ownersByTimeline.end(),
+						      "No owner for " + it->second.toString() + " observed by " + it->first->getName().toString());
+      dependencies[it->first->getName()].push_back(owner->second);
+    }
+
+    int maxLevel = -1;
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it)
+      maxLevel = std::max(maxLevel, computeLevel(*it, dependencies, 0));
+
+    m_syncLevels.clear();
+    m_syncLevels.resize(maxLevel + 1);
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
+      TeleoReactorId reactor = *it;
+      m_syncLevels[getLevel(reactor->getName())].push_back(reactor);
+    }
+
+    m_sortedReactors.clear();
+    for(std::vector< std::vector<TeleoReactorId> >::const_iterator it = m_syncLevels.begin(); it != m_syncLevels.end(); ++it)
+      m_sortedReactors.insert(m_sortedReactors.end(), it->begin(), it->end());
+
+    checkError(m_sortedReactors.size() == m_reactors.size(), "Every reactor must have a level.");
+  }
+
+  int Agent::computeLevel(const TeleoReactorId& reactor, const std::map<double, std::vector<TeleoReactorId> >& dependencies, unsigned int depth){
+    std::map<double, int>::const_iterator cached = m_levelByReactor.find(reactor->getName());
+    if(cached != m_levelByReactor.end())
+      return cached->second;
+
+    ConfigurationException::configurationCheckError(depth < m_reactors.size(), "Cycle detected in reactor specification at " + reactor->getName().toString());
+
+    int level = 0;
+    std::map<double, std::vector<TeleoReactorId> >::const_iterator it = dependencies.find(reactor->getName());
+    if(it != dependencies.end()){
+      for(std::vector<TeleoReactorId>::const_iterator d_it = it->second.begin(); d_it != it->second.end(); ++d_it)
+	level = std::max(level, 1 + computeLevel(*d_it, dependencies, depth + 1));
+    }
+
+    m_levelByReactor.insert(std::pair<double, int>(reactor->getName(), level));
+    return level;
+  }
+
   void Agent::logRequest(const TokenId& goal){
     debugMsg("Agent:logRequest", goal->toString());
     if(m_enableEventLogger){
       ObjectId object = (ObjectId) goal->getObject()->lastDomain().getSingletonValue();
-      m_eventLog.push_back(Agent::Event(getCurrentTick(), Agent::Request, object->getName().toString(), goal->getPredicateName()));
+      m_eventLog.push(Agent::Event(getCurrentTick(), Agent::Request, object->getName().toString(), goal->getPredicateName()));
     }
+    if(m_history != NULL)
+      m_history->dispatch(getCurrentTick(), goal);
   }
 
   void Agent::logRecall(const TokenId& goal){
     debugMsg("Agent:logRecall", goal->toString());
     if(m_enableEventLogger){
       ObjectId object = (ObjectId) goal->getObject()->lastDomain().getSingletonValue();
-      m_eventLog.push_back(Agent::Event(getCurrentTick(), Agent::Recall, object->getName().toString(), goal->getPredicateName()));
+      m_eventLog.push(Agent::Event(getCurrentTick(), Agent::Recall, object->getName().toString(), goal->getPredicateName()));
     }
+    if(m_history != NULL)
+      m_history->recall(getCurrentTick(), goal);
   }
 
   /**
@@ -419,23 +784,67 @@ namespace TREX {
    */
   void Agent::notify(const Observation& observation){
     debugMsg("Agent:notify", observation.toString());
-    TREXLog() << observation.toString() << std::endl;
+    TREX_SYSLOG("trex:notify", observation.toString() << std::endl);
 
     if(m_enableEventLogger)
-      m_eventLog.push_back(Agent::Event(getCurrentTick(), Agent::Notify, observation.getObjectName(), observation.getPredicate()));
+      m_eventLog.push(Agent::Event(getCurrentTick(), Agent::Notify, observation.getObjectName(), observation.getPredicate()));
 
-    m_obsLog.log(observation);
+    if(m_history != NULL)
+      m_history->observation(getCurrentTick(), observation);
 
-    for(std::multimap<LabelStr, ObserverId>::const_iterator it = m_observersByTimeline.find(observation.getObjectName());
-	it != m_observersByTimeline.end(); ++it){
-      // If we have moved past it, quit
-      if(it->first != observation.getObjectName())
-	return;
+    // Nobody observes or logs this timeline
+    std::map<double, unsigned int>::const_iterator index = m_routeByTimeline.find(observation.getObjectName());
+    if(index == m_routeByTimeline.end())
+      return;
+
+    const Route& route = m_routes[index->second];
+    if(route.logged)
+      m_obsLog.logDeclared(observation);
+
+    for(std::vector<unsigned int>::const_iterator it = route.observers.begin(); it != route.observers.end(); ++it)
+      m_observers[*it]->notify(observation);
+  }
+
+  void Agent::notifyBatch(const std::vector<const Observation*>& observations){
+    std::vector< std::vector<const Observation*> > batches(m_observers.size());
+
+    for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it){
+      const Observation& observation = **it;
+      debugMsg("Agent:notify", observation.toString());
+      TREX_SYSLOG("trex:notify", observation.toString() << std::endl);
+
+      if(m_enableEventLogger)
+	m_eventLog.push(Agent::Event(getCurrentTick(), Agent::Notify, observation.getObjectName(), observation.getPredicate()));
+
+      if(m_history != NULL)
+	m_history->observation(getCurrentTick(), observation);
+
+      std::map<double, unsigned int>::const_iterator index = m_routeByTimeline.find(observation.getObjectName());
+      if(index == m_routeByTimeline.end())
+	continue;
 
-      // Otherwise, pass it on.
-      ObserverId observer = it->second;
-      observer->notify(observation);
+      const Route& route = m_routes[index->second];
+      if(route.logged)
+	m_obsLog.logDeclared(observation);
+
+      for(std::vector<unsigned int>::const_iterator o_it = route.observers.begin(); o_it != route.observers.end(); ++o_it)
+	batches[*o_it].push_back(*it);
     }
+
+    // Each observer gets its share of the batch in one call
+    for(unsigned int i = 0; i < batches.size(); ++i)
+      if(!batches[i].empty())
+	m_observers[i]->notifyBatch(batches[i]);
+  }
+
+  Agent::Route& Agent::routeFor(const LabelStr& timeline){
+    std::map<double, unsigned int>::const_iterator it = m_routeByTimeline.find(timeline);
+    if(it != m_routeByTimeline.end())
+      return m_routes[it->second];
+
+    m_routeByTimeline.insert(std::pair<double, unsigned int>(timeline, m_routes.size()));
+    m_routes.push_back(Route());
+    return m_routes.back();
   }
 
   /**
@@ -444,10 +853,11 @@ namespace TREX {
    */
   void Agent::synchronize() {
     RStatLap chrono(m_synchUsage, RStat::self);
+
     std::vector<TeleoReactorId>::const_iterator it = m_sortedReactors.begin();
     while(it != m_sortedReactors.end() && !terminated()){
       TeleoReactorId r = *it;
-      if(!r->doSynchronize())
+      if(!r->isQuiet(m_currentTick) && !r->doSynchronize())
 	throw std::runtime_error("Unknown synchronization failure. In a future iteration, this will be recoverable.");
       ++it;
     }
@@ -456,6 +866,10 @@ namespace TREX {
   }
 
   void Agent::handleTickStart(){
+    TickTrace::counter("tick", m_currentTick);
+    TickTraceScope trace("handleTickStart");
+
+    m_monitor.addTickLateness(m_clock.getLateness(m_currentTick));
 
     debugMsg("Agent:handleTickStart", "Tick " << m_currentTick << " for " << getName().toString());
 
@@ -466,14 +880,20 @@ namespace TREX {
     m_synchUsage.reset();
     m_deliberationUsage.reset();
 
-    // Reset the collection of deliberators
-    m_deliberators = m_sortedReactors;
+    // Reuse the memory of the last tick temporaries
+    TickArena::instance().reset();
+
+    // Reset the deliberation agenda
+    m_scheduler->handleTickStart(m_sortedReactors, m_currentTick);
 
-    // Iterate over all reactors and pass on the message
+    // Iterate over all reactors and pass on the message. Quiet reactors get it when they synchronize again.
     std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin();
     while(it != m_reactors.end() && !terminated()){
       TeleoReactorId reactor = *it;
-      reactor->doHandleTickStart();
+      if(reactor->isQuiet(m_currentTick))
+	reactor->deferTickStart();
+      else
+	reactor->doHandleTickStart();
       ++it;
     }
 
@@ -485,7 +905,7 @@ namespace TREX {
     return result;
   }
 
-  const std::vector<Agent::Event>& Agent::getEventLog() const { return m_eventLog;}
+  const Agent::EventLog& Agent::getEventLog() const { return m_eventLog;}
 
 
   void Agent::registerListener(const AgentListenerId& listener){
@@ -505,23 +925,31 @@ namespace TREX {
 
   std::string Agent::toString(const  std::vector<Event>& eventLog, bool use_tick){
     std::stringstream ss;
-    for(unsigned int i = 0;i<eventLog.size(); i++){
-      std::string evType;
+    for(unsigned int i = 0;i<eventLog.size(); i++)
+      write(ss, eventLog[i], use_tick);
 
-      if(eventLog[i].m_eventType == Agent::Notify)
-	evType = "NOTIFY ";
-      else  if(eventLog[i].m_eventType == Agent::Request)
-	evType = "REQUEST";
-      else
-	evType = "RECALL";
+    return ss.str();
+  }
 
-      if(use_tick)
-	ss << eventLog[i].m_tick << " ";
+  void Agent::write(std::ostream& out, const EventLog& eventLog, bool use_tick){
+    for(unsigned int i = 0;i<eventLog.size(); i++)
+      write(out, eventLog[i], use_tick);
+  }
 
-      ss << evType << " " << eventLog[i].m_objectName.toString() << " " << eventLog[i].m_predicateName.toString() << std::endl;
-    }
+  void Agent::write(std::ostream& out, const Event& event, bool use_tick){
+    const char* evType;
 
-    return ss.str();
+    if(event.m_eventType == Agent::Notify)
+      evType = "NOTIFY ";
+    else  if(event.m_eventType == Agent::Request)
+      evType = "REQUEST";
+    else
+      evType = "RECALL";
+
+    if(use_tick)
+      out << event.m_tick << " ";
+
+    out << evType << " " << event.m_objectName.toString() << " " << event.m_predicateName.toString() << std::endl;
   }
 
   Agent::Event::Event(TICK tick, Agent::EventType evType, const LabelStr& objectName, const LabelStr& predicateName)
@@ -530,6 +958,36 @@ namespace TREX {
   Agent::Event::Event(const Agent::Event& org)
     : m_tick(org.m_tick), m_eventType(org.m_eventType), m_objectName(org.m_objectName), m_predicateName(org.m_predicateName) {}
 
+  Agent::EventLog::EventLog(unsigned int capacity, const std::string& sinkName)
+    : m_capacity(capacity), m_first(0), m_dropped(0), m_sinkName(sinkName) {}
+
+  void Agent::EventLog::push(const Agent::Event& event){
+    if(!m_sinkName.empty()){
+      // Opened on first use since the log directory is not known yet when the agent is built
+      if(!m_sink.is_open())
+	m_sink.open(LogManager::instance().file_name(m_sinkName).c_str());
+      Agent::write(m_sink, event);
+    }
+
+    if(m_capacity == 0 || m_events.size() < m_capacity)
+      m_events.push_back(event);
+    else {
+      // Full: overwrite the oldest event
+      m_events[m_first] = event;
+      m_first = (m_first + 1) % m_capacity;
+      ++m_dropped;
+    }
+  }
+
+  unsigned int Agent::EventLog::size() const { return m_events.size(); }
+
+  const Agent::Event& Agent::EventLog::operator[](unsigned int index) const {
+    checkError(index < m_events.size(), index << " is out of bounds");
+    return m_events[(m_first + index) % m_events.size()];
+  }
+
+  unsigned int Agent::EventLog::dropped() const { return m_dropped; }
+
 
   const LabelStr& Agent::TIMELINE(){
     static const LabelStr sl_action("AgentTimeline");
@@ -576,6 +1034,46 @@ namespace TREX {
     return m_monitor;
   }
 
+  void Agent::dumpLatencies(std::ostream& out) const {
+    const LatencyHistogram& lateness = m_monitor.getLateness();
+    const LatencyHistogram& jitter = m_monitor.getJitter();
+    out << m_currentTick << " agent lateness count=" << lateness.count() << " p50=" << lateness.percentile(0.5)
+	<< " p99=" << lateness.percentile(0.99) << " max=" << lateness.max() << std::endl
+	<< m_currentTick << " agent jitter count=" << jitter.count() << " p50=" << jitter.percentile(0.5)
+	<< " p99=" << jitter.percentile(0.99) << " max=" << jitter.max() << std::endl;
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
+      std::stringstream prefix;
+      prefix << m_currentTick << " " << (*it)->getName().toString() << " ";
+      for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++){
+	PerformanceMonitor::Phase phase = (PerformanceMonitor::Phase) i;
+	const LatencyHistogram& h = (*it)->getLatency(phase);
+	out << prefix.str() << PerformanceMonitor::phaseName(phase) << " count=" << h.count()
+	    << " p50=" << h.percentile(0.5) << " p99=" << h.percentile(0.99) << " max=" << h.max() << std::endl;
+      }
+    }
+  }
+
+  void Agent::dumpMemoryUsage(std::ostream& out) const {
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it){
+      const MemoryUsage& usage = (*it)->getMemoryUsage();
+      out << m_currentTick << " " << (*it)->getName().toString() << " tokens=" << usage.tokens
+	  << " variables=" << usage.variables << " constraints=" << usage.constraints << " entities=" << usage.entities << std::endl;
+    }
+  }
+
+  void Agent::writeTelemetry(TelemetrySample& out) const {
+    out.add("tick", m_currentTick);
+    out.add("agent.synchTime", to_double(m_synchUsage.user_time()));
+    out.add("agent.deliberationTime", to_double(m_deliberationUsage.user_time()));
+    out.add("agent.lateness.p99", m_monitor.getLateness().percentile(0.99));
+    out.add("agent.lateness.max", m_monitor.getLateness().max());
+    out.add("agent.jitter.p99", m_monitor.getJitter().percentile(0.99));
+    out.add("agent.skippedTicks", m_skippedTicks);
+    out.add("agent.degradedTicks", m_degradedTicks);
+    for(std::vector<TeleoReactorId>::const_iterator it = m_reactors.begin(); it != m_reactors.end(); ++it)
+      (*it)->writeTelemetry(out);
+  }
+
   void Agent::notifyRejected(const TokenId token){
     for(std::list<AgentListenerId>::const_iterator it = m_listeners.begin(); it != m_listeners.end(); ++it){
       AgentListenerId l = *it;
@@ -41,7 +41,9 @@
  * allocate reactors and connect them together according to their configuratiun requirements. It will also play the role
  * of middle-man to route observations from sender to receiver.
  * @status Documented
- * @note The Agent class is not thread safe.
+ * @note The Agent class is not thread safe. Reactors are synchronized in sequence on the agent thread.
+ * When backgroundDeliberation is set, deliberation steps run on a separate thread while the agent thread waits for the clock.
+ * The agent thread only resumes work on the reactors once that thread has completed its current step.
  */
 
 #include "TREXDefs.hh"
@@ -49,13 +51,21 @@
 #include "TeleoReactor.hh"
 #include "AgentClock.hh"
 #include "ObservationLogger.hh"
+#include "MissionHistory.hh"
 #include "PerformanceMonitor.hh"
+#include "FlatTable.hh"
+#include "TelemetryServer.hh"
 #include "RStat.hh"
+#include "ClockStat.hh"
+#include "MutexWrapper.hh"
+#include "Condition.hh"
 #include <vector>
 #include <map>
 
 namespace TREX {
 
+  class DeliberationScheduler;
+
   /**
    * @brief The Agent is an observer of messages from TeleoReactors. It is the message bus for distribution of observations
    * @see TeleoReactor
@@ -73,6 +83,16 @@ namespace TREX {
       Recall /*!< For recalls made on a reactor */
     };
 
+    /**
+     * @brief What the agent does when it starts a tick after the date of the next one, set by the overrunPolicy
+     * attribute of its configuration.
+     */
+    enum OverrunPolicy {
+      CatchUp = 0, /*!< "catchUp" : run the missed ticks back to back. The default */
+      SkipToNow, /*!< "skipToNow" : jump to the tick of the current date, as the agent does over quiet ticks */
+      DegradeDeliberation /*!< "degradeDeliberation" : run the missed ticks without deliberation until caught up */
+    };
+
     /**
      * @brief An Agent Event is used for logging. This is particularly useful when applying an event log for regression testing to validate
      * current execution against prior stored values.
@@ -88,6 +108,47 @@ namespace TREX {
 				  but it is enough to do alot of good validation against without incurring excessive overhead */
     };
 
+    /**
+     * @brief Storage for the event log. By default all the events are kept. With a capacity, only the latest events are kept
+     * in a ring buffer so that memory use does not grow with the mission. Events can also be streamed to a file as they occur.
+     */
+    class EventLog {
+    public:
+      /**
+       * @param capacity The maximum number of events kept. 0 for no limit.
+       * @param sinkName If not empty, the name of the file in the log directory to which each event is written.
+       */
+      EventLog(unsigned int capacity, const std::string& sinkName);
+
+      void push(const Event& event);
+
+      /**
+       * @brief The number of events kept
+       */
+      unsigned int size() const;
+
+      /**
+       * @brief Access events kept, from the oldest one.
+       */
+      const Event& operator[](unsigned int index) const;
+
+      /**
+       * @brief The number of events no longer kept because of the capacity.
+       */
+      unsigned int dropped() const;
+
+    private:
+      EventLog(const EventLog&);
+      void operator=(const EventLog&);
+
+      const unsigned int m_capacity;
+      std::vector<Event> m_events;
+      unsigned int m_first; /*!< Position of the oldest event once the ring is full */
+      unsigned int m_dropped;
+      const std::string m_sinkName;
+      std::ofstream m_sink;
+    };
+
     /**
      * @brief The Agent is a singleton per process.
      * @param configData The Agent XML Configuration file.
@@ -158,6 +219,22 @@ namespace TREX {
      */
     const TeleoReactorId& getOwner(const LabelStr& timeline);
 
+    /**
+     * @brief Retrieve the dependency level of a reactor. 0 if it has no external timelines, otherwise 1 + the highest level of the
+     * owners of its external timelines.
+     */
+    int getLevel(const LabelStr& reactorName) const;
+
+    /**
+     * @brief Accessor for the reactors in topological order of the dependency graph
+     */
+    const std::vector<TeleoReactorId>& getSortedReactors() const;
+
+    /**
+     * @brief Accessor for the reactors grouped by dependency level. Reactors of the same level do not depend on each other.
+     */
+    const std::vector< std::vector<TeleoReactorId> >& getLevels() const;
+
     /**
      * @brief Get the reactor count
      */
@@ -175,6 +252,14 @@ namespace TREX {
      */
     void notify(const Observation& observation);
 
+    /**
+     * @brief Called by Reactors to post all their observations of a tick at once. Each observer receives the part of the batch
+     * it tracks as a single batch.
+     * @param observations The observations reported.
+     * @see Observer::notifyBatch
+     */
+    void notifyBatch(const std::vector<const Observation*>& observations);
+
     /**
      * @brief Call back to log a request being sent to a reactor
      */
@@ -210,6 +295,16 @@ namespace TREX {
      */
     TICK getFinalTick() const;
 
+    /**
+     * @brief Ticks skipped by the SkipToNow overrun policy so far
+     */
+    unsigned long getSkippedTicks() const;
+
+    /**
+     * @brief Ticks run without deliberation by the DegradeDeliberation overrun policy so far
+     */
+    unsigned long getDegradedTicks() const;
+
     /**
      * @brief Accessor for the clock
      */
@@ -225,10 +320,32 @@ namespace TREX {
      */
     const PerformanceMonitor& getMonitor() const;
 
+    /**
+     * @brief Write the latency percentiles of every reactor and phase, one line per pair.
+     */
+    void dumpLatencies(std::ostream& out) const;
+
+    /**
+     * @brief Write the entities held by every reactor as of its last synchronization, one line per reactor.
+     */
+    void dumpMemoryUsage(std::ostream& out) const;
+
+    /**
+     * @brief Add the statistics of the current tick to a sample, as served by the TelemetryServer.
+     */
+    void writeTelemetry(TelemetrySample& out) const;
+
+    /**
+     * @brief Save the state of the DbCore reactors at the current tick. The agent can be restarted from it at the next tick
+     * with the restore attribute of its configuration. A write failure is logged and leaves the previous checkpoint in place.
+     * @see Checkpoint
+     */
+    void checkpoint(const std::string& fileName);
+
     /**
      * @brief Accessor for the event log. This event log is mostly used in the regression testing suite.
      */
-    const std::vector<Event>& getEventLog() const;
+    const EventLog& getEventLog() const;
 
     /**
      * @brief Register a listener for token rejection or completion messages
@@ -252,6 +369,19 @@ namespace TREX {
      */
     static std::string toString(const  std::vector<Event>& eventLog, bool use_tick = true);
 
+    /**
+     * @brief Stream an event log, without copying it.
+     * @param out The destination
+     * @param eventLog The events of interest
+     * @param use_tick true if you want tick values to be output. False if we just want the ordering.
+     */
+    static void write(std::ostream& out, const EventLog& eventLog, bool use_tick = true);
+
+    /**
+     * @brief Stream a single event, as one line of an event log.
+     */
+    static void write(std::ostream& out, const Event& event, bool use_tick = true);
+
     /**
      * @brief Constant for Timeline base class
      */
@@ -307,7 +437,56 @@ namespace TREX {
     Agent(const TiXmlElement& configData, Clock& clock, TICK timelimit, bool enableLogging = true);
 
     /**
-     * @brief execute the next reactor for a step.
+     * @brief Delivery information of a timeline, compiled at construction so that notify does no lookup by name
+     */
+    struct Route {
+      Route(): logged(false) {}
+      std::vector<unsigned int> observers; /*!< Index in m_observers of the reactors with this timeline as external */
+      bool logged; /*!< True if the observations on this timeline go to the observation log */
+    };
+
+    /**
+     * @brief Get the route of a timeline, creating it if needed. Only called at construction.
+     */
+    Route& routeFor(const LabelStr& timeline);
+
+    /**
+     * @brief Background deliberation thread
+     * @see startDeliberation, stopDeliberation
+     */
+    class Deliberator;
+    friend class Deliberator;
+
+    /**
+     * @brief Let the deliberation thread work until stopDeliberation is called.
+     */
+    void startDeliberation();
+
+    /**
+     * @brief Barrier at the end of the tick. Interrupts the deliberation thread and waits for its current step to complete.
+     * @throw std::runtime_error if deliberation failed on the background thread
+     */
+    void stopDeliberation();
+
+    /**
+     * @brief Deliberation thread main loop
+     */
+    void deliberate();
+
+    /**
+     * @brief Test if deliberation should stop for this tick. In the background mode this is set by stopDeliberation,
+     * otherwise it is decided by the clock.
+     */
+    bool tickEnded();
+
+    /**
+     * @brief Test if stopDeliberation was called for this tick. Always false when deliberation is done inline.
+     */
+    bool deliberationInterrupted();
+
+    /**
+     * @brief execute the next reactor for a step. Zero latency reactors are stepped until one with latency is selected,
+     * no reactor has work, or the background deliberation is interrupted. The clock is not queried between these steps.
      * @return true if more work to do
      */
     bool executeReactor();
@@ -322,16 +501,32 @@ namespace TREX {
      */
     void handleTickStart();
 
+    /**
+     * @brief The first tick, from the current one, at which some reactor is not quiet. Bounded by the final tick.
+     */
+    TICK nextActiveTick();
+
     /**
      * @brief Called to synchronize values at the execution frontier across all reactors.
      */
     void synchronize();
 
     /**
-     * @brief Select the next reactor to work on
-     * @return reactor The next reactor to work on. If no work required, returns a noId()
+     * @brief Build the reactor dependency graph and compute levels, m_sortedReactors and m_syncLevels
+     * @param subscriptions The external timelines of each reactor
+     */
+    void buildDependencyGraph(const std::vector< std::pair<TeleoReactorId, LabelStr> >& subscriptions);
+
+    /**
+     * @brief Memoized computation of the level of a reactor
+     * @param depth recursion depth, used to detect cycles
+     */
+    int computeLevel(const TeleoReactorId& reactor, const std::map<double, std::vector<TeleoReactorId> >& dependencies, unsigned int depth);
+
+    /**
+     * @brief Resume at the tick following a checkpoint. Called once the reactors are initialized.
      */
-    TeleoReactorId nextReactor();
+    void restore(const std::string& fileName);
 
     /**
      * Helper method to obtain the correct final tick value from the input parameter string
@@ -345,28 +540,48 @@ namespace TREX {
     unsigned int m_currentTick; /*!< Set by the clock */
     unsigned int m_finalTick; /*!< Determines mission end */
     unsigned int m_attempts; /*!< Tracks the number of times this tick has been attempted to be resolved */
-    std::multimap<LabelStr, ObserverId> m_observersByTimeline; /*!< Routing table for observations */
+    std::vector<ObserverId> m_observers; /*!< The reactors with external timelines */
+    std::vector<Route> m_routes; /*!< Routing table for observations */
+    std::map<double, unsigned int> m_routeByTimeline; /*!< Index in m_routes by timeline name */
     std::vector<TeleoReactorId> m_reactors; /*!< The reactors in order of allocation */
-    std::map< double, TeleoReactorId> m_reactorsByName; /*!< The set of reactors */
-    std::map< double, TeleoReactorId> m_ownersByTimeline; /*!< Lookup table for getting owners */
+    FlatMap<double, TeleoReactorId> m_reactorsByName; /*!< The set of reactors */
+    FlatMap<double, TeleoReactorId> m_ownersByTimeline; /*!< Lookup table for getting owners. Populated on construction */
+    std::map< double, int> m_levelByReactor; /*!< Cached dependency level by reactor name */
     std::vector<TeleoReactorId> m_sortedReactors; /*!< Sorted by dependency for synchronization */
-    std::vector<TeleoReactorId> m_deliberators; /*!< The agenda of reactors for deliberation. Refreshed on every tick. */
+    DeliberationScheduler* m_scheduler; /*!< Shares deliberation between reactors. The agenda is refreshed on every tick. */
+    std::vector< std::vector<TeleoReactorId> > m_syncLevels; /*!< Sorted reactors grouped by dependency level */
+    Deliberator* m_deliberator; /*!< Runs deliberation steps while the agent waits for the clock. NULL if deliberation is done inline */
+    Mutex m_deliberationLock; /*!< Protects the deliberation flags below */
+    Condition m_deliberationCond; /*!< Signaled when a deliberation flag changes */
+    bool m_deliberating; /*!< True while the deliberation thread works on the current tick */
+    bool m_interrupted; /*!< Set at the end of the tick to stop the deliberation thread */
+    bool m_shutdown; /*!< Set on destruction to terminate the deliberation thread */
+    std::string m_deliberationError; /*!< Failure reported by the deliberation thread */
     std::list<AgentListenerId> m_listeners; /*!< For monitoring events by external listeners */
 
     Clock& m_clock; /*!< The clock used to drive agent ticks. */
+    const OverrunPolicy m_overrunPolicy; /*!< How the agent gets back to the clock when it lags */
+    unsigned long m_skippedTicks; /*!< Ticks skipped by the SkipToNow policy */
+    unsigned long m_degradedTicks; /*!< Ticks run without deliberation by the DegradeDeliberation policy */
 
     /* Support for performance tracking */
     PerformanceMonitor m_monitor;
     RStat m_synchUsage;
-    RStat m_deliberationUsage;
+    ClockStat m_deliberationUsage;
+    const unsigned int m_latencyDumpPeriod; /*!< Ticks between latency dumps. 0 disables them. */
+    std::ofstream m_latencyLog; /*!< Destination of the periodic latency dumps */
+    const unsigned int m_checkpointPeriod; /*!< Ticks between checkpoints. 0 disables them. */
+    TelemetryServer* m_telemetry; /*!< Serves the statistics of the last tick. NULL unless telemetryPort is set */
+    TelemetrySample m_telemetrySample; /*!< Reused on each tick, so that the field names are only built once */
 
     /* Logging support */
     const bool m_enableEventLogger; /*!< If true, the agent will store events */
-    std::vector<Event> m_eventLog; /*!< Used for analysis and testing */
+    EventLog m_eventLog; /*!< Used for analysis and testing. Bounded by the eventLogSize attribute, streamed to eventLogFile */
     ObservationLogger m_obsLog;
+    MissionHistoryWriter* m_history; /*!< Columnar record of the mission for off line queries. NULL unless missionHistory is set */
     std::ostream& m_standardDebugStream; /*!<Stores debug stream to allow it to be reset on destruction */
 
-    static bool s_terminated; /*!< Marker for termination */    
+    static bool s_terminated; /*!< Marker for termination */
   };
 
 }
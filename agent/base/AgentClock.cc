@@ -37,9 +37,11 @@
 #include <time.h>
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 
 #include "LogManager.hh"
 #include "Guardian.hh"
+#include "ClockStat.hh"
 
 namespace TREX {
 
@@ -93,6 +95,13 @@ namespace TREX {
     sleep(getSleepDelay());
   }
 
+  TICK Clock::waitForNextTick(TICK tick){
+    TICK next;
+    while((next = getNextTick()) == tick)
+      sleep();
+    return next;
+  }
+
   TICK PseudoClock::selectStep(unsigned int stepsPerTick) {
     if( stepsPerTick<=0 ) {
       TREXLog()<<"requested number of steps is invalid ("<<stepsPerTick<<")."
@@ -121,73 +130,150 @@ namespace TREX {
     return 0;
   }
 
+  void PseudoClock::setInitialTick(TICK tick) {
+    m_tick = tick;
+    m_internalTicks = 0;
+  }
+
   /**
-   * Real Time Clock
+   * Simulation Clock
    */
-  void RealTimeClock::getDate(timeval &date) {
-    gettimeofday(&date, NULL);
+  SimulationClock::SimulationClock(double secondsPerTick, unsigned int maxStepsPerTick, bool stats) :
+    Clock(secondsPerTick, stats),
+    m_tick(0),
+    m_steps(0),
+    m_maxSteps(maxStepsPerTick)
+  {
+  }
+
+  TICK SimulationClock::getNextTick() {
+    if(m_maxSteps > 0 && m_steps >= m_maxSteps){
+      Clock::advanceTick(m_tick);
+      m_steps = 0;
+    }
+    m_steps++;
+    return m_tick;
   }
 
+  TICK SimulationClock::waitForNextTick(TICK tick) {
+    if(m_tick == tick)
+      Clock::advanceTick(m_tick);
+    m_steps = 0;
+    return m_tick;
+  }
+
+  bool SimulationClock::jumpTo(TICK tick) {
+    // Statistics are updated once for the whole jump
+    if(m_tick < tick){
+      Clock::advanceTick(m_tick);
+      m_tick = tick;
+    }
+    m_steps = 0;
+    return true;
+  }
+
+  void SimulationClock::setInitialTick(TICK tick) {
+    m_tick = tick;
+    m_steps = 0;
+  }
+
+  /**
+   * Real Time Clock
+   */
   RealTimeClock::RealTimeClock(double secondsPerTick, bool stats)
     : Clock(secondsPerTick, stats),
       m_started(false),
-      m_tick(0)
-  {
-    m_tvSecondsPerTick.tv_sec = static_cast<long>(std::floor(secondsPerTick));
-    m_tvSecondsPerTick.tv_usec = static_cast<long>(std::floor((secondsPerTick-m_tvSecondsPerTick.tv_sec)*1e6));
-  }
+      m_interrupted(false),
+      m_tick(0),
+      m_startTick(0),
+      m_startDate(0)
+  {}
 
   void RealTimeClock::start(){
-    getDate(m_nextTickDate);
-    setNextTickDate();
+    Guardian<Mutex> guard(m_lock);
+    m_startTick = m_tick;
+    m_startDate = ClockStat::now(ClockStat::monotonic);
     m_started = true;
+    m_tickCond.broadcast();
   }
 
-  void RealTimeClock::setNextTickDate(unsigned factor) {
-    m_nextTickDate.tv_usec += factor*m_tvSecondsPerTick.tv_usec;
-    m_nextTickDate.tv_sec += factor*m_tvSecondsPerTick.tv_sec + (m_nextTickDate.tv_usec/1000000);
-    m_nextTickDate.tv_usec %= 1000000;
+  void RealTimeClock::setInitialTick(TICK tick){
+    Guardian<Mutex> guard(m_lock);
+    m_tick = tick;
   }
 
-  double RealTimeClock::timeLeft() const {
-    timeval tv;
-    double result;
-    getDate(tv);
-    
-    result = m_nextTickDate.tv_usec - tv.tv_usec;
-    result /= 1e6;
-    result += m_nextTickDate.tv_sec - tv.tv_sec;
+  long long RealTimeClock::dateOf(TICK tick) const {
+    // Always from the start date : a date derived from the previous one would accumulate its rounding
+    return m_startDate + (long long) ((tick - m_startTick) * m_secondsPerTick * 1e9);
+  }
 
-    return result;
+  double RealTimeClock::timeLeft() const {
+    return (dateOf(m_tick + 1) - ClockStat::now(ClockStat::monotonic)) / 1e9;
   }
     
   TICK RealTimeClock::getNextTick(){
-   Guardian<Mutex> guard(m_lock);
-    
+    Guardian<Mutex> guard(m_lock);
+    return updateTick();
+  }
+
+  TICK RealTimeClock::updateTick(){
     if( m_started ) {      
-      double howLate = -timeLeft();
-      
-      if( howLate>=0 ) {
-	int tickIncr = 1+(int) std::floor(howLate/m_secondsPerTick);
-	m_tick += tickIncr;
-	setNextTickDate(tickIncr);
-// 	TREXLog()<<"[clock]["<<m_tick<<"] "<<howLate<<" secs late."<<std::endl; 
+      long long now = ClockStat::now(ClockStat::monotonic);
+
+      if( now>=dateOf(m_tick + 1) ) {
+	// Move to the tick of the current date, even if some were missed
+	m_tick = m_startTick + (TICK) std::floor((now - m_startDate) / (m_secondsPerTick * 1e9));
+	while( now>=dateOf(m_tick + 1) )
+	  m_tick++;
       }
     }
     return m_tick;
   }
 
+  TICK RealTimeClock::waitForNextTick(TICK tick){
+    Guardian<Mutex> guard(m_lock);
+
+    while( updateTick()==tick && !m_interrupted ) {
+      // Until started there is no tick date : wait for start() instead
+      if( m_started ) {
+	double delay = timeLeft();
+	if( delay>0.0 )
+	  m_tickCond.timedWait(m_lock, delay);
+      } else
+	m_tickCond.wait(m_lock);
+    }
+    m_interrupted = false;
+    return m_tick;
+  }
+
+  void RealTimeClock::interrupt(){
+    Guardian<Mutex> guard(m_lock);
+    m_interrupted = true;
+    m_tickCond.broadcast();
+  }
+
+  double RealTimeClock::getTimeLeft() const {
+    Guardian<Mutex> guard(m_lock);
+    if( !m_started )
+      return 0.0;
+    return std::max(0.0, timeLeft());
+  }
+
+  double RealTimeClock::getLateness(TICK tick) const {
+    if( !m_started )
+      return 0.0;
+    Guardian<Mutex> guard(m_lock);
+    return std::max(0.0, (ClockStat::now(ClockStat::monotonic) - dateOf(tick)) / 1e9);
+  }
+
   double RealTimeClock::getSleepDelay() const {    
-    if( m_started ) {
-      double delay;
-      {
-	Guardian<Mutex> guard(m_lock);
-	delay = timeLeft();
-      }
-//       TREXLog()<<"[clock]["<<m_tick<<"] sleeping for "<<delay<<" secs."<<std::endl;
-      return delay;
-    } else 
-      return Clock::getSleepDelay();
+    {
+      Guardian<Mutex> guard(m_lock);
+      // m_started is set by start under the same lock
+      if( m_started )
+	return timeLeft();
+    }
+    return Clock::getSleepDelay();
   }
 
 }
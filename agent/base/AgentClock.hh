@@ -40,6 +40,7 @@
 #include "RStat.hh"
 #include <sys/time.h>
 #include "Mutex.hh"
+#include "Condition.hh"
 
 /**
  * @brief Declaration of clock interface and implementation sub-classes
@@ -68,6 +69,38 @@ namespace TREX {
      */
     virtual void sleep() const;
 
+    /**
+     * @brief Block until the clock moves past the given tick
+     * @param tick The current tick
+     * @return The new tick. It may still be equal to tick if the wait was interrupted.
+     * @see interrupt
+     */
+    virtual TICK waitForNextTick(TICK tick);
+
+    /**
+     * @brief Wake up a thread blocked in waitForNextTick before the tick boundary
+     */
+    virtual void interrupt(){}
+
+    /**
+     * @brief Move the clock forward to the given tick, skipping the ticks in between
+     * @return false if this clock cannot skip ticks
+     */
+    virtual bool jumpTo(TICK tick){return false;}
+
+    /**
+     * @brief Wall clock time left before the next tick, in seconds
+     * @return 0 if the ticks of this clock have no wall clock deadline
+     */
+    virtual double getTimeLeft() const {return 0.0;}
+
+    /**
+     * @brief Wall clock time elapsed since the date of a tick, in seconds
+     * @param tick A tick
+     * @return 0 if @e tick is not due yet or if the ticks of this clock have no wall clock deadline
+     */
+    virtual double getLateness(TICK tick) const {return 0.0;}
+
     /**
      * @brief Utility to implement high-resolution sleep
      * @param sleepDuration The sleep duration in seconds. Accurate up to nanoseconds.
@@ -118,6 +151,11 @@ namespace TREX {
      */
     virtual void start(){}
 
+    /**
+     * @brief Count from the given tick instead of 0. Called before start when the agent resumes from a checkpoint.
+     */
+    virtual void setInitialTick(TICK tick) = 0;
+
     /** @brief Advance tick and update the stats.
      *
      * @param tick The main tick for clock
@@ -147,6 +185,7 @@ namespace TREX {
      */
     TICK getNextTick();
     virtual double getSleepDelay() const;
+    void setInitialTick(TICK tick);
 
   private:
     /**
@@ -159,8 +198,42 @@ namespace TREX {
     const TICK m_stepsPerTick;
   };
 
+  /**
+   * @brief Clock for simulations running as fast as possible. A tick ends as soon as the agent has no work left for it,
+   * or after maxStepsPerTick steps if that is not 0. It never sleeps.
+   * @note The agent only waits for the next tick once no reactor has work, so this clock is meant for inline deliberation.
+   */
+  class SimulationClock: public Clock {
+  public:
+    SimulationClock(double secondsPerTick, unsigned int maxStepsPerTick = 0, bool stats = true);
+
+    /**
+     * @brief Advance the tick once the step budget of the tick is spent
+     */
+    TICK getNextTick();
+
+    /**
+     * @brief The agent is done with the tick : advance right away
+     */
+    TICK waitForNextTick(TICK tick);
+
+    /**
+     * @brief Nothing happens until the given tick : go there right away
+     */
+    bool jumpTo(TICK tick);
+
+    void setInitialTick(TICK tick);
+
+  private:
+    TICK m_tick;
+    TICK m_steps; /*!< Steps in the current tick */
+    const TICK m_maxSteps;
+  };
+
   /**
    * @brief A clock that monitors time on a separate thread and generates updates to the tick.
+   * @note The date of each tick is computed from the start date on the monotonic clock, so rounding errors do not
+   * accumulate from tick to tick and changes of the system date do not move the ticks.
    */
   class RealTimeClock: public Clock {
   public:
@@ -176,19 +249,49 @@ namespace TREX {
      */
     TICK getNextTick();
 
+    void setInitialTick(TICK tick);
+
+    /**
+     * @brief Wait on a condition until the date of the next tick, instead of polling and sleeping
+     */
+    TICK waitForNextTick(TICK tick);
+
+    void interrupt();
+
+    /**
+     * @brief The time left before the date of the next tick, or 0 if it is already late or not started
+     */
+    double getTimeLeft() const;
+
+    /**
+     * @brief The time elapsed since the date of the given tick, or 0 if it is not due yet or the clock is not started
+     */
+    double getLateness(TICK tick) const;
+
   protected:
     double getSleepDelay() const;
 
   private:
-    static void getDate(timeval &val);
-    void setNextTickDate(unsigned factor=1);
+    /**
+     * @brief Monotonic date of a tick, in nanoseconds
+     * @pre The clock is started
+     */
+    long long dateOf(TICK tick) const;
     double timeLeft() const;
 
+    /**
+     * @brief Advance the tick if its date is past
+     * @pre m_lock is locked
+     */
+    TICK updateTick();
+
     bool m_started;
+    bool m_interrupted; /*!< Set by interrupt, cleared by waitForNextTick */
     TICK m_tick;
-    timeval m_tvSecondsPerTick;
-    timeval m_nextTickDate;
+    TICK m_startTick; /*!< The tick at start */
+    long long m_startDate; /*!< Monotonic date of m_startTick, in nanoseconds */
     mutable Mutex m_lock;
+    Condition m_tickCond; /*!< Signaled on interrupt and start */
   };
     
 }
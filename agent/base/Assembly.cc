@@ -69,6 +69,9 @@
 
 #include <fstream>
 #include <sstream>
+#include <map>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 namespace TREX {
   void initialize() { } //Used to force the library to load.
@@ -129,41 +132,66 @@ namespace TREX {
     check_error(txSource != NULL, "NULL transaction source provided.");
     static bool isFile(true);
 
-    std::ifstream f1(findFile("NDDL.cfg").c_str());
-    std::ifstream f2(findFile("temp_nddl_gen.cfg").c_str());
-    TiXmlElement* iroot = NULL;
-    if (f1.good()) {
-      iroot = EUROPA::initXml(findFile("NDDL.cfg").c_str());
-    } else if (f2.good()) {
-      iroot = EUROPA::initXml(findFile("temp_nddl_gen.cfg").c_str());
-    } else {
-      checkError(false, "Could not find 'NDDL.cfg' or 'temp_nddl_gen.cfg'");
+    std::string path = getNddlIncludePath();
+    if(!path.empty())
+      getLanguageInterpreter("nddl")->getEngine()->getConfig()->setProperty("nddl.includePath", path);
+
+    try {
+      std::string ret = executeScript("nddl", txSource, isFile);
+      assertTrue(ret == "", "Parser failed in " + std::string(txSource) + " with return: " + ret);
+    } catch(std::string ex) {
+      assertTrue(false, "Parser failed: " + ex);
+    } catch(...) {
+      assertTrue(false, "Parser failed with unknown exception reading " + std::string(txSource));
     }
+
+    return m_constraintEngine->constraintConsistent();
+  }
+
+  std::string Assembly::getNddlIncludePath(){
+    std::string file = findFile("NDDL.cfg");
+    struct stat st;
+    if(stat(file.c_str(), &st) != 0){
+      file = findFile("temp_nddl_gen.cfg");
+      checkError(stat(file.c_str(), &st) == 0, "Could not find 'NDDL.cfg' or 'temp_nddl_gen.cfg'");
+    }
+    return getNddlIncludePath(file);
+  }
+
+  std::string Assembly::getNddlIncludePath(const std::string& file){
+    // Include path by configuration file, with the modification time and size it was parsed for
+    typedef std::map<std::string, std::pair<std::pair<time_t, off_t>, std::string> > Cache;
+    static Cache sl_cache;
+
+    struct stat st;
+    if(stat(file.c_str(), &st) != 0)
+      return "";
+
+    std::pair<time_t, off_t> version(st.st_mtime, st.st_size);
+    Cache::const_iterator it = sl_cache.find(file);
+    if(it != sl_cache.end() && it->second.first == version)
+      return it->second.second;
+
+    std::string path;
+    TiXmlElement* iroot = EUROPA::initXml(file.c_str());
     if (iroot) {
       for (TiXmlElement * ichild = iroot->FirstChildElement();
 	   ichild != NULL;
 	   ichild = ichild->NextSiblingElement()) {
 	if (std::string(ichild->Value()) == "include") {
-	  std::string path = std::string(ichild->Attribute("path"));
+	  path = std::string(ichild->Attribute("path"));
 	  for (unsigned int i = 0; i < path.size(); i++) {
 	    if (path[i] == ';') {
 	      path[i] = ':';
 	    }
 	  }
-	  getLanguageInterpreter("nddl")->getEngine()->getConfig()->setProperty("nddl.includePath", path);
 	}
       }
-    }
-    try {
-      std::string ret = executeScript("nddl", txSource, isFile);
-      assertTrue(ret == "", "Parser failed in " + std::string(txSource) + " with return: " + ret);
-    } catch(std::string ex) {
-      assertTrue(false, "Parser failed: " + ex);
-    } catch(...) {
-      assertTrue(false, "Parser failed with unknown exception reading " + std::string(txSource));
+      delete iroot;
     }
 
-    return m_constraintEngine->constraintConsistent();
+    sl_cache[file] = std::make_pair(version, path);
+    return path;
   }
 
   const std::string& Assembly::exportToPlanWorks(TICK tick, unsigned int attempt){
@@ -183,6 +211,13 @@ namespace TREX {
   DbWriter* Assembly::getPPW(){
     if(m_ppw == NULL){
       m_ppw = new DbWriter(m_agentName.toString(), m_reactorName.toString(), m_planDatabase, m_constraintEngine, m_rulesEngine);
+
+      // Write the steps on a background thread with at most this number of steps pending
+      char *async = getenv(PPW_ASYNC_ENV);
+      if(async != NULL && atol(async) > 0){
+	char *sched = getenv(LOG_SCHED_ENV);
+	m_ppw->setAsync(atol(async), sched == NULL ? Thread::Scheduling() : Thread::Scheduling(sched));
+      }
     }
 
     return m_ppw;
@@ -294,6 +329,7 @@ namespace TREX {
       TREX_REGISTER_FLAW_MANAGER(assembly, TREX::GoalManager, GoalManager);
       TREX_REGISTER_FLAW_MANAGER(assembly, TREX::GreedyOpenConditionManager, GreedyOpenConditionManager);
       TREX_REGISTER_COMPONENT_FACTORY(assembly, TREX::EuclideanCostEstimator, EuclideanCostEstimator);
+      TREX_REGISTER_COMPONENT_FACTORY(assembly, TREX::TableCostEstimator, TableCostEstimator);
       TREX_REGISTER_COMPONENT_FACTORY(assembly, TREX::OrienteeringSolver, OrienteeringSolver);
       TREX_REGISTER_COMPONENT_FACTORY(assembly, TREX::EuropaSolverAdapter, EuropaSolverAdapter);
       TREX_REGISTER_FLAW_FILTER(assembly, DeliberationFilter, DeliberationFilter);
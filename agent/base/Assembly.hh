@@ -93,6 +93,12 @@ namespace TREX {
      */
     const std::string& exportToPlanWorks(TICK tick, unsigned int attempt);
 
+    /**
+     * @brief Include path of an NDDL configuration file, with ':' separators. Each file is parsed once for all the
+     * assemblies of the process, and again only when its modification time or size change.
+     */
+    static std::string getNddlIncludePath(const std::string& configFile);
+
     /**
      * @brief A plug-in class for schemas
      */
@@ -156,6 +162,11 @@ namespace TREX {
      */
     DbWriter* getPPW();
 
+    /**
+     * @brief Include path from NDDL.cfg, or temp_nddl_gen.cfg if there is none.
+     */
+    static std::string getNddlIncludePath();
+
     const LabelStr m_agentName;
     const LabelStr m_reactorName;
     SchemaId m_schema;
@@ -0,0 +1,702 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "BinaryObservationLog.cc"
+ */
+#include <cstring>
+#include <list>
+#include <stdint.h>
+
+#include "BinaryObservationLog.hh"
+#include "EuropaXML.hh"
+#include "Utilities.hh"
+#include "Debug.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+#include "Domains.hh"
+#include "DataTypes.hh"
+#include "DbClient.hh"
+#include "Object.hh"
+
+using namespace TREX;
+
+namespace {
+
+  /** @brief Size of the trailer record : tag, length, and offset */
+  size_t const TRAILER_SIZE = 1+4+8;
+  /** @brief Largest record payload accepted by the reader */
+  size_t const MAX_RECORD_SIZE = 16*1024*1024;
+  /** @brief Upper bound of a label id */
+  unsigned int const MAX_LABELS = 1<<20;
+  /** @brief Largest number of parameters, values or index entries */
+  unsigned int const MAX_COUNT = 1<<16;
+
+  void append(std::string &buf, void const *data, size_t len) {
+    buf.append(static_cast<char const *>(data), len);
+  }
+
+  void appendU32(std::string &buf, unsigned int val) {
+    uint32_t tmp = val;
+    append(buf, &tmp, sizeof(tmp));
+  }
+
+  void appendOffset(std::string &buf, long offset) {
+    unsigned long off = offset;
+    appendU32(buf, off & 0xffffffffUL);
+    appendU32(buf, (off>>16)>>16);
+  }
+
+  /** @brief Sequential decoding of a record payload */
+  class Decoder {
+  public:
+    Decoder(std::string const &buf)
+      :m_buf(buf), m_pos(0) {}
+
+    unsigned char u8() {
+      check(1);
+      return static_cast<unsigned char>(m_buf[m_pos++]);
+    }
+    unsigned int u32() {
+      uint32_t tmp;
+      get(&tmp, sizeof(tmp));
+      return tmp;
+    }
+    double real() {
+      double tmp;
+      get(&tmp, sizeof(tmp));
+      return tmp;
+    }
+    /** @brief Number of items, each taking at least @e itemSize bytes in the rest of the payload */
+    unsigned int count(size_t itemSize) {
+      unsigned int ret = u32();
+      ConfigurationException::configurationCheckError(ret<=MAX_COUNT && ret*itemSize<=m_buf.size()-m_pos,
+						      "BinaryObservationReader : count out of range.");
+      return ret;
+    }
+    long offset() {
+      unsigned long lo = u32();
+      unsigned long hi = u32();
+      return static_cast<long>(((hi<<16)<<16)|lo);
+    }
+    std::string rest() {
+      std::string ret = m_buf.substr(m_pos);
+      m_pos = m_buf.size();
+      return ret;
+    }
+
+  private:
+    void check(size_t len) const {
+      ConfigurationException::configurationCheckError(m_pos+len<=m_buf.size(),
+						      "BinaryObservationReader : truncated record.");
+    }
+    void get(void *dest, size_t len) {
+      check(len);
+      memcpy(dest, m_buf.data()+m_pos, len);
+      m_pos += len;
+    }
+
+    std::string const &m_buf;
+    size_t m_pos;
+  }; // ::Decoder
+
+  void checkLength(uint32_t len) {
+    ConfigurationException::configurationCheckError(len<=MAX_RECORD_SIZE,
+						    "BinaryObservationReader : record too large.");
+  }
+
+  bool readRecord(FILE *in, char &tag, std::string &payload) {
+    int c = fgetc(in);
+    uint32_t len;
+
+    if( EOF==c || 1!=fread(&len, sizeof(len), 1, in) )
+      return false;
+    tag = static_cast<char>(c);
+    checkLength(len);
+    payload.resize(len);
+    return 0==len || 1==fread(&payload[0], len, 1, in);
+  }
+
+} // <unnamed>
+
+/*
+ * class BinaryObservationLog
+ */
+// Statics :
+
+char const *BinaryObservationLog::magic() {
+  return "TREXOBS1";
+}
+
+bool BinaryObservationLog::isBinary(std::string const &fileName) {
+  FILE *in = fopen(fileName.c_str(), "rb");
+  char buf[8];
+  bool ret = false;
+
+  if( NULL!=in ) {
+    ret = (1==fread(buf, sizeof(buf), 1, in) && 0==memcmp(buf, magic(), sizeof(buf)));
+    fclose(in);
+  }
+  return ret;
+}
+
+/*
+ * class BinaryObservationWriter
+ */
+// Structors :
+
+BinaryObservationWriter::BinaryObservationWriter(FILE *out, bool indexed)
+  :m_file(out), m_indexed(indexed) {
+  fwrite(BinaryObservationLog::magic(), 8, 1, m_file);
+}
+
+BinaryObservationWriter::~BinaryObservationWriter() {
+  long pos = ftell(m_file);
+  std::string buf;
+
+  appendU32(buf, m_index.size());
+  for(std::vector< std::pair<TICK, long> >::const_iterator i=m_index.begin();
+      m_index.end()!=i; ++i) {
+    appendU32(buf, i->first);
+    appendOffset(buf, i->second);
+  }
+  writeRecordHeader('X', buf.size());
+  fwrite(buf.data(), buf.size(), 1, m_file);
+
+  buf.clear();
+  appendOffset(buf, pos);
+  writeRecordHeader('Z', buf.size());
+  fwrite(buf.data(), buf.size(), 1, m_file);
+  fclose(m_file);
+}
+
+// Manipulators :
+
+void BinaryObservationWriter::tick(TICK tick) {
+  std::string buf;
+
+  if( m_indexed )
+    m_index.push_back(std::make_pair(tick, ftell(m_file)));
+  appendU32(buf, tick);
+  writeRecordHeader('T', buf.size());
+  fwrite(buf.data(), buf.size(), 1, m_file);
+}
+
+void BinaryObservationWriter::log(Observation const &obs) {
+  m_buffer.clear();
+  putObservation(obs, 0);
+  writeRecord('O');
+}
+
+void BinaryObservationWriter::request(TokenId const &goal) {
+  putToken(goal);
+  writeRecord('G');
+}
+
+void BinaryObservationWriter::history(TokenId const &token) {
+  if( token->getObject()->lastDomain().isSingleton() )
+    putToken(token);
+  else {
+    // Only its possible objects are known : the history keeps them all
+    std::vector<ConstrainedVariableId> const &params = token->parameters();
+
+    m_buffer.clear();
+    putU32(token->getKey());
+    putU32(label(""));
+    putU32(label(token->getPredicateName().toString()));
+    putU32(params.size()+4);
+    for(size_t i=0; i<params.size(); ++i)
+      putParameter(params[i]->getName().toString(), params[i]->lastDomain());
+    putParameter("object", token->getObject()->lastDomain());
+    putParameter("start", token->start()->lastDomain());
+    putParameter("end", token->end()->lastDomain());
+    putParameter("duration", token->duration()->lastDomain());
+  }
+  writeRecord('H');
+}
+
+void BinaryObservationWriter::putToken(TokenId const &token) {
+  ObservationByReference obs(token);
+
+  m_buffer.clear();
+  putU32(token->getKey());
+  putObservation(obs, 3);
+  putParameter("start", token->start()->lastDomain());
+  putParameter("end", token->end()->lastDomain());
+  putParameter("duration", token->duration()->lastDomain());
+}
+
+void BinaryObservationWriter::recall(TokenId const &goal) {
+  m_buffer.clear();
+  putU32(goal->getKey());
+  writeRecord('C');
+}
+
+void BinaryObservationWriter::endTick() {
+  writeRecordHeader('E', 0);
+}
+
+void BinaryObservationWriter::putObservation(Observation const &obs, size_t extra) {
+  size_t i, cnt = obs.countParameters();
+
+  putU32(label(obs.getObjectName().toString()));
+  putU32(label(obs.getPredicate().toString()));
+  putU32(cnt+extra);
+  for( i=0; i<cnt; ++i ) {
+    std::pair<LabelStr, AbstractDomain const *> nameValuePair = obs[i];
+    putParameter(nameValuePair.first.toString(), *(nameValuePair.second));
+  }
+}
+
+void BinaryObservationWriter::putParameter(std::string const &name, AbstractDomain const &domain) {
+  // The label has to be defined before it is referred to in the payload
+  unsigned int id = label(name);
+  putU32(id);
+  encode(domain);
+}
+
+void BinaryObservationWriter::writeRecord(char tag) {
+  writeRecordHeader(tag, m_buffer.size());
+  fwrite(m_buffer.data(), m_buffer.size(), 1, m_file);
+}
+
+void BinaryObservationWriter::writeRecordHeader(char tag, unsigned int length) {
+  uint32_t len = length;
+  fputc(tag, m_file);
+  fwrite(&len, sizeof(len), 1, m_file);
+}
+
+unsigned int BinaryObservationWriter::label(std::string const &str) {
+  std::map<std::string, unsigned int>::const_iterator i = m_labels.find(str);
+
+  if( m_labels.end()!=i )
+    return i->second;
+
+  unsigned int id = m_labels.size();
+  std::string buf;
+
+  m_labels.insert(std::make_pair(str, id));
+  appendU32(buf, id);
+  buf.append(str);
+  writeRecordHeader('L', buf.size());
+  fwrite(buf.data(), buf.size(), 1, m_file);
+  return id;
+}
+
+void BinaryObservationWriter::encode(AbstractDomain const &domain) {
+  checkError(!domain.isEmpty(), "BinaryObservationWriter: empty domain.");
+  unsigned int type = label(domain.getDataType()->getName().toString());
+
+  if( domain.isSingleton() ) {
+    putU8('v');
+    putU32(type);
+    putU32(1);
+    encodeValue(domain, domain.getSingletonValue());
+  } else if( domain.isEnumerated() ) {
+    std::list<double> values;
+
+    domain.getValues(values);
+    putU8('s');
+    putU32(type);
+    putU32(values.size());
+    for(std::list<double>::const_iterator i=values.begin(); values.end()!=i; ++i)
+      encodeValue(domain, *i);
+  } else {
+    putU8('i');
+    putU32(type);
+    putU32(2);
+    encodeValue(domain, domain.getLowerBound());
+    encodeValue(domain, domain.getUpperBound());
+  }
+}
+
+void BinaryObservationWriter::encodeValue(AbstractDomain const &domain, double value) {
+  if( domain.isEntity() ) {
+    putU8('o');
+    putU32(label(domain_val_to_str(domain, value)));
+  } else if( domain.getDataType()->isBool() ) {
+    putU8('b');
+    putDouble(value);
+  } else if( domain.getDataType()->isNumeric() ) {
+    putU8('n');
+    putDouble(value);
+  } else {
+    putU8('y');
+    putU32(label(domain_val_to_str(domain, value)));
+  }
+}
+
+void BinaryObservationWriter::putU8(unsigned char val) {
+  m_buffer.push_back(static_cast<char>(val));
+}
+
+void BinaryObservationWriter::putU32(unsigned int val) {
+  appendU32(m_buffer, val);
+}
+
+void BinaryObservationWriter::putDouble(double val) {
+  append(m_buffer, &val, sizeof(val));
+}
+
+/*
+ * class BinaryObservationReader
+ */
+// Structors :
+
+BinaryObservationReader::BinaryObservationReader(std::string const &fileName, bool allRecords)
+  :m_file(fopen(fileName.c_str(), "rb")), m_allRecords(allRecords), m_stream(false), m_tick(0), m_hasPending(false),
+   m_pendingKind('O'), m_pendingKey(0) {
+  char buf[8];
+
+  ConfigurationException::configurationCheckError(NULL!=m_file, "Unable to open \""+fileName+'\"');
+  if( 1!=fread(buf, sizeof(buf), 1, m_file) || 0!=memcmp(buf, BinaryObservationLog::magic(), sizeof(buf)) ) {
+    fclose(m_file);
+    m_file = NULL;
+    ConfigurationException::configurationCheckError(false, '\"'+fileName+"\" is not a binary observation log");
+  }
+}
+
+BinaryObservationReader::BinaryObservationReader(FILE *in, bool allRecords)
+  :m_file(in), m_allRecords(allRecords), m_stream(true), m_tick(0), m_hasPending(false),
+   m_pendingKind('O'), m_pendingKey(0) {
+  char buf[8];
+
+  if( 1!=fread(buf, sizeof(buf), 1, m_file) || 0!=memcmp(buf, BinaryObservationLog::magic(), sizeof(buf)) ) {
+    fclose(m_file);
+    m_file = NULL;
+    ConfigurationException::configurationCheckError(false, "Stream is not a binary observation log");
+  }
+}
+
+BinaryObservationReader::~BinaryObservationReader() {
+  if( NULL!=m_file )
+    fclose(m_file);
+}
+
+// Manipulators :
+
+bool BinaryObservationReader::peek(TICK &tick) {
+  if( !m_hasPending && !fetch() )
+    return false;
+  tick = m_tick;
+  return true;
+}
+
+void BinaryObservationReader::next(BinaryObservationLog::Record &rec) {
+  checkError(m_hasPending, "BinaryObservationReader: no observation to read.");
+  rec.kind = m_pendingKind;
+  rec.key = m_pendingKey;
+  if( 'C'!=m_pendingKind && 'E'!=m_pendingKind )
+    decode(m_pending, rec);
+  m_hasPending = false;
+}
+
+bool BinaryObservationReader::seek(TICK tick) {
+  char tag, trailer[TRAILER_SIZE];
+  uint32_t len;
+  std::string payload;
+
+  // A log which was not closed ends with any record : check the trailer before trusting its length
+  if( 0!=fseek(m_file, -static_cast<long>(TRAILER_SIZE), SEEK_END) ||
+      1!=fread(trailer, sizeof(trailer), 1, m_file) || 'Z'!=trailer[0] )
+    return false;
+  memcpy(&len, trailer+1, sizeof(len));
+  if( 8!=len )
+    return false;
+
+  payload.assign(trailer+1+4, 8);
+  long target = Decoder(payload).offset();
+  if( 0!=fseek(m_file, target, SEEK_SET) || !readRecord(m_file, tag, payload) || 'X'!=tag )
+    return false;
+
+  Decoder index(payload);
+  for(unsigned int i=0, cnt=index.count(4+8); i<cnt; ++i) {
+    TICK t = index.u32();
+    long off = index.offset();
+    if( t>=tick ) {
+      target = off;
+      break;
+    }
+  }
+
+  // Labels are defined on first use : collect the ones defined before target
+  m_labels.clear();
+  fseek(m_file, 8, SEEK_SET);
+  while( ftell(m_file)<target ) {
+    int c = fgetc(m_file);
+    uint32_t len;
+
+    if( EOF==c || 1!=fread(&len, sizeof(len), 1, m_file) )
+      return false;
+    if( 'L'==c ) {
+      checkLength(len);
+      payload.resize(len);
+      if( 0!=len && 1!=fread(&payload[0], len, 1, m_file) )
+	return false;
+      define(payload);
+    } else
+      fseek(m_file, len, SEEK_CUR);
+  }
+  m_hasPending = false;
+  return true;
+}
+
+bool BinaryObservationReader::fetch() {
+  char tag;
+  std::string payload;
+
+  while( readRecord(m_file, tag, payload) ) {
+    switch( tag ) {
+    case 'L':
+      define(payload);
+      break;
+    case 'T':
+      m_tick = Decoder(payload).u32();
+      break;
+    case 'O':
+      m_pending.swap(payload);
+      m_pendingKind = tag;
+      m_pendingKey = 0;
+      m_hasPending = true;
+      return true;
+    case 'G':
+    case 'C':
+    case 'H':
+      if( m_allRecords ) {
+	Decoder in(payload);
+	m_pendingKey = in.u32();
+	m_pending = in.rest();
+	m_pendingKind = tag;
+	m_hasPending = true;
+	return true;
+      }
+      break;
+    case 'E':
+      if( m_stream ) {
+	m_pendingKind = tag;
+	m_pendingKey = 0;
+	m_hasPending = true;
+	return true;
+      }
+      break;
+    case 'X':
+    case 'Z':
+      // Reached the index : no more observations
+      return false;
+    default:
+      debugMsg("BinaryObservationReader", "Skipping unknown record '"<<tag<<"'");
+    }
+  }
+  return false;
+}
+
+// Observers :
+
+void BinaryObservationReader::decode(std::string const &payload,
+				     BinaryObservationLog::Record &rec) const {
+  Decoder in(payload);
+
+  rec.timeline = label(in.u32());
+  rec.predicate = label(in.u32());
+  // A parameter takes at least a name, a kind, a type and a count
+  rec.parameters.resize(in.count(4+1+4+4));
+  for(size_t i=0; i<rec.parameters.size(); ++i) {
+    BinaryObservationLog::Domain &dom = rec.parameters[i].second;
+
+    rec.parameters[i].first = label(in.u32());
+    dom.kind = in.u8();
+    dom.type = label(in.u32());
+    dom.values.resize(in.count(1+4));
+    for(size_t j=0; j<dom.values.size(); ++j) {
+      BinaryObservationLog::Value &val = dom.values[j];
+
+      val.kind = in.u8();
+      if( 'b'==val.kind || 'n'==val.kind ) 
+	val.number = in.real();
+      else
+	val.symbol = label(in.u32());
+    }
+  }
+}
+
+void BinaryObservationReader::define(std::string const &payload) {
+  Decoder def(payload);
+  unsigned int id = def.u32();
+
+  ConfigurationException::configurationCheckError(id<MAX_LABELS,
+						  "BinaryObservationReader : label id out of range.");
+  if( m_labels.size()<=id )
+    m_labels.resize(id+1);
+  m_labels[id] = def.rest();
+}
+
+std::string const &BinaryObservationReader::label(unsigned int id) const {
+  ConfigurationException::configurationCheckError(id<m_labels.size(),
+						  "BinaryObservationReader : undefined label.");
+  return m_labels[id];
+}
+
+/*
+ * class BinaryObservationDecoder
+ */
+// Structors :
+
+BinaryObservationDecoder::BinaryObservationDecoder()
+  :m_floatDT(FloatDT::instance()),
+   m_intDT(IntDT::instance()),
+   m_boolDT(BoolDT::instance()),
+   m_stringDT(StringDT::instance()),
+   m_symbolDT(SymbolDT::instance()) {}
+
+// Manipulators :
+
+AbstractDomain *BinaryObservationDecoder::asDomain(BinaryObservationLog::Domain const &dom) {
+  // The domain may come from a peer : it is checked before anything is allocated
+  ConfigurationException::configurationCheckError(!dom.values.empty(),
+						  "BinaryObservationDecoder:asDomain : empty domain.");
+
+  BinaryObservationLog::Value const &first = dom.values.front();
+  bool numeric = ('n'==first.kind || 'b'==first.kind);
+
+  ConfigurationException::configurationCheckError('o'!=first.kind,
+						  "BinaryObservationDecoder:asDomain : object parsing not supported.");
+  if( 'i'==dom.kind ) {
+    ConfigurationException::configurationCheckError(numeric && dom.values.size()==2 && first.kind==dom.values[1].kind &&
+						    first.number<=dom.values[1].number,
+						    "BinaryObservationDecoder:asDomain : type \""+dom.type+"\" is not an interval domain type.");
+    IntervalDomain *domain = dynamic_cast<IntervalDomain *>(m_domains.acquire(m_floatDT));
+
+    checkError(NULL!=domain, "BinaryObservationDecoder:asDomain : float domains are not intervals.");
+    domain->intersect(dom.values[0].number, dom.values[1].number);
+    return domain;
+  } else if( 'v'==dom.kind ) {
+    ConfigurationException::configurationCheckError(1==dom.values.size(),
+						    "BinaryObservationDecoder:asDomain : singleton with several values.");
+    if( numeric ) {
+      DataTypeId factory = ('b'==first.kind ? m_boolDT : getFactory(dom.type));
+      AbstractDomain *domain = m_domains.acquire(factory);
+      
+      if(domain->isOpen() && !domain->isMember(first.number))
+	domain->insert(first.number);
+      domain->set(first.number);
+      return domain;
+    } else if( "string"==dom.type ) 
+      return new StringDomain(first.symbol.c_str(), m_stringDT);
+    else 
+      return new SymbolDomain(LabelStr(first.symbol), m_symbolDT);
+  } else {
+    std::list<double> values;
+
+    ConfigurationException::configurationCheckError('s'==dom.kind,
+						    "BinaryObservationDecoder:asDomain : unknown domain kind.");
+    for(std::vector<BinaryObservationLog::Value>::const_iterator i=dom.values.begin();
+	dom.values.end()!=i; ++i) {
+      ConfigurationException::configurationCheckError(numeric==('n'==i->kind || 'b'==i->kind),
+						      "BinaryObservationDecoder:asDomain : mixed types in the same enumerated set.");
+      values.push_back(numeric ? i->number : static_cast<double>(LabelStr(i->symbol)));
+    }
+    if( numeric ) 
+      return new EnumeratedDomain('b'==first.kind ? m_boolDT : getFactory(dom.type), values);
+    else if( "string"==dom.type )
+      return new StringDomain(values, m_stringDT);
+    else 
+      return new SymbolDomain(values, m_symbolDT);
+  }
+} // BinaryObservationDecoder::asDomain(BinaryObservationLog::Domain const &)
+
+Observation *BinaryObservationDecoder::asObservation(BinaryObservationLog::Record const &rec) {
+  // Domains go back to the pool once the observation has been delivered
+  ObservationByValue *obs = new ObservationByValue(rec.timeline, rec.predicate, &m_domains);
+
+  obs->reserve(rec.parameters.size());
+  try {
+    for(std::vector< std::pair<std::string, BinaryObservationLog::Domain> >::const_iterator i=rec.parameters.begin();
+	rec.parameters.end()!=i; ++i) 
+      obs->push_back(i->first, asDomain(i->second));
+  } catch(ConfigurationException *) {
+    delete obs;
+    throw;
+  }
+  return obs;
+} // BinaryObservationDecoder::asObservation(BinaryObservationLog::Record const &)
+
+TokenId BinaryObservationDecoder::asGoal(BinaryObservationLog::Record const &rec, DbClientId const &client) {
+  ObjectId object = client->getObject(rec.timeline.c_str());
+
+  ConfigurationException::configurationCheckError(object.isId(), "BinaryObservationDecoder : no timeline <"+rec.timeline+"> in the goal model");
+  TokenId goal = client->createToken(rec.predicate.c_str(), NULL, true);
+  goal->getObject()->specify(object);
+  for(std::vector< std::pair<std::string, BinaryObservationLog::Domain> >::const_iterator i=rec.parameters.begin();
+      rec.parameters.end()!=i; ++i) {
+    ConstrainedVariableId var = goal->getVariable(LabelStr(i->first));
+
+    if( var.isNoId() ) {
+      std::string name = goal->toString();
+
+      client->deleteToken(goal);
+      ConfigurationException::configurationCheckError(false, name+" has no variable "+i->first);
+    }
+    AbstractDomain *dom;
+
+    try {
+      dom = asDomain(i->second);
+    } catch(ConfigurationException *) {
+      client->deleteToken(goal);
+      throw;
+    }
+    var->restrictBaseDomain(*dom);
+    m_domains.release(dom);
+  }
+  return goal;
+} // BinaryObservationDecoder::asGoal(BinaryObservationLog::Record const &, DbClientId const &)
+
+// Observers :
+
+DataTypeId BinaryObservationDecoder::getFactory(std::string const &type) const {
+  if("float" == type || "REAL_INTERVAL" == type)
+    return m_floatDT;
+  if("int" == type || "INT_INTERVAL" == type)
+    return m_intDT;
+  if("bool" == type)
+    return m_boolDT;
+  if("string" == type)
+    return m_stringDT;
+  if("symbol" == type)
+    return m_symbolDT;
+
+  ConfigurationException::configurationCheckError(false, "BinaryObservationDecoder : no match on input type "+type);
+  return m_floatDT;
+}
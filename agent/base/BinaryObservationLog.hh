@@ -0,0 +1,371 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "BinaryObservationLog.hh"
+ * @brief Definition of the binary observation log writer and reader
+ */
+#ifndef _BINARYOBSERVATIONLOG_HH
+#define _BINARYOBSERVATIONLOG_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "TREXDefs.hh"
+#include "Observer.hh"
+
+namespace TREX {
+
+  /** @brief Binary observation log format.
+   *
+   * A binary log starts with the 8 bytes magic number "TREXOBS1"
+   * followed by a sequence of records. Each record is framed with a
+   * one byte tag and a 32 bits payload length so a reader can skip
+   * records it does not care about :
+   * @li @c L defines a label : 32 bits id followed by the text
+   * @li @c T starts a new tick : 32 bits tick value
+   * @li @c O an observation (see BinaryObservationLog::Record)
+   * @li @c G a goal request : 32 bits goal key followed by the same
+   *     payload as an observation, the start, end and duration of the
+   *     goal being its last parameters
+   * @li @c C a recall : 32 bits key of the recalled goal
+   * @li @c H a token of the plan history : same payload as a goal
+   *     request, the key being the one of the token. A token whose
+   *     object is not bound has an empty timeline and an extra object
+   *     parameter listing its possible objects
+   * @li @c E ends the records of the current tick. Only written on
+   *     streams so the reader knows a tick is complete
+   * @li @c X the tick index : pairs of 32 bits tick and 64 bits file offset
+   * @li @c Z the trailer : 64 bits offset of the index record
+   *
+   * All the strings (timelines, predicates, parameter names, types and
+   * symbolic values) are interned in the label table and referred
+   * to by their id. A label is always defined before its first use.
+   * Integers and doubles are stored in host byte order.
+   *
+   * As logs are also read from peers, the reader bounds what it
+   * allocates : a record is at most 16MB, a label id below 2^20 and
+   * a count of parameters, values or index entries at most 2^16 and
+   * within the record. Any frame beyond these limits is rejected with
+   * a ConfigurationException.
+   */
+  class BinaryObservationLog {
+  public:
+    /** @brief A value of a domain */
+    struct Value {
+      /** @brief Kind of value
+       *
+       * @c b boolean, @c n numeric, @c y symbolic (either string or
+       * symbol) and @c o object.
+       */
+      char kind;
+      double number; //!< value for boolean and numeric kinds
+      std::string symbol; //!< value for symbolic and object kinds
+    };
+    /** @brief A domain */
+    struct Domain {
+      /** @brief Kind of domain
+       *
+       * @c v singleton, @c s enumerated set and @c i interval.
+       */
+      char kind;
+      std::string type; //!< Name of the domain data type
+      std::vector<Value> values; //!< The values. For an interval : lower and upper bound
+    };
+    /** @brief A decoded observation, request or recall */
+    struct Record {
+      Record():kind('O'), key(0) {}
+
+      char kind; //!< Tag of the record : @c O, @c G, @c C, @c H or @c E
+      int key; //!< Key of the goal for a request or a recall, or of the token for a history record
+      std::string timeline;
+      std::string predicate;
+      std::vector< std::pair<std::string, Domain> > parameters;
+    };
+
+    /** @brief Magic number at the start of a binary log */
+    static char const *magic();
+    /** @brief Check the format of a log file
+     *
+     * @param fileName A file name
+     *
+     * @retval true if @e fileName starts with the binary log magic number
+     * @retval false else
+     */
+    static bool isBinary(std::string const &fileName);
+  }; // TREX::BinaryObservationLog
+
+  /** @brief Binary observation log writer
+   *
+   * This class is used by ObservationLogger when the agent is
+   * configured to produce a binary log.
+   */
+  class BinaryObservationWriter {
+  public:
+    // Structors :
+    /** @brief Constructor
+     *
+     * @param out An open file
+     * @param indexed If false no tick index is kept, as for a stream
+     * which cannot be sought anyway
+     *
+     * Writes the magic number to @e out. The writer takes ownership
+     * of @e out.
+     */
+    explicit BinaryObservationWriter(FILE *out, bool indexed = true);
+    /** @brief Destructor
+     *
+     * Writes the tick index and the trailer then closes the file.
+     */
+    ~BinaryObservationWriter();
+
+    // Manipulators :
+    /** @brief Start a new tick
+     *
+     * @param tick The tick value
+     */
+    void tick(TICK tick);
+    /** @brief Write an observation
+     *
+     * @param obs An observation
+     */
+    void log(Observation const &obs);
+    /** @brief Write a goal request
+     *
+     * @param goal The requested goal. Its object must be bound.
+     */
+    void request(TokenId const &goal);
+    /** @brief Write a recall
+     *
+     * @param goal The recalled goal
+     */
+    void recall(TokenId const &goal);
+    /** @brief Write a token of the plan history
+     *
+     * @param token A token
+     */
+    void history(TokenId const &token);
+    /** @brief End the current tick
+     *
+     * Marks that all the records of the current tick were written.
+     * Readers of a file ignore it.
+     */
+    void endTick();
+
+  private:
+    void writeRecordHeader(char tag, unsigned int length);
+    void writeRecord(char tag);
+    void putToken(TokenId const &token);
+    void putObservation(Observation const &obs, size_t extra);
+    void putParameter(std::string const &name, AbstractDomain const &domain);
+    /** @brief Id of a label
+     *
+     * Defines @e str in the log if it was not already.
+     */
+    unsigned int label(std::string const &str);
+    void encode(AbstractDomain const &domain);
+    void encodeValue(AbstractDomain const &domain, double value);
+
+    void putU8(unsigned char val);
+    void putU32(unsigned int val);
+    void putDouble(double val);
+
+    FILE *m_file;
+    bool const m_indexed;
+    std::map<std::string, unsigned int> m_labels;
+    std::vector< std::pair<TICK, long> > m_index;
+    std::string m_buffer; //!< payload of the observation being encoded
+
+    // Following functions are not implemented in purpose
+    BinaryObservationWriter(BinaryObservationWriter const &);
+    void operator= (BinaryObservationWriter const &);
+  }; // TREX::BinaryObservationWriter
+
+  /** @brief Streaming binary observation log reader
+   *
+   * This class reads a binary observation log one record at a time.
+   * There is no need to load the whole file before starting to
+   * replay it.
+   */
+  class BinaryObservationReader {
+  public:
+    // Structors :
+    /** @brief Constructor
+     *
+     * @param fileName The log file name
+     * @param allRecords If true requests, recalls and history records
+     * are read as well. Otherwise they are skipped as the observations
+     * are read.
+     *
+     * @throw ConfigurationException unable to open @e fileName or
+     * this is not a binary observation log.
+     */
+    explicit BinaryObservationReader(std::string const &fileName, bool allRecords = false);
+    /** @brief Stream constructor
+     *
+     * @param in An open stream, typically a socket
+     * @param allRecords If true requests and recalls are read as well
+     *
+     * The reader takes ownership of @e in. As a stream cannot be
+     * rewound seek always fails and peek blocks until the next record
+     * arrives. The end of each tick is read as a record of kind @c E.
+     *
+     * @throw ConfigurationException @e in is not a binary observation log.
+     */
+    BinaryObservationReader(FILE *in, bool allRecords);
+    /** @brief Destructor */
+    ~BinaryObservationReader();
+
+    // Manipulators :
+    /** @brief Tick of the next observation
+     *
+     * @param[out] tick The tick of the next observation
+     *
+     * @retval true if there is still one observation to read. Its tick
+     * is then stored in @e tick
+     * @retval false the end of the log was reached
+     */
+    bool peek(TICK &tick);
+    /** @brief Read next observation
+     *
+     * @param[out] rec The decoded observation
+     *
+     * @pre peek returned true
+     *
+     * @throw ConfigurationException the record is malformed
+     */
+    void next(BinaryObservationLog::Record &rec);
+    /** @brief Go to a tick
+     *
+     * @param tick A tick value
+     *
+     * Moves the reader to the first observation occurring at or after
+     * @e tick using the tick index.
+     *
+     * @retval true success
+     * @retval false the log has no index (i.e. was not closed properly)
+     */
+    bool seek(TICK tick);
+
+  private:
+    /** @brief Read records until the next observation
+     *
+     * @retval false the end of the log was reached
+     */
+    bool fetch();
+    void decode(std::string const &payload, BinaryObservationLog::Record &rec) const;
+    /** @brief Add the label defined by the payload of a @c L record */
+    void define(std::string const &payload);
+    std::string const &label(unsigned int id) const;
+
+    FILE *m_file;
+    bool const m_allRecords;
+    bool const m_stream; //!< true if the end of the ticks are read
+    std::vector<std::string> m_labels;
+    TICK m_tick;
+    bool m_hasPending;
+    char m_pendingKind; //!< tag of the next record
+    int m_pendingKey; //!< goal key of the next record if a request or a recall
+    std::string m_pending; //!< payload of the next record
+
+    // Following functions are not implemented in purpose
+    BinaryObservationReader(BinaryObservationReader const &);
+    void operator= (BinaryObservationReader const &);
+  }; // TREX::BinaryObservationReader
+
+  /** @brief Conversion of decoded records
+   *
+   * This class converts the records read by a BinaryObservationReader
+   * back into observations and goals. The domains of the observations
+   * are recycled through an internal pool so the observations must be
+   * deleted before the decoder.
+   */
+  class BinaryObservationDecoder {
+  public:
+    BinaryObservationDecoder();
+    ~BinaryObservationDecoder() {}
+
+    /** @brief Conversion of a binary log domain
+     *
+     * @param dom A decoded domain
+     *
+     * @return The corresponding domain. The caller can give it back
+     * with release
+     *
+     * @throw ConfigurationException @e dom is not a valid domain
+     */
+    AbstractDomain *asDomain(BinaryObservationLog::Domain const &dom);
+    /** @brief Recycles a domain returned by asDomain */
+    void release(AbstractDomain *dom) {
+      m_domains.release(dom);
+    }
+    /** @brief Conversion of a binary log observation
+     *
+     * @param rec A decoded observation
+     *
+     * @return The corresponding Observation
+     */
+    Observation *asObservation(BinaryObservationLog::Record const &rec);
+    /** @brief Conversion of a recorded request
+     *
+     * @param rec A decoded request
+     * @param client Client of the database where to create the goal
+     *
+     * @return A new goal with the recorded parameters as base domains
+     */
+    TokenId asGoal(BinaryObservationLog::Record const &rec, DbClientId const &client);
+
+    /** @brief Data type of a recorded type name */
+    DataTypeId getFactory(std::string const &type) const;
+
+  private:
+    DataTypeId m_floatDT;
+    DataTypeId m_intDT;
+    DataTypeId m_boolDT;
+    DataTypeId m_stringDT;
+    DataTypeId m_symbolDT;
+    DomainPool m_domains;
+
+    // Following functions are not implemented in purpose
+    BinaryObservationDecoder(BinaryObservationDecoder const &);
+    void operator= (BinaryObservationDecoder const &);
+  }; // TREX::BinaryObservationDecoder
+
+} // TREX
+
+#endif // _BINARYOBSERVATIONLOG_HH
@@ -0,0 +1,502 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "Checkpoint.cc"
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <map>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "Checkpoint.hh"
+#include "EuropaXML.hh"
+#include "Utilities.hh"
+#include "ErrnoExcept.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+#include "PlanDatabase.hh"
+#include "Object.hh"
+#include "Debug.hh"
+
+using namespace TREX;
+
+namespace {
+
+  /** @brief Sequential encoding of a checkpoint
+   *
+   * Labels are defined in the file on first use, as for the binary
+   * observation log.
+   */
+  class Encoder {
+  public:
+    Encoder(FILE *out)
+      :m_file(out), m_good(true) {}
+
+    void record(char tag) {
+      uint32_t len = m_buffer.size();
+      if( m_good )
+	m_good = EOF!=fputc(tag, m_file) && 1==fwrite(&len, sizeof(len), 1, m_file) &&
+	  (m_buffer.empty() || 1==fwrite(m_buffer.data(), m_buffer.size(), 1, m_file));
+      m_buffer.clear();
+    }
+    /** @brief false once a record could not be written */
+    bool good() const {
+      return m_good;
+    }
+    void u8(unsigned char val) {
+      m_buffer.push_back(static_cast<char>(val));
+    }
+    void u32(unsigned int val) {
+      uint32_t tmp = val;
+      m_buffer.append(reinterpret_cast<char const *>(&tmp), sizeof(tmp));
+    }
+    void real(double val) {
+      m_buffer.append(reinterpret_cast<char const *>(&val), sizeof(val));
+    }
+    void label(std::string const &str) {
+      std::map<std::string, unsigned int>::const_iterator i = m_labels.find(str);
+      unsigned int id;
+
+      if( m_labels.end()!=i )
+	id = i->second;
+      else {
+	// Define it before the record being encoded
+	std::string pending;
+
+	id = m_labels.size();
+	m_labels.insert(std::make_pair(str, id));
+	pending.swap(m_buffer);
+	u32(id);
+	m_buffer.append(str);
+	record('L');
+	m_buffer.swap(pending);
+      }
+      u32(id);
+    }
+
+  private:
+    FILE *m_file;
+    bool m_good;
+    std::string m_buffer;
+    std::map<std::string, unsigned int> m_labels;
+  }; // ::Encoder
+
+  /** @brief Sequential decoding of a record payload */
+  class Decoder {
+  public:
+    Decoder(std::string const &buf, std::vector<std::string> const &labels)
+      :m_buf(buf), m_labels(labels), m_pos(0) {}
+
+    unsigned char u8() {
+      check(1);
+      return static_cast<unsigned char>(m_buf[m_pos++]);
+    }
+    unsigned int u32() {
+      uint32_t tmp;
+      get(&tmp, sizeof(tmp));
+      return tmp;
+    }
+    double real() {
+      double tmp;
+      get(&tmp, sizeof(tmp));
+      return tmp;
+    }
+    std::string const &label() {
+      unsigned int id = u32();
+      ConfigurationException::configurationCheckError(id<m_labels.size(),
+						      "Checkpoint : undefined label.");
+      return m_labels[id];
+    }
+    std::string rest() {
+      std::string ret = m_buf.substr(m_pos);
+      m_pos = m_buf.size();
+      return ret;
+    }
+
+  private:
+    void check(size_t len) const {
+      ConfigurationException::configurationCheckError(m_pos+len<=m_buf.size(),
+						      "Checkpoint : truncated record.");
+    }
+    void get(void *dest, size_t len) {
+      check(len);
+      memcpy(dest, m_buf.data()+m_pos, len);
+      m_pos += len;
+    }
+
+    std::string const &m_buf;
+    std::vector<std::string> const &m_labels;
+    size_t m_pos;
+  }; // ::Decoder
+
+  /** @brief Read the next record
+   *
+   * @param[out] truncated Set to true if the file ends within the record
+   *
+   * @retval false end of file
+   */
+  bool readRecord(FILE *in, char &tag, std::string &payload, bool &truncated) {
+    int c = fgetc(in);
+    uint32_t len;
+
+    truncated = false;
+    if( EOF==c )
+      return false;
+    truncated = 1!=fread(&len, sizeof(len), 1, in);
+    if( truncated )
+      return false;
+    tag = static_cast<char>(c);
+    payload.resize(len);
+    truncated = 0!=len && 1!=fread(&payload[0], len, 1, in);
+    return !truncated;
+  }
+
+  /** @brief Discard a partial checkpoint and report the error */
+  void writeFailed(FILE *out, std::string const &tmpName) {
+    int err = errno;
+
+    if( NULL!=out )
+      fclose(out);
+    remove(tmpName.c_str());
+    errno = err;
+    throw ErrnoExcept("Checkpoint::write(\""+tmpName+"\")");
+  }
+
+  void saveValue(AbstractDomain const &domain, double value, BinaryObservationLog::Value &val) {
+    if( domain.isEntity() ) {
+      val.kind = 'o';
+      val.symbol = domain_val_to_str(domain, value);
+    } else if( domain.getDataType()->isBool() ) {
+      val.kind = 'b';
+      val.number = value;
+    } else if( domain.getDataType()->isNumeric() ) {
+      val.kind = 'n';
+      val.number = value;
+    } else {
+      val.kind = 'y';
+      val.symbol = domain_val_to_str(domain, value);
+    }
+  }
+
+  void saveDomain(AbstractDomain const &domain, BinaryObservationLog::Domain &dom) {
+    dom.type = domain.getDataType()->getName().toString();
+    dom.values.clear();
+    if( domain.isSingleton() ) {
+      dom.kind = 'v';
+      dom.values.resize(1);
+      saveValue(domain, domain.getSingletonValue(), dom.values[0]);
+    } else if( domain.isEnumerated() ) {
+      std::list<double> values;
+
+      domain.getValues(values);
+      dom.kind = 's';
+      for(std::list<double>::const_iterator i=values.begin(); values.end()!=i; ++i) {
+	dom.values.push_back(BinaryObservationLog::Value());
+	saveValue(domain, *i, dom.values.back());
+      }
+    } else {
+      dom.kind = 'i';
+      dom.values.resize(2);
+      saveValue(domain, domain.getLowerBound(), dom.values[0]);
+      saveValue(domain, domain.getUpperBound(), dom.values[1]);
+    }
+  }
+
+  /** @brief Value of a saved value in this process
+   *
+   * Symbols and objects are saved by name as their value is only
+   * valid in the process which saved them.
+   *
+   * @retval false @e val is an object which does not exist in @e db
+   */
+  bool restoreValue(PlanDatabaseId const &db, BinaryObservationLog::Value const &val, double &value) {
+    if( 'b'==val.kind || 'n'==val.kind )
+      value = val.number;
+    else if( 'o'==val.kind ) {
+      ObjectId object = db->getObject(LabelStr(val.symbol));
+
+      if( object.isNoId() )
+	return false;
+      value = (double) object;
+    } else
+      value = static_cast<double>(LabelStr(val.symbol));
+    return true;
+  }
+
+  bool restoreDomain(PlanDatabaseId const &db, ConstrainedVariableId const &var, BinaryObservationLog::Domain const &dom) {
+    std::vector<double> values(dom.values.size());
+
+    for(size_t i=0; i<values.size(); ++i)
+      if( !restoreValue(db, dom.values[i], values[i]) )
+	return false;
+
+    AbstractDomain *domain = var->baseDomain().copy();
+    bool ret = true;
+
+    if( 'i'==dom.kind ) {
+      ret = (2==values.size());
+      if( ret )
+	domain->intersect(values[0], values[1]);
+    } else if( 'v'==dom.kind ) {
+      ret = (1==values.size());
+      if( ret ) {
+	if( domain->isOpen() && !domain->isMember(values[0]) )
+	  domain->insert(values[0]);
+	ret = domain->isMember(values[0]);
+	if( ret )
+	  domain->set(values[0]);
+      }
+    } else {
+      if( domain->isOpen() ) {
+	for(std::vector<double>::const_iterator i=values.begin(); values.end()!=i; ++i)
+	  domain->insert(*i);
+	domain->close();
+      }
+      std::list<double> current;
+      domain->getValues(current);
+      for(std::list<double>::const_iterator i=current.begin(); current.end()!=i; ++i)
+	if( values.end()==std::find(values.begin(), values.end(), *i) )
+	  domain->remove(*i);
+    }
+    ret = ret && !domain->isEmpty();
+    if( ret )
+      var->restrictBaseDomain(*domain);
+    delete domain;
+    return ret;
+  }
+
+} // <unnamed>
+
+/*
+ * class Checkpoint
+ */
+// Statics :
+
+char const *Checkpoint::magic() {
+  return "TREXCKP1";
+}
+
+void Checkpoint::save(TokenId const &token, char role, Token &rec) {
+  rec.role = role;
+  rec.key = token->getKey();
+  rec.timeline = Observation::getTimelineName(token).toString();
+  rec.predicate = token->getPredicateName().toString();
+
+  std::vector<ConstrainedVariableId> vars;
+  vars.push_back(token->start());
+  vars.push_back(token->end());
+  vars.push_back(token->duration());
+  vars.insert(vars.end(), token->parameters().begin(), token->parameters().end());
+
+  rec.variables.resize(vars.size());
+  for(size_t i=0; i<vars.size(); ++i) {
+    rec.variables[i].first = vars[i]->getName().toString();
+    saveDomain(vars[i]->lastDomain(), rec.variables[i].second);
+  }
+}
+
+bool Checkpoint::restore(TokenId const &token, Token const &rec) {
+  for(std::vector< std::pair<std::string, BinaryObservationLog::Domain> >::const_iterator i=rec.variables.begin();
+      rec.variables.end()!=i; ++i) {
+    ConstrainedVariableId var = token->getVariable(LabelStr(i->first));
+
+    if( var.isNoId() || !restoreDomain(token->getPlanDatabase(), var, i->second) ) {
+      debugMsg("Checkpoint", "Unable to restore "<<i->first<<" of "<<token->toString());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Structors :
+
+Checkpoint::Checkpoint()
+  :tick(0) {}
+
+Checkpoint::~Checkpoint() {}
+
+// Manipulators :
+
+void Checkpoint::read(std::string const &fileName) {
+  FILE *in = fopen(fileName.c_str(), "rb");
+  char buf[8];
+
+  ConfigurationException::configurationCheckError(NULL!=in, "Unable to open \""+fileName+'\"');
+  if( 1!=fread(buf, sizeof(buf), 1, in) || 0!=memcmp(buf, magic(), sizeof(buf)) ) {
+    fclose(in);
+    ConfigurationException::configurationCheckError(false, '\"'+fileName+"\" is not a checkpoint");
+  }
+
+  std::vector<std::string> labels;
+  std::string payload;
+  char tag;
+  bool truncated, complete = false;
+
+  reactors.clear();
+  while( !complete && readRecord(in, tag, payload, truncated) ) {
+    Decoder rec(payload, labels);
+
+    switch( tag ) {
+    case 'E':
+      complete = true;
+      break;
+    case 'L': {
+      unsigned int id = rec.u32();
+      if( labels.size()<=id )
+	labels.resize(id+1);
+      labels[id] = rec.rest();
+      break;
+    }
+    case 'T':
+      tick = rec.u32();
+      break;
+    case 'R':
+      reactors.push_back(Reactor());
+      reactors.back().name = rec.label();
+      break;
+    case 'V': {
+      ConfigurationException::configurationCheckError(!reactors.empty(), "Checkpoint : token outside of a reactor.");
+      reactors.back().tokens.push_back(Token());
+      Token &token = reactors.back().tokens.back();
+
+      token.role = rec.u8();
+      token.key = rec.u32();
+      token.timeline = rec.label();
+      token.predicate = rec.label();
+      token.variables.resize(rec.u32());
+      for(size_t i=0; i<token.variables.size(); ++i) {
+	BinaryObservationLog::Domain &dom = token.variables[i].second;
+
+	token.variables[i].first = rec.label();
+	dom.kind = rec.u8();
+	dom.type = rec.label();
+	dom.values.resize(rec.u32());
+	for(size_t j=0; j<dom.values.size(); ++j) {
+	  BinaryObservationLog::Value &val = dom.values[j];
+
+	  val.kind = rec.u8();
+	  if( 'b'==val.kind || 'n'==val.kind )
+	    val.number = rec.real();
+	  else
+	    val.symbol = rec.label();
+	}
+      }
+      break;
+    }
+    case 'O': {
+      ConfigurationException::configurationCheckError(!reactors.empty(), "Checkpoint : observation outside of a reactor.");
+      std::string const &timeline = rec.label();
+      reactors.back().lastObserved.push_back(std::make_pair(timeline, static_cast<TICK>(rec.u32())));
+      break;
+    }
+    default:
+      debugMsg("Checkpoint", "Skipping unknown record '"<<tag<<"'");
+    }
+  }
+  fclose(in);
+  // A file cut at a record boundary is only detected by the missing end record
+  ConfigurationException::configurationCheckError(complete && !truncated, '\"'+fileName+"\" is truncated");
+}
+
+// Observers :
+
+void Checkpoint::write(std::string const &fileName) const {
+  std::string tmpName = fileName+".tmp";
+  FILE *out = fopen(tmpName.c_str(), "wb");
+
+  if( NULL==out || 1!=fwrite(magic(), 8, 1, out) )
+    writeFailed(out, tmpName);
+
+  Encoder enc(out);
+
+  enc.u32(tick);
+  enc.record('T');
+  for(std::vector<Reactor>::const_iterator r=reactors.begin(); reactors.end()!=r; ++r) {
+    enc.label(r->name);
+    enc.record('R');
+    for(std::vector<Token>::const_iterator t=r->tokens.begin(); r->tokens.end()!=t; ++t) {
+      enc.u8(t->role);
+      enc.u32(t->key);
+      enc.label(t->timeline);
+      enc.label(t->predicate);
+      enc.u32(t->variables.size());
+      for(std::vector< std::pair<std::string, BinaryObservationLog::Domain> >::const_iterator v=t->variables.begin();
+	  t->variables.end()!=v; ++v) {
+	enc.label(v->first);
+	enc.u8(v->second.kind);
+	enc.label(v->second.type);
+	enc.u32(v->second.values.size());
+	for(std::vector<BinaryObservationLog::Value>::const_iterator i=v->second.values.begin();
+	    v->second.values.end()!=i; ++i) {
+	  enc.u8(i->kind);
+	  if( 'b'==i->kind || 'n'==i->kind )
+	    enc.real(i->number);
+	  else
+	    enc.label(i->symbol);
+	}
+      }
+      enc.record('V');
+    }
+    for(std::vector< std::pair<std::string, TICK> >::const_iterator o=r->lastObserved.begin();
+	r->lastObserved.end()!=o; ++o) {
+      enc.label(o->first);
+      enc.u32(o->second);
+      enc.record('O');
+    }
+  }
+  enc.record('E');
+
+  // The data must be on disk before the rename replaces the previous checkpoint
+  if( !enc.good() || 0!=fflush(out) || 0!=fsync(fileno(out)) )
+    writeFailed(out, tmpName);
+  if( 0!=fclose(out) )
+    writeFailed(NULL, tmpName);
+
+  if( 0!=rename(tmpName.c_str(), fileName.c_str()) )
+    writeFailed(NULL, tmpName);
+}
+
+Checkpoint::Reactor const *Checkpoint::find(std::string const &name) const {
+  for(std::vector<Reactor>::const_iterator i=reactors.begin(); reactors.end()!=i; ++i)
+    if( i->name==name )
+      return &(*i);
+  return NULL;
+}
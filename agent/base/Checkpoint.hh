@@ -0,0 +1,165 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "Checkpoint.hh"
+ * @brief Definition of the agent checkpoint
+ */
+#ifndef _CHECKPOINT_HH
+#define _CHECKPOINT_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string>
+#include <vector>
+
+#include "BinaryObservationLog.hh"
+#include "PlanDatabaseDefs.hh"
+
+namespace TREX {
+
+  /** @brief Agent checkpoint.
+   *
+   * A checkpoint holds the state the agent needs to resume at the
+   * tick following the one it was taken : for each DbCore reactor
+   * the current value of its timelines, its pending goals and the
+   * tick of the last observation of its external timelines. A plan
+   * database cannot be saved as is, so the plan itself is not part
+   * of it : the reactors deliberate again from the restored values.
+   *
+   * A checkpoint file uses the same framing as the binary
+   * observation log (see BinaryObservationLog) with the 8 bytes magic
+   * number "TREXCKP1" and the following records :
+   * @li @c L defines a label : 32 bits id followed by the text
+   * @li @c T the tick of the checkpoint : 32 bits tick value
+   * @li @c R starts the state of a reactor : 32 bits label of its name
+   * @li @c V a token (see Checkpoint::Token)
+   * @li @c O last observation of an external timeline : 32 bits
+   * label of the timeline and 32 bits tick
+   * @li @c E end of the checkpoint : empty, always the last record
+   */
+  class Checkpoint {
+  public:
+    /** @brief A saved token */
+    struct Token {
+      /** @brief Role of the token
+       *
+       * @c i current value of an internal timeline, @c e current
+       * value of an external timeline and @c g pending goal.
+       */
+      char role;
+      int key; //!< Key of the token when it was saved
+      std::string timeline;
+      std::string predicate;
+      /** @brief Domains of the variables by name
+       *
+       * This includes the timepoints and all the parameters but not
+       * the object variable, given by the timeline.
+       */
+      std::vector< std::pair<std::string, BinaryObservationLog::Domain> > variables;
+    };
+    /** @brief The saved state of a reactor */
+    struct Reactor {
+      std::string name;
+      std::vector<Token> tokens;
+      std::vector< std::pair<std::string, TICK> > lastObserved;
+    };
+
+    /** @brief Magic number at the start of a checkpoint */
+    static char const *magic();
+
+    /** @brief Save a token
+     *
+     * @param token A token
+     * @param role The role of the token
+     * @param[out] rec The saved token
+     */
+    static void save(TokenId const &token, char role, Token &rec);
+    /** @brief Restore the domains of a token
+     *
+     * @param token A new token of the same predicate as @e rec
+     * @param rec A saved token
+     *
+     * Restricts the base domains of the variables of @e token to the
+     * ones saved in @e rec. Object values are resolved by name.
+     *
+     * @retval true success
+     * @retval false a saved domain is not compatible with the base
+     * domain of the variable in @e token
+     */
+    static bool restore(TokenId const &token, Token const &rec);
+
+    // Structors :
+    Checkpoint();
+    ~Checkpoint();
+
+    // Manipulators :
+    /** @brief Load a checkpoint
+     *
+     * @param fileName The checkpoint file name
+     *
+     * @throw ConfigurationException unable to open @e fileName, it
+     * is not a valid checkpoint or it is truncated.
+     */
+    void read(std::string const &fileName);
+
+    // Observers :
+    /** @brief Save the checkpoint
+     *
+     * @param fileName The checkpoint file name
+     *
+     * The checkpoint is written in a temporary file first, synced
+     * and renamed as @e fileName once complete so a crash while
+     * writing does not destroy the previous checkpoint.
+     *
+     * @throw ErrnoExcept the checkpoint could not be written. The
+     * temporary file is removed and @e fileName is left as it was.
+     */
+    void write(std::string const &fileName) const;
+    /** @brief State of a reactor
+     *
+     * @param name A reactor name
+     *
+     * @return The saved state of @e name or NULL if it is not part of
+     * this checkpoint
+     */
+    Reactor const *find(std::string const &name) const;
+
+    TICK tick; //!< The tick this checkpoint was taken at
+    std::vector<Reactor> reactors;
+  }; // TREX::Checkpoint
+
+} // TREX
+
+#endif // _CHECKPOINT_HH
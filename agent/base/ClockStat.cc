@@ -0,0 +1,77 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ClockStat.cc"
+ */
+#include <sys/time.h>
+
+#include "ClockStat.hh"
+
+using namespace TREX;
+
+/*
+ * class ClockStat
+ */
+// Statics :
+
+long long ClockStat::now(ClockStat::source_type src) {
+#ifdef CLOCK_MONOTONIC
+  clockid_t id = CLOCK_MONOTONIC;
+  struct timespec date;
+
+  switch( src ) {
+# ifdef CLOCK_PROCESS_CPUTIME_ID
+  case process:
+    id = CLOCK_PROCESS_CPUTIME_ID;
+    break;
+# endif
+# ifdef CLOCK_THREAD_CPUTIME_ID
+  case thread:
+    id = CLOCK_THREAD_CPUTIME_ID;
+    break;
+# endif
+  default:
+    break;
+  }
+  if( 0==clock_gettime(id, &date) )
+    return date.tv_sec*1000000000ll+date.tv_nsec;
+#endif
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return now.tv_sec*1000000000ll+now.tv_usec*1000ll;
+}
@@ -0,0 +1,184 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ClockStat.hh"
+ *
+ * @brief Definition of ClockStat
+ */
+#ifndef _CLOCKSTAT_HH
+#define _CLOCKSTAT_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <time.h>
+
+#include "TimeUtils.hh"
+
+namespace TREX {
+
+  /** @brief Cumulated time measured with @c clock_gettime
+   *
+   * This class is a lightweight alternative to RStat when only a
+   * duration is needed. When provided by the system,
+   * @c clock_gettime does not enter the kernel and has a nanosecond
+   * resolution, which makes it well suited for timing small
+   * operations repeated many times per tick.
+   *
+   * @sa ClockStatLap
+   * @sa RStat
+   */
+  class ClockStat {
+  public:
+    /** @brief Clock source
+     *
+     * This type is used to specify what time a ClockStat measures.
+     */
+    enum source_type {
+      /** @brief Elapsed time.
+       *
+       * Monotonic clock not affected by the changes of the system
+       * date.
+       */
+      monotonic,
+      /** @brief CPU time of the process.
+       */
+      process,
+      /** @brief CPU time of the calling thread.
+       */
+      thread
+    }; // ClockStat::source_type
+
+    // Structors :
+    /** @brief Constructor
+     *
+     * @param src The clock source used by laps on this instance
+     *
+     * Create a new instance with a null cumulated time.
+     */
+    explicit ClockStat(source_type src=thread)
+      :m_source(src), m_nsecs(0) {
+      m_time.tv_sec = 0;
+      m_time.tv_usec = 0;
+    }
+    /** @brief Destructor */
+    ~ClockStat() {}
+
+    // Manipulators :
+    /** @brief Reset cumulated time to 0 */
+    void reset() {
+      m_nsecs = 0;
+      update();
+    }
+    /** @brief Add a duration
+     *
+     * @param nsecs A duration in nanoseconds
+     */
+    void add(long long nsecs) {
+      m_nsecs += nsecs;
+      update();
+    }
+
+    // Observers :
+    /** @brief Clock source */
+    source_type source() const {
+      return m_source;
+    }
+    /** @brief Cumulated time
+     *
+     * @return The cumulated time as a @c timeval. The reference
+     * stays valid for the life of this instance which allows to
+     * use it as a TickLogger field.
+     *
+     * @note The name is kept identical to RStat::user_time() in
+     * order to make both classes interchangeable.
+     */
+    timeval const &user_time() const {
+      return m_time;
+    }
+    /** @brief Cumulated time in nanoseconds */
+    long long nsecs() const {
+      return m_nsecs;
+    }
+
+    /** @brief Current time of a clock
+     *
+     * @param src A clock source
+     *
+     * @return The current value of the clock @e src in nanoseconds.
+     * On systems without @c clock_gettime all the sources fall
+     * back to @c gettimeofday.
+     */
+    static long long now(source_type src);
+
+  private:
+    void update() {
+      m_time.tv_sec = m_nsecs/1000000000ll;
+      m_time.tv_usec = (m_nsecs%1000000000ll)/1000;
+    }
+
+    source_type m_source;
+    long long m_nsecs;
+    timeval m_time;
+  }; // TREX::ClockStat
+
+  /** @brief Scoped ClockStat update
+   *
+   * This class has the same usage as RStatLap : the time elapsed
+   * between its construction and its destruction is added to a
+   * ClockStat.
+   *
+   * @code
+   * {
+   *   ClockStatLap chrono(m_searchUsage);
+   *   resume();
+   * }
+   * @endcode
+   */
+  class ClockStatLap {
+  public:
+    ClockStatLap(ClockStat &output)
+      :m_output(output), m_start(ClockStat::now(output.source())) {}
+    ~ClockStatLap() {
+      m_output.add(ClockStat::now(m_output.source())-m_start);
+    }
+
+  private:
+    ClockStat &m_output;
+    long long m_start;
+  }; // TREX::ClockStatLap
+
+} // TREX
+
+#endif // _CLOCKSTAT_HH
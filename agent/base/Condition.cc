@@ -0,0 +1,113 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "Condition.cc"
+ */
+#include <sys/time.h>
+
+#include "Condition.hh"
+
+using namespace TREX;
+
+/*
+ * class Condition
+ */
+// Structors :
+
+Condition::Condition() {
+  int ret;
+
+  ret = pthread_cond_init(&m_condId, NULL);
+  if( 0!=ret )
+    throw ErrnoExcept("Condition::Condition");
+}
+
+Condition::~Condition() {
+  int ret;
+
+  ret = pthread_cond_destroy(&m_condId);
+  if( 0!=ret )
+    throw ErrnoExcept("Condition::~Condition");
+}
+
+// Manipulators :
+
+void Condition::wait(Mutex &mtx) {
+  int ret;
+
+  ret = pthread_cond_wait(&m_condId, &(mtx.m_mutexId));
+  if( 0!=ret )
+    throw ErrnoExcept("Condition::wait");
+}
+
+bool Condition::timedWait(Mutex &mtx, double secs) {
+  struct timeval now;
+  struct timespec date;
+  long nsecs;
+  int ret;
+
+  gettimeofday(&now, NULL);
+  nsecs = now.tv_usec*1000l+static_cast<long>((secs-static_cast<long>(secs))*1e9);
+  date.tv_sec = now.tv_sec+static_cast<long>(secs)+nsecs/1000000000l;
+  date.tv_nsec = nsecs%1000000000l;
+
+  ret = pthread_cond_timedwait(&m_condId, &(mtx.m_mutexId), &date);
+  switch( ret ) {
+  case 0:
+    return true;
+  case ETIMEDOUT:
+    return false;
+  default:
+    throw ErrnoExcept("Condition::timedWait");
+  }
+}
+
+void Condition::signal() {
+  int ret;
+
+  ret = pthread_cond_signal(&m_condId);
+  if( 0!=ret )
+    throw ErrnoExcept("Condition::signal");
+}
+
+void Condition::broadcast() {
+  int ret;
+
+  ret = pthread_cond_broadcast(&m_condId);
+  if( 0!=ret )
+    throw ErrnoExcept("Condition::broadcast");
+}
@@ -0,0 +1,120 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "Condition.hh"
+ * @brief Definition of the Condition class
+ */
+#ifndef _CONDITION_HH
+#define _CONDITION_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "MutexWrapper.hh"
+
+namespace TREX {
+
+  /** @brief Condition variable.
+   *
+   * This class provides a simple wrapper to pthread condition
+   * variables. A Condition is always used in conjunction with a
+   * Mutex which has to be locked by the caller of wait() or timedWait().
+   */
+  class Condition {
+  public:
+    /** @brief Constructor.
+     *
+     * @throw ErrnoExcept error during condition creation.
+     */
+    Condition();
+    /** @brief Destructor.
+     *
+     * @throw ErrnoExcept error during condition destruction.
+     */
+    ~Condition();
+
+    /** @brief Wait for signal.
+     *
+     * @param mtx A mutex
+     *
+     * Atomically unlock @e mtx and wait for this condition to be
+     * signaled. @e mtx is locked again when this method returns.
+     *
+     * @pre @e mtx is locked by current thread
+     * @post @e mtx is locked by current thread
+     *
+     * @note As for any condition variable spurious wake ups may
+     * happen. The caller should always re-check its predicate.
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    void wait(Mutex &mtx);
+    /** @brief Wait for signal with timeout.
+     *
+     * @param mtx A mutex
+     * @param secs Maximum waiting time in seconds
+     *
+     * Identical to wait() except that it will return after
+     * @e secs seconds even if the condition was not signaled.
+     *
+     * @retval true the condition was signaled
+     * @retval false the timeout expired
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    bool timedWait(Mutex &mtx, double secs);
+
+    /** @brief Wake up one waiting thread
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    void signal();
+    /** @brief Wake up all the waiting threads
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    void broadcast();
+
+  private:
+    /** @brief condition id */
+    pthread_cond_t m_condId;
+
+    // Following functions are not implemented in purpose
+    Condition(Condition const &);
+    void operator= (Condition const &);
+  }; // TREX::Condition
+
+} // TREX
+
+#endif // _CONDITION_HH
@@ -50,6 +50,7 @@
 #include "Server.hh"
 #include "Token.hh"
 #include "TokenVariable.hh"
+#include "Constraint.hh"
 #include "Observer.hh"
 #include "DbClient.hh"
 #include "UnboundVariableDecisionPoint.hh"
@@ -61,29 +62,31 @@
 #include "Utilities.hh"
 #include "Filters.hh"
 #include "TestMonitor.hh"
+#include "TickTrace.hh"
+#include "BinaryObservationLog.hh"
 
 // For fileio
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 
+#include <cstring>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
 #include <stdexcept>
+#include <algorithm>
 
 namespace TREX {
 
   /* IMPLEMENTATION FOR DELIBERATION FILTER */
 
-  DeliberationFilter::DeliberationFilter(const TiXmlElement& configData): FlawFilter(configData, true) {}
+  DeliberationFilter::DeliberationFilter(const TiXmlElement& configData): FlawFilter(configData, true), m_verdictTick(0) {}
 
   /**
    * This method implements the horizon policy for deliberation.
    */
   bool DeliberationFilter::test(const EntityId& entity){
-    static unsigned int sl_counter(0);
-
     TokenId token;
 
     if(ConstrainedVariableId::convertable(entity)){
@@ -115,6 +118,49 @@ namespace TREX {
       m_core = DbCore::getInstance(token);
     }
 
+    // Verdicts are kept for the current tick only
+    TICK tick = (m_core.isId() ? m_core->getCurrentTick() : 0);
+    if(tick != m_verdictTick){
+      m_verdicts.clear();
+      m_verdictTick = tick;
+    }
+
+    // Reuse the verdict of the token while its temporal scope and the horizon are unchanged
+    const IntervalIntDomain& startTime = token->start()->lastDomain();
+    const IntervalIntDomain& endTime = token->end()->lastDomain();
+    const IntervalIntDomain& hor = horizon();
+    std::map<int, Verdict>::const_iterator it = m_verdicts.find(token->getKey());
+    if(it != m_verdicts.end() && it->second.matches(startTime, endTime, hor))
+      return it->second.excluded;
+
+    bool cacheable = true;
+    bool excluded = evaluate(entity, token, cacheable);
+    if(cacheable){
+      Verdict& verdict = m_verdicts[token->getKey()];
+      verdict.startLb = startTime.getLowerBound();
+      verdict.startUb = startTime.getUpperBound();
+      verdict.endLb = endTime.getLowerBound();
+      verdict.endUb = endTime.getUpperBound();
+      verdict.horizonLb = hor.getLowerBound();
+      verdict.horizonUb = hor.getUpperBound();
+      verdict.excluded = excluded;
+    }
+    else
+      m_verdicts.erase(token->getKey());
+
+    return excluded;
+  }
+
+  bool DeliberationFilter::Verdict::matches(const IntervalIntDomain& startTime, const IntervalIntDomain& endTime,
+					    const IntervalIntDomain& hor) const {
+    return startLb == startTime.getLowerBound() && startUb == startTime.getUpperBound() &&
+      endLb == endTime.getLowerBound() && endUb == endTime.getUpperBound() &&
+      horizonLb == hor.getLowerBound() && horizonUb == hor.getUpperBound();
+  }
+
+  bool DeliberationFilter::evaluate(const EntityId& entity, const TokenId& token, bool& cacheable){
+    static unsigned int sl_counter(0);
+
     TREX_INFO("trex:debug:planning", "[" << sl_counter++ << "] Evaluating " << tokenToString(token) << " with " << 
 	     token->start()->lastDomain().toString() << " AND " << 
 	     token->end()->lastDomain().toString());
@@ -166,9 +212,12 @@ namespace TREX {
     // It is inevitable if it necessarily starts within the mission window.
     inScope = inScope || startTime.getUpperBound() < Agent::instance()->getFinalTick();
 
-    // Finally, if it has a master that it could precede, since the master is already in the plan, the slave can be considered
-    if(!inScope && token->master().isId())
+    // Finally, if it has a master that it could precede, since the master is already in the plan, the slave can be considered.
+    // This also depends on the master, so it is not kept.
+    if(!inScope && token->master().isId()){
+      cacheable = false;
       inScope =  DbCore::isAction(token) || !token->getPlanDatabase()->getTemporalAdvisor()->canPrecede(token->master(), token);
+    }
 
     TREX_INFO("trex:debug:planning", (!inScope ? "Exclude " : "Allow ") <<
 		 entity->toString() << " with token scope " << token->start()->lastDomain().toString() <<
@@ -177,26 +226,19 @@ namespace TREX {
     return !inScope;
   }
 
-  TICK DeliberationFilter::currentTick(){
-    return (Agent::instance().isId() ? Agent::instance()->getCurrentTick() : 0);
-  }
-
-  void DeliberationFilter::update(TICK start, TICK end){
-    checkError(start >= Agent::instance()->getCurrentTick(), start << " < " << Agent::instance()->getCurrentTick());
-    checkError(end <= Agent::instance()->getFinalTick(), end << " > " << Agent::instance()->getCurrentTick());
-    horizon() = IntervalIntDomain((int) start, (int) end);
-  }
-
-  const IntervalIntDomain& DeliberationFilter::getHorizon(){
-    if(Agent::instance().isId())
-      return horizon();
+  const IntervalIntDomain& DeliberationFilter::getHorizon(const PlanDatabaseId& db){
+    DbCoreId core = DbCore::getInstance(db);
+    if(core.isId())
+      return core->getDeliberationHorizon();
     else
       return HorizonFilter::getHorizon();
   }
 
-  IntervalIntDomain& DeliberationFilter::horizon(){
-    static IntervalIntDomain sl_horizon(0, PLUS_INFINITY);
-    return sl_horizon;
+  const IntervalIntDomain& DeliberationFilter::horizon() const {
+    if(m_core.isId())
+      return m_core->getDeliberationHorizon();
+    else
+      return HorizonFilter::getHorizon();
   }
 
   std::ostream& DeliberationFilter::getStream(){
@@ -206,9 +248,6 @@ namespace TREX {
       return DebugMessage::getStream();
   }
 
-  // Allocate key collection
-  std::map<int, EntityId> DbCore::s_foreignKeyRelation;
-
   /**
    * @brief Little utility function for composing strings to make names
    */
@@ -218,6 +257,138 @@ namespace TREX {
     return sstr.str();
   }
 
+  ExecutionFrontier::ExecutionFrontier(): m_valid(false) {}
+
+  std::list<TokenId>::const_iterator ExecutionFrontier::begin(const std::list<TokenId>& tokenSequence) const {
+    if(!m_valid)
+      return tokenSequence.begin();
+
+    return m_position;
+  }
+
+  void ExecutionFrontier::moveTo(const std::list<TokenId>::const_iterator& position, const std::list<TokenId>& tokenSequence){
+    m_position = position;
+    m_token = (position == tokenSequence.end() ? TokenId::noId() : *position);
+    m_valid = true;
+  }
+
+  void ExecutionFrontier::reset(){
+    m_valid = false;
+    m_token = TokenId::noId();
+  }
+
+  /**
+   * A token inserted before the frontier must end before the frontier token starts. Since bounds only tighten, its earliest start
+   * is then no later than the current latest start of the frontier token. Anything else can only be inserted after the frontier.
+   * When the frontier is at the end of the sequence any insertion is a candidate.
+   */
+  void ExecutionFrontier::handleConstrained(const TokenId& predecessor, const TokenId& successor){
+    if(!m_valid)
+      return;
+
+    if(m_token.isNoId() || successor == m_token || precedes(predecessor) || precedes(successor))
+      reset();
+  }
+
+  void ExecutionFrontier::handleRemoval(const TokenId& token){
+    if(m_valid && token == m_token)
+      reset();
+  }
+
+  bool ExecutionFrontier::precedes(const TokenId& token) const {
+    return token.isId() && token != m_token && !token->isCommitted() &&
+      token->start()->lastDomain().getLowerBound() <= m_token->start()->lastDomain().getUpperBound();
+  }
+
+  ForeignKeyTable::ForeignKeyTable(): m_generation(0), m_sweepKey(0) {}
+
+  bool ForeignKeyTable::contains(const EntityId& foreign){
+    EntryMap::iterator it = m_byForeign.find(foreign->getKey());
+    return it != m_byForeign.end() && validate(it);
+  }
+
+  void ForeignKeyTable::insert(const EntityId& foreign, const EntityId& local){
+    EntryMap::iterator it = m_byForeign.find(foreign->getKey());
+    if(it != m_byForeign.end() && validate(it))
+      return;
+
+    Entry entry;
+    entry.local = local;
+    entry.localKey = local->getKey();
+    entry.generation = m_generation;
+    m_byForeign.insert(std::make_pair(foreign->getKey(), entry));
+    m_byLocal[entry.localKey] = foreign->getKey();
+  }
+
+  void ForeignKeyTable::erase(const EntityId& foreign){
+    EntryMap::iterator it = m_byForeign.find(foreign->getKey());
+    if(it != m_byForeign.end())
+      eraseEntry(it);
+  }
+
+  EntityId ForeignKeyTable::getLocal(const EntityId& foreign){
+    EntryMap::iterator it = m_byForeign.find(foreign->getKey());
+    if(it == m_byForeign.end() || !validate(it))
+      return EntityId::noId();
+
+    checkError(it->second.local.isValid(), it->second.local << " is a stale id for " << foreign->toString());
+    return it->second.local;
+  }
+
+  EntityId ForeignKeyTable::getForeign(const EntityId& local){
+    std::map<int, int>::const_iterator l_it = m_byLocal.find(local->getKey());
+    if(l_it == m_byLocal.end())
+      return EntityId::noId();
+
+    EntryMap::iterator it = m_byForeign.find(l_it->second);
+    if(it == m_byForeign.end() || !validate(it))
+      return EntityId::noId();
+
+    return Entity::getEntity(it->first);
+  }
+
+  void ForeignKeyTable::expire(){
+    static const unsigned int SWEEP_SIZE(32);
+
+    ++m_generation;
+
+    // Resume the sweep where the last one stopped, wrapping around at the end of the table
+    EntryMap::iterator it = m_byForeign.lower_bound(m_sweepKey);
+    for(unsigned int i = 0; i < SWEEP_SIZE && !m_byForeign.empty(); ++i){
+      if(it == m_byForeign.end())
+	it = m_byForeign.begin();
+
+      EntryMap::iterator current = it++;
+      validate(current);
+    }
+    m_sweepKey = (it == m_byForeign.end() ? 0 : it->first);
+  }
+
+  bool ForeignKeyTable::validate(EntryMap::iterator& it){
+    Entry& entry = it->second;
+    if(entry.generation == m_generation)
+      return true;
+
+    // Look up by key only: the ids of stale entries may no longer be valid
+    EntityId local = Entity::getEntity(entry.localKey);
+    if(local.isNoId() || local->isDiscarded() || Entity::getEntity(it->first).isNoId()){
+      eraseEntry(it);
+      return false;
+    }
+
+    entry.generation = m_generation;
+    return true;
+  }
+
+  void ForeignKeyTable::eraseEntry(EntryMap::iterator it){
+    // Objects are shared by the goals of all the clients so the local key may now be bound to another foreign key
+    std::map<int, int>::iterator l_it = m_byLocal.find(it->second.localKey);
+    if(l_it != m_byLocal.end() && l_it->second == it->first)
+      m_byLocal.erase(l_it);
+
+    m_byForeign.erase(it);
+  }
+
   TimelineContainer::TimelineContainer(const TimelineId& timeline)
     : m_timeline(timeline), m_lastObserved(0) {}
 
@@ -237,28 +408,30 @@ namespace TREX {
   void TimelineContainer::setServer(const ServerId& server){ m_server = server;}
 
   bool TimelineContainer::isDispatched(const TokenId& token){
-    for(TokenSet::const_iterator it = m_dispatchedTokens.begin(); it != m_dispatchedTokens.end(); ++it){
-      TokenId t = *it;
-      checkError(t.isValid(), t << " is a bad id in " << m_timeline->getName().toString());
-    }
-
-    return m_dispatchedTokens.find(token) != m_dispatchedTokens.end();
+    return m_dispatchedTokens.find(token->getKey()) != m_dispatchedTokens.end();
   }
 
-  const TokenSet& TimelineContainer::getDispatchedTokens() const {
+  const TimelineContainer::DispatchedTokens& TimelineContainer::getDispatchedTokens() const {
     return m_dispatchedTokens;
   }
 
   void TimelineContainer::markDispatched(const TokenId& token){    
-    m_dispatchedTokens.insert(token);
+    m_dispatchedTokens.insert(std::make_pair(token->getKey(), token));
   }
 
   void TimelineContainer::clearDispatched(const TokenId& token){
-    m_dispatchedTokens.erase(token);
+    m_dispatchedTokens.erase(token->getKey());
+    // The token is no longer settled
+    m_frontier.reset();
   }
 
   void TimelineContainer::handleRemoval(const TokenId& token){
-    m_dispatchedTokens.erase(token);
+    m_dispatchedTokens.erase(token->getKey());
+    m_frontier.handleRemoval(token);
+  }
+
+  ExecutionFrontier& TimelineContainer::getFrontier() {
+    return m_frontier;
   }
 
   DbCore::DbListener::DbListener(DbCore& dbCore)
@@ -278,10 +451,25 @@ namespace TREX {
 
   void DbCore::DbListener::notifyCommitted(const TokenId& token){ m_dbCore.handleCommitted(token); } 
 
+  void DbCore::DbListener::notifyConstrained(const ObjectId& object, const TokenId& predecessor, const TokenId& successor){
+    m_dbCore.handleConstrained(object, predecessor, successor);
+  }
+
+  void DbCore::DbListener::notifyFreed(const ObjectId& object, const TokenId& predecessor, const TokenId& successor){
+    m_dbCore.handleFreed(object, predecessor, successor);
+  }
+
   void DbCore::DbListener::notifyRejected(const TokenId& token){ m_dbCore.handleRejected(token); }
 
   void DbCore::DbListener::notifyTerminated(const TokenId& token){ m_dbCore.handleTerminated(token); } 
 
+  DbCore::CeListener::CeListener(DbCore& dbCore)
+    : ConstraintEngineListener(dbCore.m_db->getConstraintEngine()), m_dbCore(dbCore){}
+
+  void DbCore::CeListener::notifyChanged(const ConstrainedVariableId& variable, const DomainListener::ChangeType& changeType){
+    m_dbCore.handleChanged(variable);
+  }
+
   ConstrainedVariableId DbCore::getAgentClockVariable(const PlanDatabaseId db){
     static const LabelStr VAR_AGENT_CLOCK("AGENT_CLOCK");
     ConstrainedVariableId result = db->getGlobalVariable(VAR_AGENT_CLOCK);
@@ -301,14 +489,54 @@ namespace TREX {
       m_solverCfg(findFile(extractData(configData, "solverConfig").toString())),
       m_statePath(LogManager::instance().reactor_dir_path(agentName.toString(),getName().toString(),"reactor_states").c_str()),
       m_conflictPath(LogManager::instance().reactor_dir_path(agentName.toString(),getName().toString(),"conflicts").c_str()),
+      m_stateKeyframe(configData.Attribute("stateKeyframe") == NULL ? 0 : atoi(configData.Attribute("stateKeyframe"))),
+      m_stateDumps(0),
       m_planLog(LogManager::instance().reactor_file_path(agentName.toString(),getName().toString(),"plan.log").c_str()),
-      m_lastRecalled(0)
+      m_lastRecalled(0),
+      m_validationPeriod(configData.Attribute("validationPeriod") == NULL ? 0 : atoi(configData.Attribute("validationPeriod"))),
+      m_nextFullValidation(0),
+      m_archiveBatch(configData.Attribute("archiveBatch") == NULL ? 0 : atoi(configData.Attribute("archiveBatch"))),
+      m_gcThreshold(configData.Attribute("gcThreshold") == NULL ? 0 : atoi(configData.Attribute("gcThreshold"))),
+      m_tokenBudget(configData.Attribute("tokenBudget") == NULL ? 0 : atoi(configData.Attribute("tokenBudget"))),
+      m_entityBudget(configData.Attribute("entityBudget") == NULL ? 0 : atoi(configData.Attribute("entityBudget"))),
+      m_history(NULL),
+      m_historyWindow(configData.Attribute("historyWindow") == NULL ? 0 : atoi(configData.Attribute("historyWindow"))),
+      m_lastSpill(0),
+      m_historyTick(-1),
+      m_spilledTokens(0),
+      m_planReuse(configData.Attribute("planReuse") != NULL && strcmp(configData.Attribute("planReuse"), "true") == 0),
+      m_resumeBudget(configData.Attribute("resumeBudget") == NULL ? 0.5 : atof(configData.Attribute("resumeBudget"))),
+      m_planCache(configData.Attribute("planCache") != NULL && strcmp(configData.Attribute("planCache"), "true") == 0),
+      m_planChanges(0),
+      m_plannedChanges(0),
+      m_plannedHorizonEnd(0),
+      m_cachedCycles(0),
+      m_hintPending(false),
+      m_horizon(0, PLUS_INFINITY),
+      m_analyst(NULL),
+      m_planVersion(0),
+      m_removalFloor(1),
+      m_ceListener(NULL),
+      m_planDeltas(NULL),
+      m_writtenVersion(0)
   {
 
     DebugMessage::setStream(getStream());
 
     instancesByDb().insert(std::pair<PlanDatabaseId, DbCoreId>(m_db, getId()));
 
+    // The history is a binary observation log, so SimAdapter and the log tools can read it
+    if(configData.Attribute("historyWindow") != NULL){
+      std::string path = LogManager::instance().reactor_file_path(agentName.toString(), getName().toString(), "plan.history");
+      FILE* file = fopen(path.c_str(), "wb");
+      ConfigurationException::configurationCheckError(file != NULL, "Unable to open " + path);
+      m_history = new BinaryObservationWriter(file);
+    }
+
+    // Plan deltas are pushed to a file that clients can follow
+    if(configData.Attribute("planDeltas") != NULL && strcmp(configData.Attribute("planDeltas"), "true") == 0)
+      m_planDeltas = new std::ofstream(LogManager::instance().reactor_file_path(agentName.toString(), getName().toString(), "plan.deltas").c_str());
+
     const LabelStr  configFile(findFile(compose(getAgentName(), compose(getName(), "nddl")).toString()));
 
     LogManager::use(configFile.toString());
@@ -329,9 +557,9 @@ namespace TREX {
     tickDurationVar->restrictBaseDomain(IntervalDomain(tick_duration, tick_duration));
 
     // Load the solver configuration file
-    TiXmlElement* solverCfg = LogManager::initXml( m_solverCfg.c_str() );
-    m_solver = new DbSolver(m_db, solverCfg);
-    delete solverCfg;
+    const TiXmlElement& solverCfg = LogManager::acquireXml( m_solverCfg.toString() );
+    m_solver = new DbSolver(m_db, const_cast<TiXmlElement*>(&solverCfg));
+    LogManager::releaseXml( m_solverCfg.toString() );
     checkError(m_solver.isValid(), m_solver);
 
     // Finally, get all inactive tokens loaded in the initial state and store them in the initial goal set. If there are any goals
@@ -373,6 +601,16 @@ namespace TREX {
      checkError(m_solver.isValid(), m_solver);
      m_solver.release();
 
+     // Writes the tick index of the history
+     delete m_history;
+
+     // Writes the conflict files still queued
+     delete m_analyst;
+
+     // The listener must go before the constraint engine
+     delete m_ceListener;
+     delete m_planDeltas;
+
      // Purge goals, ensuring messages are sent for all goals abut their final status if appropriate
 
      for(TokenSet::iterator it = m_goals.begin(); it != m_goals.end(); ++it){
@@ -392,51 +630,111 @@ namespace TREX {
        }
      }
 
-     instancesByDb().clear();
-
-     s_foreignKeyRelation.clear();
+     // Only this core's entry goes, the other cores of the agent may still be alive
+     instancesByDb().erase(m_db);
   }
 
   void DbCore::notify(const Observation& observation){
-    TREX_INFO("trex:info:trace", nameString() << observation.toString());
+    std::vector<const Observation*> observations(1, &observation);
+    notifyBatch(observations);
+  }
 
+  void DbCore::notifyBatch(const std::vector<const Observation*>& observations){
     // Get the client to work with
     DbClientId client = m_db->getClient();
 
-    // Allocate a token - it should be inactive but not rejectable - cannot deny the truth
-    TokenId token = client->createToken(observation.getPredicate().c_str(), NULL, NOT_REJECTABLE);
-
-    // Bind the object variable
-    ObjectId timeline = client->getObject(observation.getObjectName().c_str());
-    const ConstrainedVariableId& objectVar = token->getObject();
-    objectVar->specify(timeline);
-    objectVar->restrictBaseDomain(objectVar->lastDomain());
+    // Allocate all the tokens - they should be inactive but not rejectable - cannot deny the truth. An observation which only
+    // confirms the current value extends it instead, and has no token.
+    std::vector<TokenId> tokens;
+    tokens.reserve(observations.size());
+    for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it){
+      TREX_INFO("trex:info:trace", nameString() << (*it)->toString());
+      if(confirmCurrentValue(**it))
+	tokens.push_back(TokenId::noId());
+      else
+	tokens.push_back(client->createToken((*it)->getPredicate().c_str(), NULL, NOT_REJECTABLE));
+    }
 
     // A notification of a value should have the semantics of stating a fact is true at a given time. This means the latest start is
     // the current tick, and the earliest end is the current tick. Notably, it does not constrain the earliest time it could
     // become true.
-    token->start()->restrictBaseDomain(IntervalIntDomain(getCurrentTick(), getCurrentTick()));
-    token->end()->restrictBaseDomain(IntervalIntDomain(getCurrentTick()+1, PLUS_INFINITY));
+    const IntervalIntDomain startDom(getCurrentTick(), getCurrentTick());
+    const IntervalIntDomain endDom(getCurrentTick()+1, PLUS_INFINITY);
+
+    for(unsigned int o = 0; o < observations.size(); o++){
+      const Observation& observation = *(observations[o]);
+      const TokenId& token = tokens[o];
+      if(token.isNoId())
+	continue;
+
+      // Bind the object variable
+      ObjectId timeline = client->getObject(observation.getObjectName().c_str());
+      const ConstrainedVariableId& objectVar = token->getObject();
+      objectVar->specify(timeline);
+      objectVar->restrictBaseDomain(objectVar->lastDomain());
+
+      token->start()->restrictBaseDomain(startDom);
+      token->end()->restrictBaseDomain(endDom);
+
+      // Restrict the base domains for each parameter specifed.
+      // TO DO: Make sure this is type safe
+      for(unsigned int i = 0; i < observation.countParameters(); i++){
+	const std::pair<LabelStr, const AbstractDomain*>& nameValuePair = observation[i];
+	const LabelStr& varName = nameValuePair.first;
+	const AbstractDomain& varDom = *(nameValuePair.second);
+	const ConstrainedVariableId& param = token->getVariable(varName);
+	checkError(param.isValid(), tokenToString(token) << " has no variable named " << varName.toString() << ". " << token->toLongString());
+	TREX_INFO("trex:info:trace", nameString() << "Restricting " << param->toString() << " to " << varDom.toString());
+	restrict(param, varDom);
+      }
+
+      // Store the token in the observation list
+      FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.find(timeline->getKey());
+      checkError(it != m_externalTimelineTable.end(), "Failed to find and entry for " << observation.getObjectName().toString());
+      it->second.updateLastObserved(getCurrentTick());
+
+      // Buffer the observation for identification purposes later
+      bufferObservation(token);
+    }
+  }
+
+  /**
+   * The observation confirms the current value if that value is an observation of the same predicate which can be extended,
+   * and all the parameters of the observation are singletons equal to the values of the current one. Object parameters are
+   * left to the general case since they have to be converted. Only one observation per timeline can confirm a value on a tick.
+   */
+  bool DbCore::confirmCurrentValue(const Observation& observation){
+    TICK tick = getCurrentTick();
+    if(m_state == DbCore::INVALID || tick == 0)
+      return false;
+
+    ObjectId object = m_db->getObject(observation.getObjectName());
+    if(object.isNoId())
+      return false;
+
+    FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.find(object->getKey());
+    if(it == m_externalTimelineTable.end() || it->second.lastObserved() == tick)
+      return false;
+
+    TokenId token = getValue(it->second.getTimeline(), tick - 1);
+    if(token.isNoId() || !isObservation(token) || token->getPredicateName() != observation.getPredicate() ||
+       token->end()->lastDomain().getUpperBound() <= tick || token->parameters().size() != observation.countParameters())
+      return false;
 
-    // Restrict the base domains for each parameter specifed.
-    // TO DO: Make sure this is type safe
     for(unsigned int i = 0; i < observation.countParameters(); i++){
       const std::pair<LabelStr, const AbstractDomain*>& nameValuePair = observation[i];
-      const LabelStr& varName = nameValuePair.first;
       const AbstractDomain& varDom = *(nameValuePair.second);
-      const ConstrainedVariableId& param = token->getVariable(varName);
-      checkError(param.isValid(), tokenToString(token) << " has no variable named " << varName.toString() << ". " << token->toLongString());
-      TREX_INFO("trex:info:trace", nameString() << "Restricting " << param->toString() << " to " << varDom.toString());
-      restrict(param, varDom);
+      const ConstrainedVariableId& param = token->getVariable(nameValuePair.first);
+      if(param.isNoId() || ObjectVarId::convertable(param) || !varDom.isSingleton() ||
+	 !param->lastDomain().isSingleton() || param->lastDomain().getSingletonValue() != varDom.getSingletonValue())
+	return false;
     }
 
-    // Store the token in the observation list
-    std::map< int, TimelineContainer  >::iterator it = m_externalTimelineTable.find(timeline->getKey());
-    checkError(it != m_externalTimelineTable.end(), "Failed to find and entry for " << observation.getObjectName().toString());
-    it->second.updateLastObserved(getCurrentTick());
+    TREX_INFO("DbCore:confirmCurrentValue", nameString() << observation.toString() << " extends " << tokenToString(token));
 
-    // Buffer the observation for identification purposes later
-    bufferObservation(token);
+    restrictExtension(token);
+    it->second.updateLastObserved(tick);
+    return true;
   }
 
   /**
@@ -502,7 +800,12 @@ namespace TREX {
     if(!propagate()){
       TREX_INFO("trex:warning:handleRequest", "Goal " << localGoal->toLongString() << " causes inconsistency immediately and will be removed.");
       terminate(localGoal);
-      // Clean terminated tokens
+      // Clean terminated tokens, once the history has them
+      if(m_history != NULL){
+	TokenSet terminated(m_terminatedTokens);
+	terminated.erase(localGoal);
+	writeHistory(terminated);
+      }
       Entity::discardAll(m_terminatedTokens);
       purgeOrphanedKeys();
       Entity::garbageCollect();
@@ -525,7 +828,18 @@ namespace TREX {
     TREX_INFO("DbCore:handleRecall", nameString() << "Recall received: " << tok->toString());
 
     markInvalid("Recall received. Will reset internal timelines.");
+    bufferRecall(tok);
+  }
+
+  void DbCore::handleRecall(const std::vector<TokenId>& goals){
+    TREX_INFO("DbCore:handleRecall", nameString() << goals.size() << " recalls received");
+
+    markInvalid("Recalls received. Will reset internal timelines.");
+    for(std::vector<TokenId>::const_iterator it = goals.begin(); it != goals.end(); ++it)
+      bufferRecall(*it);
+  }
 
+  void DbCore::bufferRecall(const TokenId& tok){
     // If we do not have the token locally, it has already been removed
     if(!hasEntity(tok))
       return;
@@ -533,7 +847,7 @@ namespace TREX {
     // Get the corresponding goal token and buffer it for removal on the next go.
     TokenId localGoal = getLocalEntity(tok);
     checkError(localGoal.isValid(), localGoal);
-    m_recallBuffer.push_back(localGoal->getKey());
+    m_recalledGoals.insert(localGoal);
 
     // Remove foreign keys for goal and its variables
     removeEntity(tok);
@@ -643,7 +957,7 @@ namespace TREX {
     checkError(initialTick >= getCurrentTick(), "Assume for now that this is the case. It impacts the test for dispatching initial conditions.");
 
     // Iterate over the external timelines. For each entry, update the server id from the map
-    for(std::map<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin();it != m_externalTimelineTable.end();++it){
+    for(FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin();it != m_externalTimelineTable.end();++it){
       TimelineContainer& tc = it->second;
       TimelineId timeline = tc.getTimeline();
       std::map<double, ServerId>::const_iterator c_it = serversByTimeline.find(timeline->getName());
@@ -691,6 +1005,7 @@ namespace TREX {
       else if(mode->getSpecifiedValue() == Agent::INTERNAL_TIMELINE()){
 	m_internalLabels.push_back(object_name);
 	m_internalTimelineTable.push_back( std::pair<TimelineId, TICK>(object, (TICK) PLUS_INFINITY));
+	m_internalFrontiers.insert(std::pair<int, ExecutionFrontier>(object->getKey(), ExecutionFrontier()));
 	m_timelines.push_back(object);
       }
     }
@@ -763,9 +1078,9 @@ namespace TREX {
     }
 
     // Externals
-    std::map<int, TimelineContainer>::const_iterator 
+    FlatMap<int, TimelineContainer>::const_iterator 
       cextit = m_externalTimelineTable.begin();
-    std::map<int, TimelineContainer>::const_iterator const
+    FlatMap<int, TimelineContainer>::const_iterator const
       endcext = m_externalTimelineTable.end();
 
     for( ; endcext!=cextit; ++cextit ) {
@@ -775,13 +1090,157 @@ namespace TREX {
     }
   }
 
-  void DbCore::writeTimeline(const TimelineId tl, const char mode, std::ofstream &db_out) const {
-    // Write out the timeline description
-    db_out
-      << tl->getKey()			    // Key
-      << "\t" << tl->getName().toString()   // Name
-      << "\t" << mode			    // Mode designator [I,E,A]
-      << std::endl;
+  void DbCore::PlanDelta::write(std::ostream& out) const {
+    out << m_tick << "\t" << m_reactorName.toString() << "\t" << m_version << "\t" << (m_full ? 'F' : 'D') << std::endl;
+
+    for(std::vector<TokenUpdate>::const_iterator it = m_updates.begin(); it != m_updates.end(); ++it)
+      out << it->timeline.toString()
+	  << "\t" << it->token.key
+	  << "\t" << it->token.name.toString()
+	  << "\t" << it->token.start[0]
+	  << "\t" << it->token.start[1]
+	  << "\t" << it->token.end[0]
+	  << "\t" << it->token.end[1]
+	  << std::endl;
+
+    for(std::vector<int>::const_iterator it = m_removed.begin(); it != m_removed.end(); ++it)
+      out << "-\t" << *it << std::endl;
+  }
+
+  void DbCore::getPlanDelta(unsigned int version, PlanDelta& delta){
+    publishPlan();
+
+    delta.clear();
+    delta.m_tick = getCurrentTick();
+    delta.m_reactorName = getName();
+    delta.m_version = m_planVersion;
+    delta.m_full = version < m_removalFloor;
+
+    for(FlatMap<int, PublishedToken>::const_iterator it = m_publishedTokens.begin(); it != m_publishedTokens.end(); ++it){
+      if(delta.m_full || it->second.version > version){
+	PlanDelta::TokenUpdate update;
+	update.timeline = it->second.timeline;
+	update.token = it->second.token;
+	delta.m_updates.push_back(update);
+      }
+    }
+
+    if(!delta.m_full){
+      // Removals are in version order, so only the newest ones are visited
+      std::deque< std::pair<unsigned int, int> >::const_iterator it = m_publishedRemovals.end();
+      while(it != m_publishedRemovals.begin() && (it - 1)->first > version)
+	--it;
+      for(; it != m_publishedRemovals.end(); ++it)
+	delta.m_removed.push_back(it->second);
+    }
+  }
+
+  void DbCore::publishPlan(){
+    unsigned int version = m_planVersion + 1;
+    bool changed = false;
+
+    if(m_ceListener == NULL){
+      // From now on, the database events mark the tokens to visit
+      m_ceListener = new CeListener(*this);
+      const TokenSet& tokens = m_db->getTokens();
+      for(TokenSet::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+	publishToken((*it)->getKey(), version, changed);
+    }
+    else {
+      for(std::set<int>::const_iterator it = m_dirtyTokens.begin(); it != m_dirtyTokens.end(); ++it)
+	publishToken(*it, version, changed);
+    }
+    m_dirtyTokens.clear();
+
+    while(m_publishedRemovals.size() > MAX_PUBLISHED_REMOVALS){
+      m_removalFloor = m_publishedRemovals.front().first;
+      m_publishedRemovals.pop_front();
+    }
+
+    if(changed)
+      m_planVersion = version;
+  }
+
+  void DbCore::publishToken(int key, unsigned int version, bool& changed){
+    // Deleted tokens are no longer entities. Merged, deactivated and unassigned tokens are not reported either
+    EntityId entity = Entity::getEntity(key);
+    if(entity.isId() && TokenId::convertable(entity)){
+      TokenId tok = entity;
+      if(tok->isActive() && tok->getObject()->lastDomain().isSingleton()){
+	ObjectId object = tok->getObject()->lastDomain().getSingletonValue();
+	bool published = m_externalTimelineTable.find(object->getKey()) != m_externalTimelineTable.end();
+	for(std::vector< std::pair<TimelineId, TICK> >::const_iterator it = m_internalTimelineTable.begin();
+	    !published && it != m_internalTimelineTable.end(); ++it)
+	  published = (it->first->getKey() == object->getKey());
+
+	if(published){
+	  publishToken(tok, (TimelineId) object, version, changed);
+	  return;
+	}
+      }
+    }
+
+    if(m_publishedTokens.erase(key) > 0){
+      m_publishedRemovals.push_back(std::make_pair(version, key));
+      changed = true;
+    }
+  }
+
+  void DbCore::publishToken(const TokenId& tok, const TimelineId& tl, unsigned int version, bool& changed){
+    PublishedToken published;
+    published.timeline = tl->getName();
+    published.token.key = tok->getKey();
+    published.token.name = tok->getPredicateName();
+    published.token.start[0] = tok->start()->getLowerBound();
+    published.token.start[1] = tok->start()->getUpperBound();
+    published.token.end[0] = tok->end()->getLowerBound();
+    published.token.end[1] = tok->end()->getUpperBound();
+    published.version = version;
+
+    std::pair<FlatMap<int, PublishedToken>::iterator, bool> entry = m_publishedTokens.insert(std::make_pair(tok->getKey(), published));
+    if(entry.second){
+      changed = true;
+      return;
+    }
+
+    // Events also mark tokens whose bounds end up unchanged, as after a relaxation and a new propagation
+    PublishedToken& previous = entry.first->second;
+    if(previous.timeline != published.timeline || previous.token.name != published.token.name ||
+       previous.token.start[0] != published.token.start[0] || previous.token.start[1] != published.token.start[1] ||
+       previous.token.end[0] != published.token.end[0] || previous.token.end[1] != published.token.end[1]){
+      previous = published;
+      changed = true;
+    }
+  }
+
+  void DbCore::writePlanDelta(){
+    if(m_planDeltas == NULL)
+      return;
+
+    PlanDelta delta;
+    getPlanDelta(m_writtenVersion, delta);
+    if(delta.m_version == m_writtenVersion && !delta.m_full)
+      return;
+
+    delta.write(*m_planDeltas);
+    m_planDeltas->flush();
+    m_writtenVersion = delta.m_version;
+  }
+
+  void DbCore::handleChanged(const ConstrainedVariableId& variable){
+    if(!variable->parent().isId() || !TokenId::convertable(variable->parent()))
+      return;
+
+    // Only the published variables matter
+    TokenId tok = variable->parent();
+    int key = variable->getKey();
+    if(key == tok->start()->getKey() || key == tok->end()->getKey() || key == tok->getObject()->getKey())
+      m_dirtyTokens.insert(tok->getKey());
+  }
+
+  void DbCore::writeTimeline(const TimelineId tl, const char mode, std::ostream &db_out,
+			     std::map<int, std::string> &rows, bool delta) const {
+    std::ostringstream tok_out;
 
     // Iterate over tokens
     std::list<TokenId> const &tokens = tl->getTokenSequence();
@@ -795,8 +1254,9 @@ namespace TREX {
 
       TempVarId tokStart = tok->start(),
 		tokEnd = tok->end();
+      std::ostringstream row;
 
-      db_out 
+      row
 	<< "\t" << tok->getKey()		      // Token key
 	<< "\t" << tok->getPredicateName().toString() // Token name
 	<< "\t" << tokStart->getLowerBound()	      // Start lower
@@ -804,45 +1264,86 @@ namespace TREX {
 	<< "\t" << tokEnd->getLowerBound()	      // End lower
 	<< "\t" << tokEnd->getUpperBound()	      // End upper
 	<< std::endl;
+
+      std::string const &text = (rows[tok->getKey()] = row.str());
+      if(delta) {
+	// Skip the tokens which did not change since the previous dump
+	std::map<int, std::string>::const_iterator prev = m_dumpedRows.find(tok->getKey());
+	if(m_dumpedRows.end()!=prev && prev->second==text)
+	  continue;
+      }
+      tok_out << text;
     }
+
+    // A delta only mentions the timelines which changed
+    if(delta && tok_out.str().empty())
+      return;
+
+    // Write out the timeline description
+    db_out
+      << tl->getKey()			    // Key
+      << "\t" << tl->getName().toString()   // Name
+      << "\t" << mode			    // Mode designator [I,E,A]
+      << std::endl
+      << tok_out.str();
   }
 
   std::string DbCore::dumpState(bool verbose) {
+    // Only one dump in m_stateKeyframe is a full one. Conflict dumps are always full so that the
+    // .reactorstate supersedes the .reactordelta of the nominal dump of the same attempt.
+    bool delta = !verbose && m_stateKeyframe>0 && (m_stateDumps%m_stateKeyframe)!=0;
+    std::map<int, std::string> rows;
+    if(!delta)
+      m_stateDumps = 0;
+    ++m_stateDumps;
+
     // Create a new file
     std::ostringstream oss;
-    oss << m_statePath << "/" << getCurrentTick() << "." << Agent::instance()->getCurrentAttempt() << ".reactorstate";
+    oss << m_statePath << "/" << getCurrentTick() << "." << Agent::instance()->getCurrentAttempt()
+	<< (delta ? ".reactordelta" : ".reactorstate");
 
     // Open file for writing
     std::ofstream db_out(oss.str().c_str());
 
-    // Internals 
+    // Internals
     std::vector< std::pair<TimelineId, TICK> >::const_iterator intit = m_internalTimelineTable.begin();
     std::vector< std::pair<TimelineId, TICK> >::const_iterator const endint = m_internalTimelineTable.end();
-    
+
     // Write out timelne name and contents
     for( ; endint!=intit; ++intit ) {
-      const TimelineId tl = intit->first; 
-      writeTimeline(tl,'I', db_out);
+      const TimelineId tl = intit->first;
+      writeTimeline(tl,'I', db_out, rows, delta);
     }
 
     // Externals
-    std::map<int, TimelineContainer>::const_iterator 
+    FlatMap<int, TimelineContainer>::const_iterator
       cextit = m_externalTimelineTable.begin();
-    std::map<int, TimelineContainer>::const_iterator const
+    FlatMap<int, TimelineContainer>::const_iterator const
       endcext = m_externalTimelineTable.end();
 
     for( ; endcext!=cextit; ++cextit ) {
       const TimelineId tl = cextit->second.getTimeline();
-      writeTimeline(tl,'E', db_out);
+      writeTimeline(tl,'E', db_out, rows, delta);
+    }
+
+    // Tokens which are no longer reported : removed, merged or deactivated
+    if(delta) {
+      for(std::map<int, std::string>::const_iterator it = m_dumpedRows.begin(); it != m_dumpedRows.end(); ++it)
+	if(rows.find(it->first) == rows.end())
+	  db_out << "-\t" << it->first << std::endl;
     }
 
+    // Keep the rows to compute the next delta
+    if(m_stateKeyframe>0)
+      m_dumpedRows.swap(rows);
+
     // Close the file handle
     db_out.close();
-    
+
     // Output assembly as well (very large amount of data, will slow execution)
     condDebugMsg(!verbose, "trex:monitor:verbose", nameString() << m_assembly.exportToPlanWorks(getCurrentTick(), Agent::instance()->getCurrentAttempt()));
     condDebugMsg(verbose, "trex:monitor:conflicts:verbose", nameString() << m_assembly.exportToPlanWorks(getCurrentTick(), Agent::instance()->getCurrentAttempt()));
-    
+
     return std::string("Success.");
   }
 
@@ -876,6 +1377,9 @@ namespace TREX {
   }
 
   void DbCore::handleTickStart(){
+    // Failures of the last tick were analysed on the analyst thread
+    logFailures();
+
     m_sync_stepCount = 0;
     m_search_depth = 0;
     m_search_stepCount = 0;
@@ -885,7 +1389,8 @@ namespace TREX {
       return;
     }
 
-    // Update the clock variable
+    // Update the clock variable. Only the constraints on the clock, the execution functions, are put on the agenda, so the
+    // propagation below only reaches further when they change something.
     getAgentClockVariable(m_db)->restrictBaseDomain(IntervalIntDomain(getCurrentTick(), PLUS_INFINITY));
     
     // Since things depend on the clock there could easily be a constraint violated by a tick increment. We generate an excpetion
@@ -900,7 +1405,7 @@ namespace TREX {
     if(m_state == DbCore::INACTIVE)
       m_currentTickCycle = getCurrentTick();
 
-    // Start actiosn as needed
+    // Start actiosn as needed. This propagation is free unless an action was started.
     updateActions();
     if(!propagate())
       return;
@@ -936,6 +1441,39 @@ namespace TREX {
       return false;
     }
 
+    // The cycle would only find the plan complete again
+    if(m_state == DbCore::INACTIVE && isPlanCurrent()){
+      TREX_INFO("DbCore:hasWork", nameString() << "Plan still current.");
+      m_cachedCycles++;
+      m_currentTickCycle = getCurrentTick();
+      m_lastCompleteTick = getCurrentTick();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool DbCore::isPlanCurrent() const {
+    if(!m_planCache || m_lastCompleteTick == MINUS_INFINITY || m_planChanges != m_plannedChanges)
+      return false;
+
+    TICK horizonStart, horizonEnd;
+    getHorizon(horizonStart, horizonEnd);
+
+    const TokenSet& tokens = m_db->getTokens();
+    for(TokenSet::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
+      TokenId token = *it;
+      if(token->isMerged() || !inScope(token))
+	continue;
+
+      if(TestMonitor::isCondition(token->getKey()))
+	return false;
+
+      int start = (int) token->start()->lastDomain().getLowerBound();
+      if(start >= m_plannedHorizonEnd && start < (int) horizonEnd)
+	return false;
+    }
+
     return true;
   }
 
@@ -951,6 +1489,15 @@ namespace TREX {
     checkError(isValidDb(), "Invalid database before deliberation step.");
 
     if(m_solver->isExhausted()) {
+      // The previous plan may not fit the new situation: plan again without it
+      if(!m_hintedTokens.empty()){
+	TREXLog() << nameString() << "No plan found from the previous plan. Planning from scratch." << std::endl;
+	m_solver->reset();
+	retractPlanHint();
+	propagate();
+	return;
+      }
+
       m_planLog<<'['<<getCurrentTick()<<"] No plan found"<<std::endl;
       TREXLog() << nameString() << "No plan found." << std::endl;
       markInvalid("Solver exhausted. No Plan found. Problem is over constrained. Enable Solver:step in Debug.cfg to investigate", true);
@@ -975,25 +1522,53 @@ namespace TREX {
     checkError(m_state == DbCore::ACTIVE, "Should always be in this state by now if clean up done correctly.");
 
 
-    // Retrieve and store a copy of the old horizon to reset afterwards. It is shared state for the process.
+    // The horizon belongs to this reactor, the filter reads it from here
     setHorizon();
-    const IntervalIntDomain& horizon = DeliberationFilter::getHorizon();
+    const IntervalIntDomain& horizon = m_horizon;
 
     TREX_INFO("DbCore:resume",  nameString() << "Using horizon " << horizon.toString());
 
     checkError(true || !horizon.isMember(getCurrentTick()), 
 	       "Cannot be planning at the execution frontier. Collides with synchronization.");
 
-    // Execute a single step in the search
-    m_solver->step();
+    // After a repair, start from the previous plan rather than from scratch
+    if(m_hintPending){
+      m_hintPending = false;
+      unsigned int restored = applyPlanHint();
+      TREX_INFO("trex:info:planning", nameString() << "Restored " << restored << " tokens from the previous plan.");
+      if(!propagate())
+	return;
+    }
+
+    // Execute as many steps as are expected to fit in our share of the time left to the tick. Only a
+    // single one if the clock has no deadline.
+    const double budget = m_resumeBudget * Agent::instance()->getClock().getTimeLeft();
+    const long long start = ClockStat::now(ClockStat::monotonic);
+    unsigned int steps = 0;
+    while(true) {
+      m_solver->step();
+      steps++;
+
+      m_search_depth = std::max(m_search_depth, m_solver->getDepth());
+      m_search_depth += m_solver->getStepCount();
+      TREX_INFO("trex:info:planning", "Step: depth == " << m_solver->getDepth() << " count == " << m_solver->getStepCount());
 
-    m_search_depth = std::max(m_search_depth, m_solver->getDepth());
-    m_search_depth += m_solver->getStepCount();
-    TREX_INFO("trex:info:planning", "Step: depth == " << m_solver->getDepth() << " count == " << m_solver->getStepCount());
+      // New tokens are scoped before the next step looks at them
+      processPendingTokens();
+
+      if(m_solver->noMoreFlaws() || m_solver->isExhausted())
+	break;
+
+      const double elapsed = (ClockStat::now(ClockStat::monotonic) - start) / 1e9;
+      if(!m_solver->fits(budget - elapsed))
+	break;
+    }
+
+    TREX_INFO("trex:info:planning", nameString() << steps << " steps in " << 
+	      (ClockStat::now(ClockStat::monotonic) - start) / 1e6 << " ms, for a budget of " << budget * 1e3 << " ms");
 
     // Now handle the aftermath. Dispatch is handled on a clock tick, so just update tick cycles
     // and clear the solver.
-    processPendingTokens();
     if(m_solver->noMoreFlaws()){
 
       condDebugMsg(m_solver->getStepCount() > 0, "trex:info:planning", logPlan("New Plan"));
@@ -1015,6 +1590,20 @@ namespace TREX {
     if(m_state == DbCore::INVALID)
       return false;
 
+    if(m_validationPeriod == 0)
+      return isValidEntities();
+
+    // Sample a full check periodically, and in between only look at what is new
+    if(getCurrentTick() >= m_nextFullValidation){
+      m_nextFullValidation = getCurrentTick() + m_validationPeriod;
+      m_unvalidatedTokens.clear();
+      return isValidEntities();
+    }
+
+    return isValidNewTokens();
+  }
+
+  bool DbCore::isValidEntities() const{
     std::set<EntityId> entities;
     Entity::getEntities(entities);
     for(std::set<EntityId>::const_iterator it = entities.begin(); it != entities.end(); ++it){
@@ -1026,6 +1615,23 @@ namespace TREX {
     return true;
   }
 
+  bool DbCore::isValidNewTokens() const{
+    for(TokenSet::const_iterator it = m_unvalidatedTokens.begin(); it != m_unvalidatedTokens.end(); ++it){
+      TokenId token = *it;
+      if(!token.isValid())
+	return false;
+
+      const std::vector<ConstrainedVariableId>& vars = token->getVariables();
+      for(std::vector<ConstrainedVariableId>::const_iterator v_it = vars.begin(); v_it != vars.end(); ++v_it){
+	if(!v_it->isValid())
+	  return false;
+      }
+    }
+
+    m_unvalidatedTokens.clear();
+    return true;
+  }
+
   bool DbCore::isGoal(const TokenId& tok) const{
     bool result = tok->master().isNoId();
     return result && m_goals.find(tok) != m_goals.end();
@@ -1065,10 +1671,17 @@ namespace TREX {
    * @brief Notifies observers of new information.
    */
   void DbCore::notifyObservers(){
+    TickTraceScope trace("notifyObservers", getName().c_str());
     checkError(m_state != DbCore::INVALID, "Should not be publishing when state is invalid");
 
     TREX_INFO("trex:debug:synchronization:notifyObservers", nameString() <<  "START");
 
+    // Restrictions are applied for all the timelines first, and propagated only when a decision cannot be taken without it.
+    // Domains which are not propagated yet are a superset of the propagated ones, so a lower bound after the current tick,
+    // or an upper bound before it, remains true after propagation.
+    bool pending = false;
+    std::vector<TokenId> published;
+
     for(std::vector< std::pair<TimelineId, TICK> >::iterator it = m_internalTimelineTable.begin(); it != m_internalTimelineTable.end(); ++it){
       TimelineId timeline = it->first;
       TICK lastPublished = it->second;
@@ -1079,9 +1692,12 @@ namespace TREX {
 	continue;
 
       // We want the token at the current tick. If there is NECESSARILY a change in value then we consider it suitable for
-      // dispatch. This means the start time == the currentTick. This is mainly a consideration where we are handling the first tick
+      // dispatch. This means the start time == the currentTick. This is mainly a consideration where we are handling the first tick.
+      // Tokens committed and ended in a prior tick are settled: the scan starts at the frontier and moves it past them.
+      ExecutionFrontier& frontier = m_internalFrontiers[timeline->getKey()];
+      bool settled = true;
       const std::list<TokenId>& tokenSequence = timeline->getTokenSequence();
-      for(std::list<TokenId>::const_iterator t_it = tokenSequence.begin(); t_it != tokenSequence.end(); ++t_it){
+      for(std::list<TokenId>::const_iterator t_it = frontier.begin(tokenSequence); t_it != tokenSequence.end(); ++t_it){
 	TokenId token = *t_it;
 	checkError(token.isValid(), token);
 	TREX_INFO("trex:debug:synchronization:notifyObservers", 
@@ -1090,29 +1706,29 @@ namespace TREX {
 	// If we are processing the initial tick, set the start time to be exactly 0
 	if(getCurrentTick() == 0 && token->start()->lastDomain().getUpperBound() == 0){
 	  token->start()->restrictBaseDomain(IntervalIntDomain(0, 0));
-	  if(!propagate()){
-	    TREX_INFO("trex:error", nameString() << "Inconsistent on propagating initial time bounds." << std::endl  << m_synchronizer.propagationFailure());
-
-	    throw std::runtime_error("Fatal Error propagating initial time bounds in " + nameString() + "\n\n" + m_synchronizer.propagationFailure());
-	  }
+	  pending = true;
 	}
 
 	const IntervalIntDomain& startTime = token->start()->lastDomain();
 	const IntervalIntDomain& endTime = token->end()->lastDomain();
 
+	// The token may have to be committed : its start has to be accurate
+	if(pending && startTime.getLowerBound() <= getCurrentTick() && !token->isCommitted()){
+	  publishingPropagate("Inconsistent on propagating initial time bounds or published values.");
+	  pending = false;
+	}
+
 	// If the earliest start time is after the current tick then we can finish
-	if(startTime.getLowerBound() > getCurrentTick())
+	if(startTime.getLowerBound() > getCurrentTick()){
+	  if(settled)
+	    frontier.moveTo(t_it, tokenSequence);
+	  settled = false;
 	  break;
+	}
 
 	// If the token has not been committed, do so since it is in the past
 	if(!token->isCommitted())
-	  commitAndRestrict(token);
-
-	if(!propagate()){
-	  TREX_INFO("trex:error", nameString() << "Inconsistent on propagating committed values during synchronization." << std::endl  << m_synchronizer.propagationFailure());
-	  // CONFLICT
-	  throw  std::runtime_error("Fatal Error propagating committed values during synchronization in " + nameString() + "\n\n" + m_synchronizer.propagationFailure());
-	}
+	  pending = commitAndRestrict(token) || pending;
 
 	// If the latest end time <= the current tick, skip ahead
 	if(endTime.getUpperBound() <= getCurrentTick()){
@@ -1120,24 +1736,32 @@ namespace TREX {
 	  continue;
 	}
 
+	// The token may be published : its bounds have to be accurate
+	if(pending && m_notificationKeys.find(token->getKey()) == m_notificationKeys.end()){
+	  publishingPropagate("Inconsistent on propagating committed values during synchronization.");
+	  pending = false;
+	  if(endTime.getUpperBound() <= getCurrentTick()){
+	    token->restrictBaseDomains();
+	    continue;
+	  }
+	}
+
+	// This is the first token which is not settled
+	if(settled){
+	  frontier.moveTo(t_it, tokenSequence);
+	  settled = false;
+	}
+
 	// If the start time is not a singleton it does not have to be published, so we do not.
 	if(startTime.getUpperBound() > getCurrentTick() && !startTime.isSingleton())
 	  continue;
 
-	// If we have a hit, generate a notification.
+	// If we have a hit, restrict its start and generate a notification once all are propagated.
 	if(startTime.isMember(getCurrentTick()) && m_notificationKeys.find(token->getKey()) == m_notificationKeys.end()){
 	  IntervalIntDomain startBounds((int) token->start()->lastDomain().getUpperBound(), getCurrentTick());
 	  token->start()->restrictBaseDomain(startBounds);
-
-	  if(!propagate()){
-	    TREX_INFO("trex:error", nameString() << "Inconsistent on propagating committed values during synchronization." << std::endl  << m_synchronizer.propagationFailure());
-	    // CONFLICT
-	    throw std::runtime_error("Fatal Error propagating committed values during synchronization in " + nameString() + "\n\n" + m_synchronizer.propagationFailure());
-	  }
-
-	  // Now dispatch observation
-	  ObservationByReference obs(token);
-	  m_observer->notify(obs);
+	  pending = true;
+	  published.push_back(token);
 
 	  // Log last published for this tick
 	  it->second = getCurrentTick();
@@ -1145,11 +1769,39 @@ namespace TREX {
 	  m_notificationKeys.insert(token->getKey());
 	}
       }
+
+      if(settled)
+	frontier.moveTo(tokenSequence.end(), tokenSequence);
+    }
+
+    // Single propagation for all the restrictions of the tick
+    if(pending)
+      publishingPropagate("Inconsistent on propagating committed values during synchronization.");
+
+    // Now dispatch observations
+    if(!published.empty()){
+      std::vector<ObservationByReference*> observations;
+      std::vector<const Observation*> batch;
+      for(std::vector<TokenId>::const_iterator p_it = published.begin(); p_it != published.end(); ++p_it){
+	observations.push_back(new ObservationByReference(*p_it));
+	batch.push_back(observations.back());
+      }
+      m_observer->notifyBatch(batch);
+      for(std::vector<ObservationByReference*>::const_iterator o_it = observations.begin(); o_it != observations.end(); ++o_it)
+	delete *o_it;
     }
 
     TREX_INFO("trex:debug:synchronization:notifyObservers", nameString() <<  "END");
   }
 
+  void DbCore::publishingPropagate(const std::string& message){
+    if(!propagate()){
+      TREX_INFO("trex:error", nameString() << message << std::endl  << m_synchronizer.propagationFailure());
+      // CONFLICT
+      throw std::runtime_error("Fatal Error propagating committed values during synchronization in " + nameString() + "\n\n" + m_synchronizer.propagationFailure());
+    }
+  }
+
   /**
    * @brief Dispatch Goals To Respective Servers.
    *
@@ -1158,11 +1810,20 @@ namespace TREX {
    * and if they could execute for at least a 1 tick duration in that window.
    */
   void DbCore::dispatchCommands(){
+    TickTraceScope trace("dispatchCommands", getName().c_str());
     TREX_INFO("trex:debug:dispatching:dispatchCommands", nameString() << "START");
 
-    std::vector<TokenId> activeUncontrollableEvents;
+    // The solver may have changed the temporal network since the distances were computed
+    m_distances.clear();
+
+    UncontrollableEvents activeUncontrollableEvents;
     bool initialized(false);
-    for(std::map<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
+
+    // The dispatch candidates and their timeline, collected over all the timelines before being sent
+    TickVector<TokenId>::type dispatchable;
+    TickVector<TimelineContainer*>::type containers;
+
+    for(FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
       TimelineContainer& tc = it->second;
       TimelineId timeline = tc.getTimeline();
       ServerId server = tc.getServer();
@@ -1183,14 +1844,24 @@ namespace TREX {
       IntervalIntDomain dispatchWindow(dispatchLB, dispatchUB);
       
 
-      // Get the timeline to dispatch as a list and then process it
+      // Get the timeline to dispatch as a list and then process it, starting from the execution frontier.
+      ExecutionFrontier& frontier = tc.getFrontier();
+      bool settled = true;
       const std::list<TokenId>& tokenSequence = timeline->getTokenSequence();
-      for(std::list<TokenId>::const_iterator t_it = tokenSequence.begin(); t_it != tokenSequence.end(); ++t_it){
+      for(std::list<TokenId>::const_iterator t_it = frontier.begin(tokenSequence); t_it != tokenSequence.end(); ++t_it){
 	TokenId token = *t_it;
 
-	// If we have already dispatched the token we can skip it. We would be better served storing this execution frontier
-	// to more efficiently dispatch. This could be done in a derivative of the Timeline designed for execution systems
-	if(token->isCommitted() || tc.isDispatched(token) || inDeliberation(token))
+	// If we have already dispatched the token we can skip it. Committed and dispatched tokens before the frontier
+	// will not be visited again.
+	if(token->isCommitted() || tc.isDispatched(token))
+	  continue;
+
+	if(settled){
+	  frontier.moveTo(t_it, tokenSequence);
+	  settled = false;
+	}
+
+	if(inDeliberation(token))
 	  continue;
 
 	if (!initialized) {
@@ -1219,34 +1890,74 @@ namespace TREX {
 	if(latestStart < getCurrentTick())
 	  continue;
 
-	// If the token has an  overlap with the dispatch window of at least on tick duration, send it. If the request
-	// is accepted we mark it as dispatched, otherwise we break from this timeline, since we do not expect a server to receice a request
-	// for a latter goal if it does not accept a predecessor. Note that the semantics of accepting a request are not the same as rejecting
-	// the request outright. It is rather the question of whether you can serve the request now. Absent a positive reponse, we wil retry
-	// on the next iteration
+	// If the token has an  overlap with the dispatch window of at least on tick duration, it will be sent.
 	if(startTime.intersects(dispatchWindow)){
 	  TREX_INFO("trex:dispatching", nameString() << "Dispatching " << token->toLongString());
 	  token->getObject()->restrictBaseDomain(token->getObject()->lastDomain());
-
-	  if(!propagate()){
-	    TREX_INFO("trex:warning:dispatchCommands", nameString() << "Dispatching " << token->toLongString() << " failed due to an inconsistent network.");
-	    // CONFLICT
-	    return;
-	  }
-
-	  if(server->request(token)){
-	    tc.markDispatched(token);
-	    setDispatchTime(token);
-	  }
-	  else
-	    break;
+	  dispatchable.push_back(token);
+	  containers.push_back(&tc);
 	}
       }
+
+      if(settled)
+	frontier.moveTo(tokenSequence.end(), tokenSequence);
     }
 
+    if(!dispatchable.empty())
+      dispatchBatches(dispatchable, containers);
+
     TREX_INFO("trex:debug:dispatching:dispatchCommands", nameString() << "END");
   }
 
+  /**
+   * @brief The restrictions of all the dispatched tokens are propagated at once, then each server receives its tokens as a
+   * single batch. If the request is accepted we mark it as dispatched. A server does not receive a request for a latter goal
+   * on a timeline if it does not accept a predecessor. Note that the semantics of accepting a request are not the same as
+   * rejecting the request outright. It is rather the question of whether you can serve the request now. Absent a positive
+   * reponse, we will retry on the next iteration
+   */
+  void DbCore::dispatchBatches(const TickVector<TokenId>::type& dispatchable, const TickVector<TimelineContainer*>::type& containers){
+    if(!propagate()){
+      TREX_INFO("trex:warning:dispatchCommands", nameString() << "Dispatching " << dispatchable.size() << " tokens failed due to an inconsistent network.");
+      // CONFLICT
+      return;
+    }
+
+    // Group the tokens by server, preserving their order
+    TickVector<ServerId>::type servers;
+    TickVector<TickVector<unsigned int>::type>::type byServer;
+    for(unsigned int i = 0; i < dispatchable.size(); i++){
+      ServerId server = containers[i]->getServer();
+      unsigned int s = 0;
+      while(s < servers.size() && servers[s] != server)
+	s++;
+      if(s == servers.size()){
+	servers.push_back(server);
+	byServer.push_back(TickVector<unsigned int>::type());
+      }
+      byServer[s].push_back(i);
+    }
+
+    // The server interface takes standard vectors, reused across servers
+    std::vector<TokenId> goals;
+    std::vector<bool> accepted;
+    for(unsigned int s = 0; s < servers.size(); s++){
+      goals.clear();
+      accepted.clear();
+      for(unsigned int j = 0; j < byServer[s].size(); j++)
+	goals.push_back(dispatchable[byServer[s][j]]);
+
+      servers[s]->request(goals, accepted);
+
+      for(unsigned int j = 0; j < byServer[s].size(); j++){
+	if(accepted[j]){
+	  containers[byServer[s][j]]->markDispatched(goals[j]);
+	  setDispatchTime(goals[j]);
+	}
+      }
+    }
+  }
+
 
   /**
    * @brief Dispatch Recalls To Respective Servers. All tokens in the future that have been dispatched should be recalled.
@@ -1260,32 +1971,48 @@ namespace TREX {
 
     TREX_INFO("trex:debug:dispatching:dispatchRecalls", nameString() << "START");
 
-    for(std::map<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
+    // Recalls are sent in one batch per server
+    std::vector< std::pair<ServerId, std::vector<TokenId> > > batches;
+
+    for(FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
       TimelineContainer& tc = it->second;
-      TimelineId timeline = tc.getTimeline();
       ServerId server = tc.getServer();
 
-      // If the end time is not passed, consider it.
-      const std::list<TokenId>& tokenSequence = timeline->getTokenSequence();
-      for(std::list<TokenId>::const_iterator t_it = tokenSequence.begin(); t_it != tokenSequence.end(); ++t_it){
-	TokenId token = *t_it;
+      // Only the dispatched tokens can be recalled : walk them rather than the whole timeline
+      std::vector<TokenId> recalled;
+      const TimelineContainer::DispatchedTokens& dispatched = tc.getDispatchedTokens();
+      for(TimelineContainer::DispatchedTokens::const_iterator d_it = dispatched.begin(); d_it != dispatched.end(); ++d_it){
+	TokenId token = d_it->second;
 	checkError(token.isValid(), token);
 
 	TREX_INFO("trex:debug:dispatching", nameString() << 
-		 "Evaluating " << tokenToString(token) << " for recall. Dispatched[" << tc.isDispatched(token) << "] "
-		 "Ends:" << token->end()->baseDomain().toString());
+		 "Evaluating " << tokenToString(token) << " for recall. Ends:" << token->end()->baseDomain().toString());
+
+	// If it is not finished yet, recall it.
+	if(token->end()->baseDomain().getUpperBound() > getCurrentTick() && !observedNow(token))
+	  recalled.push_back(token);
+      }
 
-	// If the token has been dispatched and it is not finished yet ,recall it.
-	if(tc.isDispatched(token) && token->end()->baseDomain().getUpperBound() > getCurrentTick() && !observedNow(token)){
+      if(recalled.empty())
+	continue;
 
-	  TREX_INFO("trex:dispatching", nameString() << "Recalling " << tokenToString(token));
-	  server->recall(token);
-	  tc.clearDispatched(token);
-	  resetDispatchTime(token);
-	}
+      for(std::vector<TokenId>::const_iterator t_it = recalled.begin(); t_it != recalled.end(); ++t_it){
+	TREX_INFO("trex:dispatching", nameString() << "Recalling " << tokenToString(*t_it));
+	tc.clearDispatched(*t_it);
+	resetDispatchTime(*t_it);
       }
+
+      unsigned int i = 0;
+      while(i < batches.size() && batches[i].first != server)
+	i++;
+      if(i == batches.size())
+	batches.push_back(std::make_pair(server, std::vector<TokenId>()));
+      batches[i].second.insert(batches[i].second.end(), recalled.begin(), recalled.end());
     }
 
+    for(unsigned int i = 0; i < batches.size(); i++)
+      batches[i].first->recall(batches[i].second);
+
     TREX_INFO("trex:debug:dispatching:dispatchRecalls", nameString() << "END");
   }
 
@@ -1348,20 +2075,34 @@ namespace TREX {
     checkError(token->end()->lastDomain().getUpperBound() > getCurrentTick(), 
 	       token->end()->lastDomain() << " and TICK " << getCurrentTick());
 
+    restrictExtension(token);
+
+    return propagate();
+  }
+
+  void DbCore::restrictExtension(const TokenId& token){
     // If the token has not been committed, do so
     if(!token->isCommitted())
       commitAndRestrict(token);
 
     token->end()->restrictBaseDomain(IntervalIntDomain(getCurrentTick() + 1, (int) token->end()->baseDomain().getUpperBound()));
-
-    return propagate();
   }
 
   bool DbCore::propagate(){
     if(m_state == DbCore::INVALID)
       return false;
 
-    if(!m_db->getConstraintEngine()->propagate()){
+    // Nothing changed since the last propagation : the agenda is empty and the network still consistent
+    const ConstraintEngineId& ce = m_db->getConstraintEngine();
+    if(ce->constraintConsistent()){
+      processPendingTokens();
+      return true;
+    }
+
+    // The temporal network may change
+    m_distances.clear();
+
+    if(!ce->propagate()){
       TREXLog() << nameString() << "Inconsistent plan." << std::endl;
       TREX_INFO("DbCore:propagate", nameString() << "Inconsistent plan.");
       markInvalid("The constraint network is inconsistent. To investigate, enable ConstraintEngine in Debug.cfg. Look for EMPTIED domain in log output to find the culprit.",true);
@@ -1510,52 +2251,135 @@ namespace TREX {
       return false;
     }
 
+    recordPlanHint();
+
+    m_plannedChanges = m_planChanges;
+    m_plannedHorizonEnd = m_horizon.getUpperBound();
+
     return true;
   }
 
+  void DbCore::recordPlanHint(){
+    // The restored tokens are now part of a complete plan
+    m_hintedTokens.clear();
+
+    if(m_planReuse)
+      getPlanDescription(m_planHint);
+  }
+
+  unsigned int DbCore::applyPlanHint(){
+    const IntervalIntDomain& horizon = m_horizon;
+    unsigned int restored = 0;
+
+    std::vector<PlanDescription::TimelineDescription>::const_iterator it = m_planHint.m_internalTimelines.begin();
+    std::vector<PlanDescription::TimelineDescription>::const_iterator const end = m_planHint.m_internalTimelines.end();
+
+    for( ; end!=it; ++it ) {
+      ObjectId object = m_db->getObject(it->name);
+      if(object.isNoId() || !TimelineId::convertable(object))
+	continue;
+
+      TimelineId timeline = (TimelineId) object;
+
+      // The last token of the previous plan which is in the plan now
+      TokenId predecessor;
+
+      for(std::vector<PlanDescription::TokenDescription>::const_iterator tokit = it->tokens.begin(); tokit != it->tokens.end(); ++tokit){
+	// Slaves of the previous plan were discarded by the relaxation, but goals and committed values remain
+	EntityId entity = Entity::getEntity(tokit->key);
+	if(entity.isNoId() || !TokenId::convertable(entity))
+	  continue;
+
+	TokenId token = (TokenId) entity;
+	if(token->isActive()){
+	  predecessor = token;
+	  continue;
+	}
+
+	if(!token->isInactive() || !token->getState()->lastDomain().isMember(Token::ACTIVE) ||
+	   token->start()->lastDomain().getLowerBound() > horizon.getUpperBound())
+	  continue;
+
+	if(restoreToken(timeline, token, predecessor)){
+	  predecessor = token;
+	  restored++;
+	}
+      }
+    }
+
+    return restored;
+  }
+
+  bool DbCore::restoreToken(const TimelineId& timeline, const TokenId& token, const TokenId& predecessor){
+    token->activate();
+
+    std::vector<OrderingChoice> choices;
+    m_db->getOrderingChoices(token, choices);
+
+    // Insert it right after its predecessor in the previous plan, or first
+    std::vector<OrderingChoice>::const_iterator it = choices.begin();
+    for( ; it != choices.end(); ++it){
+      if(it->first != timeline)
+	continue;
+
+      if(predecessor.isId() ? (it->second.first == predecessor && it->second.second == token) : it->second.first == token)
+	break;
+    }
+
+    if(it != choices.end()){
+      timeline->constrain(it->second.first, it->second.second);
+
+      if(m_db->getConstraintEngine()->propagate()){
+	TREX_INFO("DbCore:applyPlanHint", nameString() << "Restored " << token->toString());
+	m_hintedTokens.push_back(token->getKey());
+	return true;
+      }
+    }
+
+    TREX_INFO("DbCore:applyPlanHint", nameString() << "Could not restore " << token->toString());
+    token->cancel();
+    m_db->getConstraintEngine()->propagate();
+    return false;
+  }
+
+  void DbCore::retractPlanHint(){
+    for(std::vector<int>::const_iterator it = m_hintedTokens.begin(); it != m_hintedTokens.end(); ++it){
+      EntityId entity = Entity::getEntity(*it);
+      if(entity.isNoId() || !TokenId::convertable(entity))
+	continue;
+
+      TokenId token = (TokenId) entity;
+      if(token->isActive() && !token->isCommitted())
+	token->cancel();
+    }
+
+    // Do not try it again on the next repair
+    m_hintedTokens.clear();
+    m_planHint.clear();
+  }
+
   bool DbCore::hasEntity(const EntityId& entity){
-    return s_foreignKeyRelation.find(entity->getKey()) != s_foreignKeyRelation.end();
+    return m_foreignKeys.contains(entity);
   }
 
   void DbCore::addEntity(const EntityId& foreign, const EntityId& local){
-    s_foreignKeyRelation.insert(std::pair<int, EntityId>(foreign->getKey(), local));
+    m_foreignKeys.insert(foreign, local);
   }
 
   void DbCore::removeEntity(const EntityId& foreign){
-    s_foreignKeyRelation.erase(foreign->getKey());
+    m_foreignKeys.erase(foreign);
   }
 
   EntityId DbCore::getLocalEntity(const EntityId& foreign){
-    std::map<int, EntityId>::const_iterator it = s_foreignKeyRelation.find(foreign->getKey());
-    if(it != s_foreignKeyRelation.end()){
-      EntityId e = it->second;
-      checkError(e.isValid(), e << " is a stale id for " << foreign->toString());
-      return e;
-    }
-    else
-      return EntityId::noId();
+    return m_foreignKeys.getLocal(foreign);
   }
 
   EntityId DbCore::getForeignEntity(const EntityId& local){
-    for(std::map<int, EntityId>::iterator it = s_foreignKeyRelation.begin(); it != s_foreignKeyRelation.end(); ++it){
-      if(it->second == local){
-	EntityId foreignEntity = Entity::getEntity(it->first);
-	return foreignEntity;
-      }
-    }
-
-    return EntityId::noId();
+    return m_foreignKeys.getForeign(local);
   }
 
   void DbCore::purgeOrphanedKeys(){
-    std::map<int, EntityId>::iterator it = s_foreignKeyRelation.begin();
-    while(it != s_foreignKeyRelation.end()){
-      int foreignKey = it->first;
-      if(it->second->isDiscarded() || Entity::getEntity(foreignKey).isNoId())
-	s_foreignKeyRelation.erase(it++);
-      else
-	++it;
-    }
+    m_foreignKeys.expire();
   }
 
   bool DbCore::onTimeline(const TokenId& token, const LabelStr& timelineMode){
@@ -1663,7 +2487,10 @@ namespace TREX {
       return;
     }
 
-    std::vector<TokenId> activeUncontrollableEvents;
+    // The solver may have changed the temporal network since the distances were computed
+    m_distances.clear();
+
+    UncontrollableEvents activeUncontrollableEvents;
     bool initialized(false);
 
     const IntervalIntDomain horizon(getCurrentTick(), getCurrentTick());
@@ -1703,6 +2530,15 @@ namespace TREX {
     }
   }
   
+  /**
+   * @brief Orders tokens by the upper bound of their end time.
+   */
+  struct EndTimeComparator {
+    bool operator()(const TokenId& a, const TokenId& b) const {
+      return a->end()->lastDomain().getUpperBound() < b->end()->lastDomain().getUpperBound();
+    }
+  };
+
   /**
    * @brief Clear out the crud of tokens in the past that that can not effect the present or the future
    */
@@ -1710,13 +2546,24 @@ namespace TREX {
     if(m_state != DbCore::INACTIVE)
       return;
 
+    TickTraceScope trace("archive", getName().c_str());
+
     // Propagate the database
     if(!propagate())
       return;
 
     // Now we process any committed tokens that may be up for termination. These will be cleaned up on further ticks.
-    TokenSet committedTokens = m_committedTokens;
-    for(TokenSet::iterator it = committedTokens.begin(); it != committedTokens.end(); ++it){
+    // With a bounded batch, the tokens that ended first are evaluated first and the others wait for a later tick.
+    bool overBudget = isOverBudget();
+    condDebugMsg(overBudget, "DbCore:archive", nameString() << "Over budget with " << getMemoryUsage().tokens << " tokens and "
+		 << getMemoryUsage().entities << " entities. Archiving without limits.");
+    TickVector<TokenId>::type committedTokens(m_committedTokens.begin(), m_committedTokens.end());
+    if(!overBudget && m_archiveBatch > 0 && committedTokens.size() > m_archiveBatch){
+      std::partial_sort(committedTokens.begin(), committedTokens.begin() + m_archiveBatch, committedTokens.end(), EndTimeComparator());
+      committedTokens.resize(m_archiveBatch);
+    }
+
+    for(TickVector<TokenId>::type::iterator it = committedTokens.begin(); it != committedTokens.end(); ++it){
       TokenId token = *it;
       checkError(token.isValid(), token);
 
@@ -1737,22 +2584,110 @@ namespace TREX {
     for(TokenSet::iterator it = m_terminableTokens.begin(); it != m_terminableTokens.end(); ++it){
       TokenId token = *it;
       checkError(token.isValid(), token);
-      if(canBeTerminated(token))
+      // Tokens terminated on a prior tick may be waiting for garbage collection
+      if(!token->isTerminated() && canBeTerminated(token))
 	terminate(token);
     }
 
-    // Clean terminated tokens
-    Entity::discardAll(m_terminatedTokens);
+    if(m_history != NULL)
+      spillHistory();
+
+    // Clean terminated tokens once enough of them are pending. The history gets them first.
+    if(m_terminatedTokens.size() > (overBudget ? 0 : m_gcThreshold)){
+      if(m_history != NULL)
+	writeHistory(m_terminatedTokens);
+      Entity::discardAll(m_terminatedTokens);
+      purgeOrphanedKeys();
+      Entity::garbageCollect();
+    }
+
+    condDebugMsg(m_db->getConstraintEngine()->isRelaxed(), "trex:error", nameString() << "Should be no relaxation in garbage collection");
+  }
+
+  void DbCore::spillHistory(){
+    if(getCurrentTick() < m_lastSpill + m_historyWindow || getCurrentTick() < m_historyWindow)
+      return;
+    m_lastSpill = getCurrentTick();
+
+    // The committed tokens archive could not terminate yet are history too : they are written but stay in the database
+    const TICK limit = getCurrentTick() - m_historyWindow;
+    TokenSet past;
+    const TokenSet* history[] = {&m_committedTokens, &m_terminableTokens, &m_terminatedTokens};
+    for(unsigned int i = 0; i < 3; i++)
+      for(TokenSet::const_iterator it = history[i]->begin(); it != history[i]->end(); ++it){
+	TokenId token = *it;
+	checkError(token.isValid(), token);
+	if(token->end()->baseDomain().getUpperBound() < limit)
+	  past.insert(token);
+      }
+    writeHistory(past);
+
+    TokenSet spilled;
+    for(TokenSet::const_iterator it = past.begin(); it != past.end(); ++it)
+      if(m_terminatedTokens.erase(*it) > 0)
+	spilled.insert(*it);
+
+    if(spilled.empty())
+      return;
+
+    TREX_INFO("DbCore:spillHistory", nameString() << "Discarding " << spilled.size() << " tokens spilled to the history");
+
+    // The database keeps only the recent history
+    Entity::discardAll(spilled);
     purgeOrphanedKeys();
     Entity::garbageCollect();
+  }
 
-    condDebugMsg(m_db->getConstraintEngine()->isRelaxed(), "trex:error", nameString() << "Should be no relaxation in garbage collection");
+  void DbCore::writeHistory(const TokenSet& tokens){
+    for(TokenSet::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
+      TokenId token = *it;
+      checkError(token.isValid(), token);
+      if(!m_historyWritten.insert(token).second)
+	continue;
+      if(m_historyTick != (int) getCurrentTick()){
+	m_history->tick(getCurrentTick());
+	m_historyTick = getCurrentTick();
+      }
+      m_history->history(token);
+      m_spilledTokens++;
+    }
+  }
+
+  bool DbCore::isOverBudget() const {
+    const MemoryUsage& usage = getMemoryUsage();
+    return (m_tokenBudget > 0 && usage.tokens > m_tokenBudget) ||
+      (m_entityBudget > 0 && usage.entities > m_entityBudget);
+  }
+
+  void DbCore::measureMemory(MemoryUsage& usage) const {
+    const ConstraintEngineId& ce = m_db->getConstraintEngine();
+    usage.tokens = m_db->getTokens().size();
+    usage.variables = ce->getVariables().size();
+    usage.constraints = ce->getConstraints().size();
+    usage.entities = usage.tokens + usage.variables + usage.constraints;
+  }
+
+  void DbCore::writeTelemetry(TelemetrySample& out) const {
+    TeleoReactor::writeTelemetry(out);
+    out.add(getName(), "sync.nSteps", m_sync_stepCount);
+    out.add(getName(), "search.maxDepth", m_search_depth);
+    out.add(getName(), "search.nSteps", m_search_stepCount);
+    out.add(getName(), "queue.goals", m_goals.size());
+    out.add(getName(), "queue.observations", m_observations.size());
+    out.add(getName(), "queue.pendingTokens", m_pendingTokens.size());
+    out.add(getName(), "queue.tokenAgenda", m_tokenAgenda.size());
+    out.add(getName(), "queue.committedTokens", m_committedTokens.size());
+    out.add(getName(), "queue.terminatedTokens", m_terminatedTokens.size());
+    out.add(getName(), "history.spilledTokens", m_spilledTokens);
   }
 
   void DbCore::setHorizon(){
     TICK horizonStart, horizonEnd;
     getHorizon(horizonStart, horizonEnd);
-    DeliberationFilter::update(horizonStart, horizonEnd);
+    checkError(horizonStart >= getCurrentTick(), horizonStart << " < " << getCurrentTick());
+    checkError(horizonEnd <= Agent::instance()->getFinalTick(), horizonEnd << " > " << Agent::instance()->getFinalTick());
+    if(m_horizon.getLowerBound() != horizonStart || m_horizon.getUpperBound() != horizonEnd)
+      m_horizon = IntervalIntDomain((int) horizonStart, (int) horizonEnd);
   }
 
   void DbCore::getHorizon(TICK& horizonStart, TICK& horizonEnd) const {
@@ -1767,7 +2702,7 @@ namespace TREX {
    */
   bool DbCore::completeExternalTimelines(){
     // Go thru all external timelines and extend current values if they have not changed in this tick.
-    for(std::map< int, TimelineContainer >::const_iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
+    for(FlatMap<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
       const TimelineContainer& tc = it->second;
       if(tc.lastObserved() < getCurrentTick())
 	if(!extendCurrentValue(tc.getTimeline())){
@@ -1887,6 +2822,13 @@ namespace TREX {
     return sl_table;
   }
 
+  DbCoreId DbCore::getInstance(const PlanDatabaseId& db){
+    std::map<PlanDatabaseId, DbCoreId>::const_iterator it = instancesByDb().find(db);
+    if(it == instancesByDb().end())
+      return DbCoreId::noId();
+    return it->second;
+  }
+
   DbCoreId DbCore::getInstance(const TokenId& token){
     if(instancesByDb().empty())
       return DbCoreId::noId();
@@ -1920,28 +2862,8 @@ namespace TREX {
       // Now bring our tick up to speed
       m_currentTickCycle = getCurrentTick();
 
-      // Revert to INACTIVE state
-      m_state = DbCore::INACTIVE;
-      
-      // First just try to relax and resolve. 
-      bool relax_fail = !m_synchronizer.relax(false);
-      bool resolve_fail = !m_synchronizer.resolve();
-
-      // If this fails the first time, apply a stronger relaxation where we discard current values that are not persistent.
-      if(discardCurrentValues || relax_fail || resolve_fail){
-	// Cleare the state again
-	m_state = DbCore::INACTIVE;
-
-	bool relax_fail = !m_synchronizer.relax(true);
-	bool resolve_fail = !m_synchronizer.resolve();
-	if( relax_fail || resolve_fail) {
-	  return false;
-	}
-      }
-
-      TREX_INFO("DbCore:synchronize", nameString() <<  "Repaired Database Below" << std::endl << PlanDatabaseWriter::toString(m_db));
-
-      debugMsg("trex:info:planning", logPlan("Repaired Plan"));
+      if(!repair(discardCurrentValues))
+	return false;
     }
 
     // These final steps must succeed or synchronization will fail. If they do not succeed
@@ -1957,23 +2879,185 @@ namespace TREX {
     // Write the nominal reactor state files (low bandwidth)
     TREX_INFO("trex:monitor:nominal", nameString() << dumpState(false));
 
+    if(m_state != DbCore::INVALID)
+      writePlanDelta();
+
     return m_state != DbCore::INVALID;
   }
 
-  bool DbCore::processRecalls(){
-    bool recalls = false;
-    for(unsigned int i=0;i<m_recallBuffer.size(); i++){
-      int tokenKey = m_recallBuffer[i];
-      EntityId entity = Entity::getEntity(tokenKey);
-      checkError(entity.isNoId() || (entity.isValid() && TokenId::convertable(entity)), "Buffer out of synch for " << tokenKey);
-      if(entity.isId()){
-	TokenId token = (TokenId) entity;
+  bool DbCore::repair(bool discardCurrentValues){
+    // Undo any impacts of solver
+    m_solver->reset();
+    notePlanChange();
+
+    // Deliberation after the repair starts from the last complete plan
+    m_hintedTokens.clear();
+    m_hintPending = m_planReuse && !discardCurrentValues;
+
+    // Revert to INACTIVE state
+    m_state = DbCore::INACTIVE;
+
+    // First try to relax only the timelines around the failure
+    if(!discardCurrentValues && m_synchronizer.relaxNeighbourhood()){
+      if(m_synchronizer.resolve()){
+	TREX_INFO("DbCore:synchronize", nameString() <<  "Repaired Database Below" << std::endl << PlanDatabaseWriter::toString(m_db));
+	return true;
+      }
+
+      m_state = DbCore::INACTIVE;
+    }
+      
+    // Then just try to relax and resolve. 
+    bool relax_fail = !m_synchronizer.relax(false);
+    bool resolve_fail = !m_synchronizer.resolve();
+
+    // If this fails the first time, apply a stronger relaxation where we discard current values that are not persistent.
+    if(discardCurrentValues || relax_fail || resolve_fail){
+      // Cleare the state again
+      m_state = DbCore::INACTIVE;
+
+      bool relax_fail = !m_synchronizer.relax(true);
+      bool resolve_fail = !m_synchronizer.resolve();
+      if( relax_fail || resolve_fail) {
+	return false;
+      }
+    }
+
+    TREX_INFO("DbCore:synchronize", nameString() <<  "Repaired Database Below" << std::endl << PlanDatabaseWriter::toString(m_db));
+
+    debugMsg("trex:info:planning", logPlan("Repaired Plan"));
+    return true;
+  }
+
+  unsigned int DbCore::countTokens() const {
+    return m_db->getTokens().size();
+  }
+
+  void DbCore::checkpoint(Checkpoint::Reactor& state){
+    TICK tick = getCurrentTick();
+
+    state.name = getName().toString();
+    state.tokens.clear();
+    state.lastObserved.clear();
+
+    for(std::vector< std::pair<TimelineId, TICK> >::const_iterator it = m_internalTimelineTable.begin(); it != m_internalTimelineTable.end(); ++it){
+      TokenId value = getValue(it->first, tick);
+      if(value.isId()){
+	state.tokens.push_back(Checkpoint::Token());
+	Checkpoint::save(value, 'i', state.tokens.back());
+      }
+    }
+
+    for(FlatMap<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.begin(); it != m_externalTimelineTable.end(); ++it){
+      const TimelineId& timeline = it->second.getTimeline();
+      TokenId value = getValue(timeline, tick);
+      if(value.isId()){
+	state.tokens.push_back(Checkpoint::Token());
+	Checkpoint::save(value, 'e', state.tokens.back());
+      }
+      state.lastObserved.push_back(std::make_pair(timeline->getName().toString(), it->second.lastObserved()));
+    }
+
+    // Goals received from clients are dispatched again by them
+    for(TokenSet::const_iterator it = m_goals.begin(); it != m_goals.end(); ++it){
+      TokenId goal = *it;
+      if(getForeignEntity(goal).isNoId() && !goal->isCommitted() && !goal->isRejected()){
+	state.tokens.push_back(Checkpoint::Token());
+	Checkpoint::save(goal, 'g', state.tokens.back());
+      }
+    }
+  }
+
+  /**
+   * Goals of the model are recognized by their key, which does not change as long as the agent is built from the same
+   * configuration.
+   */
+  void DbCore::restore(const Checkpoint::Reactor& state){
+    DbClientId client = m_db->getClient();
+    std::map<int, const Checkpoint::Token*> goals;
+
+    const IntervalIntDomain endDom(getCurrentTick()+1, PLUS_INFINITY);
+
+    for(std::vector<Checkpoint::Token>::const_iterator it = state.tokens.begin(); it != state.tokens.end(); ++it){
+      if(it->role == 'g'){
+	goals.insert(std::make_pair(it->key, &(*it)));
+	continue;
+      }
+
+      ObjectId object = m_db->getObject(LabelStr(it->timeline));
+      if(object.isNoId() || !TimelineId::convertable(object)){
+	TREXLog() << nameString() << "No timeline " << it->timeline << " to restore." << std::endl;
+	continue;
+      }
+      TimelineId timeline = (TimelineId) object;
+
+      // The saved value replaces the initial facts
+      if(it->role == 'i'){
+	std::vector<TokenId> facts(timeline->getTokenSequence().begin(), timeline->getTokenSequence().end());
+	for(std::vector<TokenId>::const_iterator f_it = facts.begin(); f_it != facts.end(); ++f_it)
+	  (*f_it)->discard();
+      }
+
+      TokenId token = client->createToken(it->predicate.c_str(), NULL, NOT_REJECTABLE);
+      const ConstrainedVariableId& objectVar = token->getObject();
+      objectVar->specify(timeline);
+      objectVar->restrictBaseDomain(objectVar->lastDomain());
+
+      if(!Checkpoint::restore(token, *it)){
+	TREXLog() << nameString() << "Failed to restore " << tokenToString(token) << std::endl;
 	token->discard();
-	recalls = true;
+	continue;
       }
+
+      if(it->role == 'i'){
+	token->activate();
+	timeline->constrain(token, token);
+      }
+      else {
+	// An external value is observed again at the current tick
+	token->start()->restrictBaseDomain(IntervalIntDomain(MINUS_INFINITY, getCurrentTick()));
+	token->end()->restrictBaseDomain(endDom);
+	bufferObservation(token);
+      }
+    }
+
+    // Model goals which are not in the checkpoint were over or rejected
+    std::vector<TokenId> discarded;
+    for(TokenSet::const_iterator it = m_goals.begin(); it != m_goals.end(); ++it){
+      TokenId goal = *it;
+      std::map<int, const Checkpoint::Token*>::const_iterator g_it = goals.find(goal->getKey());
+      if(g_it == goals.end() || g_it->second->predicate != goal->getPredicateName().toString())
+	discarded.push_back(goal);
+    }
+    for(std::vector<TokenId>::const_iterator it = discarded.begin(); it != discarded.end(); ++it)
+      (*it)->discard();
+
+    for(std::vector< std::pair<std::string, TICK> >::const_iterator it = state.lastObserved.begin(); it != state.lastObserved.end(); ++it){
+      ObjectId object = m_db->getObject(LabelStr(it->first));
+      FlatMap<int, TimelineContainer>::iterator t_it = (object.isNoId() ? m_externalTimelineTable.end() : m_externalTimelineTable.find(object->getKey()));
+      if(t_it != m_externalTimelineTable.end())
+	t_it->second.updateLastObserved(it->second);
+    }
+
+    m_currentTickCycle = getCurrentTick();
+    m_state = DbCore::INACTIVE;
+
+    TREX_INFO("trex:info", nameString() << "Restored " << state.tokens.size() << " tokens at tick " << getCurrentTick());
+
+    propagate();
+  }
+
+  bool DbCore::processRecalls(){
+    bool recalls = !m_recalledGoals.empty();
+
+    // Discarding a goal may remove other recalled goals : they leave the set through handleRemoval
+    while(!m_recalledGoals.empty()){
+      TokenId token = *m_recalledGoals.begin();
+      checkError(token.isValid(), "Recall buffer out of synch for " << token);
+      m_recalledGoals.erase(m_recalledGoals.begin());
+      token->discard();
     }
 
-    m_recallBuffer.clear();
     return recalls;
   }
 
@@ -2004,77 +3088,120 @@ namespace TREX {
    * @brief This can be greatly optimized. The exact test every time is expensive in principle but may not
    * matter for our problem set at this time.
    */
-  bool DbCore::hasPendingPredecessors(const TokenId& ctoken, const std::vector<TokenId>& uncontrollables, bool requireDifferentObject){
+  bool DbCore::hasPendingPredecessors(const TokenId& ctoken, const UncontrollableEvents& uncontrollables, bool requireDifferentObject){
     ConstrainedVariableId c = ctoken->start();
-    for(std::vector<TokenId>::const_iterator it = uncontrollables.begin(); it != uncontrollables.end(); ++it){
-      TokenId  token = *it;
-      ConstrainedVariableId u = token->end();
-
-      if (getObjectName(token) == getObjectName(ctoken) && requireDifferentObject) {
+    const double objectName = getObjectName(ctoken);
+    for(UncontrollableEvents::const_iterator o_it = uncontrollables.begin(); o_it != uncontrollables.end(); ++o_it){
+      if (requireDifferentObject && o_it->first == objectName) {
 	continue;
       }
 
-      // Finally, if the candidate end time is a positive distance from the actions start time then this action
-      // must wait until the predecessor is finished
-      const IntervalIntDomain distanceBounds(m_db->getTemporalAdvisor()->getTemporalDistanceDomain(u, c, true));
+      for(std::vector<TokenId>::const_iterator it = o_it->second.begin(); it != o_it->second.end(); ++it){
+	TokenId  token = *it;
+	ConstrainedVariableId u = token->end();
 
-      TREX_INFO("DbCore:hasPendingPredecessors",
-	       "Distance between " << u->toString() << " and " << c->toString() << " is " << distanceBounds.toString());
+	// Finally, if the candidate end time is a positive distance from the actions start time then this action
+	// must wait until the predecessor is finished
+	const IntervalIntDomain& distanceBounds = getTemporalDistance(u, c);
 
-      // It is possible that the temporal network is inconsistent in which case it will give the result of an empty domain. 
-      // It would be ideal if propagation caught that but it does not appear to!
-      if(distanceBounds.isEmpty()){
-	markInvalid("Detected an inconsistency in the temporal network when evaluating actions for execution. To investigate, enable ConstraintEngine in Debug.cfg",true);
-	return true;
-      }
+	TREX_INFO("DbCore:hasPendingPredecessors",
+		  "Distance between " << u->toString() << " and " << c->toString() << " is " << distanceBounds.toString());
 
-      // We have a distance bound
-      if(distanceBounds.getLowerBound() >= 0 && !distanceBounds.isSingleton()){
-	TREX_INFO("trex:warning:dispatching", tokenToString(token) << " must finish before " << tokenToString(ctoken) << " can be dispatched. The temporal distance between them is:" << distanceBounds.toString());
-	TREX_INFO("DbCore:hasPendingPredecessors", tokenToString(token) << " must finish first.");
-	return true;
+	// It is possible that the temporal network is inconsistent in which case it will give the result of an empty domain. 
+	// It would be ideal if propagation caught that but it does not appear to!
+	if(distanceBounds.isEmpty()){
+	  markInvalid("Detected an inconsistency in the temporal network when evaluating actions for execution. To investigate, enable ConstraintEngine in Debug.cfg",true);
+	  return true;
+	}
+
+	// We have a distance bound
+	if(distanceBounds.getLowerBound() >= 0 && !distanceBounds.isSingleton()){
+	  TREX_INFO("trex:warning:dispatching", tokenToString(token) << " must finish before " << tokenToString(ctoken) << " can be dispatched. The temporal distance between them is:" << distanceBounds.toString());
+	  TREX_INFO("DbCore:hasPendingPredecessors", tokenToString(token) << " must finish first.");
+	  return true;
+	}
       }
     }
 
     return false;
   }
 
+  const IntervalIntDomain& DbCore::getTemporalDistance(const ConstrainedVariableId& u, const ConstrainedVariableId& c){
+    std::pair<int, int> key(u->getKey(), c->getKey());
+    std::map< std::pair<int, int>, IntervalIntDomain >::iterator it = m_distances.find(key);
+    if(it == m_distances.end())
+      it = m_distances.insert(std::make_pair(key, IntervalIntDomain(m_db->getTemporalAdvisor()->getTemporalDistanceDomain(u, c, true)))).first;
+    return it->second;
+  }
+
   bool DbCore::isCurrentObservation(const TokenId& token){
     if(m_observations.find(token) == m_observations.end())
       return false;
 
     TimelineId timeline =  (TimelineId) token->getObject()->baseDomain().getSingletonValue();
-    std::map<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.find(timeline->getKey());
+    FlatMap<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.find(timeline->getKey());
     checkError(it !=  m_externalTimelineTable.end(), tokenToString(token));
     return (it->second.lastObserved() == token->start()->baseDomain().getUpperBound());
   }
 
   void DbCore::handleAddition(const TokenId& token){
+    markPublished(token);
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
     m_pendingTokens.insert(token);
+
+    if(m_validationPeriod > 0)
+      m_unvalidatedTokens.insert(token);
   }
 
   void DbCore::handleMerge(const TokenId& token){
+    markPublished(token);
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
     removeFromTokenAgenda(token);
   }
 
   void DbCore::handleSplit(const TokenId& token){
+    markPublished(token);
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
     addToTokenAgenda(token);
   }
 
   void DbCore::handleActivated(const TokenId& token){
+    markPublished(token);
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
     removeFromTokenAgenda(token);
   }
 
   void DbCore::handleDeactivated(const TokenId& token){
+    markPublished(token);
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
     addToTokenAgenda(token);
+
+    // The token leaves its timeline
+    if(token->getObject()->lastDomain().isSingleton()){
+      ObjectId object = token->getObject()->lastDomain().getSingletonValue();
+      invalidateTokenSequence(object);
+      ExecutionFrontier* frontier = getFrontier(object);
+      if(frontier != NULL)
+	frontier->handleRemoval(token);
+    }
   }
 
   void DbCore::handleRemoval(const TokenId& token){
+    markPublished(token);
+    m_synchronizer.invalidateUnitCache();
     m_tokenScope.erase(token->getKey());
     m_goals.erase(token);
     m_observations.erase(token);
+    m_recalledGoals.erase(token);
+    m_historyWritten.erase(token);
     removeFromTokenAgenda(token);
     m_pendingTokens.erase(token);
+    m_unvalidatedTokens.erase(token);
 
     removeEntity(token);
 
@@ -2088,12 +3215,49 @@ namespace TREX {
     // unbuffer it.
     if(token->getObject()->lastDomain().isSingleton()){
       ObjectId object = token->getObject()->lastDomain().getSingletonValue();
-      std::map<int, TimelineContainer>::iterator it = m_externalTimelineTable.find(object->getKey());
+      invalidateTokenSequence(object);
+      FlatMap<int, TimelineContainer>::iterator it = m_externalTimelineTable.find(object->getKey());
       if(it != m_externalTimelineTable.end())
 	it->second.handleRemoval(token);
+
+      std::map<int, ExecutionFrontier>::iterator f_it = m_internalFrontiers.find(object->getKey());
+      if(f_it != m_internalFrontiers.end())
+	f_it->second.handleRemoval(token);
+    }
+  }
+
+  void DbCore::handleConstrained(const ObjectId& object, const TokenId& predecessor, const TokenId& successor){
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
+    invalidateTokenSequence(object);
+    ExecutionFrontier* frontier = getFrontier(object);
+    if(frontier != NULL)
+      frontier->handleConstrained(predecessor, successor);
+  }
+
+  void DbCore::handleFreed(const ObjectId& object, const TokenId& predecessor, const TokenId& successor){
+    notePlanChange();
+    m_synchronizer.invalidateUnitCache();
+    invalidateTokenSequence(object);
+    ExecutionFrontier* frontier = getFrontier(object);
+    if(frontier != NULL){
+      frontier->handleRemoval(predecessor);
+      frontier->handleRemoval(successor);
     }
   }
 
+  ExecutionFrontier* DbCore::getFrontier(const ObjectId& object){
+    std::map<int, ExecutionFrontier>::iterator it = m_internalFrontiers.find(object->getKey());
+    if(it != m_internalFrontiers.end())
+      return &(it->second);
+
+    FlatMap<int, TimelineContainer>::iterator e_it = m_externalTimelineTable.find(object->getKey());
+    if(e_it != m_externalTimelineTable.end())
+      return &(e_it->second.getFrontier());
+
+    return NULL;
+  }
+
   void DbCore::handleCommitted(const TokenId& token){
     m_committedTokens.insert(token);
   }
@@ -2103,6 +3267,7 @@ namespace TREX {
   }
 
   void DbCore::handleRejected(const TokenId& token){
+    notePlanChange();
     TREXLog() << nameString() << "Rejected " << tokenToString(token) << std::endl;
     TREX_INFO("trex:warning", nameString() << tokenToString(token) << " was rejected.\n\n" <<
 	      "   If this is a surprise, then you need to enable planner debug messages to investigate: \n" << 
@@ -2116,15 +3281,17 @@ namespace TREX {
    * Restrict base domain for all but the end time. That can only be restricted by the current tick. All others
    * can be restricted because the past is monotonic.
    */
-  void DbCore::commitAndRestrict(const TokenId& token){
+  bool DbCore::commitAndRestrict(const TokenId& token){
     TREX_INFO("trex:debug:synchronization:commitAndRestrict", "Committing " << tokenToString(token));
 
     // Commit the token and touch the state variable to trigger commit event based propagation
     token->commit();
     token->getState()->touch();
 
-    // Propagate constraints before binding attribute base domains.
-    propagate();
+    // Propagate constraints before binding attribute base domains. On failure the domains are left alone, and
+    // the propagation of the caller reports the inconsistency
+    if(!propagate())
+      return true;
 
     token->getObject()->restrictBaseDomain(token->getObject()->lastDomain());
 
@@ -2138,9 +3305,13 @@ namespace TREX {
     // just up till the current tick, even if the lower bound of the current domain is more restrictive.
     if(token->end()->lastDomain().getUpperBound() < getCurrentTick()){
       token->end()->restrictBaseDomain(token->end()->lastDomain());
+      return false;
     }
-    else
-      token->end()->restrictBaseDomain(IntervalIntDomain(getCurrentTick(), PLUS_INFINITY));
+
+    // Only this restriction may tighten the current domain
+    bool tightened = token->end()->lastDomain().getLowerBound() < getCurrentTick();
+    token->end()->restrictBaseDomain(IntervalIntDomain(getCurrentTick(), PLUS_INFINITY));
+    return tightened;
   }
 
   /**
@@ -2228,9 +3399,9 @@ namespace TREX {
       logTimeLine(intit->first, "internal");
 
     // Externals
-    std::map<int, TimelineContainer>::const_iterator 
+    FlatMap<int, TimelineContainer>::const_iterator 
       cextit = m_externalTimelineTable.begin();
-    std::map<int, TimelineContainer>::const_iterator const
+    FlatMap<int, TimelineContainer>::const_iterator const
       endcext = m_externalTimelineTable.end();
     
     for( ; endcext!=cextit; ++cextit )
@@ -2367,28 +3538,45 @@ namespace TREX {
   }
 
 
+  /**
+   * @brief Orders a tick before the tokens that may start after it
+   */
+  struct LatestStartComparator {
+    bool operator()(TICK tick, const TokenId& token) const {
+      return tick < (TICK) token->start()->lastDomain().getUpperBound();
+    }
+  };
+
   TokenId DbCore::getValue(const TimelineId& timeline, TICK tick){
-    TokenId v;
+    const std::vector<TokenId>& tokens = getTokenSequence(timeline);
 
-    const std::list<TokenId>& tokenSequence = timeline->getTokenSequence();
-    for(std::list<TokenId>::const_iterator it = tokenSequence.begin(); it != tokenSequence.end(); ++it){
-      TokenId token = *it;
-      checkError(token.isValid(), token);
-      TICK latestStart = (TICK) token->start()->lastDomain().getUpperBound();
-      TICK latestEnd = (TICK) token->end()->lastDomain().getUpperBound();
+    // The value is the last token that starts at the latest on tick, unless it ends before. Earlier tokens end before it.
+    std::vector<TokenId>::const_iterator it = std::upper_bound(tokens.begin(), tokens.end(), tick, LatestStartComparator());
+    if(it == tokens.begin())
+      return TokenId::noId();
 
-      // If we find a token in the future then we are done
-      if(latestStart > tick)
-	break;
+    TokenId token = *(--it);
+    checkError(token.isValid(), token);
+    if((TICK) token->end()->lastDomain().getUpperBound() < tick)
+      return TokenId::noId();
 
-      // If it is in the past move on
-      if(latestEnd < tick)
-	continue;
+    return token;
+  }
 
-      v = token;
+  const std::vector<TokenId>& DbCore::getTokenSequence(const TimelineId& timeline){
+    SequenceIndex& index = m_sequenceIndexes[timeline->getKey()];
+    if(!index.valid){
+      const std::list<TokenId>& tokenSequence = timeline->getTokenSequence();
+      index.tokens.assign(tokenSequence.begin(), tokenSequence.end());
+      index.valid = true;
     }
+    return index.tokens;
+  }
 
-    return v;
+  void DbCore::invalidateTokenSequence(const ObjectId& object){
+    FlatMap<int, SequenceIndex>::iterator it = m_sequenceIndexes.find(object->getKey());
+    if(it != m_sequenceIndexes.end())
+      it->second.valid = false;
   }
 
   bool DbCore::isSolverTimedOut() {
@@ -2424,6 +3612,34 @@ namespace TREX {
     return false;
   }
 
+  void DbCore::addFailure(const FailureRecord& failure){
+    m_failures.push_back(failure);
+    if(m_failures.size() > MAX_FAILURE_RECORDS)
+      m_failures.pop_front();
+
+    // Named as the conflict dumps, which take an attempt each
+    std::ostringstream oss;
+    oss << m_conflictPath << "/" << failure.tick << "." << Agent::instance()->getCurrentAttempt() << ".conflict";
+    m_failures.back().conflictFile = oss.str();
+    Agent::instance()->incrementAttempts();
+
+    if(m_analyst == NULL){
+      m_analyst = new FailureAnalyst();
+      m_analyst->start();
+    }
+    m_analyst->push(m_failures.back());
+  }
+
+  void DbCore::logFailures(){
+    if(m_analyst == NULL)
+      return;
+
+    std::vector<FailureRecord> analysed;
+    m_analyst->collect(analysed);
+    for(std::vector<FailureRecord>::const_iterator it = analysed.begin(); it != analysed.end(); ++it)
+      TREX_INFO("trex:monitor:conflicts", nameString() << it->render());
+  }
+
   void DbCore::markInvalid(const std::string& comment, const bool dump_state, const std::string& analysis) {
     // Recall dispatched goals if transitioning into this state
     if(m_state != DbCore::INVALID)
@@ -2463,7 +3679,7 @@ namespace TREX {
   /**
    * @brief Iterate over committed external tokens with a pending end time. These are the uncontrollable events of interest
    */
-  void DbCore::getActiveUncontrollableEvents(std::vector<TokenId>& results){
+  void DbCore::getActiveUncontrollableEvents(UncontrollableEvents& results){
     for(TokenSet::const_iterator it = m_committedTokens.begin(); it != m_committedTokens.end(); ++it){
       TokenId token = *it;
       checkError(token.isValid(), token);
@@ -2471,7 +3687,7 @@ namespace TREX {
       const AbstractDomain& endDom = token->end()->lastDomain();
       if(isExternal(token) && endDom.isMember(getCurrentTick()) && !endDom.isSingleton()){
 	TREX_INFO("DbCore:getActiveUncontrollableEvents", "Adding " << tokenToString(token));
-	results.push_back(token);
+	results[getObjectName(token)].push_back(token);
       }
     }
   }
@@ -2610,9 +3826,9 @@ namespace TREX {
       ss << std::endl << m_synchronizer.localContextForConstrainedVariable(predecessor->end());
     }
 
-    std::map<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.find(timeline->getKey());
+    FlatMap<int, TimelineContainer>::const_iterator it = m_externalTimelineTable.find(timeline->getKey());
     const TimelineContainer& tc = it->second;
-    const TokenSet& dispatched_tokens = tc.getDispatchedTokens();
+    const TimelineContainer::DispatchedTokens& dispatched_tokens = tc.getDispatchedTokens();
 
     if(dispatched_tokens.empty()){
       ss << std::endl << "No dispatched tokens buffered. Perhaps the dispatch window is configured incorrectly or else we are not planning ahead sufficiently to dispatch expected values.";
@@ -2625,8 +3841,8 @@ namespace TREX {
       ss << std::endl << std::endl;
     }
     else {
-      for(TokenSet::const_iterator it = dispatched_tokens.begin(); it != dispatched_tokens.end(); ++it){
-	TokenId token = *it;
+      for(TimelineContainer::DispatchedTokens::const_iterator it = dispatched_tokens.begin(); it != dispatched_tokens.end(); ++it){
+	TokenId token = it->second;
 	checkError(token.isValid(), token);
 	ss << "Dispatched " << tokenToString(token) << " start == " << token->start()->lastDomain().toString() << " && end == " <<  token->end()->lastDomain().toString() << std::endl;
       }
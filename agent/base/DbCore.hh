@@ -45,6 +45,11 @@
 #include "Synchronizer.hh"
 #include "LogManager.hh"
 #include "DbSolver.hh"
+#include "Checkpoint.hh"
+#include "TickArena.hh"
+#include "FlatTable.hh"
+#include <deque>
+#include <set>
 
 using namespace EUROPA;
 using namespace EUROPA::SOLVERS;
@@ -63,14 +68,132 @@ namespace TREX {
 
     std::ostream& getStream();
 
-    static void update(TICK start, TICK end);
-
-    static const IntervalIntDomain& getHorizon();
+    /**
+     * @brief Deliberation horizon of the reactor owning the given database. Outside of an agent, this is the
+     * horizon of the plain HorizonFilter.
+     */
+    static const IntervalIntDomain& getHorizon(const PlanDatabaseId& db);
 
   private:
+    /**
+     * @brief Verdict of test for a token, with the temporal scope and horizon it was computed for
+     */
+    struct Verdict {
+      double startLb, startUb, endLb, endUb, horizonLb, horizonUb;
+      bool excluded;
+
+      bool matches(const IntervalIntDomain& startTime, const IntervalIntDomain& endTime, const IntervalIntDomain& hor) const;
+    };
+
+    /**
+     * @brief Apply the horizon policy to a token. cacheable is cleared if the verdict depends on more than the token's
+     * temporal scope and the horizon.
+     */
+    bool evaluate(const EntityId& entity, const TokenId& token, bool& cacheable);
+
+    const IntervalIntDomain& horizon() const;
+
     DbCoreId m_core;
-    static IntervalIntDomain& horizon();
-    static TICK currentTick();
+    std::map<int, Verdict> m_verdicts; /*!< Verdicts by token key for the current tick */
+    TICK m_verdictTick;
+  };
+
+  /**
+   * @brief Execution frontier of a timeline. It records the position, in the token sequence, of the first token that still
+   * needs to be evaluated on every tick, so that per tick scans do not start over from the beginning of the plan.
+   * Tokens before the frontier are settled: committed and in the past for internal timelines, committed or dispatched for
+   * external timelines. The frontier is reset when a token which could precede it is inserted, or when the token at the frontier
+   * leaves the timeline.
+   *
+   * @see DbCore::notifyObservers, DbCore::dispatchCommands
+   */
+  class ExecutionFrontier {
+  public:
+    ExecutionFrontier();
+
+    /**
+     * @brief Where to start scanning the given token sequence.
+     */
+    std::list<TokenId>::const_iterator begin(const std::list<TokenId>& tokenSequence) const;
+
+    /**
+     * @brief Move the frontier. All the tokens before position are settled.
+     */
+    void moveTo(const std::list<TokenId>::const_iterator& position, const std::list<TokenId>& tokenSequence);
+
+    /**
+     * @brief Force a scan from the beginning of the sequence on next use.
+     */
+    void reset();
+
+    /**
+     * @brief Handle the insertion of tokens in the timeline sequence.
+     */
+    void handleConstrained(const TokenId& predecessor, const TokenId& successor);
+
+    /**
+     * @brief Handle a token leaving the timeline, by deactivation, removal or when it is freed.
+     */
+    void handleRemoval(const TokenId& token);
+
+  private:
+    /**
+     * @brief True if token is not settled and could be inserted before the frontier.
+     */
+    bool precedes(const TokenId& token) const;
+
+    bool m_valid; /*!< False if the sequence must be scanned from the start */
+    std::list<TokenId>::const_iterator m_position; /*!< The first token which is not settled */
+    TokenId m_token; /*!< The token at m_position. noId() when the frontier is at the end of the sequence */
+  };
+
+  /**
+   * @brief Link between goals and variables received from a client reactor and their local copies. Each reactor has its own
+   * table, indexed both ways so that neither direction requires a scan. Entity keys are never re-used so a stale entry can be
+   * detected from the keys alone. Entries are checked again the first time they are used after expire() starts a new
+   * generation, rather than by purging the whole table.
+   */
+  class ForeignKeyTable {
+  public:
+    ForeignKeyTable();
+
+    bool contains(const EntityId& foreign);
+
+    void insert(const EntityId& foreign, const EntityId& local);
+
+    void erase(const EntityId& foreign);
+
+    EntityId getLocal(const EntityId& foreign);
+
+    EntityId getForeign(const EntityId& local);
+
+    /**
+     * @brief To be called when entities may have been discarded. Starts a new generation and checks a bounded number of entries
+     * so that the entries which are never used again are still removed eventually.
+     */
+    void expire();
+
+  private:
+    struct Entry {
+      EntityId local;
+      int localKey;
+      unsigned int generation; /*!< Generation at which the entry was last checked */
+    };
+
+    typedef std::map<int, Entry> EntryMap;
+
+    /**
+     * @brief Check the entry if it is older than the current generation. Erases it if it is stale.
+     * @return true if the entry is still valid
+     */
+    bool validate(EntryMap::iterator& it);
+
+    void eraseEntry(EntryMap::iterator it);
+
+    EntryMap m_byForeign; /*!< Entries by foreign key */
+    std::map<int, int> m_byLocal; /*!< Foreign key by local key */
+    unsigned int m_generation;
+    int m_sweepKey; /*!< Foreign key at which the next sweep starts */
   };
 
   /**
@@ -83,6 +206,8 @@ namespace TREX {
    */
   class TimelineContainer {
   public:
+    typedef FlatMap<int, TokenId> DispatchedTokens; /*!< Tokens by key */
+
     TimelineContainer(const TimelineId& timeline);
 
     const TimelineId& getTimeline() const;
@@ -117,7 +242,7 @@ namespace TREX {
     /**
      * @brief Get the set of dispatched tokens still in memory
      */
-    const TokenSet& getDispatchedTokens() const;
+    const DispatchedTokens& getDispatchedTokens() const;
 
     /**
      * @brief Record that it has been dispatched
@@ -134,11 +259,17 @@ namespace TREX {
      */
     void handleRemoval(const TokenId& token);
 
+    /**
+     * @brief Accessor for the dispatch frontier. Tokens before it are committed or dispatched.
+     */
+    ExecutionFrontier& getFrontier();
+
   private:
-    const TimelineId m_timeline; /*!< Id for the timeline we buffer observations for */
+    TimelineId m_timeline; /*!< Id for the timeline we buffer observations for. Not const to be stored in a FlatMap */
     ServerId m_server;
     TICK m_lastObserved; /*!< Used to say how current the latest observation is. */
-    TokenSet m_dispatchedTokens; /*!< The set of buffered dispatches. Used to dispatch once only. */
+    DispatchedTokens m_dispatchedTokens; /*!< The set of buffered dispatches. Used to dispatch once only. */
+    ExecutionFrontier m_frontier; /*!< First token not yet committed or dispatched */
   };
 
   /**
@@ -201,6 +332,31 @@ namespace TREX {
        */
       void notifyTerminated(const TokenId& token);
 
+      /**
+       * @brief Handle insertion of a token in a timeline
+       */
+      void notifyConstrained(const ObjectId& object, const TokenId& predecessor, const TokenId& successor);
+
+      /**
+       * @brief Handle removal of an ordering in a timeline
+       */
+      void notifyFreed(const ObjectId& object, const TokenId& predecessor, const TokenId& successor);
+
+    private:
+
+      DbCore& m_dbCore;
+    };
+
+    /**
+     * @brief Follows the restrictions and relaxations of token variables for plan delta clients.
+     * @see getPlanDelta
+     */
+    class CeListener: public ConstraintEngineListener {
+    public:
+      CeListener(DbCore& dbCore);
+
+      void notifyChanged(const ConstrainedVariableId& variable, const DomainListener::ChangeType& changeType);
+
     private:
 
       DbCore& m_dbCore;
@@ -232,7 +388,40 @@ namespace TREX {
       std::vector<TimelineDescription> m_internalTimelines, m_actions, m_externalTimelines;
     };
 
+    /**
+     * @brief Changes to the plan description since a version received by a client
+     * @see getPlanDelta
+     */
+    class PlanDelta {
+    public:
+      friend class DbCore;
+
+      struct TokenUpdate {
+	LabelStr timeline;
+	PlanDescription::TokenDescription token;
+      };
+
+      void clear() {
+	m_updates.clear();
+	m_removed.clear();
+      }
+
+      /**
+       * @brief Write the delta in the format of reactor state deltas. A header row gives the version and whether the
+       * delta is full, then each update is a tab separated row and each removal a row starting with '-'.
+       */
+      void write(std::ostream& out) const;
+
+      TICK m_tick;
+      LabelStr m_reactorName;
+      unsigned int m_version; /*!< The version to pass to the next request */
+      bool m_full; /*!< If true, m_updates holds the whole plan and the client must drop the tokens it has */
+      std::vector<TokenUpdate> m_updates; /*!< Tokens added or whose bounds or predicate changed */
+      std::vector<int> m_removed; /*!< Keys of the tokens no longer reported */
+    };
+
     friend class DbListener;
+    friend class CeListener;
     friend class Synchronizer;
     friend class DeliberationFilter;
 
@@ -245,6 +434,16 @@ namespace TREX {
      */
     static DbCoreId getInstance(const TokenId& token);
 
+    /**
+     * @brief Accessor to retrieve the dbcore owning the given database, or noId if there is none.
+     */
+    static DbCoreId getInstance(const PlanDatabaseId& db);
+
+    /**
+     * @brief The horizon this reactor deliberates over. It is owned by each reactor so that solvers can run concurrently.
+     */
+    const IntervalIntDomain& getDeliberationHorizon() const {return m_horizon;}
+
     /**
      * @brief Test if the given toke is on a timeline that is in scope
      */
@@ -262,10 +461,23 @@ namespace TREX {
 
     void notify(const Observation& observations);
 
+    /**
+     * @brief Create the tokens of all the observations first, then bind them, sharing the client and the
+     * time bounds. Propagation is left to synchronization as for a single notify. Observations which only
+     * confirm the current value of their timeline extend it without creating a token.
+     * @see confirmCurrentValue
+     */
+    void notifyBatch(const std::vector<const Observation*>& observations);
+
     bool handleRequest(const TokenId& goal);
 
     void handleRecall(const TokenId& goal);
 
+    /**
+     * @brief Handle the recall of a batch of goals, invalidating the plan once for all of them.
+     */
+    void handleRecall(const std::vector<TokenId>& goals);
+
     void queryTimelineModes(std::list<LabelStr>& externals, std::list<LabelStr>& internals);
 
     /**
@@ -273,6 +485,14 @@ namespace TREX {
      */
     void getPlanDescription(PlanDescription &planDesc) const;
 
+    /**
+     * @brief Get the changes to the plan description since a version. The first call publishes the whole plan and starts
+     * following the database events. Later calls only visit the tokens added, removed or restricted since the previous one.
+     * @param version The m_version of the last delta received. 0 for a full description.
+     * @param delta Filled with the changes. It is a full description if the removals since version are no longer recorded.
+     */
+    void getPlanDelta(unsigned int version, PlanDelta& delta);
+
     /**
      * @brief Write a description of a conflict to disk.
      */
@@ -280,6 +500,14 @@ namespace TREX {
 
     /**
      * @brief Output the assembly to file at the current tick
+     *
+     * When the reactor is configured with stateKeyframe="N", only one dump in N is a full
+     * <tick>.<attempt>.reactorstate file. The others are <tick>.<attempt>.reactordelta files
+     * listing the tokens added or restricted since the previous dump, under the header of
+     * their timeline, followed by one "-\t<key>" line per token that disappeared.
+     * Dumps which export the assembly, as done for a conflict, are always full: they may
+     * follow the nominal dump of the same attempt, and a delta would replace the one it wrote.
+     * A full dump starts the next keyframe period.
      */
     std::string dumpState(bool export_assembly = false);
 
@@ -294,6 +522,52 @@ namespace TREX {
      */
     TokenId getValue(const TimelineId& timeline, TICK tick);
 
+    /**
+     * @brief Random access copy of the token sequence of a timeline, rebuilt when the sequence changes.
+     * @note The upper bounds of the start and end times do not decrease along the sequence, which allows binary searches by tick.
+     */
+    const std::vector<TokenId>& getTokenSequence(const TimelineId& timeline);
+
+    /**
+     * @brief Relax the database and resolve it again at the current tick, as done to repair a synchronization failure.
+     * @param discardCurrentValues If true, go straight to the stronger relaxation which discards current values.
+     * @return true if the database could be resolved
+     */
+    bool repair(bool discardCurrentValues);
+
+    /**
+     * @brief Accessor for the synchronization algorithm, mostly to get at its latencies.
+     */
+    const Synchronizer& getSynchronizer() const {return m_synchronizer;}
+
+    /**
+     * @brief Accessor for the solver used to plan goals
+     */
+    const DbSolverId& getSolver() const {return m_solver;}
+
+    /**
+     * @brief Number of planning cycles skipped with planCache="true" because the last complete plan was still current.
+     */
+    unsigned int getCachedCycles() const {return m_cachedCycles;}
+
+    /**
+     * @brief Number of tokens in the database.
+     */
+    unsigned int countTokens() const;
+
+    /**
+     * @brief Save the current value of each timeline, the pending goals loaded with the model, and the tick of the last
+     * observation of each external timeline.
+     */
+    void checkpoint(Checkpoint::Reactor& state);
+
+    /**
+     * @brief Rebuild the database from a checkpoint, just after initialization. Saved values replace the initial facts and
+     * become true at the current tick for external timelines. Goals of the model which were no longer pending are discarded.
+     * Requests from other reactors are not saved: they are dispatched again once their clients have planned.
+     */
+    void restore(const Checkpoint::Reactor& state);
+
   protected:
     /**
      * @brief Used to hook up observer for dispatch of observations and servers for dispatch of goals
@@ -310,6 +584,16 @@ namespace TREX {
      */
     virtual bool synchronize();
 
+    /**
+     * @brief Count the tokens, variables and constraints of the plan database
+     */
+    void measureMemory(MemoryUsage& usage) const;
+
+    /**
+     * @brief Adds the solver counts and the length of the token buffers
+     */
+    void writeTelemetry(TelemetrySample& out) const;
+
     /**
      * @brief Return true if there are flaws to resolve
      */
@@ -340,6 +624,22 @@ namespace TREX {
 	const bool dump_state=false,
 	const std::string& analysis = std::string(""));
 
+    /**
+     * @brief Keep the record of a synchronization failure and queue it for the FailureAnalyst, which writes its
+     * conflict file. Only the latest MAX_FAILURE_RECORDS records are kept.
+     */
+    void addFailure(const FailureRecord& failure);
+
+    /**
+     * @brief The latest synchronization failures, oldest first, as captured. Their analysis is done by the FailureAnalyst.
+     */
+    const std::deque<FailureRecord>& getFailures() const {return m_failures;}
+
+    /**
+     * @brief Log the failures analysed since the last call to the trex:monitor:conflicts messages. It does not analyse.
+     */
+    void logFailures();
+
     /**
      * @brief Accessor to goal set
      */
@@ -359,9 +659,30 @@ namespace TREX {
 
     /**
      * @brief Archive the database.
+     *
+     * At most archiveBatch committed tokens are evaluated per call, earliest end first. Terminated tokens are
+     * discarded and garbage collected once there are more than gcThreshold of them. Over budget, all committed
+     * tokens are evaluated and the terminated ones are collected at once.
      */
     void archive();
 
+    /**
+     * @brief Write the tokens which ended more than historyWindow ticks ago to the history file and discard the
+     * terminated ones. The committed tokens which cannot be terminated yet stay in the database. Done every
+     * historyWindow ticks so that the file index grows with the mission length divided by the window.
+     */
+    void spillHistory();
+
+    /**
+     * @brief Write the tokens to the history file, except those already written.
+     */
+    void writeHistory(const TokenSet& tokens);
+
+    /**
+     * @brief True if the last measure exceeds tokenBudget or entityBudget. Budgets of 0 are not enforced.
+     */
+    bool isOverBudget() const;
+
     /**
      * @brief Dispatch observations to other components
      */
@@ -372,6 +693,13 @@ namespace TREX {
      */
     void dispatchCommands();
 
+    /**
+     * @brief Propagate once and send the dispatchable tokens to their servers, one batch per server
+     * @param dispatchable The tokens to dispatch, in timeline order
+     * @param containers The timeline container of each dispatchable token
+     */
+    void dispatchBatches(const TickVector<TokenId>::type& dispatchable, const TickVector<TimelineContainer*>::type& containers);
+
     /**
      * @brief Recall dispatched commands. Invoked when the plan fails.
      */
@@ -387,6 +715,17 @@ namespace TREX {
      */
     bool extendCurrentValue(const TokenId& token);
 
+    /**
+     * @brief Restrictions applied to extend the current value, without propagation.
+     */
+    void restrictExtension(const TokenId& token);
+
+    /**
+     * @brief Extend the current value of the timeline of an observation if the observation is identical to it.
+     * @return true if extended. No token is needed for the observation then.
+     */
+    bool confirmCurrentValue(const Observation& observation);
+
     /**
      * @brief Helper method to handle constraint migration when receiving a goal
      * @see handleRequest
@@ -425,30 +764,69 @@ namespace TREX {
      */
     void removeFromTokenAgenda(const TokenId& token);
 
-    /** Handle foreign/local keys. Can be static as there should only be one server per timeline **/
-    static bool hasEntity(const EntityId& foreign);
+    /** Handle foreign/local keys for the goals posted to this reactor **/
+    bool hasEntity(const EntityId& foreign);
 
-    static void addEntity(const EntityId& foreign, const EntityId& local);
+    void addEntity(const EntityId& foreign, const EntityId& local);
 
-    static void removeEntity(const EntityId& foreign);
+    void removeEntity(const EntityId& foreign);
 
-    static EntityId getLocalEntity(const EntityId& foreign);
+    EntityId getLocalEntity(const EntityId& foreign);
 
-    static EntityId getForeignEntity(const EntityId& local);
+    EntityId getForeignEntity(const EntityId& local);
 
     /**
-     * @brief To prevent memory growth due to lost entries we provide a way to purge
-     * entries whose keys no longer map to entities.
+     * @brief To prevent memory growth due to lost entries we provide a way to drop
+     * entries whose keys no longer map to entities. Stale entries are dropped lazily.
+     * @see ForeignKeyTable::expire
      */
-    static void purgeOrphanedKeys();
+    void purgeOrphanedKeys();
 
-    static std::map<int, EntityId> s_foreignKeyRelation; /*!< Link by key for copied token when dispatching goals */
+    ForeignKeyTable m_foreignKeys; /*!< Link by key for copied token when dispatching goals */
 
     /**
      * @brief Utility to dactive the main solver when done with it.
      */
     bool deactivateSolver();
 
+    /**
+     * @brief Keep the structure of a complete plan, to reuse it on the next repair.
+     * @see applyPlanHint
+     */
+    void recordPlanHint();
+
+    /**
+     * @brief Record a change to the plan which may open a new flaw: a new token, a token leaving its
+     * timeline or a change of order on a timeline. Removals do not open flaws and are not counted.
+     */
+    void notePlanChange() {m_planChanges++;}
+
+    /**
+     * @brief Tests if the last complete plan is still complete, with no need for a new planning cycle. This is
+     * the case when only the clock moved since: no change was noted, no token entered the horizon and no condition
+     * is pending, since the clock alone may bring one into scope.
+     */
+    bool isPlanCurrent() const;
+
+    /**
+     * @brief Reuse the last complete plan after a repair. Inactive tokens which were part of it are activated and
+     * inserted on their timeline in the same order, before the solver plans the rest. Tokens which can no longer be
+     * inserted that way are left to the solver.
+     * @return The number of tokens restored
+     */
+    unsigned int applyPlanHint();
+
+    /**
+     * @brief Activate and insert a token of the plan hint after the given predecessor, or first if there is none.
+     * @return false if it was not consistent, in which case the token is inactive again.
+     */
+    bool restoreToken(const TimelineId& timeline, const TokenId& token, const TokenId& predecessor);
+
+    /**
+     * @brief Undo applyPlanHint, when the solver could not complete the plan from it.
+     */
+    void retractPlanHint();
+
     /**
      * @brief Utility for construction
      */
@@ -498,9 +876,23 @@ namespace TREX {
 
     /**
      * @brief Integrity check utility. Only use in debug mode, and only use for check errors.
+     *
+     * When a validationPeriod is given in the reactor configuration, only the tokens created since the last
+     * check are validated, and the full scan of all entities is done at most once every validationPeriod ticks.
+     * Otherwise every entity is validated on each call.
      */
     bool isValidDb() const;
 
+    /**
+     * @brief Validate all live entities
+     */
+    bool isValidEntities() const;
+
+    /**
+     * @brief Validate the tokens created since the last check, and their variables
+     */
+    bool isValidNewTokens() const;
+
     bool isGoal(const TokenId& tok) const;
 
     bool isObservation(const TokenId& tok) const;
@@ -536,6 +928,32 @@ namespace TREX {
     void handleRejected(const TokenId& token);
     void handleTerminated(const TokenId& token);
 
+    /**
+     * @brief Record a token whose published description may have changed. A NOP until plan deltas are requested.
+     */
+    void markPublished(const TokenId& token) {
+      if(m_ceListener != NULL)
+	m_dirtyTokens.insert(token->getKey());
+    }
+
+    /**
+     * @brief CeListener handler. Marks the token of a changed timeline, start or end variable.
+     */
+    void handleChanged(const ConstrainedVariableId& variable);
+    void handleConstrained(const ObjectId& object, const TokenId& predecessor, const TokenId& successor);
+    void handleFreed(const ObjectId& object, const TokenId& predecessor, const TokenId& successor);
+
+    /**
+     * @brief Retrieve the execution frontier of a timeline
+     * @return The frontier if object is an internal or external timeline of this reactor, NULL otherwise
+     */
+    ExecutionFrontier* getFrontier(const ObjectId& object);
+
+    /**
+     * @brief Mark the token sequence copy of a timeline out of date
+     */
+    void invalidateTokenSequence(const ObjectId& object);
+
     /**
      * @brief Utility to migrate constraints from one token to another
      */
@@ -547,10 +965,21 @@ namespace TREX {
      */
     bool supportedByObservation(const TokenId& tok);
 
+    /**
+     * @brief Active uncontrollable events grouped by the name of their object
+     */
+    typedef std::map<double, std::vector<TokenId> > UncontrollableEvents;
+
     /**
      * @brief Utility to check if an action has active actions that must finish before it starts
      */
-    bool hasPendingPredecessors(const TokenId& c, const std::vector<TokenId>& uncontrollables, bool requireDifferentObject = false);
+    bool hasPendingPredecessors(const TokenId& c, const UncontrollableEvents& uncontrollables, bool requireDifferentObject = false);
+
+    /**
+     * @brief Temporal distance from u to c. Results are kept until the temporal network changes.
+     * @see m_distances
+     */
+    const IntervalIntDomain& getTemporalDistance(const ConstrainedVariableId& u, const ConstrainedVariableId& c);
 
     /**
      * @brief Test if the token is internal
@@ -573,16 +1002,27 @@ namespace TREX {
     void applyFacts(const std::vector<TokenId>& facts);
 
     /**
-     * @brief Process buffered goal keys that have been recalled.
+     * @brief Discard the goals that have been recalled. Their memory is reclaimed by the garbage collection of archive.
      * @return true if a recall was made
      * @see Synchronize
      */
     bool processRecalls();
 
+    /**
+     * @brief Buffer the local goal of a recalled token for processRecalls and forget its foreign keys
+     */
+    void bufferRecall(const TokenId& goal);
+
     /**
      * @brief Utility to cmmit a token and restrict its base domains based on current time. Will propagate as it goes.
+     * @return true if the final restrictions changed domains which are not propagated yet, or if propagation failed
+     */
+    bool commitAndRestrict(const TokenId& token);
+
+    /**
+     * @brief Propagate during publication of observations. Throws with the given message if inconsistent.
      */
-    void commitAndRestrict(const TokenId& token);
+    void publishingPropagate(const std::string& message);
 
     /**
      * @brief Utility to restrict all parameter base domains of a token
@@ -601,7 +1041,7 @@ namespace TREX {
 
     void bufferObservation(const TokenId& token);
 
-    void getActiveUncontrollableEvents(std::vector<TokenId>& results);
+    void getActiveUncontrollableEvents(UncontrollableEvents& results);
 
     /**
      * @brief Utility to evaluate the scope for new tokens and buffer as appropriate
@@ -644,7 +1084,21 @@ namespace TREX {
 
     std::vector< std::pair<TimelineId, TICK> > m_internalTimelineTable; /*!< Internal Timelines */
 
-    std::map< int, TimelineContainer > m_externalTimelineTable; /*!< Logs arrival of observations per external timeline. 
+    std::map< int, ExecutionFrontier > m_internalFrontiers; /*!< Publication frontier of each internal timeline, by key */
+
+    /**
+     * @brief Token sequence copy of a timeline
+     */
+    struct SequenceIndex {
+      SequenceIndex(): valid(false) {}
+
+      bool valid; /*!< False if the sequence changed since the copy */
+      std::vector<TokenId> tokens;
+    };
+
+    FlatMap<int, SequenceIndex> m_sequenceIndexes; /*!< Token sequence copies by timeline key. See getTokenSequence */
+
+    FlatMap<int, TimelineContainer> m_externalTimelineTable; /*!< Logs arrival of observations per external timeline. 
 								  Should be garbage collected when we archive */
 
     TokenSet m_goals; /*!< Store all goals */
@@ -663,9 +1117,9 @@ namespace TREX {
 
     std::list<LabelStr> m_internalLabels, m_externalLabels;
 
-    std::set<int> m_notificationKeys; /*!< Buffer for notifications published */
+    FlatSet<int> m_notificationKeys; /*!< Buffer for notifications published */
 
-    std::vector<int> m_recallBuffer; /*!< Buffer goal keys for cleanup */
+    TokenSet m_recalledGoals; /*!< Local goals to discard on the next repair. Goals removed meanwhile leave it in handleRemoval */
 
     std::map<int, bool> m_tokenScope; /*!< Ignored token status. See 'inScope' which is used as a workaround for lack of selectivity in rules engine. */
 
@@ -685,6 +1139,10 @@ namespace TREX {
     static const bool REJECTABLE = true;
     static const bool NOT_REJECTABLE = false;
 
+    /**
+     * @brief Cores by database. Only written by the agent thread when a core is built or deleted, while no other
+     * thread works on the reactors, so lookups need no lock.
+     */
     static std::map<PlanDatabaseId, DbCoreId>& instancesByDb();
 
     static bool verifyEntities();    
@@ -695,10 +1153,30 @@ namespace TREX {
 
     void fillTimelineDescription(const TimelineId tl, PlanDescription::TimelineDescription &tlDesc) const;
 
+    /**
+     * @brief Compare the marked tokens to the published ones and record the changes under a new version. The first
+     * call publishes every token and creates the CeListener.
+     */
+    void publishPlan();
+
+    /**
+     * @brief Publish a token, or its removal if it is no longer active on a timeline of this reactor
+     */
+    void publishToken(int key, unsigned int version, bool& changed);
+    void publishToken(const TokenId& tok, const TimelineId& tl, unsigned int version, bool& changed);
+
+    /**
+     * @brief Append the changes since the last write to the plan deltas file, if the planDeltas attribute is set
+     */
+    void writePlanDelta();
+
     /**
      * @brief Write a lightweight timeline description to disk. Used by writeDbstate 
+     * @param rows Filled with the row of each active token, by key.
+     * @param delta If true, only the rows which differ from the previous dump are written
      */
-    void writeTimeline(const TimelineId tl, const char mode, std::ofstream &db_out) const;
+    void writeTimeline(const TimelineId tl, const char mode, std::ostream &db_out,
+		       std::map<int, std::string> &rows, bool delta) const;
     
     static std::ostream &writeDomain(std::ostream &out,
 				     AbstractDomain const &dom,
@@ -706,8 +1184,63 @@ namespace TREX {
 
     std::string m_statePath;
     std::string m_conflictPath;
+    const unsigned int m_stateKeyframe; /*!< Dumps between full reactor states. 0 for a full dump on each call */
+    unsigned int m_stateDumps; /*!< Number of reactor state dumps so far */
+    std::map<int, std::string> m_dumpedRows; /*!< Token rows of the previous dump, by key */
     std::ofstream m_planLog;
     unsigned int m_lastRecalled;
+
+    const unsigned int m_validationPeriod; /*!< Ticks between full database checks. 0 for a full check on each call */
+    mutable TICK m_nextFullValidation; /*!< Tick from which the next check is a full one */
+    mutable TokenSet m_unvalidatedTokens; /*!< Tokens created since the last check */
+
+    const unsigned int m_archiveBatch; /*!< Max number of committed tokens evaluated per archive. 0 for no limit */
+    const unsigned int m_gcThreshold; /*!< Number of terminated tokens to exceed before garbage collection */
+    const unsigned int m_tokenBudget; /*!< Soft limit on the number of tokens. 0 for no limit */
+    const unsigned int m_entityBudget; /*!< Soft limit on the tokens, variables and constraints together. 0 for no limit */
+    BinaryObservationWriter* m_history; /*!< Terminated tokens spilled out of the database. NULL unless historyWindow is set */
+    const unsigned int m_historyWindow; /*!< Ticks a terminated token is kept in the database when its history is spilled */
+    TICK m_lastSpill; /*!< Tick of the last spill of the history */
+    int m_historyTick; /*!< Last tick written to the history file */
+    TokenSet m_historyWritten; /*!< Tokens of the database already in the history file */
+    unsigned long m_spilledTokens; /*!< Number of tokens written to the history file */
+
+    const bool m_planReuse; /*!< If true, the last complete plan is reused after a repair */
+    const double m_resumeBudget; /*!< Share of the time left to the tick that a resume may spend on search steps */
+    const bool m_planCache; /*!< If true, planning cycles are skipped while the last plan is current */
+    unsigned int m_planChanges; /*!< Number of changes noted by notePlanChange */
+    unsigned int m_plannedChanges; /*!< m_planChanges as of the last complete plan */
+    int m_plannedHorizonEnd; /*!< End of the horizon of the last complete plan */
+    unsigned int m_cachedCycles; /*!< Number of planning cycles skipped by the plan cache */
+    PlanDescription m_planHint; /*!< The last complete plan */
+    bool m_hintPending; /*!< True from a repair until the plan hint has been applied */
+    std::vector<int> m_hintedTokens; /*!< Keys of the tokens restored from the plan hint */
+    IntervalIntDomain m_horizon; /*!< Deliberation horizon, set by setHorizon() */
+
+    /**
+     * @brief A token as last published to plan delta clients
+     */
+    struct PublishedToken {
+      LabelStr timeline;
+      PlanDescription::TokenDescription token;
+      unsigned int version; /*!< Plan version of the last change */
+    };
+
+    static const unsigned int MAX_PUBLISHED_REMOVALS = 4096; /*!< Older removals need a full delta */
+    static const unsigned int MAX_FAILURE_RECORDS = 16;
+
+    std::deque<FailureRecord> m_failures; /*!< The latest synchronization failures */
+    FailureAnalyst* m_analyst; /*!< Started by the first failure. NULL until then */
+
+    FlatMap<int, PublishedToken> m_publishedTokens; /*!< Published tokens by key */
+    std::deque< std::pair<unsigned int, int> > m_publishedRemovals; /*!< Version and key of removed tokens, oldest first */
+    unsigned int m_planVersion; /*!< Version of the last published change */
+    unsigned int m_removalFloor; /*!< Clients below this version missed removals and need a full delta */
+    CeListener* m_ceListener; /*!< Created by the first publication. NULL until plan deltas are requested */
+    std::set<int> m_dirtyTokens; /*!< Keys of the tokens changed since the last publication */
+    std::ofstream* m_planDeltas; /*!< Plan deltas pushed after each synchronization. NULL unless planDeltas is set */
+    unsigned int m_writtenVersion; /*!< Plan version of the last delta written to m_planDeltas */
+    std::map< std::pair<int, int>, IntervalIntDomain > m_distances; /*!< Temporal distances by variable keys. Cleared on propagation */
   };
 }
 
@@ -38,11 +38,21 @@
 #include "Token.hh"
 #include "Context.hh"
 #include "FlawFilter.hh"
+#include "ClockStat.hh"
+#include "Utilities.hh"
 
 namespace TREX {
   
-  DbSolver::DbSolver(const PlanDatabaseId& db, TiXmlElement* solverCfg): m_db(db) {
-    if (!solverCfg->Attribute("composite")) {
+  DbSolver::DbSolver(const PlanDatabaseId& db, TiXmlElement* solverCfg)
+    : m_db(db),
+      m_roundRobin(solverCfg->Attribute("roundRobin") != NULL && strcmp(solverCfg->Attribute("roundRobin"), "true") == 0),
+      m_roundRobinSteps(solverCfg->Attribute("roundRobinSteps") == NULL ? 100 : atoi(solverCfg->Attribute("roundRobinSteps"))),
+      m_roundRobinMaxSteps(solverCfg->Attribute("roundRobinMaxSteps") == NULL ? 64 * m_roundRobinSteps : atoi(solverCfg->Attribute("roundRobinMaxSteps"))),
+      m_active(0), m_leader(0), m_budget(0), m_spent(0), m_exhausted(0), m_stepCost(0.0) {
+    ConfigurationException::configurationCheckError(!m_roundRobin || m_roundRobinSteps > 0, "roundRobinSteps must be positive.");
+    ConfigurationException::configurationCheckError(!m_roundRobin || m_roundRobinMaxSteps >= m_roundRobinSteps,
+						    "roundRobinMaxSteps must be at least roundRobinSteps.");
+    if (!solverCfg->Attribute("composite") && !m_roundRobin) {
       AbstractSolverId solver = (new EuropaSolverAdapter(*solverCfg))->getId();
       solver->init(db, solverCfg);
       m_solvers.push_back(solver);
@@ -55,6 +65,9 @@ namespace TREX {
 	m_solvers.push_back(solver);
       }
     }
+
+    ConfigurationException::configurationCheckError(!m_roundRobin || !m_solvers.empty(), "A round robin solver needs at least one member.");
+    m_budget = m_roundRobinSteps;
   }
 
   DbSolver::~DbSolver() {
@@ -64,6 +77,10 @@ namespace TREX {
 
 
   bool DbSolver::isExhausted() {
+    // Only when every member in a row ran out of options. An incomplete one may give up where another one would not.
+    if (m_roundRobin)
+      return m_exhausted == m_solvers.size();
+
     for (std::vector<AbstractSolverId>::iterator it = m_solvers.begin(); 
 	 it != m_solvers.end(); it++) {
       AbstractSolverId solver = *it;
@@ -75,6 +92,9 @@ namespace TREX {
   }
 
   unsigned int DbSolver::getDepth() {
+    if (m_roundRobin)
+      return m_solvers[m_active]->getDepth();
+
     unsigned int ans = 0;
     for (std::vector<AbstractSolverId>::iterator it = m_solvers.begin(); 
 	 it != m_solvers.end(); it++) {
@@ -93,7 +113,35 @@ namespace TREX {
     return ans;
   }
   
+  /**
+   * @brief The average weighs the last step by a quarter : it follows the search getting deeper yet
+   * smooths out the odd slow step.
+   */
   void DbSolver::step() {
+    long long start = ClockStat::now(ClockStat::monotonic);
+    doStep();
+    double seconds = (ClockStat::now(ClockStat::monotonic) - start) / 1e9;
+    m_stepCost = (m_stepCost == 0.0 ? seconds : 0.75 * m_stepCost + 0.25 * seconds);
+  }
+
+  void DbSolver::doStep() {
+    if (m_roundRobin) {
+      if (m_solvers[m_active]->isExhausted()) {
+	if (++m_exhausted < m_solvers.size())
+	  rotate();
+      }
+      else if (m_spent >= m_budget) {
+	m_exhausted = 0;
+	rotate();
+      }
+
+      if (m_exhausted < m_solvers.size()) {
+	m_spent++;
+	m_solvers[m_active]->step();
+      }
+      return;
+    }
+
     for (std::vector<AbstractSolverId>::iterator it = m_solvers.begin(); 
 	 it != m_solvers.end(); it++) {
       AbstractSolverId solver = *it;
@@ -105,6 +153,9 @@ namespace TREX {
   }
 
   bool DbSolver::noMoreFlaws() {
+    if (m_roundRobin)
+      return m_solvers[m_active]->noMoreFlaws();
+
     for (std::vector<AbstractSolverId>::iterator it = m_solvers.begin(); 
 	 it != m_solvers.end(); it++) {
       AbstractSolverId solver = *it;
@@ -121,6 +172,7 @@ namespace TREX {
       AbstractSolverId solver = *it;
       solver->clear();
     }
+    restartRoundRobin();
   }
 
   void DbSolver::reset() {
@@ -129,6 +181,32 @@ namespace TREX {
       AbstractSolverId solver = *it;
       solver->reset();
     }
+    restartRoundRobin();
+  }
+
+  void DbSolver::rotate() {
+    m_solvers[m_active]->reset();
+    m_active = (m_active + 1) % m_solvers.size();
+    m_spent = 0;
+
+    // A full round went by without a plan: give every member more room
+    if (m_active == m_leader)
+      m_budget = nextBudget(m_budget, m_roundRobinMaxSteps);
+
+    debugMsg("DbSolver:roundRobin", "Switching to " << m_solvers[m_active]->getName().toString() << " with a budget of " << m_budget << " steps");
+  }
+
+  unsigned int DbSolver::nextBudget(unsigned int budget, unsigned int maxBudget) {
+    // Compared before doubling so that it cannot wrap around
+    return (budget > maxBudget / 2 ? maxBudget : 2 * budget);
+  }
+
+  void DbSolver::restartRoundRobin() {
+    // The active member is the one which completed the last plan, if any: it keeps the lead
+    m_leader = m_active;
+    m_budget = m_roundRobinSteps;
+    m_spent = 0;
+    m_exhausted = 0;
   }
 
   bool DbSolver::inDeliberation(const EntityId& entity) const{
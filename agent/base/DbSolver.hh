@@ -57,6 +57,15 @@ namespace TREX {
    * chronological backtracking solver (from EUROPA) can be composed with
    * an TSP solver. This provides and extensible interface for implementing
    * different planning algorithims.
+   *
+   * With roundRobin="true" the children are alternative configurations of the
+   * whole search rather than parts of it. They take turns on the one plan
+   * database, nothing runs in parallel: a member searches for at most
+   * roundRobinSteps steps, then has its decisions retracted and the next one
+   * takes over. A member which exhausts its search space hands over early. The
+   * budget doubles after each full round up to roundRobinMaxSteps, 64 times
+   * roundRobinSteps by default. The member which completes the plan leads the
+   * next deliberation.
    */
   class DbSolver {
   public:
@@ -73,9 +82,19 @@ namespace TREX {
      */
     bool isExhausted();
     /**
-     * @brief Iterates through the solvers and steps each of them.
+     * @brief Iterates through the solvers and steps each of them. The wall clock time of the step
+     * is measured to predict the cost of the next ones.
      */
     void step();
+    /**
+     * @brief Running average of the wall clock time of a step, in seconds
+     */
+    double getStepCost() const {return m_stepCost;}
+    /**
+     * @brief Tests if another step is expected to complete within the given time
+     * @param budget The time available, in seconds
+     */
+    bool fits(double budget) const {return m_stepCost < budget;}
     /**
      * @brief The size of the search stack
      */
@@ -101,10 +120,42 @@ namespace TREX {
      * @brief Test if the given entity is in deliberation
      */
     bool inDeliberation(const EntityId& entity) const;
+    /**
+     * @brief Step budget of the active round robin member
+     */
+    unsigned int getBudget() const {return m_budget;}
+    /**
+     * @brief The budget of the round after a full one: twice the current one, up to maxBudget.
+     */
+    static unsigned int nextBudget(unsigned int budget, unsigned int maxBudget);
 
   private:
+    /**
+     * @brief The step itself, without the timing
+     */
+    void doStep();
+
+    /**
+     * @brief Retract the decisions of the active round robin member and hand the search to the next one.
+     */
+    void rotate();
+
+    /**
+     * @brief Restart the round robin from its leading member with the initial step budget.
+     */
+    void restartRoundRobin();
+
     const PlanDatabaseId m_db;
     std::vector<AbstractSolverId> m_solvers; /*! The list of solvers. */
+    const bool m_roundRobin; /*!< Children are alternatives taking turns on the database */
+    const unsigned int m_roundRobinSteps; /*!< Initial step budget of each member */
+    const unsigned int m_roundRobinMaxSteps; /*!< Largest step budget of a member */
+    unsigned int m_active; /*!< Index of the member currently searching */
+    unsigned int m_leader; /*!< Index of the member which started the round */
+    unsigned int m_budget; /*!< Step budget of the current round */
+    unsigned int m_spent; /*!< Steps the active member used from its budget */
+    unsigned int m_exhausted; /*!< Consecutive members which exhausted their search space */
+    double m_stepCost; /*!< Exponential moving average of the step times, in seconds */
   };  
 
   /**
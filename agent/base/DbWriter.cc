@@ -37,6 +37,8 @@
 #endif
 
 #include "DbWriter.hh"
+#include "Guardian.hh"
+#include "TickTrace.hh"
 
 #include "Constraint.hh"
 #include "ConstraintEngine.hh"
@@ -178,6 +180,30 @@ namespace TREX {
 
   const std::string configSections[] = {GENERAL_CONFIG_SECTION, RULE_CONFIG_SECTION};
 
+  enum stepFiles {F_PARTIAL_PLAN = 0, F_OBJECTS, F_TOKENS, F_RULE_INSTANCES, F_RULE_INSTANCE_SLAVE_MAP,
+		  F_VARIABLES, F_CONSTRAINTS, F_CONSTRAINT_VAR_MAP, F_INSTANTS, F_DECISIONS, F_COUNT};
+
+  const std::string STEP_FILES[F_COUNT] =
+    {PARTIAL_PLAN, OBJECTS, TOKENS, RULE_INSTANCES, RULE_INSTANCE_SLAVE_MAP, VARIABLES, CONSTRAINTS,
+     CONSTRAINT_VAR_MAP, INSTANTS, DECISIONS};
+
+  /**
+   * @brief The thread writing the queued steps of a DbWriter
+   */
+  class DbWriter::Writer: public Thread {
+  public:
+    Writer(DbWriter& owner): m_owner(owner) {}
+    ~Writer() {}
+
+  private:
+    void *run() {
+      m_owner.drain();
+      return NULL;
+    }
+
+    DbWriter& m_owner;
+  };
+
 #ifdef __BEOS__
 #define NBBY 8
   static char *realpath(const char *path, char *resolved_path) {
@@ -212,7 +238,11 @@ namespace TREX {
       reId(re), 
       stepCount(0),
       destAlreadyInitialized(false), 
-      m_writing(false){
+      m_writing(false),
+      m_writer(NULL),
+      m_lock(Mutex::inheritProtocol),
+      m_maxPending(0),
+      m_stop(false){
     //add default directories to search for model files
     sourcePaths.push_back("");
     sourcePaths.push_back(".");
@@ -227,6 +257,16 @@ namespace TREX {
   }
 
   DbWriter::~DbWriter(void) {
+    if(m_writer != NULL) {
+      {
+	Guardian<Mutex> guard(m_lock);
+	m_stop = true;
+	m_pendingCond.broadcast();
+      }
+      // The writer only exits once all the pending steps are on disk
+      m_writer->join();
+      delete m_writer;
+    }
     if(destAlreadyInitialized) {
       statsOut->close();
       delete statsOut;
@@ -247,10 +287,12 @@ namespace TREX {
     collectStats();
     debugMsg("DbWriter:writeStats", "Writing statistics numTokens: " << numTokens 
 	     << " numVariables: " << numVariables << " numConstraints: " << numConstraints);
-    (*statsOut) << seqId << TAB << ppId << TAB << stepCount << TAB << numTokens << TAB << numVariables
-		<< TAB << numConstraints << std::endl;
-    statsOut->flush();
-
+    std::ostringstream statsRow;
+    statsRow << seqId << TAB << ppId << TAB << stepCount << TAB << numTokens << TAB << numVariables
+	     << TAB << numConstraints << std::endl;
+    Step* step = new Step;
+    step->stats = statsRow.str();
+    push(step);
   }
 
 
@@ -267,7 +309,7 @@ namespace TREX {
   }
 
   void DbWriter::outputObject(const ObjectId &objId, const int type,
-			      std::ofstream &objOut, std::ofstream &varOut) {
+			      std::ostream &objOut, std::ostream &varOut) {
     int parentKey = -1;
     if(!objId->getParent().isNoId())
       parentKey = objId->getParent()->getKey();
@@ -317,8 +359,8 @@ namespace TREX {
 
   void DbWriter::outputToken(const TokenId &token, const int type, const int slotId, 
 			     const int slotIndex, const int slotOrder, 
-			     const ObjectId &tId, std::ofstream &tokOut, 
-			     std::ofstream &varOut) {
+			     const ObjectId &tId, std::ostream &tokOut, 
+			     std::ostream &varOut) {
     check_error(token.isValid());
     if(token->isIncomplete()) {
       std::cerr << "Token " << token->getKey() << " is incomplete.  Skipping. " << std::endl;
@@ -384,7 +426,7 @@ namespace TREX {
   
   void DbWriter::outputStateVar(const Id<TokenVariable<StateDomain> >& stateVar,
 				const int parentId, const int type,
-				std::ofstream &varOut) {
+				std::ostream &varOut) {
 	
     varOut << stateVar->getKey() << TAB << ppId << TAB << parentId << TAB 
 	   << stateVar->getName().toString() << TAB;
@@ -405,7 +447,7 @@ namespace TREX {
 
   void DbWriter::outputEnumVar(const Id<TokenVariable<EnumeratedDomain> >& enumVar, 
 			       const int parentId, const int type,
-			       std::ofstream &varOut) {
+			       std::ostream &varOut) {
 	
     varOut << enumVar->getKey() << TAB << ppId << TAB << parentId << TAB 
 	   << enumVar->getName().toString() << TAB;
@@ -420,7 +462,7 @@ namespace TREX {
   
   void DbWriter::outputIntVar(const Id<TokenVariable<IntervalDomain> >& intVar,
 			      const int parentId, const int type,
-			      std::ofstream &varOut) {
+			      std::ostream &varOut) {
 	
     varOut << intVar->getKey() << TAB << ppId << TAB << parentId << TAB 
 	   << intVar->getName().toString() << TAB;
@@ -434,7 +476,7 @@ namespace TREX {
   
   void DbWriter::outputIntIntVar(const Id<TokenVariable<IntervalIntDomain> >& intVar,
 				 const int parentId, const int type,
-				 std::ofstream &varOut) {
+				 std::ostream &varOut) {
 	
 
     varOut << intVar->getKey() << TAB << ppId << TAB << parentId << TAB 
@@ -449,7 +491,7 @@ namespace TREX {
 
   void DbWriter::outputObjVar(const ObjectVarId& objVar,
 			      const int parentId, const int type,
-			      std::ofstream &varOut) {
+			      std::ostream &varOut) {
 	
 
     varOut << objVar->getKey() << TAB << ppId << TAB << parentId << TAB 
@@ -470,7 +512,7 @@ namespace TREX {
   
   void DbWriter::outputConstrVar(const ConstrainedVariableId &otherVar, 
 				 const int parentId, const int type,
-				 std::ofstream &varOut) {
+				 std::ostream &varOut) {
 	
 
     varOut << otherVar->getKey() << TAB << ppId << TAB << parentId << TAB 
@@ -492,8 +534,8 @@ namespace TREX {
     varOut << tokenVarTypes[type] << std::endl;
   }
 
-  void DbWriter::outputConstraint(const ConstraintId &constrId, std::ofstream &constrOut, 
-				  std::ofstream &cvmOut) {
+  void DbWriter::outputConstraint(const ConstraintId &constrId, std::ostream &constrOut, 
+				  std::ostream &cvmOut) {
     constrOut << constrId->getKey() << TAB << ppId << TAB << constrId->getName().toString() 
 	      << TAB << ATEMPORAL << std::endl;
     std::vector<ConstrainedVariableId>::const_iterator it =
@@ -504,9 +546,9 @@ namespace TREX {
   }
 
   void DbWriter::outputRuleInstance(const RuleInstanceId &ruleId,
-				    std::ofstream &ruleInstanceOut,
-				    std::ofstream &varOut,
-				    std::ofstream &rismOut) {
+				    std::ostream &ruleInstanceOut,
+				    std::ostream &varOut,
+				    std::ostream &rismOut) {
 
     ruleInstanceOut << ruleId->getKey() << TAB << ppId << TAB << seqId
 		    << TAB << ruleId->getRule()->getName().toString()
@@ -708,6 +750,7 @@ namespace TREX {
   }
 
   void DbWriter::write(TICK tick, unsigned int attempt) {
+    TickTraceScope trace("DbWriter::write", m_reactorName.c_str());
 
     /*
      * init output destination files if this has not been done
@@ -741,77 +784,17 @@ namespace TREX {
     
     std::string stepnum = oss.str();
 
-    std::string ppDest = dest + SLASH + stepnum;
-    if(mkdir(ppDest.c_str(), 0777) && errno != EEXIST) {
-      std::cerr << "Failed to create " << ppDest << std::endl;
-      FatalErrno();
-    }
+    Step* step = new Step;
+    step->dir = dest + SLASH + stepnum;
+    step->files.resize(F_COUNT);
 
     stepnum = "plan";
 
-    std::string ppPartialPlan = ppDest + SLASH + stepnum + PARTIAL_PLAN;
-    std::ofstream ppOut(ppPartialPlan.c_str());
-    if(!ppOut) {
-      FatalErrno();
-    }
+    // Everything is serialized in memory : the files are only created by writeStep
+    std::ostringstream ppOut, objOut, tokOut, ruleInstanceOut, rismOut, varOut, constrOut, cvmOut;
 
     ppOut << stepnum << TAB << ppId << TAB << pdbId->getSchema()->getName().toString()
 	  << TAB << seqId << std::endl;
-    ppOut.close();
-
-    std::string ppObj = ppDest + SLASH + stepnum + OBJECTS;
-    std::ofstream objOut(ppObj.c_str());
-    if(!objOut) {
-      FatalErrno();
-    }
-
-    std::string ppTok = ppDest + SLASH + stepnum + TOKENS;
-    std::ofstream tokOut(ppTok.c_str());
-    if(!tokOut) {
-      FatalErrno();
-    }
-
-    std::string ppRuleInstances = ppDest + SLASH + stepnum + RULE_INSTANCES;
-    std::ofstream ruleInstanceOut(ppRuleInstances.c_str());
-    if(!ruleInstanceOut) {
-      FatalErrno();
-    }
-
-    std::string ppRISM = ppDest + SLASH + stepnum + RULE_INSTANCE_SLAVE_MAP;
-    std::ofstream rismOut(ppRISM.c_str());
-    if(!rismOut) {
-      FatalErrno();
-    }
-
-    std::string ppVars = ppDest + SLASH + stepnum + VARIABLES;
-    std::ofstream varOut(ppVars.c_str());
-    if(!varOut) {
-      FatalErrno();
-    }
-
-    std::string ppConstrs = ppDest + SLASH + stepnum + CONSTRAINTS;
-    std::ofstream constrOut(ppConstrs.c_str());
-    if(!constrOut) {
-      FatalErrno();
-    }
-
-    std::string ppCVM = ppDest + SLASH + stepnum + CONSTRAINT_VAR_MAP;
-    std::ofstream cvmOut(ppCVM.c_str());
-    if(!cvmOut) {
-      FatalErrno();
-    }
-
-    std::string ppInsts = ppDest + SLASH + stepnum + INSTANTS;
-    std::ofstream instsOut(ppInsts.c_str());
-    if(!instsOut) {
-      FatalErrno();
-    }
-
-    std::string ppDecs = ppDest + SLASH + stepnum + DECISIONS;
-    std::ofstream decsOut(ppDecs.c_str());
-    if(!decsOut) {
-      FatalErrno();
-    }
 
     const ConstraintSet &constraints = ceId->getConstraints();
     numConstraints = constraints.size();
@@ -921,21 +904,88 @@ namespace TREX {
     }
 			
     collectStats(); // this call will overwrite incremental counters for tokens, variables, and constraints
-    (*statsOut) << seqId << TAB << ppId << TAB << stepCount << TAB << numTokens << TAB << numVariables
-		<< TAB << numConstraints << std::endl;
-    statsOut->flush();
-
-    objOut.close();
-    tokOut.close();
-    ruleInstanceOut.close();
-    rismOut.close();
-    varOut.close();
-    constrOut.close();
-    cvmOut.close();
-    instsOut.close();
-    decsOut.close();
+    std::ostringstream statsRow;
+    statsRow << seqId << TAB << ppId << TAB << stepCount << TAB << numTokens << TAB << numVariables
+	     << TAB << numConstraints << std::endl;
+
+    step->files[F_PARTIAL_PLAN] = ppOut.str();
+    step->files[F_OBJECTS] = objOut.str();
+    step->files[F_TOKENS] = tokOut.str();
+    step->files[F_RULE_INSTANCES] = ruleInstanceOut.str();
+    step->files[F_RULE_INSTANCE_SLAVE_MAP] = rismOut.str();
+    step->files[F_VARIABLES] = varOut.str();
+    step->files[F_CONSTRAINTS] = constrOut.str();
+    step->files[F_CONSTRAINT_VAR_MAP] = cvmOut.str();
+    step->stats = statsRow.str();
     m_writing = false;
     stepCount++;
+    push(step);
+  }
+
+  void DbWriter::setAsync(unsigned int maxPending, const Thread::Scheduling& sched) {
+    Guardian<Mutex> guard(m_lock);
+
+    m_maxPending = (maxPending > 0 ? maxPending : 1);
+    if(m_writer == NULL) {
+      m_writer = new Writer(*this);
+      if(!sched.isDefault())
+	m_writer->setScheduling(sched);
+      m_writer->start();
+    }
+  }
+
+  void DbWriter::push(Step* step) {
+    if(m_writer == NULL) {
+      writeStep(*step);
+      delete step;
+      return;
+    }
+    Guardian<Mutex> guard(m_lock);
+    // Bounded queue : wait for the writer rather than dropping a step
+    while(m_pending.size() >= m_maxPending)
+      m_writtenCond.wait(m_lock);
+    m_pending.push_back(step);
+    m_pendingCond.signal();
+  }
+
+  void DbWriter::drain() {
+    Guardian<Mutex> guard(m_lock);
+
+    while(true) {
+      if(m_pending.empty()) {
+	if(m_stop)
+	  return;
+	m_pendingCond.wait(m_lock);
+	continue;
+      }
+      Step* step = m_pending.front();
+      m_lock.unlock();
+      writeStep(*step);
+      delete step;
+      m_lock.lock();
+      // Only pop now so that the bound also accounts for the step being written
+      m_pending.pop_front();
+      m_writtenCond.broadcast();
+    }
+  }
+
+  void DbWriter::writeStep(const Step& step) {
+    if(!step.dir.empty()) {
+      if(mkdir(step.dir.c_str(), 0777) && errno != EEXIST) {
+	std::cerr << "Failed to create " << step.dir << std::endl;
+	FatalErrno();
+      }
+      for(unsigned int i = 0; i < F_COUNT; ++i) {
+	std::string fileName = step.dir + SLASH + STEP + STEP_FILES[i];
+	std::ofstream out(fileName.c_str());
+	if(!out) {
+	  FatalErrno();
+	}
+	out.write(step.files[i].data(), step.files[i].size());
+      }
+    }
+    (*statsOut) << step.stats;
+    statsOut->flush();
   }
 
   void DbWriter::initOutputDestination() {
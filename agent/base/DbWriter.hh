@@ -48,10 +48,13 @@
 #include "XMLUtils.hh"
 
 #include "Agent.hh"
+#include "Thread.hh"
+#include "Condition.hh"
 
 #include <set>
 #include <map>
 #include <vector>
+#include <deque>
 
 #ifdef ERROR
 #undef ERROR
@@ -73,12 +76,51 @@ namespace TREX {
 
     void addSourcePath(const char* path);
 
+    /**
+     * @brief Move the disk output of the steps to a background writer thread.
+     * @param maxPending The maximum number of serialized steps waiting to be written.
+     *
+     * write() still walks the database on the calling thread, as EUROPA is not thread safe,
+     * but only serializes the step in memory. The writer thread then creates the step
+     * directory and writes each file with a single buffered write. When @e maxPending steps
+     * are already queued write() blocks until the writer catches up, so no step is ever lost.
+     * Pending steps are flushed on destruction.
+     * @param sched The scheduling of the writer thread.
+     */
+    void setAsync(unsigned int maxPending, const Thread::Scheduling& sched = Thread::Scheduling());
+
   protected:
     inline long long int getPPId(void){return ppId;}
     long long int ppId;
     long long int seqId;
 
   private:
+    class Writer;
+
+    /**
+     * @brief The in memory snapshot of one step: the content of each file and its stats row.
+     */
+    struct Step {
+      std::string dir; /*!< The step directory. Empty for a stats only entry */
+      std::vector<std::string> files; /*!< Content of the files, indexed as STEP_FILES in DbWriter.cc */
+      std::string stats; /*!< Row to append to partialPlanStats */
+    };
+
+    /**
+     * @brief Write a step synchronously or queue it for the writer thread.
+     * @note Takes ownership of the step
+     */
+    void push(Step* step);
+
+    /**
+     * @brief Actually write a step to disk
+     */
+    void writeStep(const Step& step);
+
+    /**
+     * @brief Main loop of the writer thread
+     */
+    void drain();
 
     std::string m_agentName;
     std::string m_reactorName;
@@ -95,28 +137,38 @@ namespace TREX {
     std::ofstream *statsOut, *ruleInstanceOut;
     std::list<std::string> sourcePaths;
 
+    Writer* m_writer; /*!< The writer thread. NULL when synchronous */
+    Mutex m_lock; /*!< Protects the fields below. Inherits priority so that write() is not delayed by a preempted writer */
+    Condition m_pendingCond; /*!< Signaled when a step is queued or on stop */
+    Condition m_writtenCond; /*!< Signaled each time the writer completes a step */
+    std::deque<Step*> m_pending;
+    unsigned int m_maxPending;
+    bool m_stop;
+
+    friend class Writer;
+
     void initOutputDestination();
-    void outputObject(const ObjectId &, const int, std::ofstream &, std::ofstream &);
+    void outputObject(const ObjectId &, const int, std::ostream &, std::ostream &);
     void outputToken(const TokenId &, const int, const int, const int, const int, 
-		     const ObjectId &, std::ofstream &, std::ofstream &);
+		     const ObjectId &, std::ostream &, std::ostream &);
     void outputStateVar(const Id<TokenVariable<StateDomain> >&, const int, const int,
-			std::ofstream &varOut);
+			std::ostream &varOut);
     void outputEnumVar(const Id< TokenVariable<EnumeratedDomain> > &, const int,
-		       const int, std::ofstream &);
+		       const int, std::ostream &);
     void outputIntVar(const Id< TokenVariable<IntervalDomain> > &, const int,
-		      const int, std::ofstream &);
+		      const int, std::ostream &);
     void outputIntIntVar(const Id< TokenVariable<IntervalIntDomain> >&, const int,
-			 const int, std::ofstream &);
+			 const int, std::ostream &);
     void outputObjVar(const ObjectVarId &, const int, const int,
-		      std::ofstream &);
+		      std::ostream &);
     void outputConstrVar(const ConstrainedVariableId &, const int, const int, 
-			 std::ofstream &);
-    void outputConstraint(const ConstraintId &, std::ofstream &, std::ofstream &);
+			 std::ostream &);
+    void outputConstraint(const ConstraintId &, std::ostream &, std::ostream &);
 #ifndef NO_RESOURCES
     // TODO JRB: Move this to Resource module 
-    //void outputInstant(const InstantId &, const int, std::ofstream &);
+    //void outputInstant(const InstantId &, const int, std::ostream &);
 #endif
-    void outputRuleInstance(const RuleInstanceId &, std::ofstream &, std::ofstream & , std::ofstream &);
+    void outputRuleInstance(const RuleInstanceId &, std::ostream &, std::ostream & , std::ostream &);
     void buildSlaveAndVarSets(std::set<TokenId> &, std::set<ConstrainedVariableId> &, 
 			      const RuleInstanceId &);
     void writeStats(void);
@@ -0,0 +1,180 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Implements the deliberation scheduling policies
+ */
+
+#include "DeliberationScheduler.hh"
+#include "Utilities.hh"
+#include "Debug.hh"
+
+namespace TREX {
+
+  /**
+   * @brief First reactor with work in dependency order. A reactor keeps the cpu until it has no more work.
+   */
+  class PriorityScheduler: public DeliberationScheduler {
+  protected:
+    unsigned int select() {return 0;}
+  };
+
+  /**
+   * @brief Reactors take turns
+   */
+  class RoundRobinScheduler: public DeliberationScheduler {
+  public:
+    RoundRobinScheduler(): m_cursor(0) {}
+
+  protected:
+    unsigned int select(){
+      unsigned int i = m_cursor % m_agenda.size();
+      m_cursor = i + 1;
+      return i;
+    }
+
+    void removed(unsigned int i){
+      if(m_cursor > i)
+	m_cursor--;
+    }
+
+    void reset() {m_cursor = 0;}
+
+  private:
+    unsigned int m_cursor; /*!< Index of the next entry to serve */
+  };
+
+  /**
+   * @brief Earliest deadline first
+   */
+  class EdfScheduler: public DeliberationScheduler {
+  protected:
+    unsigned int select(){
+      unsigned int best = 0;
+      for(unsigned int i = 1; i < m_agenda.size(); i++){
+	const Entry& entry = m_agenda[i];
+	if(entry.deadline < m_agenda[best].deadline ||
+	   (entry.deadline == m_agenda[best].deadline && entry.reactor->getLookAhead() < m_agenda[best].reactor->getLookAhead()))
+	  best = i;
+      }
+      return best;
+    }
+  };
+
+  /**
+   * @brief Weighted fair sharing. The entry that received the least weighted steps goes next.
+   */
+  class WeightedScheduler: public DeliberationScheduler {
+  protected:
+    unsigned int select(){
+      unsigned int best = 0;
+      for(unsigned int i = 1; i < m_agenda.size(); i++){
+	if(m_agenda[i].virtualTime < m_agenda[best].virtualTime)
+	  best = i;
+      }
+      return best;
+    }
+  };
+
+  DeliberationScheduler* DeliberationScheduler::create(const std::string& policy){
+    if(policy == "priority")
+      return new PriorityScheduler();
+    if(policy == "roundRobin")
+      return new RoundRobinScheduler();
+    if(policy == "edf")
+      return new EdfScheduler();
+    if(policy == "weighted")
+      return new WeightedScheduler();
+
+    ConfigurationException::configurationCheckError(false, "Unknown deliberation scheduler: " + policy);
+    return NULL;
+  }
+
+  DeliberationScheduler::DeliberationScheduler(): m_maxSteps(0) {}
+
+  DeliberationScheduler::~DeliberationScheduler() {}
+
+  void DeliberationScheduler::setWeight(const TeleoReactorId& reactor, double weight){
+    ConfigurationException::configurationCheckError(weight > 0, "Weight of " + reactor->getName().toString() + " must be positive.");
+    m_weights[reactor->getName()] = weight;
+  }
+
+  void DeliberationScheduler::setMaxSteps(unsigned int maxSteps){
+    m_maxSteps = maxSteps;
+  }
+
+  void DeliberationScheduler::handleTickStart(const std::vector<TeleoReactorId>& reactors, TICK tick){
+    m_agenda.clear();
+    for(std::vector<TeleoReactorId>::const_iterator it = reactors.begin(); it != reactors.end(); ++it){
+      TeleoReactorId reactor = *it;
+      std::map<double, double>::const_iterator w_it = m_weights.find(reactor->getName());
+      Entry entry;
+      entry.reactor = reactor;
+      entry.steps = 0;
+      entry.deadline = tick + reactor->getLatency();
+      entry.virtualTime = 0;
+      entry.weight = (w_it == m_weights.end() ? 1.0 : w_it->second);
+      m_agenda.push_back(entry);
+    }
+    reset();
+  }
+
+  TeleoReactorId DeliberationScheduler::next(){
+    static unsigned int sl_counter(0);
+
+    debugMsg("DeliberationScheduler:next", "[" << sl_counter << "] Size=" << m_agenda.size());
+    sl_counter++;
+
+    while(!m_agenda.empty()){
+      unsigned int i = select();
+      Entry& entry = m_agenda[i];
+
+      if(isReady(entry)){
+	entry.steps++;
+	entry.virtualTime += 1.0 / entry.weight;
+	return entry.reactor;
+      }
+
+      // Remove the reactor that is done
+      m_agenda.erase(m_agenda.begin() + i);
+      removed(i);
+    }
+
+    return TeleoReactorId::noId();
+  }
+
+  bool DeliberationScheduler::isReady(const Entry& entry) const {
+    return (m_maxSteps == 0 || entry.steps < m_maxSteps) && entry.reactor->getLookAhead() > 0 && entry.reactor->hasWork();
+  }
+}
@@ -0,0 +1,126 @@
+#ifndef H_DeliberationScheduler
+#define H_DeliberationScheduler
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Provides declaration of the policies used by the Agent to share deliberation time between reactors within a tick.
+ * The policy is selected with the scheduler attribute of the agent configuration:
+ * - priority (default): the first reactor in dependency order that has work.
+ * - roundRobin: reactors with work take turns, one step each.
+ * - edf: the reactor with the earliest deadline, which is the current tick plus its latency. Ties go to the smaller lookAhead.
+ * - weighted: reactors get steps in proportion to the weight attribute of their configuration (default 1).
+ * The maxSteps attribute of the agent configuration caps the number of steps given to a reactor in a tick (0 for no cap).
+ */
+
+#include "TREXDefs.hh"
+#include "TeleoReactor.hh"
+#include <vector>
+#include <map>
+
+namespace TREX {
+
+  class DeliberationScheduler {
+  public:
+    /**
+     * @brief Factory method
+     * @param policy The name of the policy. See file documentation.
+     * @throw ConfigurationException if the policy is unknown
+     */
+    static DeliberationScheduler* create(const std::string& policy);
+
+    virtual ~DeliberationScheduler();
+
+    /**
+     * @brief Set the share of a reactor for the weighted policy
+     */
+    void setWeight(const TeleoReactorId& reactor, double weight);
+
+    /**
+     * @brief Set the maximum number of steps given to each reactor in a tick. 0 for no limit.
+     */
+    void setMaxSteps(unsigned int maxSteps);
+
+    /**
+     * @brief Reset the agenda for a new tick
+     * @param reactors Reactors in dependency order
+     */
+    void handleTickStart(const std::vector<TeleoReactorId>& reactors, TICK tick);
+
+    /**
+     * @brief Select the next reactor to work on. Reactors found without work are dropped for the rest of the tick.
+     * @return The next reactor to work on. If no work required, returns a noId()
+     */
+    TeleoReactorId next();
+
+  protected:
+    struct Entry {
+      TeleoReactorId reactor;
+      unsigned int steps; /*!< Steps given in this tick */
+      TICK deadline; /*!< Tick by which the deliberation of the reactor should be done */
+      double virtualTime; /*!< Steps weighted by the inverse of the reactor weight */
+      double weight;
+    };
+
+    DeliberationScheduler();
+
+    /**
+     * @brief Pick an entry in m_agenda
+     * @pre m_agenda is not empty
+     */
+    virtual unsigned int select() = 0;
+
+    /**
+     * @brief Notification that the entry at index i was removed from m_agenda
+     */
+    virtual void removed(unsigned int i) {}
+
+    /**
+     * @brief Notification that a new tick starts
+     */
+    virtual void reset() {}
+
+    std::vector<Entry> m_agenda; /*!< Reactors that may still have work for this tick, in dependency order */
+
+  private:
+    bool isReady(const Entry& entry) const;
+
+    std::map<double, double> m_weights; /*!< Weights by reactor name */
+    unsigned int m_maxSteps;
+  };
+
+}
+
+#endif
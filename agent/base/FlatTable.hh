@@ -0,0 +1,211 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "FlatTable.hh"
+ * @brief Definition of sorted vector based maps and sets
+ */
+#ifndef _FLATTABLE_HH
+#define _FLATTABLE_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace TREX {
+
+  /** @brief Map stored as a vector sorted by key.
+   *
+   * Lookups are binary searches over contiguous memory, which is
+   * faster than a std::map for the small tables read on every tick.
+   * Insertions and removals shift the entries after them : it suits
+   * tables built at initialization or whose keys mostly grow, like
+   * entity keys.
+   *
+   * Unlike std::map, an insertion or a removal invalidates the
+   * iterators and references to the other entries.
+   *
+   * @param Key The key type
+   * @param Ty The value type. It must be copy assignable
+   */
+  template<class Key, class Ty, class Compare = std::less<Key> >
+  class FlatMap {
+  public:
+    typedef Key key_type;
+    typedef Ty mapped_type;
+    typedef std::pair<Key, Ty> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() {
+      return m_entries.begin();
+    }
+    iterator end() {
+      return m_entries.end();
+    }
+    const_iterator begin() const {
+      return m_entries.begin();
+    }
+    const_iterator end() const {
+      return m_entries.end();
+    }
+
+    size_t size() const {
+      return m_entries.size();
+    }
+    bool empty() const {
+      return m_entries.empty();
+    }
+    void clear() {
+      m_entries.clear();
+    }
+    void reserve(size_t n) {
+      m_entries.reserve(n);
+    }
+
+    iterator find(Key const &key) {
+      iterator it = lower_bound(key);
+      return (it==end() || m_less(key, it->first)) ? end() : it;
+    }
+    const_iterator find(Key const &key) const {
+      const_iterator it = lower_bound(key);
+      return (it==end() || m_less(key, it->first)) ? end() : it;
+    }
+
+    /** @brief Insert an entry
+     * @return The entry for the key and true if it was inserted,
+     * false if the key was already present
+     */
+    std::pair<iterator, bool> insert(value_type const &entry) {
+      iterator it = lower_bound(entry.first);
+      if( it!=end() && !m_less(entry.first, it->first) )
+	return std::make_pair(it, false);
+      return std::make_pair(m_entries.insert(it, entry), true);
+    }
+
+    size_t erase(Key const &key) {
+      iterator it = find(key);
+      if( it==end() )
+	return 0;
+      m_entries.erase(it);
+      return 1;
+    }
+    void erase(iterator it) {
+      m_entries.erase(it);
+    }
+
+    Ty &operator[](Key const &key) {
+      return insert(value_type(key, Ty())).first->second;
+    }
+
+  private:
+    struct KeyLess {
+      KeyLess(Compare const &less): m_less(less) {}
+      bool operator()(value_type const &entry, Key const &key) const {
+	return m_less(entry.first, key);
+      }
+      Compare m_less;
+    };
+
+    iterator lower_bound(Key const &key) {
+      return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess(m_less));
+    }
+    const_iterator lower_bound(Key const &key) const {
+      return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess(m_less));
+    }
+
+    std::vector<value_type> m_entries;
+    Compare m_less;
+  };
+
+  /** @brief Set stored as a sorted vector.
+   *
+   * The same trade-offs as FlatMap apply.
+   */
+  template<class Key, class Compare = std::less<Key> >
+  class FlatSet {
+  public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef typename std::vector<Key>::const_iterator iterator;
+    typedef typename std::vector<Key>::const_iterator const_iterator;
+
+    const_iterator begin() const {
+      return m_keys.begin();
+    }
+    const_iterator end() const {
+      return m_keys.end();
+    }
+
+    size_t size() const {
+      return m_keys.size();
+    }
+    bool empty() const {
+      return m_keys.empty();
+    }
+    void clear() {
+      m_keys.clear();
+    }
+
+    const_iterator find(Key const &key) const {
+      const_iterator it = std::lower_bound(m_keys.begin(), m_keys.end(), key, m_less);
+      return (it==end() || m_less(key, *it)) ? end() : it;
+    }
+
+    std::pair<const_iterator, bool> insert(Key const &key) {
+      typename std::vector<Key>::iterator it = std::lower_bound(m_keys.begin(), m_keys.end(), key, m_less);
+      if( it!=m_keys.end() && !m_less(key, *it) )
+	return std::make_pair(const_iterator(it), false);
+      return std::make_pair(const_iterator(m_keys.insert(it, key)), true);
+    }
+
+    size_t erase(Key const &key) {
+      typename std::vector<Key>::iterator it = std::lower_bound(m_keys.begin(), m_keys.end(), key, m_less);
+      if( it==m_keys.end() || m_less(key, *it) )
+	return 0;
+      m_keys.erase(it);
+      return 1;
+    }
+
+  private:
+    std::vector<Key> m_keys;
+    Compare m_less;
+  };
+
+}
+
+#endif // _FLATTABLE_HH
@@ -117,6 +117,23 @@ namespace TREX {
     return m_token->isCommitted() && m_end.isSingleton() && m_end.getUpperBound() <= m_clock.getLowerBound() && hasStatus();
   }
 
+  bool ExecutionFunction::canIgnore(const ConstrainedVariableId& variable, int argIndex, const DomainListener::ChangeType& changeType){
+    // Only the clock, second in the scope, is updated on every tick
+    return argIndex == 1 && m_clock.getLowerBound() < dueTick();
+  }
+
+  double ExecutionFunction::startDueTick() const{
+    if(m_result.isSingleton() || !m_start.isSingleton())
+      return PLUS_INFINITY;
+    return m_start.getUpperBound();
+  }
+
+  double ExecutionFunction::endDueTick() const{
+    if(m_result.isSingleton() || !m_end.isSingleton())
+      return PLUS_INFINITY;
+    return m_end.getUpperBound();
+  }
+
   bool ExecutionFunction::isStatus(const LabelStr& status) {
     return status == m_status;
   }
@@ -157,6 +174,10 @@ namespace TREX {
 			 const std::vector<ConstrainedVariableId>& variables)
     : ExecutionFunction(name, propagatorName, constraintEngine, variables){} 
 
+  double IsStarted::dueTick() const{
+    return startDueTick();
+  }
+
   void IsStarted::handleExecute(){
     if(isStarted())
       m_result.set(1);
@@ -168,6 +189,10 @@ namespace TREX {
 			 const std::vector<ConstrainedVariableId>& variables)
     : ExecutionFunction(name, propagatorName, constraintEngine, variables){} 
 
+  double IsEnded::dueTick() const{
+    return endDueTick();
+  }
+
   void IsEnded::handleExecute(){
     if(isEnded())
       m_result.set(1);
@@ -182,6 +207,10 @@ namespace TREX {
   /**
    * @brief We only do evaluation once the token has started. We immediately commit to the result based on the bounds.
    */
+  double IsTimedOut::dueTick() const{
+    return m_fired ? PLUS_INFINITY : startDueTick();
+  }
+
   void IsTimedOut::handleExecute(){
     if(!isStarted())
       return;
@@ -207,6 +236,10 @@ namespace TREX {
 			 const std::vector<ConstrainedVariableId>& variables)
     : ExecutionFunction(name, propagatorName, constraintEngine, variables){} 
 
+  double IsStatus::dueTick() const{
+    return endDueTick();
+  }
+
   void IsStatus::handleExecute(){
     if(isEnded()){
       if(checkStatus()){
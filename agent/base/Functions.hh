@@ -93,6 +93,27 @@ namespace TREX {
     bool isStatus(const LabelStr& status);
     bool hasStatus();
 
+    /**
+     * @brief Clock updates are ignored until the tick at which the result can next change
+     */
+    bool canIgnore(const ConstrainedVariableId& variable, int argIndex, const DomainListener::ChangeType& changeType);
+
+    /**
+     * @brief The first tick at which a clock update can change the result, PLUS_INFINITY if none can. Changes to the
+     * other variables of the scope are never ignored, they move this tick.
+     */
+    virtual double dueTick() const = 0;
+
+    /**
+     * @brief Due tick of the functions waiting for the token to start
+     */
+    double startDueTick() const;
+
+    /**
+     * @brief Due tick of the functions waiting for the token to end
+     */
+    double endDueTick() const;
+
     BoolDomain& m_result; // The function result
     const IntervalIntDomain& m_clock; // The agent clock
     const IntervalIntDomain& m_start; // The token start time
@@ -116,6 +137,7 @@ namespace TREX {
 
   protected:
     virtual void handleExecute();
+    virtual double dueTick() const;
   };
 
   /**
@@ -131,6 +153,7 @@ namespace TREX {
 
   protected:
     virtual void handleExecute();
+    virtual double dueTick() const;
   };
 
 
@@ -145,6 +168,7 @@ namespace TREX {
 	       const std::vector<ConstrainedVariableId>& variables);
   protected:
     virtual void handleExecute();
+    virtual double dueTick() const;
     virtual void setSource(const ConstraintId& source_constraint);
   private:
     bool m_fired;
@@ -161,6 +185,7 @@ namespace TREX {
 	     const std::vector<ConstrainedVariableId>& variables);
   protected:
     virtual void handleExecute();
+    virtual double dueTick() const;
     virtual bool checkStatus() = 0;
   };
 
@@ -46,6 +46,7 @@
 #include <sys/stat.h>
 
 #include <cerrno>
+#include <cstdlib>
 
 #include "Debug.hh"
 
@@ -54,6 +55,7 @@
 
 #include "MutexWrapper.hh"
 #include "Guardian.hh"
+#include "Utilities.hh"
 
 using namespace TREX;
 /*
@@ -130,6 +132,16 @@ LogManager::LogManager() {
 
   delete[] buf;
 
+  char *muted = getenv(SYSLOG_MUTE_ENV);
+  if( NULL!=muted ) {
+    std::istringstream iss(muted);
+    std::string category;
+
+    while( std::getline(iss, category, ',') )
+      if( !category.empty() )
+	muteSyslog(category);
+  }
+
   for(unsigned i=1; i<MAX_LOG_ATTEMPT; ++i) {
     std::ostringstream oss;
 
@@ -144,6 +156,13 @@ LogManager::LogManager() {
     symlink(m_path.c_str(), latest.c_str());
 
     m_syslog.open(file_name(TREX_LOG_FILE).c_str());
+
+    // Asynchronous syslog with a bounded buffer if requested 
+    char *async = getenv(SYSLOG_ASYNC_ENV);
+    if( NULL!=async && atol(async)>0 ) {
+      char *sched = getenv(LOG_SCHED_ENV);
+      m_syslog.setAsync(atol(async), NULL==sched ? Thread::Scheduling() : Thread::Scheduling(sched));
+    }
     m_debug.open(file_name(TREX_DBG_FILE).c_str());
 
     DebugMessage::setStream(m_debug);
@@ -160,6 +179,11 @@ LogManager::~LogManager() {
     endi = m_logs.end();
   for( ;endi!=i ; ++i )
     delete i->second;
+
+  std::map<std::string, std::pair<TiXmlElement *, unsigned> >::iterator 
+    x = m_xml.begin(), endx = m_xml.end();
+  for( ; endx!=x; ++x)
+    delete x->second.first;
 }
 
 // Manipulators:
@@ -191,6 +215,19 @@ void LogManager::handleNewTick(TICK current) const {
     i->second->handleNewTick(current);
 }
 
+bool LogManager::syslogEnabled(std::string const &category) const {
+  std::vector<std::string>::const_iterator i = m_muted.begin(), 
+    endi = m_muted.end();
+  for( ; endi!=i; ++i)
+    if( 0==category.compare(0, i->length(), *i) )
+      return false;
+  return true;
+}
+
+void LogManager::muteSyslog(std::string const &prefix) {
+  m_muted.push_back(prefix);
+}
+
 std::string LogManager::file_name(std::string const &short_name) const {
   return m_path+"/"+short_name;
 }
@@ -267,3 +304,29 @@ std::string const &LogManager::use(std::string const &fileName) {
     std::cerr<<"Unable to find \""<<fileName<<'\"'<<std::endl;
   return fileName;
 }
+
+TiXmlElement const &LogManager::acquireXml(std::string const &fileName) {
+  std::map<std::string, std::pair<TiXmlElement *, unsigned> > &xml = instance().m_xml;
+  std::map<std::string, std::pair<TiXmlElement *, unsigned> >::iterator i = xml.find(fileName);
+
+  if( xml.end()==i ) {
+    debugMsg("LogManager", " parsing shared xml file \""<<fileName<<'\"');
+    TiXmlElement *root = initXml(fileName);
+    // Nothing is kept for a file that failed to parse so the next call tries again
+    ConfigurationException::configurationCheckError(NULL!=root, "LogManager: unable to parse \""+fileName+'\"');
+    i = xml.insert(std::make_pair(fileName, std::make_pair(root, 0u))).first;
+  }
+  ++(i->second.second);
+  return *(i->second.first);
+}
+
+void LogManager::releaseXml(std::string const &fileName) {
+  std::map<std::string, std::pair<TiXmlElement *, unsigned> > &xml = instance().m_xml;
+  std::map<std::string, std::pair<TiXmlElement *, unsigned> >::iterator i = xml.find(fileName);
+
+  checkError(xml.end()!=i, "LogManager: \""<<fileName<<"\" was not acquired");
+  if( 0==--(i->second.second) ) {
+    delete i->second.first;
+    xml.erase(i);
+  }
+}
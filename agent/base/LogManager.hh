@@ -45,6 +45,8 @@
 
 # include <memory>
 # include <fstream>
+# include <vector>
+# include <map>
 
 # include "EuropaXML.hh"
 
@@ -55,6 +57,11 @@
 # define TREX_DBG_FILE "Debug.log"
 
 # define LOG_DIR_ENV "TREX_LOG_DIR"
+# define SYSLOG_MUTE_ENV "TREX_SYSLOG_MUTE"
+# define SYSLOG_ASYNC_ENV "TREX_SYSLOG_ASYNC"
+# define TICKLOG_BINARY_ENV "TREX_TICKLOG_BINARY"
+# define PPW_ASYNC_ENV "TREX_PPW_ASYNC"
+# define LOG_SCHED_ENV "TREX_LOG_SCHED"
 # define LATEST_DIR "latest"
 # define MAX_LOG_ATTEMPT 1024
 
@@ -130,16 +137,74 @@ namespace TREX {
     static TiXmlElement *initXml(std::string const &fileName) {
       return EUROPA::initXml(use(fileName).c_str());
     }
+    /** @brief Shared XML file access.
+     *
+     * @param fileName Name of the file
+     *
+     * The file is parsed the first time it is acquired and the
+     * same content is given to all the later callers. Each call
+     * adds a reference which has to be given back with releaseXml.
+     * This is meant for the configuration files, which are small and
+     * read by several reactors. Observation logs are streamed by
+     * XmlObservationReader instead.
+     *
+     * @return The root element of @e fileName
+     *
+     * @throw ConfigurationException @e fileName could not be
+     * parsed. Nothing is kept for it, so it will be parsed again
+     * by the next call.
+     *
+     * @sa releaseXml(std::string const &)
+     */
+    static TiXmlElement const &acquireXml(std::string const &fileName);
+    /** @brief Release a shared XML file.
+     *
+     * @param fileName Name of the file
+     *
+     * Remove one reference to @e fileName. The parsed content is
+     * deleted when the last reference is released.
+     *
+     * @sa acquireXml(std::string const &)
+     */
+    static void releaseXml(std::string const &fileName);
 
     /** @brief System log entry point.
      *
      * @return a reference to the syslog file.
      *
      * @note The syslog file is a TextLog ensuring thread safety.  
+     * If the environment variable TREX_SYSLOG_ASYNC is set to a positive
+     * number, the syslog is asynchronous with at most this number of bytes
+     * pending (see TextLog::setAsync).
      */
     TextLog &syslog() {
       return m_syslog;
     }
+    /** @brief Check if a syslog category is enabled.
+     *
+     * @param category A category name
+     *
+     * All the categories are enabled by default. A category is muted
+     * when it starts with one of the prefixes given in the
+     * TREX_SYSLOG_MUTE environment variable (a ',' separated list).
+     *
+     * @retval true if messages of @e category should be logged
+     * @retval false else
+     *
+     * @sa TREX_SYSLOG
+     */
+    bool syslogEnabled(std::string const &category) const;
+    /** @brief Mute syslog categories.
+     *
+     * @param prefix A category prefix
+     *
+     * Mute all the categories starting with @e prefix, as if it was
+     * listed in TREX_SYSLOG_MUTE. Call sites of TREX_SYSLOG which
+     * already checked their category are not affected.
+     *
+     * @sa syslogEnabled(std::string const &) const
+     */
+    void muteSyslog(std::string const &prefix);
 
     /** @brief Get one TickLogger access.
      *
@@ -203,6 +268,16 @@ namespace TREX {
      * This attribute manages a ThreadSafe text log to put TREX system log messages.
      */
     TextLog m_syslog;
+    /** @brief Muted syslog categories.
+     *
+     * Prefixes of the categories excluded from the syslog.
+     */
+    std::vector<std::string> m_muted;
+    /** @brief Shared XML files.
+     *
+     * Parsed content and reference count of the files given by acquireXml
+     */
+    std::map<std::string, std::pair<TiXmlElement *, unsigned> > m_xml;
 
     friend class std::auto_ptr<LogManager>;
     
@@ -229,4 +304,21 @@ namespace TREX {
  */
 # define TREXLog() TREX::LogManager::instance().syslog()
 
+/** @brief Category based system logging macro.
+ *
+ * @param category The category of the message
+ * @param data The data to be written
+ *
+ * This macro is equivalent to <code>TREXLog() << data</code> except that
+ * @e data is evaluated only when @e category is enabled. The check is done
+ * once per call site so a muted message costs a single test.
+ *
+ * @sa TREX::LogManager::syslogEnabled(std::string const &)
+ */
+# define TREX_SYSLOG(category, data) { \
+  static bool const sl_enabled = TREX::LogManager::instance().syslogEnabled(category); \
+  if( sl_enabled ) \
+    TREXLog() << data; \
+}
+
 #endif // _LOGMANAGER_HH
@@ -0,0 +1,611 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "MissionHistory.cc"
+ */
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MissionHistory.hh"
+#include "ErrnoExcept.hh"
+#include "Observer.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+
+namespace TREX {
+
+  namespace {
+    char const FILE_MAGIC[8] = {'T', 'R', 'E', 'X', 'H', 'I', 'S', 'T'};
+    char const FOOTER_MAGIC[8] = {'T', 'R', 'E', 'X', 'H', 'E', 'N', 'D'};
+
+    size_t padding(uint64_t size) {
+      return (8-size%8)%8;
+    }
+
+    void appendParameter(std::ostringstream &text, std::string const &name, AbstractDomain const &domain) {
+      if( 0<text.tellp() )
+	text<<' ';
+      text<<name<<'='<<domain.toString();
+    }
+
+    void appendParameters(std::ostringstream &text, Observation const &obs) {
+      for(unsigned int i=0; i<obs.countParameters(); ++i) {
+	std::pair<LabelStr, AbstractDomain const *> nameValuePair = obs[i];
+	appendParameter(text, nameValuePair.first.toString(), *(nameValuePair.second));
+      }
+    }
+  }
+
+  static void fail(int fd, std::string const &from) {
+    int err = errno;
+    if( fd>=0 )
+      close(fd);
+    errno = err;
+    throw ErrnoExcept(from);
+  }
+
+  uint64_t const MissionHistory::NO_ROW;
+  uint32_t const MissionHistory::VERSION;
+
+  char const *MissionHistory::magic() {
+    return FILE_MAGIC;
+  }
+
+  /*
+   * class MissionHistoryWriter
+   */
+
+  MissionHistoryWriter::MissionHistoryWriter(std::string const &fileName, unsigned int segmentRows)
+    :m_file(fopen(fileName.c_str(), "wb")), m_offset(0), m_failed(false),
+     m_segmentRows(segmentRows>0 ? segmentRows : 1), m_writtenLabels(0), m_firstRow(0) {
+    if( NULL==m_file )
+      throw ErrnoExcept("MissionHistory fopen "+fileName);
+
+    MissionHistory::FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = MissionHistory::VERSION;
+    write(&header, sizeof(header));
+  }
+
+  MissionHistoryWriter::~MissionHistoryWriter() {
+    close();
+  }
+
+  void MissionHistoryWriter::observation(TICK tick, Observation const &obs) {
+    std::ostringstream text;
+    appendParameters(text, obs);
+    addRow(tick, MissionHistory::OBSERVATION, obs.getObjectName(), obs.getPredicate(), 0, text.str());
+  }
+
+  void MissionHistoryWriter::dispatch(TICK tick, TokenId const &goal) {
+    addGoal(tick, MissionHistory::DISPATCH, goal);
+  }
+
+  void MissionHistoryWriter::recall(TICK tick, TokenId const &goal) {
+    addGoal(tick, MissionHistory::RECALL, goal);
+  }
+
+  void MissionHistoryWriter::addGoal(TICK tick, char kind, TokenId const &goal) {
+    ObservationByReference obs(goal);
+    std::ostringstream text;
+
+    appendParameters(text, obs);
+    appendParameter(text, "start", goal->start()->lastDomain());
+    appendParameter(text, "end", goal->end()->lastDomain());
+    appendParameter(text, "duration", goal->duration()->lastDomain());
+    addRow(tick, kind, obs.getObjectName(), obs.getPredicate(), goal->getKey(), text.str());
+  }
+
+  void MissionHistoryWriter::addRow(TICK tick, char kind, LabelStr const &timeline, LabelStr const &predicate,
+				    uint32_t key, std::string const &text) {
+    if( NULL==m_file )
+      return;
+    checkError(m_ticks.empty() || m_ticks.back().tick<=tick,
+	       "MissionHistoryWriter: row at tick "<<tick<<" after tick "<<m_ticks.back().tick);
+
+    uint32_t timelineId = label(timeline), predicateId = label(predicate);
+
+    if( m_ticks.empty() || m_ticks.back().tick!=tick ) {
+      MissionHistory::TickEntry entry;
+      entry.tick = tick;
+      entry.reserved = 0;
+      entry.firstRow = rows();
+      m_ticks.push_back(entry);
+    }
+    if( MissionHistory::OBSERVATION==kind )
+      m_nextLastObservation[timelineId] = rows();
+
+    m_tickColumn.push_back(tick);
+    m_timelineColumn.push_back(timelineId);
+    m_predicateColumn.push_back(predicateId);
+    m_keyColumn.push_back(key);
+    m_textColumn.push_back(m_text.size());
+    m_text += text;
+    m_text += '\0';
+    m_kinds.push_back(kind);
+
+    if( m_kinds.size()>=m_segmentRows )
+      flushSegment();
+  }
+
+  uint32_t MissionHistoryWriter::label(LabelStr const &str) {
+    std::map<double, uint32_t>::const_iterator i = m_labelIds.find(str);
+
+    if( m_labelIds.end()!=i )
+      return i->second;
+
+    uint32_t id = m_labels.size();
+    m_labelIds.insert(std::make_pair((double)str, id));
+    m_labels.push_back(str.toString());
+    m_lastObservation.push_back(MissionHistory::NO_ROW);
+    m_nextLastObservation.push_back(MissionHistory::NO_ROW);
+    return id;
+  }
+
+  void MissionHistoryWriter::flushSegment() {
+    if( m_kinds.empty() )
+      return;
+
+    MissionHistory::SegmentEntry entry;
+    entry.offset = m_offset;
+    entry.firstRow = m_firstRow;
+    entry.rows = m_kinds.size();
+    entry.firstTick = m_tickColumn.front();
+    entry.lastTick = m_tickColumn.back();
+    entry.reserved = 0;
+    m_directory.push_back(entry);
+
+    MissionHistory::SegmentHeader header;
+    header.rows = entry.rows;
+    header.labels = m_lastObservation.size();
+    header.textSize = m_text.size();
+    header.newLabels = m_labels.size()-m_writtenLabels;
+    write(&header, sizeof(header));
+
+    // The table of the previous observations, then the columns
+    write(&m_lastObservation[0], m_lastObservation.size()*sizeof(uint64_t));
+    write(&m_tickColumn[0], entry.rows*sizeof(uint32_t));
+    write(&m_timelineColumn[0], entry.rows*sizeof(uint32_t));
+    write(&m_predicateColumn[0], entry.rows*sizeof(uint32_t));
+    write(&m_keyColumn[0], entry.rows*sizeof(uint32_t));
+    m_textColumn.push_back(m_text.size());
+    write(&m_textColumn[0], m_textColumn.size()*sizeof(uint32_t));
+    write(&m_kinds[0], m_kinds.size());
+    pad();
+    write(m_text.data(), m_text.size());
+    pad();
+
+    // The labels first used here, so that a file without footer can be read
+    uint32_t offset = 0;
+    for(uint32_t i=m_writtenLabels; i<m_labels.size(); ++i) {
+      write(&offset, sizeof(offset));
+      offset += m_labels[i].size()+1;
+    }
+    write(&offset, sizeof(offset));
+    for(uint32_t i=m_writtenLabels; i<m_labels.size(); ++i)
+      write(m_labels[i].c_str(), m_labels[i].size()+1);
+    pad();
+    m_writtenLabels = m_labels.size();
+    if( 0!=fflush(m_file) )
+      m_failed = true;
+
+    m_firstRow += entry.rows;
+    m_lastObservation = m_nextLastObservation;
+    m_tickColumn.clear();
+    m_timelineColumn.clear();
+    m_predicateColumn.clear();
+    m_keyColumn.clear();
+    m_textColumn.clear();
+    m_kinds.clear();
+    m_text.clear();
+  }
+
+  void MissionHistoryWriter::close() {
+    if( NULL==m_file )
+      return;
+    flushSegment();
+
+    MissionHistory::Footer footer;
+    memset(&footer, 0, sizeof(footer));
+
+    // Label table
+    footer.labels = m_offset;
+    footer.labelCount = m_labels.size();
+    uint32_t offset = 0;
+    for(std::vector<std::string>::const_iterator i=m_labels.begin(); m_labels.end()!=i; ++i) {
+      write(&offset, sizeof(offset));
+      offset += i->size()+1;
+    }
+    write(&offset, sizeof(offset));
+    for(std::vector<std::string>::const_iterator i=m_labels.begin(); m_labels.end()!=i; ++i)
+      write(i->c_str(), i->size()+1);
+    pad();
+
+    // Indexes
+    footer.directory = m_offset;
+    footer.segmentCount = m_directory.size();
+    if( !m_directory.empty() )
+      write(&m_directory[0], m_directory.size()*sizeof(MissionHistory::SegmentEntry));
+    footer.ticks = m_offset;
+    footer.tickCount = m_ticks.size();
+    if( !m_ticks.empty() )
+      write(&m_ticks[0], m_ticks.size()*sizeof(MissionHistory::TickEntry));
+
+    footer.rows = m_firstRow;
+    memcpy(footer.magic, FOOTER_MAGIC, sizeof(footer.magic));
+    write(&footer, sizeof(footer));
+
+    if( 0!=fclose(m_file) )
+      m_failed = true;
+    m_file = NULL;
+    condDebugMsg(m_failed, "trex:warning", "Failed to write the mission history : it is incomplete.");
+  }
+
+  void MissionHistoryWriter::write(void const *data, size_t size) {
+    if( 0<size && 1!=fwrite(data, size, 1, m_file) )
+      m_failed = true;
+    m_offset += size;
+  }
+
+  void MissionHistoryWriter::pad() {
+    static char const zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    write(zeros, padding(m_offset));
+  }
+
+  /*
+   * class MissionHistoryReader
+   */
+
+  MissionHistoryReader::MissionHistoryReader(std::string const &fileName)
+    :m_base(NULL), m_size(0), m_footer(NULL), m_labelOffsets(NULL), m_labelChars(NULL),
+     m_directory(NULL), m_ticks(NULL), m_recovered(false) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if( fd<0 )
+      fail(fd, "MissionHistory open "+fileName);
+
+    struct stat info;
+    if( 0!=fstat(fd, &info) )
+      fail(fd, "MissionHistory fstat "+fileName);
+    m_size = info.st_size;
+    if( m_size<sizeof(MissionHistory::FileHeader) ) {
+      close(fd);
+      throw std::runtime_error("MissionHistory : \""+fileName+"\" is not a mission history");
+    }
+
+    void *base = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    if( MAP_FAILED==base )
+      fail(fd, "MissionHistory mmap "+fileName);
+    close(fd);
+    m_base = static_cast<char const *>(base);
+
+    MissionHistory::FileHeader const *header = reinterpret_cast<MissionHistory::FileHeader const *>(m_base);
+    if( 0!=memcmp(header->magic, FILE_MAGIC, sizeof(header->magic)) || MissionHistory::VERSION!=header->version ) {
+      munmap(base, m_size);
+      throw std::runtime_error("MissionHistory : \""+fileName+"\" is not a mission history");
+    }
+    if( m_size>=sizeof(MissionHistory::FileHeader)+sizeof(MissionHistory::Footer) )
+      m_footer = reinterpret_cast<MissionHistory::Footer const *>(m_base+m_size-sizeof(MissionHistory::Footer));
+    if( NULL==m_footer || 0!=memcmp(m_footer->magic, FOOTER_MAGIC, sizeof(m_footer->magic)) ) {
+      // The mission did not terminate properly
+      recover(fileName);
+      return;
+    }
+
+    // The segments come first, then the label table, the directory, the tick index and the footer
+    uint64_t end = m_size-sizeof(MissionHistory::Footer);
+    bool valid = m_footer->labels<=m_footer->directory && m_footer->directory<=m_footer->ticks && m_footer->ticks<=end
+      && (static_cast<uint64_t>(m_footer->labelCount)+1)*sizeof(uint32_t)<=m_footer->directory-m_footer->labels
+      && m_footer->segmentCount*static_cast<uint64_t>(sizeof(MissionHistory::SegmentEntry))<=m_footer->ticks-m_footer->directory
+      && m_footer->tickCount*static_cast<uint64_t>(sizeof(MissionHistory::TickEntry))<=end-m_footer->ticks;
+    if( valid ) {
+      m_labelOffsets = reinterpret_cast<uint32_t const *>(m_base+m_footer->labels);
+      m_labelChars = reinterpret_cast<char const *>(m_labelOffsets+m_footer->labelCount+1);
+      m_directory = reinterpret_cast<MissionHistory::SegmentEntry const *>(m_base+m_footer->directory);
+      m_ticks = reinterpret_cast<MissionHistory::TickEntry const *>(m_base+m_footer->ticks);
+
+      // Labels are null terminated within the table
+      uint64_t chars = m_footer->directory-(m_labelChars-m_base);
+      for(uint32_t i=0; valid && i<m_footer->labelCount; ++i)
+	valid = m_labelOffsets[i]<=m_labelOffsets[i+1];
+      valid = valid && m_labelOffsets[m_footer->labelCount]<=chars
+	&& (0==m_footer->labelCount || '\0'==m_labelChars[m_labelOffsets[m_footer->labelCount]-1]);
+
+      // Each segment has to fit before the label table and to match its entry
+      uint64_t rows = 0;
+      for(uint32_t i=0; valid && i<m_footer->segmentCount; ++i) {
+	Segment seg;
+	uint64_t next;
+	valid = m_directory[i].firstRow==rows && locate(m_directory[i].offset, m_footer->labels, seg, next)
+	  && seg.rows==m_directory[i].rows && isValid(seg, rows, m_footer->labelCount);
+	rows += m_directory[i].rows;
+      }
+      valid = valid && rows==m_footer->rows;
+      for(uint32_t i=0; valid && i<m_footer->tickCount; ++i)
+	valid = m_ticks[i].firstRow<rows && (0==i || m_ticks[i-1].tick<m_ticks[i].tick);
+    }
+    if( !valid ) {
+      munmap(base, m_size);
+      throw std::runtime_error("MissionHistory : \""+fileName+"\" is corrupted");
+    }
+    for(uint32_t i=0; i<m_footer->labelCount; ++i)
+      m_labelIds.insert(std::make_pair(std::string(labelOf(i)), i));
+  }
+
+  void MissionHistoryReader::recover(std::string const &fileName) {
+    memset(&m_recoveredFooter, 0, sizeof(m_recoveredFooter));
+    m_recoveredLabelOffsets.push_back(0);
+
+    // Read the segments up to the first one which is not complete
+    uint64_t offset = sizeof(MissionHistory::FileHeader), next;
+    Segment seg;
+    while( locate(offset, m_size, seg, next) ) {
+      uint32_t labelCount = m_recoveredLabelOffsets.size()-1+seg.newLabels;
+      if( 0==seg.rows || !isValid(seg, m_recoveredFooter.rows, labelCount)
+	  || (!m_recoveredTicks.empty() && seg.tick[0]<m_recoveredTicks.back().tick) )
+	break;
+
+      MissionHistory::SegmentEntry entry;
+      entry.offset = offset;
+      entry.firstRow = m_recoveredFooter.rows;
+      entry.rows = seg.rows;
+      entry.firstTick = seg.tick[0];
+      entry.lastTick = seg.tick[entry.rows-1];
+      entry.reserved = 0;
+      m_recoveredDirectory.push_back(entry);
+      for(uint32_t i=0; i<entry.rows; ++i)
+	if( m_recoveredTicks.empty() || m_recoveredTicks.back().tick!=seg.tick[i] ) {
+	  MissionHistory::TickEntry tick;
+	  tick.tick = seg.tick[i];
+	  tick.reserved = 0;
+	  tick.firstRow = entry.firstRow+i;
+	  m_recoveredTicks.push_back(tick);
+	}
+      m_recoveredLabelChars.append(seg.newLabelChars, seg.newLabelOffsets[seg.newLabels]);
+      for(uint32_t i=1; i<=seg.newLabels; ++i)
+	m_recoveredLabelOffsets.push_back(m_recoveredLabelOffsets[labelCount-seg.newLabels]+seg.newLabelOffsets[i]);
+      m_recoveredFooter.rows += entry.rows;
+      offset = next;
+    }
+    debugMsg("trex:warning", "MissionHistory : \""<<fileName<<"\" has no footer. "
+	     <<m_recoveredFooter.rows<<" rows recovered from "<<m_recoveredDirectory.size()<<" segments.");
+
+    m_recoveredFooter.labelCount = m_recoveredLabelOffsets.size()-1;
+    m_recoveredFooter.segmentCount = m_recoveredDirectory.size();
+    m_recoveredFooter.tickCount = m_recoveredTicks.size();
+    m_recovered = true;
+    m_footer = &m_recoveredFooter;
+    m_labelOffsets = &m_recoveredLabelOffsets[0];
+    m_labelChars = m_recoveredLabelChars.c_str();
+    m_directory = m_recoveredDirectory.empty() ? NULL : &m_recoveredDirectory[0];
+    m_ticks = m_recoveredTicks.empty() ? NULL : &m_recoveredTicks[0];
+    for(uint32_t i=0; i<m_footer->labelCount; ++i)
+      m_labelIds.insert(std::make_pair(std::string(labelOf(i)), i));
+  }
+
+  MissionHistoryReader::~MissionHistoryReader() {
+    munmap(const_cast<char *>(m_base), m_size);
+  }
+
+  bool MissionHistoryReader::locate(uint64_t offset, uint64_t end, Segment &seg, uint64_t &next) const {
+    // The sizes are checked before the data they cover is read
+    if( 0!=offset%8 || offset<sizeof(MissionHistory::FileHeader) || offset>end
+	|| end-offset<sizeof(MissionHistory::SegmentHeader) )
+      return false;
+    MissionHistory::SegmentHeader const *header =
+      reinterpret_cast<MissionHistory::SegmentHeader const *>(m_base+offset);
+    uint64_t rows = header->rows;
+    uint64_t used = offset+sizeof(MissionHistory::SegmentHeader)+header->labels*static_cast<uint64_t>(sizeof(uint64_t))
+      +rows*4*sizeof(uint32_t)+(rows+1)*sizeof(uint32_t)+rows;
+    used += padding(used);
+    if( used>end )
+      return false;
+
+    // Segment::entry is only set by segment()
+    seg.entry = NULL;
+    seg.rows = header->rows;
+    seg.labels = header->labels;
+    seg.lastObservation = reinterpret_cast<uint64_t const *>(header+1);
+    seg.tick = reinterpret_cast<uint32_t const *>(seg.lastObservation+seg.labels);
+    seg.timeline = seg.tick+rows;
+    seg.predicate = seg.timeline+rows;
+    seg.key = seg.predicate+rows;
+    seg.text = seg.key+rows;
+    seg.kind = reinterpret_cast<char const *>(seg.text+rows+1);
+    seg.chars = m_base+used;
+    if( seg.text[rows]!=header->textSize || end-used<header->textSize )
+      return false;
+    used += header->textSize;
+    used += padding(used);
+
+    seg.newLabels = header->newLabels;
+    seg.newLabelOffsets = reinterpret_cast<uint32_t const *>(m_base+used);
+    if( used>end || (end-used)/sizeof(uint32_t)<seg.newLabels+static_cast<uint64_t>(1) )
+      return false;
+    used += (seg.newLabels+static_cast<uint64_t>(1))*sizeof(uint32_t);
+    seg.newLabelChars = m_base+used;
+    if( end-used<seg.newLabelOffsets[seg.newLabels] )
+      return false;
+    used += seg.newLabelOffsets[seg.newLabels];
+    used += padding(used);
+    if( used>end )
+      return false;
+
+    next = used;
+    return true;
+  }
+
+  bool MissionHistoryReader::isValid(Segment const &seg, uint64_t firstRow, uint32_t labelCount) const {
+    if( seg.labels>labelCount || seg.newLabels>labelCount )
+      return false;
+    for(uint32_t i=0; i<seg.labels; ++i)
+      if( MissionHistory::NO_ROW!=seg.lastObservation[i] && seg.lastObservation[i]>=firstRow )
+	return false;
+    for(uint32_t i=0; i<seg.rows; ++i)
+      if( seg.timeline[i]>=labelCount || seg.predicate[i]>=labelCount || seg.text[i]>seg.text[i+1]
+	  || (0<i && seg.tick[i-1]>seg.tick[i]) )
+	return false;
+    // Every text and label is null terminated before the end of its table
+    if( 0<seg.rows && (0==seg.text[seg.rows] || '\0'!=seg.chars[seg.text[seg.rows]-1]) )
+      return false;
+    if( 0!=seg.newLabelOffsets[0] )
+      return false;
+    for(uint32_t i=0; i<seg.newLabels; ++i)
+      if( seg.newLabelOffsets[i]>=seg.newLabelOffsets[i+1] )
+	return false;
+    return 0==seg.newLabels || '\0'==seg.newLabelChars[seg.newLabelOffsets[seg.newLabels]-1];
+  }
+
+  MissionHistoryReader::Segment MissionHistoryReader::segment(uint32_t index) const {
+    // Checked when the file was opened
+    Segment seg;
+    uint64_t next;
+    locate(m_directory[index].offset, m_size, seg, next);
+    seg.entry = m_directory+index;
+    return seg;
+  }
+
+  uint32_t MissionHistoryReader::segmentOf(uint64_t row) const {
+    // Last segment starting at or before row
+    uint32_t low = 0, high = m_footer->segmentCount;
+    while( high-low>1 ) {
+      uint32_t mid = low+(high-low)/2;
+      if( m_directory[mid].firstRow<=row )
+	low = mid;
+      else
+	high = mid;
+    }
+    return low;
+  }
+
+  MissionHistoryReader::Event MissionHistoryReader::event(Segment const &seg, uint32_t i) const {
+    Event ev;
+    ev.row = seg.entry->firstRow+i;
+    ev.tick = seg.tick[i];
+    ev.kind = seg.kind[i];
+    ev.timeline = labelOf(seg.timeline[i]);
+    ev.predicate = labelOf(seg.predicate[i]);
+    ev.key = seg.key[i];
+    ev.text = seg.chars+seg.text[i];
+    return ev;
+  }
+
+  bool MissionHistoryReader::labelId(std::string const &str, uint32_t &id) const {
+    std::map<std::string, uint32_t>::const_iterator i = m_labelIds.find(str);
+
+    if( m_labelIds.end()==i )
+      return false;
+    id = i->second;
+    return true;
+  }
+
+  char const *MissionHistoryReader::labelOf(uint32_t id) const {
+    return m_labelChars+m_labelOffsets[id];
+  }
+
+  MissionHistoryReader::Event MissionHistoryReader::get(uint64_t row) const {
+    checkError(row<rows(), "MissionHistoryReader: no row "<<row);
+    Segment seg = segment(segmentOf(row));
+    return event(seg, row-seg.entry->firstRow);
+  }
+
+  uint64_t MissionHistoryReader::lowerBound(TICK tick) const {
+    // First tick entry at or after tick
+    uint32_t low = 0, high = m_footer->tickCount;
+    while( low<high ) {
+      uint32_t mid = low+(high-low)/2;
+      if( m_ticks[mid].tick<tick )
+	low = mid+1;
+      else
+	high = mid;
+    }
+    return low<m_footer->tickCount ? m_ticks[low].firstRow : rows();
+  }
+
+  bool MissionHistoryReader::valueAt(std::string const &timeline, TICK tick, Event &ev) const {
+    uint32_t id;
+
+    if( 0==rows() || !labelId(timeline, id) )
+      return false;
+    uint64_t end = tick>=lastTick() ? rows() : lowerBound(tick+1);
+    if( 0==end )
+      return false;
+
+    // Look back in the segment of the last row at tick, then in the rows before the segment
+    Segment seg = segment(segmentOf(end-1));
+    for(uint32_t i=end-seg.entry->firstRow; i-->0; )
+      if( MissionHistory::OBSERVATION==seg.kind[i] && id==seg.timeline[i] ) {
+	ev = event(seg, i);
+	return true;
+      }
+    uint64_t row = id<seg.labels ? seg.lastObservation[id] : MissionHistory::NO_ROW;
+    if( MissionHistory::NO_ROW==row )
+      return false;
+    ev = get(row);
+    return true;
+  }
+
+  void MissionHistoryReader::select(TICK from, TICK to, char const *kinds, char const *timeline, uint32_t key,
+				    std::vector<Event> &result) const {
+    uint32_t id = 0;
+
+    if( 0==rows() || (NULL!=timeline && !labelId(timeline, id)) )
+      return;
+    uint64_t row = lowerBound(from), end = to>=lastTick() ? rows() : lowerBound(to+1);
+
+    while( row<end ) {
+      Segment seg = segment(segmentOf(row));
+      uint32_t last = seg.entry->rows;
+      if( end-seg.entry->firstRow<last )
+	last = end-seg.entry->firstRow;
+      for(uint32_t i=row-seg.entry->firstRow; i<last; ++i)
+	if( NULL!=strchr(kinds, seg.kind[i])
+	    && (NULL==timeline || id==seg.timeline[i])
+	    && (0==key || key==seg.key[i]) )
+	  result.push_back(event(seg, i));
+      row = seg.entry->firstRow+last;
+    }
+  }
+
+} // TREX
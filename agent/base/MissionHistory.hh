@@ -0,0 +1,400 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "MissionHistory.hh"
+ * @brief Definition of the columnar mission history store
+ */
+#ifndef _MISSIONHISTORY_HH
+#define _MISSIONHISTORY_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "TREXDefs.hh"
+
+namespace TREX {
+
+  /** @brief Layout of the mission history file.
+   *
+   * The history has one row per event of the mission : the
+   * observations posted on every timeline, and the goals dispatched
+   * and recalled. Rows are numbered in the order they occurred,
+   * which is also tick order.
+   *
+   * The file is made of segments of at most @c segmentRows rows.
+   * Each column of a segment is contiguous so a query only touches
+   * the columns it tests. A segment is laid out as :
+   * @li a SegmentHeader
+   * @li @c labels row numbers : the last observation of each label,
+   *     seen as a timeline, before the segment or NO_ROW
+   * @li the @c tick, @c timeline, @c predicate and @c key columns
+   *     as @c uint32_t
+   * @li the @c text column : @c rows+1 offsets in the segment text
+   * @li the @c kind column as one char per row, padded to 8 bytes
+   * @li the segment text, each entry null terminated, padded to 8
+   *     bytes
+   * @li the labels first used in the segment : @c newLabels+1
+   *     offsets followed by the null terminated labels, padded to 8
+   *     bytes
+   *
+   * Once closed the file ends with the label table, the segment
+   * directory, the tick index and the Footer. The label table is
+   * @c labelCount+1 offsets followed by the null terminated labels.
+   * A file without its Footer, such as the history of a mission which
+   * did not terminate, can still be read : the indexes are rebuilt
+   * from its complete segments.
+   * Timelines and predicates are label numbers. Everything is in
+   * host byte order and aligned so that the file can be used in
+   * place once mapped.
+   *
+   * @sa MissionHistoryWriter
+   * @sa MissionHistoryReader
+   */
+  class MissionHistory {
+  public:
+    /** @brief Row number of no row */
+    static const uint64_t NO_ROW = ~static_cast<uint64_t>(0);
+
+    /** @brief Kind of row. Same tags as the binary observation log */
+    enum Kind {
+      OBSERVATION = 'O', //!< New value of a timeline
+      DISPATCH = 'G', //!< Goal dispatched to the owner of its timeline
+      RECALL = 'C' //!< Goal recalled
+    };
+
+    struct FileHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t reserved;
+    };
+
+    struct SegmentHeader {
+      uint32_t rows;
+      uint32_t labels; //!< Number of entries of the last observation table
+      uint32_t textSize; //!< Size of the text, padding excluded
+      uint32_t newLabels; //!< Number of labels first used in this segment
+    };
+
+    /** @brief Entry of the segment directory */
+    struct SegmentEntry {
+      uint64_t offset; //!< Position of the SegmentHeader in the file
+      uint64_t firstRow;
+      uint32_t rows;
+      uint32_t firstTick;
+      uint32_t lastTick;
+      uint32_t reserved;
+    };
+
+    /** @brief Entry of the tick index. There is one entry per tick with rows */
+    struct TickEntry {
+      uint32_t tick;
+      uint32_t reserved;
+      uint64_t firstRow; //!< First row of this tick
+    };
+
+    struct Footer {
+      uint64_t labels; //!< Position of the label table
+      uint64_t directory; //!< Position of the segment directory
+      uint64_t ticks; //!< Position of the tick index
+      uint64_t rows;
+      uint32_t labelCount;
+      uint32_t segmentCount;
+      uint32_t tickCount;
+      uint32_t reserved;
+      char magic[8];
+    };
+
+    static char const *magic();
+    static uint32_t const VERSION = 2;
+  }; // TREX::MissionHistory
+
+  /** @brief Mission history writer.
+   *
+   * Used by Agent to record the mission as it goes. Rows are
+   * buffered by segment and a segment is written and flushed in one
+   * go when it is full. The indexes are kept in memory and written on
+   * close. If the mission does not terminate properly, the reader
+   * rebuilds them from the segments : only the rows of the last,
+   * unwritten, segment are lost. Write errors do not interrupt the
+   * mission ; they are reported on close.
+   *
+   * @sa MissionHistoryReader
+   */
+  class MissionHistoryWriter {
+  public:
+    /** @brief Constructor
+     *
+     * @param fileName Name of the history file
+     * @param segmentRows Maximum number of rows of a segment
+     *
+     * @throw ErrnoExcept the file cannot be created
+     */
+    MissionHistoryWriter(std::string const &fileName, unsigned int segmentRows = 65536);
+    /** @brief Destructor
+     *
+     * Close the file if not done yet
+     */
+    ~MissionHistoryWriter();
+
+    /** @brief Record an observation
+     *
+     * @param tick Current tick
+     * @param obs An observation
+     *
+     * @pre @e tick is not before the tick of the previous row
+     */
+    void observation(TICK tick, Observation const &obs);
+    /** @brief Record a goal dispatch
+     *
+     * @param tick Current tick
+     * @param goal A goal, identified by its key
+     *
+     * @pre @e tick is not before the tick of the previous row
+     */
+    void dispatch(TICK tick, TokenId const &goal);
+    /** @brief Record a goal recall
+     *
+     * @param tick Current tick
+     * @param goal A goal previously dispatched
+     *
+     * @pre @e tick is not before the tick of the previous row
+     */
+    void recall(TICK tick, TokenId const &goal);
+
+    /** @brief Write the last segment and the indexes, then close the file */
+    void close();
+
+    /** @brief Number of rows recorded so far */
+    uint64_t rows() const {
+      return m_firstRow+m_kinds.size();
+    }
+
+  private:
+    MissionHistoryWriter(MissionHistoryWriter const &other);
+    void operator= (MissionHistoryWriter const &other);
+
+    void addGoal(TICK tick, char kind, TokenId const &goal);
+    void addRow(TICK tick, char kind, LabelStr const &timeline, LabelStr const &predicate,
+		uint32_t key, std::string const &text);
+    uint32_t label(LabelStr const &str);
+    void flushSegment();
+    void write(void const *data, size_t size);
+    void pad();
+
+    FILE *m_file;
+    uint64_t m_offset; //!< Bytes written so far
+    bool m_failed; //!< A write failed. Reported on close
+    unsigned int const m_segmentRows;
+
+    std::map<double, uint32_t> m_labelIds;
+    std::vector<std::string> m_labels;
+    uint32_t m_writtenLabels; //!< Labels already written in a segment
+
+    std::vector<MissionHistory::SegmentEntry> m_directory;
+    std::vector<MissionHistory::TickEntry> m_ticks;
+    std::vector<uint64_t> m_lastObservation; //!< Last observation row of each label, as of the start of the segment
+    std::vector<uint64_t> m_nextLastObservation; //!< Same, including the rows of the segment
+
+    // Columns of the current segment
+    uint64_t m_firstRow;
+    std::vector<uint32_t> m_tickColumn, m_timelineColumn, m_predicateColumn, m_keyColumn, m_textColumn;
+    std::vector<char> m_kinds;
+    std::string m_text;
+  }; // TREX::MissionHistoryWriter
+
+  /** @brief Mission history reader.
+   *
+   * Maps a history file and answers queries in place : finding the
+   * rows of a tick is a binary search in the tick index, and the
+   * value of a timeline at a given tick only scans back within one
+   * segment before using the last observation table of that
+   * segment.
+   *
+   * Every offset and size read from the file is checked against its
+   * size when it is opened. A file without its footer is read up to
+   * its last complete segment.
+   *
+   * This class does not depend on the plan database so that it can
+   * be used by off line tools.
+   *
+   * @sa MissionHistoryWriter
+   */
+  class MissionHistoryReader {
+  public:
+    /** @brief A row of the history
+     *
+     * The strings point in the mapped file and are valid as long as
+     * the reader.
+     */
+    struct Event {
+      uint64_t row;
+      TICK tick;
+      char kind; //!< A MissionHistory::Kind
+      char const *timeline;
+      char const *predicate;
+      uint32_t key; //!< Key of the goal, 0 for observations
+      char const *text; //!< Parameters of the row, as "name=domain" separated by spaces
+    };
+
+    /** @brief Constructor
+     *
+     * @param fileName Name of the history file
+     *
+     * @throw ErrnoExcept the file cannot be opened or mapped
+     * @throw std::runtime_error the file is not a history or is corrupted
+     */
+    explicit MissionHistoryReader(std::string const &fileName);
+    ~MissionHistoryReader();
+
+    /** @brief Number of rows */
+    uint64_t rows() const {
+      return m_footer->rows;
+    }
+    /** @brief Number of ticks with rows */
+    uint32_t ticks() const {
+      return m_footer->tickCount;
+    }
+    /** @brief Number of segments */
+    uint32_t segments() const {
+      return m_footer->segmentCount;
+    }
+    /** @brief Size of the file in bytes */
+    size_t size() const {
+      return m_size;
+    }
+    /** @brief True if the file had no footer and its indexes were rebuilt */
+    bool recovered() const {
+      return m_recovered;
+    }
+    /** @brief First tick with rows
+     * @pre 0<ticks()
+     */
+    TICK firstTick() const {
+      return m_ticks[0].tick;
+    }
+    /** @brief Last tick with rows
+     * @pre 0<ticks()
+     */
+    TICK lastTick() const {
+      return m_ticks[m_footer->tickCount-1].tick;
+    }
+
+    /** @brief Access a row
+     * @pre @e row<rows()
+     */
+    Event get(uint64_t row) const;
+    /** @brief First row at or after a tick
+     *
+     * @return The row number, rows() if there is none
+     */
+    uint64_t lowerBound(TICK tick) const;
+
+    /** @brief Value of a timeline at a tick
+     *
+     * @param timeline Name of the timeline
+     * @param tick A tick
+     * @param[out] ev The last observation on @e timeline at or before @e tick
+     *
+     * @retval true @e ev was set
+     * @retval false There is no such observation
+     */
+    bool valueAt(std::string const &timeline, TICK tick, Event &ev) const;
+
+    /** @brief Select rows
+     *
+     * @param from First tick
+     * @param to Last tick
+     * @param kinds Kinds to select, as a string of Kind tags such as "GC"
+     * @param timeline Name of the timeline of the rows, or NULL for any
+     * @param key Key of the goal of the rows, or 0 for any
+     * @param[out] result Where the rows are appended, in row order
+     */
+    void select(TICK from, TICK to, char const *kinds, char const *timeline, uint32_t key,
+		std::vector<Event> &result) const;
+
+  private:
+    MissionHistoryReader(MissionHistoryReader const &other);
+    void operator= (MissionHistoryReader const &other);
+
+    /** @brief Columns of a segment in the mapping */
+    struct Segment {
+      MissionHistory::SegmentEntry const *entry;
+      uint32_t rows;
+      uint32_t labels;
+      uint64_t const *lastObservation;
+      uint32_t const *tick, *timeline, *predicate, *key, *text;
+      char const *kind;
+      char const *chars;
+      uint32_t newLabels;
+      uint32_t const *newLabelOffsets;
+      char const *newLabelChars;
+    };
+
+    Segment segment(uint32_t index) const;
+    bool locate(uint64_t offset, uint64_t end, Segment &seg, uint64_t &next) const;
+    bool isValid(Segment const &seg, uint64_t firstRow, uint32_t labelCount) const;
+    void recover(std::string const &fileName);
+    uint32_t segmentOf(uint64_t row) const;
+    Event event(Segment const &seg, uint32_t i) const;
+    bool labelId(std::string const &str, uint32_t &id) const;
+    char const *labelOf(uint32_t id) const;
+
+    char const *m_base;
+    size_t m_size;
+    MissionHistory::Footer const *m_footer;
+    uint32_t const *m_labelOffsets;
+    char const *m_labelChars;
+    MissionHistory::SegmentEntry const *m_directory;
+    MissionHistory::TickEntry const *m_ticks;
+    std::map<std::string, uint32_t> m_labelIds;
+
+    // Indexes rebuilt from the segments of a file without footer
+    bool m_recovered;
+    MissionHistory::Footer m_recoveredFooter;
+    std::vector<uint32_t> m_recoveredLabelOffsets;
+    std::string m_recoveredLabelChars;
+    std::vector<MissionHistory::SegmentEntry> m_recoveredDirectory;
+    std::vector<MissionHistory::TickEntry> m_recoveredTicks;
+  }; // TREX::MissionHistoryReader
+
+} // TREX
+
+#endif // _MISSIONHISTORY_HH
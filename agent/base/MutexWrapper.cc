@@ -50,10 +50,22 @@ using namespace TREX;
  */
 // Structors :
 
-Mutex::Mutex() {
+Mutex::Mutex(Mutex::Protocol protocol) {
   int ret;
 
-  ret = pthread_mutex_init(&m_mutexId, NULL);
+  if( noProtocol==protocol )
+    ret = pthread_mutex_init(&m_mutexId, NULL);
+  else {
+    pthread_mutexattr_t attr;
+
+    ret = pthread_mutexattr_init(&attr);
+    if( 0==ret ) {
+      ret = pthread_mutexattr_setprotocol(&attr, protocol);
+      if( 0==ret )
+	ret = pthread_mutex_init(&m_mutexId, &attr);
+      pthread_mutexattr_destroy(&attr);
+    }
+  }
   if( 0!=ret )
     throw ErrnoExcept("Mutex::Mutex");
 }
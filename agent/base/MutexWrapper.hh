@@ -57,7 +57,32 @@ namespace TREX {
    */
   class Mutex {
   public:
+    /** @brief Mutex protocol.
+     *
+     * This type is used to set how a mutex affects the priority of
+     * the thread that holds it.
+     */
+    enum Protocol {
+      noProtocol = PTHREAD_PRIO_NONE, //!< Priority is not affected
+      /** @brief Priority inheritance.
+       *
+       * The holder runs at the priority of the highest priority
+       * thread waiting for the mutex. This avoids priority
+       * inversions between real time threads and the threads
+       * they share the mutex with.
+       *
+       * @note Only the TextLog and DbWriter mutexes use it. The
+       * other mutexes the agent thread shares with a worker, such
+       * as those of WorkerPool, SharedVar or AgentClock, do not
+       * and a real time agent thread may still wait for a
+       * preempted holder of one of them.
+       */
+      inheritProtocol = PTHREAD_PRIO_INHERIT
+    }; // Mutex::Protocol
+
     /** @brief Constructor.
+     *
+     * @param protocol The mutex protocol
      *
      * Create a new mutex instance.
      *
@@ -65,7 +90,7 @@ namespace TREX {
      *
      * @throw ErrnoExcept error during mutex resource creation.
      */
-    Mutex();
+    explicit Mutex(Protocol protocol =noProtocol);
     /** @brief Destructor.
      *
      * @throw ErrnoExcept error dur
@@ -155,6 +180,8 @@ namespace TREX {
     // Following functions are not implemented in purpose
     Mutex(Mutex const &);
     void operator= (Mutex const &);
+
+    friend class Condition;
   }; // TREX::Mutex
 
 } // TREX
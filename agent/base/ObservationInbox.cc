@@ -0,0 +1,123 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ObservationInbox.cc"
+ */
+#include <algorithm>
+#include <set>
+
+#include "ObservationInbox.hh"
+
+namespace TREX {
+
+  static size_t roundCapacity(size_t capacity) {
+    size_t result = 1;
+    while( result<capacity )
+      result <<= 1;
+    return result;
+  }
+
+  ObservationInbox::ObservationInbox(size_t capacity, bool coalesce)
+    :m_slots(roundCapacity(capacity), NULL), m_mask(m_slots.size()-1),
+     m_coalesce(coalesce), m_head(0), m_tail(0), m_dropped(0),
+     m_droppedList(NULL), m_coalesced(0) {}
+
+  ObservationInbox::~ObservationInbox() {
+    for(size_t i=m_head; i!=m_tail; ++i)
+      delete m_slots[i&m_mask];
+    release(m_droppedList);
+  }
+
+  void ObservationInbox::release(Dropped *list) {
+    while( NULL!=list ) {
+      Dropped *next = list->next;
+      delete list->obs;
+      delete list;
+      list = next;
+    }
+  }
+
+  bool ObservationInbox::push(Observation *obs) {
+    size_t tail = m_tail;
+    __sync_synchronize();
+    if( tail-m_head>m_mask ) {
+      // Deleting obs here would free EUROPA domains off the agent thread
+      Dropped *dropped = new Dropped;
+      dropped->obs = obs;
+      do {
+	dropped->next = m_droppedList;
+      } while( !__sync_bool_compare_and_swap(&m_droppedList, dropped->next, dropped) );
+      m_dropped = m_dropped+1;
+      return false;
+    }
+    m_slots[tail&m_mask] = obs;
+    // The slot must be written before the consumer can see it
+    __sync_synchronize();
+    m_tail = tail+1;
+    return true;
+  }
+
+  void ObservationInbox::drain(std::vector<Observation *> &observations) {
+    size_t head = m_head, tail = m_tail;
+    __sync_synchronize();
+    size_t first = observations.size();
+
+    for( ; head!=tail; ++head )
+      observations.push_back(m_slots[head&m_mask]);
+    // The slots must be read before the producer can reuse them
+    __sync_synchronize();
+    m_head = head;
+    release(__sync_lock_test_and_set(&m_droppedList, static_cast<Dropped *>(NULL)));
+
+    if( m_coalesce && observations.size()-first>1 ) {
+      // Keep the last observation of each timeline, from the end
+      std::set<double> seen;
+      std::vector<Observation *>::iterator kept = observations.end();
+      for(std::vector<Observation *>::iterator i=observations.end(); observations.begin()+first!=i; ) {
+	--i;
+	if( seen.insert(static_cast<double>((*i)->getObjectName())).second )
+	  *(--kept) = *i;
+	else {
+	  delete *i;
+	  ++m_coalesced;
+	}
+      }
+      observations.erase(observations.begin()+first, kept);
+    }
+  }
+
+}
@@ -0,0 +1,149 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ObservationInbox.hh"
+ * @brief Definition of the observation queue of threaded adapters
+ */
+#ifndef _OBSERVATIONINBOX_HH
+#define _OBSERVATIONINBOX_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <vector>
+
+#include "Observer.hh"
+
+namespace TREX {
+
+  /** @brief Bounded queue of observations from a driver thread.
+   *
+   * A single producer thread, typically the driver of an adapter,
+   * pushes observations that a single consumer, the agent thread,
+   * drains when the adapter synchronizes. The queue is a ring of
+   * pointers indexed by two counters, each written by one side
+   * only, so neither side takes a lock. A push on a full queue
+   * drops the observation. The dropped observations are deleted by
+   * the consumer as it drains, so that the producer never frees
+   * EUROPA domains.
+   *
+   * With coalescing only the last observation drained for each
+   * timeline is kept : a high rate sensor then costs one
+   * observation per tick whatever its rate.
+   *
+   * @note The observations are built by the producer thread. The
+   * labels they use (timeline, predicate, parameter names) should
+   * be created before the thread starts as the EUROPA label table
+   * is not thread safe.
+   *
+   * @sa Adapter::post(Observation *)
+   */
+  class ObservationInbox {
+  public:
+    /** @brief Constructor
+     *
+     * @param capacity Minimum number of observations the queue can
+     * hold. It is rounded to a power of 2.
+     * @param coalesce Keep only the last observation of each
+     * timeline when draining
+     */
+    ObservationInbox(size_t capacity, bool coalesce);
+    /** @brief Destructor
+     *
+     * Deletes the observations not drained.
+     */
+    ~ObservationInbox();
+
+    /** @brief Push an observation
+     *
+     * @param obs An observation. The queue takes its ownership.
+     *
+     * @retval true @e obs was queued
+     * @retval false The queue was full and @e obs was dropped. It
+     * is deleted by the next drain.
+     *
+     * @pre Called by the producer thread
+     */
+    bool push(Observation *obs);
+
+    /** @brief Drain the queue
+     *
+     * @param[out] observations Receives the observations queued, in
+     * the order they were pushed. The caller takes their ownership.
+     *
+     * Deletes the observations dropped since the last drain.
+     *
+     * @pre Called by the consumer thread
+     */
+    void drain(std::vector<Observation *> &observations);
+
+    /** @brief Number of observations dropped as the queue was full */
+    unsigned long dropped() const {
+      return m_dropped;
+    }
+    /** @brief Number of observations superseded by coalescing */
+    unsigned long coalesced() const {
+      return m_coalesced;
+    }
+    /** @brief Maximum number of observations queued */
+    size_t capacity() const {
+      return m_slots.size();
+    }
+
+  private:
+    ObservationInbox(ObservationInbox const &other);
+    void operator= (ObservationInbox const &other);
+
+    /** @brief An observation dropped by the producer */
+    struct Dropped {
+      Observation *obs;
+      Dropped *next;
+    };
+    /** @brief Delete a list of dropped observations */
+    static void release(Dropped *list);
+
+    std::vector<Observation *> m_slots;
+    size_t const m_mask;
+    bool const m_coalesce;
+    volatile size_t m_head; /*!< Observations drained. Written by the consumer */
+    volatile size_t m_tail; /*!< Observations pushed. Written by the producer */
+    volatile unsigned long m_dropped; /*!< Written by the producer */
+    Dropped * volatile m_droppedList; /*!< Pushed by the producer, taken whole by the consumer */
+    unsigned long m_coalesced;
+  }; // TREX::ObservationInbox
+
+} // TREX
+
+#endif // _OBSERVATIONINBOX_HH
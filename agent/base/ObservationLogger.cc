@@ -60,7 +60,7 @@ using namespace TREX;
 ObservationLogger::ObservationLogger(LabelStr const &logName)
   :m_inHeader(true), m_empty(true), 
    m_logName(LogManager::instance().file_name(logName.toString())), 
-   m_logFile(NULL), m_hasData(false) { 
+   m_logFile(NULL), m_hasData(false), m_binary(false), m_binaryLog(NULL) { 
 }
 
 ObservationLogger::~ObservationLogger() {
@@ -69,12 +69,24 @@ ObservationLogger::~ObservationLogger() {
 
 // Modifiers :
 
+void ObservationLogger::setBinary(bool binary) {
+  checkError(NULL==m_logFile, "ObservationLogger: log format selected after file creation.");
+  m_binary = binary;
+}
+
 void ObservationLogger::startFile() {
   
   time_t cur_date;
   debugMsg("ObsLog", "Opening file "<<m_logName.toString());
   m_logFile = fopen(m_logName.c_str(), "w+");
   
+  if( m_binary ) {
+    // Large buffer : records are small and frequent
+    setvbuf(m_logFile, NULL, _IOFBF, 1<<16);
+    m_binaryLog = new BinaryObservationWriter(m_logFile);
+    return;
+  }
+    
     
   time(&cur_date);
   char *str_date = ctime(&cur_date);
@@ -86,6 +98,12 @@ void ObservationLogger::startFile() {
 }
 
 void ObservationLogger::endFile() {
+  if( NULL!=m_binaryLog ) {
+    // The writer owns the file
+    delete m_binaryLog;
+    m_binaryLog = NULL;
+    m_logFile = NULL;
+  }
   if( NULL!=m_logFile ) {
     if( m_hasData ) 
       fprintf(m_logFile, "\t</Tick>\n");
@@ -124,7 +142,7 @@ void ObservationLogger::endHeader(TICK init) {
     
     startFile();
 
-    for( j = decls.begin(); endj!=j ; ++j ) {
+    for( j = decls.begin(); !m_binary && endj!=j ; ++j ) {
       fprintf(m_logFile, "\t\t<Adapter name=\"%s\">\n",j->first.c_str());
       while( !j->second.empty() ) {
 	fprintf(m_logFile, "\t\t\t<Timeline name=\"%s\"/>\n",
@@ -133,7 +151,8 @@ void ObservationLogger::endHeader(TICK init) {
       }
       fprintf(m_logFile,"\t\t</Adapter>\n");
     }
-    fprintf(m_logFile,"\t</Declare>\n");
+    if( !m_binary )
+      fprintf(m_logFile,"\t</Declare>\n");
 //     long pos = ftell(m_logFile);
 //     fprintf(m_logFile, "</Log>\n");
 //     fseek(m_logFile, pos, SEEK_SET);
@@ -145,21 +164,34 @@ void ObservationLogger::endHeader(TICK init) {
 void ObservationLogger::log(Observation const &obs) {
   checkError(!m_inHeader, "ObservationLogger : new observation while in header.");
   
+  if( NULL!=m_logFile && m_timelines.find(obs.getObjectName())!=m_timelines.end() )
+    logDeclared(obs);
+}
+
+void ObservationLogger::logDeclared(Observation const &obs) {
+  checkError(!m_inHeader, "ObservationLogger : new observation while in header.");
+  
   if( NULL!=m_logFile ) {
-    LabelStr timeLine = obs.getObjectName();
-    if( m_timelines.find(timeLine)!=m_timelines.end() ) {
-      debugMsg("ObsLog:log", obs.toString());
+    debugMsg("ObsLog:log", obs.toString());
+    if( m_binary ) {
       if ( m_lastTick!=Agent::instance()->getCurrentTick() || m_empty ) {
 	m_lastTick = Agent::instance()->getCurrentTick();
-	if ( m_hasData ) {
-	  fprintf(m_logFile, "\t</Tick>\n");
-	}
-	fprintf(m_logFile, "\t<Tick value=\"%u\">\n", m_lastTick);
-	m_hasData = true;
+	m_binaryLog->tick(m_lastTick);
       }
       m_empty = false;
-      obs.printXML(m_logFile);
-      fprintf(m_logFile, "\n"); 
+      m_binaryLog->log(obs);
+      return;
+    }
+    if ( m_lastTick!=Agent::instance()->getCurrentTick() || m_empty ) {
+      m_lastTick = Agent::instance()->getCurrentTick();
+      if ( m_hasData ) {
+	fprintf(m_logFile, "\t</Tick>\n");
+      }
+      fprintf(m_logFile, "\t<Tick value=\"%u\">\n", m_lastTick);
+      m_hasData = true;
     }
+    m_empty = false;
+    obs.printXML(m_logFile);
+    fprintf(m_logFile, "\n"); 
   }
 }
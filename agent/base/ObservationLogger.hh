@@ -46,6 +46,7 @@
 #include <cstdio>
 #include "TREXDefs.hh"
 #include "Observer.hh"
+#include "BinaryObservationLog.hh"
 
 namespace TREX {  
   
@@ -103,6 +104,17 @@ namespace TREX {
      * @pre endHeader was previously called.
      */
     void log(Observation const &obs);
+    /** @brief Log an observation on a declared timeline
+     *
+     * @param obs an Observation
+     *
+     * Identical to log() without checking that the timeline of @e obs
+     * is declared. This is used by Agent which already knows it.
+     *
+     * @pre endHeader was previously called.
+     * @pre The timeline of @e obs was declared through declTimeline 
+     */
+    void logDeclared(Observation const &obs);
 
   private:  
     bool m_inHeader; //!< Flag to indicate if we are still in header
@@ -113,6 +125,8 @@ namespace TREX {
     std::map<LabelStr, LabelStr> m_timelines; //!< List of timelines to log
     TICK m_lastTick; //!< Value of current tick 
     bool m_hasData; //!< Flag to indicate if any Observation was already logged during this tick
+    bool m_binary; //!< Flag to indicate that the log is in binary format
+    BinaryObservationWriter *m_binaryLog; //!< Binary log writer. NULL unless in binary format
 
     /** @brief Constructor.
      *
@@ -132,6 +146,13 @@ namespace TREX {
     /** @brief Close the log file.
      */
     void endFile();
+    /** @brief Select the log format
+     *
+     * @param binary true for BinaryObservationLog format, false for XML
+     *
+     * @pre startFile was not called yet
+     */
+    void setBinary(bool binary);
 
     friend class Agent;
   }; // TREX::ObservationLogger
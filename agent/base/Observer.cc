@@ -48,6 +48,11 @@
 
 namespace TREX {
 
+  void Observer::notifyBatch(const std::vector<const Observation*>& observations){
+    for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it)
+      notify(**it);
+  }
+
   /* SIMPLE BASE CLASS */
   Observation::~Observation(){}
 
@@ -135,13 +140,16 @@ namespace TREX {
 
   /* IMPLEMENTATION FOR ObservationByValue */
 
-  ObservationByValue::ObservationByValue(const LabelStr& objectName, const LabelStr& predicateName)
-    : Observation(objectName, predicateName, 0) {}
+  ObservationByValue::ObservationByValue(const LabelStr& objectName, const LabelStr& predicateName, DomainPool* pool)
+    : Observation(objectName, predicateName, 0), m_pool(pool) {}
 
   ObservationByValue::~ObservationByValue(){
     for(unsigned int i = 0; i<m_parameters.size(); i++){
       AbstractDomain* dom = m_parameters[i].second;
-      delete dom;
+      if(m_pool != NULL)
+	m_pool->release(dom);
+      else
+	delete dom;
     }
   }
 
@@ -154,4 +162,37 @@ namespace TREX {
     m_parameters.push_back(std::pair<LabelStr, AbstractDomain*>(name, dom));
     m_parameterCount++;
   }
+
+  void ObservationByValue::reserve(unsigned int parameterCount){
+    m_parameters.reserve(parameterCount);
+  }
+
+  /* IMPLEMENTATION FOR DomainPool */
+  DomainPool::DomainPool(){}
+
+  DomainPool::~DomainPool(){
+    for(std::map< double, std::vector<AbstractDomain*> >::iterator it = m_free.begin(); it != m_free.end(); ++it)
+      for(unsigned int i = 0; i < it->second.size(); i++)
+	delete it->second[i];
+  }
+
+  AbstractDomain* DomainPool::acquire(const DataTypeId& type){
+    std::map< double, std::vector<AbstractDomain*> >::iterator it = m_free.find(type->getName());
+    if(it == m_free.end() || it->second.empty())
+      return type->baseDomain().copy();
+
+    AbstractDomain* dom = it->second.back();
+    it->second.pop_back();
+    dom->relax(type->baseDomain());
+    return dom;
+  }
+
+  void DomainPool::release(AbstractDomain* dom){
+    if(!dom->isInterval()){
+      delete dom;
+      return;
+    }
+
+    m_free[dom->getDataType()->getName()].push_back(dom);
+  }
 }
@@ -45,6 +45,9 @@
 
 #include "EuropaXML.hh"
 
+#include <map>
+#include <vector>
+
 namespace TREX {
 
   /**
@@ -110,9 +113,36 @@ namespace TREX {
     const TokenId m_token;
   };
 
+  /**
+   * @brief Recycles the domains of observations by value. Interval domains, which are the bulk of the numeric
+   * parameters, are reset to the base domain of their type when acquired again. Other domains are just deleted.
+   */
+  class DomainPool {
+  public:
+    DomainPool();
+
+    ~DomainPool();
+
+    /**
+     * @brief A domain equal to the base domain of the given type. The caller owns it until it is released.
+     */
+    AbstractDomain* acquire(const DataTypeId& type);
+
+    void release(AbstractDomain* dom);
+
+  private:
+    DomainPool(const DomainPool&);
+    void operator=(const DomainPool&);
+
+    std::map< double, std::vector<AbstractDomain*> > m_free; /*!< Released domains, by type name */
+  };
+
   class ObservationByValue: public Observation {
   public:
-    ObservationByValue(const LabelStr& objectName, const LabelStr& predicateName);
+    /**
+     * @param pool If not NULL, the parameter domains are released to this pool rather than deleted.
+     */
+    ObservationByValue(const LabelStr& objectName, const LabelStr& predicateName, DomainPool* pool = NULL);
 
     ~ObservationByValue();
 
@@ -120,14 +150,47 @@ namespace TREX {
 
     void push_back(const LabelStr&, AbstractDomain* dom);
 
+    void reserve(unsigned int parameterCount);
+
   private:
     std::vector< std::pair<LabelStr, AbstractDomain*> > m_parameters;
+    DomainPool* const m_pool;
+  };
+
+  /**
+   * @brief An observation with at most N parameters stored in place, so that publishing it does not allocate. The domains
+   * are neither copied nor owned: they must outlive the observation. This suits adapters publishing the same predicates
+   * on every tick from domains they keep.
+   */
+  template <unsigned int N>
+  class FixedObservation: public Observation {
+  public:
+    FixedObservation(const LabelStr& objectName, const LabelStr& predicateName)
+      : Observation(objectName, predicateName, 0) {}
+
+    const std::pair<LabelStr, const AbstractDomain*> operator[](unsigned int index) const {
+      checkError(index < m_parameterCount, "Index " << index << " out of " << m_parameterCount);
+      return m_parameters[index];
+    }
+
+    void push_back(const LabelStr& name, const AbstractDomain* dom){
+      checkError(m_parameterCount < N, "No room for " << name.toString() << " in " << getPredicate().toString());
+      m_parameters[m_parameterCount++] = std::pair<LabelStr, const AbstractDomain*>(name, dom);
+    }
+
+  private:
+    std::pair<LabelStr, const AbstractDomain*> m_parameters[N];
   };
 
   class Observer {
   public:
     virtual void notify(const Observation& observation) = 0;
 
+    /**
+     * @brief Deliver all the observations of a tick at once. The default delivers them one by one.
+     */
+    virtual void notifyBatch(const std::vector<const Observation*>& observations);
+
     virtual ~Observer(){}
   };
 }
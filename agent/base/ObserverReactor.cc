@@ -41,6 +41,7 @@
  * @author Frederic Py <fpy@mbari.org>
  */
 #include "ObserverReactor.hh"
+#include "Adapter.hh"
 #include "StringExtract.hh"
 
 #include "Token.hh"
@@ -53,24 +54,9 @@ using namespace TREX;
 
 // Statics :
 
-// Just a copy/paste from Adapter.cc
+// Shares the parsed configuration files with Adapter
 TiXmlElement const &ObserverReactor::externalConfig(TiXmlElement const &sourceConfig) {
-  static TiXmlElement *sl_xml = NULL;
-  static std::string sl_fileName;
-
-  std::string const newFile = extractData(sourceConfig, "config").c_str();
-  
-  if( NULL==sl_xml ) {
-    sl_xml = LogManager::initXml(newFile);
-    sl_fileName = newFile;
-  }
-
-  if( sl_fileName.find(newFile)!=0 ) {
-    delete sl_xml;
-    sl_xml = LogManager::initXml(newFile);
-    sl_fileName = newFile;    
-  }
-  return *sl_xml;
+  return Adapter::getConfig(extractData(sourceConfig, "config"));
 }
 
 // Just a copy/paste from Adapter.cc
@@ -0,0 +1,125 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Implements latency histograms for the performance monitor
+ */
+
+#include "PerformanceMonitor.hh"
+#include <cstring>
+#include <algorithm>
+
+namespace TREX {
+
+  LatencyHistogram::LatencyHistogram(){
+    reset();
+  }
+
+  void LatencyHistogram::reset(){
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_max = 0;
+    m_total = 0;
+  }
+
+  void LatencyHistogram::record(unsigned long micros){
+    m_buckets[bucketOf(micros)]++;
+    m_count++;
+    m_total += micros;
+    if(micros > m_max)
+      m_max = micros;
+  }
+
+  void LatencyHistogram::recordSince(long long start){
+    record((ClockStat::now(ClockStat::monotonic) - start) / 1000);
+  }
+
+  unsigned long LatencyHistogram::percentile(double q) const {
+    if(m_count == 0)
+      return 0;
+
+    unsigned long rank = (unsigned long) (q * m_count);
+    if(rank >= m_count)
+      rank = m_count - 1;
+
+    unsigned long seen = 0;
+    for(unsigned int i = 0; i < BUCKET_COUNT; i++){
+      seen += m_buckets[i];
+      if(seen > rank)
+	return std::min(upperBound(i), m_max);
+    }
+
+    return m_max;
+  }
+
+  /**
+   * Values below 2*SUB_BUCKETS have their own bucket. Above, a value with its highest bit at position p falls in
+   * one of the SUB_BUCKETS buckets of that power, selected by the SUB_BUCKETS bits that follow.
+   */
+  unsigned int LatencyHistogram::bucketOf(unsigned long micros){
+    if(micros < 2 * SUB_BUCKETS)
+      return micros;
+
+    unsigned int p = 0;
+    for(unsigned long v = micros; v > 1; v >>= 1)
+      p++;
+
+    if(p > MAX_POWER)
+      return BUCKET_COUNT - 1;
+
+    return (p - 3) * SUB_BUCKETS + ((micros >> (p - 4)) & (SUB_BUCKETS - 1));
+  }
+
+  unsigned long LatencyHistogram::upperBound(unsigned int bucket){
+    if(bucket < 2 * SUB_BUCKETS)
+      return bucket;
+
+    unsigned int p = bucket / SUB_BUCKETS + 3;
+    unsigned long sub = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (p - 4)) - 1;
+  }
+
+  void PerformanceMonitor::addTickLateness(double seconds){
+    unsigned long micros = (unsigned long) (seconds * 1e6);
+    if(m_lateness.count() > 0)
+      m_jitter.record(micros > m_lastLateness ? micros - m_lastLateness : m_lastLateness - micros);
+    m_lateness.record(micros);
+    m_lastLateness = micros;
+  }
+
+  const char* PerformanceMonitor::phaseName(Phase phase){
+    static const char* sl_names[PHASE_COUNT] = {"tickStart", "synchronize", "resume", "notify", "dispatch"};
+    return sl_names[phase];
+  }
+}
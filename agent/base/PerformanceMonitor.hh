@@ -37,11 +37,105 @@
  * @brief Defines a performance monitor interface for use by the agent
  */
 #include <vector>
+#include "ClockStat.hh"
 
 namespace TREX {
 
+  /**
+   * @brief Fixed memory latency histogram. Values are recorded in microseconds in log-linear buckets: exact below 32us,
+   * then 16 buckets per power of 2, which bounds the relative error of percentiles to 1/16.
+   */
+  class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    /**
+     * @brief Record a latency in microseconds. Values beyond the largest bucket are counted in the last one.
+     */
+    void record(unsigned long micros);
+
+    /**
+     * @brief Record the time elapsed since start
+     * @param start A date in nanoseconds from ClockStat::now(ClockStat::monotonic)
+     */
+    void recordSince(long long start);
+
+    void reset();
+
+    unsigned long count() const {return m_count;}
+
+    unsigned long max() const {return m_max;}
+
+    /**
+     * @brief Sum of the recorded latencies in microseconds
+     */
+    unsigned long long total() const {return m_total;}
+
+    /**
+     * @brief Get a percentile in microseconds
+     * @param q The rank in [0, 1]. For example 0.99 for p99.
+     * @return The upper bound of the bucket holding the value of rank q, or 0 if empty
+     */
+    unsigned long percentile(double q) const;
+
+    static const unsigned int MAX_POWER = 31; /*!< Largest power of 2 covered, about 35 minutes */
+    static const unsigned int SUB_BUCKETS = 16;
+    static const unsigned int BUCKET_COUNT = (MAX_POWER - 3) * SUB_BUCKETS + SUB_BUCKETS;
+
+  private:
+    static unsigned int bucketOf(unsigned long micros);
+    static unsigned long upperBound(unsigned int bucket);
+
+    unsigned long m_buckets[BUCKET_COUNT];
+    unsigned long m_count;
+    unsigned long m_max;
+    unsigned long long m_total;
+  };
+
+  /**
+   * @brief Scoped elapsed time measurement recorded in a LatencyHistogram on destruction
+   */
+  class LatencyTimer {
+  public:
+    LatencyTimer(LatencyHistogram& histogram): m_histogram(histogram), m_start(ClockStat::now(ClockStat::monotonic)) {}
+    ~LatencyTimer() {m_histogram.recordSince(m_start);}
+
+  private:
+    LatencyHistogram& m_histogram;
+    long long m_start;
+  };
+
+  /**
+   * @brief Entities held by a reactor, measured each time it synchronizes. Only reactors with a plan database fill it.
+   */
+  struct MemoryUsage {
+    MemoryUsage(): tokens(0), variables(0), constraints(0), entities(0) {}
+
+    unsigned int tokens; /*!< Tokens in the plan database, including merged and inactive ones */
+    unsigned int variables; /*!< Variables in the constraint engine */
+    unsigned int constraints; /*!< Constraints in the constraint engine */
+    unsigned int entities; /*!< Tokens, variables and constraints together. The heap is shared by all the reactors, so
+			      this count stands for their memory rather than a figure in bytes */
+  };
+
   class PerformanceMonitor {
   public:
+    /**
+     * @brief The phases of reactor execution for which latencies are recorded
+     */
+    enum Phase {
+      TICK_START = 0, /*!< TeleoReactor::doHandleTickStart */
+      SYNCHRONIZE, /*!< TeleoReactor::doSynchronize */
+      RESUME, /*!< TeleoReactor::doResume, one deliberation step */
+      NOTIFY, /*!< Delivery of an observation to the reactor */
+      DISPATCH, /*!< Delivery of a goal request to the reactor */
+      PHASE_COUNT
+    };
+
+    static const char* phaseName(Phase phase);
+
+    PerformanceMonitor(): m_lastLateness(0) {}
+
     virtual ~PerformanceMonitor(){}
 
     virtual void addTickData(const timeval& synchTime, const timeval& deliberationTime){
@@ -55,8 +149,27 @@ namespace TREX {
 
     const std::vector< std::pair<timeval, timeval> >& getData() const {return m_tickData;}
 
+    /**
+     * @brief Record how late a tick started with respect to its wall clock date
+     * @param seconds The lateness from Clock::getLateness
+     */
+    virtual void addTickLateness(double seconds);
+
+    /**
+     * @brief Lateness of the tick starts, in microseconds
+     */
+    const LatencyHistogram& getLateness() const {return m_lateness;}
+
+    /**
+     * @brief Variation of the lateness from one tick to the next, in microseconds
+     */
+    const LatencyHistogram& getJitter() const {return m_jitter;}
+
   protected:
     std::vector< std::pair<timeval, timeval> > m_tickData;
+    LatencyHistogram m_lateness;
+    LatencyHistogram m_jitter;
+    unsigned long m_lastLateness; /*!< Lateness of the previous tick, in microseconds */
   };
 
 
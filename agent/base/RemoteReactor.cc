@@ -0,0 +1,530 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "RemoteReactor.cc"
+ */
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "RemoteReactor.hh"
+#include "Token.hh"
+#include "PlanDatabase.hh"
+#include "DbClient.hh"
+#include "Server.hh"
+#include "Assembly.hh"
+#include "Utilities.hh"
+#include "ErrnoExcept.hh"
+#include "Guardian.hh"
+#include "Debug.hh"
+
+// Without MSG_NOSIGNAL the socket is set with SO_NOSIGPIPE
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+using namespace TREX;
+
+namespace {
+
+  /** @brief Delay between two connection attempts, in microseconds */
+  useconds_t const RETRY_DELAY = 100000;
+
+  /** @brief Default number of bytes left unsent before the peer is considered lost */
+  size_t const SEND_BACKLOG = 1024*1024;
+
+  /** @brief Default time to wait for a peer in listen mode, in seconds */
+  int const ACCEPT_TIMEOUT = 30;
+
+  unsigned short getPort(char const *spec) {
+    char *end = NULL;
+    long port = strtol(spec, &end, 10);
+    ConfigurationException::configurationCheckError(*spec!='\0' && *end=='\0' && port>0 && port<=65535,
+						    std::string("RemoteReactor: invalid port ")+spec);
+    return static_cast<unsigned short>(port);
+  }
+
+  int getTimeout(TiXmlElement const &configData) {
+    int timeout = (NULL==configData.Attribute("acceptTimeout") ? ACCEPT_TIMEOUT : atoi(configData.Attribute("acceptTimeout")));
+    ConfigurationException::configurationCheckError(timeout>0, "RemoteReactor: acceptTimeout must be positive");
+    return timeout;
+  }
+
+  /** @brief Bound the time a read on @e socket blocks. 0 waits forever */
+  void setReadTimeout(int socket, int seconds) {
+    timeval delay;
+    delay.tv_sec = seconds;
+    delay.tv_usec = 0;
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &delay, sizeof(delay));
+  }
+
+}
+
+/*
+ * class TREX::RemoteReactor::Receiver
+ */
+// Structors :
+
+RemoteReactor::Receiver::Receiver(RemoteReactor &owner, FILE *in)
+  :m_owner(owner), m_reader(in, true) {}
+
+RemoteReactor::Receiver::~Receiver() {
+  join();
+}
+
+// Manipulators :
+
+void *RemoteReactor::Receiver::run() {
+  std::vector<Pending> records;
+  BinaryObservationLog::Record rec;
+  TICK tick;
+
+  // Records are kept as plain strings : LabelStr are only created by the agent thread
+  try {
+    while( m_reader.peek(tick) ) {
+      m_reader.next(rec);
+      if( 'E'==rec.kind )
+	m_owner.received(records);
+      else
+	records.push_back(Pending(tick, rec));
+    }
+  } catch(ConfigurationException *e) {
+    // A corrupted stream ends the connection as a lost peer would
+    m_owner.closed(e->toString());
+    delete e;
+    return NULL;
+  } catch(std::exception const &e) {
+    m_owner.closed(e.what());
+    return NULL;
+  }
+  m_owner.closed("end of stream");
+  return NULL;
+} // RemoteReactor::Receiver::run()
+
+/*
+ * class TREX::RemoteReactor
+ */
+// Statics :
+
+int RemoteReactor::connectPeer(TiXmlElement const &configData) {
+  char const *port = configData.Attribute("listen");
+
+  if( NULL!=port ) {
+    // Only local peers may connect unless another address is given
+    char const *address = (NULL==configData.Attribute("listenAddress") ? "127.0.0.1" : configData.Attribute("listenAddress"));
+    int timeout = getTimeout(configData);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(getPort(port));
+    ConfigurationException::configurationCheckError(1==inet_pton(AF_INET, address, &addr.sin_addr),
+						    std::string("RemoteReactor: invalid listenAddress ")+address);
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if( server<0 )
+      throw ErrnoExcept("RemoteReactor: socket");
+
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if( bind(server, (sockaddr *)&addr, sizeof(addr))<0 || listen(server, 1)<0 ) {
+      ErrnoExcept error("RemoteReactor: bind");
+      close(server);
+      throw error;
+    }
+    TREX_INFO("trex:info", "Waiting for a peer on port "<<port);
+    pollfd waiting;
+    waiting.fd = server;
+    waiting.events = POLLIN;
+    int ready;
+    do {
+      ready = poll(&waiting, 1, 1000*timeout);
+    } while( ready<0 && EINTR==errno );
+    if( 0==ready )
+      errno = ETIMEDOUT;
+    int peer = (ready>0 ? accept(server, NULL, NULL) : -1);
+    if( peer<0 ) {
+      ErrnoExcept error("RemoteReactor: accept");
+      close(server);
+      throw error;
+    }
+    close(server);
+    return peer;
+  }
+
+  std::string address = extractData(configData, "connect").toString();
+  std::string::size_type colon = address.rfind(':');
+  ConfigurationException::configurationCheckError(std::string::npos!=colon,
+						  "RemoteReactor: connect expects host:port, not \""+address+'\"');
+  addrinfo hints, *found;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int ret = getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon+1).c_str(), &hints, &found);
+  ConfigurationException::configurationCheckError(0==ret, "RemoteReactor: unable to resolve \""+address+"\": "+gai_strerror(ret));
+
+  // The peer may not be listening yet
+  unsigned int retries = (NULL==configData.Attribute("retries") ? 50 : atoi(configData.Attribute("retries")));
+  int peer = -1;
+  for(unsigned int attempt=0; peer<0; ++attempt) {
+    for(addrinfo *i=found; NULL!=i && peer<0; i=i->ai_next) {
+      peer = socket(i->ai_family, i->ai_socktype, i->ai_protocol);
+      if( peer>=0 && connect(peer, i->ai_addr, i->ai_addrlen)<0 ) {
+	close(peer);
+	peer = -1;
+      }
+    }
+    if( peer<0 ) {
+      if( attempt>=retries ) {
+	ErrnoExcept error("RemoteReactor: connect");
+	freeaddrinfo(found);
+	throw error;
+      }
+      usleep(RETRY_DELAY);
+    }
+  }
+  freeaddrinfo(found);
+  return peer;
+} // RemoteReactor::connectPeer(TiXmlElement const &)
+
+// Structors :
+
+RemoteReactor::RemoteReactor(LabelStr const &agentName, TiXmlElement const &configData)
+  :TeleoReactor(agentName, configData), m_goalAssembly(NULL), m_socket(-1),
+   m_out(NULL), m_buffer(NULL), m_bufferSize(0),
+   m_maxBacklog(NULL==configData.Attribute("sendBacklog") ? SEND_BACKLOG : atoi(configData.Attribute("sendBacklog"))),
+   m_writer(NULL), m_tickOpen(false), m_receiver(NULL),
+   m_closed(false), m_lost(false), m_sentRecords(0),
+   m_receivedRecords(0), m_droppedRecords(0), m_sendFailures(0) {
+  int timeout = getTimeout(configData);
+
+  for(TiXmlElement const *child = configData.FirstChildElement(); NULL!=child;
+      child = child->NextSiblingElement()) {
+    if( 0==strcmp(child->Value(), "Internal") )
+      m_internals.insert(extractData(*child, "name"));
+    else if( 0==strcmp(child->Value(), "External") )
+      m_externals.insert(extractData(*child, "name"));
+  }
+  ConfigurationException::configurationCheckError(!m_internals.empty() || !m_externals.empty(),
+						  "RemoteReactor: "+getName().toString()+" has no timeline.");
+  if( !m_externals.empty() ) {
+    m_goalAssembly = new Assembly(agentName, getName());
+    m_goalAssembly->playTransactions(findFile(extractData(configData, "model").toString()).c_str());
+  }
+
+  m_socket = connectPeer(configData);
+  int noDelay = 1;
+  setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+  // A lost peer is then reported by send instead of killing the agent
+  int noSigPipe = 1;
+  setsockopt(m_socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+  // The records are written in memory and sent without blocking the agent thread
+  m_out = open_memstream(&m_buffer, &m_bufferSize);
+  if( NULL==m_out )
+    throw ErrnoExcept("RemoteReactor: open_memstream");
+  m_writer = new BinaryObservationWriter(m_out, false);
+  sendTick();
+  // Blocks until the peer sent its magic number, or fails once the timeout is over
+  setReadTimeout(m_socket, timeout);
+  try {
+    m_receiver = new Receiver(*this, fdopen(m_socket, "rb"));
+  } catch(ConfigurationException *) {
+    // The reader closed the socket already
+    delete m_writer;
+    free(m_buffer);
+    delete m_goalAssembly;
+    throw;
+  }
+  setReadTimeout(m_socket, 0);
+  m_receiver->start();
+  TREX_INFO("trex:info", nameString()<<"Connected to its peer with "<<m_internals.size()
+	    <<" internal and "<<m_externals.size()<<" external timelines");
+}
+
+RemoteReactor::~RemoteReactor() {
+  // Let the peer know the stream ended. This closes the memory stream.
+  delete m_writer;
+  if( !m_lost ) {
+    m_unsent.append(m_buffer, m_bufferSize);
+    sendPending();
+  }
+  free(m_buffer);
+  // Wake up the receiver if the peer did not close its side yet
+  shutdown(m_socket, SHUT_RDWR);
+  delete m_receiver;
+  m_goals.clear();
+  delete m_goalAssembly;
+}
+
+// Observers :
+
+void RemoteReactor::queryTimelineModes(std::list<LabelStr> &externals,
+				       std::list<LabelStr> &internals) {
+  internals.assign(m_internals.begin(), m_internals.end());
+  externals.assign(m_externals.begin(), m_externals.end());
+} // RemoteReactor::queryTimelineModes(std::list<LabelStr> &, std::list<LabelStr> &)
+
+void RemoteReactor::writeTelemetry(TelemetrySample &out) const {
+  TeleoReactor::writeTelemetry(out);
+  out.add(getName(), "remote.sent", m_sentRecords);
+  out.add(getName(), "remote.received", m_receivedRecords);
+  out.add(getName(), "remote.dropped", m_droppedRecords);
+  out.add(getName(), "remote.sendFailures", m_sendFailures);
+}
+
+// Manipulators :
+
+void RemoteReactor::handleInit(TICK initialTick,
+			       std::map<double, ServerId> const &serversByTimeline,
+			       ObserverId const &observer) {
+  m_observer = observer;
+  m_servers = serversByTimeline;
+} // RemoteReactor::handleInit(TICK, std::map<double, ServerId> const &, ObserverId const &)
+
+void RemoteReactor::received(std::vector<Pending> &records) {
+  m_lock.lock();
+  m_inbound.insert(m_inbound.end(), records.begin(), records.end());
+  m_lock.unlock();
+  records.clear();
+}
+
+void RemoteReactor::closed(std::string const &reason) {
+  m_lock.lock();
+  m_closed = true;
+  m_closeReason = reason;
+  m_lock.unlock();
+}
+
+bool RemoteReactor::isConnected() {
+  if( m_lost )
+    return false;
+  Guardian<Mutex> guard(m_lock);
+  return !m_closed;
+}
+
+void RemoteReactor::sendTick() {
+  fflush(m_out);
+  long length = ftell(m_out);
+  if( length>0 )
+    m_unsent.append(m_buffer, length);
+  // The memory stream is reused for the next tick
+  fseek(m_out, 0, SEEK_SET);
+  sendPending();
+}
+
+void RemoteReactor::sendPending() {
+  while( !m_unsent.empty() ) {
+    ssize_t sent = ::send(m_socket, m_unsent.data(), m_unsent.size(), MSG_DONTWAIT|MSG_NOSIGNAL);
+    if( sent>0 )
+      m_unsent.erase(0, sent);
+    else if( sent<0 && EINTR==errno )
+      continue;
+    else if( sent<0 && (EAGAIN==errno || EWOULDBLOCK==errno) )
+      break;
+    else {
+      lose(std::string("send failed : ")+strerror(errno));
+      return;
+    }
+  }
+  // The rest is sent at the next tick unless the peer does not keep up
+  if( m_unsent.size()>m_maxBacklog )
+    lose("the peer does not keep up");
+}
+
+void RemoteReactor::lose(std::string const &reason) {
+  TREX_INFO("trex:warning", nameString()<<"Lost the connection to its peer : "<<reason);
+  ++m_sendFailures;
+  m_unsent.clear();
+  m_lost = true;
+  // The receiver ends too, and reports the connection closed
+  shutdown(m_socket, SHUT_RDWR);
+  closed(reason);
+}
+
+void RemoteReactor::openTick() {
+  if( !m_tickOpen ) {
+    m_writer->tick(getCurrentTick());
+    m_tickOpen = true;
+  }
+}
+
+void RemoteReactor::notify(Observation const &observation) {
+  if( m_lost )
+    return;
+  openTick();
+  m_writer->log(observation);
+  ++m_sentRecords;
+}
+
+bool RemoteReactor::handleRequest(TokenId const &goal) {
+  // The peer would never receive the goal
+  if( !isConnected() )
+    return false;
+  openTick();
+  m_writer->request(goal);
+  ++m_sentRecords;
+  return true;
+}
+
+void RemoteReactor::handleRecall(TokenId const &goal) {
+  if( m_lost )
+    return;
+  openTick();
+  m_writer->recall(goal);
+  ++m_sentRecords;
+}
+
+void RemoteReactor::play(BinaryObservationLog::Record const &rec) {
+  if( 'G'==rec.kind ) {
+    LabelStr timeline(rec.timeline);
+    std::map<double, ServerId>::const_iterator server = m_servers.find(timeline);
+
+    if( m_externals.end()==m_externals.find(timeline) || m_servers.end()==server ) {
+      TREX_INFO("trex:warning", nameString()<<"Ignoring a request of its peer on <"<<rec.timeline
+		<<"> : this is not one of its external timelines.");
+      return;
+    }
+    TokenId goal = m_decoder.asGoal(rec, m_goalAssembly->getPlanDatabase()->getClient());
+
+    debugMsg("RemoteReactor", "["<<getName().toString()<<"]["<<getCurrentTick()<<"] request "
+	     <<goal->toString()<<" on < "<<rec.timeline<<" >");
+    m_goals[rec.key] = goal;
+    server->second->request(goal);
+  } else {
+    std::map<int, TokenId>::iterator i = m_goals.find(rec.key);
+
+    if( m_goals.end()==i )
+      return;
+    TokenId goal = i->second;
+    std::map<double, ServerId>::const_iterator server = m_servers.find(Observation::getTimelineName(goal));
+
+    debugMsg("RemoteReactor", "["<<getName().toString()<<"]["<<getCurrentTick()<<"] recall "<<goal->toString());
+    m_goals.erase(i);
+    if( m_servers.end()!=server )
+      server->second->recall(goal);
+    m_goalAssembly->getPlanDatabase()->getClient()->deleteToken(goal);
+  }
+} // RemoteReactor::play(BinaryObservationLog::Record const &)
+
+void RemoteReactor::retireGoals(TICK now) {
+  // The server keeps its own copy : a goal over before now is not needed anymore
+  std::map<int, TokenId>::iterator i = m_goals.begin();
+
+  while( m_goals.end()!=i ) {
+    TokenId goal = i->second;
+
+    if( goal->end()->baseDomain().getUpperBound()<=now ) {
+      debugMsg("RemoteReactor", "["<<getName().toString()<<"]["<<now<<"] retire "<<goal->toString());
+      m_goalAssembly->getPlanDatabase()->getClient()->deleteToken(goal);
+      m_goals.erase(i++);
+    } else
+      ++i;
+  }
+} // RemoteReactor::retireGoals(TICK)
+
+bool RemoteReactor::synchronize() {
+  TICK now = getCurrentTick();
+  std::vector<Pending> ready;
+  bool closed;
+  std::string reason;
+
+  // Only the ticks already reached are delivered
+  m_lock.lock();
+  while( !m_inbound.empty() && m_inbound.front().first<=now ) {
+    ready.push_back(m_inbound.front());
+    m_inbound.pop_front();
+  }
+  closed = m_closed;
+  reason = m_closeReason;
+  m_lock.unlock();
+
+  std::vector<const Observation *> batch;
+  for(std::vector<Pending>::const_iterator i=ready.begin(); ready.end()!=i; ++i) {
+    BinaryObservationLog::Record const &rec = i->second;
+
+    ++m_receivedRecords;
+    try {
+      if( 'O'!=rec.kind )
+	play(rec);
+      else if( m_internals.end()!=m_internals.find(LabelStr(rec.timeline)) )
+	batch.push_back(m_decoder.asObservation(rec));
+    } catch(ConfigurationException *e) {
+      // The other records of the tick are still delivered
+      TREX_INFO("trex:warning", nameString()<<"Dropping a record of its peer : "<<e->toString());
+      ++m_droppedRecords;
+      delete e;
+    }
+  }
+  // Deliver the whole tick at once
+  if( !batch.empty() )
+    m_observer->notifyBatch(batch);
+  for(std::vector<const Observation *>::iterator i=batch.begin(); batch.end()!=i; ++i)
+    delete *i;
+
+  if( !m_goals.empty() )
+    retireGoals(now);
+
+  if( closed && !m_lost ) {
+    TREX_INFO("trex:warning", nameString()<<"Lost the connection to its peer : "<<reason);
+    m_lost = true;
+  }
+
+  // Send this tick as a single message, along with what the socket could not take before
+  if( m_tickOpen && !m_lost ) {
+    m_writer->endTick();
+    sendTick();
+  } else if( !m_unsent.empty() && !m_lost )
+    sendPending();
+  m_tickOpen = false;
+  return true;
+} // RemoteReactor::synchronize()
+
+TREX_REGISTER_REACTOR(RemoteReactor, RemoteReactor);
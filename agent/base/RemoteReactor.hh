@@ -0,0 +1,235 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "RemoteReactor.hh"
+ * @brief Proxy of the reactors of another agent process
+ */
+#ifndef _REMOTEREACTOR_HH
+#define _REMOTEREACTOR_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+#include "TeleoReactor.hh"
+#include "BinaryObservationLog.hh"
+#include "Thread.hh"
+
+namespace TREX {
+
+  class Assembly;
+
+  /** @brief Proxy of the reactors of a peer agent.
+   *
+   * This reactor stands, in the local agent, for the reactors of
+   * another agent process reached through a TCP connection. Its
+   * internal timelines are owned on the peer : the requests and recalls
+   * posted on them are forwarded to the peer which delivers the
+   * observations back. Its external timelines are the local timelines
+   * the peer uses : their observations are forwarded to the peer which
+   * posts its requests back. Both agents declare a proxy with the
+   * timelines swapped :
+   *
+   * @code
+   * <TeleoReactor component="RemoteReactor" name="toAuv" lookAhead="10" latency="1"
+   *               connect="auv:7100" model="mission.nddl">
+   *   <Internal name="navigator"/>
+   *   <External name="mission"/>
+   * </TeleoReactor>
+   * @endcode
+   *
+   * while the peer declares the same proxy with listen="7100", mission
+   * as Internal and navigator as External. The listening side waits
+   * for its peer while it is constructed, for acceptTimeout seconds
+   * (30 by default). Either side then waits as long for the first
+   * bytes of its peer. It only accepts local peers unless listenAddress
+   * gives the address of another interface. The model is needed only
+   * to create the goals requested by the peer. These goals are deleted
+   * once recalled, or once their end is reached as the server has
+   * its own copy.
+   *
+   * A record of the peer that cannot be decoded, or that the model
+   * does not accept, is logged and dropped. The rest of its tick is
+   * still delivered.
+   *
+   * All the records of a tick are written as a binary observation log
+   * stream and sent at once at synchronization. The socket is never
+   * waited for : what it cannot take is sent at the next ticks, and
+   * the peer is considered lost when more than sendBacklog bytes (1MB
+   * by default) are left unsent. A receiving thread
+   * queues each tick as it is complete and the proxy delivers it at
+   * the first synchronization at or after the tick it was stamped
+   * with, so the peers have to share the same clock period. The
+   * network delay is therefore part of the latency of the proxy, and
+   * its lookAhead and latency attributes should cover it, as for any
+   * other reactor.
+   *
+   * Goals are sent by value : the peer gets their last domains, not the
+   * constraints between them. As with the SimAdapter a proxy cannot both
+   * observe and serve the same local reactor. Once the peer is lost,
+   * requests are refused and nothing is sent anymore.
+   */
+  class RemoteReactor :public TeleoReactor {
+  public:
+    /** @brief Constructor
+     *
+     * @param agentName name of the agent
+     * @param configData Configuration data for this instance
+     *
+     * Connects to the peer.
+     *
+     * @throw ErrnoExcept the connection failed or no peer connected in time
+     * @throw ConfigurationException invalid address or port, or the
+     * peer did not send a binary observation log in time
+     */
+    RemoteReactor(LabelStr const &agentName, TiXmlElement const &configData);
+    /** @brief Destructor
+     *
+     * Closes the connection and joins the receiving thread.
+     */
+    ~RemoteReactor();
+
+    void notify(Observation const &observation);
+    bool handleRequest(TokenId const &goal);
+    void handleRecall(TokenId const &goal);
+
+    void queryTimelineModes(std::list<LabelStr> &externals,
+			    std::list<LabelStr> &internals);
+
+    void writeTelemetry(TelemetrySample &out) const;
+
+  private:
+    /** @brief Reception of the peer records */
+    class Receiver :public Thread {
+    public:
+      Receiver(RemoteReactor &owner, FILE *in);
+      ~Receiver();
+
+    private:
+      void *run();
+
+      RemoteReactor &m_owner;
+      BinaryObservationReader m_reader;
+    }; // TREX::RemoteReactor::Receiver
+
+    typedef std::pair<TICK, BinaryObservationLog::Record> Pending;
+
+    void handleInit(TICK initialTick,
+		    std::map<double, ServerId> const &serversByTimeline,
+		    ObserverId const &observer);
+    bool synchronize();
+    bool hasWork() {return false;}
+    void resume() {}
+
+    /** @brief Connection to the peer
+     *
+     * @param configData Configuration of the proxy, with either a
+     * listen or a connect attribute
+     *
+     * @return The connected socket
+     */
+    static int connectPeer(TiXmlElement const &configData);
+
+    /** @brief Test if the peer is still reachable */
+    bool isConnected();
+    /** @brief Send the records written since the last call */
+    void sendTick();
+    /** @brief Send as much of m_unsent as the socket takes without blocking */
+    void sendPending();
+    /** @brief Give up on the peer after a send failure
+     * @param reason What went wrong
+     */
+    void lose(std::string const &reason);
+
+    /** @brief Queue the records of a complete tick
+     *
+     * Called by the receiving thread.
+     */
+    void received(std::vector<Pending> &records);
+    /** @brief Mark the end of the peer stream
+     *
+     * @param reason Why the stream ended
+     *
+     * Called by the receiving thread, or by lose().
+     */
+    void closed(std::string const &reason);
+
+    /** @brief Play a request or a recall received from the peer
+     *
+     * @throw ConfigurationException the goal does not fit the model
+     */
+    void play(BinaryObservationLog::Record const &rec);
+    /** @brief Delete the goals of the peer whose end is reached */
+    void retireGoals(TICK now);
+    /** @brief Start the records of the current tick if not done yet */
+    void openTick();
+
+    std::set<LabelStr> m_internals; //!< Timelines owned by the peer
+    std::set<LabelStr> m_externals; //!< Local timelines used by the peer
+    ObserverId m_observer;
+    std::map<double, ServerId> m_servers; //!< Servers of the external timelines
+    Assembly *m_goalAssembly; //!< Database of the goals requested by the peer. NULL without externals
+    std::map<int, TokenId> m_goals; //!< Goals requested by the peer by their key on the peer, until retired
+
+    int m_socket;
+    FILE *m_out; //!< Memory stream of the records of the current tick
+    char *m_buffer; //!< Content of m_out
+    size_t m_bufferSize;
+    std::string m_unsent; //!< Bytes the socket could not take yet
+    size_t const m_maxBacklog; //!< Largest m_unsent before the peer is considered lost
+    BinaryObservationWriter *m_writer;
+    bool m_tickOpen; //!< true if records were written since the last flush
+    BinaryObservationDecoder m_decoder;
+    Receiver *m_receiver;
+
+    Mutex m_lock; //!< Protects m_inbound, m_closed and m_closeReason
+    std::deque<Pending> m_inbound; //!< Complete ticks received, in order
+    bool m_closed; //!< true once the peer stream ended
+    std::string m_closeReason;
+    bool m_lost; //!< true once the agent thread knows the peer is lost
+
+    unsigned long m_sentRecords;
+    unsigned long m_receivedRecords;
+    unsigned long m_droppedRecords; //!< Received records which could not be played
+    unsigned long m_sendFailures;
+  }; // TREX::RemoteReactor
+
+} // TREX
+
+#endif // _REMOTEREACTOR_HH
@@ -51,12 +51,26 @@ namespace TREX {
      */
     virtual bool request(const TokenId& goal) = 0;
 
+    /**
+     * @brief Commands the server to handle a batch of goals, in order. As for single requests, once a goal is not
+     * received none of the following goals on the same timeline are.
+     * @param goals Tokens from the client database which are to be accomplished.
+     * @param accepted Set to the response to each goal, with the meaning of the return value of request(goal)
+     */
+    virtual void request(const std::vector<TokenId>& goals, std::vector<bool>& accepted) = 0;
+
     /**
      * @brief Commands the server to discard a goal.
      * @param goal A token from the client database which is to be recalled.
      */
     virtual void recall(const TokenId& goal) = 0;
 
+    /**
+     * @brief Commands the server to discard a batch of goals, in order.
+     * @param goals Tokens from the client database which are to be recalled.
+     */
+    virtual void recall(const std::vector<TokenId>& goals) = 0;
+
 
     /**
      * @brief Retrieve the latency it takes to respond. This is used in planning when to dispatch goals. It is a lower bound on dispatch window.
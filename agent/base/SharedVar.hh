@@ -43,6 +43,9 @@
 *  POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstring>
+#include <vector>
+
 #include "Thread.hh"
 #include "Guardian.hh"
 
@@ -244,6 +247,218 @@ namespace TREX {
 
   }; // SharedVar<>
 
+  /** @brief Shared variable read without lock
+   *
+   * This class is a companion of SharedVar for small values read
+   * much more often than written, such as the vehicle state
+   * exposed by an adapter driver thread. It uses a sequence lock :
+   * a writer makes the sequence number odd while it copies the
+   * value and readers retry their copy if the sequence changed in
+   * the meantime. Readers take no lock and never stall the
+   * writers ; they only spin for the duration of a copy.
+   *
+   * @param Ty type of the subjacent variable
+   *
+   * @pre Ty must be trivially copyable (no pointer to itself, no
+   * non trivial copy) as it may be copied while being written.
+   *
+   * @sa SharedVar
+   * @sa RcuVar
+   */
+  template<class Ty>
+  class SeqLockVar {
+  public:
+    /** @brief Constructor.
+     *
+     * @param val A value
+     */
+    SeqLockVar(Ty const &val=Ty())
+      :m_sequence(0), m_var(val) {}
+    /** @brief Destructor */
+    ~SeqLockVar() {}
+
+    /** @brief Write a new value
+     *
+     * @param value A value
+     *
+     * Writers are serialized with a mutex that readers never take.
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    void store(Ty const &value) {
+      Guardian<Mutex> guard(m_writer);
+      m_sequence = m_sequence+1;
+      __sync_synchronize();
+      memcpy(&m_var, &value, sizeof(Ty));
+      __sync_synchronize();
+      m_sequence = m_sequence+1;
+    }
+
+    /** @brief Read the value
+     *
+     * @return A consistent copy of the last value written
+     */
+    Ty load() const {
+      Ty result;
+      while( true ) {
+	unsigned long seq = m_sequence;
+	if( 0==(seq&1) ) {
+	  __sync_synchronize();
+	  memcpy(&result, &m_var, sizeof(Ty));
+	  __sync_synchronize();
+	  if( seq==m_sequence )
+	    return result;
+	}
+      }
+    }
+
+    /** @brief Number of values written */
+    unsigned long version() const {
+      return m_sequence/2;
+    }
+
+  private:
+    Mutex m_writer;
+    /** @brief Sequence number. Odd while a write is in progress */
+    volatile unsigned long m_sequence;
+    /** @brief Variable value */
+    Ty m_var;
+
+    // Following functions have no code in purpose
+    SeqLockVar(SeqLockVar const &);
+    void operator= (SeqLockVar const &);
+  }; // SeqLockVar<>
+
+  /** @brief Shared variable published by copy
+   *
+   * This class is a companion of SharedVar for large values read
+   * much more often than written by a single reader thread. A
+   * writer publishes a new copy of the value and the reader
+   * accesses the last published copy by reference, without lock
+   * nor copy. Previous copies are deleted by the writers once the
+   * reader declared, with quiescent(), that it no longer holds a
+   * reference to them.
+   *
+   * @param Ty type of the subjacent variable
+   *
+   * @pre Ty must support copy construction
+   * @pre Only one thread reads the variable
+   *
+   * @note A reader which never calls quiescent() keeps all the
+   * copies alive.
+   *
+   * @sa SharedVar
+   * @sa SeqLockVar
+   */
+  template<class Ty>
+  class RcuVar {
+  public:
+    /** @brief Constructor.
+     *
+     * @param val A value
+     */
+    RcuVar(Ty const &val=Ty())
+      :m_current(new Ty(val)), m_epoch(0) {}
+    /** @brief Destructor
+     *
+     * @pre The reader does not access this variable anymore
+     */
+    ~RcuVar() {
+      delete m_current;
+      for(typename std::vector<Retired>::iterator i=m_retired.begin(); m_retired.end()!=i; ++i)
+	delete i->value;
+    }
+
+    /** @brief Write a new value
+     *
+     * @param value A value
+     *
+     * Publishes a copy of @e value and deletes the previous copies
+     * the reader no longer refers to. Writers are serialized with a
+     * mutex that the reader never takes.
+     *
+     * @throw ErrnoExcept error during operation.
+     */
+    void store(Ty const &value) {
+      Ty *next = new Ty(value);
+      Guardian<Mutex> guard(m_writer);
+      Retired old;
+      old.value = m_current;
+      // The copy must be complete before the reader can see it
+      __sync_synchronize();
+      m_current = next;
+      __sync_synchronize();
+      // The reader may still have obtained the old copy in its current epoch
+      old.epoch = m_epoch;
+      m_retired.push_back(old);
+      reclaim();
+    }
+
+    /** @brief Read the value
+     *
+     * @return The last value published. The reference stays valid
+     * until the next call to quiescent().
+     *
+     * @pre Called by the reader thread
+     */
+    Ty const &read() const {
+      Ty const *result = m_current;
+      __sync_synchronize();
+      return *result;
+    }
+
+    /** @brief Reader quiescent state
+     *
+     * Indicates that the reader holds no reference obtained from
+     * read() anymore.
+     *
+     * @pre Called by the reader thread
+     */
+    void quiescent() {
+      __sync_synchronize();
+      m_epoch = m_epoch+1;
+      __sync_synchronize();
+    }
+
+    /** @brief Number of copies waiting to be deleted */
+    size_t retired() const {
+      Guardian<Mutex> guard(m_writer);
+      return m_retired.size();
+    }
+
+  private:
+    struct Retired {
+      Ty *value;
+      unsigned long epoch; /*!< Reader epoch when the copy was replaced */
+    };
+
+    void reclaim() {
+      unsigned long epoch = m_epoch;
+      __sync_synchronize();
+      // A copy replaced before the last quiescent state is not referred to anymore
+      size_t kept = 0;
+      for(size_t i=0; i<m_retired.size(); ++i) {
+	if( m_retired[i].epoch<epoch )
+	  delete m_retired[i].value;
+	else
+	  m_retired[kept++] = m_retired[i];
+      }
+      m_retired.resize(kept);
+    }
+
+    mutable Mutex m_writer;
+    /** @brief Last copy published */
+    Ty * volatile m_current;
+    /** @brief Number of quiescent states of the reader */
+    volatile unsigned long m_epoch;
+    /** @brief Copies replaced and not deleted yet */
+    std::vector<Retired> m_retired;
+
+    // Following functions have no code in purpose
+    RcuVar(RcuVar const &);
+    void operator= (RcuVar const &);
+  }; // RcuVar<>
+
 } // TREX
 
 #endif // _SHAREDVAR_HH
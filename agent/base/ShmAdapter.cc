@@ -0,0 +1,257 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ShmAdapter.cc"
+ */
+#include <cstdlib>
+#include <cstring>
+
+#include "ShmAdapter.hh"
+#include "Token.hh"
+#include "TokenVariable.hh"
+#include "Utilities.hh"
+#include "Assembly.hh"
+#include "Debug.hh"
+
+using namespace TREX;
+
+// Structors :
+
+ShmAdapter::ShmAdapter(LabelStr const &agentName, TiXmlElement const &configData)
+  :Adapter(agentName, configData), m_observations(NULL), m_goals(NULL),
+   m_invalid(0) {
+  TiXmlElement const &config = externalConfig(configData);
+
+  for(TiXmlElement const *tl = config.FirstChildElement("Timeline"); NULL!=tl;
+      tl = tl->NextSiblingElement("Timeline")) {
+    m_timelines.push_back(Timeline());
+    Timeline &timeline = m_timelines.back();
+    timeline.name = extractData(*tl, "name");
+
+    for(TiXmlElement const *p = tl->FirstChildElement("Predicate"); NULL!=p;
+	p = p->NextSiblingElement("Predicate")) {
+      timeline.predicates.push_back(Predicate());
+      Predicate &pred = timeline.predicates.back();
+      pred.name = extractData(*p, "name");
+
+      for(TiXmlElement const *param = p->FirstChildElement("Parameter"); NULL!=param;
+	  param = param->NextSiblingElement("Parameter")) {
+	char const *type = param->Attribute("type");
+
+	pred.parameters.push_back(extractData(*param, "name"));
+	if( NULL==type || 0==strcmp(type, "float") )
+	  pred.types.push_back(FloatDT::instance());
+	else if( 0==strcmp(type, "int") )
+	  pred.types.push_back(IntDT::instance());
+	else if( 0==strcmp(type, "bool") )
+	  pred.types.push_back(BoolDT::instance());
+	else
+	  ConfigurationException::configurationCheckError(false, "ShmAdapter: invalid parameter type "+std::string(type));
+      }
+      // Requests also carry the start, end and duration
+      ConfigurationException::configurationCheckError(pred.parameters.size()+3<=ShmRing::MAX_PARAMETERS,
+						      "ShmAdapter: too many parameters for "+pred.name.toString());
+    }
+  }
+
+  uint32_t capacity = (NULL==configData.Attribute("capacity") ? 256 : atoi(configData.Attribute("capacity")));
+  m_observations = new ShmRing(extractData(configData, "observations").toString(), capacity);
+  if( NULL!=configData.Attribute("goals") )
+    m_goals = new ShmRing(configData.Attribute("goals"), capacity);
+  TREX_INFO("trex:info", nameString()<<"Mapped \""<<m_observations->name()<<"\" for "
+	    <<m_timelines.size()<<" timelines");
+}
+
+ShmAdapter::~ShmAdapter() {
+  delete m_observations;
+  delete m_goals;
+}
+
+// Observers :
+
+void ShmAdapter::writeTelemetry(TelemetrySample &out) const {
+  Adapter::writeTelemetry(out);
+  out.add(getName(), "shm.dropped", m_observations->dropped());
+  out.add(getName(), "shm.invalid", m_invalid);
+  if( NULL!=m_goals ) {
+    out.add(getName(), "shm.goalsDropped", m_goals->dropped());
+    out.add(getName(), "shm.recallsPending", m_pendingRecalls.size());
+  }
+}
+
+// Manipulators :
+
+Observation *ShmAdapter::recordAsObservation(size_t index, ShmRing::Record const &rec) {
+  Timeline const &timeline = m_timelines[index];
+  uint32_t predicate = rec.predicate;
+
+  if( predicate>=timeline.predicates.size() )
+    return NULL;
+  Predicate const &pred = timeline.predicates[predicate];
+  // The record is read in place : only the count of the configuration is used once checked
+  unsigned int count = pred.parameters.size();
+  if( rec.count!=count )
+    return NULL;
+  for(unsigned int i=0; i<count; ++i)
+    if( !(rec.bounds[2*i]<=rec.bounds[2*i+1]) )
+      return NULL;
+
+  ObservationByValue *obs = new ObservationByValue(timeline.name, pred.name, &m_domains);
+  obs->reserve(count);
+  for(unsigned int i=0; i<count; ++i) {
+    IntervalDomain *dom = dynamic_cast<IntervalDomain *>(m_domains.acquire(pred.types[i]));
+
+    checkError(NULL!=dom, "ShmAdapter: "<<pred.parameters[i].toString()<<" is not an interval domain type.");
+    dom->intersect(rec.bounds[2*i], rec.bounds[2*i+1]);
+    obs->push_back(pred.parameters[i], dom);
+  }
+  return obs;
+} // ShmAdapter::recordAsObservation(size_t, ShmRing::Record const &)
+
+bool ShmAdapter::flushRecalls() {
+  size_t sent = 0;
+  while( sent<m_pendingRecalls.size() && m_goals->push(m_pendingRecalls[sent]) )
+    ++sent;
+  m_pendingRecalls.erase(m_pendingRecalls.begin(), m_pendingRecalls.begin()+sent);
+  return m_pendingRecalls.empty();
+} // ShmAdapter::flushRecalls()
+
+bool ShmAdapter::synchronize() {
+  if( !m_pendingRecalls.empty() )
+    flushRecalls();
+
+  uint64_t n = m_observations->available();
+  if( 0==n )
+    return true;
+
+  // A timeline holds a single value per tick : only its last record is used
+  std::vector<ShmRing::Record const *> last(m_timelines.size(), NULL);
+  for(uint64_t i=0; i<n; ++i) {
+    ShmRing::Record const &rec = m_observations->peek(i);
+    uint32_t timeline = rec.timeline;
+    if( ShmRing::OBSERVATION==rec.kind && timeline<m_timelines.size() )
+      last[timeline] = &rec;
+    else
+      ++m_invalid;
+  }
+
+  std::vector<const Observation *> batch;
+  for(size_t i=0; i<last.size(); ++i) {
+    if( NULL==last[i] )
+      continue;
+    Observation *obs = recordAsObservation(i, *last[i]);
+    if( NULL==obs )
+      ++m_invalid;
+    else
+      batch.push_back(obs);
+  }
+  // The records are copied in the domains : the producer can reuse them
+  m_observations->release(n);
+
+  if( !batch.empty() )
+    sendNotify(batch);
+  for(std::vector<const Observation *>::const_iterator i=batch.begin(); batch.end()!=i; ++i)
+    delete *i;
+  return true;
+} // ShmAdapter::synchronize()
+
+ShmAdapter::Predicate const *ShmAdapter::locate(TokenId const &goal, ShmRing::Record &rec) const {
+  LabelStr name = Observation::getTimelineName(goal);
+
+  memset(&rec, 0, sizeof(rec));
+  for(rec.timeline=0; rec.timeline<m_timelines.size(); ++rec.timeline) {
+    Timeline const &timeline = m_timelines[rec.timeline];
+    if( timeline.name!=name )
+      continue;
+    for(rec.predicate=0; rec.predicate<timeline.predicates.size(); ++rec.predicate)
+      if( timeline.predicates[rec.predicate].name==goal->getPredicateName() )
+	return &timeline.predicates[rec.predicate];
+    return NULL;
+  }
+  return NULL;
+} // ShmAdapter::locate(TokenId const &, ShmRing::Record &)
+
+bool ShmAdapter::handleRequest(TokenId const &goal) {
+  if( NULL==m_goals )
+    return true;
+  // A request must not overtake the recalls sent before it
+  if( !m_pendingRecalls.empty() && !flushRecalls() )
+    return false;
+
+  ShmRing::Record rec;
+  Predicate const *pred = locate(goal, rec);
+  if( NULL==pred ) {
+    TREX_INFO("trex:warning", nameString()<<"Ignoring "<<goal->toString()<<" : its predicate is not configured.");
+    return true;
+  }
+  rec.kind = ShmRing::REQUEST;
+  rec.key = goal->getKey();
+  rec.count = pred->parameters.size();
+  rec.bounds[0] = goal->start()->lastDomain().getLowerBound();
+  rec.bounds[1] = goal->start()->lastDomain().getUpperBound();
+  rec.bounds[2] = goal->end()->lastDomain().getLowerBound();
+  rec.bounds[3] = goal->end()->lastDomain().getUpperBound();
+  rec.bounds[4] = goal->duration()->lastDomain().getLowerBound();
+  rec.bounds[5] = goal->duration()->lastDomain().getUpperBound();
+  for(unsigned int i=0; i<rec.count; ++i) {
+    ConstrainedVariableId var = goal->getVariable(pred->parameters[i]);
+
+    checkError(var.isId(), goal->toString()<<" has no variable "<<pred->parameters[i].toString());
+    rec.bounds[2*i+6] = var->lastDomain().getLowerBound();
+    rec.bounds[2*i+7] = var->lastDomain().getUpperBound();
+  }
+  // A full ring is retried at the next tick
+  return m_goals->push(rec);
+} // ShmAdapter::handleRequest(TokenId const &)
+
+void ShmAdapter::handleRecall(TokenId const &goal) {
+  if( NULL==m_goals )
+    return;
+
+  ShmRing::Record rec;
+  if( NULL==locate(goal, rec) )
+    return;
+  rec.kind = ShmRing::RECALL;
+  rec.key = goal->getKey();
+  // A recall cannot be refused : it is kept until the ring has room
+  m_pendingRecalls.push_back(rec);
+  if( !flushRecalls() )
+    TREX_INFO("trex:warning", nameString()<<"Recall of "<<goal->toString()<<" delayed as \""
+	      <<m_goals->name()<<"\" is full");
+} // ShmAdapter::handleRecall(TokenId const &)
+
+TREX_REGISTER_REACTOR(ShmAdapter, ShmAdapter);
@@ -0,0 +1,131 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ShmAdapter.hh"
+ * @brief Definition of the shared memory adapter
+ */
+#ifndef _SHMADAPTER_HH
+#define _SHMADAPTER_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Adapter.hh"
+#include "Observer.hh"
+#include "DataTypes.hh"
+#include "ShmRing.hh"
+
+namespace TREX {
+
+  /** @brief Adapter to another process through shared memory.
+   *
+   * Observations are read in place from a ShmRing written by the
+   * other process and goals are written to a second ring, so that
+   * the process, such as a navigation stack, exchanges fixed
+   * layout records with the agent without any serialization. A
+   * record refers to timelines, predicates and parameters by their
+   * position in the adapter configuration :
+   *
+   * @code
+   * <Adapter component="ShmAdapter" name="nav" observations="/nav.obs" goals="/nav.goals" capacity="256">
+   *   <Timeline name="navigator">
+   *     <Predicate name="Navigator.Holds">
+   *       <Parameter name="x"/>
+   *       <Parameter name="speed" type="int"/>
+   *     </Predicate>
+   *   </Timeline>
+   * </Adapter>
+   * @endcode
+   *
+   * Parameter types are float (the default), int or bool, with at
+   * most ShmRing::MAX_PARAMETERS-3 parameters. At each
+   * synchronization the last observation of each timeline is sent
+   * and the others are released unread. Requests are pushed when
+   * received and published again at the next tick if the goal ring
+   * is full. Recalls which find the ring full are kept, in order,
+   * and pushed before any later request. Without the goals
+   * attribute the adapter accepts goals and ignores them.
+   *
+   * @sa ShmRing
+   */
+  class ShmAdapter :public Adapter {
+  public:
+    ShmAdapter(LabelStr const &agentName, TiXmlElement const &configData);
+    ~ShmAdapter();
+
+    void writeTelemetry(TelemetrySample &out) const;
+
+  private:
+    bool synchronize();
+    bool handleRequest(TokenId const &goal);
+    void handleRecall(TokenId const &goal);
+
+    struct Predicate {
+      LabelStr name;
+      std::vector<LabelStr> parameters;
+      std::vector<DataTypeId> types;
+    };
+    struct Timeline {
+      LabelStr name;
+      std::vector<Predicate> predicates;
+    };
+
+    /** @brief Conversion of an observation record read in place
+     * @param index Index of the timeline of the record, as checked by the caller
+     * @param rec The record
+     * @return The observation, or NULL if the record does not match the configuration
+     */
+    Observation *recordAsObservation(size_t index, ShmRing::Record const &rec);
+    /** @brief Position of a goal in the configuration
+     * @param goal A goal
+     * @param[out] rec Receives the timeline and predicate indices of @e goal
+     * @return The configuration of the goal predicate, or NULL if it is not configured
+     */
+    Predicate const *locate(TokenId const &goal, ShmRing::Record &rec) const;
+    /** @brief Push the recalls delayed by a full goal ring
+     * @return true if none is left
+     */
+    bool flushRecalls();
+
+    std::vector<Timeline> m_timelines;
+    ShmRing *m_observations; //!< Records from the other process
+    ShmRing *m_goals; //!< Records to the other process. NULL if no goal is sent
+    std::vector<ShmRing::Record> m_pendingRecalls; //!< Recalls waiting for room in m_goals
+    DomainPool m_domains; //!< Recycled parameter domains
+    unsigned long m_invalid; //!< Observation records not matching the configuration
+  }; // TREX::ShmAdapter
+
+} // TREX
+
+#endif // _SHMADAPTER_HH
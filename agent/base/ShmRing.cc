@@ -0,0 +1,179 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ShmRing.cc"
+ */
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ShmRing.hh"
+#include "ErrnoExcept.hh"
+
+namespace TREX {
+
+  /** @param created Name of the segment to unlink, NULL if it was not created */
+  static void fail(int fd, std::string const &from, char const *created = NULL) {
+    int err = errno;
+    if( fd>=0 )
+      close(fd);
+    if( NULL!=created )
+      shm_unlink(created);
+    errno = err;
+    throw ErrnoExcept(from);
+  }
+
+  /** @brief Pause between two checks of a segment being initialized, in microseconds */
+  static const useconds_t WAIT_STEP = 10000;
+  /** @brief Number of checks before giving up on a segment being initialized */
+  static const unsigned int WAIT_STEPS = 100;
+
+  ShmRing::ShmRing(std::string const &name, uint32_t capacity)
+    :m_name(name), m_created(false), m_size(0), m_capacity(0), m_header(NULL), m_records(NULL) {
+    // Only one of the processes can create the segment
+    int fd = shm_open(name.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+    m_created = (fd>=0);
+    if( !m_created ) {
+      if( EEXIST!=errno )
+	fail(fd, "ShmRing shm_open "+name);
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+      if( fd<0 )
+	fail(fd, "ShmRing shm_open "+name);
+    }
+
+    if( m_created ) {
+      m_size = sizeof(Header)+static_cast<size_t>(capacity)*sizeof(Record);
+      if( 0==capacity ) {
+	close(fd);
+	shm_unlink(name.c_str());
+	throw std::runtime_error("ShmRing : \""+name+"\" cannot be created without records");
+      }
+      if( 0!=ftruncate(fd, m_size) )
+	fail(fd, "ShmRing ftruncate "+name, name.c_str());
+    } else {
+      // The creator may not have sized the segment yet
+      struct stat info;
+      for(unsigned int i=0; ; ++i) {
+	if( 0!=fstat(fd, &info) )
+	  fail(fd, "ShmRing fstat "+name);
+	if( static_cast<size_t>(info.st_size)>=sizeof(Header) )
+	  break;
+	if( WAIT_STEPS==i ) {
+	  close(fd);
+	  throw std::runtime_error("ShmRing : \""+name+"\" was not initialized by its creator");
+	}
+	usleep(WAIT_STEP);
+      }
+      m_size = info.st_size;
+    }
+
+    void *base = mmap(NULL, m_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if( MAP_FAILED==base )
+      fail(fd, "ShmRing mmap "+name, m_created ? name.c_str() : NULL);
+    close(fd);
+    m_header = static_cast<Header *>(base);
+    m_records = reinterpret_cast<Record *>(m_header+1);
+
+    if( m_created ) {
+      memset(base, 0, sizeof(Header));
+      m_header->recordSize = sizeof(Record);
+      m_header->capacity = capacity;
+      m_capacity = capacity;
+      // The layout must be complete before the segment looks initialized
+      __sync_synchronize();
+      m_header->magic = MAGIC;
+      return;
+    }
+
+    // The creator may not have written the layout yet
+    for(unsigned int i=0; MAGIC!=*static_cast<uint32_t volatile *>(&m_header->magic); ++i) {
+      if( WAIT_STEPS==i ) {
+	munmap(base, m_size);
+	throw std::runtime_error("ShmRing : \""+name+"\" was not initialized by its creator");
+      }
+      usleep(WAIT_STEP);
+    }
+    __sync_synchronize();
+    // The other process could change the header later : only the copy checked here is used
+    m_capacity = m_header->capacity;
+    if( sizeof(Record)!=m_header->recordSize || 0==m_capacity
+	|| (m_size-sizeof(Header))/sizeof(Record)<m_capacity ) {
+      munmap(base, m_size);
+      throw std::runtime_error("ShmRing : \""+name+"\" is not a ring with the same record layout");
+    }
+  }
+
+  ShmRing::~ShmRing() {
+    munmap(m_header, m_size);
+    if( m_created )
+      shm_unlink(m_name.c_str());
+  }
+
+  bool ShmRing::push(Record const &rec) {
+    uint64_t tail = m_header->tail;
+    __sync_synchronize();
+    if( tail-m_header->head>=m_capacity ) {
+      m_header->dropped = m_header->dropped+1;
+      return false;
+    }
+    m_records[tail%m_capacity] = rec;
+    // The record must be written before the consumer can see it
+    __sync_synchronize();
+    m_header->tail = tail+1;
+    return true;
+  }
+
+  uint64_t ShmRing::available() const {
+    uint64_t result = m_header->tail-m_header->head;
+    // The records must be read after the counter
+    __sync_synchronize();
+    // A producer claiming more records than the ring holds is not trusted
+    return result>m_capacity ? m_capacity : result;
+  }
+
+  void ShmRing::release(uint64_t n) {
+    // The records must be read before the producer can reuse them
+    __sync_synchronize();
+    m_header->head = m_header->head+n;
+  }
+
+}
@@ -0,0 +1,205 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "ShmRing.hh"
+ * @brief Definition of the shared memory record ring
+ */
+#ifndef _SHMRING_HH
+#define _SHMRING_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <string>
+
+#include <stdint.h>
+
+namespace TREX {
+
+  /** @brief Ring of fixed layout records in shared memory.
+   *
+   * The ring lives in a POSIX shared memory segment so that
+   * another process on the same computer can exchange records with
+   * the agent without serialization. It has a single producer and
+   * a single consumer, possibly in different processes : each one
+   * writes its own counter in the segment header so neither takes
+   * a lock. A push on a full ring is dropped and counted.
+   *
+   * The segment starts with a Header followed by @c capacity
+   * records. Counters only grow ; record @c n is at index
+   * @c n%capacity. A process written in another language only
+   * needs to follow this layout and publish a record by writing it
+   * before incrementing @c tail.
+   *
+   * @sa ShmAdapter
+   */
+  class ShmRing {
+  public:
+    /** @brief Maximum number of parameters of a record */
+    static const unsigned int MAX_PARAMETERS = 16;
+    /** @brief Marker of an initialized segment */
+    static const uint32_t MAGIC = 0x54524558; // "TREX"
+
+    /** @brief Kind of record */
+    enum Kind {
+      OBSERVATION = 0, //!< New value of a timeline
+      REQUEST, //!< Goal posted on a timeline
+      RECALL //!< Goal recalled
+    };
+
+    /** @brief Record layout
+     *
+     * Each parameter is given by its lower and upper bounds. The
+     * bounds of a request start with the ones of its start, end and
+     * duration.
+     */
+    struct Record {
+      uint32_t kind; //!< A Kind
+      uint32_t timeline; //!< Index of the timeline in the adapter configuration
+      uint32_t predicate; //!< Index of the predicate in its timeline configuration
+      uint32_t count; //!< Number of parameters, not counting the start, end and duration of requests
+      uint64_t key; //!< Goal key of requests and recalls
+      double bounds[2*MAX_PARAMETERS];
+    };
+
+    /** @brief Segment header layout
+     *
+     * The counters are on separate cache lines as they are written
+     * by different processes.
+     */
+    struct Header {
+      uint32_t magic;
+      uint32_t recordSize; //!< sizeof(Record) of the creator
+      uint32_t capacity; //!< Number of records
+      uint32_t reserved;
+      char pad1[48];
+      volatile uint64_t head; //!< Records consumed. Written by the consumer
+      char pad2[56];
+      volatile uint64_t tail; //!< Records produced. Written by the producer
+      volatile uint64_t dropped; //!< Records dropped. Written by the producer
+      char pad3[48];
+    };
+
+    /** @brief Constructor
+     *
+     * @param name Name of the shared memory segment, such as "/nav"
+     * @param capacity Number of records of the ring if it is created
+     *
+     * Maps the segment, creating and initializing it if it does not
+     * exist yet. Otherwise waits for the process which created it to
+     * initialize it, for up to a second.
+     *
+     * @throw ErrnoExcept the segment cannot be created or mapped
+     * @throw std::runtime_error the segment exists with another
+     * layout or was not initialized in time
+     */
+    ShmRing(std::string const &name, uint32_t capacity);
+    /** @brief Destructor
+     *
+     * Unmaps the segment. The process which created the segment also
+     * unlinks it : the other process keeps its mapping, but the next
+     * ring opened with this name is a new segment.
+     */
+    ~ShmRing();
+
+    /** @brief Push a record
+     *
+     * @param rec A record
+     *
+     * @retval true @e rec was copied in the ring
+     * @retval false The ring was full
+     *
+     * @pre Called by the producer
+     */
+    bool push(Record const &rec);
+
+    /** @brief Number of records ready
+     *
+     * @pre Called by the consumer
+     */
+    uint64_t available() const;
+    /** @brief Access a record ready in place
+     *
+     * @param i Index of the record, from the oldest one ready
+     *
+     * @return The record. It stays valid until it is released.
+     *
+     * @pre @e i<available()
+     * @pre Called by the consumer
+     */
+    Record const &peek(uint64_t i) const {
+      return m_records[(m_header->head+i)%m_capacity];
+    }
+    /** @brief Release records
+     *
+     * @param n Number of records, from the oldest one, to release
+     *
+     * @pre @e n<=available()
+     * @pre Called by the consumer
+     */
+    void release(uint64_t n);
+
+    /** @brief Number of records dropped because the ring was full */
+    uint64_t dropped() const {
+      return m_header->dropped;
+    }
+    /** @brief Number of records of the ring */
+    uint32_t capacity() const {
+      return m_capacity;
+    }
+    /** @brief Segment name */
+    std::string const &name() const {
+      return m_name;
+    }
+    /** @brief Test if this process created the segment */
+    bool created() const {
+      return m_created;
+    }
+
+  private:
+    ShmRing(ShmRing const &other);
+    void operator= (ShmRing const &other);
+
+    std::string const m_name;
+    bool m_created; //!< This process created the segment and unlinks it
+    size_t m_size;
+    uint32_t m_capacity; //!< Capacity checked against the size of the mapping when opened
+    Header *m_header;
+    Record *m_records;
+  }; // TREX::ShmRing
+
+} // TREX
+
+#endif // _SHMRING_HH
@@ -43,12 +43,18 @@
 #include "Utils.hh"
 #include "Domains.hh"
 #include "Token.hh"
+#include "TokenVariable.hh"
+#include "PlanDatabase.hh"
+#include "DbClient.hh"
+#include "Server.hh"
 #include "Adapter.hh"
 #include "Assembly.hh"
 #include "SimAdapter.hh"
 #include "Agent.hh"
 #include "Utilities.hh"
 
+#include <cstring>
+
 using namespace TREX;
 
 /*
@@ -266,102 +272,181 @@ Observation *SimAdapter::xmlAsObservation(TiXmlElement const &elem) {
 
 SimAdapter::SimAdapter(LabelStr const&agentName, 
 		       TiXmlElement const &configData) 
-  :TeleoReactor(agentName, configData), m_lastBacktracked(-1),
+  :TeleoReactor(agentName, configData), m_xmlReader(NULL), m_lastBacktracked(-1),
    m_floatDT(FloatDT::instance()),
    m_intDT(IntDT::instance()),
    m_boolDT(BoolDT::instance()),
    m_stringDT(StringDT::instance()),
    m_symbolDT(SymbolDT::instance()){
   std::string s = agentName.toString() + ".log";
-  std::string file_name = findFile(s);
-  TiXmlDocument xml_log(LogManager::use(file_name));
-
-  TREX_INFO("trex:info", "Loading log input file \""<<file_name<<'\"');
-  ConfigurationException::configurationCheckError(xml_log.LoadFile(), nameString() + "Unable to load xml file \"" + file_name + '\"');
-
+  char const *trace = configData.Attribute("trace");
+  std::string file_name = findFile(NULL!=trace ? std::string(trace) : s);
+
+  m_goalAssembly = NULL;
+  if( NULL!=trace ) {
+    char const *requests = configData.Attribute("requests");
+
+    if( NULL!=requests && 0==strcmp(requests, "true") ) {
+      TREX_INFO("trex:info", "Streaming requests of input trace \""<<file_name<<'\"');
+      m_goalAssembly = new Assembly(agentName, getName());
+      m_goalAssembly->playTransactions(findFile(extractData(configData, "model").toString()).c_str());
+
+      // The timelines have to be known before the agent starts
+      BinaryObservationReader scan(LogManager::use(file_name), true);
+      BinaryObservationLog::Record rec;
+      TICK tick;
+      while( scan.peek(tick) ) {
+	scan.next(rec);
+	if( 'G'==rec.kind )
+	  m_externals.insert(LabelStr(rec.timeline));
+      }
+    } else
+      Adapter::getTimelines(m_internals,  Adapter::externalConfig(configData));
+    m_reader = new BinaryObservationReader(LogManager::use(file_name), NULL!=m_goalAssembly);
+    return;
+  }
 
   Adapter::getTimelines(m_internals,  Adapter::externalConfig(configData));
 
-  loadObservations(xml_log);
-  
+  if( BinaryObservationLog::isBinary(file_name) ) {
+    TREX_INFO("trex:info", "Streaming binary log input file \""<<file_name<<'\"');
+    m_reader = new BinaryObservationReader(LogManager::use(file_name));
+    return;
+  }
+  m_reader = NULL;
+
+  TREX_INFO("trex:info", "Streaming log input file \""<<file_name<<'\"');
+  m_xmlReader = new XmlObservationReader(file_name, m_internals);
 } // SimAdapter::SimAdapter
 
-SimAdapter::~SimAdapter() {}
+SimAdapter::~SimAdapter() {
+  delete m_reader;
+  m_goals.clear();
+  delete m_goalAssembly;
+  delete m_xmlReader;
+}
 
 // Modifiers :
 
-void SimAdapter::loadObservations(TiXmlDocument const &file) {
-  debugMsg("SimAdapter", "["<<getName().toString()<<"] : loading observation history.");
-  TICK maxTick = 0;
-
-
-  for(TiXmlElement const *tick=firstPath(&file, "Log/Tick")->ToElement();
-      NULL!=tick; tick=tick->NextSiblingElement()) 
-    if( 0==strcmp(tick->Value(), "Tick") ) {
-      std::pair<TICK, Observation *> entry;
-
-      entry.first = strtol(tick->Attribute("value"), NULL, 0);
-
-      if( entry.first>maxTick )
-	maxTick = entry.first;
-
-       debugMsg("SimAdapter", "["<<getName().toString()<<"] : observations for tick "<<entry.first);
-      for(TiXmlElement const *elem = tick->FirstChildElement();
-	  NULL!=elem; elem=elem->NextSiblingElement()) {
-	LabelStr timeline = elem->Attribute("on");
-	
-	if( m_internals.find(timeline)!=m_internals.end() ) {
- 	  debugMsg("SimAdapter", "["<<getName().toString()<<"] \t - on <"<<timeline.toString()<<">");
-
-	  entry.second = xmlAsObservation(*elem);
-	  m_log.insert(entry);
-	}
-      }
-    }
-  debugMsg("SimAdapter", "["<<getName().toString()<<"] : observation history loaded ("<<maxTick<<", "<<m_log.size()<<").");
-  m_nextObs = m_log.begin();
-}
-
 void SimAdapter::handleInit(TICK initialTick, 
 			    std::map<double, ServerId> const &serversByTimeline,
 			    ObserverId const &observer) {
   m_observer = observer;
+  m_servers = serversByTimeline;
 } // SimAdapter::handleInit(TICK, std::map<double, ServerId> const &, ObserverId const &)
 
-bool SimAdapter::synchronize() {
-  if( m_log.end()!=m_nextObs ) {
-    TICK curTick = getCurrentTick();
+void SimAdapter::playBinary() {
+  TICK curTick = getCurrentTick(), tick;
+  BinaryObservationLog::Record rec;
 
-    checkError(curTick<=m_nextObs->first, 
-	       "SimAdapter:synchronize : playable tick ("<<m_nextObs->first<<") is in the past."); 
+  if( !m_reader->peek(tick) ) {
+    Agent::terminate();
+    return;
+  }
+  std::vector<const Observation *> batch;
+  for( ; m_reader->peek(tick) && curTick>=tick; ) {
+    m_reader->next(rec);
+    if( 'O'!=rec.kind )
+      playRequest(rec);
+    else if( m_internals.find(LabelStr(rec.timeline))!=m_internals.end() ) {
+      Observation *obs = m_decoder.asObservation(rec);
 
-    for( ; m_log.end()!=m_nextObs && curTick>=m_nextObs->first; ++m_nextObs ) {
-      Observation *obs = m_nextObs->second;
-      m_nextObs->second = NULL;
-      
       debugMsg("SimAdapter", "["<<getName().toString()<<"]["<<curTick<<"] observation on < "
 	       <<obs->getObjectName().toString()<<" >");
-   
-      m_observer->notify(*obs);
-      delete obs;
+      batch.push_back(obs);
     }
   }
-  else {
+  // Deliver the whole tick at once
+  if( !batch.empty() )
+    m_observer->notifyBatch(batch);
+  for(std::vector<const Observation *>::iterator i=batch.begin(); batch.end()!=i; ++i)
+    delete *i;
+} // SimAdapter::playBinary()
+
+void SimAdapter::playRequest(BinaryObservationLog::Record const &rec) {
+  if( 'G'==rec.kind ) {
+    std::map<double, ServerId>::const_iterator server = m_servers.find(LabelStr(rec.timeline));
+
+    ConfigurationException::configurationCheckError(m_servers.end()!=server, "SimAdapter : no server for <"+rec.timeline+">");
+    TokenId goal = m_decoder.asGoal(rec, m_goalAssembly->getPlanDatabase()->getClient());
+    debugMsg("SimAdapter", "["<<getName().toString()<<"]["<<getCurrentTick()<<"] request "
+	     <<goal->toString()<<" on < "<<rec.timeline<<" >");
+    m_goals[rec.key] = goal;
+    server->second->request(goal);
+  } else if( 'C'==rec.kind ) {
+    std::map<int, TokenId>::iterator i = m_goals.find(rec.key);
+
+    // The goal may have been requested before the trace started
+    if( m_goals.end()==i )
+      return;
+    TokenId goal = i->second;
+    std::map<double, ServerId>::const_iterator server = m_servers.find(Observation::getTimelineName(goal));
+
+    debugMsg("SimAdapter", "["<<getName().toString()<<"]["<<getCurrentTick()<<"] recall "<<goal->toString());
+    m_goals.erase(i);
+    if( m_servers.end()!=server )
+      server->second->recall(goal);
+  }
+} // SimAdapter::playRequest(BinaryObservationLog::Record const &)
+
+void SimAdapter::playXml() {
+  TICK curTick = getCurrentTick(), tick;
+
+  if( !m_xmlReader->peek(tick) ) {
     Agent::terminate();
+    return;
   }
+  checkError(curTick<=tick, 
+	     "SimAdapter:synchronize : playable tick ("<<tick<<") is in the past."); 
+
+  std::vector<TiXmlElement *> elems;
+  for( ; m_xmlReader->peek(tick) && curTick>=tick; )
+    m_xmlReader->next(elems);
+
+  std::vector<const Observation *> batch;
+  for(std::vector<TiXmlElement *>::iterator i=elems.begin(); elems.end()!=i; ++i) {
+    Observation *obs = xmlAsObservation(**i);
+
+    debugMsg("SimAdapter", "["<<getName().toString()<<"]["<<curTick<<"] observation on < "
+	     <<obs->getObjectName().toString()<<" >");
+    batch.push_back(obs);
+    delete *i;
+  }
+  // Deliver the whole tick at once
+  if( !batch.empty() )
+    m_observer->notifyBatch(batch);
+  for(std::vector<const Observation *>::iterator i=batch.begin(); batch.end()!=i; ++i)
+    delete *i;
+} // SimAdapter::playXml()
+
+bool SimAdapter::synchronize() {
+  if( NULL!=m_reader ) 
+    playBinary();
+  else
+    playXml();
 
   return true;
 } // SimAdapter::synchronize()
 
+TICK SimAdapter::nextActiveTick() {
+  TICK tick;
+
+  // At the end of the log, synchronize to terminate the agent
+  if( NULL!=m_reader )
+    return m_reader->peek(tick) ? tick : getCurrentTick();
+  return m_xmlReader->peek(tick) ? tick : getCurrentTick();
+} // SimAdapter::nextActiveTick()
+
 // Observers :
 
 void SimAdapter::queryTimelineModes(std::list<LabelStr> &externals, 
 				    std::list<LabelStr> &internals) {
-  checkError(!m_internals.empty(), 
+  checkError(!m_internals.empty() || !m_externals.empty(), 
 	     "SimAdapter configuration error for " << getName().toString() 
 	     << ". There must be at least one timeline.");
   // Add the standard elements for an adapter
   internals.assign(m_internals.begin(), m_internals.end());
+  externals.assign(m_externals.begin(), m_externals.end());
 } // SimAdapter::queryTimelineModes(std::list<LabelStr> &, std::list<LabelStr> &)
 
 
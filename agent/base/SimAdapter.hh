@@ -44,16 +44,28 @@
 *  POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <map>
 #include <set>
 
 #include "TeleoReactor.hh"
 #include "DataTypes.hh"
+#include "BinaryObservationLog.hh"
+#include "XmlStream.hh"
 
 namespace TREX {
+
+  class Assembly;
   
   /** @brief A log play %TeleoReactor
    *
    * This class is able to play any Timeline declared in a log file produced by ObservationLogger.
+   * XML logs are loaded at once while binary logs are read progressively as the mission is replayed.
+   *
+   * With trace="file" it plays the inputs of one reactor recorded with traceInputs="true" instead of the
+   * agent log. With requests="true" as well, it plays the requests and recalls of the trace rather than its
+   * observations, creating the goals in a database loaded from model="file.nddl". Replaying a reactor
+   * takes an agent with the reactor and two of these adapters, one for each direction as a reactor cannot
+   * both observe and serve another one. Under a SimulationClock the replay runs as fast as possible.
    *
    * @author Frederic Py <fpy@mbari.org>
    */
@@ -84,6 +96,10 @@ namespace TREX {
      */
     bool synchronize();
 
+    /** @brief Next tick with observations to play
+     */
+    TICK nextActiveTick();
+
     void notify(Observation const &observation);
     bool handleRequest(TokenId const &token);
     void handleRecall(TokenId const &token);
@@ -99,27 +115,37 @@ namespace TREX {
   private:
     ObserverId m_observer; //!< Observer connect to the Agent
     std::set<LabelStr> m_internals; /*!< The timelines it will accept goals on and issue observations */
-    std::multimap<TICK, Observation *> m_log; //!< Observations extracted from log file
-    std::multimap<TICK, Observation *>::iterator m_nextObs; //!< next observation to play
+    std::set<LabelStr> m_externals; /*!< The timelines it requests goals on. Only when playing requests */
+    std::map<double, ServerId> m_servers; //!< Servers of the external timelines
+    Assembly *m_goalAssembly; //!< Database of the played goals. NULL unless playing requests
+    std::map<int, TokenId> m_goals; //!< Played goals by recorded key, until recalled
+    BinaryObservationReader *m_reader; //!< Binary log reader. NULL for an XML log
+    XmlObservationReader *m_xmlReader; //!< XML log reader. NULL for a binary log
     int m_lastBacktracked;
     DataTypeId m_floatDT;
     DataTypeId m_intDT;
     DataTypeId m_boolDT;
     DataTypeId m_stringDT;
     DataTypeId m_symbolDT;
+    BinaryObservationDecoder m_decoder; //!< Conversion of the records played from a binary log
 
     bool hasWork() { return false; }
     void resume() {}
     void archive() {}
 
-    /** @brief Observations loading
+    /** @brief Play the observations of current tick from the XML log
      *
-     * @param file A log file content
-     *
-     * This file extract all the Observation of @e file corresponding to the timeline
-     * in m_internals into m_log to prepare the reactor to play them.
+     * The log is read as it is played, one tick at a time.
+     */
+    void playXml();
+
+    /** @brief Play the observations of current tick from the binary log */
+    void playBinary();
+
+    /** @brief Play a request or a recall of an input trace
+     * @param rec The record read from the trace
      */
-    void loadObservations(TiXmlDocument const &file);
+    void playRequest(BinaryObservationLog::Record const &rec);
 
     /** @brief Parsing EnumeratedDomain from XML
      *
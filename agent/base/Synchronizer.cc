@@ -41,12 +41,17 @@
 #include "Timeline.hh"
 #include "Agent.hh"
 #include "Utilities.hh"
+#include "Guardian.hh"
+
+#include <fstream>
 
 
 namespace TREX {
 
   Synchronizer::Synchronizer(const DbCoreId& _core) 
-    : m_core(_core), 
+    : m_unitEpoch(0),
+      m_unitCacheTick(0),
+      m_core(_core), 
       m_db(m_core->m_db),
       m_timelines(m_core->m_timelines),
       m_goals(m_core->m_goals), 
@@ -83,13 +88,65 @@ namespace TREX {
     if(!token->getObject()->lastDomain().isSingleton())
       return false;
 
-    // Compute compatible tokens, using an exact test
-    std::vector<TokenId> compatible_tokens;
-    m_db->getCompatibleTokens(token, compatible_tokens, PLUS_INFINITY, true);
+    // Reuse the prior outcome if nothing changed in the plan structure since it was computed
+    if(m_unitCacheTick != m_core->getCurrentTick()){
+      m_unitCache.clear();
+      m_unitCacheTick = m_core->getCurrentTick();
+    }
+
+    std::map<int, UnitDecision>::const_iterator cached = m_unitCache.find(token->getKey());
+    if(cached != m_unitCache.end() && cached->second.epoch == m_unitEpoch){
+      merge_candidate = cached->second.mergeCandidate;
+      return cached->second.isUnit;
+    }
+
+    // Compute compatible tokens, using an exact test. We only need to know if there are 0, 1 or more choices so
+    // the query stops after 2 tokens. If some of them are in deliberation, the limit may hide other choices, so we redo it
+    // without a limit.
+    std::vector<TokenId>& compatible_tokens = m_compatibleTokens;
+    compatible_tokens.clear();
+    m_db->getCompatibleTokens(token, compatible_tokens, 2, true);
+    unsigned int merge_choice_count = countMergeChoices(compatible_tokens, merge_candidate);
+
+    if(merge_choice_count < 2 && compatible_tokens.size() >= 2){
+      compatible_tokens.clear();
+      m_db->getCompatibleTokens(token, compatible_tokens, PLUS_INFINITY, true);
+      merge_choice_count = countMergeChoices(compatible_tokens, merge_candidate);
+    }
+
+    bool result = false;
+
+    // If we have only one option to merge onto, and we have nowhere to insert the token, then we will have a unit decision
+    if(merge_choice_count == 1 && !m_db->hasOrderingChoice(token)){
+      TREX_INFO("trex:debug:synchronization", "Found unit decision for " << token->toString() <<
+	       " with start = " << token->start()->lastDomain().toString() << ". One spot to merge it.");
+      result = true;
+    }
+    else if(merge_choice_count == 0){
+      merge_candidate = TokenId::noId();
+
+      TREX_INFO("trex:debug:synchronization", "Found unit decision for " << token->toString() <<
+	       " with start = " << token->start()->lastDomain().toString() << ". No ordering choice.");
 
+      result = true;
+    }
+    else {
+      TREX_INFO("trex:debug:synchronization", "Excluding " << token->toString());
+    }
+
+    UnitDecision decision;
+    decision.epoch = m_unitEpoch;
+    decision.isUnit = result;
+    decision.mergeCandidate = merge_candidate;
+    m_unitCache[token->getKey()] = decision;
+
+    return result;
+  }
+
+  unsigned int Synchronizer::countMergeChoices(const std::vector<TokenId>& candidates, TokenId& merge_candidate){
     // Iterate over tokens to find one suitable for merging in synchronization
     unsigned int merge_choice_count(0);
-    for(std::vector<TokenId>::const_iterator it = compatible_tokens.begin(); it != compatible_tokens.end(); ++it){
+    for(std::vector<TokenId>::const_iterator it = candidates.begin(); it != candidates.end(); ++it){
       TokenId candidate = *it;
 
       // If the token in question is in deliberation, continue
@@ -106,24 +163,21 @@ namespace TREX {
 	break;
     }
 
-    // If we have only one option to merge onto, and we have nowhere to insert the token, then we will have a unit decision
-    if(merge_choice_count == 1 && !m_db->hasOrderingChoice(token)){
-      TREX_INFO("trex:debug:synchronization", "Found unit decision for " << token->toString() <<
-	       " with start = " << token->start()->lastDomain().toString() << ". One spot to merge it.");
-      return true;
-    }
-
-    if(merge_choice_count == 0){
-      merge_candidate = TokenId::noId();
+    return merge_choice_count;
+  }
 
-      TREX_INFO("trex:debug:synchronization", "Found unit decision for " << token->toString() <<
-	       " with start = " << token->start()->lastDomain().toString() << ". No ordering choice.");
+  void Synchronizer::invalidateUnitCache(){
+    m_unitEpoch++;
+  }
 
-      return true;
-    }
+  const char* Synchronizer::operationName(Operation operation){
+    static const char* sl_names[OPERATION_COUNT] = {"resolve", "resolveTokens", "mergeToken", "insertToken", "relax"};
+    return sl_names[operation];
+  }
 
-    TREX_INFO("trex:debug:synchronization", "Excluding " << token->toString());
-    return false;
+  void Synchronizer::resetLatencies(){
+    for(unsigned int i = 0; i < OPERATION_COUNT; i++)
+      m_latency[i].reset();
   }
 
   ConstrainedVariableId Synchronizer::getActiveGuard(const ConstrainedVariableId& var){
@@ -147,6 +201,11 @@ namespace TREX {
    * @brief Resolve unit flaws at the execution frontier
    */
   bool Synchronizer::resolve(){
+    LatencyTimer timer(m_latency[RESOLVE]);
+
+    // Only the failure of this call matters to a repair
+    m_failureScope.clear();
+
     // Use a counter to aid with settng debug breakpoints
     static unsigned int sl_counter(0);
     sl_counter++;
@@ -164,6 +223,9 @@ namespace TREX {
 
     checkError(m_core->isValidDb(), "Invalid database before synchronization.");
 
+    // Domains may have changed since the last call, with new observations for instance
+    invalidateUnitCache();
+
     m_stepCount = 0; // Reset step counter for stats
     if(resolveTokens(m_stepCount) &&
        completeInternalTimelines(m_stepCount) &&
@@ -181,8 +243,13 @@ namespace TREX {
    * the model, and current observations..
    */
   bool Synchronizer::relax(bool discardCurrentValues) {
+    LatencyTimer timer(m_latency[RELAX]);
+
     TREXLog() << m_core->nameString() << "Beginning database relax." << std::endl;
 
+    m_relaxScope.clear();
+    m_copiedValues.clear();
+
     TREX_INFO("trex:debug:synchronization:relax", m_core->nameString() << "START");
 
     // Reset observations to base values. It is important that we do this before processing
@@ -218,6 +285,89 @@ namespace TREX {
     return false;
   }
 
+  /**
+   * The neighbourhood is relaxed with the same steps as the whole database, skipping tokens on other timelines. Only the values
+   * copied in the neighbourhood are inserted again, since the other committed values were left in the plan.
+   */
+  bool Synchronizer::relaxNeighbourhood() {
+    if(m_failureScope.empty())
+      return false;
+
+    LatencyTimer timer(m_latency[RELAX]);
+
+    TREXLog() << m_core->nameString() << "Beginning relax of " << m_failureScope.size() << " timelines." << std::endl;
+
+    TREX_INFO("trex:debug:synchronization:relax", m_core->nameString() << "START on " << m_failureScope.size() << " timelines");
+
+    m_relaxScope.swap(m_failureScope);
+    m_failureScope.clear();
+    m_copiedValues.clear();
+
+    resetObservations();
+    resetGoals(false);
+    resetRemainingTokens(false);
+    m_core->purgeOrphanedKeys();
+
+    checkError(m_core->verifyEntities(), "Bug somewhere.");
+
+    bool result = true;
+    for(std::vector<TokenId>::const_iterator it = m_copiedValues.begin(); it != m_copiedValues.end() && result; ++it){
+      unsigned int stepCount = 0;
+      result = insertToken(*it, stepCount);
+    }
+
+    m_relaxScope.clear();
+    m_copiedValues.clear();
+
+    TREX_INFO("trex:debug:synchronization:relax", m_core->nameString() << "END " << (result ? "relaxed" : "failed"));
+
+    return result;
+  }
+
+  void Synchronizer::recordFailure(const TokenId& token){
+    m_failureScope.clear();
+
+    TokenSet connected;
+    computeConnectedTokens(token, connected);
+    for(TokenSet::const_iterator it = connected.begin(); it != connected.end(); ++it)
+      addToFailureScope(*it);
+
+    // Follow one more level through the tokens of these timelines
+    std::set<int> timelines = m_failureScope;
+    for(std::vector<TimelineId>::const_iterator it = m_timelines.begin(); it != m_timelines.end(); ++it){
+      const TimelineId& timeline = *it;
+      if(timelines.find(timeline->getKey()) == timelines.end())
+	continue;
+
+      const std::list<TokenId>& tokens = timeline->getTokenSequence();
+      for(std::list<TokenId>::const_iterator t_it = tokens.begin(); t_it != tokens.end(); ++t_it){
+	TokenSet neighbours;
+	computeConnectedTokens(*t_it, neighbours);
+	for(TokenSet::const_iterator n_it = neighbours.begin(); n_it != neighbours.end(); ++n_it)
+	  addToFailureScope(*n_it);
+      }
+    }
+  }
+
+  void Synchronizer::addToFailureScope(const TokenId& token){
+    std::list<ObjectId> objects = static_cast<const ObjectDomain&>(token->getObject()->lastDomain()).makeObjectList();
+    for(std::list<ObjectId>::const_iterator it = objects.begin(); it != objects.end(); ++it)
+      m_failureScope.insert((*it)->getKey());
+  }
+
+  bool Synchronizer::inRelaxScope(const TokenId& token) const {
+    if(m_relaxScope.empty())
+      return true;
+
+    // A token which could be on several timelines is relaxed if any of them is
+    std::list<ObjectId> objects = static_cast<const ObjectDomain&>(token->getObject()->lastDomain()).makeObjectList();
+    for(std::list<ObjectId>::const_iterator it = objects.begin(); it != objects.end(); ++it)
+      if(m_relaxScope.find((*it)->getKey()) != m_relaxScope.end())
+	return true;
+
+    return false;
+  }
+
   /**
    * @brief Relaxes goal commitments and removes those goals that are no longer achievable
    * @see relax
@@ -236,6 +386,9 @@ namespace TREX {
     for(TokenSet::const_iterator it = goals.begin(); it != goals.end(); ++it){
       TokenId goal = *it;
       checkError(goal.isValid(), "Invalid goal:" << goal);
+      if(!inRelaxScope(goal))
+	continue;
+
       checkError(goal->master().isNoId(), 
 		 "Should only have orphans in the goal buffer. " << 
 		 goal->toString() << " has master " << goal->getMaster()->toString());
@@ -331,6 +484,8 @@ namespace TREX {
     for(TokenSet::iterator it = observations.begin(); it != observations.end(); ++it){
       TokenId observation = *it;
       checkError(observation.isValid(), observation);
+      if(!inRelaxScope(observation))
+	continue;
 
       TREX_INFO("trex:debug:synchronization:resetObservations", m_core->nameString() << "Evaluating " << observation->toString());
 
@@ -383,6 +538,8 @@ namespace TREX {
     for(TokenSet::const_iterator it = allTokens.begin(); it!= allTokens.end(); ++it){
       TokenId token = *it;
       checkError(token.isValid(), token);
+      if(!inRelaxScope(token))
+	continue;
 
       const IntervalIntDomain& endTime = token->end()->baseDomain();
 
@@ -470,6 +627,7 @@ namespace TREX {
     // remain bound to prior valaues since the past is monotonic. Since we have already done the base domain restriction
     // and we want to prevent propagation while we are relaxing, we just commit directly
     token->commit();
+    m_copiedValues.push_back(token);
 
     TREX_INFO("trex:debug:synchronization:copyValue",m_core->nameString() << "Replaced " << source->toString() << " with " << token->toString());
   }
@@ -478,6 +636,7 @@ namespace TREX {
    * Processes the token agenda and makes insertion or merge choices
    */
   bool Synchronizer::resolveTokens(unsigned int& stepCount){
+    LatencyTimer timer(m_latency[RESOLVE_TOKENS]);
     static unsigned int sl_counter;
 
     unsigned int lastCount = PLUS_INFINITY;
@@ -532,12 +691,14 @@ namespace TREX {
     if(mergeToken(token, merge_candidate) || insertToken(token, stepCount))
       return true;
 
-    std::string explanation_str;
-    TREX_INFO("trex:monitor:conflicts", m_core->nameString() << (explanation_str = tokenResolutionFailure(token, merge_candidate)));
+    recordFailure(token);
 
-    m_core->markInvalid(std::string("Could not insert ") + token->toString() + 
-			" into the plan. The plan is not compatible with observations and must be relaxed. Enable all DbCore messages and also enable Synchronizer messages in the Debug.cfg file.", 
-			true, explanation_str);
+    // The analysis of the captured plan and the conflict file are left to the analyst thread. See DbCore::addFailure
+    FailureRecord failure = captureFailure(token, merge_candidate);
+    failure.comment = std::string("Could not insert ") + token->toString() + 
+      " into the plan. The plan is not compatible with observations and must be relaxed. Enable all DbCore messages and also enable Synchronizer messages in the Debug.cfg file.";
+    m_core->addFailure(failure);
+    m_core->markInvalid(failure.comment);
     return false;
   }
 
@@ -557,12 +718,12 @@ namespace TREX {
       unsigned int stepCount = 0;
       if(!insertToken(token, stepCount)){
 	TREX_INFO("trex:debug:synchronization:insertCopiedValues", m_core->nameString() << "Failed to insert " << token->toString());
-	std::string explanation_str;
-	TREX_INFO("trex:debug:synchronization:insertCopiedValues", m_core->nameString() << (explanation_str = tokenResolutionFailure(token, TokenId::noId())));
-	m_core->markInvalid(std::string("Failed to insert ") + token->toString() + 
-			    "This is bad. After relaxing the plan and restoring necessary state, we still can't synchronize. " + 
-			    "There is probably a bug in the model. Enable PlanDatabase and DbCore messages in Debug.log",
-			    true, explanation_str);
+	FailureRecord failure = captureFailure(token, TokenId::noId());
+	failure.comment = std::string("Failed to insert ") + token->toString() + 
+	  "This is bad. After relaxing the plan and restoring necessary state, we still can't synchronize. " + 
+	  "There is probably a bug in the model. Enable PlanDatabase and DbCore messages in Debug.log";
+	m_core->addFailure(failure);
+	m_core->markInvalid(failure.comment);
 	return false;
       }
     }
@@ -577,6 +738,8 @@ namespace TREX {
     if(m_core->isInvalid() || merge_candidate.isNoId())
       return false;
 
+    LatencyTimer timer(m_latency[MERGE]);
+
     // No need to try if already active, or if cannot be merged
     if(!token->isInactive() || !token->getState()->lastDomain().isMember(Token::MERGED))
       return false;
@@ -599,6 +762,8 @@ namespace TREX {
     if(m_core->isInvalid() || m_core->inDeliberation(token))
       return false;
 
+    LatencyTimer timer(m_latency[INSERT]);
+
     // If the token is in the past, we will not insert it. Just remove it from the agenda and return OK
     if(token->end()->lastDomain().getUpperBound() == Agent::instance()->getCurrentTick()){
       m_core->m_tokenAgenda.erase(token);
@@ -827,6 +992,153 @@ namespace TREX {
     return ss.str();
   }
 
+  FailureRecord::FailureRecord()
+    : tick(0), tokenKey(0), observation(false), masterKey(0), mergeCandidateKey(0), inconsistent(false) {
+    start[0] = start[1] = end[0] = end[1] = 0;
+  }
+
+  std::string FailureRecord::summary() const {
+    std::stringstream ss;
+    ss << "Failed to resolve " << token << " at tick " << tick << std::endl
+       << "start == [" << start[0] << ", " << start[1] << "] && end == [" << end[0] << ", " << end[1] << "]" << std::endl;
+    if(observation)
+      ss << "It is an observation." << std::endl;
+    if(masterKey != 0)
+      ss << "It is a slave of token " << masterKey << std::endl;
+    if(inconsistent)
+      ss << "The constraint network was inconsistent." << std::endl;
+    else if(mergeCandidateKey != 0)
+      ss << "Token " << mergeCandidateKey << " was the only merge candidate." << std::endl;
+    else
+      ss << "No compatible tokens and no locations for insertion." << std::endl;
+    return ss.str();
+  }
+
+  /**
+   * @brief Write a captured token as a row of the plan
+   */
+  static std::ostream& operator<<(std::ostream& out, const FailureRecord::PlanToken& token){
+    return out << token.timeline << "\t" << token.key << "\t" << token.predicate
+	       << "\t[" << token.start[0] << ", " << token.start[1] << "]\t[" << token.end[0] << ", " << token.end[1] << "]";
+  }
+
+  void FailureRecord::analyse(){
+    std::stringstream ss;
+    ss << std::endl << "Analysis results below" << std::endl << std::endl;
+
+    if(inconsistent)
+      ss << "The bounds below are those of the inconsistent network." << std::endl;
+
+    for(std::vector<PlanToken>::const_iterator it = plan.begin(); it != plan.end(); ++it){
+      if(it->key == mergeCandidateKey)
+	ss << "The merge candidate is not compatible: " << *it << std::endl;
+      // As analysisOfBlockingToken, report the tokens of the same predicate which overlap in time
+      else if(mergeCandidateKey == 0 && it->key != tokenKey && it->predicate == predicate &&
+	      it->start[0] <= start[1] && start[0] <= it->start[1] && it->end[0] <= end[1] && end[0] <= it->end[1])
+	ss << "Found a conflict with " << *it << std::endl;
+    }
+
+    ss << std::endl << "Plan at the failure:" << std::endl;
+    for(std::vector<PlanToken>::const_iterator it = plan.begin(); it != plan.end(); ++it)
+      ss << *it << std::endl;
+
+    analysis = ss.str();
+  }
+
+  std::string FailureRecord::render() const {
+    return comment + "\n" + summary() + analysis;
+  }
+
+  FailureAnalyst::FailureAnalyst()
+    : m_stop(false) {}
+
+  FailureAnalyst::~FailureAnalyst(){
+    {
+      Guardian<Mutex> guard(m_lock);
+      m_stop = true;
+      m_pendingCond.broadcast();
+    }
+    join();
+  }
+
+  void FailureAnalyst::push(const FailureRecord& record){
+    Guardian<Mutex> guard(m_lock);
+    m_pending.push_back(record);
+    if(m_pending.size() > MAX_PENDING)
+      m_pending.pop_front();
+    m_pendingCond.signal();
+  }
+
+  void FailureAnalyst::collect(std::vector<FailureRecord>& analysed){
+    Guardian<Mutex> guard(m_lock);
+    analysed.insert(analysed.end(), m_analysed.begin(), m_analysed.end());
+    m_analysed.clear();
+  }
+
+  void *FailureAnalyst::run(){
+    Guardian<Mutex> guard(m_lock);
+
+    while(true){
+      if(m_pending.empty()){
+	if(m_stop)
+	  return NULL;
+	m_pendingCond.wait(m_lock);
+	continue;
+      }
+      FailureRecord record = m_pending.front();
+      m_pending.pop_front();
+      m_lock.unlock();
+
+      record.analyse();
+      if(!record.conflictFile.empty()){
+	std::ofstream out(record.conflictFile.c_str());
+	out << record.render();
+      }
+
+      m_lock.lock();
+      m_analysed.push_back(record);
+      if(m_analysed.size() > MAX_PENDING)
+	m_analysed.erase(m_analysed.begin());
+    }
+  }
+
+  FailureRecord Synchronizer::captureFailure(const TokenId& tokenToResolve, const TokenId& merge_candidate) const {
+    FailureRecord record;
+    record.tick = m_core->getCurrentTick();
+    record.tokenKey = tokenToResolve->getKey();
+    record.token = tokenToResolve->toString();
+    record.predicate = tokenToResolve->getPredicateName().toString();
+    record.start[0] = tokenToResolve->start()->lastDomain().getLowerBound();
+    record.start[1] = tokenToResolve->start()->lastDomain().getUpperBound();
+    record.end[0] = tokenToResolve->end()->lastDomain().getLowerBound();
+    record.end[1] = tokenToResolve->end()->lastDomain().getUpperBound();
+    record.observation = m_core->isObservation(tokenToResolve);
+    record.masterKey = (tokenToResolve->master().isId() ? tokenToResolve->master()->getKey() : 0);
+    record.mergeCandidateKey = (merge_candidate.isId() ? merge_candidate->getKey() : 0);
+    record.inconsistent = !m_db->getConstraintEngine()->constraintConsistent();
+
+    // Only the bounds are copied. The analysis works from them later
+    DbCore::PlanDescription desc;
+    m_core->getPlanDescription(desc);
+    const std::vector<DbCore::PlanDescription::TimelineDescription>* timelines[] = {&desc.m_internalTimelines, &desc.m_externalTimelines};
+    for(unsigned int i = 0; i < 2; i++){
+      for(std::vector<DbCore::PlanDescription::TimelineDescription>::const_iterator tl = timelines[i]->begin(); tl != timelines[i]->end(); ++tl){
+	for(std::vector<DbCore::PlanDescription::TokenDescription>::const_iterator it = tl->tokens.begin(); it != tl->tokens.end(); ++it){
+	  FailureRecord::PlanToken token;
+	  token.timeline = tl->name.toString();
+	  token.predicate = it->name.toString();
+	  token.key = it->key;
+	  token.start[0] = it->start[0];
+	  token.start[1] = it->start[1];
+	  token.end[0] = it->end[0];
+	  token.end[1] = it->end[1];
+	  record.plan.push_back(token);
+	}
+      }
+    }
+    return record;
+  }
+
   std::string Synchronizer::localContextForConstrainedVariable(const ConstrainedVariableId& var) const {
     std::stringstream ss;
 
@@ -38,9 +38,101 @@
 #include "TREXDefs.hh"
 #include "PlanDatabaseDefs.hh"
 #include "RuleInstance.hh"
+#include "PerformanceMonitor.hh"
+#include "Thread.hh"
+#include "MutexWrapper.hh"
+#include "Condition.hh"
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace TREX {
 
+  /**
+   * @brief What is known about a synchronization failure when it happens. It is cheap to capture so that the repair
+   * goes on right away. It holds no EUROPA entity, so that it can be analysed by a FailureAnalyst on its own thread.
+   */
+  struct FailureRecord {
+    FailureRecord();
+
+    /**
+     * @brief A token of the plan at the failure
+     */
+    struct PlanToken {
+      std::string timeline;
+      std::string predicate;
+      int key;
+      double start[2], end[2];
+    };
+
+    /**
+     * @brief The captured facts, one per line. It does not read the plan database.
+     */
+    std::string summary() const;
+
+    /**
+     * @brief Fill analysis from the captured plan: the merge candidate, the tokens blocking the failed one and the
+     * plan itself. It does not read the plan database.
+     */
+    void analyse();
+
+    /**
+     * @brief The comment, the summary and the analysis, as written to the conflict file
+     */
+    std::string render() const;
+
+    TICK tick;
+    std::string comment; /*!< The hint given when the reactor was marked invalid */
+    int tokenKey; /*!< The token which could not be resolved */
+    std::string token; /*!< Its description, which remains after the token is discarded */
+    std::string predicate; /*!< Its predicate name */
+    double start[2], end[2]; /*!< Its temporal bounds */
+    bool observation;
+    int masterKey; /*!< Its master, 0 if none */
+    int mergeCandidateKey; /*!< The only token it could merge onto, 0 if none */
+    bool inconsistent; /*!< True if the constraint network was inconsistent */
+    std::vector<PlanToken> plan; /*!< The tokens of the timelines of the reactor at the failure */
+    std::string conflictFile; /*!< Where the analysis is written */
+    std::string analysis; /*!< Set by analyse() */
+  };
+
+  /**
+   * @brief Analyses failure records on its own thread and writes them to their conflict files. The analysed records
+   * are kept until collected, so that the agent thread can log them.
+   */
+  class FailureAnalyst: public Thread {
+  public:
+    FailureAnalyst();
+
+    /**
+     * @brief Analyse the queued records, then stop the thread
+     */
+    ~FailureAnalyst();
+
+    /**
+     * @brief Queue a copy of a record. Only the latest MAX_PENDING records are kept, so the caller never waits.
+     */
+    void push(const FailureRecord& record);
+
+    /**
+     * @brief Move the records analysed since the last call to @e analysed
+     */
+    void collect(std::vector<FailureRecord>& analysed);
+
+    static const unsigned int MAX_PENDING = 16;
+
+  private:
+    void *run();
+
+    Mutex m_lock; /*!< Protects the fields below */
+    Condition m_pendingCond; /*!< Signaled when a record is queued or on stop */
+    std::deque<FailureRecord> m_pending;
+    std::vector<FailureRecord> m_analysed;
+    bool m_stop;
+  };
+
   /**
    * @brief Implements the synhronization algorithm and gathers all the components required for it
    */
@@ -62,6 +154,43 @@ namespace TREX {
      */
     bool relax(bool discardCurrentValues);
 
+    /**
+     * @brief Relax only the neighbourhood of the token which could not be resolved by the last call to resolve: the timelines
+     * of the tokens connected to it, and of the tokens connected to the tokens of these timelines. Values outside of it are kept
+     * as they are.
+     * @return false if the last failure was not on a token, or if the neighbourhood could not be relaxed. The database should
+     * then be relaxed globally.
+     * @see computeConnectedTokens
+     */
+    bool relaxNeighbourhood();
+
+
+    /**
+     * @brief Discard the cached unit decisions. Called by the core whenever the structure of the plan changes, i.e. on
+     * addition, activation, merge, split, deactivation or removal of a token, and when a timeline ordering is added or freed.
+     */
+    void invalidateUnitCache();
+
+    /**
+     * @brief The operations of synchronization for which latencies are recorded
+     */
+    enum Operation {
+      RESOLVE = 0, /*!< resolve */
+      RESOLVE_TOKENS, /*!< resolveTokens, a pass over the token agenda */
+      MERGE, /*!< mergeToken */
+      INSERT, /*!< insertToken, including its slaves */
+      RELAX, /*!< relax */
+      OPERATION_COUNT
+    };
+
+    static const char* operationName(Operation operation);
+
+    /**
+     * @brief Latencies of an operation since construction or the last call to resetLatencies.
+     */
+    const LatencyHistogram& getLatency(Operation operation) const {return m_latency[operation];}
+
+    void resetLatencies();
 
     /** UTILITIES FOR ANALYSIS OF FAILURES **/
     std::string tokenResolutionFailure(const TokenId& tokenToResolve, const TokenId& merge_candidate) const;
@@ -69,6 +198,12 @@ namespace TREX {
     std::string localContextForConstrainedVariable(const ConstrainedVariableId& var) const;
     std::string tokenExtensionFailure(const TokenId& expectedToken) const;
     std::string analysisOfBlockingToken(const TokenId& tokenToResolve) const;
+
+    /**
+     * @brief Collect the facts of a failure to resolve a token and a copy of the plan bounds, without analysis
+     */
+    FailureRecord captureFailure(const TokenId& tokenToResolve, const TokenId& merge_candidate) const;
+
   private:
 
     /**
@@ -117,11 +252,34 @@ namespace TREX {
      */
     bool isUnit(const TokenId& token, TokenId& mergeCandidate);
 
+    /**
+     * @brief Count candidates for merging which are not in deliberation. Stops as soon as more than one is found.
+     * @param candidates Compatible tokens
+     * @param mergeCandidate The last candidate counted
+     */
+    unsigned int countMergeChoices(const std::vector<TokenId>& candidates, TokenId& mergeCandidate);
+
     /**
      * @brief Test for synchronization scope
      */
     bool inSynchScope(const TokenId& token, TokenId& mergeCandidate);
 
+    /**
+     * @brief Record the neighbourhood of a token which could not be resolved.
+     * @see relaxNeighbourhood
+     */
+    void recordFailure(const TokenId& token);
+
+    /**
+     * @brief Add the timelines the token could be on to the failure neighbourhood
+     */
+    void addToFailureScope(const TokenId& token);
+
+    /**
+     * @brief True if the token is affected by the relaxation in progress. Always true for a global relaxation.
+     */
+    bool inRelaxScope(const TokenId& token) const;
+
     /**
      * @brief Reset goals as part of repair
      */
@@ -163,8 +321,28 @@ namespace TREX {
      */
     static ConstrainedVariableId getActiveGuard(const ConstrainedVariableId& var);
 
+    /**
+     * @brief Cached outcome of isUnit for a token
+     */
+    struct UnitDecision {
+      bool isUnit;
+      TokenId mergeCandidate;
+      unsigned int epoch; /*!< Value of m_unitEpoch when computed */
+    };
+
+    unsigned int m_unitEpoch; /*!< Incremented whenever the plan structure changes */
+    TICK m_unitCacheTick; /*!< The tick of the cached decisions */
+    std::map<int, UnitDecision> m_unitCache; /*!< Unit decisions by token key */
+    std::vector<TokenId> m_compatibleTokens; /*!< Scratch buffer of isUnit, kept to reuse its capacity */
+
     unsigned int m_stepCount;
 
+    std::set<int> m_failureScope; /*!< Keys of the timelines around the last token which could not be resolved */
+    std::set<int> m_relaxScope; /*!< Keys of the timelines relaxed by relaxNeighbourhood. Empty for a global relaxation */
+    std::vector<TokenId> m_copiedValues; /*!< Values copied by a relaxation, to be inserted again */
+
+    LatencyHistogram m_latency[OPERATION_COUNT]; /*!< Wall clock latencies by operation */
+
     DbCoreId m_core;
     PlanDatabaseId m_db;
     const std::vector<TimelineId>& m_timelines;
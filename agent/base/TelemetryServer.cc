@@ -0,0 +1,219 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TelemetryServer.cc"
+ */
+#include <cstring>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "TelemetryServer.hh"
+#include "ErrnoExcept.hh"
+#include "Guardian.hh"
+#include "Utilities.hh"
+
+namespace TREX {
+
+  /*
+   * class TelemetrySample
+   */
+
+  void TelemetrySample::add(char const *field, double value) {
+    if( m_next==m_names.size() )
+      m_names.push_back(field);
+    set(value);
+  }
+
+  void TelemetrySample::add(LabelStr const &reactor, char const *field, double value) {
+    if( m_next==m_names.size() )
+      m_names.push_back(reactor.toString()+"."+field);
+    set(value);
+  }
+
+  void TelemetrySample::set(double value) {
+    if( m_next==m_values.size() )
+      m_values.push_back(value);
+    else
+      m_values[m_next] = value;
+    ++m_next;
+  }
+
+  void TelemetrySample::write(std::ostream &out) const {
+    for(size_t i=0; i<m_next; ++i)
+      out<<m_names[i]<<' '<<m_values[i]<<'\n';
+  }
+
+  /*
+   * class TelemetryServer
+   */
+
+  TelemetryServer::TelemetryServer(std::string const &address, unsigned short port)
+    :m_socket(-1), m_port(port), m_stop(false), m_sequence(0) {
+    m_counts[0] = m_counts[1] = 0;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ConfigurationException::configurationCheckError(inet_pton(AF_INET, address.c_str(), &addr.sin_addr)==1,
+						    "TelemetryServer: invalid address "+address);
+
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if( m_socket<0 )
+      throw ErrnoExcept("TelemetryServer: socket");
+
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    socklen_t len = sizeof(addr);
+    if( bind(m_socket, (sockaddr *)&addr, sizeof(addr))<0 || listen(m_socket, 4)<0 ||
+	getsockname(m_socket, (sockaddr *)&addr, &len)<0 ) {
+      ErrnoExcept error("TelemetryServer: bind");
+      close(m_socket);
+      throw error;
+    }
+    m_port = ntohs(addr.sin_port);
+    start();
+  }
+
+  TelemetryServer::~TelemetryServer() {
+    m_stop = true;
+    join();
+    close(m_socket);
+  }
+
+  void TelemetryServer::publish(TelemetrySample const &sample) {
+    size_t count = sample.size()<MAX_FIELDS ? sample.size() : MAX_FIELDS;
+
+    // The fields are usually all named after the first tick
+    if( count>m_names.size() ) {
+      Guardian<Mutex> guard(m_namesLock);
+      for(size_t i=m_names.size(); i<count; ++i)
+	m_names.push_back(sample.name(i));
+    }
+
+    unsigned long next = m_sequence+1;
+    unsigned int slot = next&1;
+    for(size_t i=0; i<count; ++i)
+      m_slots[slot][i] = sample.value(i);
+    m_counts[slot] = count;
+    // The sample must be complete before readers can see it
+    __sync_synchronize();
+    m_sequence = next;
+  }
+
+  std::string TelemetryServer::snapshot() const {
+    double values[MAX_FIELDS];
+    size_t count;
+    while( true ) {
+      unsigned long seq = m_sequence;
+      __sync_synchronize();
+      unsigned int slot = seq&1;
+      count = m_counts[slot];
+      memcpy(values, m_slots[slot], count*sizeof(double));
+      __sync_synchronize();
+      // The next publication writes the other slot, the one after rewrites this one
+      if( seq==m_sequence )
+	break;
+    }
+
+    // The names of the published fields are never changed
+    std::ostringstream text;
+    Guardian<Mutex> guard(m_namesLock);
+    for(size_t i=0; i<count; ++i)
+      text<<m_names[i]<<' '<<values[i]<<'\n';
+    return text.str();
+  }
+
+  void *TelemetryServer::run() {
+    while( !m_stop ) {
+      // Wake up periodically to check for termination
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(m_socket, &fds);
+      timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 200000;
+      if( select(m_socket+1, &fds, NULL, NULL, &timeout)<=0 )
+	continue;
+
+      int client = accept(m_socket, NULL, NULL);
+      if( client<0 )
+	continue;
+      serve(client);
+      close(client);
+    }
+    return NULL;
+  }
+
+  void TelemetryServer::serve(int client) const {
+    // Do not let a client hold the server
+    timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // The request itself is ignored : every path serves the snapshot
+    char request[1024];
+    if( recv(client, request, sizeof(request), 0)<=0 )
+      return;
+
+    std::string body = snapshot();
+    std::ostringstream response;
+    response<<"HTTP/1.0 200 OK\r\n"
+	    <<"Content-Type: text/plain\r\n"
+	    <<"Content-Length: "<<body.size()<<"\r\n"
+	    <<"\r\n"<<body;
+    std::string const &text = response.str();
+    size_t sent = 0;
+    while( sent<text.size() ) {
+      ssize_t n = send(client, text.data()+sent, text.size()-sent, MSG_NOSIGNAL);
+      if( n<=0 )
+	return;
+      sent += n;
+    }
+  }
+
+}
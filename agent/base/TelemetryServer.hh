@@ -0,0 +1,163 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TelemetryServer.hh"
+ * @brief Definition of the TelemetryServer class
+ */
+#ifndef _TELEMETRYSERVER_HH
+#define _TELEMETRYSERVER_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "TREXDefs.hh"
+#include "LabelStr.hh"
+#include "Thread.hh"
+#include "MutexWrapper.hh"
+
+namespace TREX {
+
+  /** @brief The statistics of one tick, kept as numbers.
+   *
+   * The fields are named the first time they are added. Later samples
+   * only overwrite the values, so taking a sample does not allocate
+   * once the first one is done. The fields must therefore be added in
+   * the same order on every tick.
+   */
+  class TelemetrySample {
+  public:
+    TelemetrySample()
+      :m_next(0) {}
+
+    /** @brief Start a new sample, keeping the field names */
+    void clear() {
+      m_next = 0;
+    }
+    /** @brief Add the field @p field of the agent */
+    void add(char const *field, double value);
+    /** @brief Add the field "<reactor>.<field>" */
+    void add(LabelStr const &reactor, char const *field, double value);
+
+    /** @brief Number of fields of the current sample */
+    size_t size() const {
+      return m_next;
+    }
+    std::string const &name(size_t i) const {
+      return m_names[i];
+    }
+    double value(size_t i) const {
+      return m_values[i];
+    }
+
+    /** @brief Write the sample as "<name> <value>" lines */
+    void write(std::ostream &out) const;
+
+  private:
+    void set(double value);
+
+    std::vector<std::string> m_names;
+    std::vector<double> m_values;
+    size_t m_next; /*!< Index of the next field added */
+  };
+
+  /** @brief Minimal HTTP endpoint for runtime telemetry.
+   *
+   * This thread answers any HTTP request on its port with the last
+   * sample published by the agent, as plain text lines of the form
+   * "<name> <value>". The text is formatted by the server thread.
+   *
+   * The values are double buffered behind a sequence counter : the
+   * agent writes the next buffer and then bumps the counter, while the
+   * server copies the current buffer and retries if the counter moved
+   * meanwhile. The names are only locked when a sample has new fields,
+   * so a slow or stuck client can not delay the control loop.
+   */
+  class TelemetryServer :public Thread {
+  public:
+    /** @brief Largest number of fields served. Others are dropped */
+    static const size_t MAX_FIELDS = 4096;
+
+    /** @brief Constructor
+     *
+     * @param address IPv4 address to bind, such as "127.0.0.1" or "0.0.0.0"
+     * @param port TCP port to listen to. 0 for a port chosen by the system
+     *
+     * Binds the socket and starts serving.
+     *
+     * @throw ConfigurationException @p address is not an IPv4 address
+     * @throw ErrnoExcept the socket cannot be opened or bound
+     */
+    TelemetryServer(std::string const &address, unsigned short port);
+    /** @brief Destructor
+     *
+     * Stops and joins the thread, then closes the socket.
+     */
+    ~TelemetryServer();
+
+    /** @brief Publish a new sample
+     *
+     * Called by a single writer, the agent. It only copies the values,
+     * and the names of the fields not published before.
+     */
+    void publish(TelemetrySample const &sample);
+
+    /** @brief Text of the last published sample */
+    std::string snapshot() const;
+
+    /** @brief The port the server listens to */
+    unsigned short port() const {
+      return m_port;
+    }
+
+  private:
+    void *run();
+    void serve(int client) const;
+
+    int m_socket;
+    unsigned short m_port;
+    volatile bool m_stop;
+    mutable Mutex m_namesLock; /*!< Protects m_names */
+    std::vector<std::string> m_names; /*!< Names of the fields published so far */
+    volatile unsigned long m_sequence; /*!< Number of samples published. The last one is in m_slots[m_sequence&1] */
+    size_t m_counts[2];
+    double m_slots[2][MAX_FIELDS];
+  };
+
+}
+
+#endif // _TELEMETRYSERVER_HH
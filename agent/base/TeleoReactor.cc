@@ -48,8 +48,13 @@
 #include "Token.hh"
 #include "Utils.hh"
 #include "Utilities.hh"
+#include "BinaryObservationLog.hh"
+#include "TickTrace.hh"
 
 #include <time.h>
+#include <algorithm>
+#include <cstring>
+#include <set>
 
 
 namespace TREX {
@@ -62,7 +67,11 @@ namespace TREX {
     TeleoObserver(TeleoReactorId reactor): Observer(), m_reactor(reactor){}
 
     virtual void notify(const Observation& observation) {
-      m_reactor->notify(observation);
+      m_reactor->doNotify(observation);
+    }
+
+    virtual void notifyBatch(const std::vector<const Observation*>& observations) {
+      m_reactor->doNotify(observations);
     }
 
   private:
@@ -84,6 +93,13 @@ namespace TREX {
       return m_reactor->request(goal);
     }
 
+    /**
+     * @brief Commands the server to handle a batch of requests
+     */
+    void request(const std::vector<TokenId>& goals, std::vector<bool>& accepted) {
+      m_reactor->request(goals, accepted);
+    }
+
     /**
      * @brief Commands the server to discard a goal previously requested
      * @param goal The goal token to recalls
@@ -92,6 +108,13 @@ namespace TREX {
       m_reactor->recall(goal);
     }
 
+    /**
+     * @brief Commands the server to discard a batch of goals previously requested
+     */
+    void recall(const std::vector<TokenId>& goals) {
+      m_reactor->recall(goals);
+    }
+
     /**
      * @brief Retrieve the latency it takes to respond. This is used in planning when to dispatch goals. It is a lower bound on dispatch window.
      */
@@ -128,9 +151,11 @@ namespace TREX {
       m_latency(atoi(extractData(configData, "latency").c_str())),
       m_thisObserver(new TeleoObserver(m_id)),
       m_thisServer(new TeleoServer(m_id)),
-      m_syncUsage(RStat::zeroed), m_searchUsage(RStat::zeroed),
+      m_syncUsage(RStat::zeroed), m_searchUsage(ClockStat::thread),
       m_shouldLog(string_cast<bool>(logDefault, checked_string(configData.Attribute("log")))),
-      m_debugStream(debugFileName(m_agentName, m_name).c_str()) {
+      m_debugStream(debugFileName(m_agentName, m_name).c_str()),
+      m_disturbed(true), m_tickStartPending(false),
+      m_inputTrace(openInputTrace(agentName, configData)), m_tracedTick(-1) {
     TREX_INFO("TeleoReactor:TeleoReactor", "Allocating '" << agentName.toString() << "." << m_name.toString());
   }
 
@@ -142,9 +167,11 @@ namespace TREX {
       m_latency(latency),
       m_thisObserver(new TeleoObserver(m_id)),
       m_thisServer(new TeleoServer(m_id)),
-      m_syncUsage(RStat::zeroed), m_searchUsage(RStat::zeroed),
+      m_syncUsage(RStat::zeroed), m_searchUsage(ClockStat::thread),
       m_shouldLog(log),
-      m_debugStream(debugFileName(m_agentName, m_name).c_str())
+      m_debugStream(debugFileName(m_agentName, m_name).c_str()),
+      m_disturbed(true), m_tickStartPending(false),
+      m_inputTrace(NULL), m_tracedTick(-1)
  {
     DebugMessage::setStream(getStream());
     TREX_INFO("TeleoReactor:TeleoReactor", "Allocating '" << agentName.toString() << "." << m_name.toString());
@@ -159,20 +186,45 @@ namespace TREX {
       m_latency(latency),
       m_thisObserver(new TeleoObserver(m_id)),
       m_thisServer(new TeleoServer(m_id)),
-      m_syncUsage(RStat::zeroed), m_searchUsage(RStat::zeroed),
+      m_syncUsage(RStat::zeroed), m_searchUsage(ClockStat::thread),
       m_shouldLog(string_cast<bool>(logDefault, checked_string(configData.Attribute("log")))), 
-      m_debugStream(debugFileName(m_agentName, m_name).c_str()){
+      m_debugStream(debugFileName(m_agentName, m_name).c_str()),
+      m_disturbed(true), m_tickStartPending(false),
+      m_inputTrace(openInputTrace(agentName, configData)), m_tracedTick(-1){
     DebugMessage::setStream(getStream());
     TREX_INFO("TeleoReactor:TeleoReactor", "Allocating '" << agentName.toString() << "." << m_name.toString());
   }
 
   TeleoReactor::~TeleoReactor(){
     DebugMessage::setStream(Agent::instance()->getStream());
+    // Writes the tick index of the trace
+    delete m_inputTrace;
     m_thisObserver.release();
     m_thisServer.release();
     m_id.remove();
   }
 
+  /**
+   * @brief The trace is written in the reactor log directory. SimAdapter replays it, with trace="..."
+   */
+  BinaryObservationWriter* TeleoReactor::openInputTrace(const LabelStr& agentName, const TiXmlElement& configData){
+    const char* traced = configData.Attribute("traceInputs");
+    if(traced == NULL || strcmp(traced, "true") != 0)
+      return NULL;
+
+    std::string path = LogManager::instance().reactor_file_path(agentName.toString(), extractData(configData, "name").toString(), "inputs.trace");
+    FILE* file = fopen(path.c_str(), "wb");
+    ConfigurationException::configurationCheckError(file != NULL, "Unable to open " + path);
+    return new BinaryObservationWriter(file);
+  }
+
+  void TeleoReactor::traceTick(){
+    if(m_tracedTick != (int) getCurrentTick()){
+      m_tracedTick = getCurrentTick();
+      m_inputTrace->tick(getCurrentTick());
+    }
+  }
+
   const TeleoReactorId& TeleoReactor::getId() const {return m_id;}
 
   const LabelStr& TeleoReactor::getName() const {return m_name;}
@@ -195,52 +247,43 @@ namespace TREX {
     return ss.str();
   }
 
-  int TeleoReactor::getPriority(int callCount){
-    std::list<LabelStr> externals, internals;
-    queryTimelineModes(externals, internals);
-
-    checkError(callCount < Agent::instance()->getReactorCount(), "Cycle detected in reactor specification");
-
-    // If has no externals, then 0
-    if(externals.empty())
-      return 0;
+  /**
+   * @brief The level is computed once by the Agent when building the reactor dependency graph
+   * @see Agent::getLevel
+   */
+  int TeleoReactor::getPriority() const {
+    return Agent::instance()->getLevel(getName());
+  }
 
-    int priority = 0;
-    for(std::list<LabelStr>::const_iterator it = externals.begin(); it != externals.end(); ++it){
-      const LabelStr& timeline = *it;
-      TeleoReactorId owner = Agent::instance()->getOwner(timeline);
-      checkError(owner.isValid(), "Invalid id for " << timeline.toString());
-      priority = std::max(priority, owner->getPriority(callCount + 1));
+  /**
+   * @brief Comparator based on dependency level
+   */
+  class PriorityComparator {
+  public:
+    bool operator()(const TeleoReactorId& a, const TeleoReactorId& b) const {
+      return a->getPriority() < b->getPriority();
     }
-
-    return 1 + priority;
-  }
+  };
 
   void TeleoReactor::sort(std::vector<TeleoReactorId>& reactors){
-    bool swapped = true;
-    int count = reactors.size()-1;
-    while(swapped){
-      swapped = false;
-      for(int i=0;i<count;i++){
-	TeleoReactorId a = reactors[i];
-	TeleoReactorId b = reactors[i+1];
-	if(b->getPriority() < a->getPriority()){
-	  reactors[i] = b;
-	  reactors[i+1] = a;
-	  swapped = true;
-	}
-      }
-    }
+    std::stable_sort(reactors.begin(), reactors.end(), PriorityComparator());
   }
 
   bool TeleoReactor::doSynchronize() {
+    if(m_tickStartPending)
+      doHandleTickStart();
     DebugMessage::setStream(getStream());
+    m_disturbed = false;
     ++m_syncCount;    
     RStatLap chrono(m_syncUsage, RStat::self);
+    LatencyTimer timer(m_latency[PerformanceMonitor::SYNCHRONIZE]);
+    TickTraceScope trace("synchronize", getName().c_str());
     { // To be "sure" that chrono is created before we call synchronize
       TREX_INFO("trex:debug:timing", "BEFORE synchronization:" << timeString());
+      drainInputs();
       bool result = synchronize();
       TREX_INFO("trex:debug:timing", "AFTER synchronization:" << timeString());
+      measureMemory(m_memoryUsage);
       return result;
     }
   }
@@ -249,7 +292,9 @@ namespace TREX {
     DebugMessage::setStream(getStream());
 
     ++m_searchCount;
-    RStatLap chrono(m_searchUsage, RStat::self);
+    ClockStatLap chrono(m_searchUsage);
+    LatencyTimer timer(m_latency[PerformanceMonitor::RESUME]);
+    TickTraceScope trace("resume", getName().c_str());
     {
       TREX_INFO("trex:debug:timing", "BEFORE resume:" << timeString());
       resume();
@@ -266,16 +311,53 @@ namespace TREX {
     m_syncUsage.reset();
     m_searchCount = 0;
     m_searchUsage.reset();
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      m_latency[i].reset();
     TickLogger *log = LogManager::instance().getTickLog(CPU_STAT_LOG);
 
     log->addField(getName().toString()+".sync.nSyncs", m_syncCount);
     log->addField(getName().toString()+".sync.userTime", m_syncUsage.user_time());
     log->addField(getName().toString()+".search.nResume", m_searchCount);
     log->addField(getName().toString()+".search.userTime", m_searchUsage.user_time());
+    log->addField(getName().toString()+".memory.nTokens", m_memoryUsage.tokens);
+    log->addField(getName().toString()+".memory.nVariables", m_memoryUsage.variables);
+    log->addField(getName().toString()+".memory.nConstraints", m_memoryUsage.constraints);
+    log->addField(getName().toString()+".memory.nEntities", m_memoryUsage.entities);
 
     handleInit(initialTick, serversByTimeline, observer);
   }
 
+  /**
+   * @brief Name of the p99 or max latency field of a phase. Built once, as samples are taken on every tick.
+   */
+  static const char* latencyField(unsigned int phase, bool max){
+    static std::vector<std::string> s_fields;
+    if(s_fields.empty()){
+      for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++){
+	const std::string field = std::string("latency.") + PerformanceMonitor::phaseName((PerformanceMonitor::Phase) i);
+	s_fields.push_back(field + ".p99");
+	s_fields.push_back(field + ".max");
+      }
+    }
+    return s_fields[2 * phase + (max ? 1 : 0)].c_str();
+  }
+
+  void TeleoReactor::writeTelemetry(TelemetrySample& out) const {
+    out.add(getName(), "sync.nSyncs", m_syncCount);
+    out.add(getName(), "sync.userTime", to_double(m_syncUsage.user_time()));
+    out.add(getName(), "search.nResume", m_searchCount);
+    out.add(getName(), "search.userTime", to_double(m_searchUsage.user_time()));
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++){
+      const LatencyHistogram& h = m_latency[i];
+      out.add(getName(), latencyField(i, false), h.percentile(0.99));
+      out.add(getName(), latencyField(i, true), h.max());
+    }
+    out.add(getName(), "memory.nTokens", m_memoryUsage.tokens);
+    out.add(getName(), "memory.nVariables", m_memoryUsage.variables);
+    out.add(getName(), "memory.nConstraints", m_memoryUsage.constraints);
+    out.add(getName(), "memory.nEntities", m_memoryUsage.entities);
+  }
+
   void TeleoReactor::doHandleTickStart() {
     DebugMessage::setStream(getStream());
 
@@ -283,24 +365,90 @@ namespace TREX {
     m_syncUsage.reset();
     m_searchCount = 0;
     m_searchUsage.reset();
+    LatencyTimer timer(m_latency[PerformanceMonitor::TICK_START]);
+    m_tickStartPending = false;
     handleTickStart();
   }
 
+  bool TeleoReactor::isQuiet(TICK tick) {
+    return !m_disturbed && nextActiveTick() > tick;
+  }
+
   /**
    * @brief Handle in the derived class if provided
    */
   void TeleoReactor::notify(const Observation& observation){}
 
+  void TeleoReactor::notifyBatch(const std::vector<const Observation*>& observations){
+    for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it)
+      notify(**it);
+  }
+
+  void TeleoReactor::doNotify(const Observation& observation){
+    if(m_inputTrace != NULL){
+      traceTick();
+      m_inputTrace->log(observation);
+    }
+    LatencyTimer timer(m_latency[PerformanceMonitor::NOTIFY]);
+    m_disturbed = true;
+    notify(observation);
+  }
+
+  void TeleoReactor::doNotify(const std::vector<const Observation*>& observations){
+    if(m_inputTrace != NULL){
+      traceTick();
+      for(std::vector<const Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it)
+	m_inputTrace->log(**it);
+    }
+    LatencyTimer timer(m_latency[PerformanceMonitor::NOTIFY]);
+    m_disturbed = true;
+    notifyBatch(observations);
+  }
+
   /**
    * @brief Log the request prior to delegation
    */
   bool TeleoReactor::request(const TokenId& goal){
     DebugMessage::setStream(getStream());
     Agent::instance()->logRequest(goal);
-    TREXLog() << nameString() << "Request received: " << tokenToString(goal);
+    TREX_SYSLOG("trex:request", nameString() << "Request received: " << tokenToString(goal));
+    if(m_inputTrace != NULL){
+      traceTick();
+      m_inputTrace->request(goal);
+    }
+    LatencyTimer timer(m_latency[PerformanceMonitor::DISPATCH]);
+    m_disturbed = true;
     return handleRequest(goal);
   }
 
+  /**
+   * @brief Log the requests prior to delegation
+   */
+  void TeleoReactor::request(const std::vector<TokenId>& goals, std::vector<bool>& accepted){
+    DebugMessage::setStream(getStream());
+    LatencyTimer timer(m_latency[PerformanceMonitor::DISPATCH]);
+    m_disturbed = true;
+    std::set<double> refused; // Timelines with a goal not received
+
+    accepted.assign(goals.size(), false);
+    for(unsigned int i = 0; i < goals.size(); i++){
+      const TokenId& goal = goals[i];
+      const LabelStr timeline = Observation::getTimelineName(goal);
+      if(refused.find(timeline) != refused.end())
+	continue;
+
+      Agent::instance()->logRequest(goal);
+      TREX_SYSLOG("trex:request", nameString() << "Request received: " << tokenToString(goal));
+      if(m_inputTrace != NULL){
+	traceTick();
+	m_inputTrace->request(goal);
+      }
+      accepted[i] = handleRequest(goal);
+      if(!accepted[i])
+	refused.insert(timeline);
+    }
+  }
+
   /**
    * @brief Handle in the derived class if provided
    */
@@ -312,15 +460,39 @@ namespace TREX {
   void TeleoReactor::recall(const TokenId& goal){
     Agent::instance()->logRecall(goal);
     DebugMessage::setStream(getStream());
-    TREXLog() << nameString() << "Recall received: " << tokenToString(goal) << std::endl;
+    TREX_SYSLOG("trex:recall", nameString() << "Recall received: " << tokenToString(goal) << std::endl);
+    if(m_inputTrace != NULL){
+      traceTick();
+      m_inputTrace->recall(goal);
+    }
+    m_disturbed = true;
     handleRecall(goal);
   }
 
+  void TeleoReactor::recall(const std::vector<TokenId>& goals){
+    DebugMessage::setStream(getStream());
+    for(std::vector<TokenId>::const_iterator it = goals.begin(); it != goals.end(); ++it){
+      Agent::instance()->logRecall(*it);
+      TREX_SYSLOG("trex:recall", nameString() << "Recall received: " << tokenToString(*it) << std::endl);
+      if(m_inputTrace != NULL){
+	traceTick();
+	m_inputTrace->recall(*it);
+      }
+    }
+    m_disturbed = true;
+    handleRecall(goals);
+  }
+
   /**
    * @brief Handle in the derived class if provided
    */
   void TeleoReactor::handleRecall(const TokenId& goal){}
 
+  void TeleoReactor::handleRecall(const std::vector<TokenId>& goals){
+    for(std::vector<TokenId>::const_iterator it = goals.begin(); it != goals.end(); ++it)
+      handleRecall(*it);
+  }
+
   TICK TeleoReactor::getLatency() const {
     return m_latency;
   }
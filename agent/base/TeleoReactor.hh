@@ -45,12 +45,17 @@
 #include "Observer.hh"
 #include "LogManager.hh"
 #include "RStat.hh"
+#include "ClockStat.hh"
+#include "PerformanceMonitor.hh"
+#include "TelemetryServer.hh"
 
 #include <list>
 #include <map>
 
 namespace TREX {
 
+  class BinaryObservationWriter;
+
   class TeleoReactor {
   public:
 
@@ -76,9 +81,13 @@ namespace TREX {
 
     /**
      * @brief Get priority based on dependency level in a DAG
+     * @see Agent::getLevel
      */
-    int getPriority(int callCount = 0);
+    int getPriority() const;
 
+    /**
+     * @brief Stable sort of reactors by dependency level
+     */
     static void sort(std::vector<TeleoReactorId>& reactors);
 
     /**
@@ -99,16 +108,44 @@ namespace TREX {
      */
     bool request(const TokenId& goal);
 
+    /**
+     * @brief Interception for a batch of requests. Each goal is logged and handled by handleRequest in order, skipping
+     * the goals which follow one not received on the same timeline.
+     * @param goals The goal tokens.
+     * @param accepted Set to the result of handleRequest for each goal. False for the skipped ones.
+     */
+    void request(const std::vector<TokenId>& goals, std::vector<bool>& accepted);
+
     /**
      * @brief Interception for recalls received so they can be logged prior to delegation
      */
     void recall(const TokenId& goal);
 
+    /**
+     * @brief Interception for a batch of recalls. Each goal is logged, then the batch is handled at once by handleRecall.
+     */
+    void recall(const std::vector<TokenId>& goals);
+
     /**
      * @brief Handle observations.
      */
     virtual void notify(const Observation& observation);
 
+    /**
+     * @brief Handle all the observations of a tick at once. The default handles them one by one through notify.
+     */
+    virtual void notifyBatch(const std::vector<const Observation*>& observations);
+
+    /**
+     * @brief Deliver an observation, recording the time spent in notify
+     */
+    void doNotify(const Observation& observation);
+
+    /**
+     * @brief Deliver a batch of observations, recording the time spent in notifyBatch
+     */
+    void doNotify(const std::vector<const Observation*>& observations);
+
     /**
      * @brief Commands the server to handle a request expressed as a goal network.
      * @param goal The goal token.
@@ -122,6 +159,11 @@ namespace TREX {
      */
     virtual void handleRecall(const TokenId& goal);
 
+    /**
+     * @brief Tells the server to handle the recall of a batch of goals. The default handles them one by one.
+     */
+    virtual void handleRecall(const std::vector<TokenId>& goals);
+
     /**
      * @brief Retrieve the latency it takes to respond. This is used in planning when to dispatch goals. It is a lower bound on dispatch window.
      */
@@ -211,8 +253,40 @@ namespace TREX {
      */
     virtual bool hasWork() = 0;
 
+    /**
+     * @brief The first tick at which the reactor needs to start and synchronize again. Until then the agent skips it,
+     * unless it receives observations, requests or recalls. The default asks for every tick.
+     */
+    virtual TICK nextActiveTick() {return 0;}
+
+    /**
+     * @brief Test if the agent can skip the reactor at the given tick
+     */
+    bool isQuiet(TICK tick);
+
+    /**
+     * @brief Skip the tick start of a quiet reactor. It is handled when the reactor synchronizes again.
+     */
+    void deferTickStart() {m_tickStartPending = true;}
+
     void doResume();
 
+    /**
+     * @brief Accessor for the latencies recorded for a phase since initialization
+     */
+    const LatencyHistogram& getLatency(PerformanceMonitor::Phase phase) const {return m_latency[phase];}
+
+    /**
+     * @brief Accessor for the entities held by the reactor as of its last synchronization
+     */
+    const MemoryUsage& getMemoryUsage() const {return m_memoryUsage;}
+
+    /**
+     * @brief Add the statistics of the current tick to the sample served by the TelemetryServer, as "<reactor>.<field>"
+     * fields. The same fields must be added on every tick.
+     */
+    virtual void writeTelemetry(TelemetrySample& out) const;
+
 
   protected:
     /**
@@ -236,11 +310,21 @@ namespace TREX {
      */
     virtual void handleTickStart(){}
 
+    /**
+     * @brief Deliver the inputs queued by other threads. Called before each synchronization. The default queues none.
+     */
+    virtual void drainInputs(){}
+
     /**
      * @brief Synchronize buffered observations.
      */
     virtual bool synchronize(){return true;}
 
+    /**
+     * @brief Count the entities held by the reactor. Called after each synchronization. The default holds none.
+     */
+    virtual void measureMemory(MemoryUsage& usage) const {}
+
     /**
      * @brief resume the work of the reactor.
      */
@@ -278,6 +362,17 @@ namespace TREX {
     static TICK getLookAheadFromXML(const TiXmlElement& configData);
     static std::string debugFileName(const LabelStr& agentName, const LabelStr& reactorName);
 
+    /**
+     * @brief Open the input trace if the configuration has traceInputs="true"
+     * @return NULL if the inputs are not traced
+     */
+    static BinaryObservationWriter* openInputTrace(const LabelStr& agentName, const TiXmlElement& configData);
+
+    /**
+     * @brief Mark the current tick in the input trace before its first input
+     */
+    void traceTick();
+
     TeleoReactorId m_id;
     const LabelStr m_name;
     const LabelStr m_agentName;
@@ -286,10 +381,17 @@ namespace TREX {
     ServerId m_thisServer; /*!< A narrower interface to receive goal requests */
 
     size_t m_syncCount, m_searchCount;
-    RStat m_syncUsage, m_searchUsage;
+    RStat m_syncUsage;
+    ClockStat m_searchUsage; /*!< Timed per resume step, hence the cheaper clock */
+    LatencyHistogram m_latency[PerformanceMonitor::PHASE_COUNT]; /*!< Wall clock latencies by phase */
+    MemoryUsage m_memoryUsage; /*!< Entity counts as of the last synchronization */
 
     bool const m_shouldLog;
     std::ofstream m_debugStream;
+    bool m_disturbed; /*!< Received observations, requests or recalls since it last synchronized */
+    bool m_tickStartPending; /*!< A tick start was deferred while quiet */
+    BinaryObservationWriter* m_inputTrace; /*!< Records the observations, requests and recalls received. NULL if not traced */
+    int m_tracedTick; /*!< Last tick marked in the input trace */
 
   };
 
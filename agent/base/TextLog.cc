@@ -41,10 +41,34 @@
  *
  * @author Frederic Py <fpy@mbari.org>
  */
+#include <sstream>
+
 #include "Guardian.hh"
+#include "Thread.hh"
 
 #include "TextLog.hh"
 
+namespace TREX {
+
+  /** @brief TextLog background writer thread.
+   */
+  class TextLog::Writer :public Thread {
+  public:
+    Writer(TextLog &owner)
+      :m_owner(owner) {}
+    ~Writer() {}
+
+  private:
+    void *run() {
+      m_owner.drain();
+      return NULL;
+    }
+
+    TextLog &m_owner;
+  }; // TREX::TextLog::Writer
+
+} // TREX
+
 using namespace TREX;
 /*
  * class TextLog
@@ -52,25 +76,103 @@ using namespace TREX;
 
 // structors :
 
-TextLog::TextLog() {}
+TextLog::TextLog() 
+  :m_lock(Mutex::inheritProtocol), m_writer(NULL), m_maxBytes(0), m_dropped(0), m_reported(0),
+   m_writing(false), m_stop(false) {}
 
 TextLog::TextLog(std::string const &name)
-  :m_log(name.c_str()) {}
-
-TextLog::~TextLog() {}
+  :m_lock(Mutex::inheritProtocol), m_log(name.c_str()), m_writer(NULL), m_maxBytes(0), m_dropped(0), 
+   m_reported(0), m_writing(false), m_stop(false) {}
+
+TextLog::~TextLog() {
+  if( NULL!=m_writer ) {
+    {
+      Guardian<Mutex> guard(m_lock);
+      m_stop = true;
+      m_pendingCond.broadcast();
+    }
+    m_writer->join();
+    delete m_writer;
+  }
+}
 
 // Manipulators :
 
 void TextLog::open(std::string const &name) {
   Guardian<Mutex> guard(m_lock);
   
+  // Do not switch file under the feet of the writer
+  while( m_writing || !m_pending.empty() )
+    m_drainedCond.wait(m_lock);
   m_log.open(name.c_str());
 }
 
-void TextLog::write(std::string const &text) {
+void TextLog::setAsync(size_t maxBytes, Thread::Scheduling const &sched) {
+  Guardian<Mutex> guard(m_lock);
+
+  m_maxBytes = maxBytes;
+  if( NULL==m_writer ) {
+    m_writer = new Writer(*this);
+    if( !sched.isDefault() )
+      m_writer->setScheduling(sched);
+    m_writer->start();
+  }
+}
+
+void TextLog::flush() {
+  Guardian<Mutex> guard(m_lock);
+
+  while( NULL!=m_writer && (m_writing || !m_pending.empty()) ) 
+    m_drainedCond.wait(m_lock);
+  m_log.flush();
+}
+
+void TextLog::write(char const *text, size_t len) {
   Guardian<Mutex> guard(m_lock);
   
-  m_log<<text<<std::flush;
+  if( NULL==m_writer ) 
+    m_log.write(text, len).flush();
+  else if( m_pending.size()+len>m_maxBytes )
+    ++m_dropped;
+  else {
+    m_pending.append(text, len);
+    m_pendingCond.signal();
+  }
+}
+
+void TextLog::drain() {
+  Guardian<Mutex> guard(m_lock);
+  std::string batch;
+
+  while( true ) {
+    if( m_pending.empty() ) {
+      m_drainedCond.broadcast();
+      if( m_stop )
+	return;
+      m_pendingCond.wait(m_lock);
+      continue;
+    }
+    batch.swap(m_pending);
+    if( m_dropped!=m_reported ) {
+      std::ostringstream oss;
+      oss<<"[TextLog] "<<(m_dropped-m_reported)<<" entries dropped\n";
+      batch.append(oss.str());
+      m_reported = m_dropped;
+    }
+    m_writing = true;
+    m_lock.unlock();
+    m_log<<batch<<std::flush;
+    batch.clear();
+    m_lock.lock();
+    m_writing = false;
+  }
+}
+
+// Observers :
+
+unsigned long TextLog::dropped() const {
+  Guardian<Mutex> guard(m_lock);
+  return m_dropped;
 }
 
 /* 
@@ -88,7 +190,7 @@ LogEntry::LogEntry(LogEntry const &other)
 }
 
 LogEntry::~LogEntry() {
-  std::string to_log = m_buff.str();
+  TickString to_log = m_buff.str();
   if( !to_log.empty() )
-    m_owner.write(to_log);
+    m_owner.write(to_log.data(), to_log.size());
 }
@@ -48,6 +48,9 @@
 #include <sstream>
 
 #include "MutexWrapper.hh"
+#include "Condition.hh"
+#include "Thread.hh"
+#include "TickArena.hh"
 
 namespace TREX {
 
@@ -60,6 +63,11 @@ namespace TREX {
    * This class implements a simple logging system that ensures that the
    * text displayed will not be splitted by other thread access.
    *
+   * By default each entry is written and flushed synchronously. In the
+   * asynchronous mode (see setAsync) entries are appended to a bounded
+   * buffer which is written to the file by a background thread. Entries
+   * that do not fit in the buffer are dropped and counted.
+   *
    * @author Frederic Py <fpy@mbari.org>
    *
    * @todo This class has to be more strongly linked to LogManager to be sure that
@@ -104,28 +112,82 @@ namespace TREX {
      */
     void open(std::string const &file);
 
+    /** @brief Switch to asynchronous mode
+     *
+     * @param maxBytes Maximum size of the pending text
+     * @param sched Scheduling of the writer thread
+     *
+     * Starts the background writer thread. Once in asynchronous mode,
+     * an entry which would make the pending text exceed @e maxBytes
+     * is dropped.
+     *
+     * @pre @e maxBytes>0
+     * @throw ErrnoExcept error while creating the writer thread
+     */
+    void setAsync(size_t maxBytes, Thread::Scheduling const &sched =Thread::Scheduling());
+    /** @brief Flush pending entries
+     *
+     * Waits until all the pending entries are written to the file.
+     */
+    void flush();
+
+    /** @brief Number of dropped entries
+     *
+     * @return the number of entries dropped because the pending
+     * buffer was full.
+     */
+    unsigned long dropped() const;
+
   private:
+    class Writer;
+
+    /** @brief Background writer main loop */
+    void drain();
+
     /** @brief stream mutex
      *
      * This mutex is used by TextLog::write to ensure that one text is written at a time.
+     * It also protects the asynchronous mode attributes. It inherits priority as a real time
+     * thread logging must not wait for a lower priority writer preempted while holding it.
      */
-    Mutex m_lock;
+    mutable Mutex m_lock;
     /** @brief Log file
      *
      * This is the file that will be updated by TextLog::write.
      */
     std::ofstream m_log;
 
+    /** @brief Signaled when text is pending or when the writer stops */
+    Condition m_pendingCond;
+    /** @brief Signaled when the pending text has been written */
+    Condition m_drainedCond;
+    /** @brief Background writer. NULL in synchronous mode */
+    Writer *m_writer;
+    /** @brief Text waiting for the writer */
+    std::string m_pending;
+    /** @brief Maximum size of m_pending */
+    size_t m_maxBytes;
+    /** @brief Number of dropped entries */
+    unsigned long m_dropped;
+    /** @brief Number of dropped entries already reported in the log */
+    unsigned long m_reported;
+    /** @brief Set while the writer is writing a batch */
+    bool m_writing;
+    /** @brief Set on destruction to stop the writer */
+    bool m_stop;
+
     /** @brief Physical log writing
      *
      * This method is called by LogEntry destructor to write a new entry physically
      * on the log file. It is the only critical section connected to this class.
      *
      * @param text The text to wirite in the log file.
+     * @param len The length of @e text
      */ 
-    void write(std::string const &text);
+    void write(char const *text, size_t len);
 
     friend class LogEntry;
+    friend class Writer;
   }; // TextLog
 
   /** @brief TextLog proxy for producting a new entry.
@@ -193,9 +255,9 @@ namespace TREX {
      *
      * This is the stream used as proxy. All output operations to the LogEntry will
      * be buffered using this stream which will give the final text to write
-     * at destruction.
+     * at destruction. Its buffer comes from the TickArena of the calling thread.
      */
-    mutable std::ostringstream m_buff;
+    mutable TickStringStream m_buff;
     
     // These function are not implemented in purpose
     LogEntry();
@@ -42,6 +42,9 @@
  * @author Frederic Py <fpy@mbari.org>
  */
 #include <sched.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 
 #include "Thread.hh"
 
@@ -95,6 +98,66 @@ extern "C" {
 
 using namespace TREX;
 
+namespace {
+
+# ifdef __linux__
+  void cpuSet(std::vector<int> const &cpus, cpu_set_t &set) {
+    CPU_ZERO(&set);
+    for(std::vector<int>::const_iterator i=cpus.begin(); cpus.end()!=i; ++i)
+      CPU_SET(*i, &set);
+  }
+# endif // __linux__
+
+  void checkPthread(int ret, std::string const &from) {
+    if( 0!=ret ) {
+      // pthread functions return their error instead of setting errno
+      errno = ret;
+      throw ErrnoExcept(from);
+    }
+  }
+
+}
+
+/*
+ * class Thread::Scheduling
+ */
+
+Thread::Scheduling::Scheduling(std::string const &spec)
+  :policy(otherPolicy), priority(0) {
+  std::string::size_type at = spec.find('@');
+  std::string head = spec.substr(0, at);
+  std::string::size_type colon = head.find(':');
+  std::string name = head.substr(0, colon);
+
+  if( "fifo"==name )
+    policy = fifoPolicy;
+  else if( "rr"==name )
+    policy = rrPolicy;
+  else if( !name.empty() && "other"!=name )
+    throw ThreadExcept("Thread::Scheduling : unknown policy \""+name+"\"");
+  if( std::string::npos!=colon ) {
+    char *end;
+    std::string value = head.substr(colon+1);
+    priority = strtol(value.c_str(), &end, 10);
+    if( value.empty() || '\0'!=*end )
+      throw ThreadExcept("Thread::Scheduling : invalid priority \""+value+"\"");
+  }
+  if( std::string::npos!=at ) {
+    // Every item of the list must be a cpu, including the last one
+    std::string::size_type begin = at+1, comma;
+    do {
+      char *end;
+      comma = spec.find(',', begin);
+      std::string cpu = spec.substr(begin, std::string::npos==comma ? comma : comma-begin);
+      long value = strtol(cpu.c_str(), &end, 10);
+      if( cpu.empty() || '\0'!=*end || value<0 )
+	throw ThreadExcept("Thread::Scheduling : invalid cpu \""+cpu+"\"");
+      cpus.push_back(value);
+      begin = comma+1;
+    } while( std::string::npos!=comma );
+  }
+}
+
 /*
  * class Thread
  */ 
@@ -112,6 +175,24 @@ void Thread::yield() {
   ::sched_yield();
 }
 
+void Thread::setCurrentScheduling(Thread::Scheduling const &sched) {
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched.priority;
+  checkPthread(::pthread_setschedparam(pthread_self(), sched.policy, &param),
+	       "Thread::setCurrentScheduling");
+  if( !sched.cpus.empty() ) {
+# ifdef __linux__
+    cpu_set_t set;
+    cpuSet(sched.cpus, set);
+    checkPthread(::pthread_setaffinity_np(pthread_self(), sizeof(set), &set),
+		 "Thread::setCurrentScheduling");
+# else
+    throw ThreadExcept("Thread::setCurrentScheduling : CPU affinity is not supported.");
+# endif // __linux__
+  }
+}
+
 // Structors :
 
 Thread::Thread() 
@@ -143,6 +224,29 @@ void Thread::setStackSize(size_t size) {
     throw ErrnoExcept("Thread::setStackSize");
 }
 
+void Thread::setScheduling(Thread::Scheduling const &sched) {
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched.priority;
+  // Without this the thread inherits the scheduling of its creator
+  checkPthread(::pthread_attr_setinheritsched(&m_attr, PTHREAD_EXPLICIT_SCHED),
+	       "Thread::setScheduling");
+  checkPthread(::pthread_attr_setschedpolicy(&m_attr, sched.policy),
+	       "Thread::setScheduling");
+  checkPthread(::pthread_attr_setschedparam(&m_attr, &param),
+	       "Thread::setScheduling");
+  if( !sched.cpus.empty() ) {
+# ifdef __linux__
+    cpu_set_t set;
+    cpuSet(sched.cpus, set);
+    checkPthread(::pthread_attr_setaffinity_np(&m_attr, sizeof(set), &set),
+		 "Thread::setScheduling");
+# else
+    throw ThreadExcept("Thread::setScheduling : CPU affinity is not supported.");
+# endif // __linux__
+  }
+}
+
 // Manipulators :
 
 void Thread::start() {
@@ -207,8 +311,12 @@ void ThreadImpl::start() {
 
 void *ThreadImpl::run() {
   void *ret = m_thread->run();
-  m_id = 0;
-  delete this;
+  // A joinable thread is cleaned up by join() : deleting ourselves
+  // here would race with a concurrent call to Thread::join()
+  if( Thread::detached==m_thread->getDetachState() ) {
+    m_id = 0;
+    delete this;
+  }
   return ret;
 }
 
@@ -43,6 +43,11 @@
 *  POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <sched.h>
+
+#include <string>
+#include <vector>
+
 #include "MutexWrapper.hh"
 
 namespace TREX {
@@ -95,6 +100,51 @@ namespace TREX {
       detached = PTHREAD_CREATE_DETACHED //!< Thread is detached
     }; // Thread::DetachState
 
+    /** @brief Thread scheduling policy.
+     *
+     * This type is used to set the scheduling policy of a Thread.
+     */
+    enum Policy {
+      otherPolicy = SCHED_OTHER, //!< Default time sharing
+      fifoPolicy = SCHED_FIFO, //!< Real time, first in first out
+      rrPolicy = SCHED_RR //!< Real time, round robin
+    }; // Thread::Policy
+
+    /** @brief Thread scheduling options.
+     *
+     * The scheduling policy, the priority and the CPUs a thread may
+     * run on. They are given in the configuration by a
+     * specification of the form @c policy[:priority][\@cpu,...]
+     * such as "fifo:80@2" or "other@0,1".
+     *
+     * @sa Mutex::inheritProtocol for the mutexes a real time thread
+     * may still be delayed on.
+     */
+    struct Scheduling {
+      /** @brief Constructor.
+       *
+       * Default time sharing scheduling on all the CPUs.
+       */
+      Scheduling()
+	:policy(otherPolicy), priority(0) {}
+      /** @brief Constructor.
+       *
+       * @param spec A scheduling specification
+       *
+       * @throw ThreadExcept @e spec is not a valid specification
+       */
+      explicit Scheduling(std::string const &spec);
+
+      /** @brief Test for the default scheduling */
+      bool isDefault() const {
+	return otherPolicy==policy && cpus.empty();
+      }
+
+      Policy policy; //!< Scheduling policy
+      int priority; //!< Priority. Only used with the real time policies
+      std::vector<int> cpus; //!< CPUs the thread may run on. Empty for all
+    }; // Thread::Scheduling
+
     /** @brief Constructor.
      *
      * Create a new thread.
@@ -149,6 +199,19 @@ namespace TREX {
      * @throw ErrnoExcept Error while trying to change thread stacjk size.
      */
     void setStackSize(size_t size);
+    /** @brief Set thread scheduling.
+     *
+     * @param sched Scheduling options
+     *
+     * Change the scheduling policy, priority and CPU affinity
+     * attributes of this thread.
+     *
+     * @pre The Thread is not runnning yet.
+     *
+     * @throw ErrnoExcept Error while trying to change thread scheduling.
+     * @throw ThreadExcept CPU affinity is not supported by this system.
+     */
+    void setScheduling(Scheduling const &sched);
 
     /** @brief Get thread scope.
      *
@@ -224,6 +287,18 @@ namespace TREX {
      * Indicates to the scheduler that the caller can yield to let other threads execute themselves.
      */
     static void yield(); 
+    /** @brief Scheduling of the calling thread.
+     *
+     * @param sched Scheduling options
+     *
+     * Change the scheduling of the caller. This is how threads
+     * which were not created by a Thread, such as the agent main
+     * thread, are configured.
+     *
+     * @throw ErrnoExcept Error while trying to change thread scheduling.
+     * @throw ThreadExcept CPU affinity is not supported by this system.
+     */
+    static void setCurrentScheduling(Scheduling const &sched);
 
   protected:
     /** @brief Thread main code
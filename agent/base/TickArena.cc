@@ -0,0 +1,139 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TickArena.cc"
+ */
+#include <cstdlib>
+#include <pthread.h>
+
+#include "TickArena.hh"
+#include "Debug.hh"
+#include "Error.hh"
+
+namespace TREX {
+
+  static pthread_key_t s_arenaKey;
+
+  static pthread_once_t s_arenaOnce = PTHREAD_ONCE_INIT;
+
+  void TickArena::createKey() {
+    pthread_key_create(&s_arenaKey, deleteArena);
+  }
+
+  void TickArena::deleteArena(void *arena) {
+    delete static_cast<TickArena *>(arena);
+  }
+
+  TickArena &TickArena::instance() {
+    pthread_once(&s_arenaOnce, createKey);
+    TickArena *result = static_cast<TickArena *>(pthread_getspecific(s_arenaKey));
+    if( NULL==result ) {
+      result = new TickArena();
+      pthread_setspecific(s_arenaKey, result);
+    }
+    return *result;
+  }
+
+  TickArena::TickArena()
+    :m_current(0), m_used(0), m_live(0), m_mallocs(0) {}
+
+  TickArena::~TickArena() {
+    condDebugMsg(m_live>0, "trex:warning", m_live<<" blocks still in use when destroying the tick arena");
+    for(std::vector<Chunk>::iterator it = m_chunks.begin(); it!=m_chunks.end(); ++it)
+      free(it->data);
+  }
+
+  void TickArena::addChunk(size_t bytes) {
+    Chunk chunk;
+    chunk.data = static_cast<char *>(malloc(bytes));
+    if( NULL==chunk.data )
+      throw std::bad_alloc();
+    chunk.size = bytes;
+    ++m_mallocs;
+    m_chunks.push_back(chunk);
+  }
+
+  void *TickArena::allocate(size_t bytes) {
+    size_t n = (bytes+ALIGNMENT-1)&~(ALIGNMENT-1);
+    if( 0==n )
+      n = ALIGNMENT;
+    // Move to the first chunk with enough room left
+    while( m_current<m_chunks.size() && m_used+n>m_chunks[m_current].size ) {
+      ++m_current;
+      m_used = 0;
+    }
+    if( m_current==m_chunks.size() ) {
+      addChunk(n>CHUNK_SIZE ? n : CHUNK_SIZE);
+      m_used = 0;
+    }
+    void *result = m_chunks[m_current].data+m_used;
+    m_used += n;
+    ++m_live;
+    return result;
+  }
+
+  void TickArena::deallocate(void *ptr, size_t bytes) {
+    if( NULL==ptr )
+      return;
+    checkError(m_live>0, "Releasing a block that was not allocated by this arena");
+    if( 0==--m_live ) {
+      m_current = 0;
+      m_used = 0;
+    }
+  }
+
+  void TickArena::reset() {
+    if( m_live>0 ) {
+      debugMsg("TickArena:reset", m_live<<" blocks still in use. Arena not reset.");
+      return;
+    }
+    m_current = 0;
+    m_used = 0;
+    if( m_chunks.size()>1 ) {
+      // A single chunk as large as all the others holds the same temporaries
+      size_t total = 0;
+      for(std::vector<Chunk>::iterator it = m_chunks.begin(); it!=m_chunks.end(); ++it) {
+	total += it->size;
+	free(it->data);
+      }
+      m_chunks.clear();
+      addChunk(total);
+      debugMsg("TickArena:reset", "Merged chunks into one of "<<total<<" bytes");
+    }
+  }
+
+}
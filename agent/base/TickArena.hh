@@ -0,0 +1,216 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TickArena.hh"
+ * @brief Definition of the per tick memory arena
+ */
+#ifndef _TICKARENA_HH
+#define _TICKARENA_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <list>
+#include <new>
+#include <sstream>
+#include <vector>
+
+namespace TREX {
+
+  /** @brief Per thread monotonic arena for tick temporaries.
+   *
+   * Allocation bumps a pointer in a chunk of memory obtained from
+   * malloc. Deallocation only counts the blocks still in use : once
+   * none are left the arena rewinds to its first chunk, so in steady
+   * state the temporaries of a tick reuse the memory of the previous
+   * ones without calling malloc.
+   *
+   * Each thread has its own arena, so no lock is taken. It must only
+   * hold containers local to a call : a container kept across ticks
+   * pins the arena and prevents it from rewinding.
+   *
+   * @sa TickAllocator
+   */
+  class TickArena {
+  public:
+    /** @brief Size of the chunks requested to malloc */
+    static const size_t CHUNK_SIZE = 64*1024;
+    /** @brief Alignment of the blocks handed out */
+    static const size_t ALIGNMENT = 16;
+
+    /** @brief Arena of the calling thread, created on first use */
+    static TickArena &instance();
+
+    /** @brief Allocate a block
+     * @param bytes Requested size
+     * @throw std::bad_alloc malloc failed
+     */
+    void *allocate(size_t bytes);
+    /** @brief Release a block
+     *
+     * The memory is reclaimed only when all the blocks are released.
+     */
+    void deallocate(void *ptr, size_t bytes);
+
+    /** @brief Start of tick
+     *
+     * Merges the chunks into a single one large enough for the
+     * previous tick. Nothing is done while blocks are in use.
+     */
+    void reset();
+
+    /** @brief Number of blocks in use */
+    size_t live() const {
+      return m_live;
+    }
+    /** @brief Number of chunks requested to malloc since creation */
+    unsigned long mallocCount() const {
+      return m_mallocs;
+    }
+
+    ~TickArena();
+
+  private:
+    TickArena();
+    TickArena(TickArena const &other);
+    void operator= (TickArena const &other);
+
+    void addChunk(size_t bytes);
+
+    static void createKey();
+    static void deleteArena(void *arena);
+
+    struct Chunk {
+      char *data;
+      size_t size;
+    };
+    std::vector<Chunk> m_chunks;
+    size_t m_current; /*!< Index of the chunk being filled */
+    size_t m_used; /*!< Bytes handed out in the current chunk */
+    size_t m_live;
+    unsigned long m_mallocs;
+  };
+
+  /** @brief Standard allocator backed by a TickArena.
+   *
+   * The allocator holds the arena of the thread that created it,
+   * which is also the one that releases its memory.
+   */
+  template<class Ty>
+  class TickAllocator {
+  public:
+    typedef Ty value_type;
+    typedef Ty *pointer;
+    typedef Ty const *const_pointer;
+    typedef Ty &reference;
+    typedef Ty const &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<class Other>
+    struct rebind {
+      typedef TickAllocator<Other> other;
+    };
+
+    TickAllocator()
+      :m_arena(&TickArena::instance()) {}
+    TickAllocator(TickAllocator const &other)
+      :m_arena(other.m_arena) {}
+    template<class Other>
+    TickAllocator(TickAllocator<Other> const &other)
+      :m_arena(other.arena()) {}
+
+    pointer address(reference x) const {
+      return &x;
+    }
+    const_pointer address(const_reference x) const {
+      return &x;
+    }
+
+    pointer allocate(size_type n, void const * =0) {
+      return static_cast<pointer>(m_arena->allocate(n*sizeof(Ty)));
+    }
+    void deallocate(pointer ptr, size_type n) {
+      m_arena->deallocate(ptr, n*sizeof(Ty));
+    }
+    size_type max_size() const {
+      return size_type(-1)/sizeof(Ty);
+    }
+
+    void construct(pointer ptr, Ty const &val) {
+      new(static_cast<void *>(ptr)) Ty(val);
+    }
+    void destroy(pointer ptr) {
+      ptr->~Ty();
+    }
+
+    TickArena *arena() const {
+      return m_arena;
+    }
+
+  private:
+    TickArena *m_arena;
+  };
+
+  template<class Ty, class Other>
+  bool operator==(TickAllocator<Ty> const &a, TickAllocator<Other> const &b) {
+    return a.arena()==b.arena();
+  }
+
+  template<class Ty, class Other>
+  bool operator!=(TickAllocator<Ty> const &a, TickAllocator<Other> const &b) {
+    return a.arena()!=b.arena();
+  }
+
+  /** @{
+   * @brief Containers for tick temporaries
+   */
+  template<class Ty>
+  struct TickVector {
+    typedef std::vector<Ty, TickAllocator<Ty> > type;
+  };
+
+  template<class Ty>
+  struct TickList {
+    typedef std::list<Ty, TickAllocator<Ty> > type;
+  };
+
+  typedef std::basic_string<char, std::char_traits<char>, TickAllocator<char> > TickString;
+  typedef std::basic_ostringstream<char, std::char_traits<char>, TickAllocator<char> > TickStringStream;
+  /** @} */
+
+}
+
+#endif // _TICKARENA_HH
@@ -41,6 +41,10 @@
  *
  * @author Frederic Py <fpy@mbari.org>
  */
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
 #include "LogManager.hh"
 
 using namespace TREX;
@@ -51,10 +55,17 @@ using namespace TREX;
 // structors :
 
 TickLogger::TickLogger(std::string const &fileName)
-  :m_baseName(fileName), m_file(LogManager::instance().file_name(fileName).c_str()),
-   m_inHeader(true) {}
+  :m_baseName(fileName), m_inHeader(true), m_binary(NULL!=getenv(TICKLOG_BINARY_ENV)),
+   m_rows(0), m_rowSize(0) {
+  std::ios_base::openmode mode = std::ios_base::out;
+
+  if( m_binary )
+    mode |= std::ios_base::binary;
+  m_file.open(LogManager::instance().file_name(fileName).c_str(), mode);
+}
 
 TickLogger::~TickLogger() {
+  flush();
   std::map<std::string, AbstractField *>::iterator i = m_fields.begin(), 
     endi=m_fields.end();
   for( ; endi!=i; ++i )
@@ -71,6 +82,31 @@ void TickLogger::printHeader() {
   m_inHeader = false;
   order_type::const_iterator i=m_print_order.begin(), endi = m_print_order.end();
   size_t count = 2;
+
+  if( m_binary ) {
+    uint32_t val = m_print_order.size()+1;
+
+    m_file.write("TREXTCK1", 8);
+    m_file.write(reinterpret_cast<char const *>(&val), sizeof(val));
+    val = sizeof(uint32_t);
+    m_file.write(reinterpret_cast<char const *>(&val), sizeof(val));
+    m_file.write("uint", 5);
+    m_file.write("TICK", 5);
+    m_rowSize = sizeof(uint32_t);
+    for(; endi!=i; ++i) {
+      AbstractField const *field = (*i)->second;
+
+      val = field->size();
+      m_file.write(reinterpret_cast<char const *>(&val), sizeof(val));
+      m_file.write(field->type(), strlen(field->type())+1);
+      m_file.write((*i)->first.c_str(), (*i)->first.length()+1);
+      m_columns.push_back(std::make_pair(field->address(), field->size()));
+      m_rowSize += field->size();
+    }
+    m_block.resize(m_rowSize*BLOCK_ROWS);
+    m_file.flush();
+    return;
+  }
   
   m_file<<"TICK[1]";
   for(; endi!=i; ++i, ++count)
@@ -78,17 +114,49 @@ void TickLogger::printHeader() {
   m_file<<std::endl;
 }
 
+void TickLogger::flush() {
+  if( 0==m_rows )
+    return;
+  if( m_binary )
+    m_file.write(&m_block[0], m_rows*m_rowSize);
+  else {
+    m_file<<m_text.str();
+    m_text.str("");
+  }
+  m_file.flush();
+  m_rows = 0;
+}
+
 // Observers :
 
 void TickLogger::handleNewTick(TICK current) {
-  order_type::const_iterator i=m_print_order.begin(), endi = m_print_order.end();
+  if( m_binary ) {
+    // Columns are only known once the header is written
+    if( m_inHeader )
+      printHeader();
+
+    char *row = &m_block[m_rows*m_rowSize];
+    uint32_t tick = current;
+
+    memcpy(row, &tick, sizeof(tick));
+    row += sizeof(tick);
+    for(std::vector< std::pair<void const *, size_t> >::const_iterator i=m_columns.begin();
+	m_columns.end()!=i; ++i) {
+      memcpy(row, i->first, i->second);
+      row += i->second;
+    }
+  } else {
+    order_type::const_iterator i=m_print_order.begin(), endi = m_print_order.end();
   
-  m_file<<current;
-  for( ; endi!=i; ++i) {
-    m_file.put('\t');
-    (*i)->second->print(m_file);
+    m_text<<current;
+    for( ; endi!=i; ++i) {
+      m_text.put('\t');
+      (*i)->second->print(m_text);
+    }
+    m_text.put('\n');
   }
-  m_file<<std::endl;
+  if( ++m_rows==BLOCK_ROWS )
+    flush();
 }
 
 bool TickLogger::exist(std::string const &name) const {
@@ -45,8 +45,11 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <sys/time.h>
 
 #include "TREXDefs.hh"
 
@@ -54,18 +57,72 @@ namespace TREX {
   
   class LogManager;
 
+  /** @brief Type names of the TickLogger binary format.
+   *
+   * @param Ty type of a field
+   */
+  template<class Ty>
+  struct tick_field_type {
+    static char const *name() {
+      return "raw";
+    }
+  };
+
+  template<>
+  struct tick_field_type<int> {
+    static char const *name() {
+      return "int";
+    }
+  };
+
+  template<>
+  struct tick_field_type<unsigned int> {
+    static char const *name() {
+      return "uint";
+    }
+  };
+
+  template<>
+  struct tick_field_type<long> {
+    static char const *name() {
+      return "long";
+    }
+  };
+
+  template<>
+  struct tick_field_type<double> {
+    static char const *name() {
+      return "double";
+    }
+  };
+
+  template<>
+  struct tick_field_type<timeval> {
+    static char const *name() {
+      return "timeval";
+    }
+  };
+
   /** @brief Structured periodic data logger.
    *
    * This class is used to store data in a structured way into a log file.
    * 
    * @author Frederic Py <fpy@mbari.org>
    *
-   * @note For now the data are stored in a tab separated file. Next step would be to store
-   * it in a binary format similar to what is done on MBARI auv code.
+   * @note By default the data are stored in a tab separated file. If the environment variable
+   * TREX_TICKLOG_BINARY is set, the data is stored in a binary columnar format instead. Its header
+   * is the magic number "TREXTCK1", the number of columns as a 32 bits integer and, for each column,
+   * its width in bytes as a 32 bits integer followed by its type and its name as null terminated
+   * strings. The first column is the tick. Each following row is the raw copy of the column values.
+   * In both formats rows are buffered and written by blocks of TickLogger::BLOCK_ROWS.
    *
    * @bug This class is not thread safe for now it may need to be corrected.
    */
   class TickLogger {
+  public:
+    /** @brief Number of rows buffered before writing to the file */
+    static size_t const BLOCK_ROWS = 64;
+
   private:
     /** @brief Abstract data field management.
      *
@@ -90,6 +147,12 @@ namespace TREX {
        * @retur nout after the operation.
        */
       virtual std::ostream &print(std::ostream &out) const =0;
+      /** @brief Address of the tracked variable */
+      virtual void const *address() const =0;
+      /** @brief Size of the tracked variable in bytes */
+      virtual size_t size() const =0;
+      /** @brief Type name for the binary format header */
+      virtual char const *type() const =0;
     }; // TickLogger::AbstractField
 
     /** @brief Typed data field management class.
@@ -132,7 +195,16 @@ namespace TREX {
       }
 
       std::ostream &print(std::ostream &out) const {
-	return out<<*m_ref; // For now we log into binary format
+	return out<<*m_ref;
+      }
+      void const *address() const {
+	return m_ref;
+      }
+      size_t size() const {
+	return sizeof(Ty);
+      }
+      char const *type() const {
+	return tick_field_type<Ty>::name();
       }
     private:
       /** @brief reference to tracked variable */ 
@@ -232,6 +304,11 @@ namespace TREX {
      * It is used to create e new datalog line attached to @e current tick.
      */
     void handleNewTick(TICK current);
+    /** @brief Write buffered rows
+     *
+     * Writes all the rows buffered since the last block to the file.
+     */
+    void flush();
 
   protected:
     /** @brief Constructor.
@@ -263,6 +340,18 @@ namespace TREX {
     std::ofstream m_file;
     bool m_inHeader, //!< @brief header flag
       m_closed; //!< @brief file closed flag
+    /** @brief binary format flag */
+    bool m_binary;
+    /** @brief Number of rows buffered */
+    size_t m_rows;
+    /** @brief Text rows buffer */
+    std::ostringstream m_text;
+    /** @brief Binary rows buffer. Allocated by printHeader for BLOCK_ROWS rows */
+    std::vector<char> m_block;
+    /** @brief Size of a binary row in bytes */
+    size_t m_rowSize;
+    /** @brief Address and size of each column for binary rows */
+    std::vector< std::pair<void const *, size_t> > m_columns;
 
     typedef std::map<std::string, AbstractField *> fields_type;
     typedef std::list<fields_type::const_iterator> order_type;
@@ -0,0 +1,208 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TickTrace.cc"
+ */
+#include <iomanip>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "TickTrace.hh"
+#include "ClockStat.hh"
+#include "MutexWrapper.hh"
+#include "Guardian.hh"
+
+namespace TREX {
+
+  bool TickTrace::s_enabled = false;
+
+  static size_t s_capacity = 0;
+
+  static unsigned long s_generation = 0;
+
+  static long long s_origin = 0;
+
+  /* Buffers are kept until the end of the process as the threads
+   * which created them may still refer to them. */
+  static std::vector<void *> s_buffers;
+
+  static Mutex s_buffersLock;
+
+  static pthread_key_t s_bufferKey;
+
+  static pthread_once_t s_bufferOnce = PTHREAD_ONCE_INIT;
+
+  static void writeString(std::ostream &out, char const *str) {
+    out<<'"';
+    for( ; '\0'!=*str; ++str ) {
+      if( '"'==*str || '\\'==*str )
+	out<<'\\';
+      out<<*str;
+    }
+    out<<'"';
+  }
+
+  void TickTrace::createKey() {
+    pthread_key_create(&s_bufferKey, NULL);
+  }
+
+  TickTrace::Buffer &TickTrace::buffer() {
+    pthread_once(&s_bufferOnce, createKey);
+    Buffer *result = static_cast<Buffer *>(pthread_getspecific(s_bufferKey));
+    if( NULL==result ) {
+      result = new Buffer();
+      result->generation = 0;
+      result->size = 0;
+      result->open = 0;
+      result->dropped = 0;
+      {
+	Guardian<Mutex> guard(s_buffersLock);
+	result->tid = s_buffers.size();
+	s_buffers.push_back(result);
+      }
+      pthread_setspecific(s_bufferKey, result);
+    }
+    return *result;
+  }
+
+  void TickTrace::enable(size_t capacity) {
+    Guardian<Mutex> guard(s_buffersLock);
+    s_capacity = capacity;
+    ++s_generation;
+    s_origin = ClockStat::now(ClockStat::monotonic);
+    s_enabled = capacity>0;
+  }
+
+  void TickTrace::disable() {
+    Guardian<Mutex> guard(s_buffersLock);
+    s_enabled = false;
+    for(std::vector<void *>::iterator it = s_buffers.begin(); it!=s_buffers.end(); ++it) {
+      Buffer *b = static_cast<Buffer *>(*it);
+      std::vector<Event>().swap(b->events);
+      b->size = 0;
+      b->open = 0;
+      b->generation = 0;
+    }
+  }
+
+  bool TickTrace::record(char phase, char const *name, char const *label, long long value) {
+    Buffer &b = buffer();
+
+    if( b.generation!=s_generation ) {
+      // First event of this thread in the trace
+      b.events.resize(s_capacity);
+      b.size = 0;
+      b.open = 0;
+      b.dropped = 0;
+      b.generation = s_generation;
+    }
+    // Room is kept for the end of the open phases
+    size_t needed = b.size+b.open+('B'==phase ? 2 : 1);
+    if( 'E'==phase ) {
+      if( 0==b.open )
+	return false;
+      --b.open;
+    } else if( needed>b.events.size() ) {
+      ++b.dropped;
+      return false;
+    } else if( 'B'==phase )
+      ++b.open;
+
+    Event &e = b.events[b.size];
+    e.phase = phase;
+    e.name = name;
+    e.label = label;
+    e.nsecs = ClockStat::now(ClockStat::monotonic);
+    e.value = value;
+    // The event must be complete before a reader can see it
+    __sync_synchronize();
+    b.size = b.size+1;
+    return true;
+  }
+
+  unsigned long TickTrace::dropped() {
+    Guardian<Mutex> guard(s_buffersLock);
+    unsigned long result = 0;
+    for(std::vector<void *>::const_iterator it = s_buffers.begin(); it!=s_buffers.end(); ++it) {
+      Buffer const *b = static_cast<Buffer const *>(*it);
+      if( b->generation==s_generation )
+	result += b->dropped;
+    }
+    return result;
+  }
+
+  void TickTrace::writeJson(std::ostream &out) {
+    Guardian<Mutex> guard(s_buffersLock);
+    long pid = getpid();
+    bool first = true;
+    char fill = out.fill('0');
+
+    out<<"{\"traceEvents\":[";
+    for(std::vector<void *>::const_iterator it = s_buffers.begin(); it!=s_buffers.end(); ++it) {
+      Buffer const *b = static_cast<Buffer const *>(*it);
+      if( b->generation!=s_generation )
+	continue;
+      size_t size = b->size;
+      __sync_synchronize();
+
+      out<<(first ? "\n" : ",\n")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"<<pid
+	 <<",\"tid\":"<<b->tid<<",\"args\":{\"name\":\"thread "<<b->tid<<"\"}}";
+      first = false;
+      for(size_t i=0; i<size; ++i) {
+	Event const &e = b->events[i];
+	long long usecs = (e.nsecs-s_origin)/1000;
+
+	out<<",\n{\"name\":";
+	writeString(out, e.name);
+	out<<",\"cat\":\"trex\",\"ph\":\""<<e.phase<<"\",\"ts\":"<<usecs<<'.'
+	   <<std::setw(3)<<(e.nsecs-s_origin)%1000
+	   <<",\"pid\":"<<pid<<",\"tid\":"<<b->tid;
+	if( 'C'==e.phase )
+	  out<<",\"args\":{\"value\":"<<e.value<<'}';
+	else if( NULL!=e.label ) {
+	  out<<",\"args\":{\"label\":";
+	  writeString(out, e.label);
+	  out<<'}';
+	}
+	out<<'}';
+      }
+    }
+    out<<"\n],\"displayTimeUnit\":\"ms\"}"<<std::endl;
+    out.fill(fill);
+  }
+
+}
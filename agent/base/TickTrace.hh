@@ -0,0 +1,196 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "TickTrace.hh"
+ * @brief Definition of the tick phase tracer
+ */
+#ifndef _TICKTRACE_HH
+#define _TICKTRACE_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace TREX {
+
+  /** @brief Begin/end events of the tick phases.
+   *
+   * Each thread records its events in its own buffer, allocated
+   * once per trace : recording takes no lock and does not call
+   * malloc. A full buffer drops the events that follow, keeping
+   * room for the end of the phases already begun. The
+   * buffers are written at the end of the mission in the Chrome
+   * trace event format, which can be loaded in chrome://tracing
+   * or Perfetto to see each tick as a timeline per thread.
+   *
+   * When the trace is not enabled recording costs a single test.
+   * The names and labels of the events are not copied : they must
+   * stay valid until the trace is written.
+   *
+   * @sa TickTraceScope
+   */
+  class TickTrace {
+  public:
+    /** @brief Test if the trace is enabled */
+    static bool enabled() {
+      return s_enabled;
+    }
+
+    /** @brief Start a new trace
+     *
+     * @param capacity Maximum number of events kept per thread
+     *
+     * Events of a previous trace are discarded.
+     *
+     * @pre No other thread is recording
+     */
+    static void enable(size_t capacity);
+    /** @brief Stop the trace
+     *
+     * Releases the buffers.
+     *
+     * @pre No other thread is recording
+     */
+    static void disable();
+
+    /** @brief Start of a phase
+     *
+     * @param name Name of the phase
+     * @param label Optional label, such as the reactor name
+     *
+     * @retval true The begin was recorded. The buffer keeps room
+     * for the end of the phase which must then be recorded with
+     * end().
+     * @retval false The trace is disabled or the buffer is full
+     */
+    static bool begin(char const *name, char const *label =NULL) {
+      return s_enabled && record('B', name, label, 0);
+    }
+    /** @brief End of a phase
+     *
+     * @param name Name of the phase
+     * @param label Optional label, such as the reactor name
+     *
+     * @pre The matching begin() returned true
+     */
+    static void end(char const *name, char const *label =NULL) {
+      if( s_enabled )
+	record('E', name, label, 0);
+    }
+    /** @brief Value of a counter
+     *
+     * @param name Name of the counter
+     * @param value New value
+     */
+    static void counter(char const *name, long long value) {
+      if( s_enabled )
+	record('C', name, NULL, value);
+    }
+
+    /** @brief Number of events dropped because a buffer was full */
+    static unsigned long dropped();
+
+    /** @brief Write the trace
+     *
+     * @param out An output stream
+     *
+     * Writes the events of all the threads as a Chrome trace
+     * event JSON document.
+     *
+     * @pre No other thread is recording
+     */
+    static void writeJson(std::ostream &out);
+
+  private:
+    struct Event {
+      char phase;
+      char const *name;
+      char const *label;
+      long long nsecs;
+      long long value;
+    };
+
+    struct Buffer {
+      unsigned int tid;
+      unsigned long generation; /*!< Trace the events belong to */
+      std::vector<Event> events;
+      volatile size_t size; /*!< Number of events complete */
+      size_t open; /*!< Number of phases begun and not ended */
+      unsigned long dropped;
+    };
+
+    static bool record(char phase, char const *name, char const *label, long long value);
+    static Buffer &buffer();
+
+    static void createKey();
+
+    static bool s_enabled;
+  }; // TREX::TickTrace
+
+  /** @brief Scoped TickTrace phase
+   *
+   * The phase begins with the construction of this instance and
+   * ends with its destruction.
+   *
+   * @code
+   * {
+   *   TickTraceScope trace("synchronize", getName().c_str());
+   *   synchronize();
+   * }
+   * @endcode
+   */
+  class TickTraceScope {
+  public:
+    TickTraceScope(char const *name, char const *label =NULL)
+      :m_name(name), m_label(label), m_active(TickTrace::begin(name, label)) {}
+    ~TickTraceScope() {
+      if( m_active )
+	TickTrace::end(m_name, m_label);
+    }
+
+  private:
+    TickTraceScope(TickTraceScope const &other);
+    void operator= (TickTraceScope const &other);
+
+    char const *m_name;
+    char const *m_label;
+    bool m_active; /*!< The end is recorded only if the begin was */
+  }; // TREX::TickTraceScope
+
+} // TREX
+
+#endif // _TICKTRACE_HH
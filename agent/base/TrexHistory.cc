@@ -0,0 +1,116 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Command line queries over a mission history file
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "MissionHistory.hh"
+
+using namespace TREX;
+
+static int usage(char const *cmd) {
+  fprintf(stderr,
+	  "Usage: %s <file> summary\n"
+	  "       %s <file> at <timeline> <tick>\n"
+	  "       %s <file> tick <tick>\n"
+	  "       %s <file> goal <key>\n"
+	  "       %s <file> goals <timeline> [<from> <to>]\n"
+	  "Query a mission history recorded with missionHistory=\"true\"\n",
+	  cmd, cmd, cmd, cmd, cmd);
+  return 1;
+}
+
+static void print(MissionHistoryReader::Event const &ev) {
+  char const *kind = MissionHistory::OBSERVATION==ev.kind ? "OBSERVE" :
+    (MissionHistory::DISPATCH==ev.kind ? "DISPATCH" : "RECALL");
+
+  if( 0==ev.key )
+    printf("[%u] %s %s.%s {%s}\n", ev.tick, kind, ev.timeline, ev.predicate, ev.text);
+  else
+    printf("[%u] %s %s.%s key=%u {%s}\n", ev.tick, kind, ev.timeline, ev.predicate, ev.key, ev.text);
+}
+
+static void print(std::vector<MissionHistoryReader::Event> const &events) {
+  for(std::vector<MissionHistoryReader::Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+    print(*it);
+}
+
+int main(int argc, char **argv) {
+  if( argc<3 )
+    return usage(argv[0]);
+
+  try {
+    MissionHistoryReader history(argv[1]);
+    std::string cmd(argv[2]);
+    std::vector<MissionHistoryReader::Event> events;
+    TICK const last = ~static_cast<TICK>(0);
+
+    if( "summary"==cmd && 3==argc ) {
+      printf("%llu rows, %u ticks, %u segments, %lu bytes\n", (unsigned long long)history.rows(),
+	     history.ticks(), history.segments(), (unsigned long)history.size());
+      if( 0<history.ticks() )
+	printf("ticks %u to %u\n", history.firstTick(), history.lastTick());
+    } else if( "at"==cmd && 5==argc ) {
+      MissionHistoryReader::Event ev;
+      if( !history.valueAt(argv[3], strtoul(argv[4], NULL, 10), ev) ) {
+	printf("No observation on %s at tick %s\n", argv[3], argv[4]);
+	return 2;
+      }
+      print(ev);
+    } else if( "tick"==cmd && 4==argc ) {
+      TICK tick = strtoul(argv[3], NULL, 10);
+      history.select(tick, tick, "OGC", NULL, 0, events);
+      print(events);
+    } else if( "goal"==cmd && 4==argc ) {
+      history.select(0, last, "GC", NULL, strtoul(argv[3], NULL, 10), events);
+      print(events);
+    } else if( "goals"==cmd && (4==argc || 6==argc) ) {
+      TICK from = 4==argc ? 0 : strtoul(argv[4], NULL, 10);
+      TICK to = 4==argc ? last : strtoul(argv[5], NULL, 10);
+      history.select(from, to, "GC", argv[3], 0, events);
+      print(events);
+    } else
+      return usage(argv[0]);
+  } catch(std::exception const &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
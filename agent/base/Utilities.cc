@@ -45,6 +45,7 @@
 #include "Token.hh"
 #include "TokenVariable.hh"
 #include <fstream>
+#include <map>
 
 using namespace EUROPA;
 
@@ -125,9 +126,10 @@ namespace TREX {
     // PseudoClock uses a sleep duration of 0.0 seconds. This causes the system to run faster for testing
     // and thus it will utilize as much CPU time as is available.
     PseudoClock clock(1.0, stepsPerTick);
-    TiXmlElement* root = initXml( findFile(configFile).c_str() );
+    const std::string configPath = findFile(configFile);
+    const TiXmlElement& root = LogManager::acquireXml(configPath);
 
-    Agent::initialize(*root, clock, 0, true);
+    Agent::initialize(root, clock, 0, true);
 
     LogManager::instance().handleInit();
 
@@ -143,12 +145,13 @@ namespace TREX {
 
     Agent::reset();
   
-    delete root;
+    LogManager::releaseXml(configPath);
   };
 
   bool validateResults(const char* problemName){
-    std::vector<Agent::Event> eventLog = Agent::instance()->getEventLog();
-    std::string eventLogStr = Agent::toString(eventLog);
+    std::stringstream ss;
+    Agent::write(ss, Agent::instance()->getEventLog());
+    std::string eventLogStr = ss.str();
 
     if(!hasValidFile(problemName)){
       makeValidFile(eventLogStr, problemName);
@@ -215,9 +218,23 @@ namespace TREX {
 
   std::string findFile(const std::string& fileName, bool forceRebuild){
     static std::vector<std::string> sl_locations;
-    if (forceRebuild) { 
+    // Resolved names, and the environment they were resolved for
+    static std::map<std::string, std::string> sl_resolved;
+    static std::string sl_env;
+
+    const char * trexPath = getenv("TREX_PATH");
+    const char * startDir = getenv("TREX_START_DIR");
+    std::string env = std::string(trexPath != NULL ? trexPath : "") + "\n" + (startDir != NULL ? startDir : "");
+    if (forceRebuild || env != sl_env) { 
       sl_locations.clear(); 
+      sl_resolved.clear();
+      sl_env = env;
     }
+
+    std::map<std::string, std::string>::const_iterator cached = sl_resolved.find(fileName);
+    if(cached != sl_resolved.end())
+      return cached->second;
+
     if(sl_locations.empty()){
       sl_locations.push_back("./");
 
@@ -246,6 +263,7 @@ namespace TREX {
 	std::ifstream f(qualifiedFileName.c_str());
 	if(f.good()) {
 	  f.close();
+	  sl_resolved[fileName] = qualifiedFileName;
 	  return qualifiedFileName;
 	}
 	
@@ -297,10 +315,12 @@ namespace TREX {
       std::ifstream f(qualifiedFileName.c_str());
       if(f.good()) {
 	f.close();
+	sl_resolved[fileName] = qualifiedFileName;
 	return qualifiedFileName;
       }
     }
 
+    // Not cached so that a file created later on is still found
     return fileName;
   }
 
@@ -85,6 +85,9 @@ namespace TREX {
 
   /**
    * @brief Obatin the fully qualified path name for the given file by searching the local directory and then the path
+   *
+   * Found files are remembered, so only the first lookup of a name touches the file system. The cache is dropped when
+   * TREX_PATH or TREX_START_DIR change, or when @e forceRebuild is set.
    */
   std::string findFile(const std::string& fileName, bool forceRebuild = false);
 
@@ -0,0 +1,158 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "WorkerPool.cc"
+ */
+#include "WorkerPool.hh"
+#include "Guardian.hh"
+
+namespace TREX {
+
+  /** @brief Worker thread.
+   *
+   * This class is the thread running the WorkerPool main loop.
+   */
+  class WorkerPool::Worker :public Thread {
+  public:
+    /** @brief Constructor
+     *
+     * @param pool The pool this worker belongs to
+     */
+    Worker(WorkerPool &pool)
+      :m_pool(pool) {}
+    /** @brief Destructor */
+    ~Worker() {}
+
+  private:
+    void *run() {
+      m_pool.work();
+      return NULL;
+    }
+
+    WorkerPool &m_pool;
+  }; // TREX::WorkerPool::Worker
+
+} // TREX
+
+using namespace TREX;
+
+/*
+ * class WorkerPool
+ */
+// Structors :
+
+WorkerPool::WorkerPool(size_t size, Thread::Scheduling const &sched)
+  :m_batch(NULL), m_next(0), m_running(0), m_stop(false), m_failed(false) {
+  for(size_t i=1; i<size; ++i) {
+    Worker *w = new Worker(*this);
+    m_workers.push_back(w);
+    if( !sched.isDefault() )
+      w->setScheduling(sched);
+    w->start();
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    Guardian<Mutex> guard(m_lock);
+    m_stop = true;
+    m_newBatch.broadcast();
+  }
+  for(std::vector<Worker *>::iterator i=m_workers.begin();
+      m_workers.end()!=i; ++i) {
+    (*i)->join();
+    delete *i;
+  }
+}
+
+// Manipulators :
+
+void WorkerPool::execute(std::vector<WorkerPool::Job *> const &batch) {
+  Guardian<Mutex> guard(m_lock);
+
+  m_batch = &batch;
+  m_next = 0;
+  m_failed = false;
+  m_error.clear();
+  m_newBatch.broadcast();
+  // The caller works too
+  drain();
+  // Barrier : wait for the jobs still executed by the workers
+  while( m_running>0 )
+    m_batchDone.wait(m_lock);
+  m_batch = NULL;
+  if( m_failed )
+    throw std::runtime_error(m_error);
+}
+
+void WorkerPool::work() {
+  Guardian<Mutex> guard(m_lock);
+
+  while( !m_stop ) {
+    if( hasJob() )
+      drain();
+    else
+      m_newBatch.wait(m_lock);
+  }
+}
+
+void WorkerPool::drain() {
+  while( hasJob() ) {
+    Job *job = (*m_batch)[m_next++];
+    std::string error;
+    bool failed = false;
+
+    ++m_running;
+    m_lock.unlock();
+    try {
+      job->execute();
+    } catch(std::exception const &e) {
+      failed = true;
+      error = e.what();
+    } catch(...) {
+      failed = true;
+      error = "WorkerPool : unknown exception in job";
+    }
+    m_lock.lock();
+    if( failed && !m_failed ) {
+      m_failed = true;
+      m_error = error;
+    }
+    if( 0==--m_running && !hasJob() )
+      m_batchDone.broadcast();
+  }
+}
@@ -0,0 +1,175 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "WorkerPool.hh"
+ * @brief Definition of the WorkerPool class
+ */
+#ifndef _WORKERPOOL_HH
+#define _WORKERPOOL_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <vector>
+
+#include "Thread.hh"
+#include "Condition.hh"
+
+namespace TREX {
+
+  /** @brief Fixed size pool of worker threads.
+   *
+   * This class maintains a set of threads which execute batches of
+   * jobs. A call to execute() dispatches all the jobs of a batch to
+   * the workers and returns only when all of them are completed. It
+   * can therefore be used as a barrier between successive batches.
+   *
+   * The calling thread takes part in the execution of the batch. As
+   * a consequence a pool of size 1 has no extra thread and executes
+   * everything in the caller.
+   */
+  class WorkerPool {
+  public:
+    /** @brief Unit of work
+     *
+     * This abstract class is the interface for the jobs executed by
+     * a WorkerPool.
+     */
+    class Job {
+    public:
+      /** @brief Destructor */
+      virtual ~Job() {}
+      /** @brief Job main code
+       *
+       * This method is called by one of the threads of the pool. An
+       * exception thrown by this method is reported by
+       * WorkerPool::execute().
+       */
+      virtual void execute() =0;
+    }; // TREX::WorkerPool::Job
+
+    // Structors :
+    /** @brief Constructor
+     *
+     * @param size Number of threads executing the jobs including the
+     * caller of execute()
+     * @param sched Scheduling of the worker threads
+     *
+     * @throw ErrnoExcept error while creating the worker threads
+     */
+    explicit WorkerPool(size_t size, Thread::Scheduling const &sched =Thread::Scheduling());
+    /** @brief Destructor
+     *
+     * Terminates and joins all the worker threads.
+     */
+    ~WorkerPool();
+
+    // Manipulators :
+    /** @brief Execute a batch of jobs
+     *
+     * @param batch The jobs to execute
+     *
+     * Dispatches all the jobs of @e batch to the pool and waits for
+     * their completion.
+     *
+     * @post all the jobs of @e batch are completed
+     *
+     * @throw std::runtime_error at least one job failed. The message
+     * is the one of the first failure.
+     */
+    void execute(std::vector<Job *> const &batch);
+
+    // Observers :
+    /** @brief Number of threads
+     *
+     * @return the number of threads executing jobs, including the caller
+     */
+    size_t size() const {
+      return m_workers.size()+1;
+    }
+
+  private:
+    class Worker;
+
+    /** @brief Main loop of the worker threads */
+    void work();
+    /** @brief Execute pending jobs
+     *
+     * Executes the jobs of the current batch until none is left.
+     *
+     * @pre m_lock is locked
+     * @post m_lock is locked
+     */
+    void drain();
+    /** @brief Check for pending jobs
+     *
+     * @retval true if the current batch has jobs not started yet
+     * @retval false else
+     */
+    bool hasJob() const {
+      return NULL!=m_batch && m_next<m_batch->size();
+    }
+
+    /** @brief Lock for all the attributes below */
+    Mutex m_lock;
+    /** @brief Signaled when a new batch is available */
+    Condition m_newBatch;
+    /** @brief Signaled when the last job of a batch completes */
+    Condition m_batchDone;
+
+    /** @brief The batch being executed */
+    std::vector<Job *> const *m_batch;
+    /** @brief Index of the next job to start in @c m_batch */
+    size_t m_next;
+    /** @brief Number of jobs started and not completed yet */
+    size_t m_running;
+    /** @brief Set on destruction to stop the workers */
+    bool m_stop;
+    /** @brief Message of the first failure in the current batch */
+    std::string m_error;
+    /** @brief Set if a job of the current batch failed */
+    bool m_failed;
+
+    std::vector<Worker *> m_workers;
+
+    // Following functions are not implemented in purpose
+    WorkerPool(WorkerPool const &);
+    void operator= (WorkerPool const &);
+
+    friend class Worker;
+  }; // TREX::WorkerPool
+
+} // TREX
+
+#endif // _WORKERPOOL_HH
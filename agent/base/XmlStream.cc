@@ -0,0 +1,384 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "XmlStream.cc"
+ */
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+#include "XmlStream.hh"
+#include "Utilities.hh"
+
+using namespace TREX;
+
+namespace {
+
+  void appendUtf8(std::string &str, unsigned long code) {
+    if( code<0x80 )
+      str += static_cast<char>(code);
+    else if( code<0x800 ) {
+      str += static_cast<char>(0xC0|(code>>6));
+      str += static_cast<char>(0x80|(code&0x3F));
+    } else if( code<0x10000 ) {
+      str += static_cast<char>(0xE0|(code>>12));
+      str += static_cast<char>(0x80|((code>>6)&0x3F));
+      str += static_cast<char>(0x80|(code&0x3F));
+    } else {
+      str += static_cast<char>(0xF0|(code>>18));
+      str += static_cast<char>(0x80|((code>>12)&0x3F));
+      str += static_cast<char>(0x80|((code>>6)&0x3F));
+      str += static_cast<char>(0x80|(code&0x3F));
+    }
+  }
+
+}
+
+/*
+ * class TREX::XmlStreamReader
+ */
+
+// Structors :
+
+XmlStreamReader::XmlStreamReader(std::string const &fileName, Handler &handler)
+  :m_fileName(fileName), m_handler(handler), m_file(fopen(fileName.c_str(), "rb")),
+   m_buffer(65536), m_pos(0), m_end(0), m_line(1), m_suspended(false) {
+  ConfigurationException::configurationCheckError(NULL!=m_file, "Unable to open \""+fileName+'\"');
+}
+
+XmlStreamReader::~XmlStreamReader() {
+  if( NULL!=m_file )
+    fclose(m_file);
+}
+
+// Manipulators :
+
+bool XmlStreamReader::parse() {
+  m_suspended = false;
+  while( !m_suspended ) {
+    int c;
+
+    // The text between the tags is not reported
+    while( EOF!=(c=get()) && '<'!=c );
+    if( EOF==c ) {
+      if( !m_open.empty() )
+	fail("unexpected end of file in <"+m_open.back()+">");
+      return false;
+    }
+    readTag();
+  }
+  return true;
+}
+
+void XmlStreamReader::readTag() {
+  int c = peek();
+
+  if( '?'==c ) {
+    skipUntil("?>");
+    return;
+  }
+  if( '!'==c ) {
+    get();
+    skipDeclaration();
+    return;
+  }
+  if( '/'==c ) {
+    get();
+    std::string name = readName();
+    skipSpaces();
+    expect('>');
+    if( m_open.empty() || m_open.back()!=name )
+      fail("unexpected </"+name+">");
+    m_open.pop_back();
+    m_handler.endElement(name, m_open.size());
+    return;
+  }
+
+  std::string name = readName();
+  m_attrs.clear();
+  for(;;) {
+    skipSpaces();
+    c = peek();
+    if( '>'==c ) {
+      get();
+      m_handler.startElement(name, m_attrs, m_open.size());
+      m_open.push_back(name);
+      return;
+    }
+    if( '/'==c ) {
+      get();
+      expect('>');
+      m_handler.startElement(name, m_attrs, m_open.size());
+      m_handler.endElement(name, m_open.size());
+      return;
+    }
+    std::string attr = readName();
+    skipSpaces();
+    expect('=');
+    skipSpaces();
+    m_attrs.push_back(std::make_pair(attr, readValue()));
+  }
+}
+
+void XmlStreamReader::skipDeclaration() {
+  if( '-'==peek() ) {
+    get();
+    expect('-');
+    skipUntil("-->");
+    return;
+  }
+  if( '['==peek() ) {
+    skipUntil("]]>");
+    return;
+  }
+  // Document type declaration, possibly with an internal subset
+  int c, depth = 0;
+  while( EOF!=(c=get()) ) {
+    if( '['==c )
+      ++depth;
+    else if( ']'==c )
+      --depth;
+    else if( '>'==c && depth<=0 )
+      return;
+  }
+  fail("unexpected end of file in a declaration");
+}
+
+std::string XmlStreamReader::readName() {
+  std::string name;
+  int c;
+
+  while( EOF!=(c=peek()) && !isspace(c) && '>'!=c && '/'!=c && '='!=c ) {
+    name += static_cast<char>(c);
+    get();
+  }
+  if( name.empty() )
+    fail("expected a name");
+  return name;
+}
+
+std::string XmlStreamReader::readValue() {
+  int quote = get(), c;
+  std::string value;
+
+  if( '\"'!=quote && '\''!=quote )
+    fail("expected a quoted value");
+  while( quote!=(c=get()) ) {
+    if( EOF==c )
+      fail("unexpected end of file in a value");
+    if( '&'!=c ) {
+      value += static_cast<char>(c);
+      continue;
+    }
+    std::string ref;
+    while( ';'!=(c=get()) ) {
+      if( EOF==c || ref.size()>10 )
+	fail("unterminated reference &"+ref);
+      ref += static_cast<char>(c);
+    }
+    if( "lt"==ref )
+      value += '<';
+    else if( "gt"==ref )
+      value += '>';
+    else if( "amp"==ref )
+      value += '&';
+    else if( "quot"==ref )
+      value += '\"';
+    else if( "apos"==ref )
+      value += '\'';
+    else if( ref.size()>1 && '#'==ref[0] ) {
+      bool hex = ('x'==ref[1] || 'X'==ref[1]);
+      appendUtf8(value, strtoul(ref.c_str()+(hex ? 2 : 1), NULL, hex ? 16 : 10));
+    } else
+      fail("unknown reference &"+ref+";");
+  }
+  return value;
+}
+
+void XmlStreamReader::skipUntil(char const *end) {
+  std::string const target(end);
+  std::string window;
+
+  while( window!=target ) {
+    int c = get();
+    if( EOF==c )
+      fail("unexpected end of file, expected \""+target+'\"');
+    window += static_cast<char>(c);
+    if( window.size()>target.size() )
+      window.erase(0, 1);
+  }
+}
+
+void XmlStreamReader::skipSpaces() {
+  while( EOF!=peek() && isspace(peek()) )
+    get();
+}
+
+void XmlStreamReader::expect(char c) {
+  if( c!=get() )
+    fail(std::string("expected '")+c+'\'');
+}
+
+int XmlStreamReader::peek() {
+  if( m_pos==m_end ) {
+    m_pos = 0;
+    m_end = fread(&m_buffer[0], 1, m_buffer.size(), m_file);
+    if( 0==m_end )
+      return EOF;
+  }
+  return static_cast<unsigned char>(m_buffer[m_pos]);
+}
+
+int XmlStreamReader::get() {
+  int c = peek();
+
+  if( EOF!=c ) {
+    ++m_pos;
+    if( '\n'==c )
+      ++m_line;
+  }
+  return c;
+}
+
+void XmlStreamReader::fail(std::string const &what) const {
+  std::ostringstream oss;
+
+  oss<<m_fileName<<':'<<m_line<<": "<<what;
+  ConfigurationException::configurationCheckError(false, oss.str());
+}
+
+/*
+ * class TREX::XmlObservationReader
+ */
+
+// Structors :
+
+XmlObservationReader::XmlObservationReader(std::string const &fileName, std::set<LabelStr> const &timelines)
+  :m_parser(fileName, *this), m_timelines(timelines), m_tick(0), m_inTick(false), m_skipping(false),
+   m_ready(false) {}
+
+XmlObservationReader::~XmlObservationReader() {
+  for(std::vector<TiXmlElement *>::iterator i=m_observations.begin(); m_observations.end()!=i; ++i)
+    delete *i;
+  // The elements of an incomplete observation are owned by their root
+  if( !m_open.empty() )
+    delete m_open.front();
+}
+
+// Manipulators :
+
+bool XmlObservationReader::peek(TICK &tick) {
+  while( !m_ready && m_parser.parse() );
+  if( !m_ready )
+    return false;
+  tick = m_tick;
+  return true;
+}
+
+void XmlObservationReader::next(std::vector<TiXmlElement *> &observations) {
+  checkError(m_ready, "XmlObservationReader: no tick to read.");
+  observations.insert(observations.end(), m_observations.begin(), m_observations.end());
+  m_observations.clear();
+  m_ready = false;
+}
+
+void XmlObservationReader::startElement(std::string const &name, XmlStreamReader::Attributes const &attrs,
+					unsigned int depth) {
+  if( 1==depth ) {
+    if( "Tick"==name ) {
+      char const *value = NULL;
+      for(XmlStreamReader::Attributes::const_iterator i=attrs.begin(); attrs.end()!=i; ++i)
+	if( "value"==i->first )
+	  value = i->second.c_str();
+      if( NULL==value ) {
+	std::ostringstream oss;
+	oss<<"XmlObservationReader: Tick line "<<m_parser.line()<<" has no value.";
+	ConfigurationException::configurationCheckError(false, oss.str());
+      }
+      m_tick = strtol(value, NULL, 0);
+      m_inTick = true;
+    }
+    return;
+  }
+  if( !m_inTick || m_skipping )
+    return;
+
+  if( 2==depth ) {
+    // Each element of a tick is an observation
+    LabelStr timeline = "";
+    for(XmlStreamReader::Attributes::const_iterator i=attrs.begin(); attrs.end()!=i; ++i)
+      if( "on"==i->first )
+	timeline = i->second;
+    if( m_timelines.find(timeline)==m_timelines.end() ) {
+      m_skipping = true;
+      return;
+    }
+  }
+
+  TiXmlElement *elem = new TiXmlElement(name.c_str());
+  for(XmlStreamReader::Attributes::const_iterator i=attrs.begin(); attrs.end()!=i; ++i)
+    elem->SetAttribute(i->first.c_str(), i->second.c_str());
+  if( !m_open.empty() )
+    m_open.back()->LinkEndChild(elem);
+  m_open.push_back(elem);
+}
+
+void XmlObservationReader::endElement(std::string const &name, unsigned int depth) {
+  if( 1==depth ) {
+    if( m_inTick && "Tick"==name ) {
+      m_inTick = false;
+      // Only stop on ticks with something to play
+      if( !m_observations.empty() ) {
+	m_ready = true;
+	m_parser.suspend();
+      }
+    }
+    return;
+  }
+  if( !m_inTick )
+    return;
+  if( m_skipping ) {
+    if( 2==depth )
+      m_skipping = false;
+    return;
+  }
+
+  TiXmlElement *elem = m_open.back();
+  m_open.pop_back();
+  if( m_open.empty() )
+    m_observations.push_back(elem);
+}
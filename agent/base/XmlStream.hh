@@ -0,0 +1,231 @@
+/* -*- C++ -*-
+ * $Id$
+ */
+/** @file "XmlStream.hh"
+ * @brief Definition of the streaming XML readers
+ */
+#ifndef _XMLSTREAM_HH
+#define _XMLSTREAM_HH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "TREXDefs.hh"
+#include "XMLUtils.hh"
+
+namespace TREX {
+
+  /** @brief Event driven XML reader.
+   *
+   * This class parses an XML file as it reads it and reports each
+   * element to a Handler, without building the document. Memory
+   * use only depends on the depth of the document and the size of
+   * its tags.
+   *
+   * The handler can suspend the parsing from one of its callbacks :
+   * parse() then returns right after this event, and the next call
+   * resumes from there. This is how a client reads a large file
+   * piece by piece.
+   *
+   * Text content, comments, processing instructions, CDATA sections
+   * and document type declarations are skipped. The predefined and
+   * numeric character references of attribute values are decoded.
+   *
+   * @sa XmlObservationReader
+   */
+  class XmlStreamReader {
+  public:
+    /** @brief Attributes of an element, in document order */
+    typedef std::vector< std::pair<std::string, std::string> > Attributes;
+
+    /** @brief Receiver of the parsing events */
+    class Handler {
+    public:
+      virtual ~Handler() {}
+
+      /** @brief Start of an element
+       *
+       * @param name Tag of the element
+       * @param attrs Its attributes
+       * @param depth Number of enclosing elements
+       */
+      virtual void startElement(std::string const &name, Attributes const &attrs, unsigned int depth) = 0;
+      /** @brief End of an element
+       *
+       * @param name Tag of the element
+       * @param depth Number of enclosing elements
+       *
+       * An empty element tag is reported as a start followed by an end.
+       */
+      virtual void endElement(std::string const &name, unsigned int depth) = 0;
+    };
+
+    /** @brief Constructor
+     *
+     * @param fileName Name of the file to parse
+     * @param handler Receiver of the events
+     *
+     * @throw ConfigurationException the file cannot be opened
+     */
+    XmlStreamReader(std::string const &fileName, Handler &handler);
+    /** @brief Destructor
+     *
+     * Close the file
+     */
+    ~XmlStreamReader();
+
+    /** @brief Parse the file
+     *
+     * Report the events to the handler until it calls suspend() or
+     * the end of the file is reached.
+     *
+     * @retval true The parsing was suspended
+     * @retval false The end of the file was reached
+     *
+     * @throw ConfigurationException the file is not well formed
+     */
+    bool parse();
+    /** @brief Suspend the parsing
+     *
+     * Called by the handler to make parse() return after the current
+     * event.
+     */
+    void suspend() {
+      m_suspended = true;
+    }
+
+    /** @brief Current line, for error messages */
+    unsigned int line() const {
+      return m_line;
+    }
+
+  private:
+    XmlStreamReader(XmlStreamReader const &other);
+    void operator= (XmlStreamReader const &other);
+
+    int get();
+    int peek();
+    void expect(char c);
+    void skipSpaces();
+    void skipUntil(char const *end);
+    void skipDeclaration();
+    std::string readName();
+    std::string readValue();
+    void readTag();
+    void fail(std::string const &what) const;
+
+    std::string const m_fileName;
+    Handler &m_handler;
+    FILE *m_file;
+    std::vector<char> m_buffer;
+    size_t m_pos, m_end; //!< Part of m_buffer to read
+    unsigned int m_line;
+    bool m_suspended;
+    std::vector<std::string> m_open; //!< Tags of the enclosing elements
+    Attributes m_attrs; //!< Attributes of the current tag
+  }; // TREX::XmlStreamReader
+
+  /** @brief Lazy reader of an XML observation log.
+   *
+   * Reads the Log/Tick/Observation files produced by
+   * ObservationLogger one tick at a time. Only the observations of
+   * the tick being read are in memory, each one as a small XML tree
+   * identical to the one of the whole document. The observations on
+   * the timelines which are not read are skipped as they are parsed.
+   *
+   * @pre The Tick elements are in increasing order, as written by
+   * ObservationLogger.
+   *
+   * @sa BinaryObservationReader
+   */
+  class XmlObservationReader :private XmlStreamReader::Handler {
+  public:
+    /** @brief Constructor
+     *
+     * @param fileName Name of the log file
+     * @param timelines The timelines to read
+     *
+     * Nothing is parsed until the first call to peek().
+     *
+     * @throw ConfigurationException the file cannot be opened
+     */
+    XmlObservationReader(std::string const &fileName, std::set<LabelStr> const &timelines);
+    ~XmlObservationReader();
+
+    /** @brief Next tick of the log
+     *
+     * @param[out] tick The value of the next tick with observations
+     *
+     * Reads the log up to the end of this tick the first time. The
+     * ticks without any observation on the timelines read are
+     * skipped.
+     *
+     * @retval true @e tick was set
+     * @retval false The end of the log was reached
+     *
+     * @throw ConfigurationException the log is not well formed or a
+     * Tick has no value
+     */
+    bool peek(TICK &tick);
+    /** @brief Get the observations of the next tick
+     *
+     * @param[out] observations Where the Observation elements of the
+     * tick are appended. The caller owns them.
+     *
+     * @pre peek() returned true since the last call
+     */
+    void next(std::vector<TiXmlElement *> &observations);
+
+  private:
+    void startElement(std::string const &name, XmlStreamReader::Attributes const &attrs, unsigned int depth);
+    void endElement(std::string const &name, unsigned int depth);
+
+    XmlStreamReader m_parser;
+    std::set<LabelStr> const m_timelines;
+    TICK m_tick;
+    bool m_inTick; //!< Parsing a Tick element
+    bool m_skipping; //!< Parsing an observation which is not read
+    bool m_ready; //!< The current tick has been read
+    std::vector<TiXmlElement *> m_observations; //!< Observations of the current tick
+    std::vector<TiXmlElement *> m_open; //!< Elements of the observation being read
+  }; // TREX::XmlObservationReader
+
+} // TREX
+
+#endif // _XMLSTREAM_HH
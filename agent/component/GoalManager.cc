@@ -41,12 +41,19 @@
 #include "Timeline.hh"
 #include "Agent.hh"
 #include "GoalManager.hh"
+#include "ComponentFactory.hh"
+#include "Utilities.hh"
+#include "WorkerPool.hh"
 
 
 #include <math.h>
+#include <fstream>
+#include <algorithm>
 
 namespace TREX{
 
+  static const int MAX_PRIORITY = 5;
+
   bool isPositionDependentGoal(const EntityId& entity){
     checkError(TokenId::convertable(entity), "Invalid configuration for " << entity->toString());
 
@@ -89,7 +96,15 @@ namespace TREX{
       m_maxIterations(1000),
       m_plateau(5),
       m_positionSourceCfg(""),
-      m_state(STATE_DONE) {
+      m_costEstimatorCfg(new TiXmlElement(configData)),
+      m_state(STATE_DONE),
+      m_nextTokenKey(0),
+      m_restarts(0),
+      m_searchPool(NULL),
+      m_movesPerStep(0),
+      m_exploring(false),
+      m_goalProblem(*this),
+      m_cachedPath(m_goalProblem) {
 
     // Set the robot's initial position to be the origin.
     m_position.x = 0;
@@ -113,6 +128,15 @@ namespace TREX{
     const char * positionSrc = configData.Attribute(CFG_POSITION_SOURCE().c_str());
     if(positionSrc != NULL)
       m_positionSourceCfg = LabelStr(positionSrc);
+
+    // MOVES PER STEP
+    const char * movesPerStep = configData.Attribute(CFG_MOVES_PER_STEP().c_str());
+    if(movesPerStep != NULL)
+      m_movesPerStep = atoi(movesPerStep);
+
+    // COST ESTIMATOR. It is configured from the attributes of the goal manager.
+    const char * costEstimator = configData.Attribute(CFG_COST_ESTIMATOR().c_str());
+    m_costEstimatorCfg->SetAttribute("component", costEstimator != NULL ? costEstimator : "EuclideanCostEstimator");
   }
 
   void GoalManager::step() {
@@ -132,16 +156,28 @@ namespace TREX{
       return;
     }
 
-    setState(STATE_PLANNING);
-    if(m_iteration < m_maxIterations && m_watchDog < m_plateau) {    
-      // Update counters to handle termination
-      m_iteration++;
-      m_watchDog++;
-      
+    if(m_restarts > 0){
+      // The searches are completed at once
+      multiStartSearch();
+      setState(STATE_DONE);
+    } else if(m_iteration < m_maxIterations && m_watchDog < m_plateau) {    
+      setState(STATE_PLANNING);
+
+      if(!m_exploring){
+	// Update counters to handle termination
+	m_iteration++;
+	m_watchDog++;
+	startNeighborhood();
+      }
+
+      // Resume on the next step if the budget of moves is exhausted. The current solution is unchanged.
+      if(!exploreNeighborhood(m_movesPerStep))
+	return;
+
       // Get best neighbor
       TokenId delta;
       GoalManager::SOLUTION candidate;
-      selectNeighbor(candidate, delta);
+      int result = selectNeighbor(candidate, delta);
       
       // In the event that the candidate is the same solution, we have hit the end of exploration unless
       // we escape somehow. The algorithm does not include such random walks to explore beyond the immediate
@@ -150,7 +186,6 @@ namespace TREX{
 	setState(STATE_DONE);
       } else {
 	// Promote if not worse. Allos for some exploration
-	int result = compare(candidate, m_currentSolution);
 	if(result >= 0) {
 	  // If a token was removed, insert into ommitted token list, and opposite if appended
 	  if(m_currentSolution.size() > candidate.size())
@@ -190,6 +225,9 @@ namespace TREX{
   void GoalManager::reset(){
     m_currentSolution.clear();
     m_ommissions.clear();
+    m_precedences.clear();
+    m_exploring = false;
+    updateNextToken();
 
     // If there are any constraints, deactivate them and delete them
     for(std::vector< std::pair<int, ConstraintId> >::const_iterator it = m_constraints.begin(); it != m_constraints.end(); ++it){
@@ -206,19 +244,45 @@ namespace TREX{
   }
 
   bool GoalManager::isNextToken(TokenId token) {
-    if (!noMoreFlaws()) {
-      return false;
-    }
+    return noMoreFlaws() && m_nextToken == token;
+  }
+
+  bool GoalManager::isNextGoal(const TokenId& token) {
+    return nextTokens().find(token->getKey()) != nextTokens().end();
+  }
+
+  std::multiset<int>& GoalManager::nextTokens() {
+    static std::multiset<int> sl_nextTokens;
+    return sl_nextTokens;
+  }
+
+  /**
+   * @brief Tokens leave the current solution through removeFlaw when activated. So the next token
+   * only changes with the state or the current solution, and can be cached.
+   */
+  void GoalManager::updateNextToken() {
     TokenId nextGoal = TokenId::noId();
-    for(SOLUTION::const_iterator it = m_currentSolution.begin(); it != m_currentSolution.end(); ++it){
-      TokenId t = *it;
-      checkError(t.isValid(), "A token that has been deleted is in the solution.");
-      if (t->isInactive()){
-	nextGoal = t;
-	break;
+    if (noMoreFlaws()) {
+      for(SOLUTION::const_iterator it = m_currentSolution.begin(); it != m_currentSolution.end(); ++it){
+	TokenId t = *it;
+	checkError(t.isValid(), "A token that has been deleted is in the solution.");
+	if (t->isInactive()){
+	  nextGoal = t;
+	  break;
+	}
       }
     }
-    return (nextGoal == token);
+
+    if(nextGoal == m_nextToken)
+      return;
+
+    if(m_nextToken.isId())
+      nextTokens().erase(nextTokens().find(m_nextTokenKey));
+    m_nextToken = nextGoal;
+    if(m_nextToken.isId()){
+      m_nextTokenKey = m_nextToken->getKey();
+      nextTokens().insert(m_nextTokenKey);
+    }
   }
 
   /**
@@ -259,6 +323,10 @@ namespace TREX{
 
     // Clear from ommittedTokens
     m_ommissions.erase(token);
+    updateNextToken();
+
+    // The neighborhood being explored may refer to the token
+    m_exploring = false;
   }
 
   void GoalManager::handleInitialize(){
@@ -271,6 +339,15 @@ namespace TREX{
       checkError(m_positionSource.isValid(), 
 		 "No position source for GoalManager. See Goal Manager Configuration in solver to set the source for getting position data.");
     }
+
+    if(m_costEstimatorCfg != NULL){
+      ComponentFactoryMgr* cfm = (ComponentFactoryMgr*)getPlanDatabase()->getEngine()->getComponent("ComponentFactoryMgr");
+      m_costEstimator = cfm->createInstance(*m_costEstimatorCfg);
+      ConfigurationException::configurationCheckError(m_costEstimator.isValid(),
+						       std::string(m_costEstimatorCfg->Attribute("component")) + " is not a CostEstimator.");
+      delete m_costEstimatorCfg;
+      m_costEstimatorCfg = NULL;
+    }
   }
 
   /**
@@ -281,16 +358,25 @@ namespace TREX{
 
     // Set the initial conditions since the problem may have moved on
     setInitialConditions();
+    m_precedences.clear();
+    m_exploring = false;
 
     // The empty solution is the default solution
     IteratorId it = OpenConditionManager::createIterator();
-    std::map<double, TokenId> sorted_by_distance;
+    std::vector<TokenId> goals;
     while(!it->done()){
       TokenId goal = (TokenId) it->next();
       checkError(goal->master().isNoId(), goal->toString());
-      Position p = getPosition(goal);
-      double distance_to_goal = computeDistance(m_position, p);
-      sorted_by_distance.insert(std::pair<double, TokenId>(distance_to_goal, goal));
+      goals.push_back(goal);
+    }
+
+    // All distances of the planning cycle are computed at once
+    updateDistances(goals);
+
+    std::map<double, TokenId> sorted_by_distance;
+    for(std::vector<TokenId>::const_iterator it = goals.begin(); it != goals.end(); ++it){
+      double distance_to_goal = distance(0, indexOf(*it));
+      sorted_by_distance.insert(std::pair<double, TokenId>(distance_to_goal, *it));
     }
 
     // Now insert in order
@@ -308,55 +394,141 @@ namespace TREX{
   }
 
 
-  GoalManager::~GoalManager(){}
+  GoalManager::~GoalManager(){
+    if(m_nextToken.isId())
+      nextTokens().erase(nextTokens().find(m_nextTokenKey));
+    delete m_searchPool;
+    delete m_costEstimatorCfg;
+    if(m_costEstimator.isId())
+      delete (CostEstimator*) m_costEstimator;
+  }
 
 
   /**
-   * @brief For now we use euclidean distance. This is where map integration comes in.
+   * @brief This is where map integration comes in, through the cost estimator.
    */
   double GoalManager::computeDistance(const Position& p1, const Position& p2){
-    double result = sqrt(pow(p1.x-p2.x, 2) + pow(p1.y-p2.y, 2));
-    debugMsg("GoalManager:computeDistance", "Distance between (" << p1.x << ", " << p1.y << ") => (" << p2.x << ", " << p2.y << ") == " << result);
-    return result;
+    checkError(m_costEstimator.isValid(), "Goal manager not initialized.");
+    return m_costEstimator->computeDistance(p1, p2);
+  }
+
+  void GoalManager::computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances){
+    checkError(m_costEstimator.isValid(), "Goal manager not initialized.");
+    m_costEstimator->computeDistances(xs, ys, distances);
+  }
+
+  /**
+   * @brief The matrix is kept for as long as the goals and initial position are the same, which spares
+   * its computation when planning is restarted with no change in the problem.
+   */
+  void GoalManager::updateDistances(const std::vector<TokenId>& goals){
+    bool changed = (m_xs.size() != goals.size() + 1 || m_xs[0] != m_position.x || m_ys[0] != m_position.y);
+    for(unsigned int i = 0; !changed && i < goals.size(); i++){
+      std::map<int, unsigned int>::const_iterator it = m_goalIndices.find(goals[i]->getKey());
+      changed = (it == m_goalIndices.end());
+      if(!changed){
+	Position p = getPosition(goals[i]);
+	changed = (m_xs[it->second] != p.x || m_ys[it->second] != p.y);
+      }
+    }
+
+    if(!changed)
+      return;
+
+    m_goalIndices.clear();
+    m_goalsByIndex.assign(1, TokenId::noId());
+    m_xs.resize(goals.size() + 1);
+    m_ys.resize(goals.size() + 1);
+    m_xs[0] = m_position.x;
+    m_ys[0] = m_position.y;
+    for(unsigned int i = 0; i < goals.size(); i++){
+      Position p = getPosition(goals[i]);
+      m_goalIndices.insert(std::make_pair(goals[i]->getKey(), i + 1));
+      m_goalsByIndex.push_back(goals[i]);
+      m_xs[i + 1] = p.x;
+      m_ys[i + 1] = p.y;
+    }
+
+    computeDistances(m_xs, m_ys, m_distances);
+    debugMsg("GoalManager:updateDistances", "Computed distances between " << m_xs.size() << " positions");
+  }
+
+  unsigned int GoalManager::indexOf(const TokenId& goal) const {
+    std::map<int, unsigned int>::const_iterator it = m_goalIndices.find(goal->getKey());
+    checkError(it != m_goalIndices.end(), "No distances computed for " << goal->toString());
+    return it->second;
   }
 
   /**
    * @brief For now, this is going to be all about speed, distance and time
    */
   bool GoalManager::evaluate(const SOLUTION& s, double& cost, double& utility){
-    static const int MAX_PRIORITY = 5;
     cost = 0;
     utility = 0;
     TokenId predecessor;
     unsigned int numConflicts(0);
     double pathLength = 0;
-    Position currentPosition = m_position;
+    unsigned int current = 0;
 
     utility = 0;
     for(SOLUTION::const_iterator it = s.begin(); it != s.end(); ++it){
       TokenId candidate = *it;
       checkError(candidate.isId() && candidate->master().isNoId(), candidate->toString());
 
-      // Utility is 10 to the power of the priority
-      utility += pow(10.0, (MAX_PRIORITY - getPriority(candidate)));
+      utility += getUtility(candidate);
 
       // Check if there is a conflict
-      if(predecessor.isId() && !getPlanDatabase()->getTemporalAdvisor()->canPrecede(predecessor, candidate))
+      if(predecessor.isId() && !canPrecede(predecessor, candidate))
 	numConflicts++;
 
-      Position nextPosition = getPosition(candidate);
+      unsigned int next = indexOf(candidate);
 
-      pathLength += computeDistance(currentPosition, nextPosition);
+      pathLength += distance(current, next);
       predecessor = candidate;
-      currentPosition = nextPosition;
+      current = next;
     }
 
-    // Priority is to remove conflicts so a much higher weight is given to that
-    cost = (pathLength / getSpeed()) + (numConflicts * pow(10.0, MAX_PRIORITY));
+    Score result = score(pathLength, numConflicts, utility);
+    cost = result.cost;
+    return result.feasible;
+  }
 
-    // Finally, feasibility is based on cost being within available budget for time.
-    // That budget is defined by the look ahead window of the solver
-    return cost <= m_timeBudget;
+  GoalManager::Score GoalManager::score(double pathLength, unsigned int numConflicts, double utility) const {
+    return OrienteeringScore::make(pathLength, numConflicts, utility, getSpeed(), m_timeBudget);
+  }
+
+  /**
+   * @brief Utility is 10 to the power of the priority
+   */
+  double GoalManager::getUtility(const TokenId& token){
+    return pow(10.0, (MAX_PRIORITY - getPriority(token)));
+  }
+
+  /**
+   * @brief Within a planning cycle the goal manager does not restrict the plan, so answers can be reused
+   * for every neighborhood explored from the same initial solution.
+   */
+  bool GoalManager::canPrecede(const TokenId& a, const TokenId& b){
+    std::pair<int, int> key(a->getKey(), b->getKey());
+    std::map<std::pair<int, int>, bool>::const_iterator it = m_precedences.find(key);
+    if(it != m_precedences.end())
+      return it->second;
+
+    bool result = getPlanDatabase()->getTemporalAdvisor()->canPrecede(a, b);
+    m_precedences.insert(std::make_pair(key, result));
+    return result;
+  }
+
+  void GoalManager::cacheCurrentSolution(){
+    m_cachedSequence.assign(m_currentSolution.begin(), m_currentSolution.end());
+
+    OrienteeringPath<GoalProblem>::SEQUENCE sequence(m_cachedSequence.size());
+    for(unsigned int i = 0; i < m_cachedSequence.size(); i++){
+      TokenId candidate = m_cachedSequence[i];
+      checkError(candidate.isId() && candidate->master().isNoId(), candidate->toString());
+      sequence[i] = indexOf(candidate) - 1;
+    }
+    m_cachedPath.assign(sequence);
   }
 
   std::string GoalManager::toString(const SOLUTION& s){
@@ -387,67 +559,258 @@ namespace TREX{
       }
     }
     m_state = s;
+    updateNextToken();
   }
 
 
+  void GoalManager::setMultiStart(unsigned int restarts, unsigned int threads){
+    m_restarts = restarts;
+    delete m_searchPool;
+    m_searchPool = (restarts > 0 ? new WorkerPool(std::max(1u, std::min(threads, restarts))) : NULL);
+  }
+
+  /**
+   * @brief Runs one search of the multi start
+   */
+  class SearchJob: public WorkerPool::Job {
+  public:
+    SearchJob(const OrienteeringProblem& problem, unsigned int seed, const OrienteeringSearch::SEQUENCE& initial)
+      : m_search(problem, seed), m_initial(initial) {}
+
+    void execute() {m_search.run(m_initial);}
+
+    const OrienteeringSearch& getSearch() const {return m_search;}
+
+  private:
+    OrienteeringSearch m_search;
+    const OrienteeringSearch::SEQUENCE& m_initial;
+  };
+
+  /**
+   * @brief The plan database is only read here, to build the data copy of the problem, and written once the best
+   * solution is known. The searches themselves only access the copy.
+   */
+  void GoalManager::multiStartSearch(){
+    std::vector<TokenId> goals(m_currentSolution.begin(), m_currentSolution.end());
+    goals.insert(goals.end(), m_ommissions.begin(), m_ommissions.end());
+    const unsigned int n = goals.size();
+
+    OrienteeringProblem problem;
+    problem.speed = getSpeed();
+    problem.timeBudget = m_timeBudget;
+    problem.maxIterations = m_maxIterations;
+    problem.plateau = m_plateau;
+    problem.utilities.resize(n);
+    problem.removable.resize(n);
+    problem.precedences.resize(n * n);
+    problem.distances.resize((n + 1) * (n + 1));
+
+    std::vector<unsigned int> indices(n + 1, 0);
+    for(unsigned int i = 0; i < n; i++){
+      indices[i + 1] = indexOf(goals[i]);
+      problem.utilities[i] = getUtility(goals[i]);
+      problem.removable[i] = !goals[i]->isActive();
+    }
+    for(unsigned int i = 0; i <= n; i++)
+      for(unsigned int j = 0; j <= n; j++)
+	problem.distances[i * (n + 1) + j] = distance(indices[i], indices[j]);
+    for(unsigned int i = 0; i < n; i++)
+      for(unsigned int j = 0; j < n; j++)
+	problem.precedences[i * n + j] = (i == j || canPrecede(goals[i], goals[j]));
+
+    // Start from the current solution, omissions being at the end of the goals
+    OrienteeringSearch::SEQUENCE initial;
+    for(unsigned int i = 0; i < m_currentSolution.size(); i++)
+      initial.push_back(i);
+
+    std::vector<WorkerPool::Job*> jobs;
+    for(unsigned int k = 0; k < m_restarts; k++)
+      jobs.push_back(new SearchJob(problem, k, initial));
+
+    m_searchPool->execute(jobs);
+
+    // Keep the best, the first one on ties
+    const OrienteeringSearch* best = &((SearchJob*) jobs[0])->getSearch();
+    for(unsigned int k = 1; k < jobs.size(); k++){
+      const OrienteeringSearch* search = &((SearchJob*) jobs[k])->getSearch();
+      debugMsg("GoalManager:multiStartSearch", "Search " << k << ": " << search->getScore().cost << "/" << search->getScore().utility);
+      if(OrienteeringScore::compare(search->getScore(), best->getScore()) == OrienteeringScore::BETTER)
+	best = search;
+    }
+
+    m_currentSolution.clear();
+    m_ommissions.clear();
+    std::vector<bool> included(n, false);
+    for(OrienteeringSearch::SEQUENCE::const_iterator it = best->getSolution().begin(); it != best->getSolution().end(); ++it){
+      m_currentSolution.push_back(goals[*it]);
+      included[*it] = true;
+    }
+    for(unsigned int i = 0; i < n; i++)
+      if(!included[i])
+	m_ommissions.insert(goals[i]);
+    m_iteration = best->getIterations();
+
+    for(std::vector<WorkerPool::Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+      delete *it;
+
+    debugMsg("trex:debug:planning:GoalManager", "Best of " << m_restarts << " searches: " << toString(m_currentSolution));
+  }
+
   /**
-   * @brief Get the best neighbor for the current solution. The neighborhood is the set of solutions
-   * within a single operation from the current solution. The operators are:
+   * @brief The neighborhood is the set of solutions within a single operation from the current solution. The operators are:
    * 1. insert
    * 2. swap
    * 3. remove
-   * There are O(n^2) neigbors
+   * There are O(n^2) neigbors. Each is scored in constant time from the path edges and conflicts
+   * cached for the current solution, and only the selected move is applied.
    *
    * @note There is alot more we can do to exploit temporal constraints and evaluate feasibility.
-   * @todo Cache feasibility of current solution
    */
-  void GoalManager::selectNeighbor(GoalManager::SOLUTION& s, TokenId& delta){
+  void GoalManager::startNeighborhood(){
     checkError(!m_currentSolution.empty() || !m_ommissions.empty(), "There must be something to do");
-    s = m_currentSolution;
 
-    // Feasibility can be used to avoid moves that are silly. We should be able to cache the feasiblility of the current solution
-    // rather than compute anew.
-    double d1, d2;
-    bool feasible = evaluate(m_currentSolution, d1, d2);
-    delta = TokenId::noId();
+    cacheCurrentSolution();
+    m_currentScore = score(m_cachedPath.pathLength(), m_cachedPath.numConflicts(), m_cachedPath.utility());
+    m_bestScore = m_currentScore;
+    m_bestMove = MOVE_NONE;
+    m_bestA = m_bestB = 0;
+    m_bestDelta = TokenId::noId();
+    m_candidates.assign(m_ommissions.begin(), m_ommissions.end());
+    m_phase = MOVE_INSERT;
+    m_cursorA = m_cursorB = 0;
+    m_exploring = true;
+  }
 
-    // Try insertions - could skip if current solution is infeasible.
-    if(feasible){
-      //std::map<double, TokenId> sorted_set;
-      for(TokenSet::const_iterator it = m_ommissions.begin(); it != m_ommissions.end(); ++it){
-	TokenId t = *it;
-	for (unsigned int i = 0; i <= m_currentSolution.size(); i++){
-	  SOLUTION c = m_currentSolution;
-	  insert(c, t, i);
-	  update(s, delta, c, t);
-	}
-      }
+  void GoalManager::consider(const Score& c, Move move, unsigned int a, unsigned int b, const TokenId& delta){
+    if(compare(c, m_bestScore) >= 0){
+      m_bestScore = c;
+      m_bestMove = move;
+      m_bestA = a;
+      m_bestB = b;
+      m_bestDelta = delta;
     }
+  }
+
+  /**
+   * @brief The cursors give the next move to evaluate. For insertions they are the candidate and the position,
+   * for swaps the 2 positions and for removals the position.
+   */
+  bool GoalManager::exploreNeighborhood(unsigned int budget){
+    const unsigned int n = m_cachedSequence.size();
+    unsigned int evaluated = 0;
+    double pathLength;
+    unsigned int numConflicts;
+
+    while(m_phase != MOVE_NONE){
+      if(budget > 0 && evaluated >= budget)
+	return false;
+
+      switch(m_phase){
+      case MOVE_INSERT:
+	// Feasibility of the current solution is used to avoid moves that are silly.
+	// Try insertions - could skip if current solution is infeasible.
+	if(!m_currentScore.feasible || m_cursorA >= m_candidates.size()){
+	  m_phase = MOVE_SWAP;
+	  m_cursorA = 0;
+	  m_cursorB = 1;
+	}
+	else {
+	  TokenId t = m_candidates[m_cursorA];
+	  unsigned int i = m_cursorB;
+
+	  m_cachedPath.insertion(indexOf(t) - 1, i, pathLength, numConflicts);
+	  Score c = score(pathLength, numConflicts, m_cachedPath.utility() + getUtility(t));
+	  debugMsg("GoalManager:update", "Evaluating insertion of " << t->getKey() << " at [" << i << "]: " << c.cost << "/" << c.utility);
+	  consider(c, MOVE_INSERT, i, 0, t);
+	  evaluated++;
+
+	  if(++m_cursorB > n){
+	    m_cursorA++;
+	    m_cursorB = 0;
+	  }
+	}
+	break;
+
+      case MOVE_SWAP:
+	// Swapping is always an option for improving things.
+	if(m_cursorB >= n){
+	  m_cursorA++;
+	  m_cursorB = m_cursorA + 1;
+	  if(m_cursorB >= n){
+	    m_phase = MOVE_REMOVE;
+	    m_cursorA = 0;
+	  }
+	}
+	else {
+	  unsigned int i = m_cursorA, j = m_cursorB;
+	  m_cachedPath.swap(i, j, pathLength, numConflicts);
+	  Score c = score(pathLength, numConflicts, m_cachedPath.utility());
+	  debugMsg("GoalManager:update", "Evaluating swap of [" << i << "] and [" << j << "]: " << c.cost << "/" << c.utility);
+	  consider(c, MOVE_SWAP, i, j, TokenId::noId());
+	  evaluated++;
+	  m_cursorB++;
+	}
+	break;
 
-    // Swapping is always an option for improving things
-    for(unsigned int i=0; i< m_currentSolution.size(); i++){
-      for(unsigned int j=i+1; j<m_currentSolution.size(); j++){
-	if(i != j){
-	  SOLUTION c = m_currentSolution;
-	  swap(c, i, j);
-	  update(s, delta, c, TokenId::noId());
+      case MOVE_REMOVE:
+	// Try removals, assuming it is infeasible
+	if(m_currentScore.feasible || m_cursorA >= n){
+	  m_phase = MOVE_NONE;
 	}
+	else {
+	  unsigned int i = m_cursorA++;
+	  TokenId t = m_cachedSequence[i];
+
+	  if(t->isActive())
+	    continue;
+
+	  m_cachedPath.removal(i, pathLength, numConflicts);
+	  Score c = score(pathLength, numConflicts, m_cachedPath.utility() - getUtility(t));
+	  debugMsg("GoalManager:update", "Evaluating removal of " << t->getKey() << ": " << c.cost << "/" << c.utility);
+	  consider(c, MOVE_REMOVE, i, 0, t);
+	  evaluated++;
+	}
+	break;
+
+      default:
+	break;
       }
     }
 
-    // Try removals, assuming it is infeasible
-    if(!feasible){
-      for(SOLUTION::const_iterator it = m_currentSolution.begin(); it != m_currentSolution.end(); ++it){
-	TokenId t = *it;
+    return true;
+  }
 
-	if(t->isActive())
-	  continue;
+  int GoalManager::selectNeighbor(GoalManager::SOLUTION& s, TokenId& delta){
+    checkError(m_exploring && m_phase == MOVE_NONE, "The neighborhood must be fully explored");
+    m_exploring = false;
 
-	SOLUTION c = m_currentSolution;
-	remove(c, t);
-	update(s, delta, c, t);
-      }
+    // Apply the selected move
+    s = m_currentSolution;
+    delta = m_bestDelta;
+    switch(m_bestMove){
+    case MOVE_INSERT:
+      insert(s, delta, m_bestA);
+      break;
+    case MOVE_SWAP:
+      swap(s, m_bestA, m_bestB);
+      break;
+    case MOVE_REMOVE:
+      remove(s, delta);
+      break;
+    default:
+      break;
     }
+
+    debugMsg("trex:debug:planning:GoalManager", "Selected neighbor " << toString(s));
+    checkError(matchesEvaluation(s, m_bestScore), "Move " << m_bestMove << " scored " << m_bestScore.cost << "/"
+	       << m_bestScore.utility << " but evaluates to " << toString(s));
+    return compare(m_bestScore, m_currentScore);
+  }
+
+  bool GoalManager::matchesEvaluation(const SOLUTION& s, const Score& expected){
+    Score actual;
+    actual.feasible = evaluate(s, actual.cost, actual.utility);
+    return OrienteeringScore::matches(actual, expected);
   }
 
   void GoalManager::insert(SOLUTION& s, const TokenId& t, unsigned int pos){
@@ -510,20 +873,6 @@ namespace TREX{
     s.erase(it);
   }
 
-  /**
-   * @brief Will promote a solution of equal or better score. This allows a move in a plateau
-   */
-  void GoalManager::update(SOLUTION& s, TokenId& delta, const SOLUTION& c, TokenId t){
-    debugMsg("GoalManager:update", "Evaluating " << toString(c));
-    if(compare(c, s) >= 0){
-      s = c;
-      delta = t;
-      debugMsg("trex:debug:planning:GoalManager", "Promote " << toString(c) << " >>> " << toString(s));
-    } else {
-      debugMsg("trex:debug:planning:GoalManager", "Not promoting " << toString(c) << " <<< " << toString(s));
-    }
-  }
-
   int GoalManager::getPriority(const TokenId& token){
     // Slaves take top priority. Cannot be rejected.
     if(token->master().isId()) {
@@ -548,7 +897,7 @@ namespace TREX{
   void GoalManager::setInitialConditions(){    
 
     // Start time
-    const IntervalIntDomain& horizon = DeliberationFilter::getHorizon();
+    const IntervalIntDomain& horizon = DeliberationFilter::getHorizon(getPlanDatabase());
     m_startTime = (int) horizon.getLowerBound();
     m_timeBudget = (int) (horizon.getUpperBound() - horizon.getLowerBound());
     debugMsg("GoalManager", "Time budget: " << m_timeBudget << " (" <<
@@ -564,39 +913,14 @@ namespace TREX{
    * @return WORSE if s1 < s2. EQUAL if s1 == s2. BETTER if s1 > s2
    */
   int GoalManager::compare(const SOLUTION& s1, const SOLUTION& s2){
-    bool f1, f2;
-    double c1, c2, u1, u2;
-    f1 = evaluate(s1, c1, u1);
-    f2 = evaluate(s2, c2, u2);
-
-    // Feasibility is dominant.
-    if(!f1) {
-      if (c1 < c2) {
-	return BETTER;
-      } else if (c1 > c2) {
-	return WORSE;
-      }
-      if (u1 > u2) {
-	return BETTER;
-      } else if (u1 < u2) {
-	return WORSE;
-      }
-    } else {
-      if (f2) {
-	if (u1 > u2) {
-	  return BETTER;
-	} else if (u1 < u2) {
-	  return WORSE;
-	}
-	if (c1 < c2) {
-	  return BETTER;
-	} else if (c1 > c2) {
-	  return WORSE;
-	}
-      }
-    }
+    Score sc1, sc2;
+    sc1.feasible = evaluate(s1, sc1.cost, sc1.utility);
+    sc2.feasible = evaluate(s2, sc2.cost, sc2.utility);
+    return compare(sc1, sc2);
+  }
 
-    return EQUAL;
+  int GoalManager::compare(const Score& s1, const Score& s2) const {
+    return OrienteeringScore::compare(s1, s2);
   }
 
   Position GoalManager::getPosition(const TokenId& token){
@@ -623,25 +947,55 @@ namespace TREX{
    * @brief We assume the curent position is a token on a given timeline that contains the current tick, and has x and y as arguments
    * indicating position.
    */
+  /**
+   * @brief Orders a tick before the tokens that start after it
+   */
+  struct EarliestStartComparator {
+    bool operator()(TICK tick, const TokenId& token) const {
+      return tick < (TICK) token->start()->lastDomain().getLowerBound();
+    }
+  };
+
+  bool GoalManager::hasPosition(const TokenId& token){
+    ConstrainedVariableId x = token->getVariable(X());
+    ConstrainedVariableId y = token->getVariable(Y());
+    checkError(x.isId(), "No variable for X in token " << token->toString());
+    checkError(y.isId(), "No variable for Y in token " << token->toString());
+    return x->lastDomain().isSingleton() && y->lastDomain().isSingleton();
+  }
+
   Position GoalManager::getCurrentPosition() {
     TICK tick = Agent::instance()->getCurrentTick();
     TokenId goodToken = TokenId::noId();
     
     debugMsg("GoalManager:getCurrentPosition", "Looking for position from token, tick: " << tick << ".");
 
-    if(m_positionSource.isId()){
+    DbCoreId core = DbCore::getInstance(getPlanDatabase());
+    if(m_positionSource.isId() && core.isId()){
+      // Start times do not decrease along the sequence. The candidates go up to the first token starting after the
+      // current tick, and the last one with a position wins.
+      const std::vector<TokenId>& tokens = core->getTokenSequence(m_positionSource);
+      std::vector<TokenId>::const_iterator it = std::upper_bound(tokens.begin(), tokens.end(), tick, EarliestStartComparator());
+      if(it != tokens.end())
+	++it;
+      while(it != tokens.begin()){
+	TokenId token = *(--it);
+	if(hasPosition(token)){
+	  debugMsg("GoalManager:getCurrentPosition", "Token contains usable position info: " << token->toString());
+	  goodToken = token;
+	  break;
+	}
+	debugMsg("GoalManager:getCurrentPosition", "Token is vacuous: " << token->toString());
+      }
+    }
+    else if(m_positionSource.isId()){
       const std::list<TokenId>& tokens = m_positionSource->getTokenSequence();
       for(std::list<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
 	TokenId token = *it;
 	debugMsg("GoalManager:getCurrentPosition", "Token range: [" << token->start()->lastDomain().getUpperBound()
 		 << ", " << token->end()->lastDomain().getLowerBound() << "].");
-	ConstrainedVariableId x = token->getVariable(X());
-	ConstrainedVariableId y = token->getVariable(Y());
-	checkError(x.isId(), "No variable for X in token " << token->toString());
-	checkError(y.isId(), "No variable for Y in token " << token->toString());
-
 
-	if(x->lastDomain().isSingleton() && y->lastDomain().isSingleton()) {
+	if(hasPosition(token)) {
 	  debugMsg("GoalManager:getCurrentPosition", "Token contains usable position info: " << token->toString());
 	  goodToken = token;
 	} else {
@@ -690,14 +1044,27 @@ namespace TREX{
     }
   }
 
-  /**
-   * This stuff not used for now
-   */
   CostEstimator::CostEstimator(const TiXmlElement& configData) {
   }
   CostEstimator::~CostEstimator() {
   }
 
+  void CostEstimator::computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances) {
+    const unsigned int n = xs.size();
+    distances.resize(n * n);
+    for(unsigned int i = 0; i < n; i++){
+      Position p1;
+      p1.x = xs[i];
+      p1.y = ys[i];
+      for(unsigned int j = 0; j < n; j++){
+	Position p2;
+	p2.x = xs[j];
+	p2.y = ys[j];
+	distances[i * n + j] = (i == j ? 0 : computeDistance(p1, p2));
+      }
+    }
+  }
+
   EuclideanCostEstimator::EuclideanCostEstimator(const TiXmlElement& configData) :
     CostEstimator(configData) {
   }
@@ -708,4 +1075,54 @@ namespace TREX{
     debugMsg("GoalManager:computeDistance", "Distance between (" << p1.x << ", " << p1.y << ") => (" << p2.x << ", " << p2.y << ") == " << result);
     return result;
   }
+
+  void EuclideanCostEstimator::computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances) {
+    const unsigned int n = xs.size();
+    distances.resize(n * n);
+    for(unsigned int i = 0; i < n; i++){
+      const double x = xs[i];
+      const double y = ys[i];
+      double* row = &distances[i * n];
+      for(unsigned int j = 0; j < n; j++){
+	const double dx = xs[j] - x;
+	const double dy = ys[j] - y;
+	row[j] = sqrt(dx * dx + dy * dy);
+      }
+    }
+  }
+
+  TableCostEstimator::TableCostEstimator(const TiXmlElement& configData) :
+    EuclideanCostEstimator(configData) {
+    const char* costFile = configData.Attribute("costFile");
+    ConfigurationException::configurationCheckError(costFile != NULL, "TableCostEstimator requires a costFile attribute.");
+    std::ifstream in(findFile(costFile).c_str());
+    ConfigurationException::configurationCheckError(in.good(), std::string("Could not open ") + costFile);
+
+    double x1, y1, x2, y2, cost;
+    while(in >> x1 >> y1 >> x2 >> y2 >> cost)
+      m_costs[makeKey(x1, y1, x2, y2)] = cost;
+
+    debugMsg("TableCostEstimator", "Read " << m_costs.size() << " costs from " << costFile);
+  }
+  TableCostEstimator::~TableCostEstimator() {
+  }
+  TableCostEstimator::Key TableCostEstimator::makeKey(double x1, double y1, double x2, double y2) {
+    return Key(std::make_pair(x1, y1), std::make_pair(x2, y2));
+  }
+  double TableCostEstimator::computeDistance(const Position& p1, const Position& p2) {
+    std::map<Key, double>::const_iterator it = m_costs.find(makeKey(p1.x, p1.y, p2.x, p2.y));
+    if(it != m_costs.end())
+      return it->second;
+    return EuclideanCostEstimator::computeDistance(p1, p2);
+  }
+  void TableCostEstimator::computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances) {
+    EuclideanCostEstimator::computeDistances(xs, ys, distances);
+    const unsigned int n = xs.size();
+    for(unsigned int i = 0; i < n; i++)
+      for(unsigned int j = 0; j < n; j++){
+	std::map<Key, double>::const_iterator it = m_costs.find(makeKey(xs[i], ys[i], xs[j], ys[j]));
+	if(it != m_costs.end())
+	  distances[i * n + j] = it->second;
+      }
+  }
 }
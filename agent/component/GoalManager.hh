@@ -37,6 +37,8 @@
 
 #include "OpenConditionManager.hh"
 #include "FlawFilter.hh"
+#include "OrienteeringSearch.hh"
+#include <set>
 
 /**
  * @brief The goal manager.
@@ -50,6 +52,7 @@ namespace TREX {
     double y;
   };
   class CostEstimator;
+  class WorkerPool;
 
   class GoalsOnlyFilter: public FlawFilter {
   public:
@@ -99,25 +102,72 @@ namespace TREX {
     DECLARE_STATIC_CLASS_CONST(LabelStr, CFG_MAP_SOURCE, "mapSource");
     DECLARE_STATIC_CLASS_CONST(LabelStr, CFG_MAX_ITERATIONS, "maxIterations");
     DECLARE_STATIC_CLASS_CONST(LabelStr, CFG_PLATEAU, "plateau");
+    DECLARE_STATIC_CLASS_CONST(LabelStr, CFG_COST_ESTIMATOR, "costEstimator");
+    DECLARE_STATIC_CLASS_CONST(LabelStr, CFG_MOVES_PER_STEP, "movesPerStep");
     /**
      * @brief True if the token is the next in the plan.
      */
     bool isNextToken(TokenId token);
+
+    /**
+     * @brief True if the token is the next in the plan of any goal manager.
+     */
+    static bool isNextGoal(const TokenId& token);
     /**
      * @brief True if the planner has no more work to do.
      */
     bool noMoreFlaws();
     /**
-     * @brief Steps the solver.
+     * @brief Steps the solver. With movesPerStep configured, a step evaluates at most that many moves and
+     * the exploration of a neighborhood is resumed on the next step.
      */
     void step();
 
+    /**
+     * @brief Accessor for the best solution found so far. It is complete at every step boundary.
+     */
+    const SOLUTION& getBestSolution() const {return m_currentSolution;}
+
     /**
      * @brief Resets internal state
      */
     void reset();
 
+    /**
+     * @brief Replace the incremental search by independent searches completed in a single step. The first
+     * starts from the initial solution and the others from random restarts. The best solution is kept.
+     * @param restarts The number of searches. 0 restores the incremental search.
+     * @param threads The number of threads running the searches, including the caller
+     */
+    void setMultiStart(unsigned int restarts, unsigned int threads);
+
   private:
+    /**
+     * @brief Evaluation of a solution
+     */
+    typedef OrienteeringScore Score;
+
+    /**
+     * @brief The goals of the planning cycle seen by an OrienteeringPath. Goal g is at index g + 1 of the distance matrix.
+     */
+    class GoalProblem {
+    public:
+      explicit GoalProblem(GoalManager& manager): m_manager(manager) {}
+
+      double distance(int from, unsigned int to) const {return m_manager.distance(from + 1, to + 1);}
+
+      bool canPrecede(unsigned int a, unsigned int b) const {
+	return m_manager.canPrecede(m_manager.m_goalsByIndex[a + 1], m_manager.m_goalsByIndex[b + 1]);
+      }
+
+      double utility(unsigned int goal) const {return m_manager.getUtility(m_manager.m_goalsByIndex[goal + 1]);}
+
+    private:
+      GoalManager& m_manager;
+    };
+
+    friend class GoalProblem;
+
     /**
      * @brief Used to synch mark current goal value as dirty
      * @see OpenConditionManager::addFlaw
@@ -152,9 +202,77 @@ namespace TREX {
     bool evaluate(const SOLUTION& s, double& cost, double& utility);
 
     /**
-     * @brief Compute a neighboring solution for s
+     * @brief True if the full evaluation of s gives the expected score. Checks the delta evaluation of moves.
+     */
+    bool matchesEvaluation(const SOLUTION& s, const Score& expected);
+
+    /**
+     * @brief Run the searches configured by setMultiStart on a data copy of the problem and keep the best solution
+     */
+    void multiStartSearch();
+
+    /**
+     * @brief Compute the score of a solution from its path length, number of precedence conflicts and utility
+     */
+    Score score(double pathLength, unsigned int numConflicts, double utility) const;
+
+    /** The moves of the neighborhood, in order of exploration */
+    enum Move {
+      MOVE_INSERT, MOVE_SWAP, MOVE_REMOVE, MOVE_NONE
+    };
+
+    /**
+     * @brief Start the exploration of the neighborhood of the current solution
+     */
+    void startNeighborhood();
+
+    /**
+     * @brief Continue the exploration of the neighborhood
+     * @param budget The maximum number of moves to evaluate. 0 for no limit.
+     * @return true if the neighborhood is fully explored
+     */
+    bool exploreNeighborhood(unsigned int budget);
+
+    /**
+     * @brief Retain a move if it is not worse than the best one so far
+     */
+    void consider(const Score& c, Move move, unsigned int a, unsigned int b, const TokenId& delta);
+
+    /**
+     * @brief Compute the best neighbor of the explored neighborhood
+     * @return The comparison of s with the current solution
+     */
+    int selectNeighbor(GoalManager::SOLUTION& s, TokenId& delta);
+
+    /**
+     * @brief Cache the path edges and conflicts of the current solution for delta evaluation of moves
+     */
+    void cacheCurrentSolution();
+
+    /**
+     * @brief Compute the distance matrix for the given goals if they or the initial position changed
+     */
+    void updateDistances(const std::vector<TokenId>& goals);
+
+    /**
+     * @brief Distance matrix index of a goal. 0 is the initial position.
+     */
+    unsigned int indexOf(const TokenId& goal) const;
+
+    /**
+     * @brief Accessor for the distance between 2 points by matrix index
+     */
+    double distance(unsigned int from, unsigned int to) const {return m_distances[from * m_xs.size() + to];}
+
+    /**
+     * @brief Memoized TemporalAdvisor::canPrecede. Cleared when a new initial solution is generated.
      */
-    void selectNeighbor(GoalManager::SOLUTION& s, TokenId& delta);
+    bool canPrecede(const TokenId& a, const TokenId& b);
+
+    /**
+     * @brief Utility contributed by a goal
+     */
+    double getUtility(const TokenId& token);
 
     /**
      * @brief Set initial conditions in terms of position, time and energy
@@ -162,10 +280,16 @@ namespace TREX {
     void setInitialConditions();
 
     /**
-     * @brief Get a distance estimate between points.
+     * @brief Get a distance estimate between points. Delegates to the cost estimator.
      */
     virtual double computeDistance(const Position& p1, const Position& p2);
 
+    /**
+     * @brief Get the distance estimates between all points. Delegates to the cost estimator.
+     * @see CostEstimator::computeDistances
+     */
+    virtual void computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances);
+
     /**
      * @brief Accessor to get a Position. For convenience
      */
@@ -176,6 +300,11 @@ namespace TREX {
      */
     Position getCurrentPosition();
 
+    /**
+     * @brief Test if a token of the position source has singleton coordinates
+     */
+    static bool hasPosition(const TokenId& token);
+
     /**
      * @brief Accessor for robot speed
      */
@@ -186,10 +315,11 @@ namespace TREX {
      */
     int compare(const SOLUTION& s1, const SOLUTION& s2);
 
+    int compare(const Score& s1, const Score& s2) const;
+
     void insert(SOLUTION&s, const TokenId& t, unsigned int pos);
     void swap(SOLUTION& s, unsigned int a, unsigned int b);
     void remove(SOLUTION& s, const TokenId& t);
-    void update(SOLUTION& s, TokenId& delta, const SOLUTION& c, TokenId t);
 
 
     std::string toString(const SOLUTION& s);
@@ -206,13 +336,26 @@ namespace TREX {
      */
     void setState(const State& s);
 
+    /**
+     * @brief Recompute the next token once the state or the current solution changed
+     */
+    void updateNextToken();
+
+    /**
+     * @brief Keys of the next tokens of all goal managers
+     */
+    static std::multiset<int>& nextTokens();
+
     // Configuration derived members
     unsigned int m_maxIterations;
     unsigned int m_plateau;
     LabelStr m_positionSourceCfg;
     TimelineId m_positionSource;
+    TiXmlElement* m_costEstimatorCfg; /*!< Configuration of the cost estimator, released on initialization */
 
     State m_state;
+    TokenId m_nextToken; /*!< First inactive token of the current solution once planning is done */
+    int m_nextTokenKey; /*!< Key of m_nextToken, which may have been deleted */
     SOLUTION m_currentSolution;
     TokenSet m_ommissions;
     std::vector< std::pair<int, ConstraintId> > m_constraints;
@@ -220,12 +363,40 @@ namespace TREX {
     // Iteration variables.
     unsigned int m_iteration, m_watchDog;
 
+    unsigned int m_restarts; /*!< Number of independent searches. 0 for the incremental search. */
+    unsigned int m_movesPerStep; /*!< Bound on moves evaluated per step. 0 for no bound. */
+
+    /* Exploration of the neighborhood, which can span several steps */
+    bool m_exploring; /*!< True from the start of a neighborhood until its best move is applied */
+    Move m_phase; /*!< The kind of moves being evaluated, MOVE_NONE once all are */
+    unsigned int m_cursorA, m_cursorB; /*!< Next move to evaluate within the phase */
+    std::vector<TokenId> m_candidates; /*!< Omitted goals to insert */
+    Score m_currentScore;
+    Score m_bestScore;
+    Move m_bestMove;
+    unsigned int m_bestA, m_bestB;
+    TokenId m_bestDelta;
+    WorkerPool* m_searchPool; /*!< Threads running the independent searches */
+
     /*!< INITIAL CONDITIONS */
     int m_startTime;
     double m_timeBudget;  
     
     Position m_position; /*! Cached position. */
 
+    /* Delta evaluation of the neighborhood of the current solution */
+    std::vector<TokenId> m_cachedSequence; /*!< The current solution */
+    GoalProblem m_goalProblem;
+    OrienteeringPath<GoalProblem> m_cachedPath; /*!< The current solution, by goal index */
+    std::map<std::pair<int, int>, bool> m_precedences; /*!< Memoized canPrecede by token keys */
+
+    /* Distances between the initial position and all goals of the planning cycle */
+    CostEstimatorId m_costEstimator;
+    std::map<int, unsigned int> m_goalIndices; /*!< Distance matrix index by goal key */
+    std::vector<TokenId> m_goalsByIndex; /*!< Goal by distance matrix index. Index 0, the initial position, has none */
+    std::vector<double> m_xs, m_ys; /*!< Positions by distance matrix index */
+    std::vector<double> m_distances; /*!< Row major distance matrix */
+
     // Integration with wavefront planner
     //plan_t* wv_plan;
 
@@ -237,11 +408,23 @@ namespace TREX {
 
   typedef Id<GoalManager> GoalManagerId;
 
+  /**
+   * @brief Estimates the cost of travel between positions for the goal manager. It is selected with the
+   * costEstimator attribute of the GoalManager, which defaults to EuclideanCostEstimator.
+   */
   class CostEstimator : public Component {
   public:
     CostEstimator(const TiXmlElement& configData);
     virtual ~CostEstimator();
     virtual double computeDistance(const Position& p1, const Position& p2) = 0;
+
+    /**
+     * @brief Compute the distances between all pairs of points at once. The default calls computeDistance for each pair.
+     * @param xs The x coordinates of the points
+     * @param ys The y coordinates of the points
+     * @param distances Filled with the row major matrix where distances[i * n + j] is the distance from point i to point j
+     */
+    virtual void computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances);
   };
 
   class EuclideanCostEstimator : public CostEstimator {
@@ -249,7 +432,29 @@ namespace TREX {
     EuclideanCostEstimator(const TiXmlElement& configData);
     ~EuclideanCostEstimator();
     double computeDistance(const Position& p1, const Position& p2);
-    
+
+    /**
+     * @brief Branch free loops over the coordinate arrays, so the compiler can vectorize them.
+     */
+    void computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances);
+  };
+
+  /**
+   * @brief Cost estimator using precomputed costs, for example derived from a road network. The costs are read from
+   * the file given by the costFile attribute with one "x1 y1 x2 y2 cost" entry per line. Pairs not listed fall back
+   * to the euclidean distance.
+   */
+  class TableCostEstimator : public EuclideanCostEstimator {
+  public:
+    TableCostEstimator(const TiXmlElement& configData);
+    ~TableCostEstimator();
+    double computeDistance(const Position& p1, const Position& p2);
+    void computeDistances(const std::vector<double>& xs, const std::vector<double>& ys, std::vector<double>& distances);
+
+  private:
+    typedef std::pair< std::pair<double, double>, std::pair<double, double> > Key;
+    static Key makeKey(double x1, double y1, double x2, double y2);
+    std::map<Key, double> m_costs;
   };
 
 }
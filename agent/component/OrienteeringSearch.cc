@@ -0,0 +1,250 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Implements the local search for orienteering problems
+ */
+
+#include "OrienteeringSearch.hh"
+#include "Error.hh"
+#include <math.h>
+#include <algorithm>
+
+namespace TREX {
+
+  OrienteeringScore OrienteeringScore::make(double pathLength, unsigned int numConflicts, double utility, double speed, double timeBudget){
+    static const int MAX_PRIORITY = 5;
+    OrienteeringScore result;
+    result.utility = utility;
+
+    // Priority is to remove conflicts so a much higher weight is given to that
+    result.cost = (pathLength / speed) + (numConflicts * pow(10.0, MAX_PRIORITY));
+
+    // Finally, feasibility is based on cost being within available budget for time.
+    // That budget is defined by the look ahead window of the solver
+    result.feasible = result.cost <= timeBudget;
+    return result;
+  }
+
+  int OrienteeringScore::compare(const OrienteeringScore& s1, const OrienteeringScore& s2){
+    bool f1 = s1.feasible, f2 = s2.feasible;
+    double c1 = s1.cost, c2 = s2.cost, u1 = s1.utility, u2 = s2.utility;
+
+    // Feasibility is dominant.
+    if(!f1) {
+      if (c1 < c2) {
+	return BETTER;
+      } else if (c1 > c2) {
+	return WORSE;
+      }
+      if (u1 > u2) {
+	return BETTER;
+      } else if (u1 < u2) {
+	return WORSE;
+      }
+    } else {
+      if (f2) {
+	if (u1 > u2) {
+	  return BETTER;
+	} else if (u1 < u2) {
+	  return WORSE;
+	}
+	if (c1 < c2) {
+	  return BETTER;
+	} else if (c1 > c2) {
+	  return WORSE;
+	}
+      }
+    }
+
+    return EQUAL;
+  }
+
+  bool OrienteeringScore::matches(const OrienteeringScore& s1, const OrienteeringScore& s2){
+    static const double EPSILON = 1e-9;
+    return s1.feasible == s2.feasible
+      && fabs(s1.cost - s2.cost) <= EPSILON * std::max(1.0, fabs(s2.cost))
+      && fabs(s1.utility - s2.utility) <= EPSILON * std::max(1.0, fabs(s2.utility));
+  }
+
+  OrienteeringSearch::OrienteeringSearch(const OrienteeringProblem& problem, unsigned int seed)
+    : m_problem(problem), m_seed(seed), m_iterations(0), m_path(problem) {}
+
+  /**
+   * @brief Same termination as the GoalManager: stop when no neighbor is at least as good, after maxIterations
+   * moves, or after plateau moves without improvement.
+   */
+  void OrienteeringSearch::run(const SEQUENCE& initial){
+    m_solution = initial;
+    m_omissions.clear();
+    std::vector<bool> included(m_problem.size(), false);
+    for(SEQUENCE::const_iterator it = initial.begin(); it != initial.end(); ++it)
+      included[*it] = true;
+    for(unsigned int i = 0; i < m_problem.size(); i++)
+      if(!included[i])
+	m_omissions.push_back(i);
+
+    if(m_seed != 0)
+      perturb();
+
+    evaluate();
+    m_iterations = 0;
+    unsigned int watchDog = 0;
+    while(m_iterations < m_problem.maxIterations && watchDog < m_problem.plateau){
+      m_iterations++;
+      watchDog++;
+
+      int result = moveToBestNeighbor();
+      if(result < 0)
+	break;
+
+      // Only pet the watchdog if we have improved the score
+      if(result == OrienteeringScore::BETTER)
+	watchDog = 0;
+    }
+  }
+
+  /**
+   * @brief Fisher-Yates shuffle of the initial sequence, making each seeded search a random restart
+   */
+  void OrienteeringSearch::perturb(){
+    for(unsigned int i = m_solution.size(); i > 1; i--){
+      unsigned int j = random(i);
+      unsigned int tmp = m_solution[i - 1];
+      m_solution[i - 1] = m_solution[j];
+      m_solution[j] = tmp;
+    }
+  }
+
+  unsigned int OrienteeringSearch::random(unsigned int n){
+    m_seed = m_seed * 1103515245u + 12345u;
+    return (m_seed >> 16) % n;
+  }
+
+  void OrienteeringSearch::evaluate(){
+    m_path.assign(m_solution);
+    m_score = OrienteeringScore::make(m_path.pathLength(), m_path.numConflicts(), m_path.utility(), m_problem.speed, m_problem.timeBudget);
+  }
+
+  /**
+   * @brief The moves are considered in the same order as in GoalManager::selectNeighbor, and a later move
+   * replaces an earlier one of equal score, which allows moves within a plateau.
+   */
+  int OrienteeringSearch::moveToBestNeighbor(){
+    enum Move {NONE, INSERT, SWAP, REMOVE};
+
+    const unsigned int n = m_solution.size();
+    OrienteeringScore best = m_score;
+    Move move = NONE;
+    unsigned int move_a = 0, move_b = 0;
+
+    double pathLength;
+    unsigned int numConflicts;
+
+    // Try insertions if the solution is feasible
+    if(m_score.feasible){
+      for(unsigned int o = 0; o < m_omissions.size(); o++){
+	unsigned int t = m_omissions[o];
+	double utility = m_path.utility() + m_problem.utility(t);
+	for(unsigned int i = 0; i <= n; i++){
+	  m_path.insertion(t, i, pathLength, numConflicts);
+	  OrienteeringScore c = OrienteeringScore::make(pathLength, numConflicts, utility, m_problem.speed, m_problem.timeBudget);
+	  if(OrienteeringScore::compare(c, best) >= 0){
+	    best = c;
+	    move = INSERT;
+	    move_a = o;
+	    move_b = i;
+	  }
+	}
+      }
+    }
+
+    // Swaps
+    for(unsigned int i = 0; i < n; i++){
+      for(unsigned int j = i + 1; j < n; j++){
+	m_path.swap(i, j, pathLength, numConflicts);
+	OrienteeringScore c = OrienteeringScore::make(pathLength, numConflicts, m_path.utility(), m_problem.speed, m_problem.timeBudget);
+	if(OrienteeringScore::compare(c, best) >= 0){
+	  best = c;
+	  move = SWAP;
+	  move_a = i;
+	  move_b = j;
+	}
+      }
+    }
+
+    // Removals if the solution is infeasible
+    if(!m_score.feasible){
+      for(unsigned int i = 0; i < n; i++){
+	if(!m_problem.removable[m_solution[i]])
+	  continue;
+
+	m_path.removal(i, pathLength, numConflicts);
+	OrienteeringScore c = OrienteeringScore::make(pathLength, numConflicts, m_path.utility() - m_problem.utility(m_solution[i]),
+						      m_problem.speed, m_problem.timeBudget);
+	if(OrienteeringScore::compare(c, best) >= 0){
+	  best = c;
+	  move = REMOVE;
+	  move_a = i;
+	}
+      }
+    }
+
+    int result = OrienteeringScore::compare(best, m_score);
+    switch(move){
+    case INSERT:
+      m_solution.insert(m_solution.begin() + move_b, m_omissions[move_a]);
+      m_omissions.erase(m_omissions.begin() + move_a);
+      break;
+    case SWAP:
+      {
+	unsigned int tmp = m_solution[move_a];
+	m_solution[move_a] = m_solution[move_b];
+	m_solution[move_b] = tmp;
+      }
+      break;
+    case REMOVE:
+      m_omissions.push_back(m_solution[move_a]);
+      m_solution.erase(m_solution.begin() + move_a);
+      break;
+    default:
+      return OrienteeringScore::WORSE;
+    }
+
+    evaluate();
+    checkError(OrienteeringScore::matches(best, m_score), "Move " << move << " scored " << best.cost << "/" << best.utility
+	       << " but evaluates to " << m_score.cost << "/" << m_score.utility);
+    return result;
+  }
+}
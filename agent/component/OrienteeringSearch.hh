@@ -0,0 +1,267 @@
+#ifndef H_ORIENTEERINGSEARCH
+#define H_ORIENTEERINGSEARCH
+
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Local search over a pure data copy of an orienteering problem. It does not access the plan
+ * database and can therefore run on worker threads.
+ */
+
+#include <vector>
+
+namespace TREX {
+
+  /**
+   * @brief Evaluation of a solution of an orienteering problem
+   */
+  struct OrienteeringScore {
+    bool feasible;
+    double cost;
+    double utility;
+
+    /**
+     * @brief Compute a score. Conflicts weigh more than any path.
+     * @param pathLength The length of the path through all goals of the solution
+     * @param numConflicts The number of successive goals which cannot precede each other
+     * @param utility The sum of the utilities of the goals of the solution
+     * @param speed The nominal speed of the robot
+     * @param timeBudget The solution is feasible if its cost does not exceed it
+     */
+    static OrienteeringScore make(double pathLength, unsigned int numConflicts, double utility, double speed, double timeBudget);
+
+    /**
+     * @brief is s1 better than s2. Feasibility is dominant, then utility for feasible solutions and cost otherwise.
+     * @return WORSE if s1 < s2. EQUAL if s1 == s2. BETTER if s1 > s2
+     */
+    static int compare(const OrienteeringScore& s1, const OrienteeringScore& s2);
+
+    /**
+     * @brief True if both scores are equal up to rounding errors. Used to check the delta evaluation of a move
+     * against the full evaluation of the resulting solution.
+     */
+    static bool matches(const OrienteeringScore& s1, const OrienteeringScore& s2);
+
+    static const int WORSE = -1;
+    static const int EQUAL = 0;
+    static const int BETTER = 1;
+  };
+
+  /**
+   * @brief Path of a sequence of goals, with its edges and precedence conflicts cached so that the insert, swap and remove
+   * moves of the local search are scored in constant time. Shared by the GoalManager and the OrienteeringSearch.
+   * @param Problem Gives double distance(int from, unsigned int to), -1 being the initial position, bool canPrecede(unsigned
+   * int a, unsigned int b) and double utility(unsigned int goal), goals being identified by an index.
+   */
+  template<class Problem>
+  class OrienteeringPath {
+  public:
+    typedef std::vector<unsigned int> SEQUENCE;
+
+    explicit OrienteeringPath(const Problem& problem)
+      : m_problem(problem), m_pathLength(0), m_numConflicts(0), m_utility(0) {}
+
+    /**
+     * @brief Cache the edges and conflicts of a sequence
+     */
+    void assign(const SEQUENCE& sequence){
+      m_sequence = sequence;
+      const unsigned int n = m_sequence.size();
+      m_edges.resize(n);
+      m_conflicts.resize(n);
+      m_pathLength = 0;
+      m_numConflicts = 0;
+      m_utility = 0;
+      for(unsigned int i = 0; i < n; i++){
+	m_edges[i] = m_problem.distance(predecessor(i), m_sequence[i]);
+	m_conflicts[i] = (i > 0 && !m_problem.canPrecede(m_sequence[i - 1], m_sequence[i]));
+	m_pathLength += m_edges[i];
+	m_numConflicts += (m_conflicts[i] ? 1 : 0);
+	m_utility += m_problem.utility(m_sequence[i]);
+      }
+    }
+
+    const SEQUENCE& sequence() const {return m_sequence;}
+
+    unsigned int size() const {return m_sequence.size();}
+
+    double pathLength() const {return m_pathLength;}
+
+    unsigned int numConflicts() const {return m_numConflicts;}
+
+    double utility() const {return m_utility;}
+
+    /**
+     * @brief Goal preceding position i, -1 being the initial position
+     */
+    int predecessor(unsigned int i) const {return i == 0 ? -1 : (int) m_sequence[i - 1];}
+
+    /**
+     * @brief Path length and conflicts once goal is inserted at position i. The edge into i is replaced by the edges through goal.
+     */
+    void insertion(unsigned int goal, unsigned int i, double& pathLength, unsigned int& numConflicts) const {
+      pathLength = m_pathLength + m_problem.distance(predecessor(i), goal);
+      numConflicts = m_numConflicts + (i > 0 && !m_problem.canPrecede(m_sequence[i - 1], goal) ? 1 : 0);
+      if(i < m_sequence.size()){
+	pathLength += m_problem.distance(goal, m_sequence[i]) - m_edges[i];
+	numConflicts += (!m_problem.canPrecede(goal, m_sequence[i]) ? 1 : 0) - (m_conflicts[i] ? 1 : 0);
+      }
+    }
+
+    /**
+     * @brief Path length and conflicts once the goals at positions i < j are swapped. Only the edges into i, i+1, j and j+1 change.
+     */
+    void swap(unsigned int i, unsigned int j, double& pathLength, unsigned int& numConflicts) const {
+      const unsigned int n = m_sequence.size();
+      pathLength = m_pathLength;
+      numConflicts = m_numConflicts;
+      unsigned int edges[4] = {i, i + 1, j, j + 1};
+      for(unsigned int e = 0; e < 4; e++){
+	unsigned int k = edges[e];
+	if(k >= n || (e == 2 && k == i + 1))
+	  continue;
+
+	// Positions of the elements at k-1 and k after the swap
+	int from = (k == 0 ? -1 : (int) (k - 1 == i ? j : (k - 1 == j ? i : k - 1)));
+	unsigned int to = (k == i ? j : (k == j ? i : k));
+
+	pathLength += m_problem.distance(from < 0 ? -1 : (int) m_sequence[from], m_sequence[to]) - m_edges[k];
+	numConflicts += (from >= 0 && !m_problem.canPrecede(m_sequence[from], m_sequence[to]) ? 1 : 0) - (m_conflicts[k] ? 1 : 0);
+      }
+    }
+
+    /**
+     * @brief Path length and conflicts once the goal at position i is removed. The edges into i and i+1 are replaced by a direct edge.
+     */
+    void removal(unsigned int i, double& pathLength, unsigned int& numConflicts) const {
+      pathLength = m_pathLength - m_edges[i];
+      numConflicts = m_numConflicts - (m_conflicts[i] ? 1 : 0);
+      if(i + 1 < m_sequence.size()){
+	pathLength += m_problem.distance(predecessor(i), m_sequence[i + 1]) - m_edges[i + 1];
+	numConflicts += (i > 0 && !m_problem.canPrecede(m_sequence[i - 1], m_sequence[i + 1]) ? 1 : 0) - (m_conflicts[i + 1] ? 1 : 0);
+      }
+    }
+
+  private:
+    const Problem& m_problem;
+    SEQUENCE m_sequence;
+    std::vector<double> m_edges; /*!< Distance from the predecessor (or initial position) of each goal */
+    std::vector<bool> m_conflicts; /*!< True if a goal cannot follow its predecessor */
+    double m_pathLength;
+    unsigned int m_numConflicts;
+    double m_utility;
+  };
+
+  /**
+   * @brief Pure data copy of the goals of an orienteering problem. Goals are identified by their index.
+   */
+  struct OrienteeringProblem {
+    unsigned int size() const {return utilities.size();}
+
+    /**
+     * @brief Distance from the goal at index from to the goal at index to. Index -1 is the initial position.
+     */
+    double distance(int from, unsigned int to) const {return distances[(from + 1) * (size() + 1) + to + 1];}
+
+    bool canPrecede(unsigned int a, unsigned int b) const {return precedences[a * size() + b];}
+
+    double utility(unsigned int goal) const {return utilities[goal];}
+
+    std::vector<double> distances; /*!< Row major matrix over the initial position and the goals, in that order */
+    std::vector<double> utilities; /*!< Utility of each goal */
+    std::vector<bool> precedences; /*!< Row major matrix. True if goal a can precede goal b */
+    std::vector<bool> removable; /*!< True if the goal can be omitted from a solution */
+    double speed;
+    double timeBudget;
+    unsigned int maxIterations;
+    unsigned int plateau;
+  };
+
+  /**
+   * @brief Steepest ascent hill climbing on an OrienteeringProblem using insert, swap and remove moves, as
+   * done by the GoalManager. Each move is scored in constant time by an OrienteeringPath. Independent searches
+   * can run concurrently on the same problem.
+   */
+  class OrienteeringSearch {
+  public:
+    typedef std::vector<unsigned int> SEQUENCE;
+
+    /**
+     * @param problem The problem. It must outlive the search.
+     * @param seed Seed of the perturbation of the initial solution. 0 starts from the initial solution as is.
+     */
+    OrienteeringSearch(const OrienteeringProblem& problem, unsigned int seed);
+
+    /**
+     * @brief Search from an initial sequence. Goals not in the sequence are initially omitted.
+     */
+    void run(const SEQUENCE& initial);
+
+    const SEQUENCE& getSolution() const {return m_solution;}
+
+    const OrienteeringScore& getScore() const {return m_score;}
+
+    unsigned int getIterations() const {return m_iterations;}
+
+  private:
+    /**
+     * @brief Randomly reorder the solution and omissions
+     */
+    void perturb();
+
+    /**
+     * @brief Cache edges and conflicts of the solution and compute its score
+     */
+    void evaluate();
+
+    /**
+     * @brief Apply the best move if not worse than the solution
+     * @return The comparison of the best neighbor with the solution, or WORSE if there is no move
+     */
+    int moveToBestNeighbor();
+
+    unsigned int random(unsigned int n);
+
+    const OrienteeringProblem& m_problem;
+    unsigned int m_seed;
+    SEQUENCE m_solution;
+    SEQUENCE m_omissions;
+    OrienteeringScore m_score;
+    unsigned int m_iterations;
+    OrienteeringPath<OrienteeringProblem> m_path; /*!< Cached for the current solution */
+  };
+}
+
+#endif
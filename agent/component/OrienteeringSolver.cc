@@ -47,16 +47,11 @@ namespace TREX {
 
 
 
-  std::vector<OrienteeringSolverId> OrienteeringSolver::s_goalSolvers;
-
+  /**
+   * @brief The goal managers maintain the set of next goals as their solutions change
+   */
   bool OrienteeringSolver::isGlobalNextGoal(TokenId token) {
-    for (std::vector<OrienteeringSolverId>::iterator it = s_goalSolvers.begin(); 
-	 it != s_goalSolvers.end(); it++) {
-      if ((*it)->isNextGoal(token)) {
-	return true;
-      }
-    }
-    return false;
+    return GoalManager::isNextGoal(token);
   }
 
   bool OrienteeringSolver::isNextGoal(TokenId token) {
@@ -68,17 +63,9 @@ namespace TREX {
 
   OrienteeringSolver::OrienteeringSolver(const TiXmlElement& cfgXml) 
     : FlawManagerSolver(cfgXml), m_goalManager(GoalManagerId::noId()), m_stepCount(0) {
-    s_goalSolvers.push_back(this->getId());
   }
   
   OrienteeringSolver::~OrienteeringSolver() {
-    for (std::vector<OrienteeringSolverId>::iterator it = s_goalSolvers.begin(); 
-	 it != s_goalSolvers.end(); it++) {
-      if ((OrienteeringSolver*)(*it) == this) {
-	s_goalSolvers.erase(it);
-	break;
-      }
-    }
   }
   
   void OrienteeringSolver::init(PlanDatabaseId db, TiXmlElement* cfgXml) {
@@ -90,6 +77,13 @@ namespace TREX {
     assertTrue((GoalManager*)getFlawManager(0),
 	       "You must have one and only one GoalManager per solver, and nothing else.");
     m_goalManager = ((GoalManager*)getFlawManager(0))->getId();
+
+    // Multi start search, with one thread per search by default
+    if(cfgXml->Attribute("restarts") != NULL){
+      unsigned int restarts = atoi(cfgXml->Attribute("restarts"));
+      const char* threads = cfgXml->Attribute("searchThreads");
+      m_goalManager->setMultiStart(restarts, threads != NULL ? atoi(threads) : restarts);
+    }
   }
   
   bool OrienteeringSolver::isExhausted() {
@@ -50,6 +50,9 @@ namespace TREX {
 
   /**
    * @brief A Steepest Ascent Hill Climbing Algorithm for Orienteering Problems.
+   *
+   * With restarts="K", K independent searches are run on searchThreads worker threads (K by default)
+   * and the best solution is kept.
    */
   class OrienteeringSolver : public FlawManagerSolver {
   public:
@@ -104,7 +107,6 @@ namespace TREX {
     bool isNextGoal(TokenId token);
   private:
     GoalManagerId m_goalManager; /*! The goal manager. */
-    static std::vector<OrienteeringSolverId> s_goalSolvers;  /*! Static list of solvers. */
     unsigned int m_stepCount; /*! Counts steps. */
   };
 }
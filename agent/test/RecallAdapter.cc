@@ -64,8 +64,9 @@ namespace TREX {
      * Force observation of value based on tick value. This will force plan failures directly and indirectly.
      */
     bool synchronize(){
-      ObservationByValue obs("c", "NumberTimeline.holds");
-      obs.push_back("value", new IntervalIntDomain(getCurrentTick(),getCurrentTick()));
+      IntervalIntDomain value(getCurrentTick(),getCurrentTick());
+      FixedObservation<1> obs("c", "NumberTimeline.holds");
+      obs.push_back("value", &value);
       m_observer->notify(obs);
       return true;
     }
@@ -0,0 +1,332 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+* 
+*  Copyright (c) 2026. TREX Project contributors.
+*  All rights reserved.
+* 
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+* 
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the TREX Project nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+* 
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file Ticks per second benchmark over the scenarios of the module tests. Each scenario is run under the simulation clock,
+ * with the step budget of its test, in a process of its own so that its peak memory is its own and a crash does not
+ * stop the sweep. Results go to s.scenario.stats and are compared with a baseline as for the scalability benchmark.
+ */
+
+#include "Agent.hh"
+#include "LogManager.hh"
+#include "PerformanceMonitor.hh"
+#include "ClockStat.hh"
+#include "Utilities.hh"
+#include "Debug.hh"
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <new>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace TREX;
+using namespace EUROPA;
+
+/*
+ * Allocation counting: this program replaces the global operator new to count the allocations and their size.
+ */
+static unsigned long sl_allocations = 0;
+static unsigned long long sl_allocatedBytes = 0;
+
+static void* countedAlloc(std::size_t size){
+  __sync_fetch_and_add(&sl_allocations, 1);
+  __sync_fetch_and_add(&sl_allocatedBytes, (unsigned long long) size);
+  void* p = malloc(size == 0 ? 1 : size);
+  if(p == NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size) throw(std::bad_alloc) {return countedAlloc(size);}
+void* operator new[](std::size_t size) throw(std::bad_alloc) {return countedAlloc(size);}
+void operator delete(void* p) throw() {free(p);}
+void operator delete[](void* p) throw() {free(p);}
+
+/**
+ * @brief A configuration of the module tests, with the steps per tick it is tested with
+ */
+struct Scenario {
+  const char* name;
+  const char* config;
+  unsigned int stepsPerTick;
+};
+
+static const Scenario sl_scenarios[] = {
+  {"GamePlay", "GamePlay.cfg", 50},
+  {"pr.0", "personal_robots/pr.0.cfg", 50},
+  {"orienteering.0", "orienteering.0.cfg", 50},
+  {"orienteering.1", "orienteering.1.cfg", 50},
+  {"orienteering.2", "orienteering.2.cfg", 50},
+  {"orienteering.3", "orienteering.3.cfg", 50},
+  {"orienteering.4", "orienteering.4.cfg", 50},
+  {"dispatch.0", "dispatch.0.cfg", 50},
+  {"dispatch.1", "dispatch.1.cfg", 50},
+  {"dispatch.2", "dispatch.2.cfg", 50},
+  {"repair.0", "repair.0.cfg", 50},
+  {"repair.1", "repair.1.cfg", 50},
+  {"repair.3", "repair.3.cfg", 50}
+};
+
+/**
+ * @brief Measures of a scenario run. Allocations and phase times only cover the ticks, not the agent initialization.
+ */
+class ScenarioResult {
+public:
+  ScenarioResult(): ticks(0), ticksPerSecond(0), synch(0), deliberation(0), allocations(0), allocatedKb(0), peakKb(0) {
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      phaseMs[i] = 0;
+  }
+
+  static std::string header() {
+    std::stringstream ss;
+    ss << "scenario,ticks,ticksPerSecond,synchSeconds,deliberationSeconds";
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      ss << "," << PerformanceMonitor::phaseName((PerformanceMonitor::Phase) i) << "Ms";
+    ss << ",allocations,allocatedKb,peakKb";
+    return ss.str();
+  }
+
+  std::string toString() const {
+    std::stringstream ss;
+    ss << name << "," << ticks << "," << ticksPerSecond << "," << synch << "," << deliberation;
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      ss << "," << phaseMs[i];
+    ss << "," << allocations << "," << allocatedKb << "," << peakKb;
+    return ss.str();
+  }
+
+  /**
+   * @brief Parse a line produced by toString
+   */
+  bool parse(const std::string& line) {
+    std::string copy(line);
+    for(unsigned int i = 0; i < copy.size(); i++)
+      if(copy[i] == ',')
+	copy[i] = ' ';
+
+    std::stringstream ss(copy);
+    ss >> name >> ticks >> ticksPerSecond >> synch >> deliberation;
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      ss >> phaseMs[i];
+    ss >> allocations >> allocatedKb >> peakKb;
+    return !ss.fail();
+  }
+
+  std::string name;
+  unsigned int ticks;
+  double ticksPerSecond;
+  double synch; /*!< Seconds of user time synchronizing */
+  double deliberation; /*!< Seconds of user time deliberating */
+  double phaseMs[PerformanceMonitor::PHASE_COUNT]; /*!< Wall clock time by phase, summed over the reactors */
+  unsigned long allocations;
+  unsigned long allocatedKb;
+  long peakKb;
+};
+
+double seconds(const timeval& v){
+  return v.tv_sec + v.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief Run a scenario once in process
+ */
+ScenarioResult runScenario(const Scenario& s){
+  const std::string configPath = findFile(s.config);
+  const TiXmlElement& root = LogManager::acquireXml(configPath);
+
+  SimulationClock clock(1.0, s.stepsPerTick);
+  Agent::initialize(root, clock);
+  LogManager::instance().handleInit();
+
+  unsigned long allocations = sl_allocations;
+  unsigned long long allocatedBytes = sl_allocatedBytes;
+  long long start = ClockStat::now(ClockStat::monotonic);
+  while(!Agent::instance()->missionCompleted())
+    Agent::instance()->doNext();
+  double wallTime = (ClockStat::now(ClockStat::monotonic) - start) / 1e9;
+
+  ScenarioResult result;
+  result.name = s.name;
+  result.allocations = sl_allocations - allocations;
+  result.allocatedKb = (sl_allocatedBytes - allocatedBytes) / 1024;
+
+  const std::vector< std::pair<timeval, timeval> >& data = Agent::instance()->getMonitor().getData();
+  result.ticks = data.size();
+  result.ticksPerSecond = (wallTime > 0 ? data.size() / wallTime : 0);
+  for(unsigned int i = 0; i < data.size(); i++){
+    result.synch += seconds(data[i].first);
+    result.deliberation += seconds(data[i].second);
+  }
+
+  const std::vector<TeleoReactorId>& reactors = Agent::instance()->getSortedReactors();
+  for(std::vector<TeleoReactorId>::const_iterator it = reactors.begin(); it != reactors.end(); ++it)
+    for(unsigned int i = 0; i < PerformanceMonitor::PHASE_COUNT; i++)
+      result.phaseMs[i] += (*it)->getLatency((PerformanceMonitor::Phase) i).total() / 1000.0;
+
+  Agent::reset();
+  LogManager::releaseXml(configPath);
+  return result;
+}
+
+/**
+ * @brief Run a scenario in a child process
+ * @param repeats The number of runs. The fastest one is kept.
+ * @param result Set to the measures of the fastest run, with the peak memory of the child process
+ * @return false if the child failed
+ */
+bool benchmarkScenario(const Scenario& s, unsigned int repeats, ScenarioResult& result){
+  int fds[2];
+  if(pipe(fds) != 0)
+    return false;
+
+  // Nothing buffered is to be output twice
+  std::cout.flush();
+  fflush(stdout);
+
+  pid_t pid = fork();
+  if(pid < 0){
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+
+  if(pid == 0){
+    close(fds[0]);
+    try{
+      ScenarioResult best;
+      for(unsigned int i = 0; i < repeats; i++){
+	ScenarioResult run = runScenario(s);
+	if(i == 0 || run.ticksPerSecond > best.ticksPerSecond)
+	  best = run;
+      }
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      best.peakKb = usage.ru_maxrss;
+
+      std::string line = best.toString() + "\n";
+      ssize_t written = write(fds[1], line.c_str(), line.size());
+      _exit(written == (ssize_t) line.size() ? 0 : 1);
+    }
+    catch(...){
+      _exit(1);
+    }
+  }
+
+  close(fds[1]);
+  std::string line;
+  char buffer[256];
+  ssize_t n;
+  while((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    line.append(buffer, n);
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 && result.parse(line);
+}
+
+/**
+ * Usage: agent-scenario-bench [repeats [baseline [tolerance]]]
+ * - repeats: runs of each scenario, 3 by default. The fastest one is reported.
+ * - baseline: the file to compare with, s.scenario.baseline by default. The results are stored there if it does not exist.
+ * - tolerance: the relative loss of ticks per second allowed, 0.2 by default.
+ * Exits with a failure status if any scenario failed or regressed.
+ */
+int main(int argc, char **argv) {
+  setenv("TREX_PATH", "./orienteering:./personal_robots", 1);
+
+  unsigned int repeats = (argc > 1 ? atoi(argv[1]) : 3);
+  if(repeats == 0)
+    repeats = 1;
+  std::string baselineFile(argc > 2 ? argv[2] : "s.scenario.baseline");
+  double tolerance = (argc > 3 ? atof(argv[3]) : 0.2);
+
+  std::map<std::string, ScenarioResult> baseline;
+  {
+    std::ifstream in(baselineFile.c_str());
+    std::string line;
+    while(getline(in, line)){
+      ScenarioResult entry;
+      if(entry.parse(line))
+	baseline[entry.name] = entry;
+    }
+  }
+
+  std::ofstream of("s.scenario.stats");
+  of << ScenarioResult::header() << std::endl;
+
+  unsigned int failures = 0;
+  for(unsigned int i = 0; i < sizeof(sl_scenarios) / sizeof(sl_scenarios[0]); i++){
+    const Scenario& s = sl_scenarios[i];
+    ScenarioResult result;
+
+    std::cout << "Running " << s.name << " ....";
+    if(!benchmarkScenario(s, repeats, result)){
+      std::cout << " FAILED" << std::endl;
+      failures++;
+      continue;
+    }
+
+    std::cout << " " << result.ticksPerSecond << " ticks/s, " << result.ticks << " ticks, synch " << result.synch <<
+      "s, deliberation " << result.deliberation << "s,";
+    for(unsigned int p = 0; p < PerformanceMonitor::PHASE_COUNT; p++)
+      std::cout << " " << PerformanceMonitor::phaseName((PerformanceMonitor::Phase) p) << " " << result.phaseMs[p] << "ms";
+    std::cout << ", " << result.allocations << " allocations (" << result.allocatedKb << "kb), peak " << result.peakKb << "kb" << std::endl;
+    of << result.toString() << std::endl;
+
+    std::map<std::string, ScenarioResult>::const_iterator prior = baseline.find(result.name);
+    if(prior != baseline.end() && result.ticksPerSecond < prior->second.ticksPerSecond * (1 - tolerance)){
+      std::cout << "REGRESSION " << result.name << ": " << result.ticksPerSecond << " ticks/s (baseline " <<
+	prior->second.ticksPerSecond << ")" << std::endl;
+      failures++;
+    }
+  }
+  of.close();
+
+  if(baseline.empty()){
+    std::ifstream in("s.scenario.stats");
+    std::ofstream out(baselineFile.c_str());
+    out << in.rdbuf();
+    std::cout << "No baseline: results stored in " << baselineFile << std::endl;
+  }
+
+  return (failures == 0 ? 0 : 1);
+}
@@ -38,15 +38,23 @@
  * with different partition structure and internal connectivity per reactor.
  */
 #include "Agent.hh"
+#include "DbCore.hh"
+#include "Synchronizer.hh"
 #include "LogManager.hh"
 #include "Debug.hh"
 #include "Nddl.hh"
 #include <signal.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace TREX;
 using namespace EUROPA;
@@ -262,8 +270,9 @@ void makeProblemInstance(const Problem& p){
 
 /**
  * @brief Run a problem, and retrieve the results as a data set
+ * @param wallTime Set to the elapsed time of the run, in seconds
  */
-std::vector< std::pair<timeval, timeval> > runProblemInstance(const Problem& p) {
+std::vector< std::pair<timeval, timeval> > runProblemInstance(const Problem& p, double& wallTime) {
   std::ofstream dbgFile("Debug.log");
   LogManager::instance();
   std::string configStr = p.toString() + std::string(".cfg");
@@ -273,6 +282,8 @@ std::vector< std::pair<timeval, timeval> > runProblemInstance(const Problem& p)
   PseudoClock clk(0.0, 10000);
   Agent::initialize(*root, clk);
 
+  timeval start, end;
+  gettimeofday(&start, NULL);
   try{
     debugMsg("ALWAYS", "Executing the agent");
     Agent::instance()->run();
@@ -280,16 +291,204 @@ std::vector< std::pair<timeval, timeval> > runProblemInstance(const Problem& p)
   catch(void*){
     debugMsg("ALWAYS", "Caught unexpected exception.");
   }
+  gettimeofday(&end, NULL);
+  wallTime = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
 
   std::vector< std::pair<timeval, timeval> > results = Agent::instance()->getMonitor().getData();
 
   // Cleanup
   Agent::reset();
-  Agent::cleanupLog();
   delete root;
   return results;
 }
 
+std::vector< std::pair<timeval, timeval> > runProblemInstance(const Problem& p) {
+  double wallTime;
+  return runProblemInstance(p, wallTime);
+}
+
+/**
+ * @brief Measures of a benchmark run. Times are in seconds.
+ */
+class BenchResult {
+public:
+  BenchResult(): ticks(0), ticksPerSecond(0), peakKb(0) {
+    for(unsigned int i = 0; i < COUNT; i++)
+      synch[i] = deliberation[i] = 0;
+  }
+
+  enum Percentile {P50 = 0, P90, P99, COUNT};
+
+  static double quantile(Percentile p) {
+    static const double sl_quantiles[COUNT] = {0.5, 0.9, 0.99};
+    return sl_quantiles[p];
+  }
+
+  static std::string header() {
+    return "problem,ticks,ticksPerSecond,synchP50,synchP90,synchP99,deliberationP50,deliberationP90,deliberationP99,peakKb";
+  }
+
+  std::string toString() const {
+    std::stringstream ss;
+    ss << name << "," << ticks << "," << ticksPerSecond;
+    for(unsigned int i = 0; i < COUNT; i++)
+      ss << "," << synch[i];
+    for(unsigned int i = 0; i < COUNT; i++)
+      ss << "," << deliberation[i];
+    ss << "," << peakKb;
+    return ss.str();
+  }
+
+  /**
+   * @brief Parse a line produced by toString
+   */
+  bool parse(const std::string& line) {
+    std::string copy(line);
+    for(unsigned int i = 0; i < copy.size(); i++)
+      if(copy[i] == ',')
+	copy[i] = ' ';
+
+    std::stringstream ss(copy);
+    ss >> name >> ticks >> ticksPerSecond;
+    for(unsigned int i = 0; i < COUNT; i++)
+      ss >> synch[i];
+    for(unsigned int i = 0; i < COUNT; i++)
+      ss >> deliberation[i];
+    ss >> peakKb;
+    return !ss.fail();
+  }
+
+  std::string name;
+  unsigned int ticks;
+  double ticksPerSecond;
+  double synch[COUNT];
+  double deliberation[COUNT];
+  long peakKb;
+};
+
+double seconds(const timeval& v){
+  return v.tv_sec + v.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief Percentiles of a set of samples, which gets sorted.
+ */
+void percentiles(std::vector<double>& samples, double* result){
+  std::sort(samples.begin(), samples.end());
+  for(unsigned int i = 0; i < BenchResult::COUNT; i++){
+    if(samples.empty())
+      result[i] = 0;
+    else {
+      unsigned int index = (unsigned int) (BenchResult::quantile((BenchResult::Percentile) i) * (samples.size() - 1) + 0.5);
+      result[i] = samples[index];
+    }
+  }
+}
+
+/**
+ * @brief Generate and run a problem in process.
+ */
+BenchResult benchmarkProblem(const Problem& p){
+  makeProblemInstance(p);
+
+  double wallTime;
+  std::vector< std::pair<timeval, timeval> > data = runProblemInstance(p, wallTime);
+
+  BenchResult result;
+  result.name = p.toString();
+  result.ticks = data.size();
+  result.ticksPerSecond = (wallTime > 0 ? data.size() / wallTime : 0);
+
+  std::vector<double> synch, deliberation;
+  for(unsigned int i = 0; i < data.size(); i++){
+    synch.push_back(seconds(data[i].first));
+    deliberation.push_back(seconds(data[i].second));
+  }
+  percentiles(synch, result.synch);
+  percentiles(deliberation, result.deliberation);
+
+  // The peak of the process so far: problems are swept by increasing size so it is the peak of the largest one run
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  result.peakKb = usage.ru_maxrss;
+
+  return result;
+}
+
+/**
+ * @brief The configurations swept by the benchmark, by increasing size. Each dimension is varied on its own from a
+ * small base problem: width, depth, growth, internal timelines, external timelines and connectivity.
+ */
+std::vector<Problem> benchmarkProblems(){
+  const unsigned int H = 50;
+  std::vector<Problem> problems;
+  for(unsigned int I = 1; I <= 30; I *= 3)
+    problems.push_back(Problem(1, 0, 0, I, 0, 0, H));
+  for(unsigned int C = 1; C < 10; C += 4)
+    problems.push_back(Problem(1, 0, 0, 10, 0, C, H));
+  for(unsigned int W = 2; W <= 8; W *= 2)
+    problems.push_back(Problem(W, 0, 1, 10, 0, 0, H));
+  for(unsigned int D = 1; D <= 3; D++)
+    problems.push_back(Problem(1, D, 1, 10, 1, 0, H));
+  for(unsigned int G = 2; G <= 3; G++)
+    problems.push_back(Problem(1, 2, G, 10, 1, 0, H));
+  for(unsigned int E = 5; E <= 20; E *= 2)
+    problems.push_back(Problem(1, 1, 1, 20, E, 0, H));
+  return problems;
+}
+
+/**
+ * @brief Sweep the benchmark problems and compare them to a baseline. As for regression tests, the results are stored
+ * as the baseline if there is none yet.
+ * @param baselineFile The file holding the baseline results
+ * @param tolerance The relative loss allowed on ticks per second and on the 90th percentile of synchronization time
+ * @return The number of problems which regressed
+ */
+unsigned int benchmark(const std::string& baselineFile, double tolerance){
+  std::map<std::string, BenchResult> baseline;
+  {
+    std::ifstream in(baselineFile.c_str());
+    std::string line;
+    while(getline(in, line)){
+      BenchResult entry;
+      if(entry.parse(line))
+	baseline[entry.name] = entry;
+    }
+  }
+
+  std::vector<Problem> problems = benchmarkProblems();
+  std::ofstream of("s.bench.stats");
+  of << BenchResult::header() << std::endl;
+
+  unsigned int regressions = 0;
+  for(std::vector<Problem>::const_iterator it = problems.begin(); it != problems.end(); ++it){
+    BenchResult result = benchmarkProblem(*it);
+    of << result.toString() << std::endl;
+
+    std::map<std::string, BenchResult>::const_iterator prior = baseline.find(result.name);
+    if(prior == baseline.end())
+      continue;
+
+    const BenchResult& ref = prior->second;
+    if(result.ticksPerSecond < ref.ticksPerSecond * (1 - tolerance) ||
+       result.synch[BenchResult::P90] > ref.synch[BenchResult::P90] * (1 + tolerance)){
+      std::cout << "REGRESSION " << result.name << ": " << result.ticksPerSecond << " ticks/s (baseline " << ref.ticksPerSecond <<
+	"), synch p90 " << result.synch[BenchResult::P90] << "s (baseline " << ref.synch[BenchResult::P90] << "s)" << std::endl;
+      regressions++;
+    }
+  }
+  of.close();
+
+  if(baseline.empty()){
+    std::ifstream in("s.bench.stats");
+    std::ofstream out(baselineFile.c_str());
+    out << in.rdbuf();
+    std::cout << "No baseline: results stored in " << baselineFile << std::endl;
+  }
+
+  return regressions;
+}
+
 /**
  * @brief Evaluate increase of synchronization with greater I. C = 0
  */
@@ -409,10 +608,93 @@ void experiment4(bool generateProblem){
 }
 
 
+/**
+ * @brief Write the latencies of each synchronization operation of a reactor, one row per operation.
+ */
+void writeSynchronizerLatencies(std::ostream& of, const Problem& p, const DbCoreId& core){
+  const Synchronizer& synchronizer = core->getSynchronizer();
+  for(unsigned int i = 0; i < Synchronizer::OPERATION_COUNT; i++){
+    Synchronizer::Operation operation = (Synchronizer::Operation) i;
+    const LatencyHistogram& latency = synchronizer.getLatency(operation);
+    of << p.toString() << "," << p.I << "," << core->countTokens() << "," << p.C << "," << 
+      Synchronizer::operationName(operation) << "," << latency.count() << "," << latency.percentile(0.5) << "," << 
+      latency.percentile(0.9) << "," << latency.percentile(0.99) << "," << latency.max() << std::endl;
+  }
+}
+
+/**
+ * @brief Synchronizer microbenchmark. A single reactor problem is generated for each size, in timelines, tokens per
+ * timeline and connectivity. The agent is run first, which grows the plan and measures synchronization as it happens on
+ * each tick. Then the database of the final tick is repaired, i.e. relaxed and resolved, for the given number of
+ * iterations. Latencies in microseconds go to s.synch.stats, one row per problem and operation.
+ */
+void synchronizerBenchmark(unsigned int iterations){
+  std::ofstream of("s.synch.stats");
+  of << "problem,timelines,tokens,constraints,operation,count,p50,p90,p99,max" << std::endl;
+
+  for(unsigned int I = 1; I <= 32; I *= 2){
+    // The horizon sets the number of tokens per timeline
+    for(unsigned int H = 10; H <= 160; H *= 4){
+      for(unsigned int C = 0; C < I; C += (I > 4 ? I / 4 : 1)){
+	Problem p(1, 0, 0, I, 0, C, H);
+	makeProblemInstance(p);
+
+	std::ofstream dbgFile("Debug.log");
+	LogManager::instance();
+	TiXmlElement* root = LogManager::initXml(p.toString() + ".cfg");
+	DebugMessage::setStream(dbgFile);
+
+	PseudoClock clk(0.0, 10000);
+	Agent::initialize(*root, clk);
+	Agent::instance()->run();
+
+	const std::vector<TeleoReactorId>& reactors = Agent::instance()->getSortedReactors();
+	for(std::vector<TeleoReactorId>::const_iterator it = reactors.begin(); it != reactors.end(); ++it){
+	  if(!DbCoreId::convertable(*it))
+	    continue;
+
+	  DbCoreId core = (DbCoreId) *it;
+	  for(unsigned int i = 0; i < iterations; i++){
+	    if(!core->repair(false)){
+	      std::cout << p.toString() << ": repair failed after " << i << " iterations" << std::endl;
+	      break;
+	    }
+	  }
+	  writeSynchronizerLatencies(of, p, core);
+	}
+
+	Agent::reset();
+	delete root;
+      }
+    }
+  }
+
+  of.close();
+}
+
+/**
+ * Usage:
+ * - no argument: generate the problems of the current experiment
+ * - exec: run them
+ * - bench [baseline [tolerance]]: sweep the benchmark problems in process, write s.bench.stats and compare with the
+ *   baseline file (s.bench.baseline by default). Exits with a failure status if any problem regressed.
+ * - synch [iterations]: Synchronizer microbenchmark, with 100 repairs per problem by default.
+ */
 int main(int argc, char **argv) {
   initTREX();
   NDDL::loadSchema();
 
+  if(argc > 1 && strcmp(argv[1], "bench") == 0){
+    std::string baselineFile(argc > 2 ? argv[2] : "s.bench.baseline");
+    double tolerance = (argc > 3 ? atof(argv[3]) : 0.2);
+    return (benchmark(baselineFile, tolerance) == 0 ? 0 : 1);
+  }
+
+  if(argc > 1 && strcmp(argv[1], "synch") == 0){
+    synchronizerBenchmark(argc > 2 ? atoi(argv[2]) : 100);
+    return 0;
+  }
+
   bool generateProblem = (argc == 1);
   //experiment1(generateProblem);
   //experiment2(generateProblem);
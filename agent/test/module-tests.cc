@@ -33,16 +33,54 @@
 */
 
 #include "Agent.hh"
+#include "DbCore.hh"
+#include "LogManager.hh"
 #include "Schema.hh"
 #include "Debug.hh"
 #include "Nddl.hh"
 #include "Utilities.hh"
 #include "TestMonitor.hh"
+#include "Checkpoint.hh"
+#include "TickArena.hh"
+#include "TickTrace.hh"
+#include "MissionHistory.hh"
+#include "Domains.hh"
+#include "DataTypes.hh"
+#include "DbWriter.hh"
+#include "ErrnoExcept.hh"
+#include "Functions.hh"
+#include "TelemetryServer.hh"
+#include "BinaryObservationLog.hh"
+#include "SharedVar.hh"
+#include "ObservationInbox.hh"
+#include "ShmRing.hh"
+#include "RemoteReactor.hh"
+#include "XmlStream.hh"
+#include "DeliberationScheduler.hh"
+#include "GoalManager.hh"
+#include "WorkerPool.hh"
+#include "FlatTable.hh"
 #include <pthread.h>
 #include <time.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <cstring>
+#include <climits>
+#include <math.h>
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <map>
+#include <list>
+#include <algorithm>
 
 using namespace EUROPA;
 
@@ -88,11 +126,343 @@ void runAgentWithSchema(const char* configFile, unsigned int stepsPerTick, const
   assertTrue(result, TREX::TestMonitor::toString().c_str());
 }
 
+/**
+ * @return The content of a file, empty if it cannot be read
+ */
+std::string readFile(const std::string& fileName){
+  std::ifstream in(fileName.c_str());
+  std::ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+/**
+ * Run an agent on the pseudo clock as runAgent does, without validating its event log, so that a test can look at the
+ * reactors along the way. The agent is reset on destruction.
+ */
+class AgentRun {
+public:
+  AgentRun(const char* configFile, unsigned int stepsPerTick)
+    : m_clock(1.0, stepsPerTick), m_configPath(findFile(configFile)) {
+    TREX::TestMonitor::reset();
+    Agent::initialize(LogManager::acquireXml(m_configPath), m_clock, 0, true);
+    LogManager::instance().handleInit();
+  }
+
+  ~AgentRun(){
+    Agent::reset();
+    LogManager::releaseXml(m_configPath);
+  }
+
+  /**
+   * @brief Run until the agent reaches the given tick.
+   * @return false if the mission completed first
+   */
+  bool runUntil(TICK tick){
+    while(Agent::instance()->getCurrentTick() < tick){
+      if(Agent::instance()->missionCompleted())
+	return false;
+      Agent::instance()->doNext();
+    }
+    return true;
+  }
+
+  void run(){
+    while(!Agent::instance()->missionCompleted())
+      Agent::instance()->doNext();
+  }
+
+  DbCore& core(const char* reactor) const {
+    DbCore* result = dynamic_cast<DbCore*>((TeleoReactor*) Agent::instance()->getReactor(reactor));
+    assertTrue(result != NULL, (std::string(reactor) + " is not a deliberative reactor").c_str());
+    return *result;
+  }
+
+  /**
+   * @brief The tokens of the plan description of a reactor, internal timelines first.
+   */
+  std::vector<TokenId> tokens(const char* reactor) const {
+    DbCore::PlanDescription plan;
+    core(reactor).getPlanDescription(plan);
+    std::vector<TokenId> result;
+    appendTokens(plan.m_internalTimelines, result);
+    appendTokens(plan.m_externalTimelines, result);
+    return result;
+  }
+
+private:
+  static void appendTokens(const std::vector<DbCore::PlanDescription::TimelineDescription>& timelines, std::vector<TokenId>& result){
+    for(std::vector<DbCore::PlanDescription::TimelineDescription>::const_iterator it = timelines.begin(); it != timelines.end(); ++it)
+      for(std::vector<DbCore::PlanDescription::TokenDescription>::const_iterator t_it = it->tokens.begin(); t_it != it->tokens.end(); ++t_it){
+	EntityId entity = Entity::getEntity(t_it->key);
+	if(entity.isId() && TokenId::convertable(entity))
+	  result.push_back((TokenId) entity);
+      }
+  }
+
+  PseudoClock m_clock;
+  const std::string m_configPath;
+};
+
+/**
+ * A clock which starts a tick as soon as the agent is done with the previous one, except that it moves lag ticks further
+ * when the agent is done with the stalled tick, as if that tick had overrun by lag periods. The time left to a tick is
+ * always timeLeft.
+ */
+class LaggingClock: public Clock {
+public:
+  LaggingClock(TICK stalled, TICK lag, double timeLeft = 0.0)
+    : Clock(1.0, false), m_tick(0), m_stalled(stalled), m_lag(lag), m_timeLeft(timeLeft) {}
+
+  TICK getNextTick(){return m_tick;}
+
+  TICK waitForNextTick(TICK tick){
+    if(m_tick == tick)
+      m_tick = tick + 1 + (tick == m_stalled ? m_lag : 0);
+    return m_tick;
+  }
+
+  double getTimeLeft() const {return m_timeLeft;}
+
+  double getLateness(TICK tick) const {
+    return tick < m_tick ? (m_tick - tick) * getSecondsPerTick() : 0.0;
+  }
+
+protected:
+  void setInitialTick(TICK tick){m_tick = tick;}
+
+private:
+  TICK m_tick;
+  const TICK m_stalled;
+  const TICK m_lag;
+  const double m_timeLeft;
+};
+
+/**
+ * A value which is only consistent if both fields are written together.
+ */
+struct SeqPair {
+  long first;
+  long second;
+};
+
+/**
+ * Stores the values 1 to count in a SeqLockVar, as a driver thread does.
+ */
+class SeqLockWriter: public Thread {
+public:
+  SeqLockWriter(SeqLockVar<SeqPair>& var, long count): m_var(var), m_count(count) {}
+
+protected:
+  void* run(){
+    for(long i = 1; i <= m_count; i++){
+      SeqPair value;
+      value.first = i;
+      value.second = -i;
+      m_var.store(value);
+    }
+    return NULL;
+  }
+
+private:
+  SeqLockVar<SeqPair>& m_var;
+  const long m_count;
+};
+
+/**
+ * Publishes vectors filled with the values 1 to count in an RcuVar.
+ */
+class RcuWriter: public Thread {
+public:
+  RcuWriter(RcuVar< std::vector<long> >& var, long count): m_var(var), m_count(count) {}
+
+protected:
+  void* run(){
+    for(long i = 1; i <= m_count; i++)
+      m_var.store(std::vector<long>(16, i));
+    return NULL;
+  }
+
+private:
+  RcuVar< std::vector<long> >& m_var;
+  const long m_count;
+};
+
+/**
+ * Pushes count observations into an ObservationInbox, as the driver thread of an adapter does. The labels are created
+ * before the thread starts.
+ */
+class InboxWriter: public Thread {
+public:
+  InboxWriter(ObservationInbox& inbox, unsigned int count, const LabelStr& timeline, const LabelStr& predicate)
+    : m_inbox(inbox), m_pushed(count, (Observation*) NULL), m_timeline(timeline), m_predicate(predicate) {}
+
+  /**
+   * @brief The i-th observation pushed, NULL if not pushed yet.
+   */
+  const Observation* pushed(unsigned int i) const {return m_pushed[i];}
+
+protected:
+  void* run(){
+    for(unsigned int i = 0; i < m_pushed.size(); i++){
+      Observation* obs = new ObservationByValue(m_timeline, m_predicate);
+      m_pushed[i] = obs;
+      m_inbox.push(obs);
+    }
+    return NULL;
+  }
+
+private:
+  ObservationInbox& m_inbox;
+  std::vector<Observation*> m_pushed;
+  const LabelStr m_timeline;
+  const LabelStr m_predicate;
+};
+
+/**
+ * Stands for the peer of a RemoteReactor listening on the loopback : connects to the port, sends the magic number
+ * followed by a truncated record and keeps the connection open until destroyed.
+ */
+class RemotePeer: public Thread {
+public:
+  RemotePeer(unsigned short port) : m_port(port), m_socket(-1) {}
+
+  ~RemotePeer(){
+    join();
+    if(m_socket >= 0)
+      close(m_socket);
+  }
+
+  /**
+   * @brief True if the peer connected and sent its records.
+   */
+  bool connected() const {return m_socket >= 0;}
+
+protected:
+  void* run(){
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // The reactor may not be listening yet
+    for(unsigned int attempt = 0; attempt < 100; attempt++){
+      int fd = socket(AF_INET, SOCK_STREAM, 0);
+      if(fd >= 0 && connect(fd, (sockaddr*) &addr, sizeof(addr)) == 0){
+        std::string records(BinaryObservationLog::magic(), 8);
+        uint32_t len = 2;
+        records += 'O';
+        records.append((const char*) &len, sizeof(len));
+        records += "xx";
+        if(write(fd, records.data(), records.size()) == (ssize_t) records.size())
+          m_socket = fd;
+        else
+          close(fd);
+        return NULL;
+      }
+      if(fd >= 0)
+        close(fd);
+      usleep(100000);
+    }
+    return NULL;
+  }
+
+private:
+  const unsigned short m_port;
+  int m_socket;
+};
+
+/**
+ * Records the events of an XmlStreamReader as a string, and suspends the parsing at the end of the elements named
+ * suspendOn.
+ */
+class XmlRecorder: public XmlStreamReader::Handler {
+public:
+  XmlRecorder(const std::string& suspendOn = "") : m_parser(NULL), m_suspendOn(suspendOn) {}
+
+  void startElement(const std::string& name, const XmlStreamReader::Attributes& attrs, unsigned int depth){
+    events += "<" + name;
+    for(XmlStreamReader::Attributes::const_iterator it = attrs.begin(); it != attrs.end(); ++it)
+      events += " " + it->first + "=" + it->second;
+    events += ">";
+  }
+
+  void endElement(const std::string& name, unsigned int depth){
+    events += "</" + name + ">";
+    if(m_parser != NULL && name == m_suspendOn)
+      m_parser->suspend();
+  }
+
+  void setParser(XmlStreamReader& parser){m_parser = &parser;}
+
+  std::string events;
+
+private:
+  XmlStreamReader* m_parser;
+  const std::string m_suspendOn;
+};
+
+/**
+ * A reactor which always has work, or never, for the deliberation scheduler tests. It must be deleted while an agent
+ * is alive.
+ */
+class BusyReactor: public TeleoReactor {
+public:
+  BusyReactor(const char* name, TICK lookAhead, TICK latency, bool busy)
+    : TeleoReactor(Agent::instance()->getName(), LabelStr(name), lookAhead, latency, false), m_busy(busy) {}
+
+  bool hasWork() {return m_busy;}
+
+  void resume() {}
+
+private:
+  const bool m_busy;
+};
+
+/**
+ * One search of a multi start, run by a WorkerPool.
+ */
+class OrienteeringRun: public WorkerPool::Job {
+public:
+  OrienteeringRun(const OrienteeringProblem& problem, unsigned int seed, const OrienteeringSearch::SEQUENCE& initial)
+    : m_search(problem, seed), m_initial(initial) {}
+
+  void execute() {m_search.run(m_initial);}
+
+  const OrienteeringSearch& getSearch() const {return m_search;}
+
+private:
+  OrienteeringSearch m_search;
+  const OrienteeringSearch::SEQUENCE& m_initial;
+};
+
 class GamePlayTests {
 public:
   static bool test(){ 
     runTest(testActionAdapter);
     runTest(testDispatch);
+    runTest(testDependencyGraph);
+    runTest(testDeliberationScheduler);
+    runTest(testBackgroundDeliberation);
+    runTest(testOverrunPolicies);
+    runTest(testResumeBudget);
+    runTest(testExecutionFrontier);
+    runTest(testTimelineValues);
+    runTest(testPendingPredecessors);
+    runTest(testObservationRouting);
+    runTest(testObservationBatch);
+    runTest(testRequestBatch);
+    runTest(testRecallBatch);
+    runTest(testPublication);
+    runTest(testForeignKeyTable);
+    runTest(testConfirmedObservation);
+    runTest(testShmAdapter);
+    runTest(testRemoteReactor);
+    runTest(testDeliberationHorizon);
+    runTest(testDeliberationVerdicts);
+    runTest(testPendingPropagation);
+    runTest(testSolverRoundRobin);
     runTest(testSqueezeObserver);
     runTest(testSimulation);
     runTest(testUndefinedSingleTimeline);
@@ -100,12 +470,29 @@ public:
     runTest(testPersonalRobots);
     runTest(testSynch);
     runTest(testExtensions);
+    runTest(testBoundedArchiving);
+    runTest(testArchivingBudget);
+    runTest(testExecutionFunctionClock);
     runTest(testRecall);
     runTest(testRepair);
+    runTest(testIncrementalValidation);
+    runTest(testPlanReuse);
+    runTest(testPlanCache);
     runTest(testLogging);
+    runTest(testQuietReactor);
+    runTest(testAsyncPlanWorks);
+    runTest(testStateDeltas);
+    runTest(testPlanDeltas);
+    runTest(testInputTrace);
+    runTest(testPlanHistory);
     runTest(testPersistence);
+    runTest(testRestore);
     runTest(testSimulationWithPlannerTimeouts);
     runTest(testScalability);
+    runTest(testScalabilityData);
+    runTest(testSynchronizerLatencies);
+    runTest(testLatencyDumps);
+    runTest(testRepairFallback);
     runTest(testTestMonitor);
     runTest(testActions);
     runTest(bugFixes); 
@@ -136,12 +523,365 @@ private:
     return true;
   }
 
+  /**
+   * Deferring the termination and the garbage collection of past tokens must not change the outcome.
+   */
+  static bool testBoundedArchiving(){
+    runAgentWithSchema("extensions.0.archive.cfg", 50, "extensions.0");
+    return true;
+  }
+
+  /**
+   * Over its entity budget, a reactor archives without the batch and threshold limits. The outcome is the same, and it
+   * holds no more tokens than with bounded archiving.
+   */
+  static bool testArchivingBudget(){
+    runAgentWithSchema("extensions.0.budget.cfg", 50, "extensions.0");
+
+    MemoryUsage bounded, budgeted;
+    {
+      AgentRun run("extensions.0.archive.cfg", 50);
+      assertTrue(run.runUntil(30));
+      bounded = run.core("exec").getMemoryUsage();
+    }
+    {
+      AgentRun run("extensions.0.budget.cfg", 50);
+      assertTrue(run.runUntil(30));
+      budgeted = run.core("exec").getMemoryUsage();
+    }
+    assertTrue(budgeted.tokens > 0 && budgeted.tokens <= bounded.tokens);
+    assertTrue(budgeted.entities == budgeted.tokens + budgeted.variables + budgeted.constraints);
+    return true;
+  }
+
+  /**
+   * The playback has nothing to do between its logged observations : it is quiet until the next one, and active again
+   * at the end of its log so that it can terminate the agent.
+   */
+  static bool testQuietReactor(){
+    AgentRun run("quiet.0.cfg", 50);
+    TeleoReactor* playback = (TeleoReactor*) Agent::instance()->getReactor("playback");
+
+    assertTrue(run.runUntil(1));
+    assertTrue(playback->nextActiveTick() == 3);
+    assertTrue(playback->isQuiet(1) && playback->isQuiet(2) && !playback->isQuiet(3));
+
+    // A request wakes it up
+    TokenId goal = run.core("client").getAssembly().getPlanDatabase()->getClient()->createToken("LogTesting.Holds", NULL, true);
+    playback->request(goal);
+    assertTrue(!playback->isQuiet(1));
+    run.core("client").getAssembly().getPlanDatabase()->getClient()->deleteToken(goal);
+
+    assertTrue(run.runUntil(4));
+    assertTrue(!playback->isQuiet(4));
+    return true;
+  }
+
+  /**
+   * Execution functions never ignore changes to the token they watch, and ignore the clock once their result is set.
+   */
+  static bool testExecutionFunctionClock(){
+    AgentRun run("extensions.0.cfg", 50);
+    assertTrue(run.runUntil(5));
+
+    unsigned int functions = 0;
+    const ConstraintSet& constraints = run.core("exec").getAssembly().getConstraintEngine()->getConstraints();
+    for(ConstraintSet::const_iterator it = constraints.begin(); it != constraints.end(); ++it){
+      ConstraintId constraint = *it;
+      if(dynamic_cast<ExecutionFunction*>((Constraint*) constraint) == NULL)
+	continue;
+      functions++;
+
+      const std::vector<ConstrainedVariableId>& scope = constraint->getScope();
+      assertTrue(!constraint->canIgnore(scope[2], 2, DomainListener::RESTRICT_TO_SINGLETON));
+      assertTrue(!constraint->canIgnore(scope[3], 3, DomainListener::UPPER_BOUND_DECREASED));
+      if(scope[0]->lastDomain().isSingleton())
+	assertTrue(constraint->canIgnore(scope[1], 1, DomainListener::LOWER_BOUND_INCREASED));
+    }
+    assertTrue(functions > 0);
+    return true;
+  }
+
   static bool testLogging(){
     runAgentWithSchema("LogWriting.cfg", 50, "LogWriting");
     runAgentWithSchema("LogReading.cfg", 50, "LogReading");
     return true;
   }
+
+  /**
+   * With a single pending step, each write waits for the writer thread. All the steps must be on disk once the
+   * writer is destroyed, and their statistics rows appended in order.
+   */
+  static bool testAsyncPlanWorks(){
+    AgentRun run("dispatch.0.cfg", 50);
+    run.runUntil(2);
+
+    const std::string agentName = Agent::instance()->getName().toString();
+    const std::string dir = LogManager::instance().reactor_dir_path(agentName, "asyncWriter", "plans");
+    const TICK tick = Agent::instance()->getCurrentTick();
+    const unsigned int steps = 5;
+    {
+      Assembly& assembly = run.core("dispatcher").getAssembly();
+      DbWriter writer(agentName, "asyncWriter", assembly.getPlanDatabase(), assembly.getConstraintEngine(), assembly.getRulesEngine());
+      writer.setAsync(1);
+      for(unsigned int attempt = 0; attempt < steps; attempt++)
+	writer.write(tick, attempt);
+    }
+
+    for(unsigned int attempt = 0; attempt < steps; attempt++){
+      std::ostringstream step;
+      step << dir << "/" << tick << "." << attempt << ".plan/plan";
+      assertTrue(!readFile(step.str() + ".partialPlan").empty(), step.str().c_str());
+      assertTrue(!readFile(step.str() + ".tokens").empty(), step.str().c_str());
+    }
+
+    std::istringstream stats(readFile(dir + "/partialPlanStats"));
+    std::string row;
+    for(unsigned int i = 0; i < steps; i++){
+      assertTrue(std::getline(stats, row));
+      std::istringstream columns(row);
+      long long int seqId, ppId;
+      unsigned int stepCount;
+      columns >> seqId >> ppId >> stepCount;
+      assertTrue(stepCount == i);
+    }
+    assertTrue(!std::getline(stats, row));
+    return true;
+  }
+
+  /**
+   * One reactor state dump in 3 is a full one. A conflict dump is always full, leaves the delta of the nominal dump
+   * of the same attempt in place and starts a new keyframe period.
+   */
+  static bool testStateDeltas(){
+    AgentRun run("dispatch.0.state.cfg", 50);
+    DbCore& dispatcher = run.core("dispatcher");
+    const std::string dir = LogManager::instance().reactor_dir_path(Agent::instance()->getName().toString(), "dispatcher", "reactor_states");
+
+    std::vector<std::string> dumps;
+    for(TICK tick = 1; tick <= 3; tick++){
+      assertTrue(run.runUntil(tick));
+      dispatcher.dumpState(false);
+      std::ostringstream name;
+      name << dir << "/" << Agent::instance()->getCurrentTick() << "." << Agent::instance()->getCurrentAttempt();
+      dumps.push_back(name.str());
+    }
+    assertTrue(!readFile(dumps[0] + ".reactorstate").empty());
+    assertTrue(readFile(dumps[1] + ".reactorstate").empty() && readFile(dumps[2] + ".reactorstate").empty());
+
+    // A conflict at the same attempt adds a full state next to the nominal delta
+    const std::string delta = readFile(dumps[2] + ".reactordelta");
+    dispatcher.dumpState(true);
+    assertTrue(!readFile(dumps[2] + ".reactorstate").empty());
+    assertTrue(readFile(dumps[2] + ".reactordelta") == delta);
+
+    // The next dump is relative to the conflict dump
+    assertTrue(run.runUntil(4));
+    std::ostringstream next;
+    next << dir << "/" << Agent::instance()->getCurrentTick() << "." << Agent::instance()->getCurrentAttempt();
+    dispatcher.dumpState(false);
+    assertTrue(readFile(next.str() + ".reactorstate").empty());
+    std::ifstream nextDelta((next.str() + ".reactordelta").c_str());
+    assertTrue(nextDelta.good());
+    return true;
+  }
   
+  /**
+   * Applying a delta to the tokens of the previous one gives the full plan. The pushed file starts with a full delta and
+   * gets one delta per synchronization that changed the plan.
+   */
+  static bool testPlanDeltas(){
+    AgentRun run("dispatch.0.deltas.cfg", 50);
+    DbCore& dispatcher = run.core("dispatcher");
+    assertTrue(run.runUntil(2));
+
+    DbCore::PlanDelta delta;
+    dispatcher.getPlanDelta(0, delta);
+    assertTrue(delta.m_full && delta.m_removed.empty());
+    std::map<int, DbCore::PlanDelta::TokenUpdate> tokens;
+    for(std::vector<DbCore::PlanDelta::TokenUpdate>::const_iterator it = delta.m_updates.begin(); it != delta.m_updates.end(); ++it)
+      tokens[it->token.key] = *it;
+
+    // Nothing changed since
+    unsigned int version = delta.m_version;
+    dispatcher.getPlanDelta(version, delta);
+    assertTrue(!delta.m_full && delta.m_version == version && delta.m_updates.empty() && delta.m_removed.empty());
+
+    for(TICK tick = 3; tick <= 5; tick++){
+      assertTrue(run.runUntil(tick));
+      dispatcher.getPlanDelta(version, delta);
+      assertTrue(!delta.m_full);
+      version = delta.m_version;
+      for(std::vector<DbCore::PlanDelta::TokenUpdate>::const_iterator it = delta.m_updates.begin(); it != delta.m_updates.end(); ++it)
+	tokens[it->token.key] = *it;
+      for(std::vector<int>::const_iterator it = delta.m_removed.begin(); it != delta.m_removed.end(); ++it){
+	// A token added and removed since the previous delta is only reported as removed
+	tokens.erase(*it);
+	EntityId entity = Entity::getEntity(*it);
+	assertTrue(entity.isNoId() || !((TokenId) entity)->isActive() || !((TokenId) entity)->getObject()->lastDomain().isSingleton());
+      }
+
+      DbCore::PlanDelta full;
+      dispatcher.getPlanDelta(0, full);
+      assertTrue(full.m_version == version && full.m_updates.size() == tokens.size());
+      for(std::vector<DbCore::PlanDelta::TokenUpdate>::const_iterator it = full.m_updates.begin(); it != full.m_updates.end(); ++it){
+	std::map<int, DbCore::PlanDelta::TokenUpdate>::const_iterator known = tokens.find(it->token.key);
+	assertTrue(known != tokens.end());
+	assertTrue(known->second.timeline == it->timeline && known->second.token.name == it->token.name);
+	assertTrue(known->second.token.start[0] == it->token.start[0] && known->second.token.start[1] == it->token.start[1]);
+	assertTrue(known->second.token.end[0] == it->token.end[0] && known->second.token.end[1] == it->token.end[1]);
+      }
+    }
+
+    // The pushed deltas
+    const std::string path = LogManager::instance().reactor_file_path(Agent::instance()->getName().toString(), "dispatcher", "plan.deltas");
+    std::istringstream pushed(readFile(path));
+    std::string row;
+    assertTrue(std::getline(pushed, row));
+    assertTrue(row.find("\tdispatcher\t") != std::string::npos && row[row.size() - 1] == 'F', row.c_str());
+    unsigned int headers = 1;
+    while(std::getline(pushed, row)){
+      std::istringstream columns(row);
+      TICK tick;
+      std::string name;
+      unsigned int rowVersion;
+      char kind;
+      if(columns >> tick >> name >> rowVersion >> kind && name == "dispatcher"){
+	assertTrue(kind == 'D' && rowVersion <= version, row.c_str());
+	headers++;
+      }
+    }
+    assertTrue(headers > 1);
+    return true;
+  }
+
+  /**
+   * The history gets each token which leaves the database, even when the garbage collection runs before the
+   * window is over, and each committed token which ended before the window, only once.
+   */
+  static bool testPlanHistory(){
+    std::string creatorHistory, reciverHistory;
+    {
+      AgentRun run("dispatch.0.history.cfg", 50);
+      const std::string agent = Agent::instance()->getName().toString();
+      creatorHistory = LogManager::instance().reactor_file_path(agent, "creator", "plan.history");
+      reciverHistory = LogManager::instance().reactor_file_path(agent, "reciver", "plan.history");
+      run.run();
+    }
+
+    const std::string files[] = {creatorHistory, reciverHistory};
+    for(unsigned int i = 0; i < 2; i++){
+      assertTrue(countRecords(files[i], false, 'H') == 0);
+      BinaryObservationReader reader(files[i], true);
+      BinaryObservationLog::Record rec;
+      TICK tick;
+      std::set<int> keys;
+      while(reader.peek(tick)){
+	reader.next(rec);
+	assertTrue(rec.kind == 'H', files[i].c_str());
+	assertTrue(keys.insert(rec.key).second, rec.predicate.c_str());
+	assertTrue(rec.parameters.size() >= 3 && rec.parameters.back().first == "duration");
+      }
+      assertTrue(i != 0 || !keys.empty());
+    }
+    return true;
+  }
+
+  /**
+   * The reciver only receives requests and the dispatcher only observations. Requests and recalls are only read back
+   * when asked for.
+   */
+  static bool testInputTrace(){
+    std::string reciverTrace, dispatcherTrace;
+    {
+      AgentRun run("dispatch.0.trace.cfg", 50);
+      const std::string agent = Agent::instance()->getName().toString();
+      reciverTrace = LogManager::instance().reactor_file_path(agent, "reciver", "inputs.trace");
+      dispatcherTrace = LogManager::instance().reactor_file_path(agent, "dispatcher", "inputs.trace");
+      run.run();
+    }
+
+    // The traces are closed with their reactor
+    assertTrue(countRecords(reciverTrace, true, 'G') > 0);
+    assertTrue(countRecords(reciverTrace, true, 'O') == 0);
+    assertTrue(countRecords(reciverTrace, false, 'G') == 0);
+    assertTrue(countRecords(dispatcherTrace, true, 'O') > 0);
+    assertTrue(countRecords(dispatcherTrace, false, 'O') == countRecords(dispatcherTrace, true, 'O'));
+
+    BinaryObservationReader reader(reciverTrace, true);
+    BinaryObservationLog::Record rec;
+    TICK tick;
+    while(reader.peek(tick)){
+      reader.next(rec);
+      if(rec.kind == 'G'){
+	assertTrue(rec.timeline == "rt" && rec.predicate == "ReciverTimeline.Beta", rec.predicate.c_str());
+	assertTrue(rec.parameters.size() >= 3 && rec.parameters.back().first == "duration");
+	assertTrue(rec.parameters[rec.parameters.size() - 3].first == "start");
+      }
+    }
+
+    // A goal which does not fit the model is left out of the database
+    AgentRun run("dispatch.0.cfg", 50);
+    const PlanDatabaseId& db = run.core("reciver").getAssembly().getPlanDatabase();
+    const unsigned int tokenCount = db->getTokens().size();
+    BinaryObservationDecoder decoder;
+    BinaryObservationLog::Record goal;
+    goal.kind = 'G';
+    goal.key = 1;
+    goal.timeline = "rt";
+    goal.predicate = "ReciverTimeline.Beta";
+    BinaryObservationLog::Domain start;
+    start.kind = 'i';
+    start.type = "int";
+    start.values.resize(2);
+    start.values[0].kind = start.values[1].kind = 'n';
+    start.values[0].number = 6;
+    start.values[1].number = 20;
+    goal.parameters.push_back(std::make_pair(std::string("start"), start));
+
+    TokenId token = decoder.asGoal(goal, db->getClient());
+    assertTrue(token->start()->baseDomain().getLowerBound() == 6);
+    db->getClient()->deleteToken(token);
+    assertTrue(db->getTokens().size() == tokenCount);
+
+    goal.parameters.push_back(std::make_pair(std::string("noSuchVariable"), start));
+    assertTrue(!decodesGoal(decoder, goal, db->getClient()));
+    assertTrue(db->getTokens().size() == tokenCount);
+
+    goal.parameters.pop_back();
+    goal.timeline = "noSuchTimeline";
+    assertTrue(!decodesGoal(decoder, goal, db->getClient()));
+    assertTrue(db->getTokens().size() == tokenCount);
+    return true;
+  }
+
+  static unsigned int countRecords(const std::string& path, bool allRecords, char kind){
+    BinaryObservationReader reader(path, allRecords);
+    BinaryObservationLog::Record rec;
+    TICK tick;
+    unsigned int count = 0;
+    while(reader.peek(tick)){
+      reader.next(rec);
+      if(rec.kind == kind)
+	count++;
+    }
+    return count;
+  }
+
+  /**
+   * @return false if the goal is rejected as a configuration error
+   */
+  static bool decodesGoal(BinaryObservationDecoder& decoder, const BinaryObservationLog::Record& rec, const DbClientId& client){
+    try {
+      client->deleteToken(decoder.asGoal(rec, client));
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return false;
+    }
+    return true;
+  }
+
   static bool testFileSearch(){
     setenv("TREX_START_DIR", "search_tests/a", 1);
     runAgentWithSchema("st.cfg", 50, "search_test.0");
@@ -169,6 +909,85 @@ private:
     return true;
   }
 
+  /**
+   * The scaling benchmark of the problem generator reads the timings of each tick from the performance monitor.
+   * There must be a sample for each tick run, none of them negative.
+   */
+  static bool testScalabilityData(){
+    AgentRun run("synchronize.cfg", 50);
+    run.run();
+    const std::vector< std::pair<timeval, timeval> >& data = Agent::instance()->getMonitor().getData();
+    assertTrue(!data.empty() && data.size() <= Agent::instance()->getFinalTick() + 1);
+    for(std::vector< std::pair<timeval, timeval> >::const_iterator it = data.begin(); it != data.end(); ++it)
+      assertTrue(it->first.tv_sec >= 0 && it->first.tv_usec >= 0 && it->second.tv_sec >= 0 && it->second.tv_usec >= 0);
+    return true;
+  }
+
+  /**
+   * Each operation of the synchronizer is timed, including when a repair is driven directly as the synchronizer
+   * microbenchmark does.
+   */
+  static bool testSynchronizerLatencies(){
+    AgentRun run("synchronize.cfg", 50);
+    assertTrue(run.runUntil(10));
+    DbCore& core = run.core("r.0.0");
+    const Synchronizer& synchronizer = core.getSynchronizer();
+    assertTrue(synchronizer.getLatency(Synchronizer::RESOLVE).count() > 0);
+
+    const unsigned long resolved = synchronizer.getLatency(Synchronizer::RESOLVE).count();
+    const unsigned long relaxed = synchronizer.getLatency(Synchronizer::RELAX).count();
+    assertTrue(core.repair(true));
+    assertTrue(synchronizer.getLatency(Synchronizer::RELAX).count() > relaxed);
+    assertTrue(synchronizer.getLatency(Synchronizer::RESOLVE).count() > resolved);
+
+    const LatencyHistogram& latency = synchronizer.getLatency(Synchronizer::RESOLVE);
+    assertTrue(latency.percentile(0.5) <= latency.percentile(0.99));
+    return true;
+  }
+
+  /**
+   * Without a token which failed to resolve there is no neighbourhood to relax, and a repair goes straight to the global
+   * relaxation. The plan must still be resolved, and synchronization must carry on from it.
+   */
+  /**
+   * Every latencyDumpPeriod ticks the agent writes its lateness and jitter, then each phase of every reactor.
+   */
+  static bool testLatencyDumps(){
+    runAgentWithSchema("dispatch.0.latency.cfg", 50, "dispatch.0");
+    std::istringstream dumps(readFile(LogManager::instance().file_name("latency.log")));
+    std::string line;
+    unsigned int lines = 0, synchronized = 0;
+    while(std::getline(dumps, line)){
+      const char* values = strstr(line.c_str(), " count=");
+      unsigned long count, p50, p99, max;
+      assertTrue(values != NULL && sscanf(values, " count=%lu p50=%lu p99=%lu max=%lu", &count, &p50, &p99, &max) == 4,
+		 line.c_str());
+      assertTrue(p50 <= p99 && p99 <= max, line.c_str());
+      if(line.find(" creator synchronize ") != std::string::npos && count > 0)
+	synchronized++;
+      lines++;
+    }
+
+    // Dumped on ticks 1, 3, 5, 7 and 9 : 2 agent lines and 5 phases for each of the 3 reactors
+    const unsigned int linesPerDump = 2 + 3 * PerformanceMonitor::PHASE_COUNT;
+    assertTrue(lines % linesPerDump == 0 && lines / linesPerDump >= 4);
+    assertTrue(readFile(LogManager::instance().file_name("latency.log")).compare(0, 17, "1 agent lateness ") == 0);
+    assertTrue(synchronized == lines / linesPerDump);
+    return true;
+  }
+
+  static bool testRepairFallback(){
+    AgentRun run("synchronize.cfg", 50);
+    assertTrue(run.runUntil(10));
+    DbCore& core = run.core("r.0.0");
+    const unsigned long relaxed = core.getSynchronizer().getLatency(Synchronizer::RELAX).count();
+    assertTrue(core.repair(false));
+    assertTrue(core.getSynchronizer().getLatency(Synchronizer::RELAX).count() == relaxed + 1);
+    assertTrue(!run.tokens("r.0.0").empty());
+    assertTrue(run.runUntil(20));
+    return true;
+  }
+
   static bool testSynch(){
     runAgentWithSchema("synch.4.cfg", 50, "synch.4");
     runAgentWithSchema("synch.3.cfg", 50, "synch.3");
@@ -222,20 +1041,140 @@ private:
   }
 
   /**
-   * @brief Set up 2 reactors planning the same timeline at different lookaheads.
+   * Each reactor owns its deliberation horizon, and the filter of its solver reads that one. A reactor that has
+   * deliberated holds a horizon as wide as its own lookahead.
    */
-  static bool testSqueezeObserver(){
-    runAgentWithSchema("SqueezeObserver.cfg", 15, "SqueezeObserver");
+  static bool testDeliberationHorizon(){
+    AgentRun run("dispatch.0.horizon.cfg", 50);
+    run.runUntil(3);
+
+    const char* reactors[] = {"creator", "reciver", "dispatcher"};
+    unsigned int deliberated = 0;
+    for(unsigned int i = 0; i < 3; i++){
+      DbCore& core = run.core(reactors[i]);
+      const IntervalIntDomain& horizon = core.getDeliberationHorizon();
+      assertTrue(&DeliberationFilter::getHorizon(core.getAssembly().getPlanDatabase()) == &horizon);
+      if(horizon.isFinite()){
+	assertTrue(horizon.getLowerBound() >= 1);
+	assertTrue(horizon.getUpperBound() - horizon.getLowerBound() == core.getLookAhead(), reactors[i]);
+	deliberated++;
+      }
+    }
+    assertTrue(deliberated > 0);
     return true;
   }
 
   /**
-   * @brief Tests the recall functionality to force dispatch of recall commands based on detected plan failure.
-   * Set up a 3 reactor system. 2 of them are deliberative reactors, one is an adapter. There are 3 timelines: a, b, c. The adapter manages
-   * c. Reactor A owns a and uses c and b. Reactor B owns b. A will dispacth requests to B and C. B and C will dispatch observations to A. C will
-   * generate observation values as a function of the current tick. This will conflict with planned values, causing re-planning each time.
-   * 
-   * Expectations in event log:
+   * The verdict of the deliberation filter on a token is kept while its temporal scope is unchanged, and computed
+   * again once the scope moves out of the horizon.
+   */
+  static bool testDeliberationVerdicts(){
+    AgentRun run("dispatch.0.horizon.cfg", 50);
+    assertTrue(run.runUntil(3));
+    DbCore& core = run.core("reciver");
+    const IntervalIntDomain& horizon = core.getDeliberationHorizon();
+    assertTrue(horizon.isFinite());
+
+    TiXmlElement config("FlawFilter");
+    config.SetAttribute("component", "DeliberationFilter");
+    DeliberationFilter filter(config);
+
+    DbClientId client = core.getAssembly().getPlanDatabase()->getClient();
+    TokenId goal = client->createToken("ReciverTimeline.Beta", NULL, true);
+    goal->getObject()->specify(client->getObject("rt"));
+
+    // Starts within the horizon
+    client->specify(goal->start(), horizon.getLowerBound());
+    assertTrue(client->propagate());
+    assertTrue(!filter.test(goal));
+    assertTrue(!filter.test(goal));
+
+    // Starts at the end of the horizon
+    client->reset(goal->start());
+    client->specify(goal->start(), horizon.getUpperBound());
+    assertTrue(client->propagate());
+    assertTrue(filter.test(goal));
+    assertTrue(filter.test(goal));
+
+    client->deleteToken(goal);
+    return true;
+  }
+
+  /**
+   * Propagation is skipped only when nothing is pending : a restriction made between ticks is still propagated at the
+   * next tick start.
+   */
+  static bool testPendingPropagation(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(2));
+    const ConstraintEngineId& ce = run.core("reciver").getAssembly().getConstraintEngine();
+    assertTrue(ce->constraintConsistent());
+
+    DbClientId client = run.core("reciver").getAssembly().getPlanDatabase()->getClient();
+    TokenId goal = client->createToken("ReciverTimeline.Beta", NULL, true);
+    const int key = goal->getKey();
+    client->specify(goal->start(), 6);
+    assertTrue(!ce->constraintConsistent());
+
+    assertTrue(run.runUntil(3));
+    assertTrue(ce->constraintConsistent());
+    EntityId entity = Entity::getEntity(key);
+    if(entity.isId())
+      assertTrue(((TokenId) entity)->end()->lastDomain().getLowerBound() >= 6);
+    return true;
+  }
+
+  /**
+   * The budget of the round robin members doubles after each round up to roundRobinMaxSteps, without wrapping around.
+   */
+  static bool testSolverRoundRobin(){
+    assertTrue(DbSolver::nextBudget(2, 8) == 4);
+    assertTrue(DbSolver::nextBudget(4, 8) == 8);
+    assertTrue(DbSolver::nextBudget(5, 8) == 8);
+    assertTrue(DbSolver::nextBudget(8, 8) == 8);
+    assertTrue(DbSolver::nextBudget(UINT_MAX / 2 + 1, UINT_MAX) == UINT_MAX);
+
+    AgentRun run("dispatch.0.roundRobinSolver.cfg", 50);
+    assertTrue(run.runUntil(10));
+    const char* reactors[] = {"creator", "reciver", "dispatcher"};
+    for(unsigned int i = 0; i < 3; i++){
+      const unsigned int budget = run.core(reactors[i]).getSolver()->getBudget();
+      assertTrue(budget >= 2 && budget <= 8, reactors[i]);
+    }
+
+    // The largest budget cannot be below the initial one
+    TiXmlElement config("Solver");
+    config.SetAttribute("name", "BadRoundRobin");
+    config.SetAttribute("roundRobin", "true");
+    config.SetAttribute("roundRobinSteps", "8");
+    config.SetAttribute("roundRobinMaxSteps", "4");
+    bool failed = false;
+    try {
+      DbSolver solver(run.core("reciver").getAssembly().getPlanDatabase(), &config);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      failed = true;
+    }
+    assertTrue(failed);
+    return true;
+  }
+
+  /**
+   * @brief Set up 2 reactors planning the same timeline at different lookaheads.
+   */
+  static bool testSqueezeObserver(){
+    runAgentWithSchema("SqueezeObserver.cfg", 15, "SqueezeObserver");
+    return true;
+  }
+
+  /**
+   * @brief Tests the recall functionality to force dispatch of recall commands based on detected plan failure.
+   * Set up a 3 reactor system. 2 of them are deliberative reactors, one is an adapter. There are 3 timelines: a, b, c. The adapter manages
+   * c. Reactor A owns a and uses c and b. Reactor B owns b. A will dispacth requests to B and C. B and C will dispatch observations to A. C will
+   * generate observation values as a function of the current tick. This will conflict with planned values, causing re-planning each time.
+   * 
+   * Expectations in event log:
    * 1. Initial plan will dispatch 2 requests from A to B and 3 requests from A to C. More are dispatched to the latter because C has zero latency.
    * 2. Notifications are send from C to A and from B to A. Neither C nor B receive notifications.
    * 3. Expect the notification from C at tick 2 to force a recall. The event pattern should reflect that of the requests.
@@ -262,6 +1201,43 @@ private:
   /**
    * Ensure execution fills out gaps in a single internal timeline
    */
+  /**
+   * An agent stopped after a checkpoint and restored from it starts at the following tick, with the saved values of
+   * its internal timelines, and completes the mission.
+   */
+  static bool testRestore(){
+    Checkpoint saved;
+    {
+      AgentRun run("dispatch.0.checkpoint.cfg", 50);
+      assertTrue(run.runUntil(7));
+      saved.read(LogManager::instance().file_name("agent.checkpoint"));
+    }
+    assertTrue(saved.tick == 4 && saved.reactors.size() == 3);
+    saved.write("dispatch.0.restore.checkpoint");
+
+    AgentRun run("dispatch.0.restore.cfg", 50);
+    assertTrue(Agent::instance()->getCurrentTick() == saved.tick + 1);
+    unsigned int restored = 0;
+    for(std::vector<Checkpoint::Reactor>::const_iterator it = saved.reactors.begin(); it != saved.reactors.end(); ++it){
+      const std::vector<TokenId> tokens = run.tokens(it->name.c_str());
+      for(std::vector<Checkpoint::Token>::const_iterator t_it = it->tokens.begin(); t_it != it->tokens.end(); ++t_it){
+	if(t_it->role != 'i')
+	  continue;
+	bool found = false;
+	for(std::vector<TokenId>::const_iterator v_it = tokens.begin(); !found && v_it != tokens.end(); ++v_it)
+	  found = ((*v_it)->getPredicateName().toString() == t_it->predicate);
+	assertTrue(found, t_it->predicate.c_str());
+	restored++;
+      }
+    }
+    assertTrue(restored > 0);
+
+    run.run();
+    assertTrue(Agent::instance()->getCurrentTick() >= 10);
+    assertTrue(TestMonitor::success(), TestMonitor::toString().c_str());
+    return true;
+  }
+
   static bool testUndefinedSingleTimeline(){
     runAgentWithSchema("Undefined.SingleTimeline.cfg", 20, "Undefined.SingleTimeline");
     return true;
@@ -307,6 +1283,41 @@ private:
     return true;
   }
 
+  /**
+   * Checking only the new tokens between full checks of the database must not change the outcome.
+   */
+  static bool testIncrementalValidation(){
+    runAgentWithSchema("repair.3.validation.cfg", 50, "repair.3");
+    return true;
+  }
+
+  /**
+   * Starting deliberation after a repair from the last complete plan must not change the outcome.
+   */
+  static bool testPlanReuse(){
+    runAgentWithSchema("repair.3.reuse.cfg", 50, "repair.3");
+    return true;
+  }
+
+  /**
+   * Skipping the planning cycles where only the clock advanced must not change the outcome. The client of quiet.0 has
+   * nothing to plan while the playback reactor is quiet, and only skips cycles when the plan cache is on.
+   */
+  static bool testPlanCache(){
+    runAgentWithSchema("dispatch.0.cache.cfg", 50, "dispatch.0");
+
+    {
+      AgentRun run("quiet.0.cfg", 50);
+      assertTrue(run.runUntil(3));
+      assertTrue(run.core("client").getCachedCycles() == 0);
+    }
+
+    AgentRun run("quiet.0.cache.cfg", 50);
+    assertTrue(run.runUntil(3));
+    assertTrue(run.core("client").getCachedCycles() > 0);
+    return true;
+  }
+
   /**
    * Tests dispatching.
    */
@@ -317,6 +1328,581 @@ private:
     return true;
   }
 
+  /**
+   * Each policy hands out the steps of reactors which always have work in its own order, and stops at maxSteps.
+   * Reactors without work or without lookAhead are never selected. The policies do not change the outcome of dispatch.0.
+   */
+  static bool testDeliberationScheduler(){
+    {
+      AgentRun run("dispatch.0.cfg", 50);
+      BusyReactor a("a", 10, 2, true), b("b", 5, 1, true), c("c", 1, 1, true), idle("idle", 10, 0, false), blind("blind", 0, 0, true);
+      std::vector<TeleoReactorId> reactors;
+      reactors.push_back(a.getId());
+      reactors.push_back(b.getId());
+      reactors.push_back(c.getId());
+      reactors.push_back(idle.getId());
+      reactors.push_back(blind.getId());
+
+      assertTrue(schedule(DeliberationScheduler::create("priority"), reactors, 2) == "aabbcc");
+      assertTrue(schedule(DeliberationScheduler::create("roundRobin"), reactors, 2) == "abcabc");
+
+      // Deadlines are the tick plus the latency. b and c tie, and c goes first with its smaller lookAhead.
+      assertTrue(schedule(DeliberationScheduler::create("edf"), reactors, 2) == "ccbbaa");
+
+      // a takes twice the share of the others until it reaches the cap
+      DeliberationScheduler* weighted = DeliberationScheduler::create("weighted");
+      weighted->setWeight(a.getId(), 2);
+      assertTrue(schedule(weighted, reactors, 4) == "abcaabcabcbc");
+    }
+
+    try {
+      DeliberationScheduler::create("lottery");
+      assertTrue(false, "An unknown policy is rejected");
+    }
+    catch(ConfigurationException* e){
+      delete e;
+    }
+
+    runAgentWithSchema("dispatch.0.roundRobin.cfg", 50, "dispatch.0");
+    runAgentWithSchema("dispatch.0.edf.cfg", 50, "dispatch.0");
+    runAgentWithSchema("dispatch.0.weighted.cfg", 50, "dispatch.0");
+    return true;
+  }
+
+  /**
+   * Deliberating on a background thread while the agent thread waits for the clock gives the event log of the inline
+   * run. A pseudo clock would count the waits of the agent thread as steps, so the ticks come from a real time clock.
+   */
+  static bool testBackgroundDeliberation(){
+    RealTimeClock clock(0.2);
+    const std::string configPath = findFile("dispatch.0.background.cfg");
+    TestMonitor::reset();
+    Agent::initialize(LogManager::acquireXml(configPath), clock, 0, true);
+    Agent::instance()->run();
+    assertTrue(TestMonitor::success(), TestMonitor::toString().c_str());
+    assertTrue(validateResults("dispatch.0"), "The background run must give dispatch.0.valid");
+    Agent::reset();
+    LogManager::releaseXml(configPath);
+    return true;
+  }
+
+  /**
+   * The dispatcher has the timelines of the creator and of the reciver as external timelines, so it is one level above
+   * them, and after them in the order of synchronization.
+   */
+  static bool testDependencyGraph(){
+    AgentRun run("dispatch.0.cfg", 50);
+    const AgentId& agent = Agent::instance();
+    assertTrue(agent->getLevel("creator") == 0 && agent->getLevel("reciver") == 0 && agent->getLevel("dispatcher") == 1);
+    assertTrue(agent->getOwner("ct")->getName() == LabelStr("creator"));
+    assertTrue(agent->getOwner("rt")->getName() == LabelStr("reciver"));
+
+    const std::vector< std::vector<TeleoReactorId> >& levels = agent->getLevels();
+    assertTrue(levels.size() == 2 && levels[0].size() == 2 && levels[1].size() == 1);
+    assertTrue(levels[1][0]->getName() == LabelStr("dispatcher"));
+
+    const std::vector<TeleoReactorId>& sorted = agent->getSortedReactors();
+    assertTrue(sorted.size() == 3 && sorted.back()->getName() == LabelStr("dispatcher"));
+    return true;
+  }
+
+  /**
+   * @brief Run an agent to completion on a clock.
+   * @param skipped Set to the ticks the agent skipped
+   * @param degraded Set to the ticks the agent ran without deliberation
+   * @return The number of ticks the agent ran
+   */
+  static unsigned int runOn(Clock& clock, const char* configFile, unsigned long& skipped, unsigned long& degraded){
+    const std::string configPath = findFile(configFile);
+    TestMonitor::reset();
+    Agent::initialize(LogManager::acquireXml(configPath), clock, 0, true);
+    LogManager::instance().handleInit();
+    unsigned int ticks = 0;
+    while(Agent::instance()->doNext())
+      ticks++;
+    skipped = Agent::instance()->getSkippedTicks();
+    degraded = Agent::instance()->getDegradedTicks();
+    Agent::reset();
+    LogManager::releaseXml(configPath);
+    return ticks;
+  }
+
+  /**
+   * The clock lags by 3 ticks once tick 3 is done. By default the agent runs ticks 4 to 6 back to back. With skipToNow it
+   * goes straight to tick 7, and with degradeDeliberation it does not deliberate on ticks 4 and 5 as the next tick is
+   * already due. While the agent is on time, none of the policies changes the outcome of dispatch.0.
+   */
+  static bool testOverrunPolicies(){
+    runAgentWithSchema("dispatch.0.skipToNow.cfg", 50, "dispatch.0");
+    runAgentWithSchema("dispatch.0.degradeDeliberation.cfg", 50, "dispatch.0");
+
+    unsigned long skipped, degraded;
+    LaggingClock catchUpClock(3, 3);
+    assertTrue(runOn(catchUpClock, "dispatch.0.cfg", skipped, degraded) == 10);
+    assertTrue(skipped == 0 && degraded == 0);
+
+    LaggingClock skipClock(3, 3);
+    assertTrue(runOn(skipClock, "dispatch.0.skipToNow.cfg", skipped, degraded) == 7);
+    assertTrue(skipped == 3 && degraded == 0);
+
+    LaggingClock degradeClock(3, 3);
+    assertTrue(runOn(degradeClock, "dispatch.0.degradeDeliberation.cfg", skipped, degraded) == 10);
+    assertTrue(skipped == 0 && degraded == 2);
+    return true;
+  }
+
+  /**
+   * @return The resumes of the dispatch.0 reactors over a run on a clock which always has 1000 seconds left to the tick
+   */
+  static unsigned long countResumes(const char* configFile){
+    LaggingClock clock(0, 0, 1000.0);
+    const std::string configPath = findFile(configFile);
+    TestMonitor::reset();
+    Agent::initialize(LogManager::acquireXml(configPath), clock, 0, true);
+    LogManager::instance().handleInit();
+    while(Agent::instance()->doNext()){}
+    assertTrue(TestMonitor::success(), TestMonitor::toString().c_str());
+    unsigned long resumes = 0;
+    const char* reactors[] = {"creator", "reciver", "dispatcher"};
+    for(unsigned int i = 0; i < 3; i++)
+      resumes += Agent::instance()->getReactor(reactors[i])->getLatency(PerformanceMonitor::RESUME).count();
+    Agent::reset();
+    LogManager::releaseXml(configPath);
+    return resumes;
+  }
+
+  /**
+   * With half of 1000 seconds to spend, each resume runs search steps until the plan is complete. With a budget of 0 the
+   * same search takes one resume per step, so it takes more resumes. Neither budget changes the outcome of dispatch.0.
+   */
+  static bool testResumeBudget(){
+    runAgentWithSchema("dispatch.0.resumeBudget.cfg", 50, "dispatch.0");
+    assertTrue(countResumes("dispatch.0.resumeBudget.cfg") > countResumes("dispatch.0.cfg"));
+    return true;
+  }
+
+  /**
+   * @return The names of the reactors in the order the scheduler selects them over one tick, the scheduler being
+   * deleted. The reactors have constant work so maxSteps must not be 0.
+   */
+  static std::string schedule(DeliberationScheduler* scheduler, const std::vector<TeleoReactorId>& reactors, unsigned int maxSteps){
+    std::string result;
+    scheduler->setMaxSteps(maxSteps);
+    scheduler->handleTickStart(reactors, 0);
+    for(TeleoReactorId reactor = scheduler->next(); reactor.isId(); reactor = scheduler->next())
+      result += reactor->getName().toString();
+    delete scheduler;
+    return result;
+  }
+
+  /**
+   * @return The value of a timeline at a tick found by walking its sequence : the last token which may start by tick
+   * and does not end before
+   */
+  static TokenId walkValue(const std::list<TokenId>& sequence, TICK tick){
+    TokenId value;
+    for(std::list<TokenId>::const_iterator it = sequence.begin(); it != sequence.end(); ++it){
+      if((TICK) (*it)->start()->lastDomain().getUpperBound() > tick)
+	break;
+      if((TICK) (*it)->end()->lastDomain().getUpperBound() >= tick)
+	value = *it;
+    }
+    return value;
+  }
+
+  /**
+   * As the plans change from tick to tick, the indexed sequence of each timeline stays that of the timeline, and the
+   * binary search of getValue finds the value a walk of the sequence finds.
+   */
+  static bool testTimelineValues(){
+    AgentRun run("dispatch.0.cfg", 50);
+    const char* reactors[] = {"creator", "reciver", "dispatcher"};
+    for(TICK tick = 1; tick < 10; tick++){
+      assertTrue(run.runUntil(tick));
+      for(unsigned int i = 0; i < 3; i++){
+	DbCore& core = run.core(reactors[i]);
+	std::vector<TokenId> tokens = run.tokens(reactors[i]);
+	for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
+	  if(!(*it)->isActive() || !(*it)->getObject()->lastDomain().isSingleton())
+	    continue;
+	  ObjectId object = (*it)->getObject()->lastDomain().getSingletonValue();
+	  if(!TimelineId::convertable(object))
+	    continue;
+	  TimelineId timeline = (TimelineId) object;
+	  const std::list<TokenId>& sequence = timeline->getTokenSequence();
+	  const std::vector<TokenId>& indexed = core.getTokenSequence(timeline);
+	  assertTrue(indexed.size() == sequence.size() && std::equal(indexed.begin(), indexed.end(), sequence.begin()));
+	  for(TICK t = 0; t <= Agent::instance()->getFinalTick(); t++)
+	    assertTrue(core.getValue(timeline, t) == walkValue(sequence, t));
+	}
+      }
+    }
+    return true;
+  }
+
+  /**
+   * The beta goal of the dispatcher waits for the gamma of the creator, an uncontrollable event on another object, to
+   * end at tick 2. It reaches the reciver on the next tick, not before.
+   */
+  static bool testPendingPredecessors(){
+    AgentRun run("dispatch.0.cfg", 50);
+    for(TICK tick = 1; tick <= 4; tick++){
+      assertTrue(run.runUntil(tick));
+      bool dispatched = false;
+      std::vector<TokenId> tokens = run.tokens("reciver");
+      for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+	dispatched = dispatched || (*it)->getPredicateName() == LabelStr("ReciverTimeline.Beta");
+      assertTrue(dispatched == (tick > 3));
+    }
+    return true;
+  }
+
+  /**
+   * The frontier moves along a sequence and falls back to its start when the token at the frontier leaves it, or when
+   * tokens are inserted while it is at the end of the sequence.
+   */
+  static bool testExecutionFrontier(){
+    AgentRun run("dispatch.0.cfg", 50);
+    run.run();
+
+    std::vector<TokenId> tokens = run.tokens("dispatcher");
+    assertTrue(tokens.size() >= 2);
+    const std::list<TokenId> sequence(tokens.begin(), tokens.end());
+    std::list<TokenId>::const_iterator second = sequence.begin();
+    ++second;
+
+    ExecutionFrontier frontier;
+    assertTrue(frontier.begin(sequence) == sequence.begin());
+    frontier.moveTo(second, sequence);
+    assertTrue(frontier.begin(sequence) == second);
+    frontier.handleRemoval(sequence.front());
+    assertTrue(frontier.begin(sequence) == second);
+    frontier.handleRemoval(*second);
+    assertTrue(frontier.begin(sequence) == sequence.begin());
+
+    frontier.moveTo(sequence.end(), sequence);
+    assertTrue(frontier.begin(sequence) == sequence.end());
+    frontier.handleConstrained(sequence.front(), *second);
+    assertTrue(frontier.begin(sequence) == sequence.begin());
+
+    frontier.moveTo(second, sequence);
+    frontier.reset();
+    assertTrue(frontier.begin(sequence) == sequence.begin());
+    return true;
+  }
+
+  /**
+   * An observation only reaches the reactors which have its timeline as external. The dispatcher is the only one
+   * observing rt : the reciver owns it and the creator ignores it.
+   */
+  static bool testObservationRouting(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+    const unsigned int dispatcher = run.core("dispatcher").countTokens();
+    const unsigned int reciver = run.core("reciver").countTokens();
+    const unsigned int creator = run.core("creator").countTokens();
+
+    // Beta is not the current value of rt, so the observation cannot just extend it and gets its own token
+    Agent::instance()->notify(ObservationByValue("rt", "ReciverTimeline.Beta"));
+    assertTrue(run.core("dispatcher").countTokens() == dispatcher + 1);
+    assertTrue(run.core("reciver").countTokens() == reciver);
+    assertTrue(run.core("creator").countTokens() == creator);
+
+    // Nobody observes an undeclared timeline
+    Agent::instance()->notify(ObservationByValue("nowhere", "Nowhere.Holds"));
+    assertTrue(run.core("dispatcher").countTokens() == dispatcher + 1);
+    return true;
+  }
+
+  /**
+   * A batch is split by observer : the dispatcher gets both its observations, and the others get nothing.
+   */
+  static bool testObservationBatch(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+    const unsigned int dispatcher = run.core("dispatcher").countTokens();
+    const unsigned int reciver = run.core("reciver").countTokens();
+    const unsigned int creator = run.core("creator").countTokens();
+
+    ObservationByValue beta("rt", "ReciverTimeline.Beta");
+    ObservationByValue delta("ct", "CreatorTimeline.Delta");
+    ObservationByValue nowhere("nowhere", "Nowhere.Holds");
+    std::vector<const Observation*> batch;
+    batch.push_back(&beta);
+    batch.push_back(&nowhere);
+    batch.push_back(&delta);
+    Agent::instance()->notifyBatch(batch);
+
+    assertTrue(run.core("dispatcher").countTokens() == dispatcher + 2);
+    assertTrue(run.core("reciver").countTokens() == reciver);
+    assertTrue(run.core("creator").countTokens() == creator);
+    return true;
+  }
+
+  /**
+   * Each goal of a batch is handled in turn, and gets its own response.
+   */
+  static bool testRequestBatch(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+
+    DbClientId client = run.core("dispatcher").getAssembly().getPlanDatabase()->getClient();
+    std::vector<TokenId> goals;
+    for(unsigned int i = 0; i < 2; i++){
+      TokenId goal = client->createToken("ReciverTimeline.Beta", NULL, true);
+      goal->getObject()->specify(client->getObject("rt"));
+      goals.push_back(goal);
+    }
+
+    const unsigned int reciver = run.core("reciver").countTokens();
+    std::vector<bool> accepted;
+    ((TeleoReactor*) Agent::instance()->getReactor("reciver"))->request(goals, accepted);
+    assertTrue(accepted.size() == 2 && accepted[0] && accepted[1]);
+    assertTrue(run.core("reciver").countTokens() >= reciver + 2);
+    return true;
+  }
+
+  /**
+   * A batch of recalls is buffered by the server and its goals are discarded at the next synchronization. A goal
+   * the server never received is ignored.
+   */
+  static bool testRecallBatch(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+
+    DbClientId client = run.core("dispatcher").getAssembly().getPlanDatabase()->getClient();
+    std::vector<TokenId> goals;
+    for(unsigned int i = 0; i < 3; i++){
+      TokenId goal = client->createToken("ReciverTimeline.Beta", NULL, true);
+      goal->getObject()->specify(client->getObject("rt"));
+      goals.push_back(goal);
+    }
+    TeleoReactor* reciver = (TeleoReactor*) Agent::instance()->getReactor("reciver");
+    TokenId unknown = goals.back();
+    goals.pop_back();
+
+    std::vector<bool> accepted;
+    reciver->request(goals, accepted);
+    assertTrue(accepted.size() == 2 && accepted[0] && accepted[1]);
+    const unsigned int requested = run.core("reciver").countTokens();
+
+    // Nothing is discarded before the next synchronization
+    goals.push_back(unknown);
+    reciver->recall(goals);
+    assertTrue(run.core("reciver").countTokens() == requested);
+    // Nor would the dispatcher dispatch them again
+    for(std::vector<TokenId>::const_iterator it = goals.begin(); it != goals.end(); ++it)
+      client->deleteToken(*it);
+
+    // The dispatcher only dispatches its own Beta after tick 3
+    assertTrue(run.runUntil(2));
+    std::vector<TokenId> tokens = run.tokens("reciver");
+    for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+      assertTrue((*it)->getPredicateName() != LabelStr("ReciverTimeline.Beta"), (*it)->toString().c_str());
+    return true;
+  }
+
+  /**
+   * With a single propagation for the restrictions of a tick, the tokens which may have started must still be committed,
+   * those which have started must have their start settled, and the current value cannot end in the past.
+   */
+  static bool testPublication(){
+    AgentRun run("dispatch.0.cfg", 50);
+    for(TICK tick = 1; tick <= 4; tick++){
+      assertTrue(run.runUntil(tick));
+      std::vector<TokenId> tokens = run.tokens("reciver");
+      for(std::vector<TokenId>::const_iterator it = tokens.begin(); it != tokens.end(); ++it){
+	const TokenId& token = *it;
+	if(token->start()->lastDomain().getLowerBound() > tick)
+	  continue;
+	assertTrue(token->isCommitted(), token->toString().c_str());
+	if(token->start()->lastDomain().getUpperBound() <= tick)
+	  assertTrue(token->start()->baseDomain().isSingleton(), token->toString().c_str());
+	if(token->end()->lastDomain().getUpperBound() > tick)
+	  assertTrue(token->end()->baseDomain().getLowerBound() >= tick, token->toString().c_str());
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Entries are found both ways, and an entry whose local entity is discarded is dropped the first time it is used
+   * after expire().
+   */
+  static bool testForeignKeyTable(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+    DbClientId foreignDb = run.core("dispatcher").getAssembly().getPlanDatabase()->getClient();
+    DbClientId localDb = run.core("reciver").getAssembly().getPlanDatabase()->getClient();
+
+    TokenId foreign = foreignDb->createToken("ReciverTimeline.Beta", NULL, true);
+    TokenId other = foreignDb->createToken("ReciverTimeline.Beta", NULL, true);
+    TokenId local = localDb->createToken("ReciverTimeline.Beta", NULL, true);
+
+    ForeignKeyTable table;
+    table.insert(foreign, local);
+    assertTrue(table.contains(foreign) && !table.contains(other));
+    assertTrue(table.getLocal(foreign)->getKey() == local->getKey());
+    assertTrue(table.getForeign(local)->getKey() == foreign->getKey());
+    assertTrue(table.getLocal(other).isNoId());
+
+    // Still valid in a new generation
+    table.expire();
+    assertTrue(table.getLocal(foreign)->getKey() == local->getKey());
+
+    localDb->deleteToken(local);
+    table.expire();
+    assertTrue(!table.contains(foreign) && table.getLocal(foreign).isNoId());
+
+    // Erasing removes both directions
+    TokenId replacement = localDb->createToken("ReciverTimeline.Beta", NULL, true);
+    table.insert(other, replacement);
+    table.erase(other);
+    assertTrue(!table.contains(other) && table.getForeign(replacement).isNoId());
+
+    localDb->deleteToken(replacement);
+    foreignDb->deleteToken(other);
+    foreignDb->deleteToken(foreign);
+    return true;
+  }
+
+  /**
+   * Observing the current value again extends it rather than creating a token. Only the first observation of a timeline
+   * on a tick can do so.
+   */
+  static bool testConfirmedObservation(){
+    AgentRun run("dispatch.0.cfg", 50);
+    assertTrue(run.runUntil(1));
+    DbCore& dispatcher = run.core("dispatcher");
+    TimelineId rt = dispatcher.getAssembly().getPlanDatabase()->getObject("rt");
+    TokenId value = dispatcher.getValue(rt, 0);
+    assertTrue(value.isId() && value->getPredicateName() == LabelStr("ReciverTimeline.Alpha"));
+
+    const unsigned int tokens = dispatcher.countTokens();
+    Agent::instance()->notify(ObservationByValue("rt", "ReciverTimeline.Alpha"));
+    assertTrue(dispatcher.countTokens() == tokens);
+    assertTrue(dispatcher.getValue(rt, 1) == value);
+    assertTrue(value->end()->baseDomain().getLowerBound() >= 2);
+
+    Agent::instance()->notify(ObservationByValue("rt", "ReciverTimeline.Alpha"));
+    assertTrue(dispatcher.countTokens() == tokens + 1);
+    return true;
+  }
+
+  /**
+   * The adapter observes the last record of each tick, and a recall which finds the goal ring full is kept and sent
+   * before the next request.
+   */
+  static bool testShmAdapter(){
+    shm_unlink("/trex.test.obs");
+    shm_unlink("/trex.test.goals");
+    ShmRing observations("/trex.test.obs", 4);
+    assertTrue(observations.created() && observations.capacity() == 4);
+    ShmRing::Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.kind = ShmRing::OBSERVATION;
+    rec.count = 2;
+    rec.bounds[0] = rec.bounds[1] = 1.5;
+    rec.bounds[2] = rec.bounds[3] = 1;
+    assertTrue(observations.push(rec));
+
+    AgentRun run("shm.0.cfg", 50);
+    ShmRing goals("/trex.test.goals", 8);
+    assertTrue(!goals.created() && goals.capacity() == 2);
+    assertTrue(run.runUntil(1));
+    assertTrue(observations.available() == 0);
+
+    rec.bounds[2] = rec.bounds[3] = 2;
+    assertTrue(observations.push(rec));
+    rec.bounds[2] = rec.bounds[3] = 3;
+    assertTrue(observations.push(rec));
+    assertTrue(run.runUntil(3));
+    assertTrue(observations.available() == 0);
+    DbCore& client = run.core("client");
+    TokenId value = client.getValue(client.getAssembly().getPlanDatabase()->getObject("log_writing"), 2);
+    assertTrue(value.isId());
+    ConstrainedVariableId p_int = value->getVariable(LabelStr("p_int"));
+    assertTrue(p_int.isId() && p_int->lastDomain().isSingleton() && p_int->lastDomain().getSingletonValue() == 3);
+
+    TeleoReactor* shm = (TeleoReactor*) Agent::instance()->getReactor("shm");
+    DbClientId db = client.getAssembly().getPlanDatabase()->getClient();
+    TokenId first = db->createToken("LogTesting.Holds", NULL, true);
+    TokenId second = db->createToken("LogTesting.Holds", NULL, true);
+    TokenId third = db->createToken("LogTesting.Holds", NULL, true);
+    assertTrue(shm->request(first) && shm->request(second));
+    assertTrue(!shm->request(third));
+
+    shm->recall(first);
+    assertTrue(goals.available() == 2);
+    assertTrue(goals.peek(0).kind == ShmRing::REQUEST && goals.peek(0).key == (uint64_t) first->getKey());
+    assertTrue(goals.peek(1).kind == ShmRing::REQUEST && goals.peek(1).key == (uint64_t) second->getKey());
+    goals.release(2);
+
+    assertTrue(shm->request(third));
+    assertTrue(goals.available() == 2);
+    assertTrue(goals.peek(0).kind == ShmRing::RECALL && goals.peek(0).key == (uint64_t) first->getKey());
+    assertTrue(goals.peek(1).kind == ShmRing::REQUEST && goals.peek(1).key == (uint64_t) third->getKey());
+    goals.release(2);
+
+    db->deleteToken(first);
+    db->deleteToken(second);
+    db->deleteToken(third);
+    return true;
+  }
+
+  /**
+   * Tests that a RemoteReactor closes a corrupted connection and then refuses goals, and that listenAddress
+   * and acceptTimeout are checked.
+   */
+  static bool testRemoteReactor(){
+    RemotePeer peer(17311);
+    peer.start();
+    AgentRun run("remote.0.cfg", 50);
+    assertTrue(peer.connected());
+    // Leaves the receiver the time to read the truncated record
+    usleep(200000);
+    assertTrue(run.runUntil(1));
+
+    TeleoReactor* remote = (TeleoReactor*) Agent::instance()->getReactor("remote");
+    DbCore& client = run.core("client");
+    DbClientId db = client.getAssembly().getPlanDatabase()->getClient();
+    TokenId goal = db->createToken("LogTesting.Holds", NULL, true);
+    assertTrue(!remote->request(goal));
+    db->deleteToken(goal);
+
+    assertTrue(failsToListen("localhost", "1") == "configuration");
+    assertTrue(failsToListen("127.0.0.1", "0") == "configuration");
+    assertTrue(failsToListen("127.0.0.1", "1") == "errno");
+    return true;
+  }
+
+  /**
+   * @brief How a RemoteReactor listening on listenAddress fails when no peer connects within acceptTimeout.
+   */
+  static std::string failsToListen(const char* address, const char* timeout){
+    TiXmlElement config("TeleoReactor");
+    config.SetAttribute("name", "alone");
+    config.SetAttribute("lookAhead", "1");
+    config.SetAttribute("latency", "0");
+    config.SetAttribute("listen", "17312");
+    config.SetAttribute("listenAddress", address);
+    config.SetAttribute("acceptTimeout", timeout);
+    TiXmlElement internal("Internal");
+    internal.SetAttribute("name", "alone_timeline");
+    config.InsertEndChild(internal);
+    try {
+      RemoteReactor reactor(LabelStr("quiet.0"), config);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return "configuration";
+    }
+    catch(ErrnoExcept const &){
+      return "errno";
+    }
+    return "connected";
+  }
+
   /**
    * Tests the OrienteeringSolver..
    */
@@ -325,6 +1911,11 @@ private:
     runAgentWithSchema("orienteering.0.cfg", 50, "orienteering.0");
     runAgentWithSchema("orienteering.1.cfg", 50, "orienteering.1");
     runAgentWithSchema("orienteering.2.cfg", 50, "orienteering.2");
+    runAgentWithSchema("orienteering.2.table.cfg", 50, "orienteering.2");
+    runAgentWithSchema("orienteering.2.restarts.cfg", 50, "orienteering.2");
+    runAgentWithSchema("orienteering.2.threads.cfg", 50, "orienteering.2");
+    // The neighborhoods take several steps each
+    runAgentWithSchema("orienteering.2.movesPerStep.cfg", 500, "orienteering.2");
     runAgentWithSchema("orienteering.3.cfg", 50, "orienteering.3");
     runAgentWithSchema("orienteering.4.cfg", 50, "orienteering.4");
     return true;
@@ -335,8 +1926,39 @@ class AgentTests {
 public:
   static bool test(){
     runTest(testRealTimeClock);
+    runTest(testRealTimeClockWait);
+    runTest(testRealTimeClockLateness);
+    runTest(testSimulationClock);
+    runTest(testTickArena);
+    runTest(testSeqLockVar);
+    runTest(testRcuVar);
+    runTest(testObservationInbox);
+    runTest(testShmRing);
+    runTest(testThreadScheduling);
+    runTest(testTickTrace);
+    runTest(testLatencyHistogram);
+    runTest(testEventLog);
+    runTest(testDomainPool);
     runTest(testForeverConfiguration);
     runTest(testTimelimitOverride);
+    runTest(testNddlIncludePath);
+    runTest(testFileIndex);
+    runTest(testSharedXml);
+    runTest(testCheckpointFile);
+    runTest(testMissionHistory);
+    runTest(testBinaryObservationLog);
+    runTest(testMalformedObservationLog);
+    runTest(testBinaryTickLog);
+    runTest(testTableCostEstimator);
+    runTest(testMultiStartSearch);
+    runTest(testFlatTables);
+    runTest(testXmlStream);
+    runTest(testTelemetryServer);
+    runTest(testFailureAnalyst);
+    runTest(testSyslogCategories);
+    runTest(testAsyncTextLog);
+    // Leaves the syslog asynchronous : keep it last
+    runTest(testAsyncSyslog);
     return true;
   }
 
@@ -371,31 +1993,1342 @@ private:
     return true;
   }
 
-  static bool testForeverConfiguration(){
-    PseudoClock clock(0.0, 1);
-    TiXmlElement* root = initXml("Forever.cfg");
+  static bool testRealTimeClockWait(){
+    RealTimeClock clk(0.5);
+    clk.start();
 
-    Agent::initialize(*root, clock);
+    // Waiting returns at the tick boundary
+    assertTrue(clk.waitForNextTick(0) == 1);
+    assertTrue(clk.getNextTick() == 1);
 
-    assertTrue(Agent::instance()->getFinalTick() == Agent::forever());
+    // An interrupted wait returns early with the same tick
+    clk.interrupt();
+    assertTrue(clk.waitForNextTick(1) == 1);
+
+    // The interruption is consumed
+    assertTrue(clk.waitForNextTick(1) == 2);
 
-    Agent::reset();
-  
-    delete root;
     return true;
   }
 
-  static bool testTimelimitOverride(){
-    PseudoClock clock(0.0, 1);
-    TiXmlElement* root = initXml("Forever.cfg");
+  static bool testRealTimeClockLateness(){
+    RealTimeClock clk(0.2);
 
-    Agent::initialize(*root, clock, 10);
+    // Nothing is late before the start
+    assertTrue(clk.getLateness(0) == 0.0);
+    // The bounds are taken from the time actually elapsed : a loaded host may sleep much longer than asked
+    long long before = ClockStat::now(ClockStat::monotonic);
+    clk.start();
 
-    assertTrue(Agent::instance()->getFinalTick() == (TICK) 10);
+    // Tick 2 was due at least 0.1 seconds before
+    Clock::sleep(0.5);
+    double lateness = clk.getLateness(2);
+    double elapsed = (ClockStat::now(ClockStat::monotonic) - before) / 1e9;
+    assertTrue(lateness >= 0.09 && lateness <= elapsed - 0.4 + 0.01);
+    // Tick 500 is 100 seconds ahead
+    assertTrue(clk.getLateness(500) == 0.0);
+    TICK tick = clk.getNextTick();
+    elapsed = (ClockStat::now(ClockStat::monotonic) - before) / 1e9;
+    assertTrue(tick >= 2 && tick <= (TICK) (elapsed / 0.2));
 
-    Agent::reset();
-  
-    delete root;
+    // Jitter is the variation of the lateness between consecutive ticks
+    PerformanceMonitor monitor;
+    monitor.addTickLateness(0.5);
+    monitor.addTickLateness(0.25);
+    assertTrue(monitor.getLateness().count() == 2 && monitor.getLateness().max() == 500000);
+    assertTrue(monitor.getJitter().count() == 1 && monitor.getJitter().max() == 250000);
+
+    return true;
+  }
+
+  static bool testSimulationClock(){
+    SimulationClock clk(1.0, 3);
+
+    // The tick holds for the step budget
+    assertTrue(clk.getNextTick() == 0);
+    assertTrue(clk.getNextTick() == 0);
+    assertTrue(clk.getNextTick() == 0);
+    assertTrue(clk.getNextTick() == 1);
+
+    // Waiting does not sleep : the tick advances right away
+    assertTrue(clk.waitForNextTick(1) == 2);
+    assertTrue(clk.getNextTick() == 2);
+
+    // Without a budget, only waiting ends the tick
+    SimulationClock asap(1.0);
+    for(unsigned int i = 0; i < 100; i++)
+      assertTrue(asap.getNextTick() == 0);
+    assertTrue(asap.waitForNextTick(0) == 1);
+
+    // Idle ticks are skipped at once, which the pseudo clock cannot do
+    assertTrue(asap.jumpTo(5));
+    assertTrue(asap.getNextTick() == 5);
+    PseudoClock pseudo(0.0, 1);
+    assertTrue(!pseudo.jumpTo(5));
+
+    return true;
+  }
+
+  static bool testTickArena(){
+    TickArena& arena = TickArena::instance();
+    { // Grow past a chunk so that the next reset merges the chunks
+      TickVector<int>::type values;
+      for(unsigned int i = 0; i < TickArena::CHUNK_SIZE; i++)
+	values.push_back(i);
+    }
+    assertTrue(arena.live() == 0);
+    arena.reset();
+
+    // The same temporaries do not call malloc again
+    unsigned long mallocs = arena.mallocCount();
+    for(unsigned int tick = 0; tick < 10; tick++){
+      { // The temporaries of a tick are gone before the arena is reset
+	TickVector<int>::type values;
+	for(unsigned int i = 0; i < TickArena::CHUNK_SIZE; i++)
+	  values.push_back(i);
+	TickStringStream ss;
+	ss << "tick " << tick;
+	assertTrue(ss.str() == TickString("tick ") + (char) ('0' + tick));
+      }
+      assertTrue(arena.live() == 0);
+      arena.reset();
+    }
+    assertTrue(arena.mallocCount() == mallocs);
+
+    return true;
+  }
+
+  /**
+   * A reader racing a writer only ever sees values written as a whole, in order.
+   */
+  static bool testSeqLockVar(){
+    SeqPair initial = {0, 0};
+    SeqLockVar<SeqPair> var(initial);
+    const long count = 100000;
+    SeqLockWriter writer(var, count);
+    writer.start();
+
+    long last = 0;
+    while(last < count){
+      SeqPair value = var.load();
+      assertTrue(value.second == -value.first);
+      assertTrue(value.first >= last);
+      last = value.first;
+    }
+    writer.join();
+    assertTrue(var.version() == (unsigned long) count);
+    return true;
+  }
+
+  /**
+   * The reader keeps reading whole copies while the writer replaces them, and the copies it quit are deleted.
+   */
+  static bool testRcuVar(){
+    RcuVar< std::vector<long> > var(std::vector<long>(16, 0));
+    const long count = 20000;
+    RcuWriter writer(var, count);
+    writer.start();
+
+    long last = 0;
+    while(last < count){
+      const std::vector<long>& value = var.read();
+      assertTrue(value.size() == 16);
+      for(std::vector<long>::const_iterator it = value.begin(); it != value.end(); ++it)
+	assertTrue(*it == value.front());
+      assertTrue(value.front() >= last);
+      last = value.front();
+      var.quiescent();
+    }
+    writer.join();
+
+    // Only the copy replaced since the last quiescent state is kept
+    var.quiescent();
+    var.store(std::vector<long>(16, count + 1));
+    assertTrue(var.retired() == 1);
+    assertTrue(var.read().front() == count + 1);
+    return true;
+  }
+
+  static void deleteAll(std::vector<Observation*>& observations){
+    for(std::vector<Observation*>::const_iterator it = observations.begin(); it != observations.end(); ++it)
+      delete *it;
+    observations.clear();
+  }
+
+  /**
+   * The inbox keeps the order of the observations pushed and drops those which do not fit, whether it is drained
+   * on the same thread or while a driver thread pushes.
+   */
+  static bool testObservationInbox(){
+    const LabelStr a("a"), b("b"), predicate("Holds");
+    std::vector<Observation*> drained;
+    {
+      ObservationInbox inbox(3, false);
+      assertTrue(inbox.capacity() == 4);
+      std::vector<Observation*> pushed;
+      for(unsigned int i = 0; i < 4; i++){
+	pushed.push_back(new ObservationByValue(a, predicate));
+	assertTrue(inbox.push(pushed.back()));
+      }
+      assertTrue(!inbox.push(new ObservationByValue(a, predicate)));
+      assertTrue(inbox.dropped() == 1);
+      inbox.drain(drained);
+      assertTrue(drained == pushed);
+      deleteAll(drained);
+
+      // The queue is usable again once drained. What is left is deleted with it.
+      assertTrue(inbox.push(new ObservationByValue(b, predicate)));
+    }
+
+    {
+      // Only the last observation of each timeline is kept, in the order of the last ones
+      ObservationInbox inbox(8, true);
+      Observation* lastB = new ObservationByValue(b, predicate);
+      Observation* lastA = new ObservationByValue(a, predicate);
+      inbox.push(new ObservationByValue(a, predicate));
+      inbox.push(lastB);
+      inbox.push(lastA);
+      inbox.drain(drained);
+      assertTrue(drained.size() == 2 && drained[0] == lastB && drained[1] == lastA);
+      assertTrue(inbox.coalesced() == 1);
+      deleteAll(drained);
+    }
+
+    ObservationInbox inbox(64, false);
+    const unsigned int count = 20000;
+    InboxWriter writer(inbox, count, a, predicate);
+    writer.start();
+    unsigned int received = 0, next = 0;
+    while(received + inbox.dropped() < count){
+      inbox.drain(drained);
+      for(std::vector<Observation*>::const_iterator it = drained.begin(); it != drained.end(); ++it){
+	// Dropped observations are skipped, the others come in order
+	while(next < count && writer.pushed(next) != *it)
+	  next++;
+	assertTrue(next < count);
+	next++;
+	received++;
+      }
+      deleteAll(drained);
+    }
+    writer.join();
+    inbox.drain(drained);
+    assertTrue(drained.empty());
+    return true;
+  }
+
+  /**
+   * Specifications are read as policy[:priority][@cpu,...] and any malformed part is rejected.
+   */
+  static bool testThreadScheduling(){
+    assertTrue(Thread::Scheduling().isDefault());
+    assertTrue(Thread::Scheduling("other").isDefault());
+
+    Thread::Scheduling fifo("fifo:80@2");
+    assertTrue(fifo.policy == Thread::fifoPolicy && fifo.priority == 80);
+    assertTrue(fifo.cpus.size() == 1 && fifo.cpus[0] == 2);
+    assertTrue(!fifo.isDefault());
+
+    Thread::Scheduling rr("rr:10");
+    assertTrue(rr.policy == Thread::rrPolicy && rr.priority == 10 && rr.cpus.empty());
+
+    Thread::Scheduling pinned("other@0,1");
+    assertTrue(pinned.policy == Thread::otherPolicy && pinned.priority == 0);
+    assertTrue(pinned.cpus.size() == 2 && pinned.cpus[0] == 0 && pinned.cpus[1] == 1);
+    assertTrue(!pinned.isDefault());
+
+    const char* invalid[] = {"batch", "fifo:", "fifo:high", "fifo:80x", "fifo@", "fifo@1,", "fifo@,1", "fifo@-1", "fifo@a", "rr:5@1,,2"};
+    for(unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++){
+      bool failed = false;
+      try {
+	Thread::Scheduling sched(invalid[i]);
+      }
+      catch(ThreadExcept const &){
+	failed = true;
+      }
+      assertTrue(failed, invalid[i]);
+    }
+    return true;
+  }
+
+  /**
+   * The process opening a ring uses the layout of its creator and does not trust a header changed later. The segment
+   * is gone once its creator closed it.
+   */
+  static bool testShmRing(){
+    const char* name = "/trex.test.ring";
+    shm_unlink(name);
+    {
+      ShmRing producer(name, 3);
+      ShmRing consumer(name, 16);
+      assertTrue(producer.created() && !consumer.created());
+      assertTrue(consumer.capacity() == 3);
+
+      ShmRing::Record rec;
+      memset(&rec, 0, sizeof(rec));
+      for(rec.key = 0; rec.key < 3; rec.key++)
+	assertTrue(producer.push(rec));
+      assertTrue(!producer.push(rec));
+      assertTrue(consumer.dropped() == 1);
+
+      assertTrue(consumer.available() == 3);
+      assertTrue(consumer.peek(0).key == 0 && consumer.peek(2).key == 2);
+      consumer.release(1);
+      assertTrue(producer.push(rec));
+      assertTrue(consumer.available() == 3);
+      assertTrue(consumer.peek(0).key == 1 && consumer.peek(2).key == 3);
+
+      // A header rewritten by the other process
+      int fd = shm_open(name, O_RDWR, 0600);
+      assertTrue(fd >= 0);
+      void* base = mmap(NULL, sizeof(ShmRing::Header), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      assertTrue(base != MAP_FAILED);
+      ShmRing::Header* header = static_cast<ShmRing::Header*>(base);
+      header->capacity = 1000;
+      header->tail = header->head + 1000;
+      assertTrue(consumer.capacity() == 3 && consumer.available() == 3);
+      munmap(base, sizeof(ShmRing::Header));
+    }
+    assertTrue(shm_open(name, O_RDWR, 0600) < 0 && errno == ENOENT);
+
+    // Segments which are not rings of the same layout
+    const char* bad = "/trex.test.bad";
+    shm_unlink(bad);
+    int fd = shm_open(bad, O_RDWR|O_CREAT|O_EXCL, 0600);
+    assertTrue(fd >= 0);
+    assertTrue(!acceptsRing(bad));
+    assertTrue(ftruncate(fd, sizeof(ShmRing::Header)) == 0);
+    ShmRing::Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ShmRing::MAGIC;
+    header.recordSize = 1;
+    header.capacity = 4;
+    assertTrue(pwrite(fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header));
+    close(fd);
+    assertTrue(!acceptsRing(bad));
+    shm_unlink(bad);
+    return true;
+  }
+
+  /**
+   * @return false if the segment is rejected
+   */
+  static bool acceptsRing(const char* name){
+    try {
+      ShmRing ring(name, 4);
+    }
+    catch(std::runtime_error const &){
+      return false;
+    }
+    return true;
+  }
+
+  static bool testTickTrace(){
+    // Nothing is recorded unless enabled
+    assertTrue(!TickTrace::begin("idle"));
+
+    TickTrace::enable(5);
+    TickTrace::counter("tick", 3);
+    {
+      TickTraceScope outer("synchronize", "reactor");
+      // The buffer keeps room for the end of the outer phase
+      for(unsigned int i = 0; i < 4; i++){
+        TickTraceScope inner("notifyObservers");
+      }
+    }
+    assertTrue(TickTrace::dropped() == 3);
+
+    std::ostringstream out;
+    TickTrace::writeJson(out);
+    std::string json = out.str();
+    assertTrue(json.find("\"ph\":\"C\"") != std::string::npos);
+    assertTrue(json.find("\"label\":\"reactor\"") != std::string::npos);
+    unsigned int begins = 0, ends = 0;
+    for(std::string::size_type pos = json.find("\"ph\":\"B\""); pos != std::string::npos; pos = json.find("\"ph\":\"B\"", pos + 1))
+      begins++;
+    for(std::string::size_type pos = json.find("\"ph\":\"E\""); pos != std::string::npos; pos = json.find("\"ph\":\"E\"", pos + 1))
+      ends++;
+    assertTrue(begins == 2 && ends == 2);
+
+    TickTrace::disable();
+    assertTrue(!TickTrace::enabled());
+    return true;
+  }
+
+  /**
+   * Latencies below 32us have their own bucket. Above, a percentile is the upper bound of its bucket, within 1/16 of
+   * the recorded value, and never more than the largest value recorded.
+   */
+  static bool testLatencyHistogram(){
+    LatencyHistogram histogram;
+    assertTrue(histogram.count() == 0 && histogram.percentile(0.5) == 0);
+    for(unsigned long micros = 0; micros < 32; micros++)
+      histogram.record(micros);
+    assertTrue(histogram.percentile(0) == 0 && histogram.percentile(0.5) == 16 && histogram.percentile(1) == 31);
+
+    histogram.reset();
+    for(unsigned long micros = 1; micros <= 100; micros++)
+      histogram.record(micros);
+    assertTrue(histogram.count() == 100 && histogram.total() == 5050 && histogram.max() == 100);
+    assertTrue(histogram.percentile(0) == 1);
+    assertTrue(histogram.percentile(0.5) == 51);
+    assertTrue(histogram.percentile(0.99) == 100);
+
+    histogram.reset();
+    histogram.record(1000);
+    histogram.record(5000);
+    assertTrue(histogram.percentile(0) == 1023 && histogram.percentile(0.5) == 5000);
+    assertTrue(histogram.percentile(0) - 1000 <= 1000 / LatencyHistogram::SUB_BUCKETS);
+    return true;
+  }
+
+  static bool testEventLog(){
+    std::ostringstream expected;
+    {
+      // The ring keeps the 3 latest events, the sink gets them all
+      Agent::EventLog log(3, "test.events");
+      for(TICK tick = 0; tick < 5; tick++){
+	Agent::Event event(tick, Agent::Notify, "position", "Holds");
+	log.push(event);
+	Agent::write(expected, event);
+      }
+      assertTrue(log.size() == 3 && log.dropped() == 2);
+      assertTrue(log[0].m_tick == 2 && log[2].m_tick == 4);
+    }
+    assertTrue(readFile(LogManager::instance().file_name("test.events")) == expected.str());
+
+    // Without a capacity, nothing is dropped
+    Agent::EventLog unbounded(0, "");
+    for(TICK tick = 0; tick < 100; tick++)
+      unbounded.push(Agent::Event(tick, Agent::Recall, "position", "Holds"));
+    assertTrue(unbounded.size() == 100 && unbounded.dropped() == 0 && unbounded[99].m_tick == 99);
+    return true;
+  }
+
+  static bool testDomainPool(){
+    DomainPool pool;
+    AbstractDomain* dom = pool.acquire(IntDT::instance());
+    assertTrue(dom->isInterval() && !dom->isSingleton());
+    dom->intersect(IntervalIntDomain(3, 3));
+    {
+      ObservationByValue obs("position", "Holds", &pool);
+      obs.push_back("x", dom);
+    }
+
+    // The observation released the domain, which is reset when acquired again
+    AbstractDomain* recycled = pool.acquire(IntDT::instance());
+    assertTrue(recycled == dom && !recycled->isSingleton());
+    assertTrue(recycled->getLowerBound() == IntDT::instance()->baseDomain().getLowerBound());
+    delete recycled;
+
+    // In place parameters refer to the domains of the caller
+    IntervalIntDomain x(1, 1), y(2, 2);
+    FixedObservation<2> fixed("position", "Holds");
+    fixed.push_back("x", &x);
+    fixed.push_back("y", &y);
+    assertTrue(fixed.countParameters() == 2);
+    assertTrue(fixed[0].first == LabelStr("x") && fixed[0].second == &x && fixed[1].second == &y);
+    return true;
+  }
+
+  static bool testForeverConfiguration(){
+    PseudoClock clock(0.0, 1);
+    TiXmlElement* root = initXml("Forever.cfg");
+
+    Agent::initialize(*root, clock);
+
+    assertTrue(Agent::instance()->getFinalTick() == Agent::forever());
+
+    Agent::reset();
+  
+    delete root;
+    return true;
+  }
+
+  static bool testTimelimitOverride(){
+    PseudoClock clock(0.0, 1);
+    TiXmlElement* root = initXml("Forever.cfg");
+
+    Agent::initialize(*root, clock, 10);
+
+    assertTrue(Agent::instance()->getFinalTick() == (TICK) 10);
+
+    Agent::reset();
+  
+    delete root;
+    return true;
+  }
+
+  /**
+   * The include path of an NDDL configuration is shared by all the assemblies, and read again once the file changes.
+   */
+  static bool testNddlIncludePath(){
+    {
+      std::ofstream cfg("test.nddl.cfg");
+      cfg << "<configuration>\n <include path=\"a;b\"/>\n</configuration>\n";
+    }
+    assertTrue(Assembly::getNddlIncludePath("test.nddl.cfg") == "a:b");
+    assertTrue(Assembly::getNddlIncludePath("test.nddl.cfg") == "a:b");
+
+    {
+      std::ofstream cfg("test.nddl.cfg");
+      cfg << "<configuration>\n <include path=\"a;b;c\"/>\n</configuration>\n";
+    }
+    assertTrue(Assembly::getNddlIncludePath("test.nddl.cfg") == "a:b:c");
+
+    remove("test.nddl.cfg");
+    assertTrue(Assembly::getNddlIncludePath("test.nddl.cfg").empty());
+    return true;
+  }
+
+  /**
+   * Resolved file names are remembered until the search path changes or a rebuild is asked for. Misses are not.
+   */
+  static bool testFileIndex(){
+    std::ofstream("test.find").close();
+    assertTrue(findFile("test.find") == "./test.find");
+
+    remove("test.find");
+    assertTrue(findFile("test.find") == "./test.find");
+    assertTrue(findFile("test.find", true) == "test.find");
+
+    std::ofstream("test.find").close();
+    assertTrue(findFile("test.find") == "./test.find");
+
+    // The start directory is searched first once it is set
+    std::ofstream("search_tests/a/test.find").close();
+    setenv("TREX_START_DIR", "search_tests/a", 1);
+    assertTrue(findFile("test.find") == "search_tests/a/test.find");
+    unsetenv("TREX_START_DIR");
+    assertTrue(findFile("test.find") == "./test.find");
+
+    remove("search_tests/a/test.find");
+    remove("test.find");
+    return true;
+  }
+
+  /**
+   * A shared XML file is parsed once while it is referenced. A file that fails to parse is reported and not kept.
+   */
+  static bool testSharedXml(){
+    std::ofstream("test.shared.xml").close();
+    for(unsigned int i = 0; i < 2; i++){
+      bool rejected = false;
+      try {
+	LogManager::acquireXml("test.shared.xml");
+      }
+      catch(ConfigurationException* e){
+	rejected = true;
+	delete e;
+      }
+      assertTrue(rejected);
+    }
+
+    {
+      std::ofstream xml("test.shared.xml");
+      xml << "<Agent name=\"first\"/>\n";
+    }
+    const TiXmlElement& first = LogManager::acquireXml("test.shared.xml");
+    assertTrue(first.Attribute("name") == std::string("first"));
+    assertTrue(&LogManager::acquireXml("test.shared.xml") == &first);
+    LogManager::releaseXml("test.shared.xml");
+    LogManager::releaseXml("test.shared.xml");
+
+    // Released by all, the file is parsed again
+    {
+      std::ofstream xml("test.shared.xml");
+      xml << "<Agent name=\"second\"/>\n";
+    }
+    const TiXmlElement& second = LogManager::acquireXml("test.shared.xml");
+    assertTrue(second.Attribute("name") == std::string("second"));
+    LogManager::releaseXml("test.shared.xml");
+
+    remove("test.shared.xml");
+    return true;
+  }
+
+  static bool testCheckpointFile(){
+    Checkpoint saved;
+    saved.tick = 42;
+    saved.reactors.push_back(Checkpoint::Reactor());
+    saved.reactors.back().name = "exec";
+    saved.reactors.back().lastObserved.push_back(std::make_pair(std::string("sensor"), (TICK) 40));
+
+    Checkpoint::Token token;
+    token.role = 'i';
+    token.key = 7;
+    token.timeline = "state";
+    token.predicate = "state.Holds";
+    token.variables.resize(1);
+    token.variables[0].first = "start";
+    token.variables[0].second.kind = 'v';
+    token.variables[0].second.type = "int";
+    token.variables[0].second.values.resize(1);
+    token.variables[0].second.values[0].kind = 'n';
+    token.variables[0].second.values[0].number = 12;
+    saved.reactors.back().tokens.push_back(token);
+
+    saved.write("test.checkpoint");
+
+    Checkpoint restored;
+    restored.read("test.checkpoint");
+
+    assertTrue(restored.tick == 42);
+    assertTrue(restored.find("exec") != NULL && restored.find("sim") == NULL);
+
+    const Checkpoint::Reactor& reactor = *restored.find("exec");
+    assertTrue(reactor.lastObserved.size() == 1 && reactor.lastObserved[0].first == "sensor" && reactor.lastObserved[0].second == 40);
+    assertTrue(reactor.tokens.size() == 1);
+    assertTrue(reactor.tokens[0].role == 'i' && reactor.tokens[0].key == 7);
+    assertTrue(reactor.tokens[0].timeline == "state" && reactor.tokens[0].predicate == "state.Holds");
+    assertTrue(reactor.tokens[0].variables.size() == 1 && reactor.tokens[0].variables[0].first == "start");
+    assertTrue(reactor.tokens[0].variables[0].second.values[0].number == 12);
+
+    // A truncated checkpoint is rejected, even when cut at a record boundary
+    std::string content = readFile("test.checkpoint");
+    for(unsigned int cut = content.size() - 1; cut + 5 >= content.size(); --cut){
+      std::ofstream("test.truncated.checkpoint", std::ios::binary).write(content.data(), cut);
+      bool rejected = false;
+      try {
+	Checkpoint truncated;
+	truncated.read("test.truncated.checkpoint");
+      }
+      catch(ConfigurationException* e){
+	rejected = true;
+	delete e;
+      }
+      assertTrue(rejected);
+    }
+
+    // A failed write is reported without touching the previous checkpoint
+    bool failed = false;
+    try {
+      saved.write("no-such-directory/test.checkpoint");
+    }
+    catch(ErrnoExcept const &){
+      failed = true;
+    }
+    assertTrue(failed);
+    assertTrue(readFile("test.checkpoint") == content);
+
+    return true;
+  }
+
+  static bool testMissionHistory(){
+    {
+      // Two rows per segment so that the queries cross segments
+      MissionHistoryWriter writer("test.hist", 2);
+      for(TICK tick = 0; tick < 10; tick += 2){
+	ObservationByValue obs("position", "Holds");
+	obs.push_back("x", new IntervalIntDomain(tick, tick));
+	ObservationByValue battery("battery", tick < 4 ? "Full" : "Low");
+	writer.observation(tick, obs);
+	writer.observation(tick, battery);
+      }
+    }
+
+    MissionHistoryReader history("test.hist");
+    assertTrue(history.rows() == 10 && history.ticks() == 5 && history.segments() == 5);
+    assertTrue(history.firstTick() == 0 && history.lastTick() == 8);
+    assertTrue(history.lowerBound(3) == 4 && history.lowerBound(9) == history.rows());
+
+    MissionHistoryReader::Event ev;
+    assertTrue(history.valueAt("position", 7, ev));
+    assertTrue(ev.tick == 6 && std::string(ev.predicate) == "Holds" && std::string(ev.text).find("x=") == 0);
+    assertTrue(history.valueAt("battery", 100, ev) && std::string(ev.predicate) == "Low");
+    assertTrue(history.valueAt("battery", 3, ev) && ev.tick == 2 && std::string(ev.predicate) == "Full");
+    assertTrue(!history.valueAt("camera", 3, ev));
+
+    std::vector<MissionHistoryReader::Event> events;
+    history.select(2, 5, "O", "battery", 0, events);
+    assertTrue(events.size() == 2 && events[0].tick == 2 && events[1].tick == 4);
+    events.clear();
+    history.select(0, 100, "GC", NULL, 0, events);
+    assertTrue(events.empty());
+    assertTrue(!history.recovered());
+
+    // Without its footer, the history is read up to its last complete segment
+    std::string bytes = readFile("test.hist");
+    MissionHistory::Footer footer;
+    memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+    writeFile("test.partial.hist", bytes.substr(0, footer.labels));
+    {
+      MissionHistoryReader partial("test.partial.hist");
+      assertTrue(partial.recovered() && partial.rows() == 10 && partial.ticks() == 5 && partial.segments() == 5);
+      assertTrue(partial.valueAt("battery", 100, ev) && std::string(ev.predicate) == "Low");
+      assertTrue(partial.valueAt("position", 7, ev) && ev.tick == 6);
+    }
+    writeFile("test.partial.hist", bytes.substr(0, footer.labels - 4));
+    {
+      MissionHistoryReader partial("test.partial.hist");
+      assertTrue(partial.recovered() && partial.rows() == 8 && partial.lastTick() == 6);
+      assertTrue(partial.valueAt("battery", 100, ev) && ev.tick == 6);
+    }
+
+    // Offsets out of the file are rejected
+    MissionHistory::SegmentEntry entry;
+    memcpy(&entry, bytes.data() + footer.directory, sizeof(entry));
+    entry.offset = bytes.size();
+    bytes.replace(footer.directory, sizeof(entry), (const char*) &entry, sizeof(entry));
+    writeFile("test.partial.hist", bytes);
+    bool rejected = false;
+    try {
+      MissionHistoryReader corrupted("test.partial.hist");
+    }
+    catch(std::runtime_error const &){
+      rejected = true;
+    }
+    assertTrue(rejected);
+    return true;
+  }
+
+  /**
+   * What the writer logs is read back in order, and seek moves to the records of a tick using the index. A log which
+   * was not closed can still be read, but not sought.
+   */
+  static bool testBinaryObservationLog(){
+    FILE* out = fopen("test.obs", "wb");
+    assertTrue(out != NULL);
+    {
+      BinaryObservationWriter writer(out);
+      for(TICK tick = 0; tick < 5; tick++){
+	writer.tick(tick);
+	ObservationByValue position("position", "Holds");
+	position.push_back("x", new IntervalIntDomain(tick, tick));
+	position.push_back("range", new IntervalIntDomain(0, tick + 1));
+	writer.log(position);
+	if(tick % 2 == 0)
+	  writer.log(ObservationByValue("battery", tick < 2 ? "Full" : "Low"));
+      }
+    }
+
+    BinaryObservationDecoder decoder;
+    BinaryObservationLog::Record rec;
+    TICK tick;
+    unsigned int count = 0;
+    {
+      BinaryObservationReader reader("test.obs");
+      while(reader.peek(tick)){
+	reader.next(rec);
+	count++;
+	if(rec.timeline == "battery"){
+	  assertTrue(tick % 2 == 0 && rec.predicate == (tick < 2 ? "Full" : "Low") && rec.parameters.empty());
+	  continue;
+	}
+	assertTrue(rec.timeline == "position" && rec.predicate == "Holds" && rec.parameters.size() == 2);
+	const BinaryObservationLog::Domain& x = rec.parameters[0].second;
+	const BinaryObservationLog::Domain& range = rec.parameters[1].second;
+	assertTrue(rec.parameters[0].first == "x" && x.kind == 'v' && x.values.size() == 1 && x.values[0].number == tick);
+	assertTrue(rec.parameters[1].first == "range" && range.kind == 'i' && range.values[1].number == tick + 1);
+
+	Observation* obs = decoder.asObservation(rec);
+	assertTrue(obs->countParameters() == 2 && (*obs)[0].second->getSingletonValue() == tick);
+	assertTrue((*obs)[1].second->getLowerBound() == 0 && (*obs)[1].second->getUpperBound() == tick + 1);
+	delete obs;
+      }
+      assertTrue(count == 8);
+
+      assertTrue(reader.seek(3) && reader.peek(tick) && tick == 3);
+      reader.next(rec);
+      assertTrue(rec.timeline == "position" && rec.parameters[0].second.values[0].number == 3);
+      assertTrue(reader.seek(0) && reader.peek(tick) && tick == 0);
+      assertTrue(reader.seek(10) && !reader.peek(tick));
+    }
+
+    // Drop the index and the trailer as if the agent had been killed
+    std::string bytes = readFile("test.obs");
+    uint32_t lo, hi;
+    memcpy(&lo, bytes.data() + bytes.size() - 8, sizeof(lo));
+    memcpy(&hi, bytes.data() + bytes.size() - 4, sizeof(hi));
+    assertTrue(hi == 0 && lo < bytes.size());
+    writeFile("test.partial.obs", bytes.substr(0, lo));
+
+    BinaryObservationReader partial("test.partial.obs");
+    assertTrue(!partial.seek(3));
+    for(count = 0; partial.peek(tick); count++)
+      partial.next(rec);
+    assertTrue(count == 8 && tick == 4);
+    return true;
+  }
+
+  /**
+   * The reader rejects frames beyond its limits or referring to undefined labels, and the decoder the domains it
+   * cannot build, before anything is allocated for them.
+   */
+  static bool testMalformedObservationLog(){
+    const std::string none = u32(0) + u32(0);
+    const std::string prefix = frame('L', u32(0) + "a") + frame('T', u32(1));
+    assertTrue(!rejectsLog(prefix + frame('O', none + u32(0))));
+
+    assertTrue(rejectsLog(std::string(1, 'O') + u32(16 * 1024 * 1024 + 1)));
+    assertTrue(rejectsLog(frame('L', u32(1 << 20) + "a")));
+    assertTrue(rejectsLog(prefix + frame('O', u32(5) + u32(0) + u32(0))));
+    assertTrue(rejectsLog(prefix + frame('O', none + u32((1 << 16) + 1) + std::string(((1 << 16) + 1) * 13, '\0'))));
+    assertTrue(rejectsLog(prefix + frame('O', none + u32(2) + std::string(13, '\0'))));
+    assertTrue(rejectsLog(prefix + frame('O', none + u32(1) + u32(0) + 'v' + u32(0) + u32(1 << 16) + std::string(5, '\0'))));
+
+    BinaryObservationDecoder decoder;
+    BinaryObservationLog::Domain dom;
+    dom.kind = 'i';
+    dom.type = "int";
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.values.resize(2);
+    dom.values[0].kind = dom.values[1].kind = 'n';
+    dom.values[0].number = 1;
+    dom.values[1].number = 3;
+    assertTrue(!rejectsDomain(decoder, dom));
+    dom.values[0].number = 4;
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.values[0].number = 1;
+    dom.values[1].kind = 'y';
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.kind = 's';
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.kind = 'q';
+    dom.values[1].kind = 'n';
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.kind = 'v';
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.values.pop_back();
+    assertTrue(!rejectsDomain(decoder, dom));
+    dom.type = "complex";
+    assertTrue(rejectsDomain(decoder, dom));
+    dom.values[0].kind = 'o';
+    dom.values[0].symbol = "rover";
+    assertTrue(rejectsDomain(decoder, dom));
+    return true;
+  }
+
+  /**
+   * With TREX_TICKLOG_BINARY the header describes the tick and each field, followed by the fixed width rows, across
+   * more than one block.
+   */
+  static bool testBinaryTickLog(){
+    // The log outlives the test : it keeps referring to its fields
+    static int count = 0;
+    static double ratio = 0;
+    setenv(TICKLOG_BINARY_ENV, "1", 1);
+    TickLogger* log = LogManager::instance().getTickLog("test.ticklog");
+    unsetenv(TICKLOG_BINARY_ENV);
+    assertTrue(log->addField("count", count) && log->addField("ratio", ratio));
+    log->printHeader();
+    const TICK rows = TickLogger::BLOCK_ROWS + 6;
+    for(TICK tick = 0; tick < rows; tick++){
+      count = 2 * tick;
+      ratio = tick / 4.0;
+      log->handleNewTick(tick);
+    }
+    log->flush();
+
+    const std::string bytes = readFile(LogManager::instance().file_name("test.ticklog"));
+    assertTrue(bytes.compare(0, 8, "TREXTCK1") == 0);
+    size_t pos = 8;
+    uint32_t columns;
+    memcpy(&columns, bytes.data() + pos, sizeof(columns));
+    pos += sizeof(columns);
+    assertTrue(columns == 3);
+
+    const char* const types[] = {"uint", "int", "double"};
+    const char* const names[] = {"TICK", "count", "ratio"};
+    const uint32_t widths[] = {sizeof(uint32_t), sizeof(int), sizeof(double)};
+    for(unsigned int i = 0; i < columns; i++){
+      uint32_t width;
+      memcpy(&width, bytes.data() + pos, sizeof(width));
+      pos += sizeof(width);
+      const std::string type(bytes.c_str() + pos);
+      pos += type.size() + 1;
+      const std::string name(bytes.c_str() + pos);
+      pos += name.size() + 1;
+      assertTrue(width == widths[i] && type == types[i] && name == names[i], name.c_str());
+    }
+
+    const size_t rowSize = widths[0] + widths[1] + widths[2];
+    assertTrue(bytes.size() == pos + rows * rowSize);
+    for(TICK tick = 0; tick < rows; tick++, pos += rowSize){
+      uint32_t value;
+      int total;
+      double fraction;
+      memcpy(&value, bytes.data() + pos, sizeof(value));
+      memcpy(&total, bytes.data() + pos + widths[0], sizeof(total));
+      memcpy(&fraction, bytes.data() + pos + widths[0] + widths[1], sizeof(fraction));
+      assertTrue(value == tick && total == (int) (2 * tick) && fraction == tick / 4.0);
+    }
+    return true;
+  }
+
+  /**
+   * The costs listed in the costFile are used in the given direction only, and the pairs not listed are euclidean,
+   * both one pair at a time and for the whole matrix.
+   */
+  static bool testTableCostEstimator(){
+    writeFile("test.costs", "0 0 3 4 20\n3 4 0 0 7\n");
+    TiXmlElement configData("CostEstimator");
+    configData.SetAttribute("costFile", "test.costs");
+    TableCostEstimator estimator(configData);
+    Position origin = {0, 0}, target = {3, 4}, beyond = {6, 8};
+    assertTrue(estimator.computeDistance(origin, target) == 20);
+    assertTrue(estimator.computeDistance(target, origin) == 7);
+    assertTrue(estimator.computeDistance(target, beyond) == 5);
+
+    std::vector<double> xs, ys, distances;
+    xs.push_back(0); xs.push_back(3); xs.push_back(6);
+    ys.push_back(0); ys.push_back(4); ys.push_back(8);
+    estimator.computeDistances(xs, ys, distances);
+    assertTrue(distances.size() == 9 && distances[0] == 0 && distances[4] == 0 && distances[8] == 0);
+    assertTrue(distances[1] == 20 && distances[3] == 7);
+    assertTrue(distances[2] == 10 && distances[6] == 10 && distances[5] == 5 && distances[7] == 5);
+
+    // The costFile is required and must exist
+    assertTrue(buildsCostEstimator(configData));
+    configData.SetAttribute("costFile", "noSuchFile.costs");
+    assertTrue(!buildsCostEstimator(configData));
+    configData.RemoveAttribute("costFile");
+    assertTrue(!buildsCostEstimator(configData));
+    return true;
+  }
+
+  /**
+   * @return false if the TableCostEstimator configuration is rejected as a configuration error
+   */
+  static bool buildsCostEstimator(const TiXmlElement& configData){
+    try {
+      TableCostEstimator estimator(configData);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Each search of a multi start only depends on its seed, so that running them on more threads gives the same
+   * solutions. The unperturbed search starts from the initial solution.
+   */
+  static bool testMultiStartSearch(){
+    const double xs[] = {0, 1, 2, 0, 4, 5, 1};
+    const double ys[] = {0, 0, 0, 3, 4, 1, 5};
+    const unsigned int n = 6;
+    OrienteeringProblem problem;
+    problem.speed = 1;
+    problem.timeBudget = 12;
+    problem.maxIterations = 100;
+    problem.plateau = 10;
+    for(unsigned int i = 0; i <= n; i++)
+      for(unsigned int j = 0; j <= n; j++)
+	problem.distances.push_back(sqrt((xs[i] - xs[j]) * (xs[i] - xs[j]) + (ys[i] - ys[j]) * (ys[i] - ys[j])));
+    for(unsigned int i = 0; i < n; i++){
+      problem.utilities.push_back(pow(10.0, (double) (i % 3)));
+      problem.removable.push_back(true);
+      for(unsigned int j = 0; j < n; j++)
+	problem.precedences.push_back(!(i == 4 && j == 1));
+    }
+
+    OrienteeringSearch::SEQUENCE initial;
+    for(unsigned int i = 0; i < n; i++)
+      initial.push_back(i);
+
+    const unsigned int restarts = 4;
+    std::vector<WorkerPool::Job*> serial, parallel;
+    for(unsigned int k = 0; k < restarts; k++){
+      serial.push_back(new OrienteeringRun(problem, k, initial));
+      parallel.push_back(new OrienteeringRun(problem, k, initial));
+    }
+    {
+      WorkerPool one(1), four(restarts);
+      one.execute(serial);
+      four.execute(parallel);
+    }
+
+    for(unsigned int k = 0; k < restarts; k++){
+      const OrienteeringSearch& a = ((OrienteeringRun*) serial[k])->getSearch();
+      const OrienteeringSearch& b = ((OrienteeringRun*) parallel[k])->getSearch();
+      assertTrue(a.getSolution() == b.getSolution() && a.getIterations() == b.getIterations());
+      assertTrue(OrienteeringScore::compare(a.getScore(), b.getScore()) == OrienteeringScore::EQUAL);
+      assertTrue(a.getIterations() > 0);
+    }
+
+    // Without perturbation the search is the same as from a fresh start
+    OrienteeringSearch fresh(problem, 0);
+    fresh.run(initial);
+    assertTrue(fresh.getSolution() == ((OrienteeringRun*) serial[0])->getSearch().getSolution());
+
+    for(unsigned int k = 0; k < restarts; k++){
+      delete serial[k];
+      delete parallel[k];
+    }
+    return true;
+  }
+
+  static std::string u32(uint32_t val){
+    return std::string((const char*) &val, sizeof(val));
+  }
+
+  static std::string frame(char tag, const std::string& payload){
+    return std::string(1, tag) + u32(payload.size()) + payload;
+  }
+
+  /**
+   * @return true if reading the records following the magic number is rejected as a configuration error
+   */
+  static bool rejectsLog(const std::string& records){
+    writeFile("test.bad.obs", std::string(BinaryObservationLog::magic(), 8) + records);
+    try {
+      BinaryObservationReader reader("test.bad.obs");
+      BinaryObservationLog::Record rec;
+      TICK tick;
+      while(reader.peek(tick))
+	reader.next(rec);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @return true if the domain is rejected as a configuration error
+   */
+  static bool rejectsDomain(BinaryObservationDecoder& decoder, const BinaryObservationLog::Domain& dom){
+    try {
+      decoder.release(decoder.asDomain(dom));
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return true;
+    }
+    return false;
+  }
+
+  static void writeFile(const char* path, const std::string& bytes){
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+  }
+
+  /**
+   * The stream reader skips declarations, comments and CDATA sections, decodes the references of attribute values
+   * and reports empty element tags as a start and an end. The observation reader only keeps the observations of its
+   * timelines, and skips the ticks without any.
+   */
+  static bool testXmlStream(){
+    writeFile("test.stream.xml",
+	      "<?xml version=\"1.0\"?>\n"
+	      "<!DOCTYPE Log [ <!ELEMENT Log ANY> ]>\n"
+	      "<!-- a comment with <Tick value=\"8\"/> -->\n"
+	      "<Log>\n"
+	      "  <![CDATA[ <Tick value=\"9\"/> ]]>\n"
+	      "  <Tick value=\"&lt;&amp;&#65;&#x42;&quot;&apos;\"/>\n"
+	      "  <Tick value='1'><Observation on=\"a\" predicate=\"P\"></Observation></Tick>\n"
+	      "</Log>\n");
+    XmlRecorder all;
+    XmlStreamReader wholeParser("test.stream.xml", all);
+    assertTrue(!wholeParser.parse());
+    assertTrue(all.events == "<Log><Tick value=<&AB\"'></Tick><Tick value=1><Observation on=a predicate=P></Observation></Tick></Log>",
+	       all.events.c_str());
+
+    XmlRecorder ticks("Tick");
+    XmlStreamReader tickParser("test.stream.xml", ticks);
+    ticks.setParser(tickParser);
+    assertTrue(tickParser.parse());
+    assertTrue(ticks.events == "<Log><Tick value=<&AB\"'></Tick>", ticks.events.c_str());
+    assertTrue(tickParser.parse());
+    assertTrue(!tickParser.parse());
+    assertTrue(ticks.events == all.events);
+
+    // Truncated and badly nested files are configuration errors
+    assertTrue(!parsesXml("<Log><Tick value=\"1\">"));
+    assertTrue(!parsesXml("<Log><Tick value=\"1"));
+    assertTrue(!parsesXml("<Log><!-- comment"));
+    assertTrue(!parsesXml("<Log></Tick>"));
+    assertTrue(!parsesXml("<Log a=\"&nbsp;\"/>"));
+    assertTrue(parsesXml("<Log a=\"&#x20AC;\"/>"));
+
+    writeFile("test.stream.xml",
+	      "<Log>\n"
+	      " <Tick value=\"0\">\n"
+	      "  <Observation on=\"a\" predicate=\"A.Holds\"><Assert name=\"x\"><value type=\"int\" name=\"1\"/></Assert></Observation>\n"
+	      "  <Observation on=\"b\" predicate=\"B.Holds\"><Assert name=\"y\"/></Observation>\n"
+	      " </Tick>\n"
+	      " <Tick value=\"1\"><Observation on=\"b\" predicate=\"B.Holds\"/></Tick>\n"
+	      " <Tick value=\"2\"><Observation on=\"a\" predicate=\"A.Holds\"/></Tick>\n"
+	      "</Log>\n");
+    std::set<LabelStr> timelines;
+    timelines.insert(LabelStr("a"));
+    XmlObservationReader reader("test.stream.xml", timelines);
+    std::vector<TiXmlElement*> observations;
+    TICK tick;
+    assertTrue(reader.peek(tick) && tick == 0);
+    reader.next(observations);
+    assertTrue(observations.size() == 1 && std::string(observations[0]->Attribute("on")) == "a");
+    const TiXmlElement* assertion = observations[0]->FirstChildElement("Assert");
+    assertTrue(assertion != NULL && std::string(assertion->Attribute("name")) == "x");
+    assertTrue(assertion->FirstChildElement("value") != NULL);
+    // Tick 1 only has observations of b
+    assertTrue(reader.peek(tick) && tick == 2);
+    reader.next(observations);
+    assertTrue(observations.size() == 2 && observations[1]->FirstChildElement() == NULL);
+    assertTrue(!reader.peek(tick));
+    for(std::vector<TiXmlElement*>::iterator it = observations.begin(); it != observations.end(); ++it)
+      delete *it;
+
+    writeFile("test.stream.xml", "<Log><Tick><Observation on=\"a\"/></Tick></Log>");
+    bool rejected = false;
+    try {
+      XmlObservationReader noValue("test.stream.xml", timelines);
+      noValue.peek(tick);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      rejected = true;
+    }
+    assertTrue(rejected);
+    return true;
+  }
+
+  /**
+   * @return false if parsing the text to its end is a configuration error
+   */
+  static bool parsesXml(const std::string& text){
+    writeFile("test.stream.xml", text);
+    XmlRecorder recorder;
+    try {
+      XmlStreamReader parser("test.stream.xml", recorder);
+      parser.parse();
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * The server only binds the address it is given, keeps the field names of the first sample and serves the last
+   * one over HTTP.
+   */
+  static bool testTelemetryServer(){
+    bool failed = false;
+    try {
+      TelemetryServer server("localhost", 0);
+    }
+    catch(ConfigurationException* e){
+      delete e;
+      failed = true;
+    }
+    assertTrue(failed);
+
+    TelemetryServer server("127.0.0.1", 0);
+    assertTrue(server.port() != 0);
+    assertTrue(server.snapshot().empty());
+
+    TelemetrySample sample;
+    sample.add("tick", 1);
+    sample.add(LabelStr("reactor"), "queue.goals", 3);
+    server.publish(sample);
+    assertTrue(server.snapshot() == "tick 1\nreactor.queue.goals 3\n", server.snapshot().c_str());
+
+    sample.clear();
+    sample.add("tick", 2);
+    sample.add(LabelStr("reactor"), "queue.goals", 4);
+    server.publish(sample);
+    assertTrue(server.snapshot() == "tick 2\nreactor.queue.goals 4\n", server.snapshot().c_str());
+    std::ostringstream written;
+    sample.write(written);
+    assertTrue(written.str() == server.snapshot());
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    assertTrue(client >= 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assertTrue(connect(client, (sockaddr*) &addr, sizeof(addr)) == 0);
+    const char request[] = "GET / HTTP/1.0\r\n\r\n";
+    assertTrue(send(client, request, sizeof(request) - 1, 0) > 0);
+    std::string response;
+    char buffer[256];
+    ssize_t n;
+    while((n = recv(client, buffer, sizeof(buffer), 0)) > 0)
+      response.append(buffer, n);
+    close(client);
+
+    assertTrue(response.find("HTTP/1.0 200 OK") == 0, response.c_str());
+    std::string::size_type body = response.find("\r\n\r\n");
+    assertTrue(body != std::string::npos && response.substr(body + 4) == server.snapshot(), response.c_str());
+    return true;
+  }
+
+  /**
+   * A failure is analysed from its captured plan on the analyst thread, which writes the conflict file and hands the
+   * record back.
+   */
+  static bool testFailureAnalyst(){
+    FailureRecord record;
+    record.tick = 4;
+    record.comment = "Could not insert the token";
+    record.tokenKey = 10;
+    record.token = "Holds(10)";
+    record.predicate = "Timeline.Holds";
+    record.start[0] = record.start[1] = 4;
+    record.end[0] = 5;
+    record.end[1] = 8;
+
+    // Overlaps the failed token, overlaps on another predicate, and is in the past
+    const int keys[] = {11, 12, 13};
+    const char* predicates[] = {"Timeline.Holds", "Timeline.Other", "Timeline.Holds"};
+    const double starts[] = {4, 4, 0};
+    for(unsigned int i = 0; i < 3; i++){
+      FailureRecord::PlanToken token;
+      token.timeline = "timeline";
+      token.predicate = predicates[i];
+      token.key = keys[i];
+      token.start[0] = token.start[1] = starts[i];
+      token.end[0] = starts[i] + 1;
+      token.end[1] = PLUS_INFINITY;
+      record.plan.push_back(token);
+    }
+    record.conflictFile = "test.conflict";
+    remove(record.conflictFile.c_str());
+
+    std::vector<FailureRecord> analysed;
+    {
+      FailureAnalyst analyst;
+      analyst.start();
+      analyst.push(record);
+      for(unsigned int i = 0; i < 100 && analysed.empty(); i++){
+	Clock::sleep(0.01);
+	analyst.collect(analysed);
+      }
+    }
+    assertTrue(analysed.size() == 1);
+    const std::string& analysis = analysed[0].analysis;
+    assertTrue(analysis.find("Found a conflict with timeline\t11\t") != std::string::npos, analysis.c_str());
+    assertTrue(analysis.find("conflict with timeline\t12\t") == std::string::npos, analysis.c_str());
+    assertTrue(analysis.find("conflict with timeline\t13\t") == std::string::npos, analysis.c_str());
+    assertTrue(analysis.find("Plan at the failure:") != std::string::npos, analysis.c_str());
+    assertTrue(readFile("test.conflict") == analysed[0].render());
+    assertTrue(analysed[0].render().find(record.comment) == 0);
+    return true;
+  }
+
+  static bool sameEntries(const FlatMap<int, int>& flatMap, const std::map<int, int>& map){
+    if(flatMap.size() != map.size())
+      return false;
+    std::map<int, int>::const_iterator m_it = map.begin();
+    for(FlatMap<int, int>::const_iterator it = flatMap.begin(); it != flatMap.end(); ++it, ++m_it)
+      if(it->first != m_it->first || it->second != m_it->second)
+	return false;
+    return true;
+  }
+
+  /**
+   * A FlatMap and a FlatSet hold the same entries, in the same order, as a std::map and a std::set given the same
+   * sequence of insertions and removals.
+   */
+  static bool testFlatTables(){
+    FlatMap<int, int> flatMap;
+    std::map<int, int> map;
+    FlatSet<int> flatSet;
+    std::set<int> set;
+    unsigned int seed = 1;
+    for(unsigned int i = 0; i < 1000; i++){
+      seed = seed * 1103515245 + 12345;
+      const int key = (seed >> 16) % 64;
+      switch(i % 4){
+      case 0:
+	assertTrue(flatMap.insert(std::make_pair(key, (int) i)).second == map.insert(std::make_pair(key, (int) i)).second);
+	assertTrue(flatSet.insert(key).second == set.insert(key).second);
+	break;
+      case 1:
+	flatMap[key] += i;
+	map[key] += i;
+	break;
+      case 2:
+	assertTrue(flatMap.erase(key) == map.erase(key));
+	assertTrue(flatSet.erase(key) == set.erase(key));
+	break;
+      default:
+	assertTrue((flatMap.find(key) == flatMap.end()) == (map.find(key) == map.end()));
+	assertTrue(flatMap.find(key) == flatMap.end() || flatMap.find(key)->second == map.find(key)->second);
+	assertTrue((flatSet.find(key) == flatSet.end()) == (set.find(key) == set.end()));
+      }
+      assertTrue(sameEntries(flatMap, map));
+      assertTrue(flatSet.size() == set.size() && std::equal(flatSet.begin(), flatSet.end(), set.begin()));
+    }
+    return true;
+  }
+
+  /**
+   * A category is muted by any of its prefixes. The data of a muted TREX_SYSLOG is not even evaluated.
+   */
+  static bool testSyslogCategories(){
+    LogManager& log = LogManager::instance();
+    assertTrue(log.syslogEnabled("test:syslog:muted"));
+    log.muteSyslog("test:syslog:muted");
+    assertTrue(!log.syslogEnabled("test:syslog:muted") && !log.syslogEnabled("test:syslog:muted:detail"));
+    assertTrue(log.syslogEnabled("test:syslog") && log.syslogEnabled("test:syslog:shown"));
+
+    unsigned int formatted = 0;
+    TREX_SYSLOG("test:syslog:muted", "[test] muted " << ++formatted << std::endl);
+    assertTrue(formatted == 0);
+    TREX_SYSLOG("test:syslog:shown", "[test] shown " << ++formatted << std::endl);
+    assertTrue(formatted == 1);
+    return true;
+  }
+
+  /**
+   * In asynchronous mode an entry which does not fit the pending buffer is dropped, and the drops are reported in the
+   * log with the next entries written. Every queued entry is written by flush and by the destructor.
+   */
+  static bool testAsyncTextLog(){
+    {
+      TextLog log("test.async.log");
+      log.setAsync(16);
+      for(unsigned int i = 0; i < 3; i++)
+	log<<"an entry longer than the buffer\n";
+      assertTrue(log.dropped() == 3);
+      log<<"kept\n";
+      log.flush();
+      assertTrue(readFile("test.async.log") == "kept\n[TextLog] 3 entries dropped\n", readFile("test.async.log").c_str());
+    }
+
+    std::ostringstream expected;
+    {
+      TextLog log("test.async.log");
+      log.setAsync(1 << 20);
+      for(unsigned int i = 0; i < 1000; i++){
+	log<<"line "<<i<<'\n';
+	expected<<"line "<<i<<'\n';
+      }
+      assertTrue(log.dropped() == 0);
+    }
+    assertTrue(readFile("test.async.log") == expected.str());
+    return true;
+  }
+
+  /**
+   * Once the agent is terminated, every line queued on an asynchronous syslog is in the log file, in order.
+   */
+  static bool testAsyncSyslog(){
+    TextLog& syslog = LogManager::instance().syslog();
+    syslog.setAsync(1 << 20);
+    const unsigned long dropped = syslog.dropped();
+    for(unsigned int i = 0; i < 1000; i++)
+      TREXLog()<<"[test] queued line "<<i<<'\n';
+    Agent::terminate();
+
+    const std::string text = readFile(LogManager::instance().file_name(TREX_LOG_FILE));
+    std::string::size_type pos = 0;
+    for(unsigned int i = 0; i < 1000; i++){
+      std::ostringstream line;
+      line<<"[test] queued line "<<i<<'\n';
+      pos = text.find(line.str(), pos);
+      assertTrue(pos != std::string::npos, line.str().c_str());
+    }
+    assertTrue(syslog.dropped() == dropped);
     return true;
   }
 };
@@ -22,6 +22,7 @@ from TREX.core.db_core import DbCore,Timeline
 class DbReader():
   DB_PATH = "reactor_states"
   DB_EXT = "reactorstate"
+  DELTA_EXT = "reactordelta"
 
   CONFLICT_PATH = "conflicts"
   CONFLICT_EXT = "conflict"
@@ -56,8 +57,14 @@ class DbReader():
 
   # Read the contents of the DB_PATH to get the ticks that are available
   def get_available_db_cores(self,log_path,reactor_name):
+    ticks = self.get_available_states(log_path,reactor_name,DbReader.DB_EXT) + self.get_available_states(log_path,reactor_name,DbReader.DELTA_EXT)
+    ticks.sort()
+    return ticks
+
+  # Read the contents of the DB_PATH to get the ticks of the files with the given extension
+  def get_available_states(self,log_path,reactor_name,ext):
     tick_paths = os.listdir(self.get_db_path(log_path,reactor_name))
-    ticks = [os.path.basename(s)[0:-(1+len(DbReader.DB_EXT))].split(".") for s in tick_paths if s[-len(DbReader.DB_EXT):] == DbReader.DB_EXT]
+    ticks = [os.path.basename(s)[0:-(1+len(ext))].split(".") for s in tick_paths if s[-len(ext):] == ext]
     ticks = [(int(t[0]),int(t[1])) for t in ticks]
     ticks.sort()
     return ticks
@@ -110,8 +117,33 @@ class DbReader():
     # Get a list of all the available conflicts
     db_core.conflicts = self.get_available_conflicts(log_path, reactor_name)
 
-    # Read in the tick
-    db_file_name = os.path.join(db_path,"%d.%d.%s" % (tick[0],tick[1],DbReader.DB_EXT))
+    # Find the last full state written before this tick, and the deltas to apply on top of it
+    keyframes = [t for t in self.get_available_states(log_path,reactor_name,DbReader.DB_EXT) if t <= tick]
+    keyframe = max(keyframes)
+    deltas = [t for t in self.get_available_states(log_path,reactor_name,DbReader.DELTA_EXT) if keyframe < t and t <= tick]
+
+    # (token,timeline) pairs by token key
+    tokens = {}
+
+    self.read_state(os.path.join(db_path,"%d.%d.%s" % (keyframe[0],keyframe[1],DbReader.DB_EXT)),db_core,tokens)
+    for delta in sorted(deltas):
+      self.read_state(os.path.join(db_path,"%d.%d.%s" % (delta[0],delta[1],DbReader.DELTA_EXT)),db_core,tokens)
+
+    # Rebuild the timeline sequences
+    for timeline in db_core.int_timelines.values() + db_core.ext_timelines.values():
+      timeline.tokens = [token for (token,tl) in tokens.values() if tl is timeline]
+      timeline.tokens.sort(key=lambda t: t.start)
+
+    # Return constructed db_core
+    return db_core
+
+  ############################################################################
+  # read_state(db_file_name,db_core,tokens)
+  #   This reads a full reactor state or a delta, updating the timelines of
+  #   db_core and the (token,timeline) pairs of tokens.
+  ############################################################################
+
+  def read_state(self,db_file_name,db_core,tokens):
     db_file = open(db_file_name)
 
     # Mode translation
@@ -121,17 +153,22 @@ class DbReader():
     timeline = None
 
     for line in db_file:
-      if line[0] != '\t':
+      if line[0] == '-':
+	# Token no longer in the plan
+	a,key = line[0:-1].split('\t')
+	tokens.pop(int(key),None)
+      elif line[0] != '\t':
 	# New Timeline
 	key,name,mode = line[0:-1].split('\t');
 	mode = modes[mode]
-	timeline = Timeline(int(key),name,mode)
-
-	# Store it in the db_core
 	if mode == Timeline.INTERNAL:
-	  db_core.int_timelines[name] = timeline
+	  timelines = db_core.int_timelines
 	else:
-	  db_core.ext_timelines[name] = timeline
+	  timelines = db_core.ext_timelines
+	# Store it in the db_core
+	if not timelines.has_key(name):
+	  timelines[name] = Timeline(int(key),name,mode)
+	timeline = timelines[name]
       else:
 	# Token
 	a,key,name,sl,su,el,eu = line[0:-1].split('\t')
@@ -140,10 +177,9 @@ class DbReader():
 	token.end = [float(el),float(eu)]
 
 	# Store it in the current timeline
-	timeline.tokens.append(token)
-    
-    # Return constructed db_core
-    return db_core
+	tokens[int(key)] = (token,timeline)
+
+    db_file.close()
 
   ############################################################################
   # load_assembly(log_path,reactor_name,tick)